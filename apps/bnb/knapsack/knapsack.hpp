@@ -3,18 +3,25 @@
 
 #include <vector>
 #include <array>
+#include <algorithm>
+#include <bitset>
 #include <cmath>
+#include <cstdint>
 
 #include <hpx/config.hpp>
 #include <boost/serialization/access.hpp>
 
 #include <hpx/util/tuple.hpp>
+#include <hpx/runtime/serialization/bitset.hpp>
 
 #include "util/NodeGenerator.hpp"
+#include "util/MemoTable.hpp"
+#include "util/BitwiseSerializable.hpp"
 
 /* A representation of a knapsack current solution */
+template <unsigned N>
 struct KPSolution {
-  std::vector<int> items;
+  std::bitset<N> items;
   int profit;
   int weight;
 
@@ -26,6 +33,8 @@ struct KPSolution {
   }
 };
 
+// Items are in profit density order, one array per field. prefixProfits[i] and prefixWeights[i]
+// sum the first i items, so the greedy fill in fractionalBound is a binary search.
 template <unsigned N>
 struct KPSpace {
   std::array<int, N> profits;
@@ -33,18 +42,39 @@ struct KPSpace {
   int numItems;
   int capacity;
 
+  std::array<std::int64_t, N + 1> prefixProfits;
+  std::array<std::int64_t, N + 1> prefixWeights;
+
   template <class Archive>
   void serialize(Archive & ar, const unsigned int version) {
     ar & profits;
     ar & weights;
     ar & numItems;
     ar & capacity;
+    ar & prefixProfits;
+    ar & prefixWeights;
   }
 };
 
+template <unsigned N>
+KPSpace<N> makeSpace(const std::array<int, N> & profits, const std::array<int, N> & weights,
+                     const int numItems, const int capacity) {
+  KPSpace<N> space {profits, weights, numItems, capacity};
+  space.prefixProfits[0] = 0;
+  space.prefixWeights[0] = 0;
+  for (auto i = 0; i < numItems; ++i) {
+    space.prefixProfits[i + 1] = space.prefixProfits[i] + profits[i];
+    space.prefixWeights[i + 1] = space.prefixWeights[i] + weights[i];
+  }
+  return space;
+}
+
+// The items still to decide on are those from next on that fit in what capacity is left, so a node
+// is its solution and next, with no list of remaining items
+template <unsigned N>
 struct KPNode {
-  KPSolution sol;
-  std::vector<int> rem;
+  KPSolution<N> sol;
+  int next;
 
   int getObj() const {
     return sol.profit;
@@ -53,62 +83,119 @@ struct KPNode {
   template <class Archive>
   void serialize(Archive & ar, const unsigned int version) {
     ar & sol;
-    ar & rem;
+    ar & next;
   }
 };
 
+// Fixed size, children and steals copy nodes in one go
+namespace hpx { namespace traits {
+template <unsigned N>
+struct is_bitwise_serializable<KPNode<N> > : YewPar::BitwiseSerializable<KPNode<N> > {};
+}}
+
+template <unsigned numItems>
+int fractionalBound(const KPSpace<numItems> & space, int firstItem, double profit, int weight);
+
 template <unsigned numItems>
-struct GenNode : YewPar::NodeGenerator<KPNode, KPSpace<numItems> > {
-  std::vector<int> items;
+struct GenNode : YewPar::NodeGenerator<KPNode<numItems>, KPSpace<numItems> > {
+  // The items the children add, in order
+  std::array<int, numItems> items;
   int pos;
 
   std::reference_wrapper<const KPSpace<numItems> > space;
-  std::reference_wrapper<const KPNode> n;
+  std::reference_wrapper<const KPNode<numItems> > n;
 
-  GenNode (const KPSpace<numItems> & space, const KPNode & n) :
+  GenNode (const KPSpace<numItems> & space, const KPNode<numItems> & n) :
       pos(0), space(std::cref(space)), n(std::cref(n)) {
-    this->numChildren = n.rem.size();
+    auto left = space.capacity - n.sol.weight;
+    this->numChildren = 0;
+    for (auto i = n.next; i < space.numItems; ++i) {
+      if (space.weights[i] <= left) {
+        items[this->numChildren++] = i;
+      }
+    }
   }
 
-  KPNode next() override {
-    auto i = n.get().rem[pos];
-    auto newSol = n.get().sol;
-    newSol.items.push_back(i);
-    newSol.profit += space.get().profits[i];
-    newSol.weight += space.get().weights[i];
+  KPNode<numItems> next() override {
+    KPNode<numItems> child;
+    nextInto(child);
+    return child;
+  }
+
+  void nextInto(KPNode<numItems> & child) {
+    const auto & parent = n.get();
+    auto i = items[pos];
+    child.sol.items = parent.sol.items;
+    child.sol.items.set(i);
+    child.sol.profit = parent.sol.profit + space.get().profits[i];
+    child.sol.weight = parent.sol.weight + space.get().weights[i];
+    child.next = i + 1;
 
     ++pos;
+  }
 
-    std::vector<int> newRem;
-    std::copy_if(n.get().rem.begin() + pos, n.get().rem.end(), std::back_inserter(newRem),
-                 [&](const int i) {
-                   return newSol.weight + space.get().weights[i] <= space.get().capacity;
-                 });
+  void skip(unsigned k) {
+    pos += k;
+  }
 
-    return { newSol, std::move(newRem) };
+  // upperBound of every child, straight from the parent
+  const std::vector<int> & childBounds() {
+    if (!haveBounds) {
+      const auto & parent = n.get();
+      bounds.clear();
+      for (auto k = 0u; k < this->numChildren; ++k) {
+        auto i = items[k];
+        bounds.push_back(fractionalBound(space.get(), i + 1,
+                                         parent.sol.profit + space.get().profits[i],
+                                         parent.sol.weight + space.get().weights[i]));
+      }
+      haveBounds = true;
+    }
+    return bounds;
   }
+
+ private:
+  std::vector<int> bounds;
+  bool haveBounds = false;
 };
 
+// Fill the remaining capacity greedily with items from firstItem on, taking a fraction of the first
+// item that doesn't fit. The items taken whole are the longest run from firstItem whose weights sum
+// to at most the capacity left, found by binary search on the prefix sums.
 template <unsigned numItems>
-int upperBound(const KPSpace<numItems> & space, const KPNode & n) {
-  auto sol = n.sol;
-
-  double profit = sol.profit;
-  auto weight  = sol.weight;
-
-  for (auto i = sol.items.back() + 1; i < space.numItems; i++) {
-    // If there is enough space for a full item we take it all
-    if (space.weights[i] + weight <= space.capacity) {
-      profit += space.profits[i];
-      weight += space.weights[i];
-    } else {
-      // Only space for some fraction of the last item
-      profit = profit + (space.capacity - weight) * ((double) space.profits[i] / (double) space.weights[i]);
-      break;
-    }
+int fractionalBound(const KPSpace<numItems> & space, int firstItem, double profit, int weight) {
+  if (firstItem >= space.numItems) {
+    return std::ceil(profit);
+  }
+
+  auto fits = space.prefixWeights[firstItem] + (space.capacity - weight);
+  auto end = space.prefixWeights.begin() + space.numItems + 1;
+  auto last = std::upper_bound(space.prefixWeights.begin() + firstItem, end, fits) - 1;
+  auto i = static_cast<int>(last - space.prefixWeights.begin());
+
+  profit += space.prefixProfits[i] - space.prefixProfits[firstItem];
+  weight += space.prefixWeights[i] - space.prefixWeights[firstItem];
+
+  // Only space for some fraction of the next item
+  if (i < space.numItems) {
+    profit = profit + (space.capacity - weight) * ((double) space.profits[i] / (double) space.weights[i]);
   }
 
   return std::ceil(profit);
 }
 
+template <unsigned numItems>
+int upperBound(const KPSpace<numItems> & space, const KPNode<numItems> & n) {
+  return fractionalBound(space, n.next, n.sol.profit, n.sol.weight);
+}
+
+// A node's subtree only depends on next and the weight so far (the children are the later items
+// that still fit), so two nodes agreeing on both can be merged, keeping the one with the higher
+// profit
+template <unsigned numItems>
+YewPar::util::MemoTable::MemoKey memoKey(const KPSpace<numItems> & space, const KPNode<numItems> & n) {
+  std::uint64_t next = n.next;
+  return {(next << 32) | static_cast<std::uint32_t>(n.sol.weight), -n.sol.profit};
+}
+
 #endif
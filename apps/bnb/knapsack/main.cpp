@@ -18,12 +18,16 @@
 #include "skeletons/Ordered.hpp"
 #include "skeletons/Budget.hpp"
 #include "skeletons/StackStealing.hpp"
+#include "skeletons/Hybrid.hpp"
+#include "skeletons/BestFirst.hpp"
+#include "skeletons/Portfolio.hpp"
 
 #ifndef NUMITEMS
 #define NUMITEMS 50
 #endif
 
 typedef func<decltype(&upperBound<NUMITEMS>), &upperBound<NUMITEMS> > bnd_func;
+typedef func<decltype(&memoKey<NUMITEMS>), &memoKey<NUMITEMS> > memo_func;
 
 struct knapsackData {
   int capacity = 0;
@@ -96,6 +100,12 @@ int hpx_main(boost::program_options::variables_map & opts) {
               }
             });
 
+  if (problem.items.size() > NUMITEMS) {
+    hpx::cout << "Too many items, rebuild with a larger YEWPAR_BUILD_BNB_APPS_KNAPSACK_NITEMS" << hpx::endl;
+    hpx::finalize();
+    return EXIT_FAILURE;
+  }
+
   // Pack the problem into a more efficient format
   std::array<int, NUMITEMS> profits;
   std::array<int, NUMITEMS> weights;
@@ -125,14 +135,8 @@ int hpx_main(boost::program_options::variables_map & opts) {
 
   auto start_time = std::chrono::steady_clock::now();
 
-  KPSpace<NUMITEMS> space {profits, weights, numItems, problem.capacity};
-  KPSolution initSol = {std::vector<int>(), 0, 0};
-
-  std::vector<int> initRem;
-  for (int i = 0; i < numItems; i++) {
-    initRem.push_back(i);
-  }
-  KPNode root {initSol, initRem};
+  auto space = makeSpace<NUMITEMS>(profits, weights, numItems, problem.capacity);
+  KPNode<NUMITEMS> root {{{}, 0, 0}, 0};
 
   auto sol = root;
   auto skeletonType = opts["skeleton"].as<std::string>();
@@ -145,15 +149,27 @@ int hpx_main(boost::program_options::variables_map & opts) {
   } else if (skeletonType == "depthbounded") {
     auto spawnDepth = opts["spawn-depth"].as<unsigned>();
     YewPar::Skeletons::API::Params<int> searchParameters;
+    searchParameters.boundRefreshInterval = opts["bound-refresh"].as<unsigned>();
     searchParameters.spawnDepth = spawnDepth;
-    sol = YewPar::Skeletons::DepthBounded<GenNode<NUMITEMS>,
-                                         YewPar::Skeletons::API::Optimisation,
-                                         YewPar::Skeletons::API::PruneLevel,
-                                         YewPar::Skeletons::API::BoundFunction<bnd_func> >
-          ::search(space, root, searchParameters);
+    searchParameters.boundOrderedPool = static_cast<bool>(opts.count("bound-ordered"));
+    if (opts.count("memoize")) {
+      sol = YewPar::Skeletons::DepthBounded<GenNode<NUMITEMS>,
+                                           YewPar::Skeletons::API::Optimisation,
+                                           YewPar::Skeletons::API::PruneLevel,
+                                           YewPar::Skeletons::API::BoundFunction<bnd_func>,
+                                           YewPar::Skeletons::API::Memoize<memo_func> >
+            ::search(space, root, searchParameters);
+    } else {
+      sol = YewPar::Skeletons::DepthBounded<GenNode<NUMITEMS>,
+                                           YewPar::Skeletons::API::Optimisation,
+                                           YewPar::Skeletons::API::PruneLevel,
+                                           YewPar::Skeletons::API::BoundFunction<bnd_func> >
+            ::search(space, root, searchParameters);
+    }
   } else if (skeletonType == "ordered") {
     auto spawnDepth = opts["spawn-depth"].as<unsigned>();
     YewPar::Skeletons::API::Params<int> searchParameters;
+    searchParameters.boundRefreshInterval = opts["bound-refresh"].as<unsigned>();
     searchParameters.spawnDepth = spawnDepth;
     sol = YewPar::Skeletons::Ordered<GenNode<NUMITEMS>,
                                      YewPar::Skeletons::API::Optimisation,
@@ -162,7 +178,10 @@ int hpx_main(boost::program_options::variables_map & opts) {
           ::search(space, root, searchParameters);
   } else if (skeletonType == "budget") {
     YewPar::Skeletons::API::Params<int> searchParameters;
+    searchParameters.boundRefreshInterval = opts["bound-refresh"].as<unsigned>();
     searchParameters.backtrackBudget = opts["backtrack-budget"].as<unsigned>();
+    searchParameters.adaptiveBudget = static_cast<bool>(opts.count("adaptive-budget"));
+    searchParameters.budgetTargetTaskMicros = opts["budget-target"].as<unsigned>();
     sol = YewPar::Skeletons::Budget<GenNode<NUMITEMS>,
                                     YewPar::Skeletons::API::Optimisation,
                                     YewPar::Skeletons::API::PruneLevel,
@@ -170,12 +189,46 @@ int hpx_main(boost::program_options::variables_map & opts) {
         ::search(space, root, searchParameters);
   } else if (skeletonType == "stacksteal") {
     YewPar::Skeletons::API::Params<int> searchParameters;
+    searchParameters.boundRefreshInterval = opts["bound-refresh"].as<unsigned>();
     searchParameters.stealAll = static_cast<bool>(opts.count("chunked"));
     sol = YewPar::Skeletons::StackStealing<GenNode<NUMITEMS>,
                                            YewPar::Skeletons::API::Optimisation,
                                            YewPar::Skeletons::API::PruneLevel,
                                            YewPar::Skeletons::API::BoundFunction<bnd_func> >
         ::search(space, root, searchParameters);
+  } else if (skeletonType == "hybrid") {
+    YewPar::Skeletons::API::Params<int> searchParameters;
+    searchParameters.boundRefreshInterval = opts["bound-refresh"].as<unsigned>();
+    searchParameters.spawnDepth = opts["spawn-depth"].as<unsigned>();
+    searchParameters.stealAll = static_cast<bool>(opts.count("chunked"));
+    sol = YewPar::Skeletons::Hybrid<GenNode<NUMITEMS>,
+                                    YewPar::Skeletons::API::Optimisation,
+                                    YewPar::Skeletons::API::PruneLevel,
+                                    YewPar::Skeletons::API::BoundFunction<bnd_func> >
+        ::search(space, root, searchParameters);
+  } else if (skeletonType == "bestfirst") {
+    YewPar::Skeletons::API::Params<int> searchParameters;
+    searchParameters.boundRefreshInterval = opts["bound-refresh"].as<unsigned>();
+    sol = YewPar::Skeletons::BestFirst<GenNode<NUMITEMS>,
+                                       YewPar::Skeletons::API::Optimisation,
+                                       YewPar::Skeletons::API::PruneLevel,
+                                       YewPar::Skeletons::API::BoundFunction<bnd_func> >
+        ::search(space, root, searchParameters);
+  } else if (skeletonType == "portfolio") {
+    typedef YewPar::Skeletons::Portfolio<GenNode<NUMITEMS>,
+                                         YewPar::Skeletons::API::Optimisation,
+                                         YewPar::Skeletons::API::PruneLevel,
+                                         YewPar::Skeletons::API::BoundFunction<bnd_func> > Portfolio;
+    YewPar::Skeletons::API::Params<int> searchParameters;
+    searchParameters.portfolioSliceMillis = opts["portfolio-slice"].as<unsigned>();
+
+    Portfolio::Config depthBounded {YewPar::Skeletons::PortfolioSkeleton::DepthBounded, searchParameters};
+    depthBounded.params.spawnDepth = opts["spawn-depth"].as<unsigned>();
+    Portfolio::Config stackSteal {YewPar::Skeletons::PortfolioSkeleton::StackStealing, searchParameters};
+    Portfolio::Config budget {YewPar::Skeletons::PortfolioSkeleton::Budget, searchParameters};
+    budget.params.backtrackBudget = opts["backtrack-budget"].as<unsigned>();
+
+    sol = Portfolio::search(space, root, {depthBounded, stackSteal, budget}, searchParameters);
   } else {
     hpx::cout << "Invalid skeleton type\n";
     hpx::finalize();
@@ -190,8 +243,10 @@ int hpx_main(boost::program_options::variables_map & opts) {
   hpx::cout << "Final Weight: " << finalSol.weight << hpx::endl;
   hpx::cout << "Expected Result: " << std::boolalpha << (finalSol.profit == problem.expectedResult) << hpx::endl;
   hpx::cout << "Items: ";
-  for (auto const & i : finalSol.items) {
-    hpx::cout << i << " ";
+  for (auto i = 0; i < numItems; ++i) {
+    if (finalSol.items.test(i)) {
+      hpx::cout << i << " ";
+    }
   }
   hpx::cout << hpx::endl;
 
@@ -207,7 +262,7 @@ int main(int argc, char* argv[]) {
   desc_commandline.add_options()
     ( "skeleton",
       boost::program_options::value<std::string>()->default_value("seq"),
-      "Which skeleton to use: seq, depthbound, stacksteal, budget, or ordered"
+      "Which skeleton to use: seq, depthbound, stacksteal, budget, ordered, hybrid, bestfirst or portfolio"
     )
     ( "input-file,f",
       boost::program_options::value<std::string>()->required(),
@@ -217,7 +272,22 @@ int main(int argc, char* argv[]) {
       boost::program_options::value<unsigned>()->default_value(500),
       "Number of backtracks before spawning work"
     )
+    ( "portfolio-slice",
+      boost::program_options::value<unsigned>()->default_value(100),
+      "Time (ms) each portfolio configuration gets in the first round, doubling every round"
+    )
+    ("adaptive-budget", "Tune the backtrack budget at runtime (budget is the starting value)")
+    ( "budget-target",
+      boost::program_options::value<unsigned>()->default_value(1000),
+      "Task duration (microseconds) the adaptive budget aims for"
+    )
     ("chunked", "Use chunking with stack stealing")
+    ("memoize", "Prune repeated (last item, weight) states (depthbounded only)")
+    ("bound-ordered", "Run the most promising tasks at each depth first (depthbounded only)")
+    ( "bound-refresh",
+      boost::program_options::value<unsigned>()->default_value(0),
+      "Re-read the shared bound every n nodes (0 = every node)"
+      )
     ( "spawn-depth,d",
       boost::program_options::value<unsigned>()->default_value(0),
       "Depth in the tree to spawn until (for parallel skeletons only)"
@@ -225,5 +295,5 @@ int main(int argc, char* argv[]) {
 
   YewPar::registerPerformanceCounters();
 
-  return hpx::init(desc_commandline, argc, argv);
+  return YewPar::init(desc_commandline, argc, argv);
 }
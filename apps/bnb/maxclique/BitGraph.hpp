@@ -6,10 +6,14 @@
  * compile time.
  */
 
-#include "BitSet.hpp"
-
 #include <vector>
 
+#include "util/BitSet.hpp"
+
+using YewPar::util::BitSet;
+using YewPar::util::BitWord;
+using YewPar::util::bits_per_word;
+
 template <unsigned n_words_>
 class BitGraph
 {
@@ -40,6 +44,14 @@ public:
     return _adjacency[a].test(b);
   }
 
+  auto row(int r) -> BitSet<n_words_> & {
+    return _adjacency[r];
+  }
+
+  auto row(int r) const -> const BitSet<n_words_> & {
+    return _adjacency[r];
+  }
+
   auto intersect_with_row(int row, BitSet<n_words_> & p) const -> void {
     p.intersect_with(_adjacency[row]);
   }
@@ -2,8 +2,8 @@
 #define _DIMACSPARSER_HPP_
 
 #include <string>
-#include <map>
-#include <set>
+#include <utility>
+#include <vector>
 
 class SomethingWentWrong : public std::exception
 {
@@ -20,7 +20,14 @@ public:
 };
 
 namespace dimacs {
-  using GraphFromFile = std::pair<unsigned, std::map<int, std::set<int> > >;
+  // Vertices are numbered from 0. Each edge is listed once (as (a, b) with a < b) however many
+  // times the file has it.
+  struct GraphFromFile {
+    unsigned size = 0;
+    std::vector<std::pair<unsigned, unsigned> > edges;
+    std::vector<unsigned> degrees;
+  };
+
   auto read_dimacs(const std::string & filename) -> GraphFromFile;
 }
 
@@ -0,0 +1,131 @@
+#ifndef _GRAPHCACHE_HPP_
+#define _GRAPHCACHE_HPP_
+
+/**
+ * A binary copy of an ordered graph: the vertex order and the adjacency
+ * bitsets as they are in memory. Later runs on the same input map it and
+ * copy the rows straight in, skipping parsing and ordering.
+ *
+ * The cache records the size and modification time of the file it was made
+ * from, and is ignored (then rewritten) once either changes.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BitGraph.hpp"
+
+#include "util/MappedFile.hpp"
+
+namespace graph_cache {
+
+  struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t size;
+    std::uint32_t words;
+    std::uint32_t unused;
+    std::uint64_t source_size;
+    std::uint64_t source_mtime;
+  };
+
+  constexpr char magic[8] = { 'Y', 'P', 'B', 'G', 'R', 'A', 'P', 'H' };
+  constexpr std::uint32_t version = 1;
+
+  // Order (one uint32_t per vertex), then the rows
+  inline auto bytes(const Header & h) -> std::size_t {
+    return sizeof(Header) + h.size * sizeof(std::uint32_t) + std::size_t(h.size) * h.words * sizeof(BitWord);
+  }
+
+  // The header of cache_file if it is an intact, up to date cache of source
+  inline auto header(const YewPar::util::MappedFile & cache, const std::string & source, Header & h) -> bool {
+    std::uint64_t size, mtime;
+    if (cache.size() < sizeof(Header) || ! YewPar::util::fileStamp(source, size, mtime))
+      return false;
+
+    std::memcpy(&h, cache.begin(), sizeof(Header));
+    return std::memcmp(h.magic, magic, sizeof(magic)) == 0 && h.version == version
+        && h.source_size == size && h.source_mtime == mtime && cache.size() == bytes(h);
+  }
+
+  // Vertices in the graph cached in cache_file, or 0 if there is no up to date cache of source
+  inline auto cached_size(const std::string & cache_file, const std::string & source) -> unsigned {
+    try {
+      YewPar::util::MappedFile cache(cache_file);
+      Header h;
+      return header(cache, source, h) ? h.size : 0;
+    } catch (const std::runtime_error &) {
+      return 0;
+    }
+  }
+
+  // Load graph and the map back to source numbering, false if there is no up to date cache with
+  // n_words_ word rows
+  template <unsigned n_words_>
+  auto read(const std::string & cache_file, const std::string & source,
+            BitGraph<n_words_> & graph, std::map<int, int> & inv) -> bool {
+    try {
+      YewPar::util::MappedFile cache(cache_file);
+      Header h;
+      if (! header(cache, source, h) || h.words != n_words_)
+        return false;
+
+      auto pos = cache.begin() + sizeof(Header);
+      for (unsigned i = 0 ; i < h.size ; ++i) {
+        std::uint32_t v;
+        std::memcpy(&v, pos, sizeof(v));
+        pos += sizeof(v);
+        inv[i] = v;
+      }
+
+      graph.resize(h.size);
+      for (unsigned i = 0 ; i < h.size ; ++i) {
+        std::memcpy(graph.row(i).data(), pos, n_words_ * sizeof(BitWord));
+        pos += n_words_ * sizeof(BitWord);
+      }
+      return true;
+    } catch (const std::runtime_error &) {
+      return false;
+    }
+  }
+
+  // Written to a temporary file first, so readers never see half a cache
+  template <unsigned n_words_>
+  auto write(const std::string & cache_file, const std::string & source,
+             const BitGraph<n_words_> & graph, std::map<int, int> & inv) -> void {
+    Header h;
+    std::memcpy(h.magic, magic, sizeof(magic));
+    h.version = version;
+    h.size = graph.size();
+    h.words = n_words_;
+    h.unused = 0;
+    if (! YewPar::util::fileStamp(source, h.source_size, h.source_mtime))
+      throw std::runtime_error("Could not stat " + source);
+
+    std::vector<std::uint32_t> order(h.size);
+    for (unsigned i = 0 ; i < h.size ; ++i)
+      order[i] = inv[i];
+
+    auto tmp = cache_file + ".tmp";
+    {
+      std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+      out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+      out.write(reinterpret_cast<const char *>(order.data()), order.size() * sizeof(std::uint32_t));
+      for (unsigned i = 0 ; i < h.size ; ++i)
+        out.write(reinterpret_cast<const char *>(graph.row(i).data()), n_words_ * sizeof(BitWord));
+      if (! out)
+        throw std::runtime_error("Could not write graph cache " + tmp);
+    }
+
+    if (std::rename(tmp.c_str(), cache_file.c_str()) != 0)
+      throw std::runtime_error("Could not replace graph cache " + cache_file);
+  }
+}
+
+#endif
@@ -14,7 +14,7 @@
 
 #include "DimacsParser.hpp"
 #include "BitGraph.hpp"
-#include "BitSet.hpp"
+#include "GraphCache.hpp"
 
 #include "YewPar.hpp"
 
@@ -27,37 +27,36 @@
 
 #include "util/func.hpp"
 #include "util/NodeGenerator.hpp"
+#include "util/WordDispatch.hpp"
 
-// Number of Words to use in our bitset representation
-// Possible to specify at compile to to handler bigger graphs if required
-#ifndef NWORDS
-#define NWORDS 8
+// The search is instantiated for bitsets of 1, 2, 4, ... up to this many words, and runs with the
+// narrowest that holds the input graph. Possible to raise at compile time to handle bigger graphs.
+#ifndef MAX_NWORDS
+#define MAX_NWORDS 32
 #endif
 
 // Order a graphFromFile and return an ordered graph alongside a map to invert
 // the vertex numbering at the end.
 template<unsigned n_words_>
 auto orderGraphFromFile(const dimacs::GraphFromFile & g, std::map<int,int> & inv) -> BitGraph<n_words_> {
-  std::vector<int> order(g.first);
+  std::vector<int> order(g.size);
   std::iota(order.begin(), order.end(), 0);
 
   // Order by degree, tie break on number
-  std::vector<int> degrees;
-  std::transform(order.begin(), order.end(), std::back_inserter(degrees),
-                 [&] (int v) { return g.second.find(v)->second.size(); });
-
+  const auto & degrees = g.degrees;
   std::sort(order.begin(), order.end(),
             [&] (int a, int b) { return ! (degrees[a] < degrees[b] || (degrees[a] == degrees[b] && a > b)); });
 
+  std::vector<int> position(g.size);
+  for (unsigned i = 0 ; i < g.size ; ++i)
+    position[order[i]] = i;
 
   // Construct a new graph with this new ordering
   BitGraph<n_words_> graph;
-  graph.resize(g.first);
+  graph.resize(g.size);
 
-  for (unsigned i = 0 ; i < g.first ; ++i)
-    for (unsigned j = 0 ; j < g.first ; ++j)
-      if (g.second.find(order[i])->second.count(order[j]))
-        graph.add_edge(i, j);
+  for (const auto & e : g.edges)
+    graph.add_edge(position[e.first], position[e.second]);
 
   // Create inv map (maybe just return order?)
   for (int i = 0; i < order.size(); i++) {
@@ -67,21 +66,40 @@ auto orderGraphFromFile(const dimacs::GraphFromFile & g, std::map<int,int> & inv
   return graph;
 }
 
+// How GenNode bounds its children (--colouring). Every node is coloured greedily to order its
+// children, the modes differ in what the children's bounds take from that colouring.
+enum class Colouring {
+  // A child's bound is the colour of its vertex
+  Greedy,
+  // The colour classes restricted to a child's candidates (never more of them than Greedy's bound),
+  // after moving candidates that are alone in their class into another class they have no
+  // neighbours in, where there is one. Tighter, but siblings' bounds are no longer ordered.
+  Recolour
+};
+
 template<unsigned n_words_>
 auto colour_class_order(const BitGraph<n_words_> & graph,
                         const BitSet<n_words_> & p,
                         std::array<unsigned, n_words_ * bits_per_word> & p_order,
-                        std::array<unsigned, n_words_ * bits_per_word> & p_bounds) -> void {
+                        std::array<unsigned, n_words_ * bits_per_word> & p_bounds,
+                        std::vector<BitSet<n_words_> > * classes = nullptr) -> void {
   BitSet<n_words_> p_left = p; // not coloured yet
   unsigned colour = 0;         // current colour
   unsigned i = 0;              // position in p_bounds
 
+  if (classes) {
+    classes->clear();
+  }
+
   // while we've things left to colour
   while (! p_left.empty()) {
     // next colour
     ++colour;
     // things that can still be given this colour
     BitSet<n_words_> q = p_left;
+    if (classes) {
+      classes->emplace_back();
+    }
 
     // while we can still give something this colour
     while (! q.empty()) {
@@ -97,14 +115,18 @@ auto colour_class_order(const BitGraph<n_words_> & graph,
       p_bounds[i] = colour;
       p_order[i] = v;
       ++i;
+      if (classes) {
+        classes->back().set(v);
+      }
     }
   }
 }
 
 // Main Maxclique B&B Functions
-// Probably needs a copy constructor
+// Members are vertices of the ordered graph, see decodeMembers
+template <unsigned n_words_>
 struct MCSol {
-  std::vector<int> members;
+  BitSet<n_words_> members;
   int colours;
 
   template <class Archive>
@@ -114,12 +136,13 @@ struct MCSol {
   }
 };
 
+template <unsigned n_words_>
 struct MCNode {
   friend class boost::serialization::access;
 
-  MCSol sol;
+  MCSol<n_words_> sol;
   int size;
-  BitSet<NWORDS> remaining;
+  BitSet<n_words_> remaining;
 
   int getObj() const {
     return size;
@@ -134,49 +157,77 @@ struct MCNode {
 
 };
 
-struct GenNode : YewPar::NodeGenerator<MCNode, BitGraph<NWORDS> > {
-  std::array<unsigned, NWORDS * bits_per_word> p_order;
-  std::array<unsigned, NWORDS * bits_per_word> colourClass;
+// Nodes are all fixed size bitsets now, steals copy them in one go
+namespace hpx { namespace traits {
+template <unsigned n_words_>
+struct is_bitwise_serializable<MCNode<n_words_> > : YewPar::BitwiseSerializable<MCNode<n_words_> > {};
+}}
 
-  std::reference_wrapper<const BitGraph<NWORDS> > graph;
+// The clique's vertices in the input's (1 based) numbering
+template <unsigned n_words_>
+auto decodeMembers(const MCSol<n_words_> & sol, const int size, std::map<int, int> & inv) -> std::vector<int> {
+  std::vector<int> members;
+  for (int i = 0; i < size; ++i) {
+    if (sol.members.test(i)) {
+      members.push_back(inv[i] + 1);
+    }
+  }
+  std::sort(members.begin(), members.end());
+  return members;
+}
+
+template <unsigned n_words_, Colouring colouring = Colouring::Greedy>
+struct GenNode : YewPar::NodeGenerator<MCNode<n_words_>, BitGraph<n_words_> > {
+  std::array<unsigned, n_words_ * bits_per_word> p_order;
+  std::array<unsigned, n_words_ * bits_per_word> colourClass;
+
+  // The colour classes as bitsets, only kept for Recolour
+  std::vector<BitSet<n_words_> > classes;
 
-  MCSol childSol;
+  std::reference_wrapper<const BitGraph<n_words_> > graph;
+
+  MCSol<n_words_> childSol;
   int childBnd;
-  BitSet<NWORDS> p;
+  BitSet<n_words_> p;
 
   int v;
 
-  GenNode(const BitGraph<NWORDS> & graph, const MCNode & n) : graph(std::cref(graph)) {
-    colour_class_order(graph, n.remaining, p_order, colourClass);
+  GenNode(const BitGraph<n_words_> & graph, const MCNode<n_words_> & n) : graph(std::cref(graph)) {
+    colour_class_order(graph, n.remaining, p_order, colourClass,
+                       colouring == Colouring::Greedy ? nullptr : &classes);
     childSol = n.sol;
     childBnd = n.size + 1;
     p = n.remaining;
-    numChildren = p.popcount();
-    v = numChildren - 1;
+    this->numChildren = p.popcount();
+    v = this->numChildren - 1;
   }
 
   // Get the next value
-  MCNode next() override {
-    auto sol = childSol;
-    sol.members.push_back(p_order[v]);
-    sol.colours = colourClass[v] - 1;
+  MCNode<n_words_> next() override {
+    MCNode<n_words_> child;
+    nextInto(child);
+    return child;
+  }
 
-    auto cands = p;
-    graph.get().intersect_with_row(p_order[v], cands);
+  void nextInto(MCNode<n_words_> & child) {
+    child.sol.members = childSol.members;
+    child.sol.members.set(p_order[v]);
+    child.size = childBnd;
+
+    child.remaining = p;
+    graph.get().intersect_with_row(p_order[v], child.remaining);
+    child.sol.colours = childColours(v, child.remaining);
 
     // Side effectful function update
     p.unset(p_order[v]);
     v--;
-
-    return {sol, childBnd, cands};
   }
 
-  MCNode nth(unsigned n) {
+  MCNode<n_words_> nth(unsigned n) {
     auto pos = v - n;
 
     auto sol = childSol;
-    sol.members.push_back(p_order[pos]);
-    sol.colours = colourClass[pos] - 1;
+    sol.members.set(p_order[pos]);
 
     auto cands = p;
     // Remove all choices from the left "left" of the one we care about
@@ -185,36 +236,117 @@ struct GenNode : YewPar::NodeGenerator<MCNode, BitGraph<NWORDS> > {
     }
 
     graph.get().intersect_with_row(p_order[pos], cands);
+    sol.colours = childColours(pos, cands);
 
     return {sol, childBnd, cands};
   }
+
+  // Colours needed by cands, the candidates of the child branching on p_order[pos]
+  int childColours(const int pos, const BitSet<n_words_> & cands) const {
+    // cands are all adjacent to p_order[pos], so they are in the classes below its colour
+    const unsigned below = colourClass[pos] - 1;
+    if constexpr (colouring == Colouring::Greedy) {
+      return below;
+    } else {
+      // Per thread so nodes don't allocate
+      static thread_local std::vector<BitSet<n_words_> > met;
+      met.clear();
+      for (unsigned k = 0; k < below; ++k) {
+        auto c = classes[k];
+        c.intersect_with(cands);
+        if (!c.empty()) {
+          met.push_back(c);
+        }
+      }
+
+      // Each move keeps the classes independent and empties one
+      int merged = 0;
+      for (auto & from : met) {
+        if (from.popcount() != 1) {
+          continue;
+        }
+        auto u = from.first_set_bit();
+        for (auto & to : met) {
+          if (&to == &from || to.empty()) {
+            continue;
+          }
+          auto conflicts = to;
+          graph.get().intersect_with_row(u, conflicts);
+          if (conflicts.empty()) {
+            to.set(u);
+            from.unset(u);
+            ++merged;
+            break;
+          }
+        }
+      }
+      return met.size() - merged;
+    }
+  }
 };
 
-int upperBound(const BitGraph<NWORDS> & space, const MCNode & n) {
+template <unsigned n_words_>
+int upperBound(const BitGraph<n_words_> & space, const MCNode<n_words_> & n) {
   return n.size + n.sol.colours;
 }
 
-typedef func<decltype(&upperBound), &upperBound> upperBound_func;
-
-
-int hpx_main(boost::program_options::variables_map & opts) {
-  /*
-  if (!opts.count("input-file")) {
-    std::cerr << "You must provide an DIMACS input file with \n";
-    hpx::finalize();
-    return EXIT_FAILURE;
+template <unsigned n_words_>
+using upperBound_func = func<decltype(&upperBound<n_words_>), &upperBound<n_words_> >;
+
+// Only Greedy's bounds are ordered among siblings, so only it can prune the rest of a level
+template <unsigned n_words_, Colouring colouring, typename Kind>
+auto randomSearch(const BitGraph<n_words_> & graph, const MCNode<n_words_> & root,
+                  const YewPar::Skeletons::API::Params<int> & searchParameters) -> MCNode<n_words_> {
+  if constexpr (colouring == Colouring::Greedy) {
+    return YewPar::Skeletons::Random<GenNode<n_words_, colouring>,
+                                     Kind,
+                                     YewPar::Skeletons::API::BoundFunction<upperBound_func<n_words_> >,
+                                     YewPar::Skeletons::API::PruneLevel>
+        ::search(graph, root, searchParameters);
+  } else {
+    return YewPar::Skeletons::Random<GenNode<n_words_, colouring>,
+                                     Kind,
+                                     YewPar::Skeletons::API::BoundFunction<upperBound_func<n_words_> > >
+        ::search(graph, root, searchParameters);
   }
-  */
-
-  //boost::program_options::notify(opts);
-
-  auto inputFile = opts["input-file"].as<std::string>();
+}
 
-  auto gFile = dimacs::read_dimacs(inputFile);
+template <unsigned n_words_, typename Kind>
+auto randomSearch(const std::string & colouring, const BitGraph<n_words_> & graph, const MCNode<n_words_> & root,
+                  const YewPar::Skeletons::API::Params<int> & searchParameters) -> MCNode<n_words_> {
+  if (colouring == "recolour") {
+    return randomSearch<n_words_, Colouring::Recolour, Kind>(graph, root, searchParameters);
+  }
+  return randomSearch<n_words_, Colouring::Greedy, Kind>(graph, root, searchParameters);
+}
 
+// Search with n_words_ word bitsets, which must hold all of the graph's vertices. gFile is only
+// parsed (if it hasn't been already) when there's no up to date graph cache.
+template <unsigned n_words_>
+int search(boost::program_options::variables_map & opts, const std::string & inputFile,
+           dimacs::GraphFromFile & gFile) {
   // Order the graph (keep a hold of the map)
+  auto cacheFile = opts["graph-cache"].as<std::string>();
   std::map<int, int> invMap;
-  auto graph = orderGraphFromFile<NWORDS>(gFile, invMap);
+  BitGraph<n_words_> graph;
+  if (!cacheFile.empty() && graph_cache::read(cacheFile, inputFile, graph, invMap)) {
+    hpx::cout << "Graph cache: loaded " << cacheFile << hpx::endl;
+  } else {
+    if (gFile.size == 0) {
+      gFile = dimacs::read_dimacs(inputFile);
+    }
+    invMap.clear();
+    graph = orderGraphFromFile<n_words_>(gFile, invMap);
+
+    if (!cacheFile.empty()) {
+      try {
+        graph_cache::write(cacheFile, inputFile, graph, invMap);
+        hpx::cout << "Graph cache: wrote " << cacheFile << hpx::endl;
+      } catch (const std::runtime_error & e) {
+        hpx::cout << e.what() << hpx::endl;
+      }
+    }
+  }
 
   auto spawnDepth = opts["spawn-depth"].as<std::uint64_t>();
   auto decisionBound = opts["decisionBound"].as<int>();
@@ -222,14 +354,14 @@ int hpx_main(boost::program_options::variables_map & opts) {
   auto start_time = std::chrono::steady_clock::now();
 
   // Initialise Root Node
-  MCSol mcsol;
-  mcsol.members.reserve(graph.size());
+  MCSol<n_words_> mcsol;
+  mcsol.members.resize(graph.size());
   mcsol.colours = 0;
 
-  BitSet<NWORDS> cands;
+  BitSet<n_words_> cands;
   cands.resize(graph.size());
   cands.set_all();
-  MCNode root = { mcsol, 0, cands };
+  MCNode<n_words_> root = { mcsol, 0, cands };
 
   auto sol = root;
   auto skeletonType = opts["skeleton"].as<std::string>();
@@ -238,15 +370,15 @@ int hpx_main(boost::program_options::variables_map & opts) {
   //     YewPar::Skeletons::API::Params<int> searchParameters;
   //     searchParameters.expectedObjective = decisionBound;
 
-  //     sol = YewPar::Skeletons::Seq<GenNode,
+  //     sol = YewPar::Skeletons::Seq<GenNode<n_words_>,
   //                                  YewPar::Skeletons::API::Decision,
-  //                                  YewPar::Skeletons::API::BoundFunction<upperBound_func>,
+  //                                  YewPar::Skeletons::API::BoundFunction<upperBound_func<n_words_> >,
   //                                  YewPar::Skeletons::API::PruneLevel>
   //           ::search(graph, root, searchParameters);
   //   } else {
-  //   sol = YewPar::Skeletons::Seq<GenNode,
+  //   sol = YewPar::Skeletons::Seq<GenNode<n_words_>,
   //                                YewPar::Skeletons::API::Optimisation,
-  //                                YewPar::Skeletons::API::BoundFunction<upperBound_func>,
+  //                                YewPar::Skeletons::API::BoundFunction<upperBound_func<n_words_> >,
   //                                YewPar::Skeletons::API::PruneLevel>
   //         ::search(graph, root);
   //   }
@@ -255,9 +387,9 @@ int hpx_main(boost::program_options::variables_map & opts) {
   //     YewPar::Skeletons::API::Params<int> searchParameters;
   //     searchParameters.expectedObjective = decisionBound;
   //     searchParameters.spawnDepth = spawnDepth;
-  //     sol = YewPar::Skeletons::DepthBounded<GenNode,
+  //     sol = YewPar::Skeletons::DepthBounded<GenNode<n_words_>,
   //                                          YewPar::Skeletons::API::Decision,
-  //                                          YewPar::Skeletons::API::BoundFunction<upperBound_func>,
+  //                                          YewPar::Skeletons::API::BoundFunction<upperBound_func<n_words_> >,
   //                                          YewPar::Skeletons::API::PruneLevel>
   //           ::search(graph, root, searchParameters);
   //   } else {
@@ -265,17 +397,17 @@ int hpx_main(boost::program_options::variables_map & opts) {
   //     searchParameters.spawnDepth = spawnDepth;
   //     auto poolType = opts["poolType"].as<std::string>();
   //     if (poolType == "deque") {
-  //       sol = YewPar::Skeletons::DepthBounded<GenNode,
+  //       sol = YewPar::Skeletons::DepthBounded<GenNode<n_words_>,
   //                                            YewPar::Skeletons::API::Optimisation,
-  //                                            YewPar::Skeletons::API::BoundFunction<upperBound_func>,
+  //                                            YewPar::Skeletons::API::BoundFunction<upperBound_func<n_words_> >,
   //                                            YewPar::Skeletons::API::PruneLevel,
   //                                            YewPar::Skeletons::API::DepthBoundedPoolPolicy<
   //                                              Workstealing::Policies::Workpool> >
   //           ::search(graph, root, searchParameters);
   //     } else {
-  //       sol = YewPar::Skeletons::DepthBounded<GenNode,
+  //       sol = YewPar::Skeletons::DepthBounded<GenNode<n_words_>,
   //                                            YewPar::Skeletons::API::Optimisation,
-  //                                            YewPar::Skeletons::API::BoundFunction<upperBound_func>,
+  //                                            YewPar::Skeletons::API::BoundFunction<upperBound_func<n_words_> >,
   //                                            YewPar::Skeletons::API::PruneLevel,
   //                                            YewPar::Skeletons::API::DepthBoundedPoolPolicy<
   //                                              Workstealing::Policies::DepthPoolPolicy> >
@@ -287,17 +419,17 @@ int hpx_main(boost::program_options::variables_map & opts) {
   //     YewPar::Skeletons::API::Params<int> searchParameters;
   //     searchParameters.expectedObjective = decisionBound;
   //     searchParameters.stealAll = static_cast<bool>(opts.count("chunked"));
-  //     sol = YewPar::Skeletons::StackStealing<GenNode,
+  //     sol = YewPar::Skeletons::StackStealing<GenNode<n_words_>,
   //                                            YewPar::Skeletons::API::Decision,
-  //                                            YewPar::Skeletons::API::BoundFunction<upperBound_func>,
+  //                                            YewPar::Skeletons::API::BoundFunction<upperBound_func<n_words_> >,
   //                                            YewPar::Skeletons::API::PruneLevel>
   //         ::search(graph, root, searchParameters);
   //   } else {
   //     YewPar::Skeletons::API::Params<int> searchParameters;
   //     searchParameters.stealAll = static_cast<bool>(opts.count("chunked"));
-  //     sol = YewPar::Skeletons::StackStealing<GenNode,
+  //     sol = YewPar::Skeletons::StackStealing<GenNode<n_words_>,
   //                                            YewPar::Skeletons::API::Optimisation,
-  //                                            YewPar::Skeletons::API::BoundFunction<upperBound_func>,
+  //                                            YewPar::Skeletons::API::BoundFunction<upperBound_func<n_words_> >,
   //                                            YewPar::Skeletons::API::PruneLevel>
   //         ::search(graph, root, searchParameters);
   //   }
@@ -305,16 +437,16 @@ int hpx_main(boost::program_options::variables_map & opts) {
   //   YewPar::Skeletons::API::Params<int> searchParameters;
   //   searchParameters.spawnDepth = spawnDepth;
   //   if (opts.count("discrepancyOrder")) {
-  //     sol = YewPar::Skeletons::Ordered<GenNode,
+  //     sol = YewPar::Skeletons::Ordered<GenNode<n_words_>,
   //                                      YewPar::Skeletons::API::Optimisation,
-  //                                      YewPar::Skeletons::API::BoundFunction<upperBound_func>,
+  //                                      YewPar::Skeletons::API::BoundFunction<upperBound_func<n_words_> >,
   //                                      YewPar::Skeletons::API::DiscrepancySearch,
   //                                      YewPar::Skeletons::API::PruneLevel>
   //         ::search(graph, root, searchParameters);
   //   } else {
-  //   sol = YewPar::Skeletons::Ordered<GenNode,
+  //   sol = YewPar::Skeletons::Ordered<GenNode<n_words_>,
   //                                        YewPar::Skeletons::API::Optimisation,
-  //                                        YewPar::Skeletons::API::BoundFunction<upperBound_func>,
+  //                                        YewPar::Skeletons::API::BoundFunction<upperBound_func<n_words_> >,
   //                                        YewPar::Skeletons::API::PruneLevel>
   //         ::search(graph, root, searchParameters);
   //   }
@@ -323,40 +455,33 @@ int hpx_main(boost::program_options::variables_map & opts) {
   //   YewPar::Skeletons::API::Params<int> searchParameters;
   //   searchParameters.backtrackBudget = opts["backtrack-budget"].as<unsigned>();
   //   searchParameters.expectedObjective = decisionBound;
-  //   sol = YewPar::Skeletons::Budget<GenNode,
-  //                                   YewPar::Skeletons::API::BoundFunction<upperBound_func>,
+  //   sol = YewPar::Skeletons::Budget<GenNode<n_words_>,
+  //                                   YewPar::Skeletons::API::BoundFunction<upperBound_func<n_words_> >,
   //                                   YewPar::Skeletons::API::Decision,
   //                                   YewPar::Skeletons::API::PruneLevel>
   //       ::search(graph, root, searchParameters);
   //   } else {
   //     YewPar::Skeletons::API::Params<int> searchParameters;
   //     searchParameters.backtrackBudget = opts["backtrack-budget"].as<unsigned>();
-  //     sol = YewPar::Skeletons::Budget<GenNode,
+  //     sol = YewPar::Skeletons::Budget<GenNode<n_words_>,
   //                                     YewPar::Skeletons::API::Optimisation,
-  //                                     YewPar::Skeletons::API::BoundFunction<upperBound_func>,
+  //                                     YewPar::Skeletons::API::BoundFunction<upperBound_func<n_words_> >,
   //                                     YewPar::Skeletons::API::PruneLevel>
   //         ::search(graph, root, searchParameters);
   //   }
   // } else 
   if (skeletonType == "basicrandom") {
     srand((unsigned)time(NULL));  //initial the seed with sys time
-    if (decisionBound != 0) {     //apply to different searches
+    auto colouring = opts["colouring"].as<std::string>();
     YewPar::Skeletons::API::Params<int> searchParameters; //define the parameter for skeleton
     searchParameters.spawnProbability = opts["spawn-probability"].as<unsigned>(); //get the parameter from command line
-    searchParameters.expectedObjective = decisionBound;
-    sol = YewPar::Skeletons::Random<GenNode,
-                                    YewPar::Skeletons::API::BoundFunction<upperBound_func>,
-                                    YewPar::Skeletons::API::Decision,
-                                    YewPar::Skeletons::API::PruneLevel>
-        ::search(graph, root, searchParameters);  // pass all parameters to begin Decision search process
+    searchParameters.adaptiveSpawnProbability = static_cast<bool>(opts.count("adaptive-spawn-probability"));
+    searchParameters.numaReplicas = static_cast<bool>(opts.count("numa-replicas"));
+    if (decisionBound != 0) {     //apply to different searches
+      searchParameters.expectedObjective = decisionBound;
+      sol = randomSearch<n_words_, YewPar::Skeletons::API::Decision>(colouring, graph, root, searchParameters);
     } else {
-      YewPar::Skeletons::API::Params<int> searchParameters;
-      searchParameters.spawnProbability = opts["spawn-probability"].as<unsigned>(); //get the parameter from command line
-      sol = YewPar::Skeletons::Random<GenNode,
-                                      YewPar::Skeletons::API::Optimisation,
-                                      YewPar::Skeletons::API::BoundFunction<upperBound_func>,
-                                      YewPar::Skeletons::API::PruneLevel>
-          ::search(graph, root, searchParameters);  // pass all parameters to begin Optimisation search process
+      sol = randomSearch<n_words_, YewPar::Skeletons::API::Optimisation>(colouring, graph, root, searchParameters);
     }
   } else {
     hpx::cout << "Invalid skeleton type option. Should be: seq, depthbound, stacksteal or ordered" << hpx::endl;
@@ -368,11 +493,51 @@ int hpx_main(boost::program_options::variables_map & opts) {
     (std::chrono::steady_clock::now() - start_time);
 
   hpx::cout << "MaxClique Size = " << sol.size << hpx::endl;
+  hpx::cout << "Clique =";
+  for (auto m : decodeMembers(sol.sol, graph.size(), invMap)) {
+    hpx::cout << " " << m;
+  }
+  hpx::cout << hpx::endl;
   hpx::cout << "cpu = " << overall_time.count() << hpx::endl;
 
   return hpx::finalize();
 }
 
+int hpx_main(boost::program_options::variables_map & opts) {
+  /*
+  if (!opts.count("input-file")) {
+    std::cerr << "You must provide an DIMACS input file with \n";
+    hpx::finalize();
+    return EXIT_FAILURE;
+  }
+  */
+
+  //boost::program_options::notify(opts);
+
+  auto inputFile = opts["input-file"].as<std::string>();
+
+  // An up to date cache saves parsing the graph at all
+  auto cacheFile = opts["graph-cache"].as<std::string>();
+  auto size = cacheFile.empty() ? 0 : graph_cache::cached_size(cacheFile, inputFile);
+
+  dimacs::GraphFromFile gFile;
+  if (size == 0) {
+    gFile = dimacs::read_dimacs(inputFile);
+    size = gFile.size;
+  }
+
+  if (size > MAX_NWORDS * bits_per_word) {
+    hpx::cout << "Graph has " << size << " vertices, more than the " << MAX_NWORDS * bits_per_word
+              << " this build supports (raise MAX_NWORDS)" << hpx::endl;
+    hpx::finalize();
+    return EXIT_FAILURE;
+  }
+
+  return YewPar::util::withWordsFor<MAX_NWORDS>(size, [&](auto words) {
+      return search<decltype(words)::value>(opts, inputFile, gFile);
+    });
+}
+
 int main (int argc, char* argv[]) {
   boost::program_options::options_description
     desc_commandline("Usage: " HPX_APPLICATION_STRING " [options]");
@@ -394,6 +559,10 @@ int main (int argc, char* argv[]) {
       boost::program_options::value<std::string>()->required(),
       "DIMACS formatted input graph"
       )
+    ( "graph-cache",
+      boost::program_options::value<std::string>()->default_value(""),
+      "Binary copy of the ordered input graph, loaded instead of parsing the input when up to date and (re)written otherwise"
+      )
     ("discrepancyOrder", "Use discrepancy order for the ordered skeleton")
     ("chunked", "Use chunking with stack stealing")
     ("poolType",
@@ -407,9 +576,15 @@ int main (int argc, char* argv[]) {
     ( "spawn-probability",
       boost::program_options::value<unsigned>()->default_value(1000000),
       "spawn probability for random skeleton should be 0-10^n"
+      )
+    ("adaptive-spawn-probability", "Tune the spawn probability at runtime (spawn-probability is the starting value)")
+    ("numa-replicas", "Keep a copy of the graph on every NUMA domain of a locality for its workers to read")
+    ( "colouring",
+      boost::program_options::value<std::string>()->default_value("greedy"),
+      "Child bounds from the parent's colouring: greedy (the child's colour) or recolour (the classes its candidates meet, merging classes with one candidate where possible)"
       );
 
   YewPar::registerPerformanceCounters();
 
-  return hpx::init(desc_commandline, argc, argv);
+  return YewPar::init(desc_commandline, argc, argv);
 }
@@ -6,10 +6,14 @@
  * compile time.
  */
 
-#include "BitSet.hpp"
-
 #include <vector>
 
+#include "util/BitSet.hpp"
+
+using YewPar::util::BitSet;
+using YewPar::util::BitWord;
+using YewPar::util::bits_per_word;
+
 template <unsigned n_words_>
 class BitGraph
 {
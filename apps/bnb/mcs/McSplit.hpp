@@ -0,0 +1,318 @@
+#ifndef MCSPLIT_HPP
+#define MCSPLIT_HPP
+
+// Maximum common (induced) subgraph by label class partitioning, following [1].
+//
+// Rather than searching for cliques in the association graph of the two graphs (|G| * |H|
+// vertices), a node keeps the vertices not yet matched partitioned into bidomains: a set of
+// pattern vertices and a set of target vertices that may still be matched to each other, because
+// they agree on their labels and on their edges to every pair matched so far. Matching v to w
+// splits every bidomain by the labels of the edges to v and to w, so a node is linear in the size
+// of the graphs, and at most min(|left|, |right|) more pairs can come from each bidomain.
+//
+// [1] McCreesh, Prosser, Trimble (2017). A Partitioning Algorithm for Maximum Common Subgraph
+//     Problems. IJCAI 2017.
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <hpx/runtime/serialization/vector.hpp>
+
+#include "util/NodeGenerator.hpp"
+#include "util/BitwiseSerializable.hpp"
+
+#include "VFParser.hpp"
+
+namespace mcsplit {
+
+// VF graphs have 16 bit vertex numbers
+using Vertex = std::uint16_t;
+
+struct Graph {
+  unsigned size;
+  std::vector<unsigned> vertexLabels;
+  std::vector<unsigned> degrees;
+  // labels[a * size + b] is the label of the edge from a to b, 0 if there is none (loops on the
+  // diagonal)
+  std::vector<unsigned> labels;
+
+  unsigned edge(const unsigned a, const unsigned b) const {
+    return labels[a * size + b];
+  }
+
+  template <class Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & size;
+    ar & vertexLabels;
+    ar & degrees;
+    ar & labels;
+  }
+};
+
+inline Graph fromVF(const VFGraph & g) {
+  Graph res;
+  res.size = g.size;
+  res.vertexLabels = g.vertex_labels;
+  res.degrees.assign(g.size, 0);
+  res.labels.reserve(g.size * g.size);
+  for (auto a = 0u; a < g.size; ++a) {
+    for (auto b = 0u; b < g.size; ++b) {
+      res.labels.push_back(g.edges[a][b]);
+      if (a != b && (g.edges[a][b] || g.edges[b][a])) {
+        res.degrees[a]++;
+      }
+    }
+  }
+  return res;
+}
+
+struct Space {
+  Graph pattern;
+  Graph target;
+
+  template <class Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & pattern;
+    ar & target;
+  }
+};
+
+// The pattern vertices left[l, l + leftLen) may be matched to the target vertices
+// right[r, r + rightLen)
+struct Bidomain {
+  Vertex l;
+  Vertex r;
+  Vertex leftLen;
+  Vertex rightLen;
+
+  template <class Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & l;
+    ar & r;
+    ar & leftLen;
+    ar & rightLen;
+  }
+};
+
+struct Node {
+  // Matched so far, patternVertices[i] to targetVertices[i]
+  std::vector<Vertex> patternVertices;
+  std::vector<Vertex> targetVertices;
+
+  std::vector<Vertex> left;
+  std::vector<Vertex> right;
+  std::vector<Bidomain> domains;
+
+  // Matched pairs plus, for every bidomain, the smaller of its sides
+  int bound;
+
+  int getObj() const {
+    return patternVertices.size();
+  }
+
+  template <class Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & patternVertices;
+    ar & targetVertices;
+    ar & left;
+    ar & right;
+    ar & domains;
+    ar & bound;
+  }
+};
+
+namespace detail {
+
+// A vertex and the key of the bidomain it goes to, packed as key << 16 | vertex so they sort as
+// plain words. Keys are two labels of at most 17 bits each (see VFParser.cpp).
+using Keyed = std::vector<std::uint64_t>;
+
+inline std::uint64_t keyed(const std::uint64_t key, const Vertex v) {
+  return (key << 16) | v;
+}
+
+// Add a bidomain for every key found on both sides of the keyed vertices
+inline void addDomains(Keyed & ls, Keyed & rs, Node & n) {
+  std::sort(ls.begin(), ls.end());
+  std::sort(rs.begin(), rs.end());
+
+  auto li = ls.begin(), ri = rs.begin();
+  while (li != ls.end() && ri != rs.end()) {
+    auto lk = *li >> 16, rk = *ri >> 16;
+    if (lk < rk) {
+      ++li;
+    } else if (rk < lk) {
+      ++ri;
+    } else {
+      Bidomain d {static_cast<Vertex>(n.left.size()), static_cast<Vertex>(n.right.size()), 0, 0};
+      for (; li != ls.end() && (*li >> 16) == lk; ++li, ++d.leftLen) {
+        n.left.push_back(static_cast<Vertex>(*li));
+      }
+      for (; ri != rs.end() && (*ri >> 16) == lk; ++ri, ++d.rightLen) {
+        n.right.push_back(static_cast<Vertex>(*ri));
+      }
+      n.bound += std::min(d.leftLen, d.rightLen);
+      n.domains.push_back(d);
+    }
+  }
+}
+
+inline std::uint64_t edgeKey(const Graph & g, const unsigned a, const unsigned b) {
+  return (std::uint64_t(g.edge(a, b)) << 17) | g.edge(b, a);
+}
+
+}
+
+// Every vertex is in the bidomain of its vertex and loop labels
+inline Node makeRoot(const Space & space) {
+  Node root;
+  root.bound = 0;
+
+  detail::Keyed ls, rs;
+  auto key = [](const Graph & g, const unsigned v) {
+    return (std::uint64_t(g.vertexLabels[v]) << 17) | g.edge(v, v);
+  };
+  for (auto v = 0u; v < space.pattern.size; ++v) {
+    ls.push_back(detail::keyed(key(space.pattern, v), v));
+  }
+  for (auto w = 0u; w < space.target.size; ++w) {
+    rs.push_back(detail::keyed(key(space.target, w), w));
+  }
+  detail::addDomains(ls, rs, root);
+  return root;
+}
+
+// Branches on the pattern vertex v of highest degree in the bidomain with the smallest larger side:
+// first matching v to each target vertex of the bidomain (highest degree first), then leaving v
+// unmatched
+struct GenNode : YewPar::NodeGenerator<Node, Space> {
+  std::reference_wrapper<const Space> space;
+  std::reference_wrapper<const Node> parent;
+
+  unsigned domain;
+  Vertex v;
+  std::vector<Vertex> ws;
+  unsigned pos = 0;
+
+  GenNode(const Space & space, const Node & n) : space(std::cref(space)), parent(std::cref(n)) {
+    numChildren = 0;
+    if (n.domains.empty()) {
+      return;
+    }
+
+    domain = 0;
+    for (auto i = 1u; i < n.domains.size(); ++i) {
+      const auto & d = n.domains[i];
+      const auto & best = n.domains[domain];
+      if (std::max(d.leftLen, d.rightLen) < std::max(best.leftLen, best.rightLen)) {
+        domain = i;
+      }
+    }
+
+    const auto & d = n.domains[domain];
+    const auto & p = space.pattern;
+    v = *std::max_element(n.left.begin() + d.l, n.left.begin() + d.l + d.leftLen,
+                          [&](Vertex a, Vertex b) { return p.degrees[a] < p.degrees[b]; });
+
+    const auto & t = space.target;
+    ws.assign(n.right.begin() + d.r, n.right.begin() + d.r + d.rightLen);
+    std::sort(ws.begin(), ws.end(), [&](Vertex a, Vertex b) {
+        return t.degrees[a] > t.degrees[b] || (t.degrees[a] == t.degrees[b] && a < b);
+      });
+
+    numChildren = ws.size() + 1;
+  }
+
+  Node next() override {
+    Node child;
+    nextInto(child);
+    return child;
+  }
+
+  void nextInto(Node & child) {
+    const auto & n = parent.get();
+    child.patternVertices = n.patternVertices;
+    child.targetVertices = n.targetVertices;
+    child.left.clear();
+    child.right.clear();
+    child.domains.clear();
+
+    if (pos < ws.size()) {
+      match(n, ws[pos], child);
+    } else {
+      unmatched(n, child);
+    }
+    ++pos;
+  }
+
+  void skip(unsigned k) {
+    pos += k;
+  }
+
+ private:
+  // Split every bidomain by the edges to v and w
+  void match(const Node & n, const Vertex w, Node & child) {
+    const auto & p = space.get().pattern;
+    const auto & t = space.get().target;
+
+    // Nothing suspends in here, so the buffers can be shared by everything on this worker
+    static thread_local detail::Keyed ls, rs;
+
+    child.patternVertices.push_back(v);
+    child.targetVertices.push_back(w);
+    child.bound = child.patternVertices.size();
+
+    for (const auto & d : n.domains) {
+      ls.clear();
+      rs.clear();
+      for (auto i = d.l; i < d.l + d.leftLen; ++i) {
+        auto u = n.left[i];
+        if (u != v) {
+          ls.push_back(detail::keyed(detail::edgeKey(p, v, u), u));
+        }
+      }
+      for (auto i = d.r; i < d.r + d.rightLen; ++i) {
+        auto u = n.right[i];
+        if (u != w) {
+          rs.push_back(detail::keyed(detail::edgeKey(t, w, u), u));
+        }
+      }
+      detail::addDomains(ls, rs, child);
+    }
+  }
+
+  // The same bidomains without v
+  void unmatched(const Node & n, Node & child) {
+    child.bound = child.patternVertices.size();
+    for (auto i = 0u; i < n.domains.size(); ++i) {
+      auto d = n.domains[i];
+      Bidomain c {static_cast<Vertex>(child.left.size()), static_cast<Vertex>(child.right.size()), 0, d.rightLen};
+      for (auto j = d.l; j < d.l + d.leftLen; ++j) {
+        if (i != domain || n.left[j] != v) {
+          child.left.push_back(n.left[j]);
+          c.leftLen++;
+        }
+      }
+      if (c.leftLen == 0) {
+        child.left.resize(c.l);
+        continue;
+      }
+      child.right.insert(child.right.end(), n.right.begin() + d.r, n.right.begin() + d.r + d.rightLen);
+      child.bound += std::min(c.leftLen, c.rightLen);
+      child.domains.push_back(c);
+    }
+  }
+};
+
+inline int upperBound(const Space &, const Node & n) {
+  return n.bound;
+}
+
+}
+
+YEWPAR_BITWISE_SERIALIZABLE(mcsplit::Bidomain)
+
+#endif
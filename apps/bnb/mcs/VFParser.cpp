@@ -1,8 +1,11 @@
 #include "VFParser.hpp"
 
-#include <fstream>
+#include <memory>
+#include <stdexcept>
 #include <string>
 
+#include "util/MappedFile.hpp"
+
 GraphFileError::GraphFileError(const std::string & filename, const std::string & message) throw () :
   _what("Error reading graph file '" + filename + "': " + message) {}
 
@@ -10,23 +13,42 @@ auto GraphFileError::what() const throw () -> const char * {
   return _what.c_str();
 }
 
-auto read_word(std::ifstream & infile) -> unsigned
-{
-  unsigned char a, b;
-  a = static_cast<unsigned char>(infile.get());
-  b = static_cast<unsigned char>(infile.get());
-  return unsigned(a) | (unsigned(b) << 8);
-}
+// Reads little endian 16 bit words straight out of the mapped file
+struct WordReader {
+  const char * pos;
+  const char * end;
+  bool short_read = false;
+
+  operator bool() const {
+    return ! short_read;
+  }
+
+  auto read_word() -> unsigned {
+    if (end - pos < 2) {
+      short_read = true;
+      return 0;
+    }
+    auto a = static_cast<unsigned char>(pos[0]);
+    auto b = static_cast<unsigned char>(pos[1]);
+    pos += 2;
+    return unsigned(a) | (unsigned(b) << 8);
+  }
+};
 
 auto read_vf(const std::string & filename, bool unlabelled, bool no_edge_labels, bool undirected) -> VFGraph
 {
   VFGraph result;
 
-  std::ifstream infile{ filename };
-  if (! infile)
+  std::unique_ptr<YewPar::util::MappedFile> file;
+  try {
+    file.reset(new YewPar::util::MappedFile(filename));
+  } catch (const std::runtime_error &) {
     throw GraphFileError{ filename, "unable to open file" };
+  }
+
+  WordReader infile{ file->begin(), file->end() };
 
-  result.size = read_word(infile);
+  result.size = infile.read_word();
   if (! infile)
     throw GraphFileError{ filename, "error reading size" };
 
@@ -50,7 +72,7 @@ auto read_vf(const std::string & filename, bool unlabelled, bool no_edge_labels,
     e.resize(result.size);
 
   for (unsigned r = 0 ; r < result.size ; ++r) {
-    unsigned l = read_word(infile) >> (16 - k1);
+    unsigned l = infile.read_word() >> (16 - k1);
     if (unlabelled)
       l = 0;
     result.vertex_labels.at(r) = l;
@@ -61,22 +83,22 @@ auto read_vf(const std::string & filename, bool unlabelled, bool no_edge_labels,
     throw GraphFileError{ filename, "error reading attributes" };
 
   for (unsigned r = 0 ; r < result.size ; ++r) {
-    int c_end = read_word(infile);
+    int c_end = infile.read_word();
     if (! infile)
       throw GraphFileError{ filename, "error reading edges count" };
 
     for (int c = 0 ; c < c_end ; ++c) {
-      unsigned e = read_word(infile);
+      unsigned e = infile.read_word();
 
       if (e >= result.size)
         throw GraphFileError{ filename, "edge index " + std::to_string(e) + " out of bounds" };
 
       if (unlabelled) {
         result.edges[r][e] = 1;
-        read_word(infile);
+        infile.read_word();
       }
       else {
-        unsigned l = (read_word(infile) >> (16 - k1)) + 1;
+        unsigned l = (infile.read_word() >> (16 - k1)) + 1;
         //                     if (result.edges[r][e] != 0 && result.edges[r][e] != l)
         //                         throw GraphFileError{ filename, "contradicting labels on " + std::to_string(r) + " and " + std::to_string(e) };
 
@@ -93,8 +115,7 @@ auto read_vf(const std::string & filename, bool unlabelled, bool no_edge_labels,
     }
   }
 
-  infile.peek();
-  if (! infile.eof())
+  if (infile.pos != infile.end)
     throw GraphFileError{ filename, "EOF not reached" };
 
   return result;
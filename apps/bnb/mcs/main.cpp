@@ -11,9 +11,10 @@
 
 #include <boost/serialization/access.hpp>
 
+#include "YewPar.hpp"
 #include "VFParser.hpp"
 #include "BitGraph.hpp"
-#include "BitSet.hpp"
+#include "McSplit.hpp"
 
 //#include "skeletons/Seq.hpp"
 #include "skeletons/DepthBounded.hpp"
@@ -210,6 +211,8 @@ int upperBound(const BitGraph<NWORDS> & space, const MCNode & n) {
 
 typedef func<decltype(&upperBound), &upperBound> upperBound_func;
 
+typedef func<decltype(&mcsplit::upperBound), &mcsplit::upperBound> mcsplitUpperBound_func;
+
 // using ss_skel = YewPar::Skeletons::StackStealing<GenNode,
 //                                                  YewPar::Skeletons::API::BnB,
 //                                                  YewPar::Skeletons::API::BoundFunction<upperBound_func>,
@@ -224,45 +227,72 @@ int hpx_main(boost::program_options::variables_map & opts) {
   auto patternG = read_vf(patternF, opts.count("unlabelled"), opts.count("no-edge-labels"), opts.count("undirected"));
   auto targetG = read_vf(targetF, opts.count("unlabelled"), opts.count("no-edge-labels"), opts.count("undirected"));
 
-  auto prod = modular_product(patternG, targetG);
+  auto spawnDepth = opts["spawn-depth"].as<std::uint64_t>();
+  auto engine = opts["engine"].as<std::string>();
 
-  BitGraph<NWORDS> graph; std::vector<int> order, invorder;
-  std::tie(graph, order, invorder) = buildGraph<NWORDS>(prod);
+  std::map<int, int> isomorphism;
+  std::chrono::milliseconds overall_time;
+  if (engine == "mcsplit") {
+    mcsplit::Space space {mcsplit::fromVF(patternG), mcsplit::fromVF(targetG)};
 
-  if (graph.size() > bits_per_word*NWORDS) {
-    std::cout << "Binary Cannot Handle Graph of this size. Recompile with a bigger NWORDS" << std::endl;
-    hpx::finalize();
-    return EXIT_FAILURE;
-  }
+    auto start_time = std::chrono::steady_clock::now();
 
-  auto spawnDepth = opts["spawn-depth"].as<std::uint64_t>();
-  auto start_time = std::chrono::steady_clock::now();
+    YewPar::Skeletons::API::Params<int> searchParameters;
+    searchParameters.spawnDepth = spawnDepth;
+    auto result = YewPar::Skeletons::DepthBounded<mcsplit::GenNode,
+                                                  YewPar::Skeletons::API::Optimisation,
+                                                  YewPar::Skeletons::API::BoundFunction<mcsplitUpperBound_func> >
+        ::search(space, mcsplit::makeRoot(space), searchParameters);
 
-  // // Initialise Root Node
-  MCSol mcsol;
-  mcsol.members.reserve(graph.size());
-  mcsol.colours = 0;
+    overall_time = std::chrono::duration_cast<std::chrono::milliseconds>
+      (std::chrono::steady_clock::now() - start_time);
 
-  BitSet<NWORDS> cands;
-  cands.resize(graph.size());
-  cands.set_all();
-  MCNode root = {mcsol, 0, cands};
+    for (auto i = 0u; i < result.patternVertices.size(); ++i) {
+      isomorphism.insert({result.patternVertices[i], result.targetVertices[i]});
+    }
+  } else if (engine == "clique") {
+    auto prod = modular_product(patternG, targetG);
 
-  YewPar::Skeletons::API::Params<int> searchParameters;
-  searchParameters.spawnDepth = spawnDepth;
-  auto result = YewPar::Skeletons::DepthBounded<GenNode,
-                                               YewPar::Skeletons::API::Optimisation,
-                                               YewPar::Skeletons::API::BoundFunction<upperBound_func>,
-                                               YewPar::Skeletons::API::PruneLevel>
-        ::search(graph, root, searchParameters);
+    BitGraph<NWORDS> graph; std::vector<int> order, invorder;
+    std::tie(graph, order, invorder) = buildGraph<NWORDS>(prod);
 
-  auto overall_time = std::chrono::duration_cast<std::chrono::milliseconds>
-    (std::chrono::steady_clock::now() - start_time);
+    if (graph.size() > bits_per_word*NWORDS) {
+      std::cout << "Binary Cannot Handle Graph of this size. Recompile with a bigger NWORDS" << std::endl;
+      hpx::finalize();
+      return EXIT_FAILURE;
+    }
 
-  std::map<int, int> isomorphism;
-  auto sol = result.sol;
-  for (auto const & v : sol.members) {
-    isomorphism.insert(unproduct(prod.first, order[v]));
+    auto start_time = std::chrono::steady_clock::now();
+
+    // // Initialise Root Node
+    MCSol mcsol;
+    mcsol.members.reserve(graph.size());
+    mcsol.colours = 0;
+
+    BitSet<NWORDS> cands;
+    cands.resize(graph.size());
+    cands.set_all();
+    MCNode root = {mcsol, 0, cands};
+
+    YewPar::Skeletons::API::Params<int> searchParameters;
+    searchParameters.spawnDepth = spawnDepth;
+    auto result = YewPar::Skeletons::DepthBounded<GenNode,
+                                                 YewPar::Skeletons::API::Optimisation,
+                                                 YewPar::Skeletons::API::BoundFunction<upperBound_func>,
+                                                 YewPar::Skeletons::API::PruneLevel>
+          ::search(graph, root, searchParameters);
+
+    overall_time = std::chrono::duration_cast<std::chrono::milliseconds>
+      (std::chrono::steady_clock::now() - start_time);
+
+    auto sol = result.sol;
+    for (auto const & v : sol.members) {
+      isomorphism.insert(unproduct(prod.first, order[v]));
+    }
+  } else {
+    std::cout << "Invalid engine: " << engine << std::endl;
+    hpx::finalize();
+    return EXIT_FAILURE;
   }
 
   // Print Results
@@ -309,6 +339,10 @@ int main (int argc, char* argv[]) {
       boost::program_options::value<std::uint64_t>()->default_value(0),
       "Depth in the tree to spawn at"
       )
+    ( "engine",
+      boost::program_options::value<std::string>()->default_value("clique"),
+      "clique: clique search of the association graph, mcsplit: label class partitioning (no NWORDS limit)"
+      )
     ( "pattern-file",
       boost::program_options::value<std::string>(),
       "VF formatted input graph"
@@ -321,7 +355,7 @@ int main (int argc, char* argv[]) {
     ("no-edge-labels", "Get rid of edge labels, but keep vertex labels")
     ("undirected", "Make the graph undirected");
 
-  return hpx::init(desc_commandline, argc, argv);
+  return YewPar::init(desc_commandline, argc, argv);
 }
 
 
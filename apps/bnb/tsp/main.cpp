@@ -1,4 +1,10 @@
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdint>
 #include <iostream>
+#include <numeric>
+#include <random>
 #include <set>
 #include <chrono>
 #include <bitset>
@@ -15,28 +21,52 @@
 #include "skeletons/Ordered.hpp"
 #include "skeletons/Budget.hpp"
 #include "skeletons/StackStealing.hpp"
+#include "skeletons/BestFirst.hpp"
+#include "util/MemoTable.hpp"
+#include "util/BitwiseSerializable.hpp"
 
+// Cities are numbered from 1 and sets of them are single words
 #define MAX_CITIES  64
 
+// A (partial) tour, complete ones end back at the start
 struct TSPSol {
-  std::vector<unsigned> cities;
+  std::array<std::uint8_t, MAX_CITIES + 1> cities;
+  std::uint8_t length;
   unsigned tourLength;
 
+  unsigned front() const {
+    return cities[0];
+  }
+
+  unsigned back() const {
+    return cities[length - 1];
+  }
+
+  void push_back(const unsigned c) {
+    cities[length++] = c;
+  }
+
   template <class Archive>
   void serialize(Archive & ar, const unsigned int version) {
     ar & cities;
+    ar & length;
     ar & tourLength;
   }
 };
 
+template <typename Dist>
 struct TSPSpace {
-  DistanceMatrix<MAX_CITIES> distances;
+  DistanceMatrix<Dist> distances;
   unsigned numCities;
 
+  // nearest[c] holds the other cities by increasing distance from c
+  CityMatrix<std::uint8_t> nearest;
+
   template <class Archive>
   void serialize(Archive & ar, const unsigned int version) {
     ar & distances;
     ar & numCities;
+    ar & nearest;
   }
 };
 
@@ -60,109 +90,219 @@ struct TSPNode {
 
 };
 
+// Fixed size, so children and steals copy nodes in one go
+YEWPAR_BITWISE_SERIALIZABLE(TSPNode)
 
-template <std::size_t words_>
-static unsigned next_set(const std::bitset<words_> & bs, unsigned max, unsigned last_set) {
-  for (auto i = last_set + 1; i <= max; ++i) {
-    if (bs.test(i)) {
-      return i;
+// Call f on each city in cities, in increasing order, a word at a time
+template <typename F>
+static void forEachCity(const std::bitset<MAX_CITIES> & cities, F && f) {
+  static_assert(MAX_CITIES <= 64, "forEachCity reads the set as one word");
+  for (auto w = cities.to_ullong(); w; w &= w - 1) {
+    f(static_cast<unsigned>(__builtin_ctzll(w)));
+  }
+}
+
+template <typename Dist>
+CityMatrix<std::uint8_t> nearestCities(const DistanceMatrix<Dist> & distances) {
+  auto numCities = distances.size();
+  CityMatrix<std::uint8_t> nearest(numCities);
+  for (auto c = 1u; c <= numCities; ++c) {
+    auto end = nearest[c];
+    for (auto o = 1u; o <= numCities; ++o) {
+      if (o != c) {
+        *end++ = o;
+      }
     }
+    std::stable_sort(nearest[c], end, [&](const unsigned x, const unsigned y) {
+        return distances[c][x] < distances[c][y];
+      });
   }
+  return nearest;
 }
 
-struct NodeGen : YewPar::NodeGenerator<TSPNode, TSPSpace> {
+template <typename Dist>
+unsigned pathBound(const TSPSpace<Dist> & space,
+                   const std::bitset<MAX_CITIES> & cities,
+                   unsigned start);
+
+template <typename Dist>
+struct NodeGen : YewPar::NodeGenerator<TSPNode, TSPSpace<Dist> > {
   unsigned lastCity;
 
-  std::reference_wrapper<const TSPSpace> space;
+  std::reference_wrapper<const TSPSpace<Dist> > space;
   std::reference_wrapper<const TSPNode> parent;
 
-  unsigned nextToVisit;
+  // Children go to the nearest cities first, so good tours turn up early
+  std::array<std::uint8_t, MAX_CITIES> order;
+  unsigned nextToVisit = 0;
 
-  NodeGen(const TSPSpace & space, const TSPNode & n) :
+  NodeGen(const TSPSpace<Dist> & space, const TSPNode & n) :
       space(std::cref(space)), parent(std::cref(n)) {
-    lastCity = n.sol.cities.back();
-    numChildren = n.unvisited.count();
-    const auto & bs = parent.get().unvisited;
-    nextToVisit = next_set<MAX_CITIES>(bs, this->space.get().numCities, 0);
+    lastCity = n.sol.back();
+    this->numChildren = 0;
+    const auto near = space.nearest[lastCity];
+    for (auto i = 0u; i + 1 < space.numCities; ++i) {
+      if (n.unvisited.test(near[i])) {
+        order[this->numChildren++] = near[i];
+      }
+    }
   }
 
   TSPNode next() override {
-    auto nextCity = nextToVisit;
-    nextToVisit = next_set<MAX_CITIES>(parent.get().unvisited, space.get().numCities, nextToVisit);
+    TSPNode child;
+    nextInto(child);
+    return child;
+  }
+
+  void nextInto(TSPNode & child) {
+    auto nextCity = order[nextToVisit++];
+    const auto & p = parent.get();
 
     // Not quite right since partial tours don't have a length
-    auto newSol = parent.get().sol;
-    newSol.cities.push_back(nextCity);
-    newSol.tourLength += space.get().distances[lastCity][nextCity];
+    auto & newSol = child.sol;
+    std::copy_n(p.sol.cities.begin(), p.sol.length, newSol.cities.begin());
+    newSol.length = p.sol.length;
+    newSol.push_back(nextCity);
+    newSol.tourLength = p.sol.tourLength + space.get().distances[lastCity][nextCity];
 
-    auto newUnvisited = parent.get().unvisited;
-    newUnvisited.reset(nextCity);
+    child.unvisited = p.unvisited;
+    child.unvisited.reset(nextCity);
 
     // Link back to the start if we have a complete tour
-    if (newUnvisited.none()) {
-      auto start = newSol.cities.front();
-      newSol.cities.push_back(start);
+    if (child.unvisited.none()) {
+      auto start = newSol.front();
+      newSol.push_back(start);
       newSol.tourLength += space.get().distances[nextCity][start];
     }
+  }
+
+  void skip(unsigned k) {
+    nextToVisit += k;
+  }
 
-    return TSPNode { newSol, newUnvisited };
+  // boundFn of every child. A child's rest of the tour goes through its city and the cities it has
+  // left, which together are the parent's unvisited cities whichever city was added, so one
+  // pathBound does for all of them.
+  const std::vector<unsigned> & childBounds() {
+    if (!haveBounds) {
+      const auto & p = parent.get();
+      const auto & s = space.get();
+      auto rest = pathBound(s, p.unvisited, p.sol.front());
+
+      bounds.clear();
+      for (auto i = 0u; i < this->numChildren; ++i) {
+        bounds.push_back(p.sol.tourLength + s.distances[lastCity][order[i]] + rest);
+      }
+      haveBounds = true;
+    }
+    return bounds;
   }
+
+ private:
+  std::vector<unsigned> bounds;
+  bool haveBounds = false;
 };
 
-// Very simple MST function, nothing fancy so not the fastest
-unsigned mst(const TSPSpace & space,
-             unsigned lastCity,
-             std::bitset<MAX_CITIES> & remCities) {
+// Prim's algorithm on the (at most 64) cities, which is quadratic but has no setup cost
+template <typename Dist>
+unsigned mst(const TSPSpace<Dist> & space, std::bitset<MAX_CITIES> cities) {
   std::array<unsigned, MAX_CITIES> weights;
 
-  auto w = 0;
-  auto minCity = 0;
-  auto minWeight = INT_MAX;
-
-  // Set up initial weights
-  for (auto i = 1; i <= space.numCities; ++i) {
-    if (remCities.test(i)) {
-      weights[i] = space.distances[lastCity][i];
-    }
+  if (cities.none()) {
+    return 0;
   }
 
-  while (!remCities.none()) {
-    auto minWeight = INT_MAX;
-    for (auto i = 1; i <= space.numCities; ++i) {
-      if (remCities.test(i)) {
-        if (weights[i]< minWeight) {
+  unsigned w = 0;
+
+  // Set up initial weights
+  auto from = static_cast<unsigned>(__builtin_ctzll(cities.to_ullong()));
+  cities.reset(from);
+  const auto fromRow = space.distances[from];
+  forEachCity(cities, [&](unsigned i) { weights[i] = fromRow[i]; });
+
+  while (cities.any()) {
+    unsigned minCity = 0;
+    unsigned minWeight = UINT_MAX;
+    forEachCity(cities, [&](unsigned i) {
+        if (weights[i] < minWeight) {
           minWeight = weights[i];
           minCity = i;
         }
-      }
-    }
+      });
 
     w += minWeight;
-    remCities.reset(minCity);
+    cities.reset(minCity);
 
     // Update weights
-      for (auto i = 1; i <= space.numCities; ++i) {
-        if (remCities.test(i)) {
-          auto dist = space.distances[minCity][i];
-          if (dist < weights[i]) {
-            weights[i] = dist;
-          }
-        }
-      }
+    const auto row = space.distances[minCity];
+    forEachCity(cities, [&](unsigned i) {
+        weights[i] = std::min<unsigned>(weights[i], row[i]);
+      });
   }
 
   return w;
 }
 
-unsigned boundFn(const TSPSpace & space, const TSPNode & n) {
-  std::bitset<MAX_CITIES> nodes = n.unvisited;
-  nodes.set(n.sol.cities.front());
-  return n.sol.tourLength + mst(space, n.sol.cities.back(), nodes);
+// Distance from c to the nearest of cities other than c (0 if there's none)
+template <typename Dist>
+unsigned nearestIn(const TSPSpace<Dist> & space, unsigned c, const std::bitset<MAX_CITIES> & cities) {
+  const auto near = space.nearest[c];
+  for (auto i = 0u; i + 1 < space.numCities; ++i) {
+    if (cities.test(near[i])) {
+      return space.distances[c][near[i]];
+    }
+  }
+  return 0;
+}
+
+// Lower bound on the length of a path through all of cities, in any order, followed by an edge to
+// start (which is one of cities when the path begins there). The best of two bounds:
+//   - without its last edge the path spans cities, so is no shorter than their MST, and the last
+//     edge is no shorter than start's nearest city in cities
+//   - each of cities is left by an edge to another of them or to start, no shorter than the one to
+//     the nearest of those
+template <typename Dist>
+unsigned pathBound(const TSPSpace<Dist> & space,
+                   const std::bitset<MAX_CITIES> & cities,
+                   unsigned start) {
+  auto targets = cities;
+  targets.set(start);
+
+  unsigned out = 0;
+  forEachCity(cities, [&](unsigned c) { out += nearestIn(space, c, targets); });
+
+  auto tree = mst(space, cities) + nearestIn(space, start, cities);
+  return std::max(tree, out);
 }
 
-typedef func<decltype(&boundFn), &boundFn> upperBound_func;
+// The rest of the tour starts from the last city and goes through the unvisited ones to the start
+template <typename Dist>
+unsigned boundFn(const TSPSpace<Dist> & space, const TSPNode & n) {
+  if (n.unvisited.none()) {
+    return n.sol.tourLength;
+  }
+  auto cities = n.unvisited;
+  cities.set(n.sol.back());
+  return n.sol.tourLength + pathBound(space, cities, n.sol.front());
+}
 
-unsigned greedyNN(const DistanceMatrix<MAX_CITIES> & distances,
+// The rest of a tour only depends on where it is and which cities are left, so of two partial tours
+// agreeing on both only the shorter needs searching. Cities are numbered from 1, so bit 0 of the
+// unvisited set is always clear and shifting it out leaves cities 1..58 in the low 58 bits, below
+// the last city. Exact for up to 58 cities, beyond that the last city is hashed in and (very
+// rarely) two states could collide.
+template <typename Dist>
+YewPar::util::MemoTable::MemoKey memoKey(const TSPSpace<Dist> & space, const TSPNode & n) {
+  std::uint64_t rem = n.unvisited.to_ullong();
+  std::uint64_t last = n.sol.back();
+  if (space.numCities <= 58) {
+    return {(rem >> 1) | (last << 58), static_cast<std::int64_t>(n.sol.tourLength)};
+  }
+  return {rem ^ ((last + 1) * 0x9e3779b97f4a7c15ULL), static_cast<std::int64_t>(n.sol.tourLength)};
+}
+
+template <typename Dist>
+unsigned greedyNN(const DistanceMatrix<Dist> & distances,
                   const std::vector<unsigned> & cities,
                   const unsigned startingCity) {
   unsigned dist = 0;
@@ -177,7 +317,7 @@ unsigned greedyNN(const DistanceMatrix<MAX_CITIES> & distances,
 
   while (!rem.empty()) {
     auto nextCity = *(std::min_element(rem.begin(), rem.end(),
-                                       [curCity, distances](const unsigned & x, const unsigned & y){
+                                       [curCity, &distances](const unsigned & x, const unsigned & y){
                                          return distances[curCity][x] < distances[curCity][y];
                                        }));
     dist += distances[curCity][nextCity];
@@ -191,57 +331,82 @@ unsigned greedyNN(const DistanceMatrix<MAX_CITIES> & distances,
   return dist;
 }
 
-
-// TSP helper functions
-unsigned calculateTourLength(const DistanceMatrix<MAX_CITIES> & distances,
-                             const std::vector<unsigned> & cities) {
-  auto l = 0;
-  for (auto i = 0; i < cities.size() - 1; ++i) {
-    l += distances[cities[i]][cities[i+1]];
-  }
-  return l;
-}
-
-int hpx_main(boost::program_options::variables_map & opts) {
-  auto inputFile = opts["input-file"].as<std::string>();
-
-  TSPFromFile inputData;
-  try {
-    inputData = parseFile(inputFile);
-  } catch (SomethingWentWrong & e) {
-    std::cerr << e.what() << hpx::endl;
-    hpx::finalize();
+// Multi-start heuristic: a nearest neighbour tour from a random city, taking one of the two
+// nearest unvisited cities at random at each step, rotated to start at the root's city
+template <typename Dist>
+TSPNode randomisedNN(const TSPSpace<Dist> & space, const TSPNode & root, std::uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  auto start = 1 + static_cast<unsigned>(rng() % space.numCities);
+
+  std::array<std::uint8_t, MAX_CITIES> tour;
+  std::bitset<MAX_CITIES> rem = root.unvisited;
+  rem.set(root.sol.front());
+  rem.reset(start);
+  tour[0] = start;
+
+  for (auto i = 1u; i < space.numCities; ++i) {
+    const auto near = space.nearest[tour[i - 1]];
+    unsigned candidates[2];
+    auto found = 0u;
+    for (auto j = 0u; j + 1 < space.numCities && found < 2; ++j) {
+      if (rem.test(near[j])) {
+        candidates[found++] = near[j];
+      }
+    }
+    tour[i] = candidates[rng() % found];
+    rem.reset(tour[i]);
   }
 
-  DistanceMatrix<MAX_CITIES> distances;
-  if (inputData.type == TSP_TYPE::EUC_2D) {
-    distances = buildDistanceMatrixEUC2D<MAX_CITIES>(inputData);
-  } else {
-    distances = buildDistanceMatrixGEO<MAX_CITIES>(inputData);
+  TSPNode n;
+  n.sol.length = 0;
+  n.sol.tourLength = 0;
+  auto first = std::find(tour.begin(), tour.begin() + space.numCities, root.sol.front()) - tour.begin();
+  for (auto i = 0u; i < space.numCities; ++i) {
+    auto c = tour[(first + i) % space.numCities];
+    if (i > 0) {
+      n.sol.tourLength += space.distances[n.sol.back()][c];
+    }
+    n.sol.push_back(c);
   }
+  n.sol.tourLength += space.distances[n.sol.back()][n.sol.front()];
+  n.sol.push_back(n.sol.front());
+  return n;
+}
 
-  std::vector<unsigned> initialTour {1};
-  std::bitset<MAX_CITIES> unvisited;
-
+// Search with Dist distances, which must hold all of them
+template <typename Dist>
+int search(boost::program_options::variables_map & opts,
+           const TSPFromFile & inputData,
+           DistanceMatrix<Dist> distances) {
+  using NodeGen = ::NodeGen<Dist>;
+  using upperBound_func = func<decltype(&boundFn<Dist>), &boundFn<Dist> >;
+  using memo_func = func<decltype(&memoKey<Dist>), &memoKey<Dist> >;
+  using heuristic_func = func<decltype(&randomisedNN<Dist>), &randomisedNN<Dist> >;
+
+  TSPNode root;
+  root.sol.length = 0;
+  root.sol.push_back(1);
+  root.sol.tourLength = 0;
   for (auto i = 2; i <= inputData.numNodes; ++i) {
-    unvisited.set(i);
+    root.unvisited.set(i);
   }
 
   auto start_time = std::chrono::steady_clock::now();
 
-  TSPSpace space { distances , inputData.numNodes };
-  TSPSol initSol { initialTour, 0};
-  TSPNode root { initSol, unvisited };
+  auto nearest = nearestCities(distances);
+  TSPSpace<Dist> space { std::move(distances), inputData.numNodes, std::move(nearest) };
 
   auto skeletonType = opts["skeleton"].as<std::string>();
   auto spawnDepth = opts["spawn-depth"].as<unsigned>();
   auto sol = root;
 
   // Init the bound to a greedy nearest neighbour search
-  std::vector<unsigned> allCities(inputData.numNodes + 1);
+  std::vector<unsigned> allCities(inputData.numNodes);
   std::iota(allCities.begin(), allCities.end(), 1);
   YewPar::Skeletons::API::Params<unsigned> searchParameters;
-  searchParameters.initialBound = greedyNN(distances, allCities, 1);
+  searchParameters.initialBound = greedyNN(space.distances, allCities, 1);
+  searchParameters.numaReplicas = static_cast<bool>(opts.count("numa-replicas"));
+  searchParameters.multiStartMillis = opts["multistart-millis"].as<unsigned>();
 
   if (skeletonType == "seq") {
 
@@ -252,11 +417,34 @@ int hpx_main(boost::program_options::variables_map & opts) {
         ::search(space, root, searchParameters);
   } else if (skeletonType == "depthbounded") {
     searchParameters.spawnDepth = spawnDepth;
-    sol = YewPar::Skeletons::DepthBounded<NodeGen,
-                                         YewPar::Skeletons::API::Optimisation,
-                                         YewPar::Skeletons::API::BoundFunction<upperBound_func>,
-                                         YewPar::Skeletons::API::ObjectiveComparison<std::less<unsigned>>>
-               ::search(space, root, searchParameters);
+    if (opts.count("memoize")) {
+      sol = YewPar::Skeletons::DepthBounded<NodeGen,
+                                           YewPar::Skeletons::API::Optimisation,
+                                           YewPar::Skeletons::API::BoundFunction<upperBound_func>,
+                                           YewPar::Skeletons::API::Memoize<memo_func>,
+                                           YewPar::Skeletons::API::ObjectiveComparison<std::less<unsigned>>>
+                 ::search(space, root, searchParameters);
+    } else if (opts.count("lazy-incumbent")) {
+      sol = YewPar::Skeletons::DepthBounded<NodeGen,
+                                           YewPar::Skeletons::API::Optimisation,
+                                           YewPar::Skeletons::API::LazyIncumbent,
+                                           YewPar::Skeletons::API::BoundFunction<upperBound_func>,
+                                           YewPar::Skeletons::API::ObjectiveComparison<std::less<unsigned>>>
+                 ::search(space, root, searchParameters);
+    } else if (searchParameters.multiStartMillis > 0) {
+      sol = YewPar::Skeletons::DepthBounded<NodeGen,
+                                           YewPar::Skeletons::API::Optimisation,
+                                           YewPar::Skeletons::API::BoundFunction<upperBound_func>,
+                                           YewPar::Skeletons::API::InitialHeuristic<heuristic_func>,
+                                           YewPar::Skeletons::API::ObjectiveComparison<std::less<unsigned>>>
+                 ::search(space, root, searchParameters);
+    } else {
+      sol = YewPar::Skeletons::DepthBounded<NodeGen,
+                                           YewPar::Skeletons::API::Optimisation,
+                                           YewPar::Skeletons::API::BoundFunction<upperBound_func>,
+                                           YewPar::Skeletons::API::ObjectiveComparison<std::less<unsigned>>>
+                 ::search(space, root, searchParameters);
+    }
   } else if (skeletonType == "ordered") {
     searchParameters.spawnDepth = spawnDepth;
     if (opts.count("discrepancyOrder")) {
@@ -282,10 +470,27 @@ int hpx_main(boost::program_options::variables_map & opts) {
         ::search(space, root, searchParameters);
   } else if (skeletonType == "stacksteal") {
     searchParameters.stealAll = static_cast<bool>(opts.count("chunked"));
-    sol = YewPar::Skeletons::StackStealing<NodeGen,
-                                           YewPar::Skeletons::API::Optimisation,
-                                           YewPar::Skeletons::API::BoundFunction<upperBound_func>,
-                                           YewPar::Skeletons::API::ObjectiveComparison<std::less<unsigned>>>
+    searchParameters.pathSteals = static_cast<bool>(opts.count("path-steals"));
+    if (searchParameters.multiStartMillis > 0) {
+      sol = YewPar::Skeletons::StackStealing<NodeGen,
+                                             YewPar::Skeletons::API::Optimisation,
+                                             YewPar::Skeletons::API::BoundFunction<upperBound_func>,
+                                             YewPar::Skeletons::API::InitialHeuristic<heuristic_func>,
+                                             YewPar::Skeletons::API::ObjectiveComparison<std::less<unsigned>>>
+          ::search(space, root, searchParameters);
+    } else {
+      sol = YewPar::Skeletons::StackStealing<NodeGen,
+                                             YewPar::Skeletons::API::Optimisation,
+                                             YewPar::Skeletons::API::BoundFunction<upperBound_func>,
+                                             YewPar::Skeletons::API::ObjectiveComparison<std::less<unsigned>>>
+          ::search(space, root, searchParameters);
+    }
+  } else if (skeletonType == "bestfirst") {
+    searchParameters.maxFrontierSize = opts["max-frontier-size"].as<unsigned>();
+    sol = YewPar::Skeletons::BestFirst<NodeGen,
+                                       YewPar::Skeletons::API::Optimisation,
+                                       YewPar::Skeletons::API::BoundFunction<upperBound_func>,
+                                       YewPar::Skeletons::API::ObjectiveComparison<std::less<unsigned>>>
         ::search(space, root, searchParameters);
   } else {
     hpx::cout << "Invalid skeleton type\n";
@@ -296,8 +501,8 @@ int hpx_main(boost::program_options::variables_map & opts) {
                       (std::chrono::steady_clock::now() - start_time);
 
   hpx::cout << "Tour: ";
-  for (const auto c : sol.sol.cities) {
-    hpx::cout << c << ",";
+  for (auto i = 0u; i < sol.sol.length; ++i) {
+    hpx::cout << static_cast<unsigned>(sol.sol.cities[i]) << ",";
   }
   hpx::cout << hpx::endl;
   hpx::cout << "Optimal tour length: " << sol.sol.tourLength << "\n";
@@ -307,6 +512,32 @@ int hpx_main(boost::program_options::variables_map & opts) {
   return hpx::finalize();
 }
 
+int hpx_main(boost::program_options::variables_map & opts) {
+  auto inputFile = opts["input-file"].as<std::string>();
+
+  TSPFromFile inputData;
+  try {
+    inputData = parseFile(inputFile);
+  } catch (SomethingWentWrong & e) {
+    std::cerr << e.what() << hpx::endl;
+    return hpx::finalize();
+  }
+
+  if (inputData.numNodes >= MAX_CITIES) {
+    std::cerr << "At most " << MAX_CITIES - 1 << " cities are supported\n";
+    return hpx::finalize();
+  }
+
+  auto distances = inputData.type == TSP_TYPE::EUC_2D ? buildDistanceMatrixEUC2D(inputData)
+                                                      : buildDistanceMatrixGEO(inputData);
+
+  // Narrower distances mean fewer cache lines per row scan in the bounds
+  if (distances.fitsIn<std::uint16_t>()) {
+    return search<std::uint16_t>(opts, inputData, distances.as<std::uint16_t>());
+  }
+  return search<unsigned>(opts, inputData, std::move(distances));
+}
+
 int main(int argc, char* argv[]) {
   boost::program_options::options_description
       desc_commandline("Usage: " HPX_APPLICATION_STRING " [options]");
@@ -314,7 +545,7 @@ int main(int argc, char* argv[]) {
   desc_commandline.add_options()
       ( "skeleton",
         boost::program_options::value<std::string>()->default_value("seq"),
-        "Which skeleton to use: seq, depthbound, stacksteal, budget, or ordered"
+        "Which skeleton to use: seq, depthbound, stacksteal, budget, ordered or bestfirst"
         )
       ( "input-file,f",
         boost::program_options::value<std::string>()->required(),
@@ -326,6 +557,18 @@ int main(int argc, char* argv[]) {
         )
        ("discrepancyOrder", "Use discrepancy order for the ordered skeleton")
        ("chunked", "Use chunking with stack stealing")
+       ("path-steals", "Send nodes stolen remotely as paths where cheaper (stacksteal)")
+       ("numa-replicas", "Keep a copy of the distance matrix on every NUMA domain of a locality for its workers to read")
+       ("lazy-incumbent", "Only propagate bounds during the search, fetch the best tour at the end (depthbounded)")
+       ("memoize", "Prune partial tours reaching the same city with the same cities left more expensively (depthbounded)")
+      ( "multistart-millis",
+        boost::program_options::value<unsigned>()->default_value(0),
+        "Improve the initial bound with randomised nearest neighbour tours on all workers for this long (depthbounded, stacksteal)"
+        )
+      ( "max-frontier-size",
+        boost::program_options::value<unsigned>()->default_value(100000),
+        "Open nodes kept per locality before searching depth first (bestfirst)"
+        )
        ( "spawn-depth,d",
         boost::program_options::value<unsigned>()->default_value(0),
         "Depth in the tree to spawn until (for parallel skeletons only)"
@@ -333,5 +576,5 @@ int main(int argc, char* argv[]) {
 
   YewPar::registerPerformanceCounters();
 
-  return hpx::init(desc_commandline, argc, argv);
+  return YewPar::init(desc_commandline, argc, argv);
 }
@@ -1,36 +1,87 @@
 #include "parser.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "util/MappedFile.hpp"
+
+namespace {
+
+bool isSpace(const char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+// The next whitespace separated token of [pos, end), copied out so strtod can't run off the end of
+// the mapping
+bool token(const char * & pos, const char * end, char (&buf)[64]) {
+  while (pos < end && isSpace(*pos)) ++pos;
+  auto start = pos;
+  while (pos < end && !isSpace(*pos)) ++pos;
+  auto len = static_cast<std::size_t>(pos - start);
+  if (len == 0 || len >= sizeof(buf)) {
+    return false;
+  }
+  std::memcpy(buf, start, len);
+  buf[len] = '\0';
+  return true;
+}
+
+// A node line is "id x y" with an integer id and decimal coordinates
+bool parseNode(const char * pos, const char * end, unsigned & id, double & x, double & y) {
+  char buf[64];
+  char * rest;
+  if (!token(pos, end, buf) || !std::isdigit(static_cast<unsigned char>(buf[0]))) return false;
+  id = std::strtoul(buf, &rest, 10);
+  if (*rest) return false;
+  if (!token(pos, end, buf)) return false;
+  x = std::strtod(buf, &rest);
+  if (*rest) return false;
+  if (!token(pos, end, buf)) return false;
+  y = std::strtod(buf, &rest);
+  if (*rest) return false;
+  while (pos < end && isSpace(*pos)) ++pos;
+  return pos == end;
+}
+
+}
+
 TSPFromFile parseFile (const std::string & filename) {
   TSPFromFile result;
 
-  std::ifstream infile{ filename };
-  if (!infile) {
+  std::unique_ptr<YewPar::util::MappedFile> file;
+  try {
+    file.reset(new YewPar::util::MappedFile(filename));
+  } catch (const std::runtime_error &) {
     throw SomethingWentWrong { "Can't read from file" };
   }
 
-  std::string line;
-  while (std::getline(infile, line)) {
-    if (line.empty()) continue;
+  static const std::string typeField = "EDGE_WEIGHT_TYPE:";
 
-    // TODO: need to parse the type field
+  for (auto pos = file->begin(); pos < file->end(); ) {
+    auto eol = std::find(pos, file->end(), '\n');
+    auto line = pos;
+    pos = eol + 1;
 
-    static const std::regex node { R"(\s*(\d+)\s+([-]*\d+[.\d]*)\s+([-]*\d+[.\d]*))" };
-    static const std::regex type { R"(EDGE_WEIGHT_TYPE: (\w+))" };
-    std::smatch match;
-    if (regex_match(line, match, node)) {
-      result.nodeInfo[std::stoi(match.str(1))] = std::make_pair(std::stod(match.str(2)), std::stod(match.str(3)));
+    unsigned id;
+    double x, y;
+    if (parseNode(line, eol, id, x, y)) {
+      result.nodeInfo[id] = std::make_pair(x, y);
       // Assumes the nodes are in increasing order
-      result.numNodes = std::stoi(match.str(0));
-    } else if (regex_match(line, match, type)) {
-      if (match.str(1) == "EUC_2D") result.type = TSP_TYPE::EUC_2D;
-      if (match.str(1) == "GEO")    result.type = TSP_TYPE::GEO;
+      result.numNodes = id;
+    } else if (eol - line > static_cast<std::ptrdiff_t>(typeField.size()) &&
+               std::equal(typeField.begin(), typeField.end(), line)) {
+      char buf[64];
+      auto rest = line + typeField.size();
+      if (token(rest, eol, buf)) {
+        if (std::strcmp(buf, "EUC_2D") == 0) result.type = TSP_TYPE::EUC_2D;
+        if (std::strcmp(buf, "GEO") == 0)    result.type = TSP_TYPE::GEO;
+      }
     }
   }
 
-  if (! infile.eof()) {
-    throw SomethingWentWrong { "Error reading file" };
-  }
-
   return result;
 }
 
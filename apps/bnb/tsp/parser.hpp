@@ -1,11 +1,14 @@
 #ifndef TSP_PARSER
 #define TSP_PARSER
 
+#include <algorithm>
 #include <exception>
+#include <limits>
 #include <unordered_map>
 #include <fstream>
 #include <regex>
 #include <cmath>
+#include <vector>
 
 enum TSP_TYPE {
   EUC_2D, GEO
@@ -31,12 +34,69 @@ struct TSPFromFile {
 };
 
 TSPFromFile parseFile (const std::string & filename);
-template<unsigned N>
-using DistanceMatrix = std::array<std::array<unsigned, N>, N>;
 
-template<unsigned N>
-DistanceMatrix<N> buildDistanceMatrixEUC2D (const TSPFromFile & data) {
-  DistanceMatrix<N> costs;
+// A square table indexed by city, sized at runtime. Cities are numbered from 1, so row and column 0
+// are unused. Rows are padded to whole cache lines so every row starts at the same offset in one
+// and a row scan touches as few lines as it can. Distances use the narrowest T they fit in (see
+// fitsIn), and nearest city lists use std::uint8_t.
+template <typename T>
+class CityMatrix {
+ private:
+  unsigned numCities = 0;
+  unsigned stride = 0;
+  std::vector<T> cells;
+
+ public:
+  CityMatrix() = default;
+
+  explicit CityMatrix(const unsigned numCities) :
+      numCities(numCities),
+      stride(((numCities + 1) * sizeof(T) + 63) / 64 * (64 / sizeof(T))),
+      cells(static_cast<std::size_t>(numCities + 1) * stride, T{}) {}
+
+  T * operator[](const unsigned r) {
+    return cells.data() + static_cast<std::size_t>(r) * stride;
+  }
+
+  const T * operator[](const unsigned r) const {
+    return cells.data() + static_cast<std::size_t>(r) * stride;
+  }
+
+  unsigned size() const {
+    return numCities;
+  }
+
+  // Can every entry be held by a U?
+  template <typename U>
+  bool fitsIn() const {
+    return std::all_of(cells.begin(), cells.end(), [](const T x) {
+        return x <= std::numeric_limits<U>::max();
+      });
+  }
+
+  // A copy with U entries, which must all fit
+  template <typename U>
+  CityMatrix<U> as() const {
+    CityMatrix<U> m(numCities);
+    for (auto r = 0u; r <= numCities; ++r) {
+      std::copy(this->operator[](r), this->operator[](r) + numCities + 1, m[r]);
+    }
+    return m;
+  }
+
+  template <class Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & numCities;
+    ar & stride;
+    ar & cells;
+  }
+};
+
+template <typename Dist>
+using DistanceMatrix = CityMatrix<Dist>;
+
+inline DistanceMatrix<unsigned> buildDistanceMatrixEUC2D (const TSPFromFile & data) {
+  DistanceMatrix<unsigned> costs(data.numNodes);
   for (const auto & n1 : data.nodeInfo) {
     for (const auto & n2 : data.nodeInfo) {
       if (n1.first == n2.first) {
@@ -54,9 +114,8 @@ DistanceMatrix<N> buildDistanceMatrixEUC2D (const TSPFromFile & data) {
 
 unsigned calculateDistanceLatLon(std::pair<double, double> n1, std::pair<double, double> n2);
 
-template<unsigned N>
-DistanceMatrix<N> buildDistanceMatrixGEO (const TSPFromFile & data) {
-  DistanceMatrix<N> costs;
+inline DistanceMatrix<unsigned> buildDistanceMatrixGEO (const TSPFromFile & data) {
+  DistanceMatrix<unsigned> costs(data.numNodes);
 
   for (const auto & n1 : data.nodeInfo) {
     for (const auto & n2 : data.nodeInfo) {
@@ -9,6 +9,8 @@
 #include <utility>
 #include <algorithm>
 
+#include "util/BitSet.hpp"
+
 /// We'll use an array of unsigned long longs to represent our bits.
 using BitWord = unsigned long long;
 
@@ -21,6 +23,10 @@ static const constexpr int bits_per_word = sizeof(BitWord) * 8;
  * than doing all the bit voodoo inline.
  *
  * Indices start at 0.
+ *
+ * The word loops are YewPar's runtime selected SIMD kernels (see
+ * util/BitSet.hpp), including fused ones that count the bits of the
+ * result in the same pass.
  */
 template <unsigned words_>
 class FixedBitSet
@@ -72,10 +78,7 @@ class FixedBitSet
          */
         auto popcount() const -> unsigned
         {
-            unsigned result = 0;
-            for (auto & p : _bits)
-                result += __builtin_popcountll(p);
-            return result;
+            return YewPar::util::BitSetKernels::popcount(_bits.data(), words_);
         }
 
         /**
@@ -83,8 +86,7 @@ class FixedBitSet
          */
         auto intersect_with(const FixedBitSet<words_> & other) -> void
         {
-            for (typename Bits::size_type i = 0 ; i < words_ ; ++i)
-                _bits[i] = _bits[i] & other._bits[i];
+            YewPar::util::BitSetKernels::intersect(_bits.data(), other._bits.data(), words_);
         }
 
         /**
@@ -92,8 +94,15 @@ class FixedBitSet
          */
         auto union_with(const FixedBitSet<words_> & other) -> void
         {
-            for (typename Bits::size_type i = 0 ; i < words_ ; ++i)
-                _bits[i] = _bits[i] | other._bits[i];
+            YewPar::util::BitSetKernels::unite(_bits.data(), other._bits.data(), words_);
+        }
+
+        /**
+         * Union with another set, returning how many bits are then on.
+         */
+        auto union_with_popcount(const FixedBitSet<words_> & other) -> unsigned
+        {
+            return YewPar::util::BitSetKernels::unitePopcount(_bits.data(), other._bits.data(), words_);
         }
 
         /**
@@ -101,8 +110,34 @@ class FixedBitSet
          */
         auto intersect_with_complement(const FixedBitSet<words_> & other) -> void
         {
-            for (typename Bits::size_type i = 0 ; i < words_ ; ++i)
-                _bits[i] = _bits[i] & ~other._bits[i];
+            YewPar::util::BitSetKernels::intersectComplement(_bits.data(), other._bits.data(), words_);
+        }
+
+        /**
+         * Intersect with the complement of another set, returning how many
+         * bits are then on.
+         */
+        auto intersect_with_complement_popcount(const FixedBitSet<words_> & other) -> unsigned
+        {
+            return YewPar::util::BitSetKernels::intersectComplementPopcount(_bits.data(), other._bits.data(), words_);
+        }
+
+        /**
+         * Intersect with each of the first k of others, returning how many
+         * bits are then on. One pass over our words, however large k is.
+         */
+        template <std::size_t n_>
+        auto intersect_with_all_popcount(const std::array<const FixedBitSet<words_> *, n_> & others, unsigned k) -> unsigned
+        {
+            std::array<const BitWord *, n_> rows;
+            for (unsigned r = 0 ; r < k ; ++r)
+                rows[r] = others[r]->_bits.data();
+            return YewPar::util::BitSetKernels::intersectAllPopcount(_bits.data(), rows.data(), k, words_);
+        }
+
+        auto operator== (const FixedBitSet<words_> & other) const -> bool
+        {
+            return _bits == other._bits;
         }
 
         /**
@@ -111,12 +146,7 @@ class FixedBitSet
          */
         auto first_set_bit() const -> int
         {
-            for (typename Bits::size_type i = 0 ; i < _bits.size() ; ++i) {
-                int b = __builtin_ffsll(_bits[i]);
-                if (0 != b)
-                    return i * bits_per_word + b - 1;
-            }
-            return -1;
+            return YewPar::util::BitSetKernels::firstSetBit(_bits.data(), words_);
         }
 
         /**
@@ -19,9 +19,12 @@
 #include "skeletons/StackStealing.hpp"
 #include "skeletons/Ordered.hpp"
 #include "skeletons/Budget.hpp"
+#include "skeletons/Portfolio.hpp"
+#include "skeletons/Restarts.hpp"
 
 #include "util/func.hpp"
 #include "util/NodeGenerator.hpp"
+#include "util/WordDispatch.hpp"
 
 #include "lad.hh"
 #include "fixed_bit_set.hh"
@@ -30,8 +33,10 @@
 #include <hpx/util/tuple.hpp>
 #include <hpx/include/iostreams.hpp>
 
-#ifndef NWORDS
-#define NWORDS 64
+// Domains are instantiated for 1, 2, 4, ... up to this many words, and the search runs with the
+// narrowest that holds the target graph
+#ifndef MAX_NWORDS
+#define MAX_NWORDS 128
 #endif
 
 using std::array;
@@ -142,8 +147,9 @@ int largest_target_degree;
 
   Model() = default;
 
-  Model(const Graph & target, const Graph & pattern) :
-      max_graphs(5),
+  // With distance3 there is a sixth supplemental graph, of the paths of length 3
+  Model(const Graph & target, const Graph & pattern, const bool distance3 = false) :
+      max_graphs(distance3 ? 6 : 5),
       pattern_size(pattern.size()),
       full_pattern_size(pattern.size()),
       target_size(target.size()),
@@ -251,6 +257,32 @@ int largest_target_degree;
         }
       }
     }
+
+    // v and w are adjacent in graph 5 if some path v - a - b - w goes through
+    // four different vertices, which an injective mapping keeps
+    if (max_graphs > 5) {
+      for (unsigned v = 0 ; v < size ; ++v) {
+        FixedBitSet<n_words_> reach;
+        auto nv = graph_rows[v * max_graphs + 0];
+        unsigned ap = 0;
+        for (int a = nv.first_set_bit_from(ap) ; a != -1 ; a = nv.first_set_bit_from(ap)) {
+          nv.unset(a);
+          auto na = graph_rows[a * max_graphs + 0];
+          na.unset(v);
+          na.unset(a);
+          unsigned bp = 0;
+          for (int b = na.first_set_bit_from(bp) ; b != -1 ; b = na.first_set_bit_from(bp)) {
+            na.unset(b);
+            auto nb = graph_rows[b * max_graphs + 0];
+            nb.unset(a);
+            nb.unset(b);
+            reach.union_with(nb);
+          }
+        }
+        reach.unset(v);
+        graph_rows[v * max_graphs + 5] = reach;
+      }
+    }
   }
 
   template <class Archive>
@@ -282,7 +314,9 @@ auto find_unit_domain(Domains<n_words_> & domains) -> typename Domains<n_words_>
 // The max_graphs_ template parameter is so that the for each graph
 // pair loop gets unrolled, which makes an annoyingly large difference
 // to performance. Note that for larger target graphs, half of the
-// total runtime is spent in this function.
+// total runtime is spent in this function. The rows to intersect with
+// are gathered first so the domain is read, intersected with all of
+// them and counted in a single pass.
 template <unsigned n_words_, int max_graphs_>
 auto propagate_adjacency_constraints(
     const Model<n_words_> & m,
@@ -291,14 +325,41 @@ auto propagate_adjacency_constraints(
 {
   auto pattern_adjacency_bits = m.pattern_adjacencies_bits(current_assignment.variable, d.v);
 
+  array<const FixedBitSet<n_words_> *, max_graphs_> rows;
+  unsigned n_rows = 0;
+
   // for each graph pair...
   for (int g = 0 ; g < max_graphs_ ; ++g) {
     // if we're adjacent...
     if (pattern_adjacency_bits & (1u << g)) {
       // ...then we can only be mapped to adjacent vertices
-      d.values.intersect_with(m.target_graph_rows[current_assignment.value * max_graphs_ + g]);
+      rows[n_rows++] = &m.target_graph_rows[current_assignment.value * max_graphs_ + g];
     }
   }
+
+  // we might have removed values
+  d.popcount = d.values.intersect_with_all_popcount(rows, n_rows);
+}
+
+template <unsigned n_words_>
+auto propagate_simple_constraints(
+    const Model<n_words_> & m,
+    Domain<n_words_> & d,
+    const Assignment & current_assignment) -> bool
+{
+  // all different
+  d.values.unset(current_assignment.value);
+
+  // adjacency, this also updates the popcount
+  switch (m.max_graphs) {
+    case 5: propagate_adjacency_constraints<n_words_, 5>(m, d, current_assignment); break;
+    case 6: propagate_adjacency_constraints<n_words_, 6>(m, d, current_assignment); break;
+
+    default:
+      throw "you forgot to update the ugly max_graphs hack";
+  }
+
+  return 0 != d.popcount;
 }
 
 template <unsigned n_words_>
@@ -312,21 +373,7 @@ auto propagate_simple_constraints(
     if (d.fixed)
       continue;
 
-    // all different
-    d.values.unset(current_assignment.value);
-
-    // adjacency
-    switch (m.max_graphs) {
-      case 5: propagate_adjacency_constraints<n_words_, 5>(m, d, current_assignment); break;
-      case 6: propagate_adjacency_constraints<n_words_, 6>(m, d, current_assignment); break;
-
-      default:
-        throw "you forgot to update the ugly max_graphs hack";
-    }
-
-    // we might have removed values
-    d.popcount = d.values.popcount();
-    if (0 == d.popcount)
+    if (! propagate_simple_constraints(m, d, current_assignment))
       return false;
   }
 
@@ -364,6 +411,31 @@ auto propagate(
   return true;
 }
 
+// Fill new_domains (reusing its capacity) with the unfixed domains of a child that assigns
+// current_assignment, propagating the assignment's simple constraints as each domain is copied.
+// This is one pass over the domains, where copying them and then propagating is two, and gives
+// what propagate would after its first assignment, with the assigned domain dropped rather than
+// fixed.
+template <unsigned n_words_>
+auto copy_domains_and_propagate(
+    const Model<n_words_> & m,
+    const Domains<n_words_> & domains,
+    const Assignment & current_assignment,
+    Domains<n_words_> & new_domains) -> bool
+{
+  new_domains.clear();
+  for (auto & d : domains) {
+    if (d.fixed || d.v == current_assignment.variable)
+      continue;
+
+    new_domains.push_back(d);
+    if (! propagate_simple_constraints(m, new_domains.back(), current_assignment))
+      return false;
+  }
+
+  return true;
+}
+
 template <unsigned n_words_>
 auto find_branch_domain(
     const Model<n_words_> & m,
@@ -379,28 +451,6 @@ auto find_branch_domain(
   return result;
 }
 
-template <unsigned n_words_>
-auto copy_domains_and_assign(
-    const Domains<n_words_> & domains,
-    unsigned branch_v,
-    unsigned f_v) -> Domains<n_words_>
-{
-  Domains<n_words_> new_domains;
-  new_domains.reserve(domains.size());
-  for (auto & d : domains) {
-    if (d.fixed)
-      continue;
-
-    new_domains.push_back(d);
-    if (d.v == branch_v) {
-      new_domains.back().values.unset_all();
-      new_domains.back().values.set(f_v);
-      new_domains.back().popcount = 1;
-    }
-  }
-  return new_domains;
-}
-
 template <unsigned n_words_>
 auto initialise_domains(
     const Model<n_words_> & m,
@@ -520,16 +570,14 @@ auto cheap_all_different(Domains<n_words_> & domains) -> bool
     while (domain_index != -1) {
       auto & d = domains.at(domain_index);
 
-      d.values.intersect_with_complement(hall);
-      d.popcount = d.values.popcount();
+      d.popcount = d.values.intersect_with_complement_popcount(hall);
 
       if (0 == d.popcount)
         return false;
 
-      domains_so_far.union_with(d.values);
       ++neighbours_so_far;
 
-      unsigned domains_so_far_popcount = domains_so_far.popcount();
+      unsigned domains_so_far_popcount = domains_so_far.union_with_popcount(d.values);
       if (domains_so_far_popcount < neighbours_so_far) {
         return false;
       }
@@ -576,6 +624,35 @@ struct SIPNode {
   }
 };
 
+// A node relative to a sibling: they share all assignments but the last and most domains
+template <unsigned n_words_>
+struct SIPNodeDelta {
+  unsigned numDomains;
+  vector<tuple<unsigned, Domain<n_words_> > > changedDomains;
+
+  unsigned sharedAssignments;
+  vector<tuple<Assignment, bool> > newAssignments;
+
+  bool propagationSuccess;
+  bool sat;
+
+  template <class Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & numDomains;
+    ar & changedDomains;
+    ar & sharedAssignments;
+    ar & newAssignments;
+    ar & propagationSuccess;
+    ar & sat;
+  }
+};
+
+template <unsigned n_words_>
+auto same_domain(const Domain<n_words_> & a, const Domain<n_words_> & b) -> bool
+{
+  return a.v == b.v && a.popcount == b.popcount && a.fixed == b.fixed && a.values == b.values;
+}
+
 template <unsigned n_words_>
 struct GenNode : YewPar::NodeGenerator<SIPNode<n_words_>, Model<n_words_>> {
   const Domain<n_words_> * branch_domain;
@@ -619,39 +696,96 @@ struct GenNode : YewPar::NodeGenerator<SIPNode<n_words_>, Model<n_words_>> {
 
   // Get the next value
   SIPNode<n_words_> next() override {
-    if (sat) { return SIPNode<n_words_>(parent.get().assignments, true); }
+    SIPNode<n_words_> child;
+    nextInto(child);
+    return child;
+  }
+
+  // The child is built in dest, the stack frame it goes into, so its domains and assignments
+  // reuse the frame's vectors. The parent's domains are read once, straight into dest.
+  void nextInto(SIPNode<n_words_> & dest) {
+    const auto & p = parent.get();
+    dest.assignments.values.assign(p.assignments.values.begin(), p.assignments.values.end());
+
+    if (sat) {
+      dest.domains.clear();
+      dest.propagationSuccess = true;
+      dest.sat = true;
+      return;
+    }
 
-    // We need to do the copy in case we are running in parallel
-    auto newAssignments = parent.get().assignments;
     Assignment a {branch_domain->v, branch_v[f_v]};
-    newAssignments.values.push_back(hpx::util::make_tuple(std::move(a), true));
+    ++f_v;
 
-    auto dom = parent.get().domains;
-    auto new_domains = copy_domains_and_assign(dom, branch_domain->v, branch_v[f_v]);
+    // Fix the branch domain first, as propagate would for any unit domain
+    dest.assignments.values.push_back(hpx::util::make_tuple(a, true));
+    dest.assignments.values.push_back(hpx::util::make_tuple(a, false));
 
-    auto prop = propagate(model.get(), new_domains, newAssignments);
+    dest.sat = false;
+    dest.propagationSuccess =
+        copy_domains_and_propagate(model.get(), p.domains, a, dest.domains) &&
+        cheap_all_different(dest.domains) &&
+        propagate(model.get(), dest.domains, dest.assignments);
+  }
 
-    ++f_v;
+  // Skipped values are never assigned, so there's nothing to propagate
+  void skip(unsigned k) {
+    if (!sat) { f_v += k; }
+  }
+
+  // Chunked steals send siblings as deltas
+  static SIPNodeDelta<n_words_> siblingDelta(const SIPNode<n_words_> & base, const SIPNode<n_words_> & n) {
+    SIPNodeDelta<n_words_> d;
+
+    d.numDomains = n.domains.size();
+    for (unsigned i = 0; i < n.domains.size(); ++i) {
+      if (i >= base.domains.size() || !same_domain(base.domains[i], n.domains[i])) {
+        d.changedDomains.push_back(hpx::util::make_tuple(i, n.domains[i]));
+      }
+    }
 
-    //return SIPNode<n_words_>(std::move(new_domains), std::move(newAssignments), prop);
-    return SIPNode<n_words_>(new_domains, std::move(newAssignments), prop);
+    const auto & bv = base.assignments.values;
+    const auto & nv = n.assignments.values;
+    unsigned shared = 0;
+    while (shared < bv.size() && shared < nv.size() &&
+           get<0>(bv[shared]).variable == get<0>(nv[shared]).variable &&
+           get<0>(bv[shared]).value == get<0>(nv[shared]).value &&
+           get<1>(bv[shared]) == get<1>(nv[shared])) {
+      ++shared;
+    }
+    d.sharedAssignments = shared;
+    d.newAssignments.assign(nv.begin() + shared, nv.end());
+
+    d.propagationSuccess = n.propagationSuccess;
+    d.sat = n.sat;
+    return d;
   }
-};
 
-int hpx_main(boost::program_options::variables_map & opts) {
-  hpx::cout << "Using pattern file: " << opts["pattern"].as<std::string>() << hpx::endl;
-  hpx::cout << "Using target file: " << opts["target"].as<std::string>() << hpx::endl;
-  auto patternG = read_lad(opts["pattern"].as<std::string>());
-  auto targetG  = read_lad(opts["target"].as<std::string>());
+  static SIPNode<n_words_> applySiblingDelta(const SIPNode<n_words_> & base, const SIPNodeDelta<n_words_> & d) {
+    SIPNode<n_words_> n;
 
-  if (patternG.size() > targetG.size()) {
-    std::cerr << "Pattern graph larger than Target graph\n";
-    return hpx::finalize();
+    n.domains.assign(base.domains.begin(), base.domains.begin() + std::min<std::size_t>(base.domains.size(), d.numDomains));
+    n.domains.resize(d.numDomains);
+    for (const auto & c : d.changedDomains) {
+      n.domains[get<0>(c)] = get<1>(c);
+    }
+
+    n.assignments.values.reserve(d.sharedAssignments + d.newAssignments.size());
+    n.assignments.values.assign(base.assignments.values.begin(), base.assignments.values.begin() + d.sharedAssignments);
+    n.assignments.values.insert(n.assignments.values.end(), d.newAssignments.begin(), d.newAssignments.end());
+
+    n.propagationSuccess = d.propagationSuccess;
+    n.sat = d.sat;
+    return n;
   }
+};
 
-  const Model<NWORDS> m(targetG, patternG);
+// Search with n_words_ word domains, which must hold all of the target's vertices
+template <unsigned n_words_>
+int search(boost::program_options::variables_map & opts, const Graph & patternG, const Graph & targetG) {
+  const Model<n_words_> m(targetG, patternG, opts.count("distance3"));
 
-  Domains<NWORDS> domains(m.pattern_size);
+  Domains<n_words_> domains(m.pattern_size);
   if (!initialise_domains(m, domains)) {
     std::cerr << "Could not initialise domains\n";
     return hpx::finalize();
@@ -660,7 +794,7 @@ int hpx_main(boost::program_options::variables_map & opts) {
   Assignments assignments;
   assignments.values.reserve(m.pattern_size);
 
-  SIPNode<NWORDS> root(domains, assignments);
+  SIPNode<n_words_> root(domains, assignments);
 
   auto sol = root;
 
@@ -668,10 +802,12 @@ int hpx_main(boost::program_options::variables_map & opts) {
 
   YewPar::Skeletons::API::Params<bool> searchParameters;
   searchParameters.expectedObjective = true;
+  searchParameters.memoryCapMB = opts["memory-cap"].as<std::uint64_t>();
+  searchParameters.numaReplicas = static_cast<bool>(opts.count("numa-replicas"));
 
   auto skeleton = opts["skeleton"].as<std::string>();
   if (skeleton == "seq") {
-    sol = YewPar::Skeletons::Seq<GenNode<NWORDS>,
+    sol = YewPar::Skeletons::Seq<GenNode<n_words_>,
                                 YewPar::Skeletons::API::Decision,
                                 YewPar::Skeletons::API::MoreVerbose>
         ::search(m, root, searchParameters);
@@ -679,14 +815,21 @@ int hpx_main(boost::program_options::variables_map & opts) {
     searchParameters.spawnDepth = opts["spawn-depth"].as<std::uint64_t>();
     auto poolType = opts["poolType"].as<std::string>();
     if (poolType == "deque") {
-      sol = YewPar::Skeletons::DepthBounded<GenNode<NWORDS>,
+      sol = YewPar::Skeletons::DepthBounded<GenNode<n_words_>,
                                            YewPar::Skeletons::API::Decision,
                                            YewPar::Skeletons::API::DepthBoundedPoolPolicy<
                                              Workstealing::Policies::Workpool>,
                                            YewPar::Skeletons::API::MoreVerbose>
           ::search(m, root, searchParameters);
+    } else if (poolType == "perthread") {
+      sol = YewPar::Skeletons::DepthBounded<GenNode<n_words_>,
+                                           YewPar::Skeletons::API::Decision,
+                                           YewPar::Skeletons::API::DepthBoundedPoolPolicy<
+                                             Workstealing::Policies::PerThreadWorkpool>,
+                                           YewPar::Skeletons::API::MoreVerbose>
+          ::search(m, root, searchParameters);
     } else {
-      sol = YewPar::Skeletons::DepthBounded<GenNode<NWORDS>,
+      sol = YewPar::Skeletons::DepthBounded<GenNode<n_words_>,
                                            YewPar::Skeletons::API::Decision,
                                            YewPar::Skeletons::API::DepthBoundedPoolPolicy<
                                              Workstealing::Policies::DepthPoolPolicy>,
@@ -695,31 +838,55 @@ int hpx_main(boost::program_options::variables_map & opts) {
     }
   } else if (skeleton ==  "stacksteal") {
     searchParameters.stealAll = static_cast<bool>(opts.count("chunked"));
-    sol = YewPar::Skeletons::StackStealing<GenNode<NWORDS>,
+    searchParameters.claimSteals = static_cast<bool>(opts.count("claim-steals"));
+    sol = YewPar::Skeletons::StackStealing<GenNode<n_words_>,
                                          YewPar::Skeletons::API::Decision,
                                          YewPar::Skeletons::API::MoreVerbose>
         ::search(m, root, searchParameters);
   } else if (skeleton ==  "budget") {
     searchParameters.backtrackBudget = opts["backtrack-budget"].as<std::uint64_t>();
-    sol = YewPar::Skeletons::Budget<GenNode<NWORDS>,
+    searchParameters.adaptiveBudget = static_cast<bool>(opts.count("adaptive-budget"));
+    searchParameters.budgetTargetTaskMicros = opts["budget-target"].as<std::uint64_t>();
+    sol = YewPar::Skeletons::Budget<GenNode<n_words_>,
                                     YewPar::Skeletons::API::Decision,
                                     YewPar::Skeletons::API::MoreVerbose>
         ::search(m, root, searchParameters);
   } else if (skeleton ==  "ordered") {
     searchParameters.spawnDepth = opts["spawn-depth"].as<std::uint64_t>();
     if (opts.count("discrepancyOrder")) {
-      sol = YewPar::Skeletons::Ordered<GenNode<NWORDS>,
+      sol = YewPar::Skeletons::Ordered<GenNode<n_words_>,
                                       YewPar::Skeletons::API::Decision,
                                       YewPar::Skeletons::API::DiscrepancySearch,
                                       YewPar::Skeletons::API::MoreVerbose>
           ::search(m, root, searchParameters);
     } else {
-      sol = YewPar::Skeletons::Ordered<GenNode<NWORDS>,
+      sol = YewPar::Skeletons::Ordered<GenNode<n_words_>,
                                       YewPar::Skeletons::API::Decision,
                                       YewPar::Skeletons::API::MoreVerbose>
           ::search(m, root, searchParameters);
 
     }
+  } else if (skeleton ==  "restarts") {
+    searchParameters.restartBacktracks = opts["restart-backtracks"].as<unsigned>();
+    sol = YewPar::Skeletons::Restarts<GenNode<n_words_>,
+                                      YewPar::Skeletons::API::Decision,
+                                      YewPar::Skeletons::API::MoreVerbose>
+        ::search(m, root, searchParameters);
+  } else if (skeleton ==  "portfolio") {
+    typedef YewPar::Skeletons::Portfolio<GenNode<n_words_>,
+                                         YewPar::Skeletons::API::Decision,
+                                         YewPar::Skeletons::API::MoreVerbose> Portfolio;
+    searchParameters.portfolioSliceMillis = opts["portfolio-slice"].as<std::uint64_t>();
+
+    Portfolio::Config depthBounded {YewPar::Skeletons::PortfolioSkeleton::DepthBounded, searchParameters};
+    depthBounded.params.spawnDepth = opts["spawn-depth"].as<std::uint64_t>();
+    Portfolio::Config stackSteal {YewPar::Skeletons::PortfolioSkeleton::StackStealing, searchParameters};
+    Portfolio::Config budget {YewPar::Skeletons::PortfolioSkeleton::Budget, searchParameters};
+    budget.params.backtrackBudget = opts["backtrack-budget"].as<std::uint64_t>();
+    Portfolio::Config ordered {YewPar::Skeletons::PortfolioSkeleton::Ordered, searchParameters};
+    ordered.params.spawnDepth = opts["spawn-depth"].as<std::uint64_t>();
+
+    sol = Portfolio::search(m, root, {depthBounded, stackSteal, budget, ordered}, searchParameters);
   } else {
     std::cerr << "Invalid skeleton type\n";
     return hpx::finalize();
@@ -747,6 +914,28 @@ int hpx_main(boost::program_options::variables_map & opts) {
   return hpx::finalize();
 }
 
+int hpx_main(boost::program_options::variables_map & opts) {
+  hpx::cout << "Using pattern file: " << opts["pattern"].as<std::string>() << hpx::endl;
+  hpx::cout << "Using target file: " << opts["target"].as<std::string>() << hpx::endl;
+  auto patternG = read_lad(opts["pattern"].as<std::string>());
+  auto targetG  = read_lad(opts["target"].as<std::string>());
+
+  if (patternG.size() > targetG.size()) {
+    std::cerr << "Pattern graph larger than Target graph\n";
+    return hpx::finalize();
+  }
+
+  if (targetG.size() > MAX_NWORDS * bits_per_word) {
+    std::cerr << "Target graph has more than " << MAX_NWORDS * bits_per_word
+              << " vertices, rebuild with a larger MAX_NWORDS\n";
+    return hpx::finalize();
+  }
+
+  return YewPar::util::withWordsFor<MAX_NWORDS>(targetG.size(), [&](auto words) {
+      return search<decltype(words)::value>(opts, patternG, targetG);
+    });
+}
+
 int main (int argc, char* argv[]) {
   boost::program_options::options_description
       desc_commandline("Usage: " HPX_APPLICATION_STRING " [options]");
@@ -754,7 +943,7 @@ int main (int argc, char* argv[]) {
   desc_commandline.add_options()
       ( "skeleton",
         boost::program_options::value<std::string>()->default_value("seq"),
-        "Which skeleton to use: seq, depthbound, stacksteal, budget, or ordered"
+        "Which skeleton to use: seq, depthbound, stacksteal, budget, ordered, restarts or portfolio"
       )
       ( "spawn-depth,d",
         boost::program_options::value<std::uint64_t>()->default_value(0),
@@ -764,11 +953,31 @@ int main (int argc, char* argv[]) {
         boost::program_options::value<std::uint64_t>()->default_value(0),
         "Backtrack budget for budget skeleton"
       )
+      ( "portfolio-slice",
+        boost::program_options::value<std::uint64_t>()->default_value(100),
+        "Time (ms) each portfolio configuration gets in the first round, doubling every round"
+      )
+      ( "restart-backtracks",
+        boost::program_options::value<unsigned>()->default_value(100),
+        "Backtracks before the first restart, later runs get multiples of it following the Luby sequence (restarts)"
+      )
+      ("adaptive-budget", "Tune the backtrack budget at runtime (budget is the starting value)")
+      ( "budget-target",
+        boost::program_options::value<std::uint64_t>()->default_value(1000),
+        "Task duration (microseconds) the adaptive budget aims for"
+      )
+      ( "memory-cap",
+        boost::program_options::value<std::uint64_t>()->default_value(0),
+        "Stop spawning while a locality's pools and stacks hold more than this many MB (depthbounded, budget; 0 = no cap)"
+      )
+      ("numa-replicas", "Keep a copy of the model on every NUMA domain of a locality for its workers to read")
       ("poolType",
        boost::program_options::value<std::string>()->default_value("depthpool"),
-       "Pool type for depthbounded skeleton")
+       "Pool type for depthbounded skeleton (depthpool, deque or perthread)")
       ("discrepancyOrder", "Use discrepancy order for the ordered skeleton")
       ("chunked", "Use chunking with stack stealing")
+      ("claim-steals", "Let thieves claim nodes from running stacks without waiting for them (stacksteal)")
+      ("distance3", "Also filter on paths of length 3 (a sixth supplemental graph)")
       ("pattern",
       boost::program_options::value<std::string>()->required(),
       "Specify the pattern file (LAD format)"
@@ -780,5 +989,5 @@ int main (int argc, char* argv[]) {
 
   YewPar::registerPerformanceCounters();
 
-  return hpx::init(desc_commandline, argc, argv);
+  return YewPar::init(desc_commandline, argc, argv);
 }
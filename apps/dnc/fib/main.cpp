@@ -1,70 +1,67 @@
-#include <hpx/hpx.hpp>
 #include <hpx/hpx_init.hpp>
+#include <hpx/include/iostreams.hpp>
 
-#include <utility>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
 
-#include "dnc/dnc-seq.hpp"
-#include "dnc/dnc-par.hpp"
-#include "dnc/dnc-dist.hpp"
-#include "dnc/macros.hpp"
+#include "YewPar.hpp"
+#include "skeletons/DnC.hpp"
 
-// Fib functionality
-std::uint64_t fib(std::uint64_t n) {
-  return n <= 2 ? 1 : fib(n - 1) + fib(n - 2);
-}
-
-bool fib_trivial(std::uint64_t n) {
-  return n < 30;
-}
+// fib(n) = fib(n - 1) + fib(n - 2). Only the base cases are trivial, the skeleton decides how far
+// down it is worth spawning.
+struct Fib {
+  typedef std::uint64_t Input;
+  typedef std::uint64_t Result;
 
-std::pair<std::uint64_t, std::uint64_t> fib_divide(std::uint64_t n) {
-  return std::make_pair(n - 1, n - 2);
-}
+  static bool trivial(const std::uint64_t & n) {
+    return n <= 2;
+  }
 
-std::uint64_t fib_conquer(std::uint64_t n1, std::uint64_t n2) {
-  return n1 + n2;
-}
+  static std::uint64_t base(const std::uint64_t & n) {
+    return 1;
+  }
 
-// Required Action definitions
-HPX_PLAIN_ACTION(fib, fib_action)
-HPX_PLAIN_ACTION(fib_trivial, fib_trivial_action)
-HPX_PLAIN_ACTION(fib_divide, fib_divide_action)
-HPX_PLAIN_ACTION(fib_conquer, fib_conquer_action)
-YEWPAR_CREATE_DNC_PAR_ACTION(fib_par_act, std::uint64_t, fib_divide_action, fib_conquer_action, fib_trivial_action, fib_action)
-YEWPAR_CREATE_DNC_DIST_ACTION(fib_dist_act, std::uint64_t, fib_divide_action, fib_conquer_action, fib_trivial_action, fib_action)
+  static std::vector<std::uint64_t> divide(const std::uint64_t & n) {
+    return {n - 1, n - 2};
+  }
 
+  static std::uint64_t conquer(const std::uint64_t & n, const std::vector<std::uint64_t> & rs) {
+    return rs[0] + rs[1];
+  }
+};
 
 int hpx_main(boost::program_options::variables_map & opts) {
-  const std::vector<std::string> skeletonTypes = {"seq", "par", "dist" };
+  const std::vector<std::string> skeletonTypes = {"seq", "par"};
 
   auto skeletonType = opts["skeleton"].as<std::string>();
   auto found = std::find(std::begin(skeletonTypes), std::end(skeletonTypes), skeletonType);
   if (found == std::end(skeletonTypes)) {
-    std::cout << "Invalid skeleton type option. Should be: seq, par or dist" << std::endl;
+    hpx::cout << "Invalid skeleton type option. Should be: seq or par" << hpx::endl;
     hpx::finalize();
     return EXIT_FAILURE;
   }
 
   auto n = opts["n"].as<std::uint64_t>();
 
-  std::uint64_t res = 0;
+  auto start_time = std::chrono::steady_clock::now();
 
+  std::uint64_t res = 0;
   if (skeletonType == "seq") {
-    res = skeletons::DnC::Seq::dnc<std::uint64_t>
-      (fib_divide, fib_conquer, fib_trivial, fib, n);
-  }
-
-  if (skeletonType == "par") {
-    res = skeletons::DnC::Par::dnc<std::uint64_t, fib_divide_action, fib_conquer_action, fib_trivial_action, fib_action, fib_par_act>
-      (n);
+    res = YewPar::Skeletons::DnC<Fib>::sequential(n);
+  } else if (skeletonType == "par") {
+    YewPar::Skeletons::API::Params<> searchParameters;
+    searchParameters.spawnDepth = opts["spawn-depth"].as<unsigned>();
+    res = YewPar::Skeletons::DnC<Fib>::search(n, searchParameters);
   }
 
-  if (skeletonType == "dist") {
-    res = skeletons::DnC::Dist::dnc<std::uint64_t, fib_divide_action, fib_conquer_action, fib_trivial_action, fib_action, fib_dist_act>
-      (n);
-  }
+  auto overall_time = std::chrono::duration_cast<std::chrono::milliseconds>
+                      (std::chrono::steady_clock::now() - start_time);
 
-  std::cout << "Fib(" << n << ") = " << res << std::endl;
+  hpx::cout << "Fib(" << n << ") = " << res << hpx::endl;
+  hpx::cout << "cpu = " << overall_time.count() << hpx::endl;
 
   return hpx::finalize();
 }
@@ -80,8 +77,14 @@ int main(int argc, char* argv[]) {
       )
     ( "skeleton",
       boost::program_options::value<std::string>()->default_value("seq"),
-      "Type of skeleton to use: seq, par, dist"
+      "Type of skeleton to use: seq or par"
+      )
+    ( "spawn-depth,d",
+      boost::program_options::value<unsigned>()->default_value(8),
+      "Depth to always spawn until, deeper tasks are only spawned while workers are idle (par)"
       );
 
-  return hpx::init(desc_commandline, argc, argv);
+  YewPar::registerPerformanceCounters();
+
+  return YewPar::init(desc_commandline, argc, argv);
 }
@@ -4,6 +4,7 @@
 #include <memory>
 #include <chrono>
 
+#include "YewPar.hpp"
 #include "skeletons/Seq.hpp"
 #include "skeletons/DepthBounded.hpp"
 #include "skeletons/StackStealing.hpp"
@@ -116,5 +117,5 @@ int main(int argc, char* argv[]) {
 
   hpx::register_startup_function(&Workstealing::Policies::SearchManagerPerf::registerPerformanceCounters);
 
-  return hpx::init(desc_commandline, argc, argv);
+  return YewPar::init(desc_commandline, argc, argv);
 }
@@ -15,26 +15,30 @@
 #include "skeletons/DepthBounded.hpp"
 #include "skeletons/StackStealing.hpp"
 #include "skeletons/Budget.hpp"
+#include "util/BitwiseSerializable.hpp"
+#include "util/Partition.hpp"
+#include "util/SolutionSink.hpp"
 
 // N-queens doesn't have a space
 struct Empty {};
 
+// Boards up to 32 use 32 bit masks, larger ones (up to 64) 64 bit masks
+template <typename W>
 struct Node {
-    std::uint32_t all;
-    std::uint32_t ld;
-    std::uint32_t cols;
-    std::uint32_t rd;
-    std::uint32_t poss;
+    W all;
+    W ld;
+    W cols;
+    W rd;
+    W poss;
 
     Node() : all(0), ld(0), cols(0), rd(0), poss(0) {};
-    Node(std::uint32_t all, std::uint32_t ld, std::uint32_t cols,
-         std::uint32_t rd, std::uint32_t poss)
+    Node(W all, W ld, W cols, W rd, W poss)
     : all(all), ld(ld), cols(cols), rd(rd), poss(poss) {};
 };
 
 namespace hpx { namespace serialization {
-  template<class Archive>
-  void serialize(Archive & ar, Node & x, const unsigned int version) {
+  template<class Archive, typename W>
+  void serialize(Archive & ar, Node<W> & x, const unsigned int version) {
     ar & x.all;
     ar & x.ld;
     ar & x.cols;
@@ -43,40 +47,102 @@ namespace hpx { namespace serialization {
   }
 }}
 
-struct NodeGen : YewPar::NodeGenerator<Node, Empty> {
-  std::uint32_t all;
-  std::uint32_t poss;
-  std::uint32_t ld;
-  std::uint32_t cols;
-  std::uint32_t rd;
+namespace hpx { namespace traits {
+template <typename W>
+struct is_bitwise_serializable<Node<W> > : YewPar::BitwiseSerializable<Node<W> > {};
+}}
+
+template <typename W>
+int popcount(const W w) {
+  return __builtin_popcountll(w);
+}
+
+// Columns left of the middle of a board with the columns in all
+template <typename W>
+W leftHalf(const W all) {
+  auto size = popcount(all);
+  return all >> (size - size / 2);
+}
+
+// With mirror symmetry the root's children are only the first row queens left of the middle (and
+// the middle itself on odd boards), and below a middle first row queen only the second row queens
+// left of the middle. Every solution found then stands for itself and its mirror image.
+template <typename W>
+Node<W> makeRoot(const unsigned size, const bool symmetry) {
+  W all = size == 8 * sizeof(W) ? ~W(0) : (W(1) << size) - 1;
+  W poss = all;
+  if (symmetry) {
+    poss = leftHalf(all);
+    if (size % 2 == 1) {
+      poss |= W(1) << (size / 2);
+    }
+  }
+  return Node<W>(all, 0, 0, 0, poss);
+}
+
+template <typename W>
+struct NodeGen : YewPar::StaticNodeGenerator<NodeGen<W>, Node<W>, Empty> {
+  W all;
+  W poss;
+  W ld;
+  W cols;
+  W rd;
+
+  // The middle column, if this is the root of an odd board searched with symmetry (0 otherwise)
+  W middle;
 
-  NodeGen(const Empty &, const Node & parent) :
+  NodeGen(const Empty &, const Node<W> & parent) :
   all(parent.all), ld(parent.ld), cols(parent.cols)
-  , rd(parent.rd), poss(parent.poss) {
-    this->numChildren = __builtin_popcount(poss);
+  , rd(parent.rd), poss(parent.poss), middle(0) {
+    this->numChildren = popcount(poss);
+    if (cols == 0 && poss != all && popcount(all) % 2 == 1) {
+      middle = W(1) << (popcount(all) / 2);
+    }
   }
 
-  Node next() override {
-      auto bit = poss & -poss;
+  Node<W> next() {
+      W bit = poss & -poss;
       poss -= bit;
 
-      auto new_ld = (ld | bit) << 1;
-      auto new_cols = cols | bit;
-      auto new_rd = (rd | bit) >> 1;
-      auto newP = ~(new_ld | new_cols | new_rd) & all;
+      W new_ld = (ld | bit) << 1;
+      W new_cols = cols | bit;
+      W new_rd = (rd | bit) >> 1;
+      W newP = ~(new_ld | new_cols | new_rd) & all;
 
-      return Node (all, new_ld, new_cols, new_rd, newP);
+      // A middle first row queen is its own mirror image, so the second row is halved instead
+      if (bit == middle) {
+        newP &= leftHalf(all);
+      }
+
+      return Node<W>(all, new_ld, new_cols, new_rd, newP);
+  }
+
+  void skip(unsigned k) {
+    for (auto i = 0u; i < k; ++i) {
+      poss &= poss - 1;
+    }
+  }
+
+  // Children fill the last free column
+  bool childrenAreLeaves() const {
+    return popcount(all & ~cols) == 1;
   }
 };
 
-struct CountSols : YewPar::Enumerator<Node, std::uint64_t> {
+template <typename W>
+struct CountSols : YewPar::Enumerator<Node<W>, std::uint64_t> {
   std::uint64_t count;
   CountSols() : count(0) {};
 
-  void accumulate(const Node & n) override {
+  void accumulate(const Node<W> & n) override {
     if (n.cols == n.all) { count++; }
   }
 
+  // A child is a solution iff it takes the last free column
+  void accumulateChildren(const NodeGen<W> & gen) {
+    if (popcount(gen.all & ~gen.cols) == 1) { count += popcount(gen.poss); }
+  }
+
   void combine(const std::uint64_t & other) override {
     count += other;
   }
@@ -84,58 +150,198 @@ struct CountSols : YewPar::Enumerator<Node, std::uint64_t> {
   std::uint64_t get() override { return count; }
 };
 
-int hpx_main(boost::program_options::variables_map & opts) {
+// A full board, for streaming solutions with --solutions
+template <typename W>
+struct IsBoard {
+  bool operator()(const Node<W> & n, const unsigned) const {
+    return n.cols == n.all;
+  }
+};
+
+template <typename W>
+std::uint64_t search(boost::program_options::variables_map & opts, const Node<W> & root) {
   auto spawnDepth = opts["spawn-depth"].as<unsigned>();
-  auto size = opts["size"].as<unsigned>();
   auto skeleton   = opts["skeleton"].as<std::string>();
+  auto countTermination = static_cast<bool>(opts.count("count-termination"));
 
-  auto all = (1 << size) - 1;
-  Node root(all, 0, 0, 0, all);
-
-  auto start_time = std::chrono::steady_clock::now();
-
-  std::uint64_t count;
+  std::uint64_t count = 0;
   if (skeleton == "seq") {
     YewPar::Skeletons::API::Params<> searchParameters;
-    count = YewPar::Skeletons::Seq<NodeGen,
+    count = YewPar::Skeletons::Seq<NodeGen<W>,
                                     YewPar::Skeletons::API::Enumeration,
-                                    YewPar::Skeletons::API::Enumerator<CountSols>,
+                                    YewPar::Skeletons::API::Enumerator<CountSols<W> >,
                                     YewPar::Skeletons::API::DepthLimited>
              ::search(Empty(), root, searchParameters);
   } else if (skeleton == "depthbounded") {
     YewPar::Skeletons::API::Params<> searchParameters;
     searchParameters.spawnDepth = spawnDepth;
-    count = YewPar::Skeletons::DepthBounded<NodeGen,
-                                              YewPar::Skeletons::API::Enumeration,
-                                              YewPar::Skeletons::API::Enumerator<CountSols>,
-                                              YewPar::Skeletons::API::DepthLimited>
-             ::search(Empty(), root, searchParameters);
+    if (opts.count("partition")) {
+      searchParameters.checkpointFile = opts["partition"].as<std::string>();
+      searchParameters.resumeFromCheckpoint = true;
+    }
+    if (opts.count("solutions")) {
+      count = YewPar::Skeletons::DepthBounded<NodeGen<W>,
+                                                YewPar::Skeletons::API::Enumeration,
+                                                YewPar::Skeletons::API::SolutionSink<Node<W>, IsBoard<W> >,
+                                                YewPar::Skeletons::API::DepthLimited>
+               ::search(Empty(), root, searchParameters);
+    } else if (countTermination) {
+      count = YewPar::Skeletons::DepthBounded<NodeGen<W>,
+                                                YewPar::Skeletons::API::Enumeration,
+                                                YewPar::Skeletons::API::Enumerator<CountSols<W> >,
+                                                YewPar::Skeletons::API::DepthLimited,
+                                                YewPar::Skeletons::API::CountTermination>
+               ::search(Empty(), root, searchParameters);
+    } else {
+      count = YewPar::Skeletons::DepthBounded<NodeGen<W>,
+                                                YewPar::Skeletons::API::Enumeration,
+                                                YewPar::Skeletons::API::Enumerator<CountSols<W> >,
+                                                YewPar::Skeletons::API::DepthLimited>
+               ::search(Empty(), root, searchParameters);
+    }
   } else if (skeleton == "stacksteal"){
     YewPar::Skeletons::API::Params<> searchParameters;
     searchParameters.stealAll = static_cast<bool>(opts.count("chunked"));
-    count = YewPar::Skeletons::StackStealing<NodeGen,
-                                              YewPar::Skeletons::API::Enumeration,
-                                              YewPar::Skeletons::API::Enumerator<CountSols>,
-                                              YewPar::Skeletons::API::DepthLimited>
-             ::search(Empty(), root, searchParameters);
+    searchParameters.stealAdaptive = static_cast<bool>(opts.count("adaptive-chunking"));
+    searchParameters.maxDistributedSteals = opts["distributed-steals"].as<unsigned>();
+    searchParameters.stealPrefetchThreshold = opts["steal-prefetch"].as<unsigned>();
+    if (countTermination) {
+      count = YewPar::Skeletons::StackStealing<NodeGen<W>,
+                                                YewPar::Skeletons::API::Enumeration,
+                                                YewPar::Skeletons::API::Enumerator<CountSols<W> >,
+                                                YewPar::Skeletons::API::DepthLimited,
+                                                YewPar::Skeletons::API::CountTermination>
+               ::search(Empty(), root, searchParameters);
+    } else {
+      count = YewPar::Skeletons::StackStealing<NodeGen<W>,
+                                                YewPar::Skeletons::API::Enumeration,
+                                                YewPar::Skeletons::API::Enumerator<CountSols<W> >,
+                                                YewPar::Skeletons::API::DepthLimited>
+               ::search(Empty(), root, searchParameters);
+    }
   } else if (skeleton == "budget"){
     YewPar::Skeletons::API::Params<> searchParameters;
     searchParameters.backtrackBudget = opts["backtrack-budget"].as<unsigned>();
-    count = YewPar::Skeletons::Budget<NodeGen,
-                                       YewPar::Skeletons::API::Enumeration,
-                                       YewPar::Skeletons::API::Enumerator<CountSols>,
-                                       YewPar::Skeletons::API::DepthLimited>
-        ::search(Empty(), root, searchParameters);
-  } else {
+    if (countTermination) {
+      count = YewPar::Skeletons::Budget<NodeGen<W>,
+                                         YewPar::Skeletons::API::Enumeration,
+                                         YewPar::Skeletons::API::Enumerator<CountSols<W> >,
+                                         YewPar::Skeletons::API::DepthLimited,
+                                         YewPar::Skeletons::API::CountTermination>
+          ::search(Empty(), root, searchParameters);
+    } else {
+      count = YewPar::Skeletons::Budget<NodeGen<W>,
+                                         YewPar::Skeletons::API::Enumeration,
+                                         YewPar::Skeletons::API::Enumerator<CountSols<W> >,
+                                         YewPar::Skeletons::API::DepthLimited>
+          ::search(Empty(), root, searchParameters);
+    }
+  }
+  return count;
+}
+
+// Write the board's partitions for separate jobs (see util/Partition.hpp)
+template <typename W>
+void writePartitions(boost::program_options::variables_map & opts, const Node<W> & root) {
+  auto parts = YewPar::util::Partition::split<NodeGen<W>, CountSols<W> >(
+      Empty(), root,
+      opts["partition-depth"].as<unsigned>(),
+      opts["partitions"].as<unsigned>(),
+      opts["partition-probes"].as<unsigned>(),
+      popcount(root.all));
+  YewPar::util::Partition::writeParts(opts["partition-out"].as<std::string>(), parts);
+  hpx::cout << "Wrote " << parts.size() << " partitions" << hpx::endl;
+}
+
+// Count the full boards in a file written with --solutions
+template <typename W>
+std::uint64_t readSolutions(const std::string & file, const unsigned size) {
+  std::uint64_t count = 0;
+  YewPar::util::SolutionSink::readFile<Node<W> >(file, [&](const Node<W> & n) {
+    if (n.cols == n.all && popcount(n.all) == static_cast<int>(size)) {
+      count++;
+    }
+  });
+  return count;
+}
+
+int hpx_main(boost::program_options::variables_map & opts) {
+  auto size = opts["size"].as<unsigned>();
+  auto skeleton = opts["skeleton"].as<std::string>();
+  // A single queen is its own mirror image
+  auto symmetry = static_cast<bool>(opts.count("symmetry")) && size > 1;
+
+  if (skeleton != "seq" && skeleton != "depthbounded" && skeleton != "stacksteal" && skeleton != "budget") {
     hpx::cout << "Invalid skeleton type: " << skeleton << hpx::endl;
     return hpx::finalize();
   }
 
+  if (size == 0 || size > 64) {
+    hpx::cout << "Board size must be between 1 and 64" << hpx::endl;
+    return hpx::finalize();
+  }
+
+  if (opts.count("merge")) {
+    auto files = opts["merge"].as<std::vector<std::string> >();
+    hpx::cout << "Solution for n = " << size <<  ": "
+              << YewPar::util::Partition::mergeEnumerated<CountSols<std::uint64_t> >(files) << hpx::endl;
+    return hpx::finalize();
+  }
+
+  if (opts.count("read-solutions")) {
+    auto file = opts["read-solutions"].as<std::string>();
+    auto count = size <= 32 ? readSolutions<std::uint32_t>(file, size) : readSolutions<std::uint64_t>(file, size);
+    hpx::cout << "Read " << count << " solutions" << hpx::endl;
+    return hpx::finalize();
+  }
+
+  if (opts.count("partition-out")) {
+    if (size <= 32) {
+      writePartitions(opts, makeRoot<std::uint32_t>(size, symmetry));
+    } else {
+      writePartitions(opts, makeRoot<std::uint64_t>(size, symmetry));
+    }
+    return hpx::finalize();
+  }
+
+  if (opts.count("partition") && skeleton != "depthbounded") {
+    hpx::cout << "Partitions can only be searched with the depthbounded skeleton" << hpx::endl;
+    return hpx::finalize();
+  }
+
+  if (opts.count("solutions") && skeleton != "depthbounded") {
+    hpx::cout << "Solutions can only be streamed with the depthbounded skeleton" << hpx::endl;
+    return hpx::finalize();
+  }
+
+  if (opts.count("solutions")) {
+    YewPar::util::SolutionSink::begin(opts["solutions"].as<std::string>());
+  }
+
+  auto start_time = std::chrono::steady_clock::now();
+
+  std::uint64_t count;
+  if (size <= 32) {
+    count = search(opts, makeRoot<std::uint32_t>(size, symmetry));
+  } else {
+    count = search(opts, makeRoot<std::uint64_t>(size, symmetry));
+  }
+  if (opts.count("solutions")) {
+    hpx::cout << "Solutions written: " << YewPar::util::SolutionSink::end() << hpx::endl;
+  }
+  if (symmetry) {
+    count *= 2;
+  }
+
   auto overall_time = std::chrono::duration_cast<std::chrono::milliseconds>
                       (std::chrono::steady_clock::now() - start_time);
 
   hpx::cout << "Solution for n = " << size <<  ": " << count << hpx::endl;
 
+  if (opts.count("result-file")) {
+    YewPar::util::Partition::writeResult(opts["result-file"].as<std::string>(), count);
+  }
+
   hpx::cout << "=====" << hpx::endl;
   hpx::cout << "cpu = " << overall_time.count() << hpx::endl;
 
@@ -157,7 +363,7 @@ int main(int argc, char* argv[]) {
     )
     ( "size,n",
       boost::program_options::value<unsigned>()->default_value(8),
-      "Boards size"
+      "Boards size, up to 64"
     )
     ( "backtrack-budget,b",
       boost::program_options::value<unsigned>()->default_value(500),
@@ -167,9 +373,56 @@ int main(int argc, char* argv[]) {
       boost::program_options::value<bool>()->default_value(false),
       "Enable verbose output"
     )
-    ("chunked", "Use chunking with stack stealing");
+    ("chunked", "Use chunking with stack stealing")
+    ("adaptive-chunking", "Size stack steals by thief distance and remaining work")
+    ("count-termination", "Detect termination with task counters instead of a promise per task")
+    ("symmetry", "Only search first rows left of the middle (and the middle on odd boards), doubling the count")
+    ( "distributed-steals",
+      boost::program_options::value<unsigned>()->default_value(1),
+      "Maximum number of outstanding distributed steals per locality (stack stealing)"
+    )
+    ( "steal-prefetch",
+      boost::program_options::value<unsigned>()->default_value(0),
+      "Steal remotely once the stolen task buffer holds this many tasks or fewer, 0 to disable (stack stealing)"
+    )
+    ( "partition-out",
+      boost::program_options::value<std::string>(),
+      "Only split the search into partitions, written to <prefix>.0, <prefix>.1, ..."
+    )
+    ( "partition-depth",
+      boost::program_options::value<unsigned>()->default_value(3),
+      "Depth to split the search at"
+    )
+    ( "partitions",
+      boost::program_options::value<unsigned>()->default_value(16),
+      "Number of partitions to write"
+    )
+    ( "partition-probes",
+      boost::program_options::value<unsigned>()->default_value(64),
+      "Random probes estimating each subtree at the split depth"
+    )
+    ( "partition",
+      boost::program_options::value<std::string>(),
+      "Search only this partition (depthbounded)"
+    )
+    ( "result-file",
+      boost::program_options::value<std::string>(),
+      "Also write the count to this file, for --merge"
+    )
+    ( "merge",
+      boost::program_options::value<std::vector<std::string> >()->multitoken(),
+      "Only add up the counts in these result files"
+    )
+    ( "solutions",
+      boost::program_options::value<std::string>(),
+      "Also write every board to <prefix>.<locality> (depthbounded), with --symmetry only one of each mirror pair"
+    )
+    ( "read-solutions",
+      boost::program_options::value<std::string>(),
+      "Only count the boards in a file written with --solutions"
+    );
 
   YewPar::registerPerformanceCounters();
 
-  return hpx::init(desc_commandline, argc, argv);
+  return YewPar::init(desc_commandline, argc, argv);
 }
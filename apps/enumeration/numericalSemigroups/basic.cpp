@@ -2,6 +2,7 @@
 
 #include <hpx/hpx_init.hpp>
 
+#include "YewPar.hpp"
 #include "skeletons/DepthBounded.hpp"
 
 typedef unsigned char uchar;
@@ -148,5 +149,5 @@ int main(int argc, char* argv[]) {
       boost::program_options::value<unsigned>()->default_value(0),
       "Depth in the tree to count until"
     );
-  return hpx::init(desc_commandline, argc, argv);
+  return YewPar::init(desc_commandline, argc, argv);
 }
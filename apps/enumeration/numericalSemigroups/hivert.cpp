@@ -20,80 +20,61 @@
 // Numerical Semigroups don't have a space
 struct Empty {};
 
-struct NodeGen : YewPar::NodeGenerator<Monoid, Empty> {
-  Monoid group;
-  generator_iter<CHILDREN> it;
+template <unsigned S>
+struct NodeGen : YewPar::NodeGenerator<Monoid<S>, Empty> {
+  Monoid<S> group;
+  generator_iter<CHILDREN, S> it;
 
-  NodeGen(const Empty &, const Monoid & s) : group(s), it(generator_iter<CHILDREN>(s)){
+  NodeGen(const Empty &, const Monoid<S> & s) : group(s), it(generator_iter<CHILDREN, S>(s)){
     this->numChildren = it.count(group);
     it.move_next(group); // Original code skips begin
   }
 
-  Monoid next() override {
+  Monoid<S> next() override {
     auto res = remove_generator(group, it.get_gen());
     it.move_next(group);
     return res;
   }
 };
 
-// Enumerator
-struct CountDepths : YewPar::Enumerator<Monoid, std::vector<uint64_t>> {
-  std::vector<uint64_t> counts;
-  CountDepths() {
-    counts.resize(50);
-  }
-
-  void accumulate(const Monoid & m) override {
-    counts[m.genus] += 1;
-  }
+// Every monoid's genus is its depth, so the skeletons' per depth counts are the counts per genus
+template <unsigned S>
+using CountDepths = YewPar::DepthHistogramEnumerator<Monoid<S>, MAX_GENUS>;
 
-  void combine(const std::vector<uint64_t> & other) override {
-    for(auto i = 0; i < counts.size(); i++) {
-      counts[i] += other[i];
-    }
-  }
-
-  std::vector<uint64_t> get() override { return counts; }
-
-};
-
-
-int hpx_main(boost::program_options::variables_map & opts) {
+template <unsigned S>
+std::vector<std::uint64_t> search(boost::program_options::variables_map & opts) {
   auto spawnDepth = opts["spawn-depth"].as<unsigned>();
   auto maxDepth   = opts["genus"].as<unsigned>();
   auto skeleton   = opts["skeleton"].as<std::string>();
-  //auto stealAll   = opts["stealall"].as<bool>();
 
-  Monoid root;
+  Monoid<S> root;
   init_full_N(root);
 
-  auto start_time = std::chrono::steady_clock::now();
-
   std::vector<std::uint64_t> counts;
   // if (skeleton == "seq") {
   //   YewPar::Skeletons::API::Params<> searchParameters;
   //   searchParameters.maxDepth = maxDepth;
-  //   counts = YewPar::Skeletons::Seq<NodeGen,
+  //   counts = YewPar::Skeletons::Seq<NodeGen<S>,
   //                                   YewPar::Skeletons::API::Enumeration,
-  //                                   YewPar::Skeletons::API::Enumerator<CountDepths>,
+  //                                   YewPar::Skeletons::API::Enumerator<CountDepths<S> >,
   //                                   YewPar::Skeletons::API::DepthLimited>
   //            ::search(Empty(), root, searchParameters);
   // } else if (skeleton == "depthbounded") {
   //   YewPar::Skeletons::API::Params<> searchParameters;
   //   searchParameters.maxDepth   = maxDepth;
   //   searchParameters.spawnDepth = spawnDepth;
-  //   counts = YewPar::Skeletons::DepthBounded<NodeGen,
+  //   counts = YewPar::Skeletons::DepthBounded<NodeGen<S>,
   //                                           YewPar::Skeletons::API::Enumeration,
-  //                                           YewPar::Skeletons::API::Enumerator<CountDepths>,
+  //                                           YewPar::Skeletons::API::Enumerator<CountDepths<S> >,
   //                                           YewPar::Skeletons::API::DepthLimited>
   //            ::search(Empty(), root, searchParameters);
   // } else if (skeleton == "stacksteal"){
   //   YewPar::Skeletons::API::Params<> searchParameters;
   //   searchParameters.maxDepth = maxDepth;
   //   searchParameters.stealAll = static_cast<bool>(opts.count("chunked"));
-  //   counts = YewPar::Skeletons::StackStealing<NodeGen,
+  //   counts = YewPar::Skeletons::StackStealing<NodeGen<S>,
   //                                             YewPar::Skeletons::API::Enumeration,
-  //                                             YewPar::Skeletons::API::Enumerator<CountDepths>,
+  //                                             YewPar::Skeletons::API::Enumerator<CountDepths<S> >,
   //                                             YewPar::Skeletons::API::DepthLimited>
   //            ::search(Empty(), root, searchParameters);
   // } else 
@@ -101,23 +82,45 @@ int hpx_main(boost::program_options::variables_map & opts) {
     YewPar::Skeletons::API::Params<> searchParameters;
     searchParameters.backtrackBudget = opts["backtrack-budget"].as<unsigned>();
     searchParameters.maxDepth   = maxDepth;
-    counts = YewPar::Skeletons::Budget<NodeGen,
-                                       YewPar::Skeletons::API::Enumeration,
-				       YewPar::Skeletons::API::Enumerator<CountDepths>,
-				       YewPar::Skeletons::API::DepthLimited>
-	     ::search(Empty(), root, searchParameters);
+    searchParameters.joinPollMillis = opts["join-poll-millis"].as<unsigned>();
+    auto hist = YewPar::Skeletons::Budget<NodeGen<S>,
+                                          YewPar::Skeletons::API::Enumeration,
+                                          YewPar::Skeletons::API::Enumerator<CountDepths<S> >,
+                                          YewPar::Skeletons::API::DepthLimited>
+                ::search(Empty(), root, searchParameters);
+    counts.assign(hist.begin(), hist.end());
   } else if (skeleton == "basicrandom") {
     srand((unsigned)time(NULL));  //initial the seed with sys time
     YewPar::Skeletons::API::Params<> searchParameters;
     searchParameters.spawnProbability = opts["spawn-probability"].as<unsigned>();
     searchParameters.maxDepth   = maxDepth;
-    counts = YewPar::Skeletons::Random<NodeGen,
-                                       YewPar::Skeletons::API::Enumeration,
-                                       YewPar::Skeletons::API::Enumerator<CountDepths>,
-                                       YewPar::Skeletons::API::DepthLimited>
-             ::search(Empty(), root, searchParameters);
+    auto hist = YewPar::Skeletons::Random<NodeGen<S>,
+                                          YewPar::Skeletons::API::Enumeration,
+                                          YewPar::Skeletons::API::Enumerator<CountDepths<S> >,
+                                          YewPar::Skeletons::API::DepthLimited>
+                ::search(Empty(), root, searchParameters);
+    counts.assign(hist.begin(), hist.end());
   } else {
     hpx::cout << "Invalid skeleton type: " << skeleton << hpx::endl;
+  }
+  return counts;
+}
+
+int hpx_main(boost::program_options::variables_map & opts) {
+  auto maxDepth   = opts["genus"].as<unsigned>();
+
+  if (maxDepth > MAX_GENUS) {
+    hpx::cout << "Genus " << maxDepth << " is more than MAX_GENUS (" << MAX_GENUS << ")" << hpx::endl;
+    return hpx::finalize();
+  }
+
+  auto start_time = std::chrono::steady_clock::now();
+
+  // Monoids only as big as this genus needs
+  auto counts = withSizeFor(maxDepth, [&](auto size) {
+      return search<decltype(size)::value>(opts);
+    });
+  if (counts.empty()) {
     return hpx::finalize();
   }
 
@@ -159,6 +162,10 @@ int main(int argc, char* argv[]) {
       boost::program_options::value<bool>()->default_value(false),
       "Enable verbose output"
     )
+    ( "join-poll-millis",
+      boost::program_options::value<unsigned>()->default_value(0),
+      "How often (ms) the budget skeleton looks for localities connecting mid search (0 never)"
+    )
     ("chunked", "Use chunking with stack stealing")
     ( "spawn-probability",
       boost::program_options::value<unsigned>()->default_value(1000000),
@@ -167,5 +174,5 @@ int main(int argc, char* argv[]) {
 
   YewPar::registerPerformanceCounters();
 
-  return hpx::init(desc_commandline, argc, argv);
+  return YewPar::init(desc_commandline, argc, argv);
 }
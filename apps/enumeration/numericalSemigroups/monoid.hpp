@@ -2,42 +2,61 @@
 #define MONOID_HPP
 
 #include <cstdint>
+#include <cstring>
+#include <algorithm>
 #include <array>
 #include <functional>
-
-// We cant have those as C++ constant because of the #define used below in
-// remove_generator manual loop unrolling. I don't know if the unrolling is
-// doable using template metaprogamming. I didn't manage to figure out how.
+#include <iostream>
+#include <type_traits>
 
 #ifndef MAX_GENUS
 #error "Please define the MAX_GENUS macro"
 #endif
-#define SIZE_BOUND (3*(MAX_GENUS-1))
-#define NBLOCKS ((SIZE_BOUND+15) >> 4)
-#define SIZE (NBLOCKS << 4)
 
 #include <x86intrin.h>
 
-typedef uint8_t epi8 __attribute__ ((vector_size (16)));
-typedef uint8_t dec_numbers[SIZE] __attribute__ ((aligned (16)));
-typedef std::array<epi8, NBLOCKS> dec_blocks;
-typedef uint_fast64_t ind_t;  // The type used for array indexes
+#include "util/BitSet.hpp"
+#include "util/BitwiseSerializable.hpp"
+
+// A monoid to genus g keeps the decomposition numbers of 0 to 3(g - 1), rounded up to whole 16 byte
+// blocks, the unit the generator scans go in. Monoids are templated on that size and the app picks
+// the smallest one for the genus it was asked for (withSizeFor), MAX_GENUS only bounds the sizes
+// compiled in.
+//
+// The decomposition number update in remove_generator goes 16 (SSSE3), 32 (AVX2) or 64 (AVX-512BW)
+// bytes at a time. The wider kernels are compiled with target attributes and picked at runtime from
+// the level util/BitSet.hpp detects, so YEWPAR_BITSET_KERNELS also selects them.
+
+constexpr unsigned blockSize = 16;
 
-// We need to specialise an instance to epi8 since boost doesn't automatically know how to
-// handle the __vector(16) attr
-namespace hpx { namespace serialization {
-  template<class Archive>
-  void serialize(Archive & ar, epi8 & x, const unsigned int version) {
-    ar & x;
+constexpr unsigned sizeFor(const unsigned genus) {
+  return genus < 2 ? blockSize : ((3 * (genus - 1) + blockSize - 1) / blockSize) * blockSize;
+}
+
+constexpr unsigned maxSize = sizeFor(MAX_GENUS);
+
+// f(std::integral_constant<unsigned, size>) with the smallest size holding monoids of this genus
+template <unsigned size = blockSize, typename F>
+auto withSizeFor(const unsigned genus, F && f) {
+  if constexpr (size >= maxSize) {
+    return f(std::integral_constant<unsigned, size>());
+  } else {
+    if (sizeFor(genus) <= size) {
+      return f(std::integral_constant<unsigned, size>());
+    }
+    return withSizeFor<size + blockSize>(genus, f);
   }
-}}
+}
 
+typedef uint8_t epi8 __attribute__ ((vector_size (16)));
+typedef uint_fast64_t ind_t;  // The type used for array indexes
+
+template <unsigned S>
 struct Monoid
 {
-  union {
-    dec_numbers decs;
-    dec_blocks blocks;
-  };
+  static_assert(S % blockSize == 0, "Monoids hold whole blocks");
+
+  alignas(16) uint8_t decs[S];
   // Dont use char as they have to be promoted to 64 bits to do pointer arithmetic.
   ind_t conductor, min, genus;
 
@@ -50,32 +69,27 @@ struct Monoid
   }
 };
 
-void init_full_N(Monoid &);
-void print_monoid(const Monoid &);
-void print_epi8(epi8);
-inline void copy_blocks(dec_blocks &__restrict__ dst,
-			const dec_blocks &__restrict__ src);
-inline void remove_generator(Monoid &__restrict__ dst,
-		      const Monoid &__restrict__ src,
-		      ind_t gen);
-inline Monoid remove_generator(const Monoid &src, ind_t gen);
-
+// The decomposition numbers would otherwise go one byte at a time
+namespace hpx { namespace traits {
+template <unsigned S>
+struct is_bitwise_serializable<Monoid<S> > : YewPar::BitwiseSerializable<Monoid<S> > {};
+}}
 
 // typedef enum { ALL, CHILDREN } generator_type;
 class ALL {};
 class CHILDREN {};
 
 // template <generator_type T> class generator_iter
-template <class T> class generator_iter
+template <class T, unsigned S> class generator_iter
 {
 private:
-  unsigned int mask;   // movemask_epi8 returns a 32 bits values
-  ind_t iblock, gen, bound;
+  unsigned int mask;   // The generators left in the block at base, movemask_epi8 returns a 32 bits values
+  ind_t base, gen, bound;
 
 public:
-  generator_iter(const Monoid & mon);
-  bool move_next(const Monoid & mon);
-  uint8_t count(const Monoid & mon);
+  generator_iter(const Monoid<S> & mon);
+  bool move_next(const Monoid<S> & mon);
+  uint8_t count(const Monoid<S> & mon);
   inline ind_t get_gen() const {return gen; };
 };
 
@@ -124,86 +138,150 @@ const epi8 shift16[16] =
     {m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1, 0, 1, 2},
     {m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1, 0, 1},
     {m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1, 0} };
-const epi8 mask16[16] =
-  { {m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1},
-    { 0,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1},
-    { 0, 0,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1},
-    { 0, 0, 0,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1},
-    { 0, 0, 0, 0,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1},
-    { 0, 0, 0, 0, 0,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1},
-    { 0, 0, 0, 0, 0, 0,m1,m1,m1,m1,m1,m1,m1,m1,m1,m1},
-    { 0, 0, 0, 0, 0, 0, 0,m1,m1,m1,m1,m1,m1,m1,m1,m1},
-    { 0, 0, 0, 0, 0, 0, 0, 0,m1,m1,m1,m1,m1,m1,m1,m1},
-    { 0, 0, 0, 0, 0, 0, 0, 0, 0,m1,m1,m1,m1,m1,m1,m1},
-    { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,m1,m1,m1,m1,m1,m1},
-    { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,m1,m1,m1,m1,m1},
-    { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,m1,m1,m1,m1},
-    { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,m1,m1,m1},
-    { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,m1,m1},
-    { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,m1} };
-
-template<> inline generator_iter<ALL>::generator_iter(const Monoid & mon)
-  : bound((mon.conductor+mon.min+15) >> 4)
+
+namespace monoid_kernels {
+
+typedef uint8_t epi8x32 __attribute__ ((vector_size (32)));
+typedef uint8_t epi8x64 __attribute__ ((vector_size (64)));
+
+// 16, 32 or 64, the widest kernels this CPU has
+inline unsigned detectWidth() {
+#ifdef YEWPAR_BITSET_X86
+  auto l = YewPar::util::BitSetKernels::level();
+  if (l >= YewPar::util::BitSetKernels::Level::AVX512 && __builtin_cpu_supports("avx512bw")) {
+    return 64;
+  }
+  if (l >= YewPar::util::BitSetKernels::Level::AVX2) {
+    return 32;
+  }
+#endif
+  return 16;
+}
+
+// Detected once at startup, so the per node branches on it are a plain load
+inline const unsigned width = detectWidth();
+
+// dst[k] = src[k] - (src[k - gen] != 0) from k to size, as far as whole Vs go. Returns where it
+// stopped. Only reading src keeps the loads clear of the (narrower) stores copying src to dst.
+// Always inlined, so the vectors are compiled for the instruction set of the kernel calling it.
+template <typename V>
+__attribute__((always_inline))
+inline ind_t decrement(uint8_t * dst, const uint8_t * src, const ind_t gen, ind_t k, const ind_t size) {
+  auto step = [&](const ind_t at) {
+    V s, d;
+    std::memcpy(&s, src + at - gen, sizeof(V));
+    std::memcpy(&d, src + at, sizeof(V));
+    d += (V) (s != V{});  // The comparison is -1 where s is non zero
+    std::memcpy(dst + at, &d, sizeof(V));
+  };
+  for (; k + sizeof(V) <= size; k += sizeof(V)) {
+    step(k);
+  }
+  // Redoing some bytes is harmless, so a last V ending at size finishes it if all of it is past gen
+  // (monoids can be narrower than V, the 16 byte kernel does all of those)
+  if (k < size && size >= gen + sizeof(V)) {
+    step(size - sizeof(V));
+    k = size;
+  }
+  return k;
+}
+
+inline ind_t decrement16(uint8_t * dst, const uint8_t * src, const ind_t gen, const ind_t k, const ind_t size) {
+  return decrement<epi8>(dst, src, gen, k, size);
+}
+
+// Bit i set if decs[i] == 1, for the 16 bytes from decs
+inline unsigned ones16(const uint8_t * decs) {
+  epi8 b;
+  std::memcpy(&b, decs, 16);
+  return movemask_epi8(b == block1);
+}
+
+#ifdef YEWPAR_BITSET_X86
+__attribute__((target("avx2")))
+inline ind_t decrement32(uint8_t * dst, const uint8_t * src, const ind_t gen, const ind_t k, const ind_t size) {
+  return decrement<epi8x32>(dst, src, gen, k, size);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+inline ind_t decrement64(uint8_t * dst, const uint8_t * src, const ind_t gen, const ind_t k, const ind_t size) {
+  return decrement<epi8x64>(dst, src, gen, k, size);
+}
+#endif
+
+}
+
+template <unsigned S>
+void init_full_N(Monoid<S> &m)
 {
-  epi8 block;
-  iblock = 0;
-  block = mon.blocks[0];
-  mask  = movemask_epi8(block == block1);
-  mask &= 0xFFFE; // 0 is not a generator
-  gen = - 1;
-};
+  // i = a + b with 0 <= a <= b in i / 2 + 1 ways
+  for (auto i = 0u; i < S; i++) {
+    m.decs[i] = i / 2 + 1;
+  }
+  m.genus = 0;
+  m.conductor = 1;
+  m.min = 1;
+}
+
+template <unsigned S>
+void print_monoid(const Monoid<S> &m)
+{
+  unsigned int i;
+  std::cout<<"min = "<<m.min<<", cond = "<<m.conductor<<", genus = "<<m.genus<<", decs = ";
+  for (i=0; i<S; i++) std::cout<<((int) m.decs[i])<<' ';
+  std::cout<<std::endl;
+}
 
-template<> inline generator_iter<CHILDREN>::generator_iter(const Monoid & mon)
-  : bound((mon.conductor+mon.min+15) >> 4)
+// Generators are below conductor + min, and they are the numbers with one decomposition. Only a
+// few blocks hold candidates, and each was just written by remove_generator, so the scans stay 16
+// bytes at a time: wider loads over those narrower stores stall more than they save.
+template <class T, unsigned S> inline generator_iter<T, S>::generator_iter(const Monoid<S> & mon)
+  : bound(std::min<ind_t>(mon.conductor + mon.min, S))
 {
-  epi8 block;
-  iblock = mon.conductor >> 4;
-  block = mon.blocks[iblock] & mask16[mon.conductor & 0xF];
-  mask  = movemask_epi8(block == block1);
-  gen = (iblock << 4) - 1;
+  if constexpr (std::is_same<T, ALL>::value) {
+    base = 0;
+    mask = monoid_kernels::ones16(mon.decs);
+    mask &= 0xFFFE; // 0 is not a generator
+  } else {
+    base = mon.conductor & ~ind_t(15);
+    mask = base < S ? monoid_kernels::ones16(mon.decs + base) : 0;
+    mask &= 0xFFFF << (mon.conductor & 0xF);
+  }
+  gen = base - 1;
 };
 
-template <class T> inline uint8_t generator_iter<T>::count(const Monoid & mon)
+template <class T, unsigned S> inline uint8_t generator_iter<T, S>::count(const Monoid<S> & mon)
 {
   uint8_t nbr = _mm_popcnt_u32(mask); // popcnt returns a 8 bits value
-  for (ind_t ib = iblock+1; ib < bound; ib++)
-    nbr += _mm_popcnt_u32(movemask_epi8(mon.blocks[ib] == block1));
+  for (ind_t b = base + 16; b < bound; b += 16)
+    nbr += _mm_popcnt_u32(monoid_kernels::ones16(mon.decs + b));
   return nbr;
 };
 
-template <class T> inline bool generator_iter<T>::move_next(const Monoid & mon)
+template <class T, unsigned S> inline bool generator_iter<T, S>::move_next(const Monoid<S> & mon)
 {
   while (!mask)
     {
-      iblock++;
-      if (iblock > bound) return false;
-      gen = (iblock << 4) - 1;
-      mask  = movemask_epi8(mon.blocks[iblock] == block1);
+      base += 16;
+      if (base >= bound) return false;
+      mask = monoid_kernels::ones16(mon.decs + base);
     }
-  unsigned char shift = __bsfd (mask) + 1; // Bit Scan Forward
-  gen += shift;
-  mask >>= shift;
+  gen = base + __bsfd(mask); // Bit Scan Forward
+  mask &= mask - 1;
   return true;
 };
 
 
-
-inline __attribute__((always_inline))
-void copy_blocks(dec_blocks &dst, dec_blocks const &src)
-{
-  dst = src;
-}
-
-
 #include <cassert>
 
+template <unsigned S>
 inline __attribute__((always_inline))
-void remove_generator(Monoid &__restrict__ dst,
-		      const Monoid &__restrict__ src,
+void remove_generator(Monoid<S> &__restrict__ dst,
+		      const Monoid<S> &__restrict__ src,
 		      ind_t gen)
 {
   ind_t start_block, decal;
-  epi8 block;
+  epi8 block, head;
 
   assert(src.decs[gen] == 1);
 
@@ -211,90 +289,36 @@ void remove_generator(Monoid &__restrict__ dst,
   dst.genus = src.genus + 1;
   dst.min = (gen == src.min) ? dst.conductor : src.min;
 
-  copy_blocks(dst.blocks, src.blocks);
+  std::memcpy(dst.decs, src.decs, S);
 
-  start_block = gen >> 4;
+  start_block = gen & ~ind_t(15);
   decal = gen & 0xF;
-  // Shift block by decal uchar
-  block = shuffle_epi8(src.blocks[0], shift16[decal]);
-  dst.blocks[start_block] -= ((block != zero) & block1);
-#if NBLOCKS >= 5
-
-#define CASE_UNROLL(i_loop)			\
-  case i_loop : \
-    dst.blocks[i_loop+1] -= (load_unaligned_epi8(srcblock) != zero) & block1; \
-    srcblock += sizeof(epi8);
-
-  {
-    const uint8_t *srcblock = src.decs + sizeof(epi8) - decal;
-  switch(start_block)
-    {
-      CASE_UNROLL(0);
-#if NBLOCKS > 2
-      CASE_UNROLL(1);
-#endif
-#if NBLOCKS > 3
-      CASE_UNROLL(2);
-#endif
-#if NBLOCKS > 4
-      CASE_UNROLL(3);
-#endif
-#if NBLOCKS > 5
-      CASE_UNROLL(4);
-#endif
-#if NBLOCKS > 6
-      CASE_UNROLL(5);
-#endif
-#if NBLOCKS > 7
-      CASE_UNROLL(6);
-#endif
-#if NBLOCKS > 8
-      CASE_UNROLL(7);
-#endif
-#if NBLOCKS > 9
-      CASE_UNROLL(8);
-#endif
-#if NBLOCKS > 10
-      CASE_UNROLL(9);
-#endif
-#if NBLOCKS > 11
-      CASE_UNROLL(10);
-#endif
-#if NBLOCKS > 12
-      CASE_UNROLL(11);
-#endif
-#if NBLOCKS > 13
-      CASE_UNROLL(12);
-#endif
-#if NBLOCKS > 14
-      CASE_UNROLL(13);
-#endif
-#if NBLOCKS > 15
-      CASE_UNROLL(14);
-#endif
-#if NBLOCKS > 16
-#error "Too many blocks"
-#endif
-    }
+  // The 16 bytes holding gen, from the first block shifted by decal uchar
+  std::memcpy(&block, src.decs, 16);
+  std::memcpy(&head, src.decs + start_block, 16);
+  block = shuffle_epi8(block, shift16[decal]);
+  head -= ((block != zero) & block1);
+  std::memcpy(dst.decs + start_block, &head, 16);
+
+  // The rest as wide as the CPU goes, then the 16 byte blocks left over
+  ind_t k = start_block + 16;
+#ifdef YEWPAR_BITSET_X86
+  auto w = monoid_kernels::width;
+  if (w == 64) {
+    k = monoid_kernels::decrement64(dst.decs, src.decs, gen, k, S);
+  } else if (w == 32) {
+    k = monoid_kernels::decrement32(dst.decs, src.decs, gen, k, S);
   }
-#else
-#warning "Loop not unrolled"
-
-  for (auto i=start_block+1; i<NBLOCKS; i++)
-    {
-      // The following won't work due to some alignment problem (bug in GCC 4.7.1?)
-      // block = *((epi8*)(src.decs + ((i-start_block)<<4) - decal));
-      block = load_unaligned_epi8(src.decs + ((i-start_block)<<4) - decal);
-      dst.blocks[i] -= ((block != zero) & block1);
-    }
 #endif
+  monoid_kernels::decrement16(dst.decs, src.decs, gen, k, S);
 
   assert(dst.decs[dst.conductor-1] == 0);
 }
 
-inline Monoid remove_generator(const Monoid &src, ind_t gen)
+template <unsigned S>
+inline Monoid<S> remove_generator(const Monoid<S> &src, ind_t gen)
 {
-  Monoid dst;
+  Monoid<S> dst;
   remove_generator(dst, src, gen);
   return dst;
 }
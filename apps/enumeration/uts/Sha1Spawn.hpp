@@ -0,0 +1,177 @@
+#ifndef UTS_SHA1_SPAWN_HPP
+#define UTS_SHA1_SPAWN_HPP
+
+#include <cstdint>
+#include <cstring>
+
+#include "util/BitSet.hpp"
+
+// rng_spawn for many children at once, bit for bit the same as uts-rng's brg_sha1.
+//
+// A child's state is the SHA-1 of its parent's 20 byte state followed by its (big endian, 4 byte)
+// spawn number. That is a single block whose words only differ between siblings in word 5, so:
+//   - the first five rounds only see the parent's words, they are done once per parent (prepare)
+//   - the rest run for a batch of consecutive siblings at once, one per SIMD lane (hash)
+// Lane counts follow the kernel level util/BitSet.hpp picks (so YEWPAR_BITSET_KERNELS applies):
+// 16 with AVX512, 8 with AVX2, otherwise 4 (SSE2, or plain code where there's no x86).
+namespace sha1_spawn {
+
+constexpr unsigned maxLanes = 16;
+
+struct Midstate {
+  // The parent's state, as big endian message words
+  std::uint32_t w[5];
+
+  // a to e after the first five rounds
+  std::uint32_t v[5];
+};
+
+constexpr std::uint32_t initial[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+
+inline std::uint32_t rotl(const std::uint32_t x, const int n) {
+  return (x << n) | (x >> (32 - n));
+}
+
+inline Midstate prepare(const std::uint8_t * parentState) {
+  Midstate m;
+  for (auto i = 0; i < 5; ++i) {
+    m.w[i] = (std::uint32_t(parentState[4 * i]) << 24) | (std::uint32_t(parentState[4 * i + 1]) << 16) |
+             (std::uint32_t(parentState[4 * i + 2]) << 8) | std::uint32_t(parentState[4 * i + 3]);
+  }
+
+  auto a = initial[0], b = initial[1], c = initial[2], d = initial[3], e = initial[4];
+  for (auto t = 0; t < 5; ++t) {
+    auto tmp = rotl(a, 5) + (d ^ (b & (c ^ d))) + e + 0x5a827999 + m.w[t];
+    e = d; d = c; c = rotl(b, 30); b = a; a = tmp;
+  }
+  m.v[0] = a; m.v[1] = b; m.v[2] = c; m.v[3] = d; m.v[4] = e;
+  return m;
+}
+
+namespace detail {
+
+// Rounds 5 to 79 of the children first to first + lanes - 1, with V a GCC vector of lanes words.
+// Always inlined so the vector code is compiled for the instruction set of the kernel calling it.
+template <typename V, unsigned lanes>
+__attribute__((always_inline))
+inline void hashLanes(const Midstate & m, const std::uint32_t first, std::uint8_t (*out)[20]) {
+  V w[16];
+  for (auto i = 0; i < 5; ++i) {
+    w[i] = V{} + m.w[i];
+  }
+  for (auto l = 0u; l < lanes; ++l) {
+    w[5][l] = first + l;
+  }
+  // Padding: a single 1 bit after the 24 message bytes, and the length in bits at the end
+  w[6] = V{} + 0x80000000u;
+  for (auto i = 7; i < 15; ++i) {
+    w[i] = V{};
+  }
+  w[15] = V{} + 192u;
+
+  V a = V{} + m.v[0], b = V{} + m.v[1], c = V{} + m.v[2], d = V{} + m.v[3], e = V{} + m.v[4];
+  for (auto t = 5; t < 80; ++t) {
+    V wt;
+    if (t < 16) {
+      wt = w[t];
+    } else {
+      auto x = w[(t + 13) & 15] ^ w[(t + 8) & 15] ^ w[(t + 2) & 15] ^ w[t & 15];
+      wt = w[t & 15] = (x << 1) | (x >> 31);
+    }
+
+    V f;
+    std::uint32_t k;
+    if (t < 20) {
+      f = d ^ (b & (c ^ d)); k = 0x5a827999;
+    } else if (t < 40) {
+      f = b ^ c ^ d; k = 0x6ed9eba1;
+    } else if (t < 60) {
+      f = (b & c) | (d & (b ^ c)); k = 0x8f1bbcdc;
+    } else {
+      f = b ^ c ^ d; k = 0xca62c1d6;
+    }
+
+    // Rotates written out, a helper returning V would be compiled without the kernel's target
+    auto tmp = ((a << 5) | (a >> 27)) + f + e + k + wt;
+    e = d; d = c; c = (b << 30) | (b >> 2); b = a; a = tmp;
+  }
+
+  V h[5] = {a + initial[0], b + initial[1], c + initial[2], d + initial[3], e + initial[4]};
+  for (auto l = 0u; l < lanes; ++l) {
+    for (auto i = 0; i < 5; ++i) {
+      std::uint32_t x = h[i][l];
+      out[l][4 * i] = x >> 24;
+      out[l][4 * i + 1] = x >> 16;
+      out[l][4 * i + 2] = x >> 8;
+      out[l][4 * i + 3] = x;
+    }
+  }
+}
+
+typedef std::uint32_t V4 __attribute__((vector_size(16)));
+typedef std::uint32_t V8 __attribute__((vector_size(32)));
+typedef std::uint32_t V16 __attribute__((vector_size(64)));
+
+inline void hash4(const Midstate & m, const std::uint32_t first, std::uint8_t (*out)[20]) {
+  hashLanes<V4, 4>(m, first, out);
+}
+
+#ifdef YEWPAR_BITSET_X86
+__attribute__((target("avx2")))
+inline void hash8(const Midstate & m, const std::uint32_t first, std::uint8_t (*out)[20]) {
+  hashLanes<V8, 8>(m, first, out);
+}
+
+__attribute__((target("avx512f")))
+inline void hash16(const Midstate & m, const std::uint32_t first, std::uint8_t (*out)[20]) {
+  hashLanes<V16, 16>(m, first, out);
+}
+#endif
+
+}
+
+// Write the states of children first, first + 1, ... into out (which has room for maxLanes),
+// returning how many were written
+inline unsigned hash(const Midstate & m, const std::uint32_t first, std::uint8_t (*out)[20]) {
+#ifdef YEWPAR_BITSET_X86
+  auto l = YewPar::util::BitSetKernels::level();
+  if (l >= YewPar::util::BitSetKernels::Level::AVX512) {
+    detail::hash16(m, first, out);
+    return 16;
+  }
+  if (l == YewPar::util::BitSetKernels::Level::AVX2) {
+    detail::hash8(m, first, out);
+    return 8;
+  }
+#endif
+  detail::hash4(m, first, out);
+  return 4;
+}
+
+// The children of one parent, hashed a batch at a time as the generator asks for them
+class Batch {
+ private:
+  Midstate mid;
+  bool prepared = false;
+  std::uint32_t first = 0;
+  unsigned count = 0;
+  std::uint8_t states[maxLanes][20];
+
+ public:
+  // rng_spawn(parentState, out, i), parentState must be the same on every call
+  void spawn(const std::uint8_t * parentState, const std::uint32_t i, std::uint8_t * out) {
+    if (!prepared) {
+      mid = prepare(parentState);
+      prepared = true;
+    }
+    if (i < first || i >= first + count) {
+      first = i;
+      count = hash(mid, first, states);
+    }
+    std::memcpy(out, states[i - first], 20);
+  }
+};
+
+}
+
+#endif
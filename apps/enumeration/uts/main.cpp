@@ -1,9 +1,12 @@
+#include <algorithm>
+
 #include <hpx/hpx_init.hpp>
 #include <hpx/include/iostreams.hpp>
 
 // We just use the default RNG for simplicity
 #define BRG_RNG
 #include "uts-rng/rng.h"
+#include "Sha1Spawn.hpp"
 
 #include "YewPar.hpp"
 #include "skeletons/Seq.hpp"
@@ -63,11 +66,14 @@ template <TreeType t>
 struct NodeGen {};
 
 template <>
-struct NodeGen<TreeType::BINOMIAL> : YewPar::NodeGenerator<UTSNode, UTSState> {
+struct NodeGen<TreeType::BINOMIAL> : YewPar::StaticNodeGenerator<NodeGen<TreeType::BINOMIAL>, UTSNode, UTSState> {
   UTSNode parent;
   UTSState params;
   int i = 0;
 
+  // Children states, a SIMD batch at a time, the same as rng_spawn's
+  sha1_spawn::Batch batch;
+
   // Interpret 32 bit positive integer as value on [0,1)
   // From UTS Codebase
   double rng_toProb(int n) {
@@ -92,21 +98,28 @@ struct NodeGen<TreeType::BINOMIAL> : YewPar::NodeGenerator<UTSNode, UTSState> {
     this->numChildren = calcNumChildren();
   }
 
-  UTSNode next() override {
+  UTSNode next() {
     UTSNode child { false, parent.depth + 1 };
-    rng_spawn(parent.rngstate.state, child.rngstate.state, i);
+    batch.spawn(parent.rngstate.state, i, child.rngstate.state);
     ++i;
 
     return child;
   }
+
+  void skip(unsigned k) {
+    i += k;
+  }
 };
 
 template <>
-struct NodeGen<TreeType::GEOMETRIC> : YewPar::NodeGenerator<UTSNode, UTSState> {
+struct NodeGen<TreeType::GEOMETRIC> : YewPar::StaticNodeGenerator<NodeGen<TreeType::GEOMETRIC>, UTSNode, UTSState> {
   UTSNode parent;
   UTSState params;
   int i = 0;
 
+  // Children states, a SIMD batch at a time, the same as rng_spawn's
+  sha1_spawn::Batch batch;
+
   NodeGen() { this->numChildren = 0; }
   NodeGen(const UTSState & params, const UTSNode & parent) : params(params), parent(parent) {
     this->numChildren = calcNumChildren();
@@ -151,13 +164,24 @@ struct NodeGen<TreeType::GEOMETRIC> : YewPar::NodeGenerator<UTSNode, UTSState> {
     return (int) floor(log(1 - u) / log(1 - p));
   }
 
-  UTSNode next() override {
+  UTSNode next() {
     UTSNode child { false, parent.depth + 1 };
-    rng_spawn(parent.rngstate.state, child.rngstate.state, i);
+    batch.spawn(parent.rngstate.state, i, child.rngstate.state);
     ++i;
 
     return child;
   }
+
+  void skip(unsigned k) {
+    i += k;
+  }
+
+  // Depths where calcNumChildren has a zero branching factor
+  bool childrenAreLeaves() const {
+    auto depth = parent.depth + 1;
+    return (params.geoType == GeometricType::FIXED && depth >= params.gen_mx) ||
+        (params.geoType == GeometricType::CYCLIC && depth > 5 * params.gen_mx);
+  }
 };
 
 
@@ -169,6 +193,11 @@ struct CountNodes : YewPar::Enumerator<UTSNode, std::uint64_t> {
     count++;
   }
 
+  template <typename Gen>
+  void accumulateChildren(const Gen & gen) {
+    count += gen.numChildren;
+  }
+
   void combine(const std::uint64_t & other) override {
     count += other;
   }
@@ -182,6 +211,34 @@ struct CountNodes : YewPar::Enumerator<UTSNode, std::uint64_t> {
 
 std::vector<std::string> treeTypes = {"binomial", "geometric"};
 
+// The standard trees from UTS's sample_trees.sh, with their published sizes and depths. Geometric
+// shapes are in this app's numbering, so UTS's "-a 3" (fixed) is FIXED and "-a 2" (cyclic) CYCLIC.
+struct UTSPreset {
+  std::string name;
+  std::string treeType;
+  UTSState params;
+  int seed;
+  std::uint64_t nodes;
+  unsigned depth;
+};
+
+std::vector<UTSPreset> presets = {
+  {"T1",    "geometric", {4,    0, 0,            10, GeometricType::FIXED},  19,  4130071ULL,      10},
+  {"T5",    "geometric", {4,    0, 0,            20, GeometricType::LINEAR}, 34,  4147582ULL,      20},
+  {"T2",    "geometric", {6,    0, 0,            16, GeometricType::CYCLIC}, 502, 4117769ULL,      81},
+  {"T3",    "binomial",  {2000, 8, 0.124875},                                42,  4112897ULL,      1572},
+  {"T1L",   "geometric", {4,    0, 0,            13, GeometricType::FIXED},  29,  102181082ULL,    13},
+  {"T2L",   "geometric", {7,    0, 0,            23, GeometricType::CYCLIC}, 220, 96793510ULL,     67},
+  {"T3L",   "binomial",  {2000, 5, 0.200014},                                7,   111345631ULL,    17844},
+  {"T1XL",  "geometric", {4,    0, 0,            15, GeometricType::FIXED},  29,  1635119272ULL,   15},
+  {"T1XXL", "geometric", {4,    0, 0,            15, GeometricType::FIXED},  19,  4230646601ULL,   15},
+  {"T3XXL", "binomial",  {2000, 2, 0.499995},                                316, 2793220501ULL,   99049},
+  {"T2XXL", "binomial",  {2000, 2, 0.499999995},                             0,   10612052303ULL,  216370},
+  {"T1WL",  "geometric", {4,    0, 0,            18, GeometricType::FIXED},  19,  270751679750ULL, 18},
+  {"T2WL",  "binomial",  {2000, 2, 0.4999999995},                            559, 295393891003ULL, 2493110},
+  {"T3WL",  "binomial",  {2000, 5, 0.200014},                                34,  157063495159ULL, 758577},
+};
+
 int hpx_main(boost::program_options::variables_map & opts) {
   auto spawnDepth = opts["spawn-depth"].as<unsigned>();
   auto maxDepth   = opts["until-depth"].as<unsigned>();
@@ -193,8 +250,34 @@ int hpx_main(boost::program_options::variables_map & opts) {
   UTSState params { opts["uts-b"].as<double>(), opts["uts-m"].as<double>(), opts["uts-q"].as<double>(),
         opts["uts-d"].as<int>(), static_cast<GeometricType>(opts["uts-a"].as<int>()) };
 
+  auto seed = opts["uts-r"].as<int>();
+
+  auto preset = presets.end();
+  if (opts.count("uts-preset")) {
+    auto name = opts["uts-preset"].as<std::string>();
+    preset = std::find_if(presets.begin(), presets.end(), [&](const UTSPreset & p) { return p.name == name; });
+    if (preset == presets.end()) {
+      hpx::cout << "Unknown UTS preset " << name << ", expected one of:";
+      for (const auto & p : presets) {
+        hpx::cout << " " << p.name;
+      }
+      hpx::cout << hpx::endl;
+      return hpx::finalize();
+    }
+
+    treeType = preset->treeType;
+    params = preset->params;
+    seed = preset->seed;
+
+    if (preset->depth > UTS_MAX_TREE_DEPTH && (skeleton == "stacksteal" || skeleton == "budget")) {
+      hpx::cout << "Preset " << name << " is " << preset->depth << " deep, more than UTS_MAX_TREE_DEPTH ("
+                << UTS_MAX_TREE_DEPTH << ")" << hpx::endl;
+      return hpx::finalize();
+    }
+  }
+
   UTSNode root { true, 0 };
-  rng_init(root.rngstate.state, opts["uts-r"].as<int>());
+  rng_init(root.rngstate.state, seed);
 
   std::uint64_t count;
   if (treeType == "binomial") {
@@ -207,6 +290,12 @@ int hpx_main(boost::program_options::variables_map & opts) {
     } else if (skeleton == "depthbounded") {
       YewPar::Skeletons::API::Params<> searchParameters;
       searchParameters.spawnDepth = spawnDepth;
+      searchParameters.traceFile = opts["trace-file"].as<std::string>();
+      searchParameters.adaptiveSpawnDepth = static_cast<bool>(opts.count("adaptive-spawn-depth"));
+      searchParameters.checkpointFile = opts["checkpoint-file"].as<std::string>();
+      searchParameters.checkpointIntervalMillis = opts["checkpoint-interval"].as<unsigned>();
+      searchParameters.resumeFromCheckpoint = static_cast<bool>(opts.count("resume"));
+      searchParameters.autoTune = static_cast<bool>(opts.count("auto-tune"));
       count = YewPar::Skeletons::DepthBounded<NodeGen<TreeType::BINOMIAL>,
                                       YewPar::Skeletons::API::Enumeration,
                                       YewPar::Skeletons::API::Enumerator<CountNodes>,
@@ -215,6 +304,11 @@ int hpx_main(boost::program_options::variables_map & opts) {
     } else if (skeleton == "stacksteal") {
       YewPar::Skeletons::API::Params<> searchParameters;
       searchParameters.stealAll = static_cast<bool>(opts.count("chunked"));
+      searchParameters.traceFile = opts["trace-file"].as<std::string>();
+      searchParameters.stealAdaptive = static_cast<bool>(opts.count("adaptive-chunking"));
+      searchParameters.maxDistributedSteals = opts["distributed-steals"].as<unsigned>();
+      searchParameters.stealPrefetchThreshold = opts["steal-prefetch"].as<unsigned>();
+      searchParameters.claimSteals = static_cast<bool>(opts.count("claim-steals"));
       count = YewPar::Skeletons::StackStealing<NodeGen<TreeType::BINOMIAL>,
                                                 YewPar::Skeletons::API::Enumeration,
                                                 YewPar::Skeletons::API::Enumerator<CountNodes>,
@@ -225,6 +319,8 @@ int hpx_main(boost::program_options::variables_map & opts) {
     } else if (skeleton == "budget") {
       YewPar::Skeletons::API::Params<> searchParameters;
       searchParameters.backtrackBudget = opts["backtrack-budget"].as<unsigned>();
+      searchParameters.traceFile = opts["trace-file"].as<std::string>();
+      searchParameters.autoTune = static_cast<bool>(opts.count("auto-tune"));
       count = YewPar::Skeletons::Budget<NodeGen<TreeType::BINOMIAL>,
                                         YewPar::Skeletons::API::Enumeration,
                                         YewPar::Skeletons::API::Enumerator<CountNodes>,
@@ -244,6 +340,12 @@ int hpx_main(boost::program_options::variables_map & opts) {
     } else if (skeleton == "depthbounded") {
       YewPar::Skeletons::API::Params<> searchParameters;
       searchParameters.spawnDepth = spawnDepth;
+      searchParameters.traceFile = opts["trace-file"].as<std::string>();
+      searchParameters.adaptiveSpawnDepth = static_cast<bool>(opts.count("adaptive-spawn-depth"));
+      searchParameters.checkpointFile = opts["checkpoint-file"].as<std::string>();
+      searchParameters.checkpointIntervalMillis = opts["checkpoint-interval"].as<unsigned>();
+      searchParameters.resumeFromCheckpoint = static_cast<bool>(opts.count("resume"));
+      searchParameters.autoTune = static_cast<bool>(opts.count("auto-tune"));
       count = YewPar::Skeletons::DepthBounded<NodeGen<TreeType::GEOMETRIC>,
                                             YewPar::Skeletons::API::Enumeration,
                                             YewPar::Skeletons::API::Enumerator<CountNodes>,
@@ -252,6 +354,11 @@ int hpx_main(boost::program_options::variables_map & opts) {
     } else if (skeleton == "stacksteal") {
       YewPar::Skeletons::API::Params<> searchParameters;
       searchParameters.stealAll = static_cast<bool>(opts.count("chunked"));
+      searchParameters.traceFile = opts["trace-file"].as<std::string>();
+      searchParameters.stealAdaptive = static_cast<bool>(opts.count("adaptive-chunking"));
+      searchParameters.maxDistributedSteals = opts["distributed-steals"].as<unsigned>();
+      searchParameters.stealPrefetchThreshold = opts["steal-prefetch"].as<unsigned>();
+      searchParameters.claimSteals = static_cast<bool>(opts.count("claim-steals"));
       count = YewPar::Skeletons::StackStealing<NodeGen<TreeType::GEOMETRIC>,
                                                 YewPar::Skeletons::API::Enumeration,
                                                 YewPar::Skeletons::API::Enumerator<CountNodes>,
@@ -262,6 +369,8 @@ int hpx_main(boost::program_options::variables_map & opts) {
     } else if (skeleton == "budget") {
       YewPar::Skeletons::API::Params<> searchParameters;
       searchParameters.backtrackBudget = opts["backtrack-budget"].as<unsigned>();
+      searchParameters.traceFile = opts["trace-file"].as<std::string>();
+      searchParameters.autoTune = static_cast<bool>(opts.count("auto-tune"));
       count = YewPar::Skeletons::Budget<NodeGen<TreeType::GEOMETRIC>,
                                          YewPar::Skeletons::API::Enumeration,
                                          YewPar::Skeletons::API::Enumerator<CountNodes>,
@@ -278,6 +387,10 @@ int hpx_main(boost::program_options::variables_map & opts) {
                       (std::chrono::steady_clock::now() - start_time);
 
   hpx::cout << "Total Nodes: " << count << hpx::endl;
+  if (preset != presets.end() && maxDepth == 0) {
+    hpx::cout << "Expected Nodes: " << preset->nodes << (count == preset->nodes ? " (match)" : " (MISMATCH)")
+              << hpx::endl;
+  }
 
   hpx::cout << "=====" << hpx::endl;
   hpx::cout << "cpu = " << overall_time.count() << hpx::endl;
@@ -307,8 +420,36 @@ int main(int argc, char* argv[]) {
         "Number of backtracks before spawning work"
         )
       ("chunked", "Use chunking with stack stealing")
+      ("claim-steals", "Let thieves claim nodes from running stacks without waiting for them (stacksteal)")
+      ("adaptive-spawn-depth", "Spawn below the spawn depth when idle and stop above it when saturated")
+      ( "checkpoint-file",
+        boost::program_options::value<std::string>()->default_value("uts.checkpoint"),
+        "Where to write checkpoints/resume from (depthbounded)"
+        )
+      ( "checkpoint-interval",
+        boost::program_options::value<unsigned>()->default_value(0),
+        "Checkpoint the search every n ms, 0 to disable (depthbounded)"
+        )
+      ("resume", "Resume from the checkpoint file rather than starting at the root (depthbounded)")
+      ("auto-tune", "Pick the spawn depth/budget from a sampled estimate of the tree (depthbounded, budget)")
+      ( "trace-file",
+        boost::program_options::value<std::string>()->default_value(""),
+        "Record every task to <file>.json (Chrome trace) and <file>.csv (depthbounded, stacksteal, budget)"
+        )
+      ("adaptive-chunking", "Size stack steals by thief distance and remaining work")
+      ( "distributed-steals",
+        boost::program_options::value<unsigned>()->default_value(1),
+        "Maximum number of outstanding distributed steals per locality (stack stealing)"
+        )
+      ( "steal-prefetch",
+        boost::program_options::value<unsigned>()->default_value(0),
+        "Steal remotely once the stolen task buffer holds this many tasks or fewer, 0 to disable (stack stealing)"
+        )
       // UTS Options
       //LINEAR, CYCLIC, FIXED, EXPDEC
+      ( "uts-preset", boost::program_options::value<std::string>(),
+        "A standard UTS tree (T1, T2, T3, T5, T1L, T2L, T3L, T1XL, T1XXL, T3XXL, T2XXL, T1WL, T2WL, T3WL) in place of "
+        "the other uts options, the node count is checked against its published size" )
       ( "uts-t", boost::program_options::value<std::string>()->default_value("binomial"), "Which tree type to use" )
       ( "uts-b", boost::program_options::value<double>()->default_value(4.0), "Root branching factor" )
       ( "uts-q", boost::program_options::value<double>()->default_value(15.0 / 64.0), "BIN: Probability of non-leaf node" )
@@ -320,5 +461,5 @@ int main(int argc, char* argv[]) {
 
   YewPar::registerPerformanceCounters();
 
-  return hpx::init(desc_commandline, argc, argv);
+  return YewPar::init(desc_commandline, argc, argv);
 }
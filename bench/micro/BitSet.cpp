@@ -0,0 +1,109 @@
+#include "util/BitSet.hpp"
+
+#include "MicroBench.hpp"
+
+// The maxclique/mcs/sip bitset operations at each kernel level this CPU has
+namespace {
+
+using namespace YewPar::util;
+
+// brock400 sized graphs
+constexpr unsigned words = 7;
+
+BitSet<words> sparse(const int every) {
+  BitSet<words> b;
+  b.resize(words * bits_per_word);
+  for (int i = 0; i < static_cast<int>(words) * bits_per_word; i += every) {
+    b.set(i);
+  }
+  return b;
+}
+
+// Whether this CPU has level l, so benchmarks it doesn't have are reported as skipped
+template <BitSetKernels::Level l>
+bool hasLevel() {
+  return !(BitSetKernels::supported() < l);
+}
+
+// Runs f at level l, which must be supported
+template <typename F>
+MicroBench::clock::duration atLevel(const BitSetKernels::Level l, F && f) {
+  auto old = BitSetKernels::level();
+  BitSetKernels::setLevel(l);
+  auto t = MicroBench::time(f);
+  BitSetKernels::setLevel(old);
+  return t;
+}
+
+template <BitSetKernels::Level l>
+MicroBench::clock::duration intersect(std::uint64_t iterations) {
+  auto a = sparse(3);
+  auto b = sparse(5);
+  return atLevel(l, [&]() {
+      for (std::uint64_t i = 0; i < iterations; ++i) {
+        auto c = a;
+        c.intersect_with(b);
+        c.intersect_with_complement(a);
+        MicroBench::doNotOptimise(c);
+      }
+    });
+}
+
+template <BitSetKernels::Level l>
+MicroBench::clock::duration popcount(std::uint64_t iterations) {
+  auto a = sparse(3);
+  return atLevel(l, [&]() {
+      for (std::uint64_t i = 0; i < iterations; ++i) {
+        MicroBench::doNotOptimise(a);
+        MicroBench::doNotOptimise(a.popcount());
+      }
+    });
+}
+
+// SIP's adjacency propagation: intersect with the supplemental graph rows and count, in one pass
+template <BitSetKernels::Level l>
+MicroBench::clock::duration intersectAllPopcount(std::uint64_t iterations) {
+  auto a = sparse(2);
+  BitSet<words> rows[3] = { sparse(3), sparse(5), sparse(7) };
+  const BitWord * rowWords[3] = { rows[0].data(), rows[1].data(), rows[2].data() };
+  return atLevel(l, [&]() {
+      for (std::uint64_t i = 0; i < iterations; ++i) {
+        auto c = a;
+        MicroBench::doNotOptimise(BitSetKernels::intersectAllPopcount(c.data(), rowWords, 3, words));
+        MicroBench::doNotOptimise(c);
+      }
+    });
+}
+
+// Only the last word set, the worst case for the colouring loop
+template <BitSetKernels::Level l>
+MicroBench::clock::duration firstSetBit(std::uint64_t iterations) {
+  BitSet<words> a;
+  a.set(words * bits_per_word - 1);
+  return atLevel(l, [&]() {
+      for (std::uint64_t i = 0; i < iterations; ++i) {
+        MicroBench::doNotOptimise(a);
+        MicroBench::doNotOptimise(a.first_set_bit());
+      }
+    });
+}
+
+using L = BitSetKernels::Level;
+
+MICROBENCH("BitSet/intersect/scalar", intersect<L::Scalar>);
+MICROBENCH("BitSet/intersect/avx2", intersect<L::AVX2>, 1, hasLevel<L::AVX2>);
+MICROBENCH("BitSet/intersect/avx512", intersect<L::AVX512>, 1, hasLevel<L::AVX512>);
+
+MICROBENCH("BitSet/popcount/scalar", popcount<L::Scalar>);
+MICROBENCH("BitSet/popcount/avx2", popcount<L::AVX2>, 1, hasLevel<L::AVX2>);
+MICROBENCH("BitSet/popcount/avx512popcnt", popcount<L::AVX512Popcnt>, 1, hasLevel<L::AVX512Popcnt>);
+
+MICROBENCH("BitSet/intersectAllPopcount/scalar", intersectAllPopcount<L::Scalar>);
+MICROBENCH("BitSet/intersectAllPopcount/avx2", intersectAllPopcount<L::AVX2>, 1, hasLevel<L::AVX2>);
+MICROBENCH("BitSet/intersectAllPopcount/avx512popcnt", intersectAllPopcount<L::AVX512Popcnt>, 1, hasLevel<L::AVX512Popcnt>);
+
+MICROBENCH("BitSet/firstSetBit/scalar", firstSetBit<L::Scalar>);
+MICROBENCH("BitSet/firstSetBit/avx2", firstSetBit<L::AVX2>, 1, hasLevel<L::AVX2>);
+MICROBENCH("BitSet/firstSetBit/avx512", firstSetBit<L::AVX512>, 1, hasLevel<L::AVX512>);
+
+}
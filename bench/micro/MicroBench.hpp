@@ -0,0 +1,85 @@
+#ifndef YEWPAR_MICROBENCH_HPP
+#define YEWPAR_MICROBENCH_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <hpx/lcos/async.hpp>
+#include <hpx/lcos/future.hpp>
+#include <hpx/lcos/wait_all.hpp>
+
+// A small benchmark harness in the style of Google Benchmark, run inside the HPX runtime so the
+// primitives see the same environment as in a search.
+//
+// A benchmark is a function running iterations operations and returning how long they took (it
+// may leave setup out of the time). The driver (main.cpp) doubles the iterations until a run takes
+// at least --min-time and reports the time per operation.
+namespace MicroBench {
+
+using clock = std::chrono::steady_clock;
+using Fn = std::function<clock::duration(std::uint64_t iterations)>;
+using Available = std::function<bool()>;
+
+struct Benchmark {
+  std::string name;
+  Fn fn;
+  // Skipped when there are fewer HPX worker threads than this
+  unsigned threads;
+  // Skipped when this returns false (e.g. the CPU lacks an instruction set); always run if empty
+  Available available;
+};
+
+inline std::vector<Benchmark> & benchmarks() {
+  static std::vector<Benchmark> bs;
+  return bs;
+}
+
+struct Register {
+  Register(std::string name, Fn fn, unsigned threads = 1, Available available = Available()) {
+    benchmarks().push_back(Benchmark {std::move(name), std::move(fn), threads, std::move(available)});
+  }
+};
+
+// Keep the compiler from optimising away a value that is otherwise unused
+template <typename T>
+inline void doNotOptimise(const T & x) {
+  asm volatile("" : : "g"(&x) : "memory");
+}
+
+template <typename F>
+clock::duration time(F && f) {
+  auto start = clock::now();
+  f();
+  return clock::now() - start;
+}
+
+// f(i) for i in [0, iterations), split over n HPX threads running at once
+template <typename F>
+clock::duration onThreads(const unsigned n, const std::uint64_t iterations, F f) {
+  return time([&]() {
+      std::vector<hpx::future<void> > futs;
+      for (unsigned t = 0; t < n; ++t) {
+        futs.push_back(hpx::async([&f, t, n, iterations]() {
+              for (auto i = static_cast<std::uint64_t>(t); i < iterations; i += n) {
+                f(i);
+              }
+            }));
+      }
+      hpx::wait_all(futs);
+    });
+}
+
+}
+
+#define MICROBENCH_CAT_(a, b) a##b
+#define MICROBENCH_CAT(a, b) MICROBENCH_CAT_(a, b)
+
+// MICROBENCH("Name", fn), MICROBENCH("Name", fn, threads) or MICROBENCH("Name", fn, threads, available)
+#define MICROBENCH(...) \
+  static MicroBench::Register MICROBENCH_CAT(microbench_, __LINE__)(__VA_ARGS__)
+
+#endif
@@ -0,0 +1,95 @@
+#include <memory>
+
+#include <hpx/runtime/components/new.hpp>
+#include <hpx/runtime/find_here.hpp>
+#include <hpx/runtime/get_ptr.hpp>
+
+#include "workstealing/DepthPool.hpp"
+#include "workstealing/Workqueue.hpp"
+
+#include "MicroBench.hpp"
+
+// The task queues, called directly as the co-located policies do
+namespace {
+
+using Task = hpx::util::function<void(hpx::naming::id_type)>;
+
+// Deep enough to spread over a few of the DepthPool's levels
+constexpr unsigned depths = 16;
+
+Task emptyTask() {
+  return Task([](hpx::naming::id_type) {});
+}
+
+template <typename Component>
+std::shared_ptr<Component> newLocal(hpx::naming::id_type & id) {
+  id = hpx::new_<Component>(hpx::find_here()).get();
+  return hpx::get_ptr<Component>(hpx::launch::sync, id);
+}
+
+MICROBENCH("DepthPool/addWork+getLocal", [](std::uint64_t iterations) {
+    hpx::naming::id_type id;
+    auto pool = newLocal<workstealing::DepthPool>(id);
+    auto task = emptyTask();
+    return MicroBench::time([&]() {
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+          pool->addWork(task, i % depths);
+          MicroBench::doNotOptimise(pool->getLocal());
+        }
+      });
+  });
+
+MICROBENCH("DepthPool/steal", [](std::uint64_t iterations) {
+    hpx::naming::id_type id;
+    auto pool = newLocal<workstealing::DepthPool>(id);
+    auto task = emptyTask();
+    for (std::uint64_t i = 0; i < iterations; ++i) {
+      pool->addWork(task, i % depths);
+    }
+    return MicroBench::time([&]() {
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+          MicroBench::doNotOptimise(pool->steal());
+        }
+      });
+  });
+
+// Per task stolen, with the chunk serialized for the (remote) thief as stealChunk_action would
+MICROBENCH("DepthPool/stealChunk/32", [](std::uint64_t iterations) {
+    hpx::naming::id_type id;
+    auto pool = newLocal<workstealing::DepthPool>(id);
+    auto task = emptyTask();
+    for (std::uint64_t i = 0; i < iterations; ++i) {
+      pool->addWork(task, 0);
+    }
+    return MicroBench::time([&]() {
+        while (!pool->stealChunk(32).empty()) {}
+      });
+  });
+
+MICROBENCH("Workqueue/addWork+getLocal", [](std::uint64_t iterations) {
+    hpx::naming::id_type id;
+    auto queue = newLocal<workstealing::Workqueue>(id);
+    auto task = emptyTask();
+    return MicroBench::time([&]() {
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+          queue->addWork(task);
+          MicroBench::doNotOptimise(queue->getLocal());
+        }
+      });
+  });
+
+MICROBENCH("Workqueue/steal", [](std::uint64_t iterations) {
+    hpx::naming::id_type id;
+    auto queue = newLocal<workstealing::Workqueue>(id);
+    auto task = emptyTask();
+    for (std::uint64_t i = 0; i < iterations; ++i) {
+      queue->addWork(task);
+    }
+    return MicroBench::time([&]() {
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+          MicroBench::doNotOptimise(queue->steal());
+        }
+      });
+  });
+
+}
@@ -0,0 +1,116 @@
+#include <functional>
+#include <limits>
+
+#include "skeletons/API.hpp"
+#include "skeletons/Common.hpp"
+#include "skeletons/DepthFirst.hpp"
+#include "util/NodeGenerator.hpp"
+#include "util/Registry.hpp"
+#include "util/func.hpp"
+
+#include "MicroBench.hpp"
+
+// Per node costs of the skeletons, on a trivial node type so only YewPar's own work is measured
+namespace {
+
+using namespace YewPar;
+using namespace YewPar::Skeletons;
+
+struct BenchSpace {};
+
+struct BenchNode {
+  int obj = 0;
+
+  int getObj() const { return obj; }
+
+  template <class Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & obj;
+  }
+};
+
+struct BenchGen : NodeGenerator<BenchNode, BenchSpace> {
+  BenchNode node;
+
+  BenchGen(const BenchSpace &, const BenchNode & n) : node(n) {
+    numChildren = 2;
+  }
+
+  BenchNode next() override {
+    return node;
+  }
+};
+
+// Never prunes, and nodes never beat the incumbent (initialBound below)
+int upperBound(const BenchSpace &, const BenchNode & n) {
+  return n.obj + 10;
+}
+typedef func<decltype(&upperBound), &upperBound> upperBound_func;
+
+constexpr int initialBound = 5;
+
+template <typename PN, typename Bound>
+MicroBench::Fn processNodeBench(const unsigned boundRefreshInterval) {
+  return [boundRefreshInterval](std::uint64_t iterations) {
+    using Reg = Registry<BenchSpace, BenchNode, Bound, typename PN::Enumerator>;
+
+    API::Params<Bound> params;
+    params.initialBound = initialBound;
+    params.boundRefreshInterval = boundRefreshInterval;
+    BenchSpace space;
+    BenchNode node;
+    Reg::gReg->initialise(space, node, params);
+
+    typename PN::Enumerator acc;
+    return MicroBench::time([&]() {
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+          MicroBench::doNotOptimise(PN::processNode(params, space, node, 1, acc));
+        }
+      });
+  };
+}
+
+using EnumPN = ProcessNode<BenchSpace, BenchNode, API::Enumeration>;
+using OptPN = ProcessNode<BenchSpace, BenchNode, API::Optimisation, API::BoundFunction<upperBound_func> >;
+
+MICROBENCH("ProcessNode/enumeration", processNodeBench<EnumPN, bool>(0));
+MICROBENCH("ProcessNode/optimisation", processNodeBench<OptPN, int>(0));
+MICROBENCH("ProcessNode/optimisation/boundRefresh64", processNodeBench<OptPN, int>(64));
+
+// n threads updating the local bound at once, improving it on every call or never
+MicroBench::Fn registryBench(const unsigned n, const bool improving) {
+  return [n, improving](std::uint64_t iterations) {
+    using Reg = Registry<BenchSpace, BenchNode, int, IdentityEnumerator<BenchNode> >;
+    Reg::gReg->localBound.store(improving ? 0 : std::numeric_limits<int>::max());
+    return MicroBench::onThreads(n, iterations, [improving](std::uint64_t i) {
+        auto bnd = improving ? static_cast<int>(i) : 0;
+        MicroBench::doNotOptimise(Reg::gReg->updateRegistryBound<std::greater<int> >(bnd));
+      });
+  };
+}
+
+MICROBENCH("Registry/updateRegistryBound/improving/1T", registryBench(1, true), 1);
+MICROBENCH("Registry/updateRegistryBound/improving/4T", registryBench(4, true), 4);
+MICROBENCH("Registry/updateRegistryBound/improving/16T", registryBench(16, true), 16);
+MICROBENCH("Registry/updateRegistryBound/stale/1T", registryBench(1, false), 1);
+MICROBENCH("Registry/updateRegistryBound/stale/4T", registryBench(4, false), 4);
+MICROBENCH("Registry/updateRegistryBound/stale/16T", registryBench(16, false), 16);
+
+// A task's stack: built from the per thread cache after the first iteration, then grown to depth
+MicroBench::Fn generatorStackBench(const unsigned depth) {
+  return [depth](std::uint64_t iterations) {
+    BenchSpace space;
+    StackElem<BenchGen> root(space, BenchNode());
+    return MicroBench::time([&]() {
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+          GeneratorStack<BenchGen> stack(5000, root);
+          MicroBench::doNotOptimise(stack[depth]);
+        }
+      });
+  };
+}
+
+MICROBENCH("GeneratorStack/setup", generatorStackBench(0));
+MICROBENCH("GeneratorStack/setup+depth32", generatorStackBench(32));
+
+}
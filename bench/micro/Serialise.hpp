@@ -0,0 +1,51 @@
+#ifndef YEWPAR_MICROBENCH_SERIALISE_HPP
+#define YEWPAR_MICROBENCH_SERIALISE_HPP
+
+#include <vector>
+
+#include <hpx/runtime/serialization/input_archive.hpp>
+#include <hpx/runtime/serialization/output_archive.hpp>
+#include <hpx/runtime/serialization/serialize.hpp>
+
+#include "MicroBench.hpp"
+
+// Saving and loading a node as a steal response would
+namespace MicroBench {
+
+template <typename Node>
+Fn saveBench(const Node & node) {
+  return [node](std::uint64_t iterations) {
+    std::vector<char> buf;
+    return time([&]() {
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+          buf.clear();
+          hpx::serialization::output_archive ar(buf);
+          ar << node;
+          doNotOptimise(buf);
+        }
+      });
+  };
+}
+
+template <typename Node>
+Fn loadBench(const Node & node) {
+  return [node](std::uint64_t iterations) {
+    std::vector<char> buf;
+    {
+      hpx::serialization::output_archive ar(buf);
+      ar << node;
+    }
+    return time([&]() {
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+          Node n;
+          hpx::serialization::input_archive ar(buf, buf.size());
+          ar >> n;
+          doNotOptimise(n);
+        }
+      });
+  };
+}
+
+}
+
+#endif
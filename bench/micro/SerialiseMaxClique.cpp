@@ -0,0 +1,58 @@
+#include <vector>
+
+#include <hpx/runtime/serialization/vector.hpp>
+
+#include "util/BitSet.hpp"
+
+#include "Serialise.hpp"
+
+namespace {
+
+using YewPar::util::BitSet;
+
+// The same layout as maxclique's MCNode (apps/bnb/maxclique/main.cpp), for brock200-sized graphs
+constexpr unsigned words = 8;
+
+struct MCSol {
+  std::vector<int> members;
+  int colours;
+
+  template <class Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & members;
+    ar & colours;
+  }
+};
+
+struct MCNode {
+  MCSol sol;
+  int size;
+  BitSet<words> remaining;
+
+  template <class Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & sol;
+    ar & size;
+    ar & remaining;
+  }
+};
+
+// A node a third of the way into a search for a 21-clique in a 200 vertex graph
+MCNode typicalNode() {
+  MCNode n;
+  for (int v = 0; v < 7; ++v) {
+    n.sol.members.push_back(v * 13);
+  }
+  n.sol.colours = 14;
+  n.size = n.sol.members.size();
+  n.remaining.resize(200);
+  for (int v = 0; v < 200; v += 3) {
+    n.remaining.set(v);
+  }
+  return n;
+}
+
+MICROBENCH("Serialise/MCNode/save", MicroBench::saveBench(typicalNode()));
+MICROBENCH("Serialise/MCNode/load", MicroBench::loadBench(typicalNode()));
+
+}
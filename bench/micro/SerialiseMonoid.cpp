@@ -0,0 +1,17 @@
+#include "monoid.hpp"
+
+#include "Serialise.hpp"
+
+namespace {
+
+// Sized for genus 50
+Monoid<sizeFor(50)> typicalNode() {
+  Monoid<sizeFor(50)> m;
+  init_full_N(m);
+  return m;
+}
+
+MICROBENCH("Serialise/Monoid/save", MicroBench::saveBench(typicalNode()));
+MICROBENCH("Serialise/Monoid/load", MicroBench::loadBench(typicalNode()));
+
+}
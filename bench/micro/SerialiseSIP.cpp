@@ -0,0 +1,80 @@
+#include <tuple>
+#include <vector>
+
+#include <hpx/runtime/serialization/std_tuple.hpp>
+#include <hpx/runtime/serialization/vector.hpp>
+
+#include "fixed_bit_set.hh"
+
+#include "Serialise.hpp"
+
+namespace {
+
+// The same layout as sip's SIPNode (apps/decision/sip/main.cpp) with the default NWORDS
+constexpr unsigned words = 128;
+
+struct Assignment {
+  unsigned variable;
+  unsigned value;
+
+  template <class Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & variable;
+    ar & value;
+  }
+};
+
+struct Domain {
+  unsigned v;
+  unsigned popcount;
+  bool fixed = false;
+  FixedBitSet<words> values;
+
+  template <class Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & v;
+    ar & popcount;
+    ar & fixed;
+    ar & values;
+  }
+};
+
+struct SIPNode {
+  std::vector<Domain> domains;
+  std::vector<std::tuple<Assignment, bool> > assignments;
+  bool propagationSuccess;
+  bool sat;
+
+  template <class Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & domains;
+    ar & assignments;
+    ar & propagationSuccess;
+    ar & sat;
+  }
+};
+
+// A 30 vertex pattern, 10 vertices assigned, in a big target
+SIPNode typicalNode() {
+  SIPNode n;
+  for (unsigned v = 0; v < 20; ++v) {
+    Domain d;
+    d.v = v + 10;
+    for (unsigned t = v; t < words * bits_per_word; t += 7) {
+      d.values.set(t);
+    }
+    d.popcount = d.values.popcount();
+    n.domains.push_back(d);
+  }
+  for (unsigned v = 0; v < 10; ++v) {
+    n.assignments.emplace_back(Assignment {v, v * 31}, v % 3 == 0);
+  }
+  n.propagationSuccess = true;
+  n.sat = false;
+  return n;
+}
+
+MICROBENCH("Serialise/SIPNode/save", MicroBench::saveBench(typicalNode()));
+MICROBENCH("Serialise/SIPNode/load", MicroBench::loadBench(typicalNode()));
+
+}
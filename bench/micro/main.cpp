@@ -0,0 +1,103 @@
+#include <hpx/hpx_init.hpp>
+#include <hpx/include/iostreams.hpp>
+#include <hpx/runtime/get_os_thread_count.hpp>
+
+#include <boost/format.hpp>
+
+#include <fstream>
+#include <regex>
+#include <string>
+
+#include "YewPar.hpp"
+
+#include "MicroBench.hpp"
+
+namespace {
+
+struct Result {
+  std::string name;
+  std::uint64_t iterations;
+  double nsPerOp;
+};
+
+Result run(const MicroBench::Benchmark & b, const MicroBench::clock::duration minTime) {
+  constexpr std::uint64_t maxIterations = std::uint64_t(1) << 32;
+
+  std::uint64_t iterations = 1;
+  MicroBench::clock::duration took;
+  while (true) {
+    took = b.fn(iterations);
+    if (took >= minTime || iterations >= maxIterations) {
+      break;
+    }
+    // Aim a bit past minTime next time, but never grow by more than 10x
+    auto scale = took.count() > 0 ? 1.4 * minTime.count() / took.count() : 10;
+    iterations = std::min(maxIterations,
+                          static_cast<std::uint64_t>(iterations * std::max(2.0, std::min(10.0, scale))));
+  }
+  auto ns = std::chrono::duration_cast<std::chrono::duration<double, std::nano> >(took).count();
+  return Result {b.name, iterations, ns / iterations};
+}
+
+}
+
+int hpx_main(boost::program_options::variables_map & opts) {
+  std::regex filter(opts["filter"].as<std::string>());
+  auto minTime = std::chrono::milliseconds(opts["min-time"].as<unsigned>());
+
+  std::vector<Result> results;
+  for (const auto & b : MicroBench::benchmarks()) {
+    if (!std::regex_search(b.name, filter)) {
+      continue;
+    }
+    if (b.threads > hpx::get_os_thread_count()) {
+      hpx::cout << (boost::format("%1$-48s skipped, needs %2% threads") % b.name % b.threads) << hpx::endl;
+      continue;
+    }
+    if (b.available && !b.available()) {
+      hpx::cout << (boost::format("%1$-48s skipped, not supported here") % b.name) << hpx::endl;
+      continue;
+    }
+
+    auto r = run(b, minTime);
+    hpx::cout << (boost::format("%-48s %12d iterations %12.1f ns/op") % r.name % r.iterations % r.nsPerOp)
+              << hpx::endl;
+    results.push_back(r);
+  }
+
+  if (opts.count("output")) {
+    std::ofstream out(opts["output"].as<std::string>());
+    out << "[\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+      out << (boost::format("  {\"name\": \"%1%\", \"iterations\": %2%, \"ns_per_op\": %3%}%4%\n")
+              % results[i].name % results[i].iterations % results[i].nsPerOp
+              % (i + 1 < results.size() ? "," : ""));
+    }
+    out << "]\n";
+  }
+
+  return hpx::finalize();
+}
+
+int main(int argc, char* argv[]) {
+  boost::program_options::options_description
+      desc_commandline("Usage: " HPX_APPLICATION_STRING " [options]");
+
+  desc_commandline.add_options()
+      ( "filter",
+        boost::program_options::value<std::string>()->default_value(".*"),
+        "Only run benchmarks whose name matches this regex"
+        )
+      ( "min-time",
+        boost::program_options::value<unsigned>()->default_value(200),
+        "Minimum time (ms) each benchmark runs for"
+        )
+      ( "output",
+        boost::program_options::value<std::string>(),
+        "Also write the results to this file as JSON"
+        );
+
+  YewPar::registerPerformanceCounters();
+
+  return YewPar::init(desc_commandline, argc, argv);
+}
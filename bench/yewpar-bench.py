@@ -0,0 +1,243 @@
+#!/usr/bin/env python3
+"""Benchmark driver for the YewPar apps.
+
+Runs every benchmark of a matrix (see matrix.json) for each of its skeletons, thread counts and
+locality counts, and writes the wall times, node counts and performance counters of each
+configuration as JSON. Given a baseline (an earlier output) it also reports configurations that
+got slower by more than the tolerance, or whose node counts changed, and exits with status 1 if
+there are any. A configuration that fails (exits non zero, times out or fails its check) is
+recorded under "failures" and the rest of the matrix still runs, the exit status is then 1 as well.
+
+With --scaling it also reports, for each benchmark and skeleton, the speedup and parallel
+efficiency of every configuration against the one with the fewest workers (threads times
+localities). Both are computed from nodes per second when the benchmark counts nodes, so a benchmark
+whose "weak" table grows the problem with the worker count (weak scaling) is reported the same way
+as one with a fixed problem (strong scaling). uts-scaling.json is the UTS matrix for this.
+
+    yewpar-bench.py --build-dir build --data-dir test --output bench.json [--baseline old.json]
+    yewpar-bench.py --matrix bench/uts-scaling.json --scaling --build-dir build --data-dir test
+"""
+
+import argparse
+import json
+import os
+import re
+import statistics
+import subprocess
+import sys
+import time
+
+# --hpx:print-counter lines, e.g. /yewpar{locality#0/total}/nodes/processed,1,2.09,[s],4130071
+COUNTER_LINE = re.compile(r'^(/[^,]+),\d+,[\d.]+,?\[s\],(.*)$')
+CPU_LINE = re.compile(r'^cpu = (\d+)', re.M)
+
+
+def find_app(build_dir, name):
+    for root, _, files in os.walk(build_dir):
+        if name in files:
+            path = os.path.join(root, name)
+            if os.access(path, os.X_OK):
+                return path
+    return None
+
+
+def expand(args, values):
+    return [a.format(**values) for a in args]
+
+
+def parse_counters(out):
+    counters = {}
+    for line in out.splitlines():
+        m = COUNTER_LINE.match(line.strip())
+        if not m:
+            continue
+        values = [v for v in m.group(2).split(',') if v and v != '[s]']
+        try:
+            values = [float(v) for v in values]
+        except ValueError:
+            pass
+        counters[m.group(1)] = values[0] if len(values) == 1 else values
+    return counters
+
+
+def run_once(cmd, bench, timeout):
+    start = time.monotonic()
+    proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                          universal_newlines=True, timeout=timeout)
+    wall = time.monotonic() - start
+    out = proc.stdout
+
+    if proc.returncode != 0:
+        raise RuntimeError('%s exited with %d:\n%s' % (' '.join(cmd), proc.returncode, out))
+    if 'check' in bench and not re.search(bench['check'], out):
+        raise RuntimeError('%s: output does not match "%s":\n%s' % (' '.join(cmd), bench['check'], out))
+
+    res = {'wall': wall, 'counters': parse_counters(out)}
+    cpu = CPU_LINE.search(out)
+    if cpu:
+        res['cpu_ms'] = int(cpu.group(1))
+    if 'nodes' in bench:
+        m = re.search(bench['nodes'], out)
+        if m:
+            res['nodes'] = int(m.group(1))
+    return res
+
+
+def configurations(matrix):
+    for bench in matrix['benchmarks']:
+        for skel, skel_args in bench['skeletons'].items():
+            for locs in bench.get('localities', matrix.get('localities', [1])):
+                for threads in bench.get('threads', matrix.get('threads', [1])):
+                    yield bench, skel, skel_args, threads, locs
+
+
+def weak_args(bench, workers):
+    # The entry for the largest worker count not above this one
+    weak = bench.get('weak', {})
+    fits = [int(w) for w in weak if int(w) <= workers]
+    return weak[str(max(fits))] if fits else []
+
+
+def run_matrix(matrix, build_dir, data_dir, repeats, timeout, only):
+    """Results and failures (error messages), both keyed by configuration"""
+    counters = matrix.get('counters', [])
+    results = {}
+    failures = {}
+    for bench, skel, skel_args, threads, locs in configurations(matrix):
+        key = '%s/%s/%dT/%dL' % (bench['name'], skel, threads, locs)
+        if only and not re.search(only, key):
+            continue
+
+        app = find_app(build_dir, bench['app'])
+        if app is None:
+            print('%s: skipped, %s not built under %s' % (key, bench['app'], build_dir), flush=True)
+            continue
+
+        values = {'data': data_dir, 'threads': threads, 'localities': locs}
+        cmd = []
+        if locs > 1:
+            cmd += expand(matrix.get('launcher', ['mpirun', '-n', '{localities}']), values)
+        cmd.append(app)
+        cmd += ['--skeleton', skel] + expand(skel_args, values) + expand(bench.get('args', []), values)
+        cmd += expand(weak_args(bench, threads * locs), values)
+        cmd += ['--hpx:threads', str(threads)]
+        cmd += ['--hpx:print-counter=' + c for c in counters]
+
+        print('%s: %s' % (key, ' '.join(cmd)), flush=True)
+        try:
+            runs = [run_once(cmd, bench, timeout) for _ in range(repeats)]
+        except (RuntimeError, subprocess.TimeoutExpired, OSError) as e:
+            failures[key] = str(e)
+            print('  FAILED %s' % e, flush=True)
+            continue
+
+        walls = [r['wall'] for r in runs]
+        res = {
+            'benchmark': bench['name'],
+            'skeleton': skel,
+            'threads': threads,
+            'localities': locs,
+            'command': cmd,
+            'wall': walls,
+            'wall_median': statistics.median(walls),
+            'counters': runs[-1]['counters'],
+        }
+        if all('cpu_ms' in r for r in runs):
+            res['cpu_ms_median'] = statistics.median(r['cpu_ms'] for r in runs)
+        if 'nodes' in runs[-1]:
+            res['nodes'] = runs[-1]['nodes']
+        results[key] = res
+        print('  median %.3fs' % res['wall_median'], flush=True)
+    return results, failures
+
+
+def compare(results, baseline, tolerance):
+    problems = []
+    for key, res in sorted(results.items()):
+        old = baseline.get(key)
+        if old is None:
+            continue
+        ratio = res['wall_median'] / old['wall_median'] if old['wall_median'] > 0 else 1
+        if ratio > 1 + tolerance:
+            problems.append('%s: %.3fs -> %.3fs (%+.1f%%)' %
+                            (key, old['wall_median'], res['wall_median'], (ratio - 1) * 100))
+        if 'nodes' in old and 'nodes' in res and old['nodes'] != res['nodes']:
+            problems.append('%s: nodes %d -> %d' % (key, old['nodes'], res['nodes']))
+    return problems
+
+
+def scaling(results):
+    groups = {}
+    for key, res in results.items():
+        groups.setdefault((res['benchmark'], res['skeleton']), []).append((key, res))
+
+    report = {}
+    for (bench, skel), runs in sorted(groups.items()):
+        runs.sort(key=lambda r: (r[1]['threads'] * r[1]['localities'], r[1]['localities']))
+
+        def rate(res):
+            return res.get('nodes', 1) / res['wall_median'] if res['wall_median'] > 0 else 0
+
+        base = runs[0][1]
+        base_workers = base['threads'] * base['localities']
+        print('%s/%s (against %dT/%dL)' % (bench, skel, base['threads'], base['localities']))
+        print('  %8s %10s %10s %10s' % ('workers', 'median', 'speedup', 'efficiency'))
+        for key, res in runs:
+            workers = res['threads'] * res['localities']
+            speedup = rate(res) / rate(base) if rate(base) > 0 else 0
+            efficiency = speedup * base_workers / workers
+            report[key] = {'workers': workers, 'speedup': speedup, 'efficiency': efficiency}
+            print('  %8s %9.3fs %10.2f %9.1f%%' % ('%dx%d' % (res['localities'], res['threads']),
+                                                 res['wall_median'], speedup, efficiency * 100))
+    return report
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    p = argparse.ArgumentParser(description='Run a matrix of YewPar benchmarks')
+    p.add_argument('--matrix', default=os.path.join(here, 'matrix.json'))
+    p.add_argument('--build-dir', required=True, help='where the apps were built')
+    p.add_argument('--data-dir', required=True, help='instances, usually YEWPAR_TEST_DATA_DIR')
+    p.add_argument('--output', default='bench.json')
+    p.add_argument('--baseline', help='earlier output to compare against')
+    p.add_argument('--tolerance', type=float, default=0.1,
+                   help='allowed slowdown against the baseline as a fraction (default 0.1)')
+    p.add_argument('--repeats', type=int, help='runs per configuration (default from the matrix)')
+    p.add_argument('--timeout', type=float, default=3600, help='seconds per run')
+    p.add_argument('--only', help='regex, only run configurations whose key matches')
+    p.add_argument('--scaling', action='store_true',
+                   help='report speedup and efficiency against the fewest workers')
+    args = p.parse_args()
+
+    with open(args.matrix) as f:
+        matrix = json.load(f)
+    repeats = args.repeats or matrix.get('repeats', 3)
+
+    results, failures = run_matrix(matrix, args.build_dir, args.data_dir, repeats, args.timeout,
+                                   args.only)
+    out = {'matrix': os.path.abspath(args.matrix), 'repeats': repeats, 'results': results,
+           'failures': failures}
+    if args.scaling:
+        out['scaling'] = scaling(results)
+    with open(args.output, 'w') as f:
+        json.dump(out, f, indent=2, sort_keys=True)
+    print('Wrote %d configurations to %s' % (len(results), args.output))
+    for key in sorted(failures):
+        print('FAILED ' + key)
+
+    status = 1 if failures else 0
+
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)['results']
+        problems = compare(results, baseline, args.tolerance)
+        for line in problems:
+            print('REGRESSION ' + line)
+        if problems:
+            return 1
+        print('No regressions against %s (tolerance %.0f%%)' % (args.baseline, args.tolerance * 100))
+    return status
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -50,9 +50,9 @@ stdenv.mkDerivation rec {
 
   cmakeFlags = [
     "-DCMAKE_BUILD_TYPE=Release"
-    "-DYEWPAR_BUILD_BNB_APPS_MAXCLIQUE_NWORDS=14"
+    "-DYEWPAR_BUILD_BNB_APPS_MAXCLIQUE_MAX_NWORDS=16"
     "-DYEWPAR_BUILD_BNB_APPS_KNAPSACK_NITEMS=220"
-    "-DYEWPAR_BUILD_APPS_SIP_NWORDS=128"
+    "-DYEWPAR_BUILD_APPS_SIP_MAX_NWORDS=128"
   ];
 
   LD_LIBRARY_PATH="${openssl}/lib"; #For some reason this isn't set right on gpg
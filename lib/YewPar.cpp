@@ -1,15 +1,37 @@
 #include "workstealing/policies/SearchManager.hpp"
 #include "workstealing/policies/Workpool.hpp"
+#include "workstealing/policies/PerThreadWorkpool.hpp"
 #include "workstealing/policies/PriorityOrdered.hpp"
 #include "workstealing/policies/DepthPoolPolicy.hpp"
+#include "workstealing/LoadGossip.hpp"
+#include "workstealing/WorkerStates.hpp"
+#include "workstealing/StealStats.hpp"
+#include "util/AdaptiveBudget.hpp"
+#include "util/AdaptiveSpawnRate.hpp"
+#include "util/MemoTable.hpp"
+#include "util/CompletionAggregator.hpp"
+#include "util/SearchMetrics.hpp"
+#include "util/MemoryUsage.hpp"
+#include "util/Log.hpp"
 
 namespace YewPar {
 
 void registerPerformanceCounters() {
   hpx::register_startup_function(&Workstealing::Policies::SearchManagerPerf::registerPerformanceCounters);
   hpx::register_startup_function(&Workstealing::Policies::WorkpoolPerf::registerPerformanceCounters);
+  hpx::register_startup_function(&Workstealing::Policies::PerThreadWorkpoolPerf::registerPerformanceCounters);
   hpx::register_startup_function(&Workstealing::Policies::PriorityOrderedPerf::registerPerformanceCounters);
   hpx::register_startup_function(&Workstealing::Policies::DepthPoolPolicyPerf::registerPerformanceCounters);
+  hpx::register_startup_function(&Workstealing::LoadGossip::registerPerformanceCounters);
+  hpx::register_startup_function(&Workstealing::WorkerStates::registerPerformanceCounters);
+  hpx::register_startup_function(&Workstealing::StealStats::registerPerformanceCounters);
+  hpx::register_startup_function(&YewPar::util::AdaptiveBudget::registerPerformanceCounters);
+  hpx::register_startup_function(&YewPar::util::AdaptiveSpawnRate::registerPerformanceCounters);
+  hpx::register_startup_function(&YewPar::util::MemoTable::registerPerformanceCounters);
+  hpx::register_startup_function(&YewPar::util::CompletionAggregator::registerPerformanceCounters);
+  hpx::register_startup_function(&YewPar::util::SearchMetrics::registerPerformanceCounters);
+  hpx::register_startup_function(&YewPar::util::MemoryUsage::registerPerformanceCounters);
+  hpx::register_startup_function(&YewPar::util::Log::registerShutdownFlush);
 }
 
 }
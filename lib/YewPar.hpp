@@ -1,8 +1,30 @@
 #ifndef YEWPAR_HPP
 #define YEWPAR_HPP
+
+#include <vector>
+
+#include <hpx/hpx_init.hpp>
+
+#include "util/RuntimeOptions.hpp"
+
 namespace YewPar {
 
 void registerPerformanceCounters();
 
+// hpx::init, also accepting YewPar's runtime options (see util/RuntimeOptions.hpp) on the command
+// line. Applications call this in place of hpx::init. Inline as hpx::init needs the application's
+// hpx_main.
+inline int init(boost::program_options::options_description & desc, int argc, char* argv[]) {
+  desc.add(util::RuntimeOptions::options());
+
+  auto translated = util::RuntimeOptions::translate(argc, argv);
+  std::vector<char *> args(argv, argv + argc);
+  for (auto & a : translated.hpxArgs) {
+    args.push_back(&a[0]);
+  }
+
+  return hpx::init(desc, static_cast<int>(args.size()), args.data(), translated.config);
+}
+
 }
 #endif
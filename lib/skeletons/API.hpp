@@ -4,6 +4,16 @@
 #include <boost/parameter.hpp>
 #include <boost/serialization/access.hpp>
 
+#include <stdexcept>
+#include <string>
+
+#include <hpx/runtime/serialization/string.hpp>
+
+namespace YewPar {
+template <typename NodeType, typename IsSolution>
+struct SolutionSinkEnumerator;
+}
+
 namespace YewPar { namespace Skeletons {
 
 namespace parameter = boost::parameter;
@@ -30,13 +40,40 @@ BOOST_PARAMETER_TEMPLATE_KEYWORD(BoundFunction)
 BOOST_PARAMETER_TEMPLATE_KEYWORD(ObjectiveComparison)
 BOOST_PARAMETER_TEMPLATE_KEYWORD(MaxStackDepth)
 BOOST_PARAMETER_TEMPLATE_KEYWORD(Enumerator)
+// Stream every node for which IsSolution()(node, depth) holds to per-locality files instead of
+// reducing them, search() returns how many there were. See util/SolutionSink.hpp.
+template <typename Node, typename IsSolution>
+struct SolutionSink : Enumerator<SolutionSinkEnumerator<Node, IsSolution> > {};
+// Prune nodes whose state was already searched (or reached more cheaply). Takes a function
+// (space, node) -> util::MemoTable::MemoKey, see util/MemoTable.hpp for the table itself.
+BOOST_PARAMETER_TEMPLATE_KEYWORD(Memoize)
+// Build the initial incumbent of a B&B search with a randomised construction heuristic, a function
+// (space, root, seed) -> Node, run from many starts on every worker for Params::multiStartMillis.
+// See util/MultiStart.hpp.
+BOOST_PARAMETER_TEMPLATE_KEYWORD(InitialHeuristic)
 
 // Optimisations
 DEF_PRESENT_PARAMETER(PruneLevel, PruneLevel_)
 
+// Keep incumbent nodes on the locality that found them and only propagate bounds, the winning
+// node is fetched once at the end of the search
+DEF_PRESENT_PARAMETER(LazyIncumbent, LazyIncumbent_)
+
+// Count processed/pruned nodes and a depth histogram while searching, see util/SearchMetrics.hpp.
+// Implied by any Verbose_ level.
+DEF_PRESENT_PARAMETER(Metrics, Metrics_)
+
 // Depth bounded policies
 BOOST_PARAMETER_TEMPLATE_KEYWORD(DepthBoundedPoolPolicy)
 
+// Detect the end of the search with per-locality task counters rather than a promise per task
+// (DepthBounded, Budget and StackStealing)
+DEF_PRESENT_PARAMETER(CountTermination, CountTermination_)
+
+// Used by the Hybrid skeleton to switch StackStealing to depth bounded spawning above spawnDepth.
+// Use Hybrid rather than passing this directly.
+DEF_PRESENT_PARAMETER(HybridSpawns, HybridSpawns_)
+
 // Ordered Discrpancy search toggle
 DEF_PRESENT_PARAMETER(DiscrepancySearch, DiscrepancySearch_)
 
@@ -67,17 +104,118 @@ struct Params {
   // Depth Spawns
   unsigned spawnDepth = 1;
 
+  // Treat spawnDepth as a hint: keep spawning below it while workers are idle and stop spawning
+  // above it while the local pool is saturated. See util/AdaptiveSpawnDepth.hpp.
+  bool adaptiveSpawnDepth = false;
+
   // Stack Steals
   // Should we steal all remaining nodes at the highest depth or just one?
   bool stealAll = false;
 
+  // Size steal responses by thief distance and remaining work, possibly taking nodes from several
+  // levels of the stack (overrides stealAll)
+  bool stealAdaptive = false;
+
+  // Maximum number of distributed steals a locality may have outstanding at once
+  unsigned maxDistributedSteals = 1;
+
+  // Start a distributed steal once the local task buffer holds this many tasks or fewer (0 disables
+  // prefetching, steals then only happen once a worker is idle)
+  unsigned stealPrefetchThreshold = 0;
+
+  // Send nodes stolen by other localities as their path from the root when recomputing them is
+  // estimated to be cheaper than sending them. See util/PathSteal.hpp.
+  bool pathSteals = false;
+
+  // StackStealing: publish the shallowest levels of each stack so thieves claim nodes from them
+  // directly rather than waiting for the searching thread to answer (which it only does between
+  // nodes, so an expensive node holds the steal up). The thief builds the node itself. Steals are
+  // then always a single node (stealAll/stealAdaptive are ignored), and pathSteals takes precedence.
+  // See workstealing/OpenLevels.hpp.
+  bool claimSteals = false;
+
+  // B&B: with n > 1 each worker re-reads the shared bound every n nodes (or as soon as the bound on
+  // its locality improves) and prunes against a thread-local copy in between. Useful when nodes are so cheap
+  // the bound read is noticeable. Pruning is never wrong, just possibly less effective.
+  unsigned boundRefreshInterval = 0;
+
   // Budget
   // FIXME: How to determine a good value for this?
   unsigned backtrackBudget = 200;
 
+  // Let each locality tune the budget at runtime (backtrackBudget is then only the starting value),
+  // aiming for tasks that run for around budgetTargetTaskMicros. See util/AdaptiveBudget.hpp.
+  bool adaptiveBudget = false;
+  unsigned budgetTargetTaskMicros = 1000;
+
   // Random spawnProbability = 1/n
   unsigned spawnProbability = 1000000;
 
+  // Let each locality tune the spawn probability at runtime (spawnProbability is then only the
+  // starting value). See util/AdaptiveSpawnRate.hpp.
+  bool adaptiveSpawnProbability = false;
+
+  // BestFirst: open nodes a locality keeps in its frontier before searching further children depth
+  // first, and how many expansions a worker does between sending its best node to another locality
+  // (0 never sends)
+  unsigned maxFrontierSize = 100000;
+  unsigned frontierExchangeInterval = 1024;
+
+  // Portfolio: time each configuration gets in the first round, doubling every round (0 runs the
+  // first configuration to completion)
+  unsigned portfolioSliceMillis = 100;
+
+  // Memoize: entries in each locality's memo table (rounded up to a power of two)
+  unsigned memoTableSize = 1 << 20;
+
+  // DepthBounded: write the outstanding work to checkpointFile every checkpointIntervalMillis (0
+  // never), and/or start from the work in checkpointFile instead of the root. The file is removed
+  // once a search writing checkpoints completes. See util/Checkpoint.hpp. Every other skeleton
+  // throws std::invalid_argument if either is set.
+  std::string checkpointFile;
+  unsigned checkpointIntervalMillis = 0;
+  bool resumeFromCheckpoint = false;
+
+  // Choose spawnDepth, backtrackBudget and spawnProbability from a sampled estimate of the tree
+  // before searching, with this many random probes (see util/TreeEstimator.hpp). StackStealing
+  // always uses the estimate for its initial work distribution.
+  bool autoTune = false;
+  unsigned estimatorProbes = 256;
+
+  // DepthBounded, Budget, StackStealing and Ordered: record every task and write the trace to
+  // traceFile.json (Chrome trace format) and traceFile.csv at the end, keeping the last
+  // traceBufferSize tasks of each worker. See util/TaskTrace.hpp.
+  std::string traceFile;
+  unsigned traceBufferSize = 1 << 16;
+
+  // DepthBounded and Budget with the DepthPool policy, B&B: order the tasks at each depth by their
+  // root's bound, most promising first, and skip tasks whose bound no longer beats the incumbent
+  // once they are popped
+  bool boundOrderedPool = false;
+
+  // DepthBounded and Budget: once a locality's pools, stacks and child futures hold more than this
+  // many MB, stop spawning and search would-be tasks inline until usage drops (0 never does). See
+  // util/MemoryUsage.hpp.
+  unsigned memoryCapMB = 0;
+
+  // Keep a copy of the space for every NUMA domain of a locality, made by the first worker of that
+  // domain to need it (so its pages are allocated on that domain), and have the skeletons' tasks read
+  // their own domain's copy. For large, heavily read spaces on multi-socket machines. See
+  // Registry::localSpace.
+  bool numaReplicas = false;
+
+  // Restarts: a run restarts after restartBacktracks * luby(n) backtracks, where n counts the
+  // worker's runs. See Restarts.hpp.
+  unsigned restartBacktracks = 100;
+
+  // B&B with an InitialHeuristic: run it on all workers for this long before searching, installing
+  // its best node as the incumbent if that beats initialBound (0 skips the heuristic)
+  unsigned multiStartMillis = 0;
+
+  // DepthBounded and Budget (without CountTermination): every joinPollMillis look for localities that
+  // connected to the application after the search started and have them join it (0 never does).
+  // See util/LocalityJoin.hpp.
+  unsigned joinPollMillis = 0;
 
   // Needed to push to registries on all nodes
   template <class Archive>
@@ -86,12 +224,48 @@ struct Params {
     ar & expectedObjective;
     ar & initialBound;
     ar & spawnDepth;
+    ar & adaptiveSpawnDepth;
     ar & stealAll;
+    ar & stealAdaptive;
+    ar & maxDistributedSteals;
+    ar & stealPrefetchThreshold;
+    ar & pathSteals;
+    ar & claimSteals;
+    ar & boundRefreshInterval;
     ar & backtrackBudget;
+    ar & adaptiveBudget;
+    ar & budgetTargetTaskMicros;
     ar & spawnProbability;
+    ar & adaptiveSpawnProbability;
+    ar & maxFrontierSize;
+    ar & frontierExchangeInterval;
+    ar & portfolioSliceMillis;
+    ar & memoTableSize;
+    ar & checkpointFile;
+    ar & checkpointIntervalMillis;
+    ar & resumeFromCheckpoint;
+    ar & autoTune;
+    ar & estimatorProbes;
+    ar & traceFile;
+    ar & traceBufferSize;
+    ar & boundOrderedPool;
+    ar & memoryCapMB;
+    ar & numaReplicas;
+    ar & restartBacktracks;
+    ar & multiStartMillis;
+    ar & joinPollMillis;
   }
 };
 
+// For the skeletons other than DepthBounded, which have no point at which all their work can be
+// recorded (thieves take it off running stacks, or it is never split off at all)
+template <typename Bound>
+void rejectCheckpoints(const Params<Bound> & params, const std::string & skeleton) {
+  if (params.checkpointIntervalMillis > 0 || params.resumeFromCheckpoint) {
+    throw std::invalid_argument(skeleton + " doesn't support checkpoints, use DepthBounded");
+  }
+}
+
 }}}
 
 #endif
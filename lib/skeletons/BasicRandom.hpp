@@ -5,6 +5,17 @@
 
 #include <boost/format.hpp>
 
+#include "util/NodeGenerator.hpp"
+#include "util/FastRandom.hpp"
+#include "util/AdaptiveSpawnRate.hpp"
+#include "util/TreeEstimator.hpp"
+#include "util/CompletionAggregator.hpp"
+#include "util/TaskPool.hpp"
+#include "util/util.hpp"
+
+#include "workstealing/WorkerStates.hpp"
+#include "workstealing/StealStats.hpp"
+
 #include<random>
 #include<stdlib.h>
 #include<time.h>
@@ -22,6 +33,9 @@ struct Random {
   typedef typename Generator::Nodetype Node;
   typedef typename Generator::Spacetype Space;
 
+  static_assert(isNodeGenerator<Generator>::value,
+                "Generator needs Nodetype, Spacetype, numChildren, next() and a (Space, Node) constructor");
+
   typedef typename API::skeleton_signature::bind<Args...>::type args;
 
   static constexpr bool isEnumeration = parameter::value_type<args, API::tag::Enumeration_, std::integral_constant<bool, false> >::type::value;
@@ -29,6 +43,7 @@ struct Random {
   static constexpr bool isDecision = parameter::value_type<args, API::tag::Decision_, std::integral_constant<bool, false> >::type::value;
   static constexpr bool isDepthBounded = parameter::value_type<args, API::tag::DepthLimited_, std::integral_constant<bool, false> >::type::value;
   static constexpr bool pruneLevel = parameter::value_type<args, API::tag::PruneLevel_, std::integral_constant<bool, false> >::type::value;
+  static constexpr bool lazyIncumbent = parameter::value_type<args, API::tag::LazyIncumbent_, std::integral_constant<bool, false> >::type::value;
   static constexpr unsigned maxStackDepth = parameter::value_type<args, API::tag::MaxStackDepth, std::integral_constant<unsigned, 5000> >::type::value;
 
   typedef typename parameter::value_type<args, API::tag::Verbose_, std::integral_constant<unsigned, 0> >::type Verbose;
@@ -39,6 +54,8 @@ struct Random {
   typedef typename parameter::value_type<args, API::tag::ObjectiveComparison, std::greater<Bound> >::type Objcmp;
   typedef typename parameter::value_type<args, API::tag::Enumerator, IdentityEnumerator<Node>>::type Enum;
 
+  typedef ProcessNode<Space, Node, Args...> PN;
+
   typedef typename parameter::value_type<args, API::tag::DepthBoundedPoolPolicy, Workstealing::Policies::DepthPoolPolicy>::type Policy;
 
   static void printSkeletonDetails() {
@@ -56,12 +73,17 @@ struct Random {
     }
     if constexpr (std::is_same<Policy, Workstealing::Policies::Workpool>::value) {
         hpx::cout << "Workpool: Deque\n";
+      } else if constexpr (std::is_same<Policy, Workstealing::Policies::PerThreadWorkpool>::value) {
+        hpx::cout << "Workpool: PerThreadDeque\n";
       } else {
       hpx::cout << "Workpool: DepthPool\n";
     }
     hpx::cout << hpx::flush;
   }
 
+  // Nodes between adaptive spawn probability updates
+  static constexpr unsigned spawnRateUpdateInterval = 4096;
+
   static void expand(const Space & space,
                      const Node & n,
                      const API::Params<Bound> & params,
@@ -71,28 +93,38 @@ struct Random {
     auto reg = Registry<Space, Node, Bound, Enum>::gReg;
 
     auto depth = childDepth;
-    
+
+    const auto adaptive = params.adaptiveSpawnProbability;
+    auto spawnThreshold = adaptive ? util::AdaptiveSpawnRate::threshold()
+                                   : util::AdaptiveSpawnRate::thresholdFor(params.spawnProbability);
+    auto untilUpdate = spawnRateUpdateInterval;
+
     // Init the stack
     StackElem<Generator> initElem(space, n);
     GeneratorStack<Generator> genStack(maxStackDepth, initElem);
 
     // Count the initial element
     if (isEnumeration) {
-      acc.accumulate(n);
+      accumulateNode(acc, n, childDepth - 1);
     }
 
     auto stackDepth = 0;
     while (stackDepth >= 0) {
 
       if constexpr(isDecision) {
-        if (reg->stopSearch) {
+        if (reg->shouldStop()) {
           return;
         }
       }
       
-      if (params.spawnProbability != 0) {
-	unsigned sp = (rand()<<15)+rand();
-        if (sp < 1073741824/params.spawnProbability) {
+      if (adaptive && --untilUpdate == 0) {
+        untilUpdate = spawnRateUpdateInterval;
+        util::AdaptiveSpawnRate::update();
+        spawnThreshold = util::AdaptiveSpawnRate::threshold();
+      }
+
+      if (spawnThreshold != 0) {
+        if (util::threadRandom() < spawnThreshold) {
           // get all nodes of the highest depth
           for (auto i = 0; i < stackDepth; ++i) {
             if (genStack[i].seen < genStack[i].gen.numChildren) {
@@ -108,12 +140,22 @@ struct Random {
 
       // If there's still children at this stackDepth we move into them
       if (genStack[stackDepth].seen < genStack[stackDepth].gen.numChildren) {
-        genStack[stackDepth + 1].node = genStack[stackDepth].gen.next();
+        auto pb = PN::preProcessChild(params, genStack[stackDepth].gen, genStack[stackDepth].seen, depth + 1, acc);
+        if (pb == ProcessNodeRet::Prune) {
+          genStack[stackDepth].seen++;
+          continue;
+        } else if (pb == ProcessNodeRet::Break) {
+          stackDepth--;
+          depth--;
+          continue;
+        }
+
+        nextChildInto(genStack[stackDepth].gen, genStack[stackDepth + 1].node);
         const auto & child = genStack[stackDepth + 1].node;
 
         genStack[stackDepth].seen++;
 
-        auto pn = ProcessNode<Space, Node, Args...>::processNode(params, space, child, acc);
+        auto pn = PN::processNode(params, space, child, depth, acc, PN::template batchedBounds<Generator>);
         if (pn == ProcessNodeRet::Exit) { return; }
         else if (pn == ProcessNodeRet::Prune) { continue; }
         else if (pn == ProcessNodeRet::Break) {
@@ -123,7 +165,6 @@ struct Random {
         }
 
         // Going down
-        const auto childGen = Generator(space, child);
         stackDepth++;
         depth++;
 
@@ -138,7 +179,7 @@ struct Random {
         }
 
         genStack[stackDepth].seen = 0;
-        genStack[stackDepth].gen = childGen;
+        resetGenerator(genStack[stackDepth].gen, space, child);
       } else {
         stackDepth--;
         depth--;
@@ -150,11 +191,12 @@ struct Random {
                           const unsigned childDepth,
                           const hpx::naming::id_type donePromiseId) {
     auto reg = Registry<Space, Node, Bound, Enum>::gReg;
+    const auto & space = reg->localSpace();
 
     Enum acc;
 
     std::vector<hpx::future<void> > childFutures;
-    expand(reg->space, taskRoot, reg->params, acc, childFutures, childDepth);
+    expand(space, taskRoot, reg->params, acc, childFutures, childDepth);
 
     // Atomically updates the (process) local counter
     if constexpr (isEnumeration) {
@@ -163,7 +205,7 @@ struct Random {
 
     hpx::apply(hpx::util::bind([=](std::vector<hpx::future<void> > & futs) {
           hpx::wait_all(futs);
-          hpx::async<hpx::lcos::base_lco_with_value<void>::set_value_action>(donePromiseId, true);
+          util::CompletionAggregator::complete(donePromiseId);
         }, std::move(childFutures)));
   }
 
@@ -175,13 +217,14 @@ struct Random {
 
     Random_::SubtreeTask<Generator, Args...> t;
     hpx::util::function<void(hpx::naming::id_type)> task;
-    task = hpx::util::bind(t, hpx::util::placeholders::_1, taskRoot, childDepth, pid);
+    task = util::TaskPool::pooledTask(hpx::util::bind(t, hpx::util::placeholders::_1, taskRoot, childDepth, pid));
 
     auto workPool = std::static_pointer_cast<Policy>(Workstealing::Scheduler::local_policy);
-    if constexpr (std::is_same<Policy, Workstealing::Policies::Workpool>::value) {
-      workPool->addwork(task);
+    if constexpr (std::is_same<Policy, Workstealing::Policies::Workpool>::value ||
+                  std::is_same<Policy, Workstealing::Policies::PerThreadWorkpool>::value) {
+      workPool->addwork(std::move(task));
     } else {
-      workPool->addwork(task, childDepth - 1);
+      workPool->addwork(std::move(task), childDepth - 1);
     }
 
     return pfut;
@@ -189,25 +232,47 @@ struct Random {
 
   static auto search (const Space & space,
                       const Node & root,
-                      const API::Params<Bound> params = API::Params<Bound>()) {
+                      API::Params<Bound> params = API::Params<Bound>()) {
+    API::rejectCheckpoints(params, "BasicRandom");
+
+    SearchContext ctx;
+
+    if constexpr(verbose > 1) {
+      Workstealing::StealStats::setEnabledEverywhere(true);
+    }
+
+    if (params.autoTune) {
+      util::autoTune<Generator, isDepthBounded>(space, root, params, verbose);
+    }
+
     if constexpr (verbose) {
       printSkeletonDetails();
     }
 
-    hpx::wait_all(hpx::lcos::broadcast<InitRegistryAct<Space, Node, Bound, Enum> >(
-        hpx::find_all_localities(), space, root, params));
+    initRegistries<Space, Node, Bound, Enum>(space, root, params);
+
+    PN::initSearch(params);
 
-    Policy::initPolicy();
+    if constexpr(std::is_same<Policy, Workstealing::Policies::DepthPoolPolicy>::value) {
+      // Tasks are pooled at their parent's depth, below maxDepth when depth limited
+      Policy::initPolicy(false, params.maxDepth);
+    } else {
+      Policy::initPolicy();
+    }
+
+    if (params.adaptiveSpawnProbability) {
+      hpx::wait_all(hpx::lcos::broadcast<util::AdaptiveSpawnRate::reset_act>(
+          hpx::find_all_localities(), params.spawnProbability));
+    }
 
-    auto threadCount = hpx::get_os_thread_count() == 1 ? 1 : hpx::get_os_thread_count() - 1;
-    hpx::wait_all(hpx::lcos::broadcast<Workstealing::Scheduler::startSchedulers_act>(
-        hpx::find_all_localities(), threadCount));
+    hpx::wait_all(hpx::lcos::broadcast<Workstealing::Scheduler::startLocalSchedulers_act>(
+        hpx::find_all_localities()));
 
     if constexpr(isOptimisation || isDecision) {
       auto inc = hpx::new_<Incumbent>(hpx::find_here()).get();
       hpx::wait_all(hpx::lcos::broadcast<UpdateGlobalIncumbentAct<Space, Node, Bound, Enum> >(
           hpx::find_all_localities(), inc));
-      initIncumbent<Space, Node, Bound, Enum, Objcmp, Verbose>(root, params.initialBound);
+      PN::initIncumbent(root, params);
     }
 
     createTask(1, root).get();
@@ -215,14 +280,25 @@ struct Random {
     hpx::wait_all(hpx::lcos::broadcast<Workstealing::Scheduler::stopSchedulers_act>(
         hpx::find_all_localities()));
 
+    if constexpr (verbose >= 2) {
+      Workstealing::WorkerStates::printAllReports();
+    }
+
+    if constexpr (verbose >= 3) {
+      Workstealing::StealStats::printAllReports();
+    }
+
+    if (verbose && params.adaptiveSpawnProbability) {
+      util::printOnEachLocality<util::AdaptiveSpawnRate::printReport_act>();
+    }
+
+    PN::printReports();
+
     // Return the right thing
     if constexpr(isEnumeration) {
       return combineEnumerators<Space, Node, Bound, Enum>();
     } else if constexpr(isOptimisation || isDecision) {
-      auto reg = Registry<Space, Node, Bound, Enum>::gReg;
-
-      typedef typename Incumbent::GetIncumbentAct<Node, Bound, Objcmp, Verbose> getInc;
-      return hpx::async<getInc>(reg->globalIncumbent).get();
+      return getFinalIncumbent<Space, Node, Bound, Enum, Objcmp, Verbose, lazyIncumbent>();
     } else {
       static_assert(isEnumeration || isOptimisation || isDecision, "Please provide a supported search type: Enumeration, Optimisation, Decision");
     }
@@ -0,0 +1,466 @@
+#ifndef SKELETONS_BESTFIRST_HPP
+#define SKELETONS_BESTFIRST_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include <hpx/lcos/broadcast.hpp>
+#include <hpx/lcos/local/mutex.hpp>
+#include <hpx/include/iostreams.hpp>
+#include <hpx/include/threads.hpp>
+#include <hpx/runtime/serialization/vector.hpp>
+
+#include <boost/format.hpp>
+
+#include "API.hpp"
+
+#include "util/NodeGenerator.hpp"
+#include "util/Registry.hpp"
+#include "util/Incumbent.hpp"
+#include "util/func.hpp"
+#include "util/util.hpp"
+
+#include "Common.hpp"
+#include "DepthFirst.hpp"
+
+#include "workstealing/Scheduler.hpp"
+#include "workstealing/Termination.hpp"
+
+namespace YewPar { namespace Skeletons {
+
+namespace BestFirst_ {
+template <typename Generator, typename ...Args>
+struct StartWorkersAct;
+template <typename Generator, typename ...Args>
+struct StopWorkersAct;
+template <typename Generator, typename ...Args>
+struct StealBestAct;
+template <typename Generator, typename ...Args>
+struct ReceiveNodesAct;
+template <typename Generator, typename ...Args>
+struct PrintReportAct;
+}
+
+// Best-first branch and bound. Every locality keeps a priority queue (the frontier) of open nodes
+// ordered by BoundFunction, and its workers always expand the most promising local node. Children
+// go back into the frontier until it holds Params::maxFrontierSize nodes, after which they are
+// searched depth first, keeping memory bounded. Localities with an empty frontier take the best
+// nodes of a random other locality, and every Params::frontierExchangeInterval expansions a worker
+// sends its locality's best node to a random other locality so good nodes spread out.
+//
+// Incumbents go through the usual Registry machinery. Termination is detected by counting nodes
+// added to and expanded from the frontiers (see Termination.hpp).
+template <typename Generator, typename ...Args>
+struct BestFirst {
+  typedef typename Generator::Nodetype Node;
+  typedef typename Generator::Spacetype Space;
+
+  static_assert(isNodeGenerator<Generator>::value,
+                "Generator needs Nodetype, Spacetype, numChildren, next() and a (Space, Node) constructor");
+
+  typedef typename API::skeleton_signature::bind<Args...>::type args;
+
+  static constexpr bool isEnumeration = parameter::value_type<args, API::tag::Enumeration_, std::integral_constant<bool, false> >::type::value;
+  static constexpr bool isOptimisation = parameter::value_type<args, API::tag::Optimisation_, std::integral_constant<bool, false> >::type::value;
+  static constexpr bool isDecision = parameter::value_type<args, API::tag::Decision_, std::integral_constant<bool, false> >::type::value;
+  static constexpr bool isDepthBounded = parameter::value_type<args, API::tag::DepthLimited_, std::integral_constant<bool, false> >::type::value;
+  static constexpr bool pruneLevel = parameter::value_type<args, API::tag::PruneLevel_, std::integral_constant<bool, false> >::type::value;
+  static constexpr bool lazyIncumbent = parameter::value_type<args, API::tag::LazyIncumbent_, std::integral_constant<bool, false> >::type::value;
+  static constexpr unsigned maxStackDepth = parameter::value_type<args, API::tag::MaxStackDepth, std::integral_constant<unsigned, 5000> >::type::value;
+
+  typedef typename parameter::value_type<args, API::tag::Verbose_, std::integral_constant<unsigned, 0> >::type Verbose;
+  static constexpr unsigned verbose = Verbose::value;
+
+  typedef typename parameter::value_type<args, API::tag::BoundFunction, nullFn__>::type boundFn;
+  typedef typename boundFn::return_type Bound;
+  typedef typename parameter::value_type<args, API::tag::ObjectiveComparison, std::greater<Bound> >::type Objcmp;
+  typedef typename parameter::value_type<args, API::tag::Enumerator, IdentityEnumerator<Node>>::type Enum;
+
+  typedef ProcessNode<Space, Node, Args...> PN;
+
+  static_assert(!std::is_same<boundFn, nullFn__>::value, "BestFirst needs a BoundFunction to order nodes by");
+  static_assert(isOptimisation || isDecision, "BestFirst supports Optimisation and Decision searches");
+
+  struct FrontierNode {
+    Bound bnd;
+    Node node;
+    // Depth of node's children, as in DepthBounded
+    unsigned depth;
+
+    template <class Archive>
+    void serialize(Archive & ar, const unsigned int version) {
+      ar & bnd;
+      ar & node;
+      ar & depth;
+    }
+  };
+
+  // The best bound comes out of the priority queue first
+  struct WorseBound {
+    bool operator()(const FrontierNode & a, const FrontierNode & b) const {
+      Objcmp cmp;
+      return cmp(b.bnd, a.bnd);
+    }
+  };
+
+  // Per locality state
+  struct Frontier {
+    hpx::lcos::local::mutex mtx;
+    std::priority_queue<FrontierNode, std::vector<FrontierNode>, WorseBound> queue;
+    std::atomic<std::uint64_t> size {0};
+
+    std::atomic<bool> running {false};
+    std::vector<hpx::future<void> > workers;
+
+    // Only one outstanding remote steal per locality
+    std::atomic<bool> stealing {false};
+
+    std::atomic<std::uint64_t> expansions {0};
+    std::atomic<std::uint64_t> depthFirstFallbacks {0};
+    std::atomic<std::uint64_t> remoteSteals {0};
+    std::atomic<std::uint64_t> nodesShared {0};
+    std::atomic<std::uint64_t> maxSize {0};
+  };
+
+  static Frontier & frontier() {
+    static Frontier f;
+    return f;
+  }
+
+  static void printSkeletonDetails(const API::Params<Bound> & params) {
+    hpx::cout << "Skeleton Type: BestFirst\n";
+    hpx::cout << "Optimisation: " << std::boolalpha << isOptimisation << "\n";
+    hpx::cout << "Decision: " << std::boolalpha << isDecision << "\n";
+    hpx::cout << "DepthBounded: " << std::boolalpha << isDepthBounded << "\n";
+    hpx::cout << "PruneLevel Optimisation: " << std::boolalpha << pruneLevel << "\n";
+    hpx::cout << "Max Frontier Size: " << params.maxFrontierSize << "\n";
+    hpx::cout << "Frontier Exchange Interval: " << params.frontierExchangeInterval << "\n";
+    hpx::cout << hpx::flush;
+  }
+
+  // Could anything below a node with this bound still beat the incumbent?
+  static bool promising(const Bound & bnd) {
+    auto reg = Registry<Space, Node, Bound, Enum>::gReg;
+    Objcmp cmp;
+    if constexpr(isDecision) {
+      return cmp(bnd, reg->params.expectedObjective) || bnd == reg->params.expectedObjective;
+    } else {
+      return cmp(bnd, reg->localBound.load(std::memory_order_relaxed));
+    }
+  }
+
+  // Nodes coming from another locality are already counted as spawned
+  static void push(std::vector<FrontierNode> nodes) {
+    auto & f = frontier();
+    std::uint64_t size;
+    {
+      std::lock_guard<hpx::lcos::local::mutex> l(f.mtx);
+      for (auto & n : nodes) {
+        f.queue.push(std::move(n));
+      }
+      size = f.queue.size();
+    }
+    f.size.store(size, std::memory_order_relaxed);
+    if (size > f.maxSize.load(std::memory_order_relaxed)) {
+      f.maxSize.store(size, std::memory_order_relaxed);
+    }
+  }
+
+  static void pushNew(const Node & n, const Bound & bnd, const unsigned depth) {
+    Workstealing::Termination::taskSpawned();
+    push({FrontierNode {bnd, n, depth}});
+  }
+
+  static std::vector<FrontierNode> pop(const std::size_t max) {
+    auto & f = frontier();
+    std::vector<FrontierNode> res;
+    std::lock_guard<hpx::lcos::local::mutex> l(f.mtx);
+    while (!f.queue.empty() && res.size() < max) {
+      res.push_back(f.queue.top());
+      f.queue.pop();
+    }
+    f.size.store(f.queue.size(), std::memory_order_relaxed);
+    return res;
+  }
+
+  // Remote side of a steal: hand over our best nodes, keeping at least half the frontier
+  static std::vector<FrontierNode> stealBest(const unsigned max) {
+    auto & f = frontier();
+    auto take = std::min<std::uint64_t>(max, f.size.load(std::memory_order_relaxed) / 2);
+    return take == 0 ? std::vector<FrontierNode>() : pop(take);
+  }
+
+  static void receiveNodes(std::vector<FrontierNode> nodes) {
+    push(std::move(nodes));
+  }
+
+  static hpx::naming::id_type randomOtherLocality(std::mt19937 & rng) {
+    auto others = util::findOtherLocalities();
+    std::uniform_int_distribution<std::size_t> dist(0, others.size() - 1);
+    return others[dist(rng)];
+  }
+
+  static bool stealRemote(std::mt19937 & rng) {
+    auto & f = frontier();
+    if (hpx::get_num_localities(hpx::launch::sync) <= 1 || f.stealing.exchange(true)) {
+      return false;
+    }
+
+    auto victim = randomOtherLocality(rng);
+    auto nodes = hpx::async<BestFirst_::StealBestAct<Generator, Args...> >(
+        victim, Workstealing::Scheduler::localWorkers()).get();
+    f.stealing.store(false);
+
+    if (nodes.empty()) {
+      return false;
+    }
+    f.remoteSteals++;
+    push(std::move(nodes));
+    return true;
+  }
+
+  static void shareBest(std::mt19937 & rng) {
+    auto & f = frontier();
+    if (hpx::get_num_localities(hpx::launch::sync) <= 1 || f.size.load(std::memory_order_relaxed) < 2) {
+      return;
+    }
+    auto nodes = pop(1);
+    if (!nodes.empty()) {
+      f.nodesShared++;
+      hpx::apply<BestFirst_::ReceiveNodesAct<Generator, Args...> >(randomOtherLocality(rng), std::move(nodes));
+    }
+  }
+
+  static void expand(const FrontierNode & fn) {
+    auto reg = Registry<Space, Node, Bound, Enum>::gReg;
+    const auto & space = reg->localSpace();
+    const auto & params = reg->params;
+    auto & f = frontier();
+    Enum acc;
+
+    if constexpr(isDepthBounded) {
+      if (fn.depth == params.maxDepth) {
+        return;
+      }
+    }
+
+    auto visitDepthFirst = [&](const Node & c, const unsigned depth) {
+      if constexpr(isDecision) {
+        if (reg->shouldStop()) {
+          return ProcessNodeRet::Exit;
+        }
+      }
+      return PN::processNode(params, space, c, depth - 1, acc, PN::template batchedBounds<Generator>);
+    };
+    auto preVisit = [&](Generator & gen, const unsigned i, const unsigned depth) {
+      return PN::preProcessChild(params, gen, i, depth, acc);
+    };
+
+    Generator newCands = Generator(space, fn.node);
+    for (auto i = 0; i < newCands.numChildren; ++i) {
+      auto pb = PN::preProcessChild(params, newCands, i, fn.depth + 1, acc);
+      if (pb == ProcessNodeRet::Prune) { continue; }
+      else if (pb == ProcessNodeRet::Break) { break; }
+
+      auto c = newCands.next();
+
+      auto pn = PN::processNode(params, space, c, fn.depth, acc, PN::template batchedBounds<Generator>);
+      if (pn == ProcessNodeRet::Exit) { return; }
+      else if (pn == ProcessNodeRet::Prune) { continue; }
+      else if (pn == ProcessNodeRet::Break) { break; }
+
+      if constexpr(isDepthBounded) {
+        if (fn.depth + 1 == params.maxDepth) {
+          continue;
+        }
+      }
+
+      if (f.size.load(std::memory_order_relaxed) < params.maxFrontierSize) {
+        if constexpr(PN::template batchedBounds<Generator>) {
+          pushNew(c, newCands.childBounds()[i], fn.depth + 1);
+        } else {
+          pushNew(c, boundFn::invoke(space, c), fn.depth + 1);
+        }
+      } else {
+        f.depthFirstFallbacks++;
+        if (expandDepthFirst<Generator, maxStackDepth, isDepthBounded>(
+                space, c, fn.depth + 1, params.maxDepth, visitDepthFirst, preVisit) == ProcessNodeRet::Exit) {
+          return;
+        }
+      }
+    }
+  }
+
+  static void worker() {
+    auto reg = Registry<Space, Node, Bound, Enum>::gReg;
+    auto & f = frontier();
+    std::mt19937 rng(std::random_device{}());
+    std::uint64_t sinceExchange = 0;
+    unsigned idle = 0;
+
+    while (f.running.load(std::memory_order_relaxed)) {
+      auto nodes = pop(1);
+      if (nodes.empty()) {
+        if (stealRemote(rng)) {
+          idle = 0;
+          continue;
+        }
+        if (++idle < 64) {
+          hpx::this_thread::yield();
+        } else {
+          hpx::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        continue;
+      }
+      idle = 0;
+
+      auto & fn = nodes.front();
+      bool stopped = false;
+      if constexpr(isDecision) {
+        stopped = reg->shouldStop();
+      }
+
+      // The incumbent may have improved since the node was added
+      if (!stopped && promising(fn.bnd)) {
+        expand(fn);
+        f.expansions++;
+      }
+      Workstealing::Termination::taskCompleted();
+
+      if (reg->params.frontierExchangeInterval > 0 &&
+          ++sinceExchange >= reg->params.frontierExchangeInterval) {
+        sinceExchange = 0;
+        shareBest(rng);
+      }
+    }
+  }
+
+  // One worker per scheduler this locality would run, localities may differ
+  static void startWorkers() {
+    auto numWorkers = Workstealing::Scheduler::localWorkers();
+    auto & f = frontier();
+    {
+      std::lock_guard<hpx::lcos::local::mutex> l(f.mtx);
+      f.queue = decltype(f.queue)();
+    }
+    f.size = 0;
+    f.maxSize = 0;
+    f.expansions = 0;
+    f.depthFirstFallbacks = 0;
+    f.remoteSteals = 0;
+    f.nodesShared = 0;
+    f.running = true;
+
+    for (unsigned i = 0; i < numWorkers; ++i) {
+      auto exe = Workstealing::Scheduler::workerExecutor(i, hpx::threads::thread_priority_normal);
+      f.workers.push_back(hpx::async(exe, &worker));
+    }
+  }
+
+  static void stopWorkers() {
+    auto & f = frontier();
+    f.running = false;
+    hpx::wait_all(f.workers);
+    f.workers.clear();
+
+    // Anything left was stopped early (decision) and can go
+    std::lock_guard<hpx::lcos::local::mutex> l(f.mtx);
+    f.queue = decltype(f.queue)();
+    f.size = 0;
+  }
+
+  static void printReport() {
+    auto & f = frontier();
+    hpx::cout
+        << (boost::format("%1% BestFirst: %2% expansions, max frontier %3%, %4% depth first fallbacks, %5% remote steals, %6% nodes shared")
+            % static_cast<std::int64_t>(hpx::get_locality_id())
+            % f.expansions.load()
+            % f.maxSize.load()
+            % f.depthFirstFallbacks.load()
+            % f.remoteSteals.load()
+            % f.nodesShared.load())
+        << hpx::endl;
+  }
+
+  static auto search (const Space & space,
+                      const Node & root,
+                      const API::Params<Bound> params = API::Params<Bound>()) {
+    API::rejectCheckpoints(params, "BestFirst");
+
+    SearchContext ctx;
+
+    if constexpr(verbose) {
+      printSkeletonDetails(params);
+    }
+
+    initRegistries<Space, Node, Bound, Enum>(space, root, params);
+
+    PN::initSearch(params);
+
+    hpx::wait_all(hpx::lcos::broadcast<Workstealing::Termination::reset_act>(hpx::find_all_localities()));
+
+    auto inc = hpx::new_<Incumbent>(hpx::find_here()).get();
+    hpx::wait_all(hpx::lcos::broadcast<UpdateGlobalIncumbentAct<Space, Node, Bound, Enum> >(
+        hpx::find_all_localities(), inc));
+    PN::initIncumbent(root, params);
+
+    hpx::wait_all(hpx::lcos::broadcast<BestFirst_::StartWorkersAct<Generator, Args...> >(
+        hpx::find_all_localities()));
+
+    pushNew(root, boundFn::invoke(space, root), 1);
+    Workstealing::Termination::waitForTermination();
+
+    hpx::wait_all(hpx::lcos::broadcast<BestFirst_::StopWorkersAct<Generator, Args...> >(
+        hpx::find_all_localities()));
+
+    if constexpr(verbose > 1) {
+      util::printOnEachLocality<BestFirst_::PrintReportAct<Generator, Args...> >();
+    }
+
+    PN::printReports();
+
+    return getFinalIncumbent<Space, Node, Bound, Enum, Objcmp, Verbose, lazyIncumbent>();
+  }
+};
+
+namespace BestFirst_ {
+template <typename Generator, typename ...Args>
+struct StartWorkersAct : hpx::actions::make_action<
+  decltype(&BestFirst<Generator, Args...>::startWorkers),
+  &BestFirst<Generator, Args...>::startWorkers,
+  StartWorkersAct<Generator, Args...>>::type {};
+
+template <typename Generator, typename ...Args>
+struct StopWorkersAct : hpx::actions::make_action<
+  decltype(&BestFirst<Generator, Args...>::stopWorkers),
+  &BestFirst<Generator, Args...>::stopWorkers,
+  StopWorkersAct<Generator, Args...>>::type {};
+
+template <typename Generator, typename ...Args>
+struct StealBestAct : hpx::actions::make_action<
+  decltype(&BestFirst<Generator, Args...>::stealBest),
+  &BestFirst<Generator, Args...>::stealBest,
+  StealBestAct<Generator, Args...>>::type {};
+
+template <typename Generator, typename ...Args>
+struct ReceiveNodesAct : hpx::actions::make_action<
+  decltype(&BestFirst<Generator, Args...>::receiveNodes),
+  &BestFirst<Generator, Args...>::receiveNodes,
+  ReceiveNodesAct<Generator, Args...>>::type {};
+
+template <typename Generator, typename ...Args>
+struct PrintReportAct : hpx::actions::make_action<
+  decltype(&BestFirst<Generator, Args...>::printReport),
+  &BestFirst<Generator, Args...>::printReport,
+  PrintReportAct<Generator, Args...>>::type {};
+}
+
+}}
+
+#endif
@@ -1,10 +1,25 @@
 #ifndef SKELETONS_BUDGET_HPP
 #define SKELETONS_BUDGET_HPP
 
+#include <chrono>
+#include <stdexcept>
+
 #include <hpx/include/iostreams.hpp>
 
 #include <boost/format.hpp>
 
+#include "util/NodeGenerator.hpp"
+#include "workstealing/Termination.hpp"
+#include "workstealing/WorkerStates.hpp"
+#include "workstealing/StealStats.hpp"
+#include "util/AdaptiveBudget.hpp"
+#include "util/TreeEstimator.hpp"
+#include "util/CompletionAggregator.hpp"
+#include "util/MemoryUsage.hpp"
+#include "util/TaskPool.hpp"
+#include "util/util.hpp"
+#include "util/LocalityJoin.hpp"
+
 namespace YewPar { namespace Skeletons {
 
 namespace detail {
@@ -18,6 +33,9 @@ struct Budget {
   typedef typename Generator::Nodetype Node;
   typedef typename Generator::Spacetype Space;
 
+  static_assert(isNodeGenerator<Generator>::value,
+                "Generator needs Nodetype, Spacetype, numChildren, next() and a (Space, Node) constructor");
+
   typedef typename API::skeleton_signature::bind<Args...>::type args;
 
   static constexpr bool isEnumeration = parameter::value_type<args, API::tag::Enumeration_, std::integral_constant<bool, false> >::type::value;
@@ -25,6 +43,8 @@ struct Budget {
   static constexpr bool isDecision = parameter::value_type<args, API::tag::Decision_, std::integral_constant<bool, false> >::type::value;
   static constexpr bool isDepthBounded = parameter::value_type<args, API::tag::DepthLimited_, std::integral_constant<bool, false> >::type::value;
   static constexpr bool pruneLevel = parameter::value_type<args, API::tag::PruneLevel_, std::integral_constant<bool, false> >::type::value;
+  static constexpr bool lazyIncumbent = parameter::value_type<args, API::tag::LazyIncumbent_, std::integral_constant<bool, false> >::type::value;
+  static constexpr bool countTermination = parameter::value_type<args, API::tag::CountTermination_, std::integral_constant<bool, false> >::type::value;
   static constexpr unsigned maxStackDepth = parameter::value_type<args, API::tag::MaxStackDepth, std::integral_constant<unsigned, 5000> >::type::value;
 
   typedef typename parameter::value_type<args, API::tag::Verbose_, std::integral_constant<unsigned, 0> >::type Verbose;
@@ -35,9 +55,15 @@ struct Budget {
   typedef typename parameter::value_type<args, API::tag::ObjectiveComparison, std::greater<Bound> >::type Objcmp;
   typedef typename parameter::value_type<args, API::tag::Enumerator, IdentityEnumerator<Node>>::type Enum;
 
+  typedef ProcessNode<Space, Node, Args...> PN;
+
   typedef typename parameter::value_type<args, API::tag::DepthBoundedPoolPolicy, Workstealing::Policies::DepthPoolPolicy>::type Policy;
 
-  static void printSkeletonDetails() {
+  // Params::boundOrderedPool needs a DepthPool and something to order by
+  static constexpr bool boundOrdered = std::is_same<Policy, Workstealing::Policies::DepthPoolPolicy>::value &&
+      !std::is_same<boundFn, nullFn__>::value;
+
+  static void printSkeletonDetails(const API::Params<Bound> & params) {
     hpx::cout << "Skeleton Type: Budget\n";
     hpx::cout << "Enumeration : " << std::boolalpha << isEnumeration << "\n";
     hpx::cout << "Optimisation: " << std::boolalpha << isOptimisation << "\n";
@@ -50,8 +76,13 @@ struct Budget {
       } else {
       hpx::cout << "Using Bounding: false\n";
     }
+    hpx::cout << "CountTermination: " << std::boolalpha << countTermination << "\n";
+    hpx::cout << "Memory cap (MB): " << params.memoryCapMB << "\n";
+    hpx::cout << "Adaptive Budget: " << std::boolalpha << params.adaptiveBudget << "\n";
     if constexpr (std::is_same<Policy, Workstealing::Policies::Workpool>::value) {
         hpx::cout << "Workpool: Deque\n";
+      } else if constexpr (std::is_same<Policy, Workstealing::Policies::PerThreadWorkpool>::value) {
+        hpx::cout << "Workpool: PerThreadDeque\n";
       } else {
       hpx::cout << "Workpool: DepthPool\n";
     }
@@ -66,8 +97,16 @@ struct Budget {
                      const unsigned childDepth) {
     auto reg = Registry<Space, Node, Bound, Enum>::gReg;
 
+    // Tasks drained after a decision search succeeds shouldn't build a stack
+    if constexpr(isDecision) {
+      if (reg->shouldStop()) {
+        return;
+      }
+    }
+
     auto depth = childDepth;
     auto backtracks = 0;
+    auto budget = params.adaptiveBudget ? util::AdaptiveBudget::current() : params.backtrackBudget;
 
     // Init the stack
     StackElem<Generator> initElem(space, n);
@@ -75,40 +114,59 @@ struct Budget {
 
     // Count the initial element
     if (isEnumeration) {
-      acc.accumulate(n);
+      accumulateNode(acc, n, childDepth - 1);
     }
 
     auto stackDepth = 0;
     while (stackDepth >= 0) {
 
       if constexpr(isDecision) {
-        if (reg->stopSearch) {
+        if (reg->shouldStop()) {
           return;
         }
       }
 
-      // We spawn when we have exhausted our backtrack budget
-      if (backtracks == params.backtrackBudget) {
+      // We spawn when we have exhausted our backtrack budget, unless over the memory cap where we
+      // keep searching them here
+      if (backtracks >= budget) {
         // Spawn everything at the highest possible depth
-        for (auto i = 0; i < stackDepth; ++i) {
-          if (genStack[i].seen < genStack[i].gen.numChildren) {
-            while (genStack[i].seen < genStack[i].gen.numChildren) {
-              genStack[i].seen++;
-              childFutures.push_back(createTask(childDepth + i + 1, genStack[i].gen.next()));
+        if (!util::MemoryUsage::overCap()) {
+          for (auto i = 0; i < stackDepth; ++i) {
+            if (genStack[i].seen < genStack[i].gen.numChildren) {
+              while (genStack[i].seen < genStack[i].gen.numChildren) {
+                genStack[i].seen++;
+                spawnChild(childFutures, childDepth + i + 1, genStack[i].gen.next());
+              }
             }
           }
         }
         backtracks = 0;
+
+        // Long running tasks pick up any change made since they started
+        if (params.adaptiveBudget) {
+          budget = util::AdaptiveBudget::current();
+        }
       }
 
       // If there's still children at this stackDepth we move into them
       if (genStack[stackDepth].seen < genStack[stackDepth].gen.numChildren) {
-        genStack[stackDepth + 1].node = genStack[stackDepth].gen.next();
+        auto pb = PN::preProcessChild(params, genStack[stackDepth].gen, genStack[stackDepth].seen, depth + 1, acc);
+        if (pb == ProcessNodeRet::Prune) {
+          genStack[stackDepth].seen++;
+          continue;
+        } else if (pb == ProcessNodeRet::Break) {
+          stackDepth--;
+          depth--;
+          backtracks++;
+          continue;
+        }
+
+        nextChildInto(genStack[stackDepth].gen, genStack[stackDepth + 1].node);
         const auto & child = genStack[stackDepth + 1].node;
 
         genStack[stackDepth].seen++;
 
-        auto pn = ProcessNode<Space, Node, Args...>::processNode(params, space, child, acc);
+        auto pn = PN::processNode(params, space, child, depth, acc, PN::template batchedBounds<Generator>);
         if (pn == ProcessNodeRet::Exit) { return; }
         else if (pn == ProcessNodeRet::Prune) { continue; }
         else if (pn == ProcessNodeRet::Break) {
@@ -119,7 +177,6 @@ struct Budget {
         }
 
         // Going down
-        const auto childGen = Generator(space, child);
         stackDepth++;
         depth++;
 
@@ -135,7 +192,7 @@ struct Budget {
         }
 
         genStack[stackDepth].seen = 0;
-        genStack[stackDepth].gen = childGen;
+        resetGenerator(genStack[stackDepth].gen, space, child);
       } else {
         stackDepth--;
         depth--;
@@ -148,79 +205,206 @@ struct Budget {
                           const unsigned childDepth,
                           const hpx::naming::id_type donePromiseId) {
     auto reg = Registry<Space, Node, Bound, Enum>::gReg;
+    const auto & space = reg->localSpace();
+
+    util::TaskTrace::ScopedTask trace(childDepth, childDepth == 1 ? util::TaskTrace::Origin::Root
+                                      : util::TaskTrace::originOf(false, donePromiseId));
 
     Enum acc;
 
     std::vector<hpx::future<void> > childFutures;
-    expand(reg->space, taskRoot, reg->params, acc, childFutures, childDepth);
+    if (boundOrdered && reg->params.boundOrderedPool &&
+        PN::prunedSinceSpawn(reg->params, space, taskRoot)) {
+      // Nothing left to search
+    } else if (reg->params.adaptiveBudget) {
+      auto start = std::chrono::steady_clock::now();
+      expand(space, taskRoot, reg->params, acc, childFutures, childDepth);
+      util::AdaptiveBudget::taskFinished(std::chrono::steady_clock::now() - start);
+    } else {
+      expand(space, taskRoot, reg->params, acc, childFutures, childDepth);
+    }
 
     // Atomically updates the (process) local counter
     if constexpr (isEnumeration) {
       reg->updateEnumerator(acc);
     }
 
+    if constexpr(countTermination) {
+      Workstealing::Termination::taskCompleted();
+      return;
+    }
+
     hpx::apply(hpx::util::bind([=](std::vector<hpx::future<void> > & futs) {
           hpx::wait_all(futs);
-          hpx::async<hpx::lcos::base_lco_with_value<void>::set_value_action>(donePromiseId, true);
+          util::MemoryUsage::add(util::MemoryUsage::Futures,
+                                 -static_cast<std::int64_t>(futs.size()) * util::MemoryUsage::futureBytes);
+          util::CompletionAggregator::complete(donePromiseId);
         }, std::move(childFutures)));
   }
 
+  static void addTask(const unsigned childDepth,
+                      const Node & taskRoot,
+                      const hpx::naming::id_type donePromiseId) {
+    detail::BudgetSubtreeTask<Generator, Args...> t;
+    hpx::util::function<void(hpx::naming::id_type)> task;
+    task = util::TaskPool::pooledTask(hpx::util::bind(t, hpx::util::placeholders::_1, taskRoot, childDepth, donePromiseId));
+
+    auto workPool = std::static_pointer_cast<Policy>(Workstealing::Scheduler::local_policy);
+    if constexpr (std::is_same<Policy, Workstealing::Policies::Workpool>::value ||
+                  std::is_same<Policy, Workstealing::Policies::PerThreadWorkpool>::value) {
+      workPool->addwork(std::move(task));
+    } else {
+      if constexpr(boundOrdered) {
+        auto reg = Registry<Space, Node, Bound, Enum>::gReg;
+        if (reg->params.boundOrderedPool) {
+          workPool->addwork(std::move(task), childDepth - 1, PN::priority(reg->localSpace(), taskRoot));
+          return;
+        }
+      }
+      workPool->addwork(std::move(task), childDepth - 1);
+    }
+  }
+
+  // Spawn a child task, either tracked by a promise or counted for termination detection
+  static void spawnChild(std::vector<hpx::future<void> > & childFutures,
+                         const unsigned childDepth,
+                         const Node & taskRoot) {
+    if constexpr(countTermination) {
+      Workstealing::Termination::taskSpawned();
+      addTask(childDepth, taskRoot, hpx::invalid_id);
+    } else {
+      childFutures.push_back(createTask(childDepth, taskRoot));
+      util::MemoryUsage::add(util::MemoryUsage::Futures, util::MemoryUsage::futureBytes);
+    }
+  }
+
   static hpx::future<void> createTask(const unsigned childDepth,
                                       const Node & taskRoot) {
     hpx::lcos::promise<void> prom;
     auto pfut = prom.get_future();
     auto pid  = prom.get_id();
 
-    detail::BudgetSubtreeTask<Generator, Args...> t;
-    hpx::util::function<void(hpx::naming::id_type)> task;
-    task = hpx::util::bind(t, hpx::util::placeholders::_1, taskRoot, childDepth, pid);
+    addTask(childDepth, taskRoot, pid);
 
-    auto workPool = std::static_pointer_cast<Policy>(Workstealing::Scheduler::local_policy);
-    if constexpr (std::is_same<Policy, Workstealing::Policies::Workpool>::value) {
-      workPool->addwork(task);
-    } else {
-      workPool->addwork(task, childDepth - 1);
+    return pfut;
+  }
+
+  // Params::joinPollMillis: set loc up for the running search and start its schedulers
+  static void joinLocality(const hpx::naming::id_type & loc,
+                           const Space & space,
+                           const Node & root,
+                           const API::Params<Bound> & params) {
+    PN::initJoinedLocality(loc, space, root, params);
+
+    if (params.adaptiveBudget) {
+      hpx::async<util::AdaptiveBudget::reset_act>(loc, params.backtrackBudget, params.budgetTargetTaskMicros).get();
     }
 
-    return pfut;
+    hpx::async<util::MemoryUsage::reset_act>(loc, static_cast<std::uint64_t>(params.memoryCapMB) << 20).get();
+
+    Policy::joinLocality(loc);
+    hpx::async<Workstealing::Scheduler::startLocalSchedulers_act>(loc).get();
   }
 
   static auto search (const Space & space,
                       const Node & root,
-                      const API::Params<Bound> params = API::Params<Bound>()) {
+                      API::Params<Bound> params = API::Params<Bound>()) {
+    // Tasks don't record their stacks when paused, see DepthBounded for checkpoints
+    API::rejectCheckpoints(params, "Budget");
+
+    SearchContext ctx;
+
+    if constexpr(verbose > 1) {
+      Workstealing::StealStats::setEnabledEverywhere(true);
+    }
+
+    if (params.autoTune) {
+      util::autoTune<Generator, isDepthBounded>(space, root, params, verbose);
+    }
+
     if constexpr (verbose) {
-      printSkeletonDetails();
+      printSkeletonDetails(params);
+    }
+
+    initRegistries<Space, Node, Bound, Enum>(space, root, params);
+
+    PN::initSearch(params);
+    util::TaskTrace::begin(params.traceFile, params.traceBufferSize);
+
+    if (params.adaptiveBudget) {
+      hpx::wait_all(hpx::lcos::broadcast<util::AdaptiveBudget::reset_act>(
+          hpx::find_all_localities(), params.backtrackBudget, params.budgetTargetTaskMicros));
     }
 
-    hpx::wait_all(hpx::lcos::broadcast<InitRegistryAct<Space, Node, Bound, Enum> >(
-        hpx::find_all_localities(), space, root, params));
+    hpx::wait_all(hpx::lcos::broadcast<util::MemoryUsage::reset_act>(
+        hpx::find_all_localities(), static_cast<std::uint64_t>(params.memoryCapMB) << 20));
 
-    Policy::initPolicy();
+    if constexpr(std::is_same<Policy, Workstealing::Policies::DepthPoolPolicy>::value) {
+      // Tasks are pooled at their parent's depth, below maxDepth when depth limited
+      Policy::initPolicy(boundOrdered && params.boundOrderedPool, params.maxDepth);
+    } else {
+      Policy::initPolicy();
+    }
 
-    auto threadCount = hpx::get_os_thread_count() == 1 ? 1 : hpx::get_os_thread_count() - 1;
-    hpx::wait_all(hpx::lcos::broadcast<Workstealing::Scheduler::startSchedulers_act>(
-        hpx::find_all_localities(), threadCount));
+    if constexpr(countTermination) {
+      hpx::wait_all(hpx::lcos::broadcast<Workstealing::Termination::reset_act>(hpx::find_all_localities()));
+    }
+
+    hpx::wait_all(hpx::lcos::broadcast<Workstealing::Scheduler::startLocalSchedulers_act>(
+        hpx::find_all_localities()));
 
     if constexpr(isOptimisation || isDecision) {
       auto inc = hpx::new_<Incumbent>(hpx::find_here()).get();
       hpx::wait_all(hpx::lcos::broadcast<UpdateGlobalIncumbentAct<Space, Node, Bound, Enum> >(
           hpx::find_all_localities(), inc));
-      initIncumbent<Space, Node, Bound, Enum, Objcmp, Verbose>(root, params.initialBound);
+      PN::initIncumbent(root, params);
     }
 
-    createTask(1, root).get();
+    if constexpr(countTermination) {
+      Workstealing::Termination::taskSpawned();
+      addTask(1, root, hpx::invalid_id);
+      Workstealing::Termination::waitForTermination();
+    } else {
+      util::LocalityWatcher joins(params.joinPollMillis, [&](const hpx::naming::id_type & loc) {
+        joinLocality(loc, space, root, params);
+      });
+      createTask(1, root).get();
+      joins.stop();
+      if constexpr(verbose) {
+        if (joins.joined() > 0) {
+          hpx::cout << (boost::format("Localities joined during the search: %1%\n") % joins.joined())
+                    << hpx::flush;
+        }
+      }
+    }
 
     hpx::wait_all(hpx::lcos::broadcast<Workstealing::Scheduler::stopSchedulers_act>(
         hpx::find_all_localities()));
 
+    if constexpr (verbose >= 2) {
+      Workstealing::WorkerStates::printAllReports();
+    }
+
+    if constexpr (verbose >= 3) {
+      Workstealing::StealStats::printAllReports();
+    }
+
+    if (verbose >= 2 || (params.memoryCapMB > 0 && verbose)) {
+      util::printOnEachLocality<util::MemoryUsage::printReport_act>();
+    }
+
+    if (params.adaptiveBudget) {
+      util::printOnEachLocality<util::AdaptiveBudget::printReport_act>();
+    }
+
+    util::TaskTrace::end(params.traceFile);
+    PN::printReports();
+
     // Return the right thing
     if constexpr(isEnumeration) {
       return combineEnumerators<Space, Node, Bound, Enum>();
     } else if constexpr(isOptimisation || isDecision) {
-      auto reg = Registry<Space, Node, Bound, Enum>::gReg;
-
-      typedef typename Incumbent::GetIncumbentAct<Node, Bound, Objcmp, Verbose> getInc;
-      return hpx::async<getInc>(reg->globalIncumbent).get();
+      return getFinalIncumbent<Space, Node, Bound, Enum, Objcmp, Verbose, lazyIncumbent>();
     } else {
       static_assert(isEnumeration || isOptimisation || isDecision, "Please provide a supported search type: Enumeration, Optimisation, Decision");
     }
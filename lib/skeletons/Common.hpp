@@ -3,7 +3,21 @@
 
 #include "util/Registry.hpp"
 #include "util/Incumbent.hpp"
+#include "util/IncumbentTimeline.hpp"
+#include "util/BoundPropagation.hpp"
+#include "util/SearchContext.hpp"
 #include "util/Enumerator.hpp"
+#include "util/SolutionSink.hpp"
+#include "util/MemoTable.hpp"
+#include "util/MultiStart.hpp"
+#include "util/SearchMetrics.hpp"
+#include "util/TaskTrace.hpp"
+#include "util/Log.hpp"
+
+#include "workstealing/Scheduler.hpp"
+#include "workstealing/WorkerStates.hpp"
+
+#include "DepthFirst.hpp"
 
 namespace YewPar { namespace Skeletons {
 
@@ -18,47 +32,82 @@ static void initIncumbent(const Node & node, const Bound & bnd) {
   hpx::async<initVals>(reg->globalIncumbent, node, bnd).get();
 }
 
-template<typename Space, typename Node, typename Bound, typename Enumerator, typename Cmp, typename Verbose>
+// Prune locally with the new bound straight away, other localities and the global incumbent are
+// updated in the background
+template<typename Space, typename Node, typename Bound, typename Enumerator, typename Cmp, typename Verbose, bool lazyIncumbent = false>
 static void updateIncumbent(const Node & node, const Bound & bnd) {
   auto reg = Registry<Space, Node, Bound, Enumerator>::gReg;
 
-  (*reg).template updateRegistryBound<Cmp>(bnd);
-  hpx::lcos::broadcast<UpdateRegistryBoundAct<Space, Node, Bound, Enumerator, Cmp> >(
-      hpx::find_all_localities(), bnd);
-
-  typedef typename Incumbent::UpdateIncumbentAct<Node, Bound, Cmp, Verbose> act;
-  hpx::async<act>(reg->globalIncumbent, node).get();
+  if ((*reg).template updateRegistryBound<Cmp>(bnd)) {
+    Workstealing::WorkerStates::ScopedState s(Workstealing::WorkerStates::Incumbent);
+    BoundPropagation::submit<Space, Node, Bound, Enumerator, Cmp, Verbose, lazyIncumbent>(node);
+  }
 }
 
-template<typename Space, typename Node, typename Bound, typename Enum>
-static typename Enum::ResT combineEnumerators() {
-  auto vals = hpx::lcos::broadcast<GetEnumeratorValAct<Space, Node, Bound, Enum> >(
-    hpx::find_all_localities()).get();
+// Fetch the global incumbent's timeline into lastIncumbentTimeline, once all updates have arrived
+template<typename Space, typename Node, typename Bound, typename Enumerator, typename Cmp, typename Verbose>
+static void fetchIncumbentTimeline() {
+  auto reg = Registry<Space, Node, Bound, Enumerator>::gReg;
 
-  Enum res;
-  for (const auto v : vals) {
-    res.combine(v);
+  typedef typename Incumbent::GetTimelineAct<Node, Bound, Cmp, Verbose> getTimeline;
+  auto & timeline = lastIncumbentTimeline<Bound>();
+  timeline = hpx::async<getTimeline>(reg->globalIncumbent).get();
+
+  if constexpr(Verbose::value >= 1) {
+    // Search time messages come first
+    util::Log::flushAll();
+    hpx::cout << (boost::format("Incumbent improved %1% times, time to first solution: %2%s, time to final incumbent: %3%s\n")
+                  % timeline.improvements.size()
+                  % timeline.timeToFirstSolution()
+                  % timeline.timeToFinalIncumbent())
+              << hpx::flush;
   }
-  return res.get();
 }
 
-template <typename Generator>
-struct StackElem {
-  unsigned seen;
-  typename Generator::Nodetype node;
-  Generator gen;
+// Wait for in flight incumbent updates from all localities and return the final incumbent. Unless
+// the search is still going (checkpoints) this also fills in lastIncumbentTimeline.
+template<typename Space, typename Node, typename Bound, typename Enumerator, typename Cmp, typename Verbose, bool lazyIncumbent = false>
+static Node getFinalIncumbent(const bool searchDone = true) {
+  auto reg = Registry<Space, Node, Bound, Enumerator>::gReg;
 
-  StackElem(Generator gen) : seen(0), gen(gen) {};
-  StackElem(const typename Generator::Spacetype & s,
-            const typename Generator::Nodetype & n)
-      : seen(0), node(n), gen(Generator(s, node)) {};
-};
+  hpx::wait_all(hpx::lcos::broadcast<BoundPropagation::DrainIncumbentUpdatesAct<Space, Node, Bound, Enumerator, Cmp, Verbose, lazyIncumbent> >(
+      hpx::find_all_localities()));
+  if (searchDone) {
+    fetchIncumbentTimeline<Space, Node, Bound, Enumerator, Cmp, Verbose>();
+  }
 
-template <typename Generator>
-using GeneratorStack = std::vector<StackElem<Generator>>;
+  // Find the locality holding the best node and fetch only that one. If nobody improved on the
+  // initial incumbent it's still in the global component.
+  if constexpr(lazyIncumbent) {
+    auto localities = hpx::find_all_localities();
+    auto bnds = hpx::lcos::broadcast<BoundPropagation::GetLocalIncumbentBoundAct<Space, Node, Bound, Enumerator> >(
+        localities).get();
+
+    Cmp cmp;
+    int best = -1;
+    for (auto i = 0; i < bnds.size(); ++i) {
+      if (hpx::util::get<0>(bnds[i]) &&
+          (best < 0 || cmp(hpx::util::get<1>(bnds[i]), hpx::util::get<1>(bnds[best])))) {
+        best = i;
+      }
+    }
+
+    if (best >= 0) {
+      return hpx::async<BoundPropagation::GetLocalIncumbentAct<Space, Node, Bound, Enumerator> >(
+          localities[best]).get();
+    }
+  }
+
+  typedef typename Incumbent::GetIncumbentAct<Node, Bound, Cmp, Verbose> getInc;
+  return hpx::async<getInc>(reg->globalIncumbent).get();
+}
+
+// Tree reduction rooted here, so large results (e.g. per-depth counts) combine in O(log P) steps
+template<typename Space, typename Node, typename Bound, typename Enum>
+static typename Enum::ResT combineEnumerators() {
+  return reduceEnumerators<Space, Node, Bound, Enum>(hpx::get_locality_id());
+}
 
-// General node processing
-enum ProcessNodeRet { Exit, Prune, Break, Continue };
 
 template <typename Space, typename Node, typename ...Args>
 struct ProcessNode {
@@ -68,65 +117,314 @@ struct ProcessNode {
   static constexpr bool isDecision = parameter::value_type<args, API::tag::Decision_, std::integral_constant<bool, false> >::type::value;
   static constexpr bool isEnumeration = parameter::value_type<args, API::tag::Enumeration_, std::integral_constant<bool, false> >::type::value;
   static constexpr bool pruneLevel = parameter::value_type<args, API::tag::PruneLevel_, std::integral_constant<bool, false> >::type::value;
+  static constexpr bool lazyIncumbent = parameter::value_type<args, API::tag::LazyIncumbent_, std::integral_constant<bool, false> >::type::value;
+  static constexpr bool isDepthLimited = parameter::value_type<args, API::tag::DepthLimited_, std::integral_constant<bool, false> >::type::value;
 
   typedef typename parameter::value_type<args, API::tag::Verbose_, std::integral_constant<unsigned, 0> >::type Verbose;
 
+  static constexpr bool metrics = Verbose::value > 0 ||
+      parameter::value_type<args, API::tag::Metrics_, std::integral_constant<bool, false> >::type::value;
+
   typedef typename parameter::value_type<args, API::tag::BoundFunction, nullFn__>::type boundFn;
   typedef typename boundFn::return_type Bound;
   typedef typename parameter::value_type<args, API::tag::ObjectiveComparison, std::greater<Bound> >::type Objcmp;
 
   typedef typename parameter::value_type<args, API::tag::Enumerator, IdentityEnumerator<Node>>::type Enumerator;
 
+  typedef typename parameter::value_type<args, API::tag::Memoize, nullFn__>::type memoFn;
+  static constexpr bool memoize = !std::is_same<memoFn, nullFn__>::value;
+
+  typedef typename parameter::value_type<args, API::tag::InitialHeuristic, nullFn__>::type heuristicFn;
+  static constexpr bool multiStart = !std::is_same<heuristicFn, nullFn__>::value;
+
+  // Enumerations count every node, a repeated state still has to be counted again
+  static_assert(!(memoize && isEnumeration), "Memoize only supports Optimisation and Decision searches");
+
+  // Current bound to prune against, see Params::boundRefreshInterval. stale is this worker's
+  // Registry::boundNotices flag (a worker thread's slot never changes).
+  struct BoundCache {
+    Bound bnd;
+    unsigned countdown = 0;
+    std::uint64_t searchId = 0;
+    std::atomic<bool> * stale = nullptr;
+  };
+
+  static BoundCache & boundCache() {
+    static thread_local BoundCache cache;
+    return cache;
+  }
+
+  // countNode: whether this read counts towards the refresh interval, once per node
+  static Bound currentBound(const API::Params<Bound> & params, const bool countNode = true) {
+    auto reg = Registry<Space, Node, Bound, Enumerator>::gReg;
+    if (params.boundRefreshInterval <= 1) {
+      return reg->localBound.load(std::memory_order_relaxed);
+    }
+
+    auto & cache = boundCache();
+    if (!cache.stale) {
+      cache.stale = &reg->boundNotices.mine().stale;
+    }
+    if (cache.countdown == 0 || cache.searchId != reg->searchId ||
+        cache.stale->load(std::memory_order_relaxed)) {
+      cache.stale->store(false, std::memory_order_relaxed);
+      cache.bnd = reg->localBound.load(std::memory_order_relaxed);
+      cache.countdown = params.boundRefreshInterval;
+      cache.searchId = reg->searchId;
+    }
+    if (countNode) {
+      --cache.countdown;
+    }
+    return cache.bnd;
+  }
+
+  // Can this node (or its subtree) still beat the incumbent, or reach the decision target?
+  static ProcessNodeRet checkBound(const API::Params<Bound> & params, const Bound & bnd) {
+    Objcmp cmp;
+    if constexpr(isDecision) {
+        if (!cmp(bnd, params.expectedObjective) && bnd != params.expectedObjective) {
+          if constexpr(pruneLevel) {
+              return ProcessNodeRet::Break;
+            } else {
+            return ProcessNodeRet::Prune;
+          }
+        }
+        // B&B Case
+      } else {
+      auto best = currentBound(params);
+      if (!cmp(bnd, best)) {
+        if constexpr(pruneLevel) {
+            return ProcessNodeRet::Break;
+        } else {
+          return ProcessNodeRet::Prune;
+        }
+      }
+    }
+    return ProcessNodeRet::Continue;
+  }
+
+  // Priority of a task rooted at n in a bound ordered pool (Params::boundOrderedPool), higher is
+  // more promising
+  static double priority(const Space & space, const Node & n) {
+    if constexpr(!std::is_same<boundFn, nullFn__>::value) {
+      auto b = static_cast<double>(boundFn::invoke(space, n));
+      return std::is_same<Objcmp, std::less<Bound> >::value ? -b : b;
+    } else {
+      return 0;
+    }
+  }
+
+  // Has the incumbent caught up with a task rooted at n since it was spawned? Tasks from bound
+  // ordered pools are skipped (and counted as pruned) if so.
+  static bool prunedSinceSpawn(const API::Params<Bound> & params, const Space & space, const Node & n) {
+    if constexpr(isOptimisation && !std::is_same<boundFn, nullFn__>::value) {
+      if (checkBound(params, boundFn::invoke(space, n)) != ProcessNodeRet::Continue) {
+        recordOutcome(ProcessNodeRet::Prune);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Does Generator give the bounds of its children up front? (see NodeGenerator.hpp)
+  template <typename Generator>
+  static constexpr bool batchedBounds =
+      !std::is_same<boundFn, nullFn__>::value && detail::hasChildBounds<Generator>::value;
+
+  // Can the Enumerator take all of Generator's children in one go? (see Enumerator.hpp)
+  template <typename Generator>
+  static constexpr bool bulkLeaves = isEnumeration && hasAccumulateChildren<Enumerator, Generator>::value;
+
+  // Called before building the ith child of gen, at childDepth (skeleton depths count the root as
+  // 1, enumerators see childDepth - 1; children at maxDepth are never expanded). When the children are leaves, because of the depth limit or because the generator
+  // says so, they are all accumulated at once and the level ends (Break). With batched bounds a
+  // child that can't beat the incumbent is skipped in gen (Prune), or ends the level with PruneLevel
+  // (Break). Children left (Continue) still go through processNode, passing
+  // boundChecked = batchedBounds<Generator>.
+  template <typename Generator>
+  static ProcessNodeRet preProcessChild(const API::Params<Bound> & params,
+                                        Generator & gen,
+                                        const unsigned i,
+                                        const unsigned childDepth,
+                                        Enumerator & acc) {
+    if constexpr(bulkLeaves<Generator>) {
+      if (i == 0 && ((isDepthLimited && childDepth == params.maxDepth) || childrenAreLeaves(gen))) {
+        accumulateChildrenOf(acc, gen, childDepth - 1);
+        util::TaskTrace::countNodes(gen.numChildren);
+        if constexpr(metrics) {
+          util::SearchMetrics::visited(childDepth, gen.numChildren);
+          util::SearchMetrics::processed(gen.numChildren);
+        }
+        return ProcessNodeRet::Break;
+      }
+    }
+
+    if constexpr(metrics) {
+      util::SearchMetrics::visited(childDepth);
+    }
+
+    if constexpr(batchedBounds<Generator>) {
+      auto pb = checkBound(params, gen.childBounds()[i]);
+      if (pb == ProcessNodeRet::Prune) {
+        skipChildren(gen, 1);
+      }
+      if (pb != ProcessNodeRet::Continue) {
+        recordOutcome(pb);
+      }
+      return pb;
+    }
+    return ProcessNodeRet::Continue;
+  }
+
+  static void recordOutcome(const ProcessNodeRet r) {
+    if constexpr(metrics) {
+      if (r == ProcessNodeRet::Continue) {
+        util::SearchMetrics::processed();
+      } else if (r == ProcessNodeRet::Prune) {
+        util::SearchMetrics::pruned();
+      } else if (r == ProcessNodeRet::Break) {
+        util::SearchMetrics::levelPruned();
+      }
+    }
+  }
+
+  // Clear the memo tables and metrics on all localities before a search
+  static void initSearch(const API::Params<Bound> & params) {
+    if constexpr(memoize) {
+      hpx::wait_all(hpx::lcos::broadcast<util::MemoTable::reset_act>(
+          hpx::find_all_localities(), static_cast<std::uint64_t>(params.memoTableSize)));
+    }
+    if constexpr(metrics) {
+      hpx::wait_all(hpx::lcos::broadcast<util::SearchMetrics::reset_act>(hpx::find_all_localities()));
+    }
+  }
+
+  // Bring a locality that joined the running search (see util/LocalityJoin.hpp) up to date: search
+  // id, registry, global incumbent and current bound, and the per-search resets of initSearch. Every
+  // locality also makes room for it in its scheduler and gossip state.
+  static void initJoinedLocality(const hpx::naming::id_type & loc,
+                                 const Space & space,
+                                 const Node & root,
+                                 const API::Params<Bound> & params) {
+    hpx::wait_all(hpx::lcos::broadcast<Workstealing::Scheduler::addLocality_act>(
+        hpx::find_all_localities(), loc));
+    hpx::async<beginSearch_act>(loc, currentSearchId()).get();
+    hpx::async<InitRegistryAct<Space, Node, Bound, Enumerator> >(loc, space, root, params).get();
+
+    if constexpr(isOptimisation || isDecision) {
+      auto reg = Registry<Space, Node, Bound, Enumerator>::gReg;
+      hpx::async<UpdateGlobalIncumbentAct<Space, Node, Bound, Enumerator> >(loc, reg->globalIncumbent).get();
+      // Updates the joiner missed only cost it some pruning until the next one arrives
+      hpx::async<UpdateRegistryBoundAct<Space, Node, Bound, Enumerator, Objcmp> >(
+          loc, reg->localBound.load()).get();
+    }
+
+    if constexpr(memoize) {
+      hpx::async<util::MemoTable::reset_act>(loc, static_cast<std::uint64_t>(params.memoTableSize)).get();
+    }
+    if constexpr(metrics) {
+      hpx::async<util::SearchMetrics::reset_act>(loc).get();
+    }
+    if (!params.traceFile.empty()) {
+      hpx::async<util::TaskTrace::reset_act>(loc, params.traceBufferSize).get();
+    }
+  }
+
+  // Set the initial incumbent on all localities, the global incumbent component already existing.
+  // That's start with params.initialBound unless the InitialHeuristic finds something better.
+  static void initIncumbent(const Node & start, const API::Params<Bound> & params) {
+    if constexpr(isOptimisation && multiStart) {
+      if (params.multiStartMillis > 0) {
+        auto best = util::MultiStart::run<Space, Node, Bound, Enumerator, heuristicFn, Objcmp>(
+            params.multiStartMillis, Verbose::value > 0);
+        Objcmp cmp;
+        if (cmp(best.getObj(), params.initialBound)) {
+          hpx::wait_all(hpx::lcos::broadcast<UpdateRegistryBoundAct<Space, Node, Bound, Enumerator, Objcmp> >(
+              hpx::find_all_localities(), best.getObj()));
+          Skeletons::initIncumbent<Space, Node, Bound, Enumerator, Objcmp, Verbose>(best, best.getObj());
+          return;
+        }
+      }
+    }
+    Skeletons::initIncumbent<Space, Node, Bound, Enumerator, Objcmp, Verbose>(start, params.initialBound);
+  }
+
+  static void printReports() {
+    if constexpr(Verbose::value > 1) {
+      if constexpr(memoize) {
+        util::printOnEachLocality<util::MemoTable::printReport_act>();
+      }
+      util::printOnEachLocality<util::SearchMetrics::printReport_act>();
+    }
+  }
+
+  // c is at depth (the root being at 0), which goes to enumerators that take it (see Enumerator.hpp)
   static ProcessNodeRet processNode(const API::Params<Bound> & params,
                                     const Space & space,
                                     const Node & c,
-                                    Enumerator & acc) {
+                                    const unsigned depth,
+                                    Enumerator & acc,
+                                    const bool boundChecked = false) {
+    util::TaskTrace::countNodes();
+    auto r = process(params, space, c, depth, acc, boundChecked);
+    recordOutcome(r);
+    return r;
+  }
+
+ private:
+  static ProcessNodeRet process(const API::Params<Bound> & params,
+                                const Space & space,
+                                const Node & c,
+                                const unsigned depth,
+                                Enumerator & acc,
+                                const bool boundChecked) {
 
     if constexpr(isEnumeration) {
-        acc.accumulate(c);
+        accumulateNode(acc, c, depth);
         return ProcessNodeRet::Continue;
     }
 
+    // Set once a decision search succeeds, or when a Portfolio run is out of time
+    if (Registry<Space, Node, Bound, Enumerator>::gReg->shouldStop()) {
+      return ProcessNodeRet::Exit;
+    }
+
     if constexpr(isDecision) {
         if (c.getObj() == params.expectedObjective) {
-          updateIncumbent<Space, Node, Bound, Enumerator, Objcmp, Verbose>(c, c.getObj());
-          hpx::lcos::broadcast<SetStopFlagAct<Space, Node, Bound, Enumerator> >(hpx::find_all_localities());
+          updateIncumbent<Space, Node, Bound, Enumerator, Objcmp, Verbose, lazyIncumbent>(c, c.getObj());
+          hpx::lcos::broadcast<StopAndCancelAct<Space, Node, Bound, Enumerator> >(hpx::find_all_localities());
           return ProcessNodeRet::Exit;
         }
       }
 
     if constexpr(!std::is_same<boundFn, nullFn__>::value) {
-        Objcmp cmp;
-        auto bnd  = boundFn::invoke(space, c);
-        if constexpr(isDecision) {
-            if (!cmp(bnd, params.expectedObjective) && bnd != params.expectedObjective) {
-              if constexpr(pruneLevel) {
-                  return ProcessNodeRet::Break;
-                } else {
-                return ProcessNodeRet::Prune;
-              }
-            }
-            // B&B Case
-          } else {
-          auto reg = Registry<Space, Node, Bound, Enumerator>::gReg;
-          auto best = reg->localBound.load();
-          if (!cmp(bnd, best)) {
-            if constexpr(pruneLevel) {
-                return ProcessNodeRet::Break;
-            } else {
-              return ProcessNodeRet::Prune;
-            }
+        if (!boundChecked) {
+          auto pb = checkBound(params, boundFn::invoke(space, c));
+          if (pb != ProcessNodeRet::Continue) {
+            return pb;
           }
         }
       }
 
+    if constexpr(memoize) {
+        auto k = memoFn::invoke(space, c);
+        if (util::MemoTable::seen(k.key, k.cost)) {
+          return ProcessNodeRet::Prune;
+        }
+      }
+
     if constexpr(isOptimisation) {
-        auto reg = Registry<Space, Node, Bound, Enumerator>::gReg;
-        auto best = reg->localBound.load();
+        // A bound check above (or the batched one before) has already counted this node
+        auto best = currentBound(params, !boundChecked && std::is_same<boundFn, nullFn__>::value);
 
         Objcmp cmp;
         if (cmp(c.getObj(),best)) {
-          updateIncumbent<Space, Node, Bound, Enumerator, Objcmp, Verbose>(c, c.getObj());
+          updateIncumbent<Space, Node, Bound, Enumerator, Objcmp, Verbose, lazyIncumbent>(c, c.getObj());
+
+          // Our own improvements are picked up straight away
+          if (params.boundRefreshInterval > 1) {
+            boundCache().countdown = 0;
+          }
         }
     }
     return ProcessNodeRet::Continue;
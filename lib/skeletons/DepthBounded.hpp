@@ -1,7 +1,10 @@
 #ifndef SKELETONS_DEPTHSPAWN_HPP
 #define SKELETONS_DEPTHSPAWN_HPP
 
+#include <chrono>
 #include <iostream>
+#include <iterator>
+#include <mutex>
 #include <vector>
 #include <cstdint>
 
@@ -10,18 +13,31 @@
 #include "API.hpp"
 
 #include <hpx/lcos/broadcast.hpp>
+#include <hpx/lcos/local/condition_variable.hpp>
+#include <hpx/lcos/local/mutex.hpp>
 #include <hpx/include/iostreams.hpp>
 
 #include "util/NodeGenerator.hpp"
 #include "util/Registry.hpp"
 #include "util/Incumbent.hpp"
 #include "util/func.hpp"
+#include "util/AdaptiveSpawnDepth.hpp"
+#include "util/Checkpoint.hpp"
+#include "util/TreeEstimator.hpp"
+#include "util/CompletionAggregator.hpp"
+#include "util/MemoryUsage.hpp"
+#include "util/TaskPool.hpp"
+#include "util/LocalityJoin.hpp"
 
 #include "Common.hpp"
 
 #include "workstealing/Scheduler.hpp"
 #include "workstealing/policies/Workpool.hpp"
+#include "workstealing/policies/PerThreadWorkpool.hpp"
 #include "workstealing/policies/DepthPoolPolicy.hpp"
+#include "workstealing/Termination.hpp"
+#include "workstealing/WorkerStates.hpp"
+#include "workstealing/StealStats.hpp"
 
 namespace YewPar { namespace Skeletons {
 
@@ -30,6 +46,9 @@ namespace DepthBounded_ {
 template <typename Generator, typename ...Args>
 struct SubtreeTask;
 
+template <typename Generator, typename ...Args>
+struct ResumeTasksAct;
+
 }
 
 // This skeleton allows spawning all tasks into a workqueue based policy based on some depth limit
@@ -38,13 +57,19 @@ struct DepthBounded {
   typedef typename Generator::Nodetype Node;
   typedef typename Generator::Spacetype Space;
 
+  static_assert(isNodeGenerator<Generator>::value,
+                "Generator needs Nodetype, Spacetype, numChildren, next() and a (Space, Node) constructor");
+
   typedef typename API::skeleton_signature::bind<Args...>::type args;
 
   static constexpr bool isEnumeration = parameter::value_type<args, API::tag::Enumeration_, std::integral_constant<bool, false> >::type::value;
   static constexpr bool isOptimisation = parameter::value_type<args, API::tag::Optimisation_, std::integral_constant<bool, false> >::type::value;
   static constexpr bool isDecision = parameter::value_type<args, API::tag::Decision_, std::integral_constant<bool, false> >::type::value;
   static constexpr bool isDepthLimited = parameter::value_type<args, API::tag::DepthLimited_, std::integral_constant<bool, false> >::type::value;
+  static constexpr unsigned maxStackDepth = parameter::value_type<args, API::tag::MaxStackDepth, std::integral_constant<unsigned, 5000> >::type::value;
   static constexpr bool pruneLevel = parameter::value_type<args, API::tag::PruneLevel_, std::integral_constant<bool, false> >::type::value;
+  static constexpr bool lazyIncumbent = parameter::value_type<args, API::tag::LazyIncumbent_, std::integral_constant<bool, false> >::type::value;
+  static constexpr bool countTermination = parameter::value_type<args, API::tag::CountTermination_, std::integral_constant<bool, false> >::type::value;
 
   typedef typename parameter::value_type<args, API::tag::Verbose_, std::integral_constant<unsigned, 0> >::type Verbose;
   static constexpr unsigned verbose = Verbose::value;
@@ -54,11 +79,20 @@ struct DepthBounded {
   typedef typename parameter::value_type<args, API::tag::ObjectiveComparison, std::greater<Bound> >::type Objcmp;
   typedef typename parameter::value_type<args, API::tag::Enumerator, IdentityEnumerator<Node>>::type Enum;
 
+  typedef ProcessNode<Space, Node, Args...> PN;
+
+  typedef CheckpointTask<Node> CPTask;
+
   typedef typename parameter::value_type<args, API::tag::DepthBoundedPoolPolicy, Workstealing::Policies::DepthPoolPolicy>::type Policy;
 
+  // Params::boundOrderedPool needs a DepthPool and something to order by
+  static constexpr bool boundOrdered = std::is_same<Policy, Workstealing::Policies::DepthPoolPolicy>::value &&
+      !std::is_same<boundFn, nullFn__>::value;
+
   static void printSkeletonDetails(const API::Params<Bound> & params) {
     hpx::cout << "Skeleton Type: DepthBounded\n";
     hpx::cout << "d_cutoff: " << params.spawnDepth << "\n";
+    hpx::cout << "Adaptive d_cutoff: " << std::boolalpha << params.adaptiveSpawnDepth << "\n";
     hpx::cout << "Enumeration : " << std::boolalpha << isEnumeration << "\n";
     hpx::cout << "Optimisation: " << std::boolalpha << isOptimisation << "\n";
     hpx::cout << "Decision: " << std::boolalpha << isDecision << "\n";
@@ -69,8 +103,12 @@ struct DepthBounded {
       } else {
       hpx::cout << "Using Bounding: false\n";
     }
+    hpx::cout << "CountTermination: " << std::boolalpha << countTermination << "\n";
+    hpx::cout << "Memory cap (MB): " << params.memoryCapMB << "\n";
     if constexpr (std::is_same<Policy, Workstealing::Policies::Workpool>::value) {
       hpx::cout << "Workpool: Deque\n";
+    } else if constexpr (std::is_same<Policy, Workstealing::Policies::PerThreadWorkpool>::value) {
+      hpx::cout << "Workpool: PerThreadDeque\n";
     } else {
       hpx::cout << "Workpool: DepthPool\n";
     }
@@ -82,7 +120,17 @@ struct DepthBounded {
                                const API::Params<Bound> & params,
                                Enum & acc,
                                std::vector<hpx::future<void> > & childFutures,
-                               const unsigned childDepth) {
+                               const unsigned childDepth,
+                               const unsigned firstChild = 0) {
+    auto reg = Registry<Space, Node, Bound, Enum>::gReg;
+
+    // Tasks drained after a decision search succeeds shouldn't build a generator, or spawn
+    if constexpr(isDecision) {
+        if (reg->shouldStop()) {
+          return;
+        }
+      }
+
     Generator newCands = Generator(space, n);
 
     if constexpr(isDepthLimited) {
@@ -91,63 +139,112 @@ struct DepthBounded {
         }
     }
 
-    for (auto i = 0; i < newCands.numChildren; ++i) {
+    skipChildren(newCands, firstChild);
+    for (auto i = firstChild; i < newCands.numChildren; ++i) {
+      if (reg->checkpointing.load(std::memory_order_relaxed)) {
+        reg->saveCheckpointTask(n, childDepth, i);
+        return;
+      }
+
+      auto pb = PN::preProcessChild(params, newCands, i, childDepth + 1, acc);
+      if (pb == ProcessNodeRet::Prune) { continue; }
+      else if (pb == ProcessNodeRet::Break) { break; }
+
       auto c = newCands.next();
 
-      auto pn = ProcessNode<Space, Node, Args...>::processNode(params, space, c, acc);
+      auto pn = PN::processNode(params, space, c, childDepth, acc, PN::template batchedBounds<Generator>);
       if (pn == ProcessNodeRet::Exit) { return; }
+      else if (pn == ProcessNodeRet::Prune) { continue; }
       else if (pn == ProcessNodeRet::Break) { break; }
       //default continue
 
-      // Spawn new tasks for all children (that are still alive after pruning)
-      childFutures.push_back(createTask(childDepth + 1, c));
+      // Spawn new tasks for all children (that are still alive after pruning), over the memory cap
+      // they are searched here instead
+      if ((!params.adaptiveSpawnDepth ||
+           util::AdaptiveSpawnDepth::shouldSpawn(childDepth, params.spawnDepth)) &&
+          !util::MemoryUsage::overCap()) {
+        spawnChild(childFutures, childDepth + 1, c);
+      } else {
+        expandNoSpawns(space, c, params, acc, childFutures, childDepth + 1);
+      }
     }
   }
 
+  // Only spawns (below the cutoff) with adaptiveSpawnDepth
   static void expandNoSpawns(const Space & space,
                              const Node & n,
                              const API::Params<Bound> & params,
                              Enum & acc,
-                             const unsigned childDepth) {
+                             std::vector<hpx::future<void> > & childFutures,
+                             const unsigned childDepth,
+                             const unsigned firstChild = 0) {
     auto reg = Registry<Space, Node, Bound, Enum>::gReg;
-    Generator newCands = Generator(space, n);
 
     if constexpr(isDecision) {
-        if (reg->stopSearch) {
+        if (reg->shouldStop()) {
           return;
         }
       }
 
-    if constexpr(isDepthLimited) {
-        if (childDepth == params.maxDepth) {
-          return;
-        }
-    }
-
-    for (auto i = 0; i < newCands.numChildren; ++i) {
-      auto c = newCands.next();
-
-      auto pn = ProcessNode<Space, Node, Args...>::processNode(params, space, c, acc);
-      if (pn == ProcessNodeRet::Exit) { return; }
-      else if (pn == ProcessNodeRet::Prune) { continue; }
-      else if (pn == ProcessNodeRet::Break) { break; }
-
-      expandNoSpawns(space, c, params, acc, childDepth + 1);
-    }
+    expandDepthFirst<Generator, maxStackDepth, isDepthLimited>(
+        space, n, firstChild, childDepth, params.maxDepth,
+        [&](const Node & c, const unsigned depth) {
+          if constexpr(isDecision) {
+            if (reg->shouldStop()) {
+              return ProcessNodeRet::Exit;
+            }
+          }
+
+          auto pn = PN::processNode(params, space, c, depth - 1, acc, PN::template batchedBounds<Generator>);
+          if (pn != ProcessNodeRet::Continue) {
+            return pn;
+          }
+
+          // Hand the subtree to a new task instead of searching it here
+          if (params.adaptiveSpawnDepth &&
+              util::AdaptiveSpawnDepth::shouldSpawn(depth - 1, params.spawnDepth) &&
+              !util::MemoryUsage::overCap()) {
+            spawnChild(childFutures, depth, c);
+            return ProcessNodeRet::Prune;
+          }
+          return ProcessNodeRet::Continue;
+        },
+        [&](Generator & gen, const unsigned i, const unsigned depth) {
+          return PN::preProcessChild(params, gen, i, depth, acc);
+        },
+        [&]() { return reg->checkpointing.load(std::memory_order_relaxed); },
+        [&](const Node & node, const unsigned depth, const unsigned next) {
+          reg->saveCheckpointTask(node, depth, next);
+        });
   }
 
   static void subtreeTask(const Node taskRoot,
                           const unsigned childDepth,
+                          const unsigned firstChild,
                           const hpx::naming::id_type donePromiseId) {
     auto reg = Registry<Space, Node, Bound, Enum>::gReg;
+    const auto & space = reg->localSpace();
+
+    util::TaskTrace::ScopedTask trace(childDepth, childDepth == 1 ? util::TaskTrace::Origin::Root
+                                      : util::TaskTrace::originOf(false, donePromiseId));
 
     Enum acc;
     std::vector<hpx::future<void> > childFutures;
 
-    if (childDepth <= reg->params.spawnDepth) {
-      expandWithSpawns(reg->space, taskRoot, reg->params, acc, childFutures, childDepth);
+    auto start = std::chrono::steady_clock::now();
+    if (reg->checkpointing.load(std::memory_order_relaxed)) {
+      // Queued before the checkpoint, keep it for afterwards
+      reg->saveCheckpointTask(taskRoot, childDepth, firstChild);
+    } else if (boundOrdered && reg->params.boundOrderedPool &&
+               PN::prunedSinceSpawn(reg->params, space, taskRoot)) {
+      // Nothing left to search
+    } else if (childDepth <= reg->params.spawnDepth) {
+      expandWithSpawns(space, taskRoot, reg->params, acc, childFutures, childDepth, firstChild);
     } else {
-      expandNoSpawns(reg->space, taskRoot, reg->params, acc, childDepth);
+      expandNoSpawns(space, taskRoot, reg->params, acc, childFutures, childDepth, firstChild);
+    }
+    if (reg->params.adaptiveSpawnDepth) {
+      util::AdaptiveSpawnDepth::taskFinished(childDepth, std::chrono::steady_clock::now() - start);
     }
 
     // Atomically updates the (process) local enumerator
@@ -155,75 +252,328 @@ struct DepthBounded {
       reg->updateEnumerator(acc);
     }
 
+    if constexpr(countTermination) {
+      Workstealing::Termination::taskCompleted();
+      return;
+    }
+
     hpx::apply(hpx::util::bind([=](std::vector<hpx::future<void> > & futs) {
           hpx::wait_all(futs);
-          hpx::async<hpx::lcos::base_lco_with_value<void>::set_value_action>(donePromiseId, true);
+          util::MemoryUsage::add(util::MemoryUsage::Futures,
+                                 -static_cast<std::int64_t>(futs.size()) * util::MemoryUsage::futureBytes);
+          util::CompletionAggregator::complete(donePromiseId);
         }, std::move(childFutures)));
   }
 
+  static void addTask(const unsigned childDepth,
+                      const Node & taskRoot,
+                      const hpx::naming::id_type donePromiseId,
+                      const unsigned firstChild = 0) {
+    DepthBounded_::SubtreeTask<Generator, Args...> t;
+    hpx::util::function<void(hpx::naming::id_type)> task;
+    task = util::TaskPool::pooledTask(hpx::util::bind(t, hpx::util::placeholders::_1, taskRoot, childDepth, firstChild, donePromiseId));
+
+    auto workPool = std::static_pointer_cast<Policy>(Workstealing::Scheduler::local_policy);
+    if constexpr (std::is_same<Policy, Workstealing::Policies::Workpool>::value ||
+                  std::is_same<Policy, Workstealing::Policies::PerThreadWorkpool>::value) {
+      workPool->addwork(std::move(task));
+    } else {
+      if constexpr(boundOrdered) {
+        auto reg = Registry<Space, Node, Bound, Enum>::gReg;
+        if (reg->params.boundOrderedPool) {
+          workPool->addwork(std::move(task), childDepth - 1, PN::priority(reg->localSpace(), taskRoot));
+          return;
+        }
+      }
+      workPool->addwork(std::move(task), childDepth - 1);
+    }
+  }
+
+  // Spawn a child task, either tracked by a promise or counted for termination detection
+  static void spawnChild(std::vector<hpx::future<void> > & childFutures,
+                         const unsigned childDepth,
+                         const Node & taskRoot) {
+    if constexpr(countTermination) {
+      Workstealing::Termination::taskSpawned();
+      addTask(childDepth, taskRoot, hpx::invalid_id);
+    } else {
+      childFutures.push_back(createTask(childDepth, taskRoot));
+      util::MemoryUsage::add(util::MemoryUsage::Futures, util::MemoryUsage::futureBytes);
+    }
+  }
+
   static hpx::future<void> createTask(const unsigned childDepth,
-                                      const Node & taskRoot) {
+                                      const Node & taskRoot,
+                                      const unsigned firstChild = 0) {
     hpx::lcos::promise<void> prom;
     auto pfut = prom.get_future();
     auto pid  = prom.get_id();
 
-    DepthBounded_::SubtreeTask<Generator, Args...> t;
-    hpx::util::function<void(hpx::naming::id_type)> task;
-    task = hpx::util::bind(t, hpx::util::placeholders::_1, taskRoot, childDepth, pid);
+    addTask(childDepth, taskRoot, pid, firstChild);
 
-    auto workPool = std::static_pointer_cast<Policy>(Workstealing::Scheduler::local_policy);
-    if constexpr (std::is_same<Policy, Workstealing::Policies::Workpool>::value) {
-      workPool->addwork(task);
+     return pfut;
+  }
+
+  // Spawn tasks on this locality. Without countTermination this only returns once they (and all
+  // their children) are done.
+  static void resumeTasks(std::vector<CPTask> tasks) {
+    if constexpr(countTermination) {
+      for (const auto & t : tasks) {
+        Workstealing::Termination::taskSpawned();
+        addTask(t.childDepth, t.node, hpx::invalid_id, t.firstChild);
+      }
     } else {
-      workPool->addwork(task, childDepth - 1);
+      std::vector<hpx::future<void> > futs;
+      for (const auto & t : tasks) {
+        futs.push_back(createTask(t.childDepth, t.node, t.firstChild));
+      }
+      hpx::wait_all(futs);
     }
+  }
 
-     return pfut;
+  // Run tasks (spread round robin over the localities) until the search ends or a checkpoint
+  // pauses it. Returns true if it was paused.
+  static bool runTasks(std::vector<CPTask> tasks, const API::Params<Bound> & params) {
+    auto localities = hpx::find_all_localities();
+    std::vector<std::vector<CPTask> > perLocality(localities.size());
+    for (auto i = 0; i < tasks.size(); ++i) {
+      perLocality[i % localities.size()].push_back(std::move(tasks[i]));
+    }
+
+    hpx::lcos::local::mutex mtx;
+    hpx::lcos::local::condition_variable cv;
+    bool finished = false;
+    bool paused = false;
+
+    hpx::future<void> timer = hpx::make_ready_future();
+    if (params.checkpointIntervalMillis > 0) {
+      timer = hpx::async([&]() {
+        std::unique_lock<hpx::lcos::local::mutex> l(mtx);
+        if (!cv.wait_for(l, std::chrono::milliseconds(params.checkpointIntervalMillis),
+                         [&]() { return finished; })) {
+          paused = true;
+          l.unlock();
+          // Including any locality that joined since the tasks were handed out
+          hpx::wait_all(hpx::lcos::broadcast<SetCheckpointingAct<Space, Node, Bound, Enum> >(
+              hpx::find_all_localities(), true));
+        }
+      });
+    }
+
+    std::vector<hpx::future<void> > futs;
+    for (auto i = 0; i < localities.size(); ++i) {
+      if (!perLocality[i].empty()) {
+        futs.push_back(hpx::async<DepthBounded_::ResumeTasksAct<Generator, Args...> >(
+            localities[i], std::move(perLocality[i])));
+      }
+    }
+    hpx::wait_all(futs);
+    if constexpr(countTermination) {
+      Workstealing::Termination::waitForTermination();
+    }
+
+    {
+      std::lock_guard<hpx::lcos::local::mutex> l(mtx);
+      finished = true;
+    }
+    cv.notify_all();
+    timer.get();
+    return paused;
+  }
+
+  // Collect the work left after a pause and write it out, with everything found so far. Returns the
+  // tasks to carry on with.
+  static std::vector<CPTask> checkpoint(const API::Params<Bound> & params) {
+    auto localities = hpx::find_all_localities();
+
+    Checkpoint<Node, Bound, typename Enum::ResT> cp;
+    for (const auto & l : localities) {
+      auto ts = hpx::async<TakeCheckpointTasksAct<Space, Node, Bound, Enum> >(l).get();
+      std::move(ts.begin(), ts.end(), std::back_inserter(cp.tasks));
+    }
+    hpx::wait_all(hpx::lcos::broadcast<SetCheckpointingAct<Space, Node, Bound, Enum> >(
+        localities, false));
+
+    if constexpr(isEnumeration) {
+      cp.enumerated = combineEnumerators<Space, Node, Bound, Enum>();
+    } else {
+      cp.incumbent = getFinalIncumbent<Space, Node, Bound, Enum, Objcmp, Verbose, lazyIncumbent>(false);
+      cp.bound = cp.incumbent.getObj();
+      if constexpr(isOptimisation) {
+        // Not improved on yet, the initial bound still holds
+        Objcmp cmp;
+        if (!cmp(cp.bound, params.initialBound)) {
+          cp.bound = params.initialBound;
+        }
+      }
+    }
+
+    // Finished just as the checkpoint started, nothing to resume
+    if (!cp.tasks.empty()) {
+      writeCheckpoint(params.checkpointFile, cp);
+      if constexpr(verbose) {
+        hpx::cout << (boost::format("Checkpoint: %1% tasks written to %2%\n")
+                      % cp.tasks.size() % params.checkpointFile)
+                  << hpx::flush;
+      }
+    }
+    return std::move(cp.tasks);
+  }
+
+  // Params::joinPollMillis: set loc up for the running search and start its schedulers
+  static void joinLocality(const hpx::naming::id_type & loc,
+                           const Space & space,
+                           const Node & root,
+                           const API::Params<Bound> & params) {
+    PN::initJoinedLocality(loc, space, root, params);
+
+    if (params.adaptiveSpawnDepth) {
+      hpx::async<util::AdaptiveSpawnDepth::reset_act>(loc).get();
+    }
+
+    hpx::async<util::MemoryUsage::reset_act>(loc, static_cast<std::uint64_t>(params.memoryCapMB) << 20).get();
+
+    Policy::joinLocality(loc);
+    hpx::async<Workstealing::Scheduler::startLocalSchedulers_act>(loc).get();
   }
 
   static auto search (const Space & space,
                       const Node & root,
-                      const API::Params<Bound> params = API::Params<Bound>()) {
+                      API::Params<Bound> params = API::Params<Bound>()) {
+    SearchContext ctx;
+
+    if constexpr(verbose > 1) {
+      Workstealing::StealStats::setEnabledEverywhere(true);
+    }
+
+    if (params.autoTune) {
+      util::autoTune<Generator, isDepthLimited>(space, root, params, verbose);
+    }
+
     if constexpr (verbose) {
         printSkeletonDetails(params);
     }
 
-    hpx::wait_all(hpx::lcos::broadcast<InitRegistryAct<Space, Node, Bound, Enum> >(
-        hpx::find_all_localities(), space, root, params));
+    // Resuming starts from the incumbent and counts so far
+    Checkpoint<Node, Bound, typename Enum::ResT> resumed;
+    auto start = root;
+    if (params.resumeFromCheckpoint) {
+      resumed = readCheckpoint<Node, Bound, typename Enum::ResT>(params.checkpointFile);
+      if constexpr(isOptimisation || isDecision) {
+        start = resumed.incumbent;
+        params.initialBound = resumed.bound;
+      }
+    }
+
+    initRegistries<Space, Node, Bound, Enum>(space, root, params);
+
+    PN::initSearch(params);
+    util::TaskTrace::begin(params.traceFile, params.traceBufferSize);
+
+    if (params.adaptiveSpawnDepth) {
+      hpx::wait_all(hpx::lcos::broadcast<util::AdaptiveSpawnDepth::reset_act>(hpx::find_all_localities()));
+    }
+
+    hpx::wait_all(hpx::lcos::broadcast<util::MemoryUsage::reset_act>(
+        hpx::find_all_localities(), static_cast<std::uint64_t>(params.memoryCapMB) << 20));
+
+    if constexpr(std::is_same<Policy, Workstealing::Policies::DepthPoolPolicy>::value) {
+      // Tasks are pooled at their parent's depth, below maxDepth when depth limited
+      Policy::initPolicy(boundOrdered && params.boundOrderedPool, params.maxDepth);
+    } else {
+      Policy::initPolicy();
+    }
 
-    Policy::initPolicy();
+    if constexpr(countTermination) {
+      hpx::wait_all(hpx::lcos::broadcast<Workstealing::Termination::reset_act>(hpx::find_all_localities()));
+    }
 
-    auto threadCount = hpx::get_os_thread_count() == 1 ? 1 : hpx::get_os_thread_count() - 1;
-    hpx::wait_all(hpx::lcos::broadcast<Workstealing::Scheduler::startSchedulers_act>(
-        hpx::find_all_localities(), threadCount));
+    hpx::wait_all(hpx::lcos::broadcast<Workstealing::Scheduler::startLocalSchedulers_act>(
+        hpx::find_all_localities()));
 
     if constexpr(isOptimisation || isDecision) {
       auto inc = hpx::new_<Incumbent>(hpx::find_here()).get();
       hpx::wait_all(hpx::lcos::broadcast<UpdateGlobalIncumbentAct<Space, Node, Bound, Enum> >(
           hpx::find_all_localities(), inc));
-      initIncumbent<Space, Node, Bound, Enum, Objcmp, Verbose>(root, params.initialBound);
+      PN::initIncumbent(start, params);
     }
 
     // Ensure the root node is accumulated if required
     if constexpr(isEnumeration) {
         Enum acc;
-        acc.accumulate(root);
+        if (params.resumeFromCheckpoint) {
+          acc.combine(resumed.enumerated);
+        } else {
+          accumulateNode(acc, root, 0);
+        }
         Registry<Space, Node, Bound, Enum>::gReg->updateEnumerator(acc);
     }
 
-    createTask(1, root).get();
+    std::vector<CPTask> tasks;
+    if (params.resumeFromCheckpoint) {
+      tasks = std::move(resumed.tasks);
+    } else {
+      tasks.push_back(CPTask {root, 1, 0});
+    }
+
+    // Counting termination waves assume a fixed set of localities
+    util::LocalityWatcher joins(countTermination ? 0 : params.joinPollMillis,
+                                [&](const hpx::naming::id_type & loc) {
+                                  joinLocality(loc, space, root, params);
+                                });
+
+    while (runTasks(std::move(tasks), params)) {
+      if constexpr(isDecision) {
+        if (Registry<Space, Node, Bound, Enum>::gReg->stopSearch.load()) {
+          break;
+        }
+      }
+
+      tasks = checkpoint(params);
+      if (tasks.empty()) {
+        break;
+      }
+    }
+
+    if (params.checkpointIntervalMillis > 0) {
+      removeCheckpoint(params.checkpointFile);
+    }
+
+    joins.stop();
+    if constexpr(verbose) {
+      if (joins.joined() > 0) {
+        hpx::cout << (boost::format("Localities joined during the search: %1%\n") % joins.joined())
+                  << hpx::flush;
+      }
+    }
 
     hpx::wait_all(hpx::lcos::broadcast<Workstealing::Scheduler::stopSchedulers_act>(
         hpx::find_all_localities()));
 
+    if constexpr (verbose >= 2) {
+      Workstealing::WorkerStates::printAllReports();
+    }
+
+    if constexpr (verbose >= 3) {
+      Workstealing::StealStats::printAllReports();
+    }
+
+    if (verbose >= 2 || (params.memoryCapMB > 0 && verbose)) {
+      util::printOnEachLocality<util::MemoryUsage::printReport_act>();
+    }
+
+    if (params.adaptiveSpawnDepth && verbose) {
+      util::printOnEachLocality<util::AdaptiveSpawnDepth::printReport_act>();
+    }
+
+    util::TaskTrace::end(params.traceFile);
+    PN::printReports();
+
     // Return the right thing
     if constexpr(isEnumeration) {
       return combineEnumerators<Space, Node, Bound, Enum>();
     } else if constexpr(isOptimisation || isDecision) {
-      auto reg = Registry<Space, Node, Bound, Enum>::gReg;
-
-      typedef typename Incumbent::GetIncumbentAct<Node, Bound, Objcmp, Verbose> getInc;
-      return hpx::async<getInc>(reg->globalIncumbent).get();
+      return getFinalIncumbent<Space, Node, Bound, Enum, Objcmp, Verbose, lazyIncumbent>();
     } else {
       static_assert(isEnumeration || isOptimisation || isDecision, "Please provide a supported search type: Enumeration, Optimisation, Decision");
     }
@@ -238,6 +588,12 @@ struct SubtreeTask : hpx::actions::make_action<
   &DepthBounded<Generator, Args...>::subtreeTask,
   SubtreeTask<Generator, Args...>>::type {};
 
+template <typename Generator, typename ...Args>
+struct ResumeTasksAct : hpx::actions::make_action<
+  decltype(&DepthBounded<Generator, Args...>::resumeTasks),
+  &DepthBounded<Generator, Args...>::resumeTasks,
+  ResumeTasksAct<Generator, Args...>>::type {};
+
 }
 
 }}
@@ -249,6 +605,11 @@ struct action_stacksize<YewPar::Skeletons::DepthBounded_::SubtreeTask<Generator,
   enum { value = threads::thread_stacksize_huge };
 };
 
+template <typename Generator, typename ...Args>
+struct action_stacksize<YewPar::Skeletons::DepthBounded_::ResumeTasksAct<Generator, Args...> > {
+  enum { value = threads::thread_stacksize_huge };
+};
+
 }}
 
 #endif
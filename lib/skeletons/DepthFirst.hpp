@@ -0,0 +1,259 @@
+#ifndef SKELETONS_DEPTHFIRST_HPP
+#define SKELETONS_DEPTHFIRST_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "util/HugePages.hpp"
+#include "util/NodeGenerator.hpp"
+#include "util/MemoryUsage.hpp"
+
+namespace YewPar { namespace Skeletons {
+
+template <typename Generator>
+struct StackElem {
+  unsigned seen;
+  typename Generator::Nodetype node;
+  Generator gen;
+
+  StackElem(Generator gen) : seen(0), gen(gen) {};
+  StackElem(const typename Generator::Spacetype & s,
+            const typename Generator::Nodetype & n)
+      : seen(0), node(n), gen(Generator(s, node)) {};
+};
+
+// Search stack of the stack based skeletons (StackStealing, Budget, BasicRandom).
+//
+// Frames are only built the first time the search reaches their depth, as copies of the bottom
+// frame since generators need not be default constructible. Storage for maxDepth frames is
+// reserved up front (but not touched) so frames never move: generators may hold references to the
+// node in the frame below. Once a task is done its frames go back to a small per worker thread
+// cache and the next task on that thread reuses them, assigning over the old nodes and generators
+// rather than building new ones. Built frames, cached or not, count towards util::MemoryUsage.
+// Frame storage of deep stacks can be on huge pages, see util/HugePages.hpp.
+template <typename Generator>
+class GeneratorStack {
+ public:
+  using Frames = std::vector<StackElem<Generator>, util::HugePages::Allocator<StackElem<Generator> > >;
+
+  GeneratorStack(const std::size_t maxDepth, const StackElem<Generator> & root)
+      : frames(acquire(maxDepth)) {
+    if (frames.empty()) {
+      frames.push_back(root);
+      account(1);
+    } else {
+      frames[0] = root;
+    }
+  }
+
+  GeneratorStack(const GeneratorStack & other) : frames(acquire(other.frames.capacity())) {
+    assign(other);
+  }
+
+  GeneratorStack & operator=(const GeneratorStack & other) {
+    if (this != &other) {
+      assign(other);
+    }
+    return *this;
+  }
+
+  ~GeneratorStack() {
+    auto & cache = frameCache();
+    if (frames.capacity() > 0 && cache.size() < maxCachedStacks) {
+      cache.push_back(std::move(frames));
+    } else {
+      account(-static_cast<std::int64_t>(frames.size()));
+    }
+  }
+
+  StackElem<Generator> & operator[](const std::size_t i) {
+    while (frames.size() <= i) {
+      // Growing past the reserved storage would move the frames
+      if (frames.size() == frames.capacity()) {
+        throw std::length_error("GeneratorStack: search is deeper than MaxStackDepth");
+      }
+      frames.push_back(frames.front());
+      account(1);
+    }
+    return frames[i];
+  }
+
+  // Only for frames the search has already reached
+  const StackElem<Generator> & operator[](const std::size_t i) const {
+    return frames[i];
+  }
+
+ private:
+  // A few stacks per worker is enough, tasks on a thread mostly run one after the other
+  static constexpr std::size_t maxCachedStacks = 4;
+
+  Frames frames;
+
+  static std::vector<Frames> & frameCache() {
+    static thread_local std::vector<Frames> cache;
+    return cache;
+  }
+
+  static Frames acquire(const std::size_t maxDepth) {
+    auto & cache = frameCache();
+    while (!cache.empty()) {
+      auto f = std::move(cache.back());
+      cache.pop_back();
+      if (f.capacity() >= maxDepth) {
+        return f;
+      }
+      account(-static_cast<std::int64_t>(f.size()));
+    }
+    Frames f;
+    f.reserve(maxDepth);
+    return f;
+  }
+
+  // Copy frame by frame (never reallocating) to keep frames in place
+  void assign(const GeneratorStack & other) {
+    auto n = std::min(frames.size(), other.frames.size());
+    for (std::size_t i = 0; i < n; ++i) {
+      frames[i] = other.frames[i];
+    }
+    for (auto i = n; i < other.frames.size(); ++i) {
+      frames.push_back(other.frames[i]);
+      account(1);
+    }
+  }
+
+  static void account(const std::int64_t n) {
+    util::MemoryUsage::add(util::MemoryUsage::Stacks, n * static_cast<std::int64_t>(sizeof(StackElem<Generator>)));
+  }
+};
+
+// Result of processing a node: stop the search, skip the node, skip the node and its remaining
+// siblings, or search below the node
+enum ProcessNodeRet { Exit, Prune, Break, Continue };
+
+// Iterative depth first search below n, the sequential engine of Seq, DepthBounded
+// (expandNoSpawns) and Ordered. Uses an explicit GeneratorStack rather than recursion, so deep
+// trees are only limited by maxStackDepth, not the thread stack.
+//
+// n itself (at depth nDepth) is not visited. Every node below it is passed to visit(node, depth)
+// and the result decides what happens next:
+// Exit stops the whole search (and is returned), Prune skips the node, Break skips the node and
+// its remaining siblings, and Continue searches below it. With depthLimited, nodes at maxDepth are
+// visited but never expanded.
+//
+// Before a child is built, preVisit(gen, i, childDepth) is asked about the ith child of gen. It
+// returns Continue to build and visit it as above, or Exit/Prune/Break with the same meaning
+// without the child ever being built; on Prune preVisit must have skipped the child in gen (see
+// ProcessNode::preProcessChild).
+//
+// For checkpointing the search can start at the firstChild'th child of n, and suspend() is asked
+// before every child whether to stop. If it says so, the remaining work of every frame is handed to
+// save(node, nodeDepth, firstChild) (meaning the children of node from firstChild on are left)
+// and Exit is returned.
+template <typename Generator, unsigned maxStackDepth, bool depthLimited,
+          typename Visit, typename PreVisit, typename Suspend, typename Save>
+ProcessNodeRet expandDepthFirst(const typename Generator::Spacetype & space,
+                                const typename Generator::Nodetype & n,
+                                const unsigned firstChild,
+                                const unsigned nDepth,
+                                const unsigned maxDepth,
+                                Visit && visit,
+                                PreVisit && preVisit,
+                                Suspend && suspend,
+                                Save && save) {
+  if constexpr(depthLimited) {
+    if (nDepth == maxDepth) {
+      return ProcessNodeRet::Continue;
+    }
+  }
+
+  StackElem<Generator> rootElem(space, n);
+  if (firstChild > 0) {
+    skipChildren(rootElem.gen, firstChild);
+    rootElem.seen = firstChild;
+  }
+  GeneratorStack<Generator> stack(maxStackDepth, rootElem);
+
+  int stackDepth = 0;
+  while (stackDepth >= 0) {
+    if (suspend()) {
+      for (auto d = 0; d <= stackDepth; ++d) {
+        if (stack[d].seen < stack[d].gen.numChildren) {
+          save(stack[d].node, nDepth + d, stack[d].seen);
+        }
+      }
+      return ProcessNodeRet::Exit;
+    }
+
+    auto & top = stack[stackDepth];
+    if (top.seen == top.gen.numChildren) {
+      --stackDepth;
+      continue;
+    }
+
+    const unsigned childDepth = nDepth + stackDepth + 1;
+    auto pre = preVisit(top.gen, top.seen, childDepth);
+    if (pre == ProcessNodeRet::Exit) { return ProcessNodeRet::Exit; }
+    else if (pre == ProcessNodeRet::Prune) {
+      top.seen++;
+      continue;
+    } else if (pre == ProcessNodeRet::Break) {
+      --stackDepth;
+      continue;
+    }
+
+    auto & next = stack[stackDepth + 1];
+    nextChildInto(top.gen, next.node);
+    top.seen++;
+
+    auto pn = visit(next.node, childDepth);
+    if (pn == ProcessNodeRet::Exit) { return ProcessNodeRet::Exit; }
+    else if (pn == ProcessNodeRet::Prune) { continue; }
+    else if (pn == ProcessNodeRet::Break) {
+      --stackDepth;
+      continue;
+    }
+
+    if constexpr(depthLimited) {
+      if (childDepth == maxDepth) {
+        continue;
+      }
+    }
+
+    resetGenerator(next.gen, space, next.node);
+    next.seen = 0;
+    ++stackDepth;
+  }
+
+  return ProcessNodeRet::Continue;
+}
+
+template <typename Generator, unsigned maxStackDepth, bool depthLimited, typename Visit, typename PreVisit>
+ProcessNodeRet expandDepthFirst(const typename Generator::Spacetype & space,
+                                const typename Generator::Nodetype & n,
+                                const unsigned nDepth,
+                                const unsigned maxDepth,
+                                Visit && visit,
+                                PreVisit && preVisit) {
+  return expandDepthFirst<Generator, maxStackDepth, depthLimited>(
+      space, n, 0, nDepth, maxDepth, std::forward<Visit>(visit), std::forward<PreVisit>(preVisit),
+      []() { return false; },
+      [](const typename Generator::Nodetype &, unsigned, unsigned) {});
+}
+
+template <typename Generator, unsigned maxStackDepth, bool depthLimited, typename Visit>
+ProcessNodeRet expandDepthFirst(const typename Generator::Spacetype & space,
+                                const typename Generator::Nodetype & n,
+                                const unsigned nDepth,
+                                const unsigned maxDepth,
+                                Visit && visit) {
+  return expandDepthFirst<Generator, maxStackDepth, depthLimited>(
+      space, n, nDepth, maxDepth, std::forward<Visit>(visit),
+      [](Generator &, unsigned, unsigned) { return ProcessNodeRet::Continue; });
+}
+
+}}
+
+#endif
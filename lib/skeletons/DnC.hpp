@@ -0,0 +1,301 @@
+#ifndef SKELETONS_DNC_HPP
+#define SKELETONS_DNC_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <hpx/apply.hpp>
+#include <hpx/lcos/broadcast.hpp>
+#include <hpx/lcos/local/promise.hpp>
+#include <hpx/include/iostreams.hpp>
+#include <hpx/runtime/find_here.hpp>
+#include <hpx/runtime/serialization/vector.hpp>
+
+#include "API.hpp"
+
+#include "util/AdaptiveSpawnDepth.hpp"
+#include "util/SearchContext.hpp"
+#include "util/util.hpp"
+
+#include "workstealing/Scheduler.hpp"
+#include "workstealing/policies/Workpool.hpp"
+#include "workstealing/policies/PerThreadWorkpool.hpp"
+#include "workstealing/policies/DepthPoolPolicy.hpp"
+#include "workstealing/WorkerStates.hpp"
+#include "workstealing/StealStats.hpp"
+
+namespace YewPar { namespace Skeletons {
+
+namespace DnC_ {
+
+template <typename Problem, typename ...Args>
+struct TaskAct;
+
+template <typename Problem, typename ...Args>
+struct DeliverAct;
+
+template <typename Problem, typename ...Args>
+struct InitAct;
+
+}
+
+// Divide and conquer on the YewPar scheduler (the same workpool policies as DepthBounded).
+//
+// Problem provides
+//
+//   typedef ... Input;
+//   typedef ... Result;
+//   static bool trivial(const Input &);       // solve directly?
+//   static Result base(const Input &);        // the direct solution
+//   static std::vector<Input> divide(const Input &);
+//   static Result conquer(const Input &, const std::vector<Result> &);
+//
+// trivial should only say whether an input can be divided at all, not whether it is worth
+// spawning: granularity is left to util::AdaptiveSpawnDepth, with Params::spawnDepth as the hint.
+// Down to spawnDepth subproblems are spawned unless the pool is saturated, below it only while
+// workers are starving and tasks at that depth have been big enough to be worth it. Everything
+// else is solved by plain recursion.
+//
+// A task that divides allocates a Join on its locality holding a slot per child. Children (run
+// anywhere) write their result into the slot, and whichever finishes last conquers and passes the
+// result on to its own parent's Join. Results so travel up the task tree with one counter per
+// spawning task rather than a future per call. The last child is always solved in the dividing
+// task itself rather than spawned.
+template <typename Problem, typename ...Args>
+struct DnC {
+  typedef typename Problem::Input Input;
+  typedef typename Problem::Result Result;
+
+  typedef typename API::skeleton_signature::bind<Args...>::type args;
+
+  typedef typename parameter::value_type<args, API::tag::Verbose_, std::integral_constant<unsigned, 0> >::type Verbose;
+  static constexpr unsigned verbose = Verbose::value;
+
+  typedef typename parameter::value_type<args, API::tag::DepthBoundedPoolPolicy, Workstealing::Policies::DepthPoolPolicy>::type Policy;
+
+  struct Join {
+    Input input;
+    std::vector<Result> results;
+    std::atomic<unsigned> pending;
+
+    // Where the result goes, parent == 0 for the root
+    hpx::naming::id_type parentLoc;
+    std::uintptr_t parent;
+    unsigned idx;
+
+    Join(const Input & in, const unsigned n, hpx::naming::id_type parentLoc,
+         const std::uintptr_t parent, const unsigned idx)
+        : input(in), results(n), pending(n), parentLoc(parentLoc), parent(parent), idx(idx) {}
+  };
+
+  // Per locality
+  static unsigned spawnDepth;
+
+  // Only on the locality running search()
+  static hpx::lcos::local::promise<Result> * rootResult;
+
+  static void init(const unsigned spawnDepth) {
+    DnC<Problem, Args...>::spawnDepth = spawnDepth;
+    util::AdaptiveSpawnDepth::reset();
+  }
+
+  static void printSkeletonDetails(const API::Params<> & params) {
+    hpx::cout << "Skeleton Type: DnC\n";
+    hpx::cout << "d_cutoff (hint): " << params.spawnDepth << "\n";
+    if constexpr (std::is_same<Policy, Workstealing::Policies::Workpool>::value) {
+      hpx::cout << "Workpool: Deque\n";
+    } else if constexpr (std::is_same<Policy, Workstealing::Policies::PerThreadWorkpool>::value) {
+      hpx::cout << "Workpool: PerThreadDeque\n";
+    } else {
+      hpx::cout << "Workpool: DepthPool\n";
+    }
+    hpx::cout << hpx::flush;
+  }
+
+  static Result sequential(const Input & in) {
+    if (Problem::trivial(in)) {
+      return Problem::base(in);
+    }
+
+    auto children = Problem::divide(in);
+    std::vector<Result> results;
+    results.reserve(children.size());
+    for (const auto & c : children) {
+      results.push_back(sequential(c));
+    }
+    return Problem::conquer(in, results);
+  }
+
+  // Result r fills slot idx of the Join at parent on this locality
+  static void deliverLocal(const std::uintptr_t parent, const unsigned idx, Result r) {
+    if (parent == 0) {
+      rootResult->set_value(std::move(r));
+      return;
+    }
+
+    auto j = reinterpret_cast<Join *>(parent);
+    j->results[idx] = std::move(r);
+    if (j->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      auto res = Problem::conquer(j->input, j->results);
+      auto loc = j->parentLoc;
+      auto p = j->parent;
+      auto i = j->idx;
+      delete j;
+      deliver(loc, p, i, std::move(res));
+    }
+  }
+
+  static void deliver(const hpx::naming::id_type & loc, const std::uintptr_t parent,
+                      const unsigned idx, Result r) {
+    if (loc == hpx::find_here()) {
+      deliverLocal(parent, idx, std::move(r));
+    } else {
+      hpx::apply<DnC_::DeliverAct<Problem, Args...> >(loc, parent, idx, std::move(r));
+    }
+  }
+
+  // Solve in (at depth) and deliver the result
+  static void solve(const Input & in, const unsigned depth, const hpx::naming::id_type & parentLoc,
+                    const std::uintptr_t parent, const unsigned idx) {
+    if (Problem::trivial(in)) {
+      deliver(parentLoc, parent, idx, Problem::base(in));
+      return;
+    }
+
+    if (!util::AdaptiveSpawnDepth::shouldSpawn(depth, spawnDepth)) {
+      deliver(parentLoc, parent, idx, sequential(in));
+      return;
+    }
+
+    auto children = Problem::divide(in);
+    if (children.empty()) {
+      deliver(parentLoc, parent, idx, Problem::conquer(in, {}));
+      return;
+    }
+
+    auto j = new Join(in, children.size(), parentLoc, parent, idx);
+    auto jp = reinterpret_cast<std::uintptr_t>(j);
+    auto here = hpx::find_here();
+    for (unsigned i = 0; i + 1 < children.size(); ++i) {
+      addTask(children[i], depth + 1, here, jp, i);
+    }
+    solve(children.back(), depth + 1, here, jp, children.size() - 1);
+  }
+
+  static void task(const Input in, const unsigned depth, const hpx::naming::id_type parentLoc,
+                   const std::uintptr_t parent, const unsigned idx) {
+    auto start = std::chrono::steady_clock::now();
+    solve(in, depth, parentLoc, parent, idx);
+    util::AdaptiveSpawnDepth::taskFinished(depth, std::chrono::steady_clock::now() - start);
+  }
+
+  static void addTask(const Input & in, const unsigned depth, const hpx::naming::id_type & parentLoc,
+                      const std::uintptr_t parent, const unsigned idx) {
+    DnC_::TaskAct<Problem, Args...> t;
+    hpx::util::function<void(hpx::naming::id_type)> task;
+    task = hpx::util::bind(t, hpx::util::placeholders::_1, in, depth, parentLoc, parent, idx);
+
+    auto workPool = std::static_pointer_cast<Policy>(Workstealing::Scheduler::local_policy);
+    if constexpr (std::is_same<Policy, Workstealing::Policies::Workpool>::value ||
+                  std::is_same<Policy, Workstealing::Policies::PerThreadWorkpool>::value) {
+      workPool->addwork(task);
+    } else {
+      workPool->addwork(task, depth - 1);
+    }
+  }
+
+  static Result search(const Input & root, const API::Params<> params = API::Params<>()) {
+    API::rejectCheckpoints(params, "DnC");
+
+    SearchContext ctx;
+
+    if constexpr(verbose > 1) {
+      Workstealing::StealStats::setEnabledEverywhere(true);
+    }
+
+    if constexpr (verbose) {
+      printSkeletonDetails(params);
+    }
+
+    hpx::wait_all(hpx::lcos::broadcast<DnC_::InitAct<Problem, Args...> >(
+        hpx::find_all_localities(), params.spawnDepth));
+
+    Policy::initPolicy();
+
+    hpx::wait_all(hpx::lcos::broadcast<Workstealing::Scheduler::startLocalSchedulers_act>(
+        hpx::find_all_localities()));
+
+    hpx::lcos::local::promise<Result> done;
+    auto res = done.get_future();
+    rootResult = &done;
+
+    addTask(root, 1, hpx::find_here(), 0, 0);
+    auto r = res.get();
+    rootResult = nullptr;
+
+    hpx::wait_all(hpx::lcos::broadcast<Workstealing::Scheduler::stopSchedulers_act>(
+        hpx::find_all_localities()));
+
+    if constexpr (verbose >= 2) {
+      Workstealing::WorkerStates::printAllReports();
+    }
+
+    if constexpr (verbose >= 3) {
+      Workstealing::StealStats::printAllReports();
+    }
+
+    if constexpr (verbose) {
+      util::printOnEachLocality<util::AdaptiveSpawnDepth::printReport_act>();
+    }
+
+    return r;
+  }
+};
+
+template <typename Problem, typename ...Args>
+unsigned DnC<Problem, Args...>::spawnDepth = 1;
+
+template <typename Problem, typename ...Args>
+hpx::lcos::local::promise<typename Problem::Result> * DnC<Problem, Args...>::rootResult = nullptr;
+
+namespace DnC_ {
+
+template <typename Problem, typename ...Args>
+struct TaskAct : hpx::actions::make_action<
+  decltype(&DnC<Problem, Args...>::task),
+  &DnC<Problem, Args...>::task,
+  TaskAct<Problem, Args...>>::type {};
+
+template <typename Problem, typename ...Args>
+struct DeliverAct : hpx::actions::make_action<
+  decltype(&DnC<Problem, Args...>::deliverLocal),
+  &DnC<Problem, Args...>::deliverLocal,
+  DeliverAct<Problem, Args...>>::type {};
+
+template <typename Problem, typename ...Args>
+struct InitAct : hpx::actions::make_action<
+  decltype(&DnC<Problem, Args...>::init),
+  &DnC<Problem, Args...>::init,
+  InitAct<Problem, Args...>>::type {};
+
+}
+
+}}
+
+namespace hpx { namespace traits {
+
+template <typename Problem, typename ...Args>
+struct action_stacksize<YewPar::Skeletons::DnC_::TaskAct<Problem, Args...> > {
+  enum { value = threads::thread_stacksize_huge };
+};
+
+template <typename Problem, typename ...Args>
+struct action_stacksize<YewPar::Skeletons::DnC_::DeliverAct<Problem, Args...> > {
+  enum { value = threads::thread_stacksize_huge };
+};
+
+}}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef SKELETONS_HYBRID_HPP
+#define SKELETONS_HYBRID_HPP
+
+#include "API.hpp"
+#include "StackStealing.hpp"
+
+namespace YewPar { namespace Skeletons {
+
+// DepthBounded style spawning down to params.spawnDepth, StackStealing below it. Nodes above the
+// cutoff are expanded and every surviving child is spawned as a task into the search manager's
+// buffers; tasks below the cutoff run on a stack that idle workers steal from once the buffers
+// have drained. Both halves share one scheduler, one policy (SearchManager) and its counters.
+//
+// Takes the same parameters as StackStealing. spawnDepth = 0 is plain stack stealing with a
+// single initial task.
+template <typename Generator, typename ...Args>
+struct Hybrid : StackStealing<Generator, API::HybridSpawns, Args...> {};
+
+}}
+
+#endif
@@ -4,8 +4,14 @@
 #include <iostream>
 #include <vector>
 #include <cstdint>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
 
 #include <hpx/lcos/broadcast.hpp>
+#include <hpx/lcos/local/condition_variable.hpp>
+#include <hpx/lcos/local/mutex.hpp>
 #include <hpx/include/iostreams.hpp>
 
 #include <boost/format.hpp>
@@ -17,11 +23,15 @@
 #include "util/Incumbent.hpp"
 #include "util/Enumerator.hpp"
 #include "util/func.hpp"
-#include "util/DistSetOnceFlag.hpp"
+#include "util/ClaimTable.hpp"
+#include "util/TreeEstimator.hpp"
+#include "util/Log.hpp"
+#include "util/TaskPool.hpp"
 
 #include "Common.hpp"
 
 #include "workstealing/policies/PriorityOrdered.hpp"
+#include "workstealing/WorkerStates.hpp"
 
 namespace YewPar { namespace Skeletons {
 
@@ -35,13 +45,18 @@ struct Ordered {
   typedef typename Generator::Nodetype Node;
   typedef typename Generator::Spacetype Space;
 
+  static_assert(isNodeGenerator<Generator>::value,
+                "Generator needs Nodetype, Spacetype, numChildren, next() and a (Space, Node) constructor");
+
   typedef typename API::skeleton_signature::bind<Args...>::type args;
 
   static constexpr bool isEnumeration = parameter::value_type<args, API::tag::Enumeration_, std::integral_constant<bool, false> >::type::value;
   static constexpr bool isOptimisation = parameter::value_type<args, API::tag::Optimisation_, std::integral_constant<bool, false> >::type::value;
   static constexpr bool isDecision = parameter::value_type<args, API::tag::Decision_, std::integral_constant<bool, false> >::type::value;
   static constexpr bool isDepthBounded = parameter::value_type<args, API::tag::DepthLimited_, std::integral_constant<bool, false> >::type::value;
+  static constexpr unsigned maxStackDepth = parameter::value_type<args, API::tag::MaxStackDepth, std::integral_constant<unsigned, 5000> >::type::value;
   static constexpr bool pruneLevel = parameter::value_type<args, API::tag::PruneLevel_, std::integral_constant<bool, false> >::type::value;
+  static constexpr bool lazyIncumbent = parameter::value_type<args, API::tag::LazyIncumbent_, std::integral_constant<bool, false> >::type::value;
   static constexpr bool discrepancySearch = parameter::value_type<args, API::tag::DiscrepancySearch_, std::integral_constant<bool, false> >::type::value;
 
   typedef typename parameter::value_type<args, API::tag::Verbose_, std::integral_constant<unsigned, 0> >::type Verbose;
@@ -52,6 +67,8 @@ struct Ordered {
   typedef typename parameter::value_type<args, API::tag::ObjectiveComparison, std::greater<Bound> >::type Objcmp;
   typedef typename parameter::value_type<args, API::tag::Enumerator, IdentityEnumerator<Node>>::type Enum;
 
+  typedef ProcessNode<Space, Node, Args...> PN;
+
   static void printSkeletonDetails() {
     hpx::cout << "Skeleton Type: Ordered\n";
     hpx::cout << "Enumeration : " << std::boolalpha << isEnumeration << "\n";
@@ -67,153 +84,213 @@ struct Ordered {
     hpx::cout << hpx::flush;
   }
 
+  // Tasks are claimed (by the sequential thread or a worker) through the ClaimTable using their
+  // position in the task list as id
   struct OrderedTask {
-    OrderedTask(const Node n, unsigned priority) : node(n), priority(priority) {
-      startedFlag = hpx::new_<YewPar::util::DistSetOnceFlag>(hpx::find_here()).get();
-    };
+    OrderedTask(const Node n, unsigned priority) : node(n), priority(priority), id(0) {};
     const Node node;
     unsigned priority;
-    hpx::naming::id_type startedFlag;
+    std::uint64_t id;
+  };
+
+  // Tasks in order of id. The generator appends to it while the sequential thread (and the workers,
+  // through the policy) already run the earlier tasks.
+  struct TaskStream {
+    hpx::lcos::local::mutex mtx;
+    hpx::lcos::local::condition_variable cv;
+    std::deque<OrderedTask> tasks;
+    bool done = false;
   };
 
-  // Spawn tasks in a discrepancy search fashion
-  // Discrepancy search priority based on number of discrepancies taken
+  // All nodes depth levels below n, in depth first order. For discrepancy search the priority is
+  // the number of discrepancies taken to reach the node.
+  static void collectTasks(const Space & space,
+                           unsigned depth,
+                           unsigned numDisc,
+                           const Node & n,
+                           std::vector<OrderedTask> & tasks) {
+    if (depth == 0) {
+      tasks.emplace_back(OrderedTask(n, numDisc));
+      return;
+    }
+
+    auto newCands = Generator(space, n);
+    for (auto i = 0; i < newCands.numChildren; ++i) {
+      auto node = newCands.next();
+      collectTasks(space, depth - 1, numDisc + i, node, tasks);
+    }
+  }
+
+  // Spawn all tasks spawnDepth levels below the root. The subtrees below each of the root's
+  // children are expanded in parallel, but their tasks are published strictly in order so ids (and,
+  // for linear search, priorities) are the same as for a sequential depth first expansion.
   // Invariant: spawnDepth > 0
-  static std::vector<OrderedTask> prioritiseTasks(const Space & space,
-                                                  unsigned spawnDepth,
-                                                  const Node & root) {
-    std::vector<OrderedTask> tasks;
-    if constexpr (discrepancySearch) {
-      std::function<void(unsigned, unsigned, const Node &)>
-          fn = [&](unsigned depth, unsigned numDisc, const Node & n) {
-        if (depth == 0) {
-          tasks.emplace_back(OrderedTask(n, numDisc));
-        } else {
-          auto newCands = Generator(space, n);
-          for (auto i = 0; i < newCands.numChildren; ++i) {
-            auto node = newCands.next();
-            fn(depth - 1, numDisc + i, node);
-          }
+  static void prioritiseTasks(unsigned spawnDepth,
+                              const Node & root,
+                              std::shared_ptr<TaskStream> stream) {
+    auto reg = Registry<Space, Node, Bound, Enum>::gReg;
+    const auto & space = reg->localSpace();
+    auto spawn_start_time = std::chrono::steady_clock::now();
+
+    std::vector<hpx::future<std::vector<OrderedTask> > > parts;
+    auto rootCands = Generator(space, root);
+    for (auto i = 0; i < rootCands.numChildren; ++i) {
+      auto c = rootCands.next();
+      if (spawnDepth == 1) {
+        parts.push_back(hpx::make_ready_future(std::vector<OrderedTask> {OrderedTask(c, i)}));
+      } else {
+        parts.push_back(hpx::async([&space, spawnDepth, i](const Node & c) {
+              std::vector<OrderedTask> tasks;
+              collectTasks(space, spawnDepth - 1, i, c, tasks);
+              return tasks;
+            }, std::move(c)));
+      }
+    }
+
+    auto policy = std::static_pointer_cast<Workstealing::Policies::PriorityOrderedPolicy>(
+        Workstealing::Scheduler::local_policy);
+
+    std::uint64_t numTasks = 0;
+    for (auto & part : parts) {
+      if constexpr(isDecision) {
+        if (reg->shouldStop()) {
+          break;
         }
-      };
-      fn(spawnDepth, 0, root);
-      // Linear task spawning
-    } else {
-      std::function<void(unsigned, const Node &)> fn =
-          [&](unsigned depth, const Node & n) {
-        if (depth == 0) {
-          tasks.emplace_back(OrderedTask(n, 0));
-        } else {
-          auto newCands = Generator(space, n);
-          for (auto i = 0; i < newCands.numChildren; ++i) {
-            auto node = newCands.next();
-            fn(depth - 1, node);
-          }
+      }
+
+      auto tasks = part.get();
+      for (auto & t : tasks) {
+        t.id = numTasks++;
+        if constexpr(!discrepancySearch) {
+          // Linear order
+          t.priority = t.id;
         }
-      };
-      fn(spawnDepth, root);
 
-      // Reassign priorities from 0 to get a fixed order
-      for (auto i = 0; i < tasks.size(); ++i) {
-        tasks[i].priority = i;
+        Ordered_::SubtreeTask<Generator, Args...> child;
+        hpx::util::function<void(hpx::naming::id_type)> task;
+        task = util::TaskPool::pooledTask(hpx::util::bind(child, hpx::util::placeholders::_1, t.node, t.id));
+        policy->addwork(t.priority, std::move(task));
+      }
+
+      {
+        std::lock_guard<hpx::lcos::local::mutex> l(stream->mtx);
+        for (auto & t : tasks) {
+          stream->tasks.push_back(t);
+        }
       }
+      stream->cv.notify_all();
     }
 
-    if (verbose > 1) {
-      hpx::cout <<
-          (boost::format("Ordered Skeleton Spawned %1% Tasks\n") % tasks.size())
-                << hpx::flush;
+    // Nothing may still be using the registry once we report being done
+    hpx::wait_all(parts);
+
+    {
+      std::lock_guard<hpx::lcos::local::mutex> l(stream->mtx);
+      stream->done = true;
     }
+    stream->cv.notify_all();
 
-    return tasks;
+    if (verbose > 1) {
+      auto spawn_time = std::chrono::duration_cast<std::chrono::milliseconds>
+          (std::chrono::steady_clock::now() - spawn_start_time);
+      util::Log::write((boost::format("Ordered Skeleton Spawned %1% Tasks\n"
+                                      "Ordered Skeleton, time to spawn tasks: %2% ms\n")
+                        % numTasks % spawn_time.count()).str());
+    }
   }
+
   static void expandNoSpawns(const Space & space,
                              const Node & n,
                              const API::Params<Bound> & params,
                              Enum & acc,
                              const unsigned childDepth) {
     auto reg = Registry<Space, Node, Bound, Enum>::gReg;
-    Generator newCands = Generator(space, n);
 
     if constexpr(isDecision) {
-        if (reg->stopSearch) {
+        if (reg->shouldStop()) {
           return;
         }
       }
 
-    if constexpr(isDepthBounded) {
-        if (childDepth == params.maxDepth) {
-          return;
-        }
-    }
+    expandDepthFirst<Generator, maxStackDepth, isDepthBounded>(
+        space, n, childDepth, params.maxDepth,
+        [&](const Node & c, const unsigned depth) {
+          if constexpr(isDecision) {
+            if (reg->shouldStop()) {
+              return ProcessNodeRet::Exit;
+            }
+          }
+          return PN::processNode(params, space, c, depth - 1, acc, PN::template batchedBounds<Generator>);
+        },
+        [&](Generator & gen, const unsigned i, const unsigned depth) {
+          return PN::preProcessChild(params, gen, i, depth, acc);
+        });
+  }
 
-    for (auto i = 0; i < newCands.numChildren; ++i) {
-      auto c = newCands.next();
+  static auto search (const Space & space,
+                      const Node & root,
+                      API::Params<Bound> params = API::Params<Bound>()) {
+    API::rejectCheckpoints(params, "Ordered");
 
-      auto pn = ProcessNode<Space, Node, Args...>::processNode(params, space, c, acc);
-      if (pn == ProcessNodeRet::Exit) { return; }
-      else if (pn == ProcessNodeRet::Prune) { continue; }
-      else if (pn == ProcessNodeRet::Break) { break; }
+    SearchContext ctx;
 
-      expandNoSpawns(space, c, params, acc, childDepth + 1);
+    if (params.autoTune) {
+      util::autoTune<Generator, isDepthBounded>(space, root, params, verbose);
     }
-  }
 
-  static auto search (const Space & space,
-                      const Node & root,
-                      const API::Params<Bound> params = API::Params<Bound>()) {
     if constexpr(verbose) {
       printSkeletonDetails();
     }
 
-    hpx::wait_all(hpx::lcos::broadcast<InitRegistryAct<Space, Node, Bound, Enum> >(
-        hpx::find_all_localities(), space, root, params));
+    initRegistries<Space, Node, Bound, Enum>(space, root, params);
+
+    PN::initSearch(params);
+    util::TaskTrace::begin(params.traceFile, params.traceBufferSize);
 
     if constexpr(isOptimisation || isDecision) {
       auto inc = hpx::new_<Incumbent>(hpx::find_here()).get();
       hpx::wait_all(hpx::lcos::broadcast<UpdateGlobalIncumbentAct<Space, Node, Bound, Enum> >(
           hpx::find_all_localities(), inc));
-      initIncumbent<Space, Node, Bound, Enum, Objcmp, Verbose>(root, params.initialBound);
+      PN::initIncumbent(root, params);
     }
 
     Workstealing::Policies::PriorityOrderedPolicy::initPolicy();
 
-    auto spawn_start_time = std::chrono::steady_clock::now();
-    // Spawn all tasks to some depth *ordered*
-    auto tasks = prioritiseTasks(space, params.spawnDepth, root);
-    for (auto const & t : tasks) {
-      Ordered_::SubtreeTask<Generator, Args...> child;
-      hpx::util::function<void(hpx::naming::id_type)> task;
-      task = hpx::util::bind(child, hpx::util::placeholders::_1, t.node, t.startedFlag);
-      std::static_pointer_cast<Workstealing::Policies::PriorityOrderedPolicy>
-          (Workstealing::Scheduler::local_policy)->addwork(t.priority, std::move(task));
-    }
+    // Ids are only known once tasks are generated, the claim table grows as they are used
+    hpx::wait_all(hpx::lcos::broadcast<YewPar::util::ClaimTable::reset_act>(
+        hpx::find_all_localities(), 0, hpx::get_locality_id()));
 
-    if (verbose > 1) {
-      auto spawn_time = std::chrono::duration_cast<std::chrono::milliseconds>
-          (std::chrono::steady_clock::now() - spawn_start_time);
-      hpx::cout <<
-          (boost::format("Ordered Skeleton, time to spawn tasks: %1% ms\n") % spawn_time.count())
-                << hpx::flush;
-    }
+    // Spawn all tasks to some depth *ordered*, in the background so work can start on the first
+    // tasks straight away
+    auto stream = std::make_shared<TaskStream>();
+    auto generator = hpx::async(&prioritiseTasks, params.spawnDepth, root, stream);
 
-    // We need to start 1 less thread on the master locality than everywhere
-    // else to handle the sequential order
+    // We need to start 1 less thread on the master locality than it would
+    // otherwise to handle the sequential order
     auto allLocs = hpx::find_all_localities();
     allLocs.erase(std::remove(allLocs.begin(), allLocs.end(), hpx::find_here()), allLocs.end());
 
-    auto threadCount = hpx::get_os_thread_count() == 1 ? 1 : hpx::get_os_thread_count() - 1;
-    hpx::wait_all(hpx::lcos::broadcast<Workstealing::Scheduler::startSchedulers_act>(allLocs, threadCount));
+    hpx::wait_all(hpx::lcos::broadcast<Workstealing::Scheduler::startLocalSchedulers_act>(allLocs));
 
-    auto threadCountLocal = hpx::get_os_thread_count() <= 2 ? 0 : hpx::get_os_thread_count() - 2;
-    Workstealing::Scheduler::startSchedulers(threadCountLocal);
+    Workstealing::Scheduler::startLocalSchedulersBeside(1);
 
     // Make this thread the sequential thread of execution.
     auto reg = Registry<Space, Node, Bound, Enum>::gReg;
-    for (auto & t : tasks) {
+    for (std::size_t next = 0; ; ++next) {
+      const OrderedTask * t;
+      {
+        std::unique_lock<hpx::lcos::local::mutex> l(stream->mtx);
+        stream->cv.wait(l, [&]() { return next < stream->tasks.size() || stream->done; });
+        if (next >= stream->tasks.size()) {
+          break;
+        }
+        // Deque elements don't move as more are added
+        t = &stream->tasks[next];
+      }
+
       // Allow early termination of sequential thread
       if constexpr(isDecision) {
-        if (reg->stopSearch) {
+        if (reg->shouldStop()) {
           break;
         }
       }
@@ -221,29 +298,36 @@ struct Ordered {
       // Quick prune path to avoid writing global flags
       if constexpr(isOptimisation && !std::is_same<boundFn, nullFn__>::value) {
         Objcmp cmp;
-        auto best = reg->localBound.load();
-        auto bnd  = boundFn::invoke(space, t.node);
+        auto best = reg->localBound.load(std::memory_order_relaxed);
+        auto bnd  = boundFn::invoke(space, t->node);
         if (!cmp(bnd,best)) {
           continue;
         }
       }
 
-      auto weStarted = hpx::async<YewPar::util::DistSetOnceFlag::set_value_action>(t.startedFlag).get();
-      if (weStarted) {
+      // The claim table lives here so this never leaves the locality
+      if (YewPar::util::ClaimTable::claim(t->id)) {
         Enum acc;
-        expandNoSpawns(space, t.node, params, acc, params.spawnDepth);
+        expandNoSpawns(space, t->node, params, acc, params.spawnDepth);
       }
     }
 
+    generator.get();
+
     // We have either seen everything or terminated early to make sure everyone stops
     hpx::wait_all(hpx::lcos::broadcast<Workstealing::Scheduler::stopSchedulers_act>(
         hpx::find_all_localities()));
 
+    if constexpr (verbose >= 2) {
+      Workstealing::WorkerStates::printAllReports();
+    }
+
+    util::TaskTrace::end(params.traceFile);
+    PN::printReports();
+
     // Return the right thing
     if constexpr(isOptimisation || isDecision) {
-      auto reg = Registry<Space, Node, Bound, Enum>::gReg;
-      typedef typename Incumbent::GetIncumbentAct<Node, Bound, Objcmp, Verbose> getInc;
-      return hpx::async<getInc>(reg->globalIncumbent).get();
+      return getFinalIncumbent<Space, Node, Bound, Enum, Objcmp, Verbose, lazyIncumbent>();
     } else {
       static_assert(isEnumeration, "Please provide a supported search type: Enumeration, Optimisation, Decision");
       static_assert(isOptimisation || isDecision, "Please provide a supported search type: Enumeration, Optimisation, Decision");
@@ -251,11 +335,11 @@ struct Ordered {
   }
 
   static void subtreeTask(const Node taskRoot,
-                          const hpx::naming::id_type started) {
+                          const std::uint64_t taskId) {
     // Don't bother checking if the sequential thread has done this task since we are stopping anyway
     auto reg = Registry<Space, Node, Bound, Enum>::gReg;
     if constexpr (isDecision) {
-      if (reg->stopSearch) {
+      if (reg->shouldStop()) {
         return;
       }
     }
@@ -263,18 +347,20 @@ struct Ordered {
     // Quick prune path
     if constexpr(isOptimisation && !std::is_same<boundFn, nullFn__>::value) {
       Objcmp cmp;
-      auto best = reg->localBound.load();
-      auto bnd  = boundFn::invoke(reg->space, taskRoot);
+      auto best = reg->localBound.load(std::memory_order_relaxed);
+      auto bnd  = boundFn::invoke(reg->localSpace(), taskRoot);
       if (!cmp(bnd,best)) {
         return;
       }
     }
 
-    auto weStarted = hpx::async<YewPar::util::DistSetOnceFlag::set_value_action>(started).get();
     // Sequential thread has beaten us to this task. Don't bother executing it again.
-    if (weStarted) {
+    if (YewPar::util::ClaimTable::claim(taskId)) {
+      // Tasks are all generated by the locality running search()
+      util::TaskTrace::ScopedTask trace(reg->params.spawnDepth + 1,
+                                        util::TaskTrace::originOf(false, hpx::find_root_locality()));
       Enum acc;
-      expandNoSpawns(reg->space, taskRoot, reg->params, acc, reg->params.spawnDepth);
+      expandNoSpawns(reg->localSpace(), taskRoot, reg->params, acc, reg->params.spawnDepth);
     }
   }
 };
@@ -0,0 +1,248 @@
+#ifndef SKELETONS_PORTFOLIO_HPP
+#define SKELETONS_PORTFOLIO_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <hpx/lcos/broadcast.hpp>
+#include <hpx/lcos/local/condition_variable.hpp>
+#include <hpx/lcos/local/mutex.hpp>
+#include <hpx/include/iostreams.hpp>
+
+#include <boost/format.hpp>
+
+#include "API.hpp"
+
+#include "util/NodeGenerator.hpp"
+#include "util/IncumbentTimeline.hpp"
+#include "util/Registry.hpp"
+#include "util/func.hpp"
+
+#include "DepthBounded.hpp"
+#include "StackStealing.hpp"
+#include "Budget.hpp"
+#include "Ordered.hpp"
+
+namespace YewPar { namespace Skeletons {
+
+enum class PortfolioSkeleton { DepthBounded, StackStealing, Budget, Ordered };
+
+// Races several skeleton/parameter configurations against each other on one instance.
+//
+// The schedulers are per locality, so configurations can't share the workers at the same time.
+// Instead they take turns: in round r every configuration runs on all workers for
+// Params::portfolioSliceMillis * 2^r ms before it is stopped (through the Registry stop flag) and
+// the next one starts. The first run to finish within its slice has searched the whole tree, so its
+// answer is final. Incumbents carry over between runs as the next run's initialBound, so every
+// configuration prunes with the best bound found by any of them, and a decision search ends as soon
+// as any run finds a solution.
+template <typename Generator, typename ...Args>
+struct Portfolio {
+  typedef typename Generator::Nodetype Node;
+  typedef typename Generator::Spacetype Space;
+
+  static_assert(isNodeGenerator<Generator>::value,
+                "Generator needs Nodetype, Spacetype, numChildren, next() and a (Space, Node) constructor");
+
+  typedef typename API::skeleton_signature::bind<Args...>::type args;
+
+  static constexpr bool isOptimisation = parameter::value_type<args, API::tag::Optimisation_, std::integral_constant<bool, false> >::type::value;
+  static constexpr bool isDecision = parameter::value_type<args, API::tag::Decision_, std::integral_constant<bool, false> >::type::value;
+
+  typedef typename parameter::value_type<args, API::tag::Verbose_, std::integral_constant<unsigned, 0> >::type Verbose;
+  static constexpr unsigned verbose = Verbose::value;
+
+  typedef typename parameter::value_type<args, API::tag::BoundFunction, nullFn__>::type boundFn;
+  typedef typename boundFn::return_type Bound;
+  typedef typename parameter::value_type<args, API::tag::ObjectiveComparison, std::greater<Bound> >::type Objcmp;
+  typedef typename parameter::value_type<args, API::tag::Enumerator, IdentityEnumerator<Node>>::type Enum;
+
+  static_assert(isOptimisation || isDecision, "Portfolio supports Optimisation and Decision searches");
+
+  // initialBound and expectedObjective are taken from the Portfolio's own params
+  struct Config {
+    PortfolioSkeleton skeleton;
+    API::Params<Bound> params;
+  };
+
+  // Slices stop doubling here
+  static constexpr unsigned maxSliceShift = 20;
+
+  static std::string skeletonName(const PortfolioSkeleton s) {
+    switch (s) {
+      case PortfolioSkeleton::DepthBounded: return "depthbounded";
+      case PortfolioSkeleton::StackStealing: return "stacksteal";
+      case PortfolioSkeleton::Budget: return "budget";
+      case PortfolioSkeleton::Ordered: return "ordered";
+    }
+    return "unknown";
+  }
+
+  static void printSkeletonDetails(const std::vector<Config> & configs, const API::Params<Bound> & params) {
+    hpx::cout << "Skeleton Type: Portfolio\n";
+    hpx::cout << "Optimisation: " << std::boolalpha << isOptimisation << "\n";
+    hpx::cout << "Decision: " << std::boolalpha << isDecision << "\n";
+    hpx::cout << "Slice (ms): " << params.portfolioSliceMillis << "\n";
+    hpx::cout << "Configurations:";
+    for (const auto & c : configs) {
+      hpx::cout << " " << skeletonName(c.skeleton);
+    }
+    hpx::cout << "\n" << hpx::flush;
+  }
+
+  static Node runConfig(const Config & cfg, const Space & space, const Node & root) {
+    switch (cfg.skeleton) {
+      case PortfolioSkeleton::DepthBounded:
+        return DepthBounded<Generator, Args...>::search(space, root, cfg.params);
+      case PortfolioSkeleton::StackStealing:
+        return StackStealing<Generator, Args...>::search(space, root, cfg.params);
+      case PortfolioSkeleton::Budget:
+        return Budget<Generator, Args...>::search(space, root, cfg.params);
+      case PortfolioSkeleton::Ordered:
+        return Ordered<Generator, Args...>::search(space, root, cfg.params);
+    }
+    return root;
+  }
+
+  // Run cfg, stopping it after limit (if non zero). timedOut is set if it was stopped.
+  static Node runFor(const Config & cfg, const Space & space, const Node & root,
+                     const std::chrono::milliseconds limit, bool & timedOut) {
+    if (limit.count() == 0) {
+      timedOut = false;
+      return runConfig(cfg, space, root);
+    }
+
+    hpx::lcos::local::mutex mtx;
+    hpx::lcos::local::condition_variable cv;
+    bool finished = false;
+    bool expired = false;
+    auto previousSearch = currentSearchId();
+
+    auto timer = hpx::async([&]() {
+      std::unique_lock<hpx::lcos::local::mutex> l(mtx);
+      if (cv.wait_for(l, limit, [&]() { return finished; })) {
+        return;
+      }
+
+      // The stop is for the run's search, which is the first one after previousSearch. If it hasn't
+      // initialised its registries everywhere yet they keep the stop rather than clearing it.
+      while (currentSearchId() == previousSearch) {
+        if (cv.wait_for(l, std::chrono::milliseconds(1), [&]() { return finished; })) {
+          return;
+        }
+      }
+      expired = true;
+      l.unlock();
+      hpx::wait_all(hpx::lcos::broadcast<StopAndCancelSearchAct<Space, Node, Bound, Enum> >(
+          hpx::find_all_localities(), currentSearchId()));
+    });
+
+    auto sol = runConfig(cfg, space, root);
+    {
+      std::lock_guard<hpx::lcos::local::mutex> l(mtx);
+      finished = true;
+    }
+    cv.notify_all();
+
+    // The next run re-initialises the registries, the stop must have landed by then
+    timer.get();
+
+    // A run that completed just as the time ran out never saw the stop, its answer is final
+    timedOut = false;
+    if (expired) {
+      for (auto observed : hpx::lcos::broadcast<StopObservedAct<Space, Node, Bound, Enum> >(
+               hpx::find_all_localities()).get()) {
+        timedOut = timedOut || observed;
+      }
+    }
+    return sol;
+  }
+
+  static auto search (const Space & space,
+                      const Node & root,
+                      const std::vector<Config> & configs,
+                      const API::Params<Bound> params = API::Params<Bound>()) {
+    // Runs are stopped and restarted from the best bound, a checkpoint would only cover one of them
+    API::rejectCheckpoints(params, "Portfolio");
+    for (const auto & cfg : configs) {
+      API::rejectCheckpoints(cfg.params, "Portfolio");
+    }
+
+    if constexpr(verbose) {
+      printSkeletonDetails(configs, params);
+    }
+
+    auto best = root;
+    auto bestBound = params.initialBound;
+    Objcmp cmp;
+
+    // Each run's timeline, shifted to the start of the portfolio. Runs start from the best bound
+    // so far, so every improvement they record is one for the portfolio as well.
+    auto & timeline = lastIncumbentTimeline<Bound>();
+    IncumbentTimeline<Bound> portfolioTimeline;
+    auto portfolioStart = std::chrono::steady_clock::now();
+
+    if (configs.empty()) {
+      timeline = portfolioTimeline;
+      return best;
+    }
+
+    for (unsigned round = 0; ; ++round) {
+      std::chrono::milliseconds limit(0);
+      if (params.portfolioSliceMillis > 0) {
+        limit = std::chrono::milliseconds(
+            static_cast<std::uint64_t>(params.portfolioSliceMillis) << std::min(round, maxSliceShift));
+      }
+
+      for (auto i = 0; i < configs.size(); ++i) {
+        auto cfg = configs[i];
+        cfg.params.expectedObjective = params.expectedObjective;
+        cfg.params.initialBound = bestBound;
+
+        bool timedOut;
+        auto start = std::chrono::steady_clock::now();
+        auto sol = runFor(cfg, space, root, limit, timedOut);
+
+        std::chrono::duration<double> offset = start - portfolioStart;
+        for (auto imp : timeline.improvements) {
+          imp.seconds += offset.count();
+          portfolioTimeline.improvements.push_back(imp);
+        }
+        timeline = portfolioTimeline;
+
+        if constexpr(verbose > 1) {
+          auto t = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+          hpx::cout << (boost::format("Portfolio: round %1% %2% (config %3%) ran %4% ms%5%\n")
+                        % round % skeletonName(cfg.skeleton) % i % t.count()
+                        % (timedOut ? ", out of time" : ""))
+                    << hpx::flush;
+        }
+
+        if constexpr(isDecision) {
+          if (sol.getObj() == params.expectedObjective || !timedOut) {
+            return sol;
+          }
+        } else {
+          // A run that found nothing better returns the root, so ask the registry whether it improved
+          auto found = Registry<Space, Node, Bound, Enum>::gReg->localBound.load();
+          if (cmp(found, bestBound)) {
+            best = sol;
+            bestBound = found;
+          }
+          if (!timedOut) {
+            return best;
+          }
+        }
+      }
+    }
+  }
+};
+
+}}
+
+#endif
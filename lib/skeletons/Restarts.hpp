@@ -0,0 +1,398 @@
+#ifndef SKELETONS_RESTARTS_HPP
+#define SKELETONS_RESTARTS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <hpx/lcos/broadcast.hpp>
+#include <hpx/include/iostreams.hpp>
+#include <hpx/include/threads.hpp>
+#include <hpx/runtime/serialization/vector.hpp>
+
+#include <boost/format.hpp>
+
+#include "API.hpp"
+
+#include "util/NodeGenerator.hpp"
+#include "util/Nogoods.hpp"
+#include "util/Registry.hpp"
+#include "util/Incumbent.hpp"
+#include "util/SearchContext.hpp"
+#include "util/func.hpp"
+#include "util/util.hpp"
+
+#include "Common.hpp"
+
+#include "workstealing/Scheduler.hpp"
+
+namespace YewPar { namespace Skeletons {
+
+namespace Restarts_ {
+template <typename Generator, typename ...Args>
+struct RunWorkersAct;
+template <typename Generator, typename ...Args>
+struct AddNogoodsAct;
+template <typename Generator, typename ...Args>
+struct PrintReportAct;
+}
+
+// Restarting decision search, for problems with heavy tailed runtimes where one bad early choice
+// can cost hours and another order finishes in seconds.
+//
+// Every worker of every locality searches the whole tree depth first on its own, visiting each
+// node's children in a fresh random order, and gives up on a run after
+// Params::restartBacktracks * luby(n) backtracks (1, 1, 2, 1, 1, 2, 4, ... for its n'th run). At a
+// restart the run's refuted subtrees (the children already searched on each level of the current
+// branch) become nogoods, which go to the Registry of this and every other locality. Every run
+// reads the nogoods added since its last start, and skips those subtrees without building them,
+// so later runs pick up where the earlier ones (on any worker) left off.
+//
+// The first worker to find a solution stops every locality (through the Registry stop flag, as
+// other decision searches do). A run that searches the whole tree without restarting shows there
+// is no solution, and stops everyone the same way.
+//
+// Children are built by skipping to them in a fresh generator, so generators should provide skip
+// (see NodeGenerator.hpp), otherwise each child costs building all those before it.
+template <typename Generator, typename ...Args>
+struct Restarts {
+  typedef typename Generator::Nodetype Node;
+  typedef typename Generator::Spacetype Space;
+
+  static_assert(isNodeGenerator<Generator>::value,
+                "Generator needs Nodetype, Spacetype, numChildren, next() and a (Space, Node) constructor");
+
+  typedef typename API::skeleton_signature::bind<Args...>::type args;
+
+  static constexpr bool isDecision = parameter::value_type<args, API::tag::Decision_, std::integral_constant<bool, false> >::type::value;
+  static constexpr bool isDepthLimited = parameter::value_type<args, API::tag::DepthLimited_, std::integral_constant<bool, false> >::type::value;
+
+  typedef typename parameter::value_type<args, API::tag::Verbose_, std::integral_constant<unsigned, 0> >::type Verbose;
+  static constexpr unsigned verbose = Verbose::value;
+
+  typedef typename parameter::value_type<args, API::tag::BoundFunction, nullFn__>::type boundFn;
+  typedef typename boundFn::return_type Bound;
+  typedef typename parameter::value_type<args, API::tag::ObjectiveComparison, std::greater<Bound> >::type Objcmp;
+  typedef typename parameter::value_type<args, API::tag::Enumerator, IdentityEnumerator<Node>>::type Enum;
+
+  typedef ProcessNode<Space, Node, Args...> PN;
+
+  static_assert(isDecision, "Restarts supports Decision searches");
+  // A memo entry only says a state was reached before, not that it was searched to the end
+  static_assert(!PN::memoize, "Restarts can't use Memoize");
+
+  enum class RunResult { Exhausted, Restart, Stopped };
+
+  // A node on the current branch, its children in the order this run visits them and how many of
+  // them have been started
+  struct Frame {
+    Node node;
+    // Index of node among its parent's children
+    std::uint32_t index;
+    std::vector<std::uint32_t> order;
+    unsigned next;
+    // This node in the worker's NogoodTrie
+    std::uint32_t trie;
+  };
+
+  // Per locality
+  struct Stats {
+    std::atomic<std::uint64_t> runs {0};
+    std::atomic<std::uint64_t> nodes {0};
+    std::atomic<std::uint64_t> nogoodsLearned {0};
+    std::atomic<std::uint64_t> nogoodsReceived {0};
+    std::atomic<std::uint64_t> skipped {0};
+  };
+
+  static Stats & stats() {
+    static Stats s;
+    return s;
+  }
+
+  static void printSkeletonDetails(const API::Params<Bound> & params) {
+    hpx::cout << "Skeleton Type: Restarts\n";
+    hpx::cout << "Decision: " << std::boolalpha << isDecision << "\n";
+    hpx::cout << "DepthLimited: " << std::boolalpha << isDepthLimited << "\n";
+    hpx::cout << "Restart Backtracks: " << params.restartBacktracks << "\n";
+    hpx::cout << hpx::flush;
+  }
+
+  // The Luby sequence 1, 1, 2, 1, 1, 2, 4, 1, 1, 2, ... from i = 1
+  static std::uint64_t luby(std::uint64_t i) {
+    for (;;) {
+      unsigned k = 1;
+      while ((std::uint64_t(1) << k) - 1 < i) {
+        ++k;
+      }
+      if ((std::uint64_t(1) << k) - 1 == i) {
+        return std::uint64_t(1) << (k - 1);
+      }
+      i -= (std::uint64_t(1) << (k - 1)) - 1;
+    }
+  }
+
+  // Do a node's children get searched? Depths as in DepthBounded, the root is at 0.
+  static bool expands(const API::Params<Bound> & params, const unsigned depth) {
+    return !isDepthLimited || depth + 1 < params.maxDepth;
+  }
+
+  // Make frames[depth] (whose node is already set) ready to visit its children
+  static void enterNode(std::vector<Frame> & frames, const unsigned depth, const Space & space,
+                        std::mt19937 & rng) {
+    auto & f = frames[depth];
+    Generator gen(space, f.node);
+    f.order.resize(gen.numChildren);
+    std::iota(f.order.begin(), f.order.end(), 0u);
+    std::shuffle(f.order.begin(), f.order.end(), rng);
+    f.next = 0;
+  }
+
+  // The nogoods of an interrupted run: on every level of the branch, the children searched to the
+  // end. trie already knows the ones skipped because of it, they aren't repeated.
+  static std::vector<util::NogoodPath> refuted(const std::vector<Frame> & frames, const unsigned depth,
+                                               const util::NogoodTrie & trie) {
+    std::vector<util::NogoodPath> res;
+    util::NogoodPath prefix;
+    for (unsigned l = 0; l <= depth; ++l) {
+      if (l > 0) {
+        prefix.push_back(frames[l].index);
+      }
+      const auto & f = frames[l];
+      // Below the top of the branch the last child started is still being searched
+      auto done = l < depth ? f.next - 1 : f.next;
+      for (unsigned j = 0; j < done; ++j) {
+        if (trie.isNogood(trie.child(f.trie, f.order[j]))) {
+          continue;
+        }
+        res.push_back(prefix);
+        res.back().push_back(f.order[j]);
+      }
+    }
+    return res;
+  }
+
+  static RunResult run(const Space & space, const Node & root, const API::Params<Bound> & params,
+                       const std::uint64_t backtrackLimit, util::NogoodTrie & trie,
+                       std::vector<Frame> & frames, std::mt19937 & rng,
+                       std::vector<util::NogoodPath> & learned) {
+    auto reg = Registry<Space, Node, Bound, Enum>::gReg;
+    Enum acc;
+
+    if (frames.empty()) {
+      frames.emplace_back();
+    }
+    frames[0].node = root;
+    frames[0].index = 0;
+    frames[0].trie = trie.root();
+    if (!expands(params, 0)) {
+      return RunResult::Exhausted;
+    }
+    enterNode(frames, 0, space, rng);
+
+    std::uint64_t backtracks = 0;
+    std::uint64_t nodes = 0;
+    int depth = 0;
+    auto result = RunResult::Exhausted;
+    while (depth >= 0) {
+      if (reg->shouldStop()) {
+        result = RunResult::Stopped;
+        break;
+      }
+
+      auto & f = frames[depth];
+      if (f.next == f.order.size()) {
+        --depth;
+        if (++backtracks >= backtrackLimit && depth >= 0) {
+          learned = refuted(frames, depth, trie);
+          result = RunResult::Restart;
+          break;
+        }
+        continue;
+      }
+
+      auto i = f.order[f.next++];
+      auto t = trie.child(f.trie, i);
+      if (trie.isNogood(t)) {
+        ++stats().skipped;
+        continue;
+      }
+
+      // frames[depth] must not move while the generator refers to its node
+      if (frames.size() <= static_cast<unsigned>(depth) + 1) {
+        frames.emplace_back();
+      }
+      auto & parent = frames[depth];
+      auto & child = frames[depth + 1];
+      {
+        Generator gen(space, parent.node);
+        skipChildren(gen, i);
+        nextChildInto(gen, child.node);
+      }
+      ++nodes;
+
+      // Level pruning relies on the generator's order, which runs don't follow, so a Break only
+      // prunes the child
+      // Finding a solution stops every locality
+      auto pn = PN::processNode(params, space, child.node, depth + 1, acc);
+      if (pn == ProcessNodeRet::Exit) {
+        result = RunResult::Stopped;
+        break;
+      }
+      if (pn != ProcessNodeRet::Continue || !expands(params, depth + 1)) {
+        continue;
+      }
+
+      child.index = i;
+      child.trie = t;
+      ++depth;
+      enterNode(frames, depth, space, rng);
+    }
+
+    stats().nodes += nodes;
+    return result;
+  }
+
+  static void worker(const unsigned seed) {
+    auto reg = Registry<Space, Node, Bound, Enum>::gReg;
+    const auto & space = reg->localSpace();
+    const auto & params = reg->params;
+    auto here = hpx::find_here();
+    auto others = util::findOtherLocalities();
+
+    std::mt19937 rng(seed);
+    util::NogoodTrie trie;
+    std::size_t cursor = 0;
+    std::vector<Frame> frames;
+
+    for (std::uint64_t n = 1; ; ++n) {
+      cursor = reg->nogoods.readInto(cursor, trie);
+      ++stats().runs;
+
+      std::vector<util::NogoodPath> learned;
+      auto limit = static_cast<std::uint64_t>(std::max(1u, params.restartBacktracks)) * luby(n);
+      auto r = run(space, reg->root, params, limit, trie, frames, rng, learned);
+
+      if (r == RunResult::Exhausted) {
+        // Every subtree this run skipped was refuted before, so there is no solution
+        hpx::wait_all(hpx::lcos::broadcast<SetStopFlagAct<Space, Node, Bound, Enum> >(
+            hpx::find_all_localities()));
+        return;
+      }
+      if (r != RunResult::Restart) {
+        return;
+      }
+
+      if (!learned.empty()) {
+        stats().nogoodsLearned += learned.size();
+        reg->nogoods.add(learned);
+        for (const auto & l : others) {
+          hpx::apply<Restarts_::AddNogoodsAct<Generator, Args...> >(l, reg->searchId, learned);
+        }
+      }
+    }
+  }
+
+  // Run this locality's workers until the search stops
+  static void runWorkers() {
+    auto & s = stats();
+    s.runs = 0;
+    s.nodes = 0;
+    s.nogoodsLearned = 0;
+    s.nogoodsReceived = 0;
+    s.skipped = 0;
+
+    std::random_device rd;
+    std::vector<hpx::future<void> > workers;
+    for (unsigned i = 0; i < Workstealing::Scheduler::localWorkers(); ++i) {
+      auto exe = Workstealing::Scheduler::workerExecutor(i, hpx::threads::thread_priority_normal);
+      workers.push_back(hpx::async(exe, &worker, rd()));
+    }
+    hpx::wait_all(workers);
+  }
+
+  // Nogoods learned on another locality. Late messages from an earlier search are dropped.
+  static void addNogoods(const std::uint64_t searchId, const std::vector<util::NogoodPath> & ps) {
+    auto reg = Registry<Space, Node, Bound, Enum>::gReg;
+    if (searchId != reg->searchId) {
+      return;
+    }
+    stats().nogoodsReceived += ps.size();
+    reg->nogoods.add(ps);
+  }
+
+  static void printReport() {
+    auto & s = stats();
+    hpx::cout
+        << (boost::format("%1% Restarts: %2% runs, %3% nodes, %4% nogoods learned, %5% received, %6% subtrees skipped")
+            % static_cast<std::int64_t>(hpx::get_locality_id())
+            % s.runs.load()
+            % s.nodes.load()
+            % s.nogoodsLearned.load()
+            % s.nogoodsReceived.load()
+            % s.skipped.load())
+        << hpx::endl;
+  }
+
+  static auto search (const Space & space,
+                      const Node & root,
+                      const API::Params<Bound> params = API::Params<Bound>()) {
+    API::rejectCheckpoints(params, "Restarts");
+
+    SearchContext ctx;
+
+    if constexpr(verbose) {
+      printSkeletonDetails(params);
+    }
+
+    if (root.getObj() == params.expectedObjective) {
+      return root;
+    }
+
+    initRegistries<Space, Node, Bound, Enum>(space, root, params);
+
+    PN::initSearch(params);
+
+    auto inc = hpx::new_<Incumbent>(hpx::find_here()).get();
+    hpx::wait_all(hpx::lcos::broadcast<UpdateGlobalIncumbentAct<Space, Node, Bound, Enum> >(
+        hpx::find_all_localities(), inc));
+    PN::initIncumbent(root, params);
+
+    hpx::wait_all(hpx::lcos::broadcast<Restarts_::RunWorkersAct<Generator, Args...> >(
+        hpx::find_all_localities()));
+
+    if constexpr(verbose > 1) {
+      util::printOnEachLocality<Restarts_::PrintReportAct<Generator, Args...> >();
+    }
+
+    PN::printReports();
+
+    return getFinalIncumbent<Space, Node, Bound, Enum, Objcmp, Verbose>();
+  }
+};
+
+namespace Restarts_ {
+template <typename Generator, typename ...Args>
+struct RunWorkersAct : hpx::actions::make_action<
+  decltype(&Restarts<Generator, Args...>::runWorkers),
+  &Restarts<Generator, Args...>::runWorkers,
+  RunWorkersAct<Generator, Args...>>::type {};
+
+template <typename Generator, typename ...Args>
+struct AddNogoodsAct : hpx::actions::make_action<
+  decltype(&Restarts<Generator, Args...>::addNogoods),
+  &Restarts<Generator, Args...>::addNogoods,
+  AddNogoodsAct<Generator, Args...>>::type {};
+
+template <typename Generator, typename ...Args>
+struct PrintReportAct : hpx::actions::make_action<
+  decltype(&Restarts<Generator, Args...>::printReport),
+  &Restarts<Generator, Args...>::printReport,
+  PrintReportAct<Generator, Args...>>::type {};
+}
+
+}}
+
+#endif
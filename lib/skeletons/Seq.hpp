@@ -10,7 +10,11 @@
 #include "API.hpp"
 #include "util/NodeGenerator.hpp"
 #include "util/Enumerator.hpp"
+#include "util/MemoTable.hpp"
 #include "util/func.hpp"
+#include "util/Log.hpp"
+
+#include "DepthFirst.hpp"
 
 namespace YewPar { namespace Skeletons {
 
@@ -19,6 +23,9 @@ struct Seq {
   typedef typename Generator::Nodetype Node;
   typedef typename Generator::Spacetype Space;
 
+  static_assert(isNodeGenerator<Generator>::value,
+                "Generator needs Nodetype, Spacetype, numChildren, next() and a (Space, Node) constructor");
+
   typedef typename API::skeleton_signature::bind<Args...>::type args;
 
   static constexpr bool isEnumeration = parameter::value_type<args, API::tag::Enumeration_, std::integral_constant<bool, false> >::type::value;
@@ -26,11 +33,14 @@ struct Seq {
   static constexpr bool isDecision = parameter::value_type<args, API::tag::Decision_, std::integral_constant<bool, false> >::type::value;
   static constexpr bool isDepthBounded = parameter::value_type<args, API::tag::DepthLimited_, std::integral_constant<bool, false> >::type::value;
   static constexpr bool pruneLevel = parameter::value_type<args, API::tag::PruneLevel_, std::integral_constant<bool, false> >::type::value;
+  static constexpr unsigned maxStackDepth = parameter::value_type<args, API::tag::MaxStackDepth, std::integral_constant<unsigned, 5000> >::type::value;
   static constexpr unsigned verbose = parameter::value_type<args, API::tag::Verbose_, std::integral_constant<unsigned, 0> >::type::value;
   typedef typename parameter::value_type<args, API::tag::BoundFunction, nullFn__>::type boundFn;
   typedef typename boundFn::return_type Bound;
   typedef typename parameter::value_type<args, API::tag::ObjectiveComparison, std::greater<Bound> >::type Objcmp;
   typedef typename parameter::value_type<args, API::tag::Enumerator, IdentityEnumerator<Node>>::type Enumerator;
+  typedef typename parameter::value_type<args, API::tag::Memoize, nullFn__>::type memoFn;
+  static constexpr bool memoize = !std::is_same<memoFn, nullFn__>::value;
 
   static void printSkeletonDetails() {
     hpx::cout << "Skeleton Type: Seq\n";
@@ -47,101 +57,145 @@ struct Seq {
     hpx::cout << hpx::flush;
   }
 
-  static bool expand(const Space & space,
-                     const Node & n,
-                     const API::Params<Bound> & params,
-                     std::pair<Node, Bound> & incumbent,
-                     const unsigned childDepth,
-                     Enumerator & acc) {
-    Generator newCands = Generator(space, n);
+  static ProcessNodeRet checkBound(const API::Params<Bound> & params,
+                                   const std::pair<Node, Bound> & incumbent,
+                                   const Bound & bnd) {
+    Objcmp cmp;
+    if constexpr(isDecision) {
+      if (!cmp(bnd, params.expectedObjective) && bnd != params.expectedObjective) {
+        return pruneLevel ? ProcessNodeRet::Break : ProcessNodeRet::Prune;
+      }
+    // B&B Case
+    } else {
+      auto best = std::get<1>(incumbent);
+      if (!cmp(bnd,best)) {
+        return pruneLevel ? ProcessNodeRet::Break : ProcessNodeRet::Prune;
+      }
+    }
+    return ProcessNodeRet::Continue;
+  }
 
-    if constexpr(isEnumeration) {
-        acc.accumulate(n);
+  // Before the ith child of gen (at childDepth) is built: accumulate leaf levels in bulk and prune
+  // on batched bounds, as ProcessNode::preProcessChild
+  static ProcessNodeRet preProcessChild(const API::Params<Bound> & params,
+                                        const std::pair<Node, Bound> & incumbent,
+                                        Generator & gen,
+                                        const unsigned i,
+                                        const unsigned childDepth,
+                                        Enumerator & acc) {
+    if constexpr(isEnumeration && hasAccumulateChildren<Enumerator, Generator>::value) {
+      if (i == 0 && ((isDepthBounded && childDepth == params.maxDepth) || childrenAreLeaves(gen))) {
+        accumulateChildrenOf(acc, gen, childDepth - 1);
+        return ProcessNodeRet::Break;
+      }
     }
 
-    if constexpr(isDepthBounded) {
-        if (childDepth == params.maxDepth) {
-          return false;
-        }
+    if constexpr(!std::is_same<boundFn, nullFn__>::value && detail::hasChildBounds<Generator>::value) {
+      auto pb = checkBound(params, incumbent, gen.childBounds()[i]);
+      if (pb == ProcessNodeRet::Prune) {
+        skipChildren(gen, 1);
       }
+      return pb;
+    }
+    return ProcessNodeRet::Continue;
+  }
 
-    for (auto i = 0; i < newCands.numChildren; ++i) {
-      auto c = newCands.next();
-
-      if constexpr(isDecision) {
-        if (c.getObj() == params.expectedObjective) {
-          std::get<0>(incumbent) = c;
-          if constexpr(verbose > 1) {
-            hpx::cout <<
-              (boost::format("Found solution on: %1%\n")
-              % static_cast<std::int64_t>(hpx::get_locality_id()))
-                      << hpx::flush;
-          }
-          return true;
+  // Process a child (at depth, the root being at 0): check for a decision solution, prune on the
+  // bound and update the incumbent
+  static ProcessNodeRet processNode(const Space & space,
+                                    const Node & c,
+                                    const unsigned depth,
+                                    const API::Params<Bound> & params,
+                                    std::pair<Node, Bound> & incumbent,
+                                    Enumerator & acc) {
+    if constexpr(isDecision) {
+      if (c.getObj() == params.expectedObjective) {
+        std::get<0>(incumbent) = c;
+        if constexpr(verbose > 1) {
+          util::Log::write((boost::format("Found solution on: %1%\n")
+                            % static_cast<std::int64_t>(hpx::get_locality_id())).str());
         }
+        return ProcessNodeRet::Exit;
       }
+    }
 
-      // Do we support bounding?
-      if constexpr(!std::is_same<boundFn, nullFn__>::value) {
-          Objcmp cmp;
-          auto bnd  = boundFn::invoke(space, c);
-          if constexpr(isDecision) {
-            if (!cmp(bnd, params.expectedObjective) && bnd != params.expectedObjective) {
-              if constexpr(pruneLevel) {
-                break;
-              } else {
-                continue;
-              }
-            }
-          // B&B Case
-          } else {
-            auto best = std::get<1>(incumbent);
-            if (!cmp(bnd,best)) {
-              if constexpr(pruneLevel) {
-                  break;
-                } else {
-                continue;
-              }
-            }
-        }
+    // Do we support bounding? (Already checked with batched bounds)
+    if constexpr(!std::is_same<boundFn, nullFn__>::value && !detail::hasChildBounds<Generator>::value) {
+      auto pb = checkBound(params, incumbent, boundFn::invoke(space, c));
+      if (pb != ProcessNodeRet::Continue) {
+        return pb;
       }
+    }
 
-      if constexpr(isBnB) {
-        Objcmp cmp;
-        if (cmp(c.getObj(), std::get<1>(incumbent))) {
-          std::get<0>(incumbent) = c;
-          std::get<1>(incumbent) = c.getObj();
-          if constexpr(verbose >= 1) {
-            hpx::cout << (boost::format("New Incumbent: %1%\n") % c.getObj()) << hpx::flush;
-          }
-        }
+    if constexpr(memoize) {
+      auto k = memoFn::invoke(space, c);
+      if (util::MemoTable::seen(k.key, k.cost)) {
+        return ProcessNodeRet::Prune;
       }
+    }
 
-      auto found = expand(space, c, params, incumbent, childDepth + 1, acc);
-      if constexpr(isDecision) {
-        // Propagate early exit
-        if (found) {
-          return true;
+    if constexpr(isBnB) {
+      Objcmp cmp;
+      if (cmp(c.getObj(), std::get<1>(incumbent))) {
+        std::get<0>(incumbent) = c;
+        std::get<1>(incumbent) = c.getObj();
+        if constexpr(verbose >= 1) {
+          util::Log::write((boost::format("New Incumbent: %1%\n") % c.getObj()).str());
         }
       }
     }
-    return false;
+
+    if constexpr(isEnumeration) {
+      accumulateNode(acc, c, depth);
+    }
+
+    return ProcessNodeRet::Continue;
+  }
+
+  // Returns true if a decision search found its solution
+  static bool expand(const Space & space,
+                     const Node & n,
+                     const API::Params<Bound> & params,
+                     std::pair<Node, Bound> & incumbent,
+                     const unsigned childDepth,
+                     Enumerator & acc) {
+    auto res = expandDepthFirst<Generator, maxStackDepth, isDepthBounded>(
+        space, n, childDepth, params.maxDepth,
+        [&](const Node & c, unsigned depth) { return processNode(space, c, depth - 1, params, incumbent, acc); },
+        [&](Generator & gen, unsigned i, unsigned depth) {
+          return preProcessChild(params, incumbent, gen, i, depth, acc);
+        });
+    return res == ProcessNodeRet::Exit;
   }
 
   static auto search (const Space & space,
                       const Node & root,
                       const API::Params<Bound> params = API::Params<Bound>()) {
     static_assert(isEnumeration || isBnB || isDecision, "Please provide a supported search type: Enumeration, BnB, Decision");
+    static_assert(!(memoize && isEnumeration), "Memoize only supports Optimisation and Decision searches");
+
+    API::rejectCheckpoints(params, "Seq");
 
     if constexpr (verbose) {
       printSkeletonDetails();
     }
 
+    if constexpr(memoize) {
+      util::MemoTable::reset(params.memoTableSize);
+    }
+
     Enumerator acc;
 
     std::pair<Node, Bound> incumbent = std::make_pair(root, params.initialBound);
+    if constexpr(isEnumeration) {
+      accumulateNode(acc, root, 0);
+    }
     expand(space, root, params, incumbent, 1, acc);
 
+    if constexpr(memoize && verbose > 1) {
+      util::MemoTable::printReport();
+    }
+
     if constexpr(isBnB || isDecision) {
       return std::get<0>(incumbent);
     } else if constexpr(isEnumeration) {
@@ -2,12 +2,18 @@
 #define SKELETONS_STACKSTEAL_HPP
 
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <vector>
 #include <cstdint>
+#include <chrono>
 
 #include "API.hpp"
 
 #include <hpx/lcos/broadcast.hpp>
+#include <hpx/lcos/local/spinlock.hpp>
 #include <hpx/include/iostreams.hpp>
 
 #include <boost/format.hpp>
@@ -16,14 +22,19 @@
 #include "util/Registry.hpp"
 #include "util/Incumbent.hpp"
 #include "util/func.hpp"
+#include "util/PathSteal.hpp"
 #include "util/util.hpp"
+#include "util/TreeEstimator.hpp"
+#include "util/CompletionAggregator.hpp"
 
 #include "Common.hpp"
 
+#include "workstealing/OpenLevels.hpp"
 #include "workstealing/Scheduler.hpp"
 #include "workstealing/policies/SearchManager.hpp"
-
-#include "skeletons/Seq.hpp"
+#include "workstealing/Termination.hpp"
+#include "workstealing/WorkerStates.hpp"
+#include "workstealing/StealStats.hpp"
 
 namespace YewPar { namespace Skeletons {
 
@@ -32,6 +43,9 @@ struct StackStealing {
   typedef typename Generator::Nodetype Node;
   typedef typename Generator::Spacetype Space;
 
+  static_assert(isNodeGenerator<Generator>::value,
+                "Generator needs Nodetype, Spacetype, numChildren, next() and a (Space, Node) constructor");
+
   typedef typename API::skeleton_signature::bind<Args...>::type args;
 
   static constexpr bool isEnumeration = parameter::value_type<args, API::tag::Enumeration_, std::integral_constant<bool, false> >::type::value;
@@ -39,6 +53,9 @@ struct StackStealing {
   static constexpr bool isDecision = parameter::value_type<args, API::tag::Decision_, std::integral_constant<bool, false> >::type::value;
   static constexpr bool isDepthBounded = parameter::value_type<args, API::tag::DepthLimited_, std::integral_constant<bool, false> >::type::value;
   static constexpr bool pruneLevel = parameter::value_type<args, API::tag::PruneLevel_, std::integral_constant<bool, false> >::type::value;
+  static constexpr bool lazyIncumbent = parameter::value_type<args, API::tag::LazyIncumbent_, std::integral_constant<bool, false> >::type::value;
+  static constexpr bool countTermination = parameter::value_type<args, API::tag::CountTermination_, std::integral_constant<bool, false> >::type::value;
+  static constexpr bool isHybrid = parameter::value_type<args, API::tag::HybridSpawns_, std::integral_constant<bool, false> >::type::value;
   static constexpr unsigned maxStackDepth = parameter::value_type<args, API::tag::MaxStackDepth, std::integral_constant<unsigned, 5000> >::type::value;
 
   typedef typename parameter::value_type<args, API::tag::Verbose_, std::integral_constant<unsigned, 0> >::type Verbose;
@@ -49,8 +66,15 @@ struct StackStealing {
   typedef typename parameter::value_type<args, API::tag::ObjectiveComparison, std::greater<Bound> >::type Objcmp;
   typedef typename parameter::value_type<args, API::tag::Enumerator, IdentityEnumerator<Node>>::type Enum;
 
+  typedef ProcessNode<Space, Node, Args...> PN;
+
   static void printSkeletonDetails(const API::Params<Bound> & params) {
-    hpx::cout << "Skeleton Type: StackStealing\n";
+    if constexpr(isHybrid) {
+      hpx::cout << "Skeleton Type: Hybrid\n";
+      hpx::cout << "d_cutoff: " << params.spawnDepth << "\n";
+    } else {
+      hpx::cout << "Skeleton Type: StackStealing\n";
+    }
     hpx::cout << "Enumeration : " << std::boolalpha << isEnumeration << "\n";
     hpx::cout << "Optimisation: " << std::boolalpha << isOptimisation << "\n";
     hpx::cout << "Decision: " << std::boolalpha << isDecision << "\n";
@@ -62,73 +86,429 @@ struct StackStealing {
     } else {
       hpx::cout << "Using Bounding: false\n";
     }
+    hpx::cout << "CountTermination: " << std::boolalpha << countTermination << "\n";
     hpx::cout << "Chunking Enabled: " << std::boolalpha << params.stealAll << "\n";
+    hpx::cout << "Adaptive Chunking: " << std::boolalpha << params.stealAdaptive << "\n";
+    hpx::cout << "Max Distributed Steals: " << params.maxDistributedSteals << "\n";
+    hpx::cout << "Steal Prefetch Threshold: " << params.stealPrefetchThreshold << "\n";
+    hpx::cout << "Path Steals: " << std::boolalpha << params.pathSteals << "\n";
+    hpx::cout << "Claim Steals: " << std::boolalpha << params.claimSteals << "\n";
     hpx::cout << hpx::flush;
   }
 
-  static void subTreeTask(const Node initNode,
+  static void subTreeTask(const TaskNode<Node> initTask,
                           const unsigned depth,
                           const hpx::naming::id_type donePromise) {
     auto reg = Registry<Space, Node, Bound, Enum>::gReg;
+    const auto & space = reg->localSpace();
+
+    util::TaskTrace::ScopedTask trace(depth, depth == 1 ? util::TaskTrace::Origin::Root
+                                      : util::TaskTrace::originOf(!spawnedByParent(depth, reg->params), donePromise));
+
+    const auto initNode = initTask.hasNode ? initTask.node
+                                           : recomputeNode<Generator>(space, reg->root, initTask.path);
+
+    auto taskPromise = donePromise;
+    if constexpr(SiblingDeltas<Generator>::enabled) {
+      if (!initTask.siblings.empty()) {
+        taskPromise = unbundleSiblings(initNode, initTask.siblings, depth, donePromise);
+      }
+    }
+
+    if constexpr(isHybrid) {
+      if (depth <= reg->params.spawnDepth) {
+        expandWithSpawns(initNode, initTask.path, depth, taskPromise);
+        return;
+      }
+    }
+
     Enum acc;
 
     // Setup the stack with root node
-    StackElem<Generator> rootElem(reg->space, initNode);
+    StackElem<Generator> rootElem(space, initNode);
 
     GeneratorStack<Generator> generatorStack(maxStackDepth, rootElem);
 
     if constexpr(isEnumeration) {
-        acc.accumulate(initNode);
+      if (!spawnedByParent(depth, reg->params)) {
+        accumulateNode(acc, initNode, depth - 1);
+      }
     }
 
     // Register with the Policy to allow stealing from this stack
+    auto claims = makeClaimState(reg->params);
     std::shared_ptr<SharedState> stealReq;
     unsigned threadId;
-    std::tie(stealReq, threadId) = std::static_pointer_cast<Policy>(Workstealing::Scheduler::local_policy)->registerThread();
+    std::tie(stealReq, threadId) = std::static_pointer_cast<Policy>(Workstealing::Scheduler::local_policy)->registerThread(
+        claimFn(claims, space, depth));
+
+    runTaskFromStack(depth, space, generatorStack, stealReq, claims, acc, taskPromise, threadId, initTask.path);
+  }
+
+  // Queue the delta encoded siblings of a stolen node as tasks of their own. Returns the promise
+  // the node's own task should set, donePromise is set once it and all the siblings are done.
+  static hpx::naming::id_type unbundleSiblings(const Node & base,
+                                               const std::vector<std::vector<char> > & siblings,
+                                               const unsigned depth,
+                                               const hpx::naming::id_type donePromise) {
+    auto policy = std::static_pointer_cast<Policy>(Workstealing::Scheduler::local_policy);
+
+    std::vector<hpx::promise<void> > promises;
+    std::vector<hpx::future<void> > futures;
+    for (const auto & s : siblings) {
+      policy->addwork(TaskNode<Node>(SiblingDeltas<Generator>::decode(base, s)), depth, trackTask(promises, futures));
+    }
 
-    runTaskFromStack(depth, reg->space, generatorStack, stealReq, acc, donePromise, threadId);
+    if constexpr(countTermination) {
+      return donePromise;
+    } else {
+      auto own = trackTask(promises, futures);
+      hpx::apply(hpx::util::bind([=](std::vector<hpx::future<void> > & futs) {
+            hpx::wait_all(futs);
+            util::CompletionAggregator::complete(donePromise);
+          }, std::move(futures)));
+      return own;
+    }
   }
 
   using SubTreeTask = func<
     decltype(&StackStealing<Generator, Args...>::subTreeTask),
     &StackStealing<Generator, Args...>::subTreeTask>;
 
-  using Policy      = Workstealing::Policies::SearchManager::SearchManagerComp<Node, SubTreeTask, Args...>;
+  using Policy      = Workstealing::Policies::SearchManager::SearchManagerComp<TaskNode<Node>, SubTreeTask, Args...>;
   using Response    = typename Policy::Response_t;
   using SharedState = typename Policy::SharedState_t;
 
+  // Claim steals (Params::claimSteals): the stack's published levels, and the tasks thieves claimed
+  // from them, which the searching thread waits for along with its own
+  struct ClaimState {
+    workstealing::OpenLevels<Node> levels;
+    hpx::lcos::local::spinlock mtx;
+    std::vector<hpx::promise<void> > promises;
+    std::vector<hpx::future<void> > futures;
+  };
+
+  // Path steals need the path to the stolen node, which only the searching thread knows, so they
+  // keep to the usual steals
+  static std::shared_ptr<ClaimState> makeClaimState(const API::Params<Bound> & params) {
+    if (!params.claimSteals || params.pathSteals) {
+      return nullptr;
+    }
+    return std::make_shared<ClaimState>();
+  }
+
+  static typename Policy::Claim_t claimFn(const std::shared_ptr<ClaimState> & claims,
+                                          const Space & space,
+                                          const int startingDepth) {
+    if (!claims) {
+      return nullptr;
+    }
+    return [claims, &space, startingDepth](TaskNode<Node> & task, int & depth, hpx::naming::id_type & prom) {
+      return claimFromStack(*claims, space, startingDepth, task, depth, prom);
+    };
+  }
+
+  // Run by the thief (or the search manager answering a remote steal): claim the next child of the
+  // shallowest open level and build it from a copy of its parent. Costs the thief a generator
+  // construction but never waits for the searching thread.
+  static bool claimFromStack(ClaimState & claims,
+                             const Space & space,
+                             const int startingDepth,
+                             TaskNode<Node> & task,
+                             int & depth,
+                             hpx::naming::id_type & prom) {
+    std::size_t level;
+    std::uint32_t idx;
+    Node parent;
+    if (!claims.levels.steal(level, idx, parent)) {
+      return false;
+    }
+
+    Generator gen(space, parent);
+    task = TaskNode<Node>(nthChild(gen, idx));
+    depth = startingDepth + level + 1;
+
+    std::lock_guard<hpx::lcos::local::spinlock> l(claims.mtx);
+    prom = trackTask(claims.promises, claims.futures);
+    return true;
+  }
+
+  // Publish level i of the stack, from its seen'th child, for claim steals. Levels whose children
+  // preProcessChild would accumulate in bulk stay private.
+  static void openLevel(ClaimState * claims,
+                        GeneratorStack<Generator> & generatorStack,
+                        const int i,
+                        const int childDepth,
+                        const API::Params<Bound> & params) {
+    if (!claims || !workstealing::OpenLevels<Node>::publishes(i)) {
+      return;
+    }
+    auto & elem = generatorStack[i];
+    bool isPrivate = false;
+    if constexpr(PN::template bulkLeaves<Generator>) {
+      isPrivate = (isDepthBounded && childDepth == params.maxDepth) || childrenAreLeaves(elem.gen);
+    }
+    claims->levels.open(i, &elem.node, elem.seen, elem.gen.numChildren, isPrivate);
+  }
+
+  // Whether level i has a child left for us, moving its generator to it. With claim steals we
+  // claim the child first, thieves may have taken some of the ones before it.
+  static bool nextChildAt(GeneratorStack<Generator> & generatorStack, const int i, ClaimState * claims) {
+    auto & elem = generatorStack[i];
+    if (!claims || !workstealing::OpenLevels<Node>::publishes(i)) {
+      return elem.seen < elem.gen.numChildren;
+    }
+    auto idx = claims->levels.claim(i);
+    if (idx < 0) {
+      return false;
+    }
+    skipChildren(elem.gen, idx - elem.seen);
+    elem.seen = idx;
+    return true;
+  }
+
+  // The rest of level i was pruned
+  static void closeLevel(ClaimState * claims, const int i) {
+    if (claims && workstealing::OpenLevels<Node>::publishes(i)) {
+      claims->levels.close(i);
+    }
+  }
+
+  // Hybrid: tasks for nodes at depth 2..spawnDepth+1 were spawned by expandWithSpawns, which has
+  // already processed (counted/bounded) them. Everything else (the root and stolen nodes, which
+  // always come from a stack below spawnDepth + 1) hasn't been.
+  static bool spawnedByParent(const unsigned depth, const API::Params<Bound> & params) {
+    return isHybrid && depth > 1 && depth <= params.spawnDepth + 1;
+  }
+
+  // Hybrid: expand a node above the cutoff, spawning a task for each surviving child into the
+  // search manager's buffers, as DepthBounded would
+  static void expandWithSpawns(const Node & n,
+                               const std::vector<std::uint32_t> & path,
+                               const unsigned depth,
+                               const hpx::naming::id_type donePromise) {
+    auto reg = Registry<Space, Node, Bound, Enum>::gReg;
+    const auto & space = reg->localSpace();
+    Enum acc;
+    std::vector<hpx::promise<void> > promises;
+    std::vector<hpx::future<void> > futures;
+
+    if constexpr(isEnumeration) {
+      if (!spawnedByParent(depth, reg->params)) {
+        accumulateNode(acc, n, depth - 1);
+      }
+    }
+
+    bool stopped = false;
+    if constexpr(isDecision) {
+      stopped = reg->shouldStop();
+    }
+
+    if (!stopped) {
+      auto policy = std::static_pointer_cast<Policy>(Workstealing::Scheduler::local_policy);
+      Generator newCands = Generator(space, n);
+      for (auto i = 0; i < newCands.numChildren; ++i) {
+        auto pb = PN::preProcessChild(reg->params, newCands, i, depth + 1, acc);
+        if (pb == ProcessNodeRet::Prune) { continue; }
+        else if (pb == ProcessNodeRet::Break) { break; }
+
+        auto c = newCands.next();
+
+        auto pn = PN::processNode(reg->params, space, c, depth, acc, PN::template batchedBounds<Generator>);
+        if (pn == ProcessNodeRet::Exit) { break; }
+        else if (pn == ProcessNodeRet::Prune) { continue; }
+        else if (pn == ProcessNodeRet::Break) { break; }
+
+        // Nodes at maxDepth are counted but never expanded
+        if constexpr(isDepthBounded) {
+          if (depth + 1 >= reg->params.maxDepth) {
+            continue;
+          }
+        }
+
+        if (reg->params.pathSteals) {
+          auto childPath = path;
+          childPath.push_back(i);
+          policy->addwork(TaskNode<Node>(c, std::move(childPath)), depth + 1, trackTask(promises, futures));
+        } else {
+          policy->addwork(c, depth + 1, trackTask(promises, futures));
+        }
+      }
+    }
+
+    if constexpr(isEnumeration) {
+      reg->updateEnumerator(acc);
+    }
+
+    if constexpr(countTermination) {
+      Workstealing::Termination::taskCompleted();
+      return;
+    }
+
+    hpx::apply(hpx::util::bind([=](std::vector<hpx::future<void> > & futs) {
+          hpx::wait_all(futs);
+          util::CompletionAggregator::complete(donePromise);
+        }, std::move(futures)));
+  }
+
   // Find the (approx) required depth<Generator> to create "totalThreads" tasks
+  // Shallowest depth estimated to hold a node for every thread. The initial distribution copes
+  // with the estimate being off, it just hands out fewer tasks.
   static unsigned getRequiredSpawnDepth(const Space & space,
                                         const Node & root,
                                         const YewPar::Skeletons::API::Params<Bound> params,
                                         const unsigned totalThreads) {
+    auto probeDepth = isDepthBounded ? params.maxDepth : maxStackDepth;
+    auto est = util::estimateTree<Generator>(space, root, params.estimatorProbes, probeDepth);
+    return std::max(1u, est.depthWith(totalThreads));
+  }
+
+  // Account for a new task handed out (by a steal or the initial distribution). Returns the id of
+  // the promise the task sets when done, or invalid_id when counting for termination detection.
+  static hpx::naming::id_type trackTask(std::vector<hpx::promise<void> > & promises,
+                                        std::vector<hpx::future<void> > & futures) {
+    if constexpr(countTermination) {
+      Workstealing::Termination::taskSpawned();
+      return hpx::invalid_id;
+    } else {
+      promises.emplace_back();
+      auto & prom = promises.back();
+      futures.push_back(prom.get_future());
+      return prom.get_id();
+    }
+  }
+
+  // Hand the next unexplored node at stack level i to a thief. With path steals the path to it is
+  // the first basePathLen + i entries of the current path plus its index at level i. Only remote
+  // thieves get the path alone, local ones share the node's memory anyway.
+  static TaskNode<Node> stealFromLevel(GeneratorStack<Generator> & generatorStack,
+                                       const int i,
+                                       const std::vector<std::uint32_t> & path,
+                                       const std::size_t basePathLen,
+                                       const bool remoteThief) {
+    auto reg = Registry<Space, Node, Bound, Enum>::gReg;
+
+    const auto idx = generatorStack[i].seen;
+    generatorStack[i].seen++;
 
-    auto depthRequired = 1;
-    while (depthRequired <= params.maxDepth) {
-      auto localParams = params;
-      localParams.maxDepth = depthRequired;
-      std::uint64_t numNodes = YewPar::Skeletons::Seq<Generator,
-                                             YewPar::Skeletons::API::Enumeration,
-                                             YewPar::Skeletons::API::Enumerator<CountNodesEnumerator<Node>>,
-                                             YewPar::Skeletons::API::BoundFunction<boundFn>,
-                                             YewPar::Skeletons::API::ObjectiveComparison<Objcmp>,
-                                             YewPar::Skeletons::API::DepthLimited>
-                      ::search(space, root, localParams);
-      if (numNodes >= totalThreads) {
-        break;
+    TaskNode<Node> res(generatorStack[i].gen.next());
+    if (reg->params.pathSteals) {
+      res.path.assign(path.begin(), path.begin() + basePathLen + i);
+      res.path.push_back(idx);
+      if (remoteThief && RecomputeCost<Generator>::preferPath(res.node, res.path.size())) {
+        res.sendPathOnly();
+        Workstealing::Policies::SearchManagerPerf::perf_pathSteals++;
       }
-      ++depthRequired;
     }
-    return depthRequired;
+    return res;
+  }
+
+  // Steal n nodes from level i of the stack into res. A remote thief gets them as a single task
+  // (the first node with the others delta encoded against it) if the generator supports it. Path
+  // steals keep one task per node, they need every node's path and already send little.
+  static void stealChunk(GeneratorStack<Generator> & generatorStack,
+                         const int i,
+                         const std::uint64_t n,
+                         const int taskDepth,
+                         const std::vector<std::uint32_t> & path,
+                         const std::size_t basePathLen,
+                         const bool remoteThief,
+                         Response & res,
+                         std::vector<hpx::promise<void> > & promises,
+                         std::vector<hpx::future<void> > & futures) {
+    auto reg = Registry<Space, Node, Bound, Enum>::gReg;
+
+    if constexpr(SiblingDeltas<Generator>::enabled) {
+      if (remoteThief && n > 1 && !reg->params.pathSteals) {
+        TaskNode<Node> bundle(generatorStack[i].gen.next());
+        generatorStack[i].seen++;
+        for (std::uint64_t j = 1; j < n; ++j) {
+          auto sibling = generatorStack[i].gen.next();
+          generatorStack[i].seen++;
+          bundle.siblings.push_back(SiblingDeltas<Generator>::encode(bundle.node, sibling));
+        }
+        Workstealing::Policies::SearchManagerPerf::perf_deltaSteals += n - 1;
+        res.emplace_back(hpx::util::make_tuple(std::move(bundle), taskDepth, trackTask(promises, futures)));
+        return;
+      }
+    }
+
+    for (std::uint64_t j = 0; j < n; ++j) {
+      auto stolen = stealFromLevel(generatorStack, i, path, basePathLen, remoteThief);
+      res.emplace_back(hpx::util::make_tuple(std::move(stolen), taskDepth, trackTask(promises, futures)));
+    }
+  }
+
+  // (Re)build gen for n in place, timing it if requested to keep the path steal estimates up to date
+  static void makeGenerator(Generator & gen, const Space & space, const Node & n, const bool sample) {
+    if (!sample) {
+      resetGenerator(gen, space, n);
+      return;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    resetGenerator(gen, space, n);
+    RecomputeCost<Generator>::record(std::chrono::steady_clock::now() - t0);
+  }
+
+  // Most nodes a single adaptive steal hands to a thief on this/another locality
+  static constexpr unsigned maxLocalChunk = 4;
+  static constexpr unsigned maxDistributedChunk = 32;
+
+  // Build a steal response whose size depends on how far away the thief is and how much work we
+  // have left. Remote thieves get up to half of the remaining unexplored nodes (steals are
+  // expensive, so we want them rare), local thieves up to a quarter. Nodes are taken from the
+  // shallowest levels first, never more than half of a level (rounded up), so we keep some work
+  // at every level. During ramp-up the stack is shallow and steals get a single large node, near
+  // the end each steal takes several of the (small) remaining nodes.
+  static Response adaptiveStealResponse(const int startingDepth,
+                                        GeneratorStack<Generator> & generatorStack,
+                                        const int stackDepth,
+                                        const bool remoteThief,
+                                        const std::vector<std::uint32_t> & path,
+                                        const std::size_t basePathLen,
+                                        std::vector<hpx::promise<void> > & promises,
+                                        std::vector<hpx::future<void> > & futures) {
+    std::uint64_t remaining = 0;
+    for (auto i = 0; i < stackDepth; ++i) {
+      remaining += generatorStack[i].gen.numChildren - generatorStack[i].seen;
+    }
+
+    Response res;
+    if (remaining == 0) {
+      return res;
+    }
+
+    std::uint64_t want = remoteThief ? std::min<std::uint64_t>(maxDistributedChunk, remaining / 2)
+                                     : std::min<std::uint64_t>(maxLocalChunk, remaining / 4);
+    want = std::max<std::uint64_t>(want, 1);
+
+    std::uint64_t taken = 0;
+    for (auto i = 0; i < stackDepth && taken < want; ++i) {
+      auto left = generatorStack[i].gen.numChildren - generatorStack[i].seen;
+      auto take = std::min<std::uint64_t>((left + 1) / 2, want - taken);
+      if (take > 0) {
+        stealChunk(generatorStack, i, take, startingDepth + i + 1, path, basePathLen, remoteThief,
+                   res, promises, futures);
+        taken += take;
+      }
+    }
+
+    return res;
   }
 
   // TODO: We only need the depth for counting so need to constexpr more
+  //
+  // With path steals, path holds the path from the search root to the node at stackDepth (it is
+  // only maintained when Params::pathSteals is set). With claim steals (claims set) thieves take
+  // work from the published levels themselves and stealRequest is never raised.
   static void runWithStack(const int startingDepth,
                            const Space & space,
                            GeneratorStack<Generator> & generatorStack,
                            std::shared_ptr<SharedState> stealRequest,
+                           ClaimState * claims,
                            Enum & acc,
                            std::vector<hpx::future<void> > & futures,
+                           std::vector<std::uint32_t> & path,
                            int stackDepth = 0,
                            int depth = -1) {
     auto reg = Registry<Space, Node, Bound, Enum>::gReg;
@@ -139,10 +519,18 @@ struct StackStealing {
       depth = startingDepth;
     }
 
+    const auto pathSteals = reg->params.pathSteals;
+    const std::size_t basePathLen = pathSteals ? path.size() - stackDepth : 0;
+    unsigned generated = 0;
+
+    for (auto i = 0; i <= stackDepth; ++i) {
+      openLevel(claims, generatorStack, i, startingDepth + i + 1, reg->params);
+    }
+
     while (stackDepth >= 0) {
 
       if constexpr(isDecision) {
-        if (reg->stopSearch) {
+        if (reg->shouldStop()) {
           return;
         }
       }
@@ -151,37 +539,29 @@ struct StackStealing {
       if (std::get<0>(*stealRequest)) {
         // We steal from the highest possible generator with work
         bool responded = false;
-        for (auto i = 0; i < stackDepth; ++i) {
+        if (reg->params.stealAdaptive) {
+          auto res = adaptiveStealResponse(startingDepth, generatorStack, stackDepth,
+                                           std::get<2>(*stealRequest), path, basePathLen,
+                                           promises, futures);
+          std::get<1>(*stealRequest).set(res);
+          responded = true;
+        }
+        for (auto i = 0; i < stackDepth && !responded; ++i) {
           // Work left at this level:
           if (generatorStack[i].seen < generatorStack[i].gen.numChildren) {
             if (reg->params.stealAll) {
               Response res;
-              while (generatorStack[i].seen < generatorStack[i].gen.numChildren) {
-                generatorStack[i].seen++;
-
-                promises.emplace_back();
-                auto & prom = promises.back();
-
-                futures.push_back(prom.get_future());
-
-                const auto stolenSol = generatorStack[i].gen.next();
-                res.emplace_back(hpx::util::make_tuple(stolenSol, startingDepth + i + 1, prom.get_id()));
-              }
+              stealChunk(generatorStack, i, generatorStack[i].gen.numChildren - generatorStack[i].seen,
+                         startingDepth + i + 1, path, basePathLen, std::get<2>(*stealRequest),
+                         res, promises, futures);
 
               std::get<1>(*stealRequest).set(res);
               responded = true;
               break;
               // Steal the first task only
             } else {
-              generatorStack[i].seen++;
-
-              promises.emplace_back();
-              auto & prom = promises.back();
-
-              futures.push_back(prom.get_future());
-
-              const auto stolenSol = generatorStack[i].gen.next();
-              Response res {hpx::util::make_tuple(stolenSol, startingDepth + i + 1, prom.get_id())};
+              auto stolen = stealFromLevel(generatorStack, i, path, basePathLen, std::get<2>(*stealRequest));
+              Response res {hpx::util::make_tuple(std::move(stolen), startingDepth + i + 1, trackTask(promises, futures))};
               std::get<1>(*stealRequest).set(res);
 
               responded = true;
@@ -197,26 +577,40 @@ struct StackStealing {
       }
 
       // If there's still children at this stackDepth we move into them
-      if (generatorStack[stackDepth].seen < generatorStack[stackDepth].gen.numChildren) {
+      if (nextChildAt(generatorStack, stackDepth, claims)) {
+
+        auto pb = PN::preProcessChild(reg->params, generatorStack[stackDepth].gen, generatorStack[stackDepth].seen, depth + 1, acc);
+        if (pb == ProcessNodeRet::Prune) {
+          generatorStack[stackDepth].seen++;
+          continue;
+        } else if (pb == ProcessNodeRet::Break) {
+          closeLevel(claims, stackDepth);
+          stackDepth--;
+          depth--;
+          continue;
+        }
+
+        // A thief may still be copying the node we are about to overwrite
+        if (claims && workstealing::OpenLevels<Node>::publishes(stackDepth + 1)) {
+          claims->levels.waitForReaders(stackDepth + 1);
+        }
 
         // Get the next child at this stackDepth
-        generatorStack[stackDepth + 1].node = generatorStack[stackDepth].gen.next();
+        nextChildInto(generatorStack[stackDepth].gen, generatorStack[stackDepth + 1].node);
         auto & child = generatorStack[stackDepth + 1].node;
 
         generatorStack[stackDepth].seen++;
 
-        auto pn = ProcessNode<Space, Node, Args...>::processNode(reg->params, space, child, acc);
+        auto pn = PN::processNode(reg->params, space, child, depth, acc, PN::template batchedBounds<Generator>);
         if (pn == ProcessNodeRet::Exit) { return; }
         else if (pn == ProcessNodeRet::Prune) { continue; }
         else if (pn == ProcessNodeRet::Break) {
+          closeLevel(claims, stackDepth);
           stackDepth--;
           depth--;
           continue;
         }
 
-        // Get the child's generator
-        const auto childGen = Generator(space, child);
-
         // Going down
         stackDepth++;
         depth++;
@@ -230,8 +624,16 @@ struct StackStealing {
           }
         }
 
+        if (pathSteals) {
+          path.resize(basePathLen + stackDepth - 1);
+          path.push_back(generatorStack[stackDepth - 1].seen - 1);
+        }
+
+        // Get the child's generator
         generatorStack[stackDepth].seen = 0;
-        generatorStack[stackDepth].gen = childGen;
+        makeGenerator(generatorStack[stackDepth].gen, space, child,
+                      pathSteals && ++generated % RecomputeCost<Generator>::sampleInterval == 0);
+        openLevel(claims, generatorStack, stackDepth, depth + 1, reg->params);
       } else {
         stackDepth--;
         depth--;
@@ -244,15 +646,20 @@ struct StackStealing {
                                 const Space & space,
                                 GeneratorStack<Generator> & generatorStack,
                                 const std::shared_ptr<SharedState> stealRequest,
+                                const std::shared_ptr<ClaimState> claims,
                                 Enum & acc,
                                 const hpx::naming::id_type donePromise,
                                 const unsigned searchManagerId,
+                                std::vector<std::uint32_t> path,
                                 const int stackDepth = 0,
                                 const int depth = -1) {
     auto reg = Registry<Space, Node, Bound, Enum>::gReg;
     std::vector<hpx::future<void> > futures;
 
-    runWithStack(startingDepth, space, generatorStack, stealRequest, acc, futures, stackDepth, depth);
+    runWithStack(startingDepth, space, generatorStack, stealRequest, claims.get(), acc, futures, path, stackDepth, depth);
+    if (claims) {
+      claims->levels.closeAll();
+    }
 
     // Atomically updates the (process) local counter
     if constexpr(isEnumeration) {
@@ -261,16 +668,26 @@ struct StackStealing {
 
     std::static_pointer_cast<Policy>(Workstealing::Scheduler::local_policy)->unregisterThread(searchManagerId);
 
+    // No thief can claim from us once we are unregistered
+    if (claims) {
+      std::move(claims->futures.begin(), claims->futures.end(), std::back_inserter(futures));
+    }
+
+    if constexpr(countTermination) {
+      Workstealing::Termination::taskCompleted();
+      return;
+    }
+
     hpx::apply(hpx::util::bind([=](std::vector<hpx::future<void> > & futs) {
           hpx::wait_all(futs);
-          hpx::async<hpx::lcos::base_lco_with_value<void>::set_value_action>(donePromise, true);
+          util::CompletionAggregator::complete(donePromise);
         }, std::move(futures)));
   }
 
 
   // Action to push a new scheduler running this skeleton to a distributed node
   // (for setting initial work distribution)
-  static void addWork (const Node initNode,
+  static void addWork (const TaskNode<Node> initNode,
                        const unsigned depth,
                        const hpx::naming::id_type donePromise) {
     hpx::threads::executors::default_executor exe(hpx::threads::thread_priority_critical,
@@ -284,6 +701,47 @@ struct StackStealing {
     &StackStealing<Generator, Args...>::addWork,
     addWorkAct>::type {};
 
+  // Path from the root to the node at stackDepth of a stack started at the root
+  static std::vector<std::uint32_t> stackPath(const GeneratorStack<Generator> & generatorStack,
+                                              const int stackDepth) {
+    std::vector<std::uint32_t> path;
+    for (auto i = 0; i < stackDepth; ++i) {
+      path.push_back(generatorStack[i].seen - 1);
+    }
+    return path;
+  }
+
+  // Where the initial tasks go, in order: every locality once per worker (less one here, for the
+  // thread searching the rest of the root's stack). Interleaved by smooth weighted round robin, so
+  // if there are fewer tasks than workers they are still shared out in proportion to the workers.
+  static std::vector<hpx::naming::id_type> initialWorkTargets() {
+    const auto & workers = Workstealing::Scheduler::workersPerLocality();
+    auto localities = util::findOtherLocalities();
+    localities.push_back(hpx::find_here());
+
+    std::vector<std::int64_t> weight, current(localities.size(), 0);
+    std::int64_t total = 0;
+    for (const auto & l : localities) {
+      std::int64_t n = workers[hpx::naming::get_locality_id_from_id(l)];
+      weight.push_back(l == hpx::find_here() ? n - 1 : n);
+      total += weight.back();
+    }
+
+    std::vector<hpx::naming::id_type> targets;
+    for (std::int64_t t = 0; t < total; ++t) {
+      std::size_t best = 0;
+      for (std::size_t i = 0; i < localities.size(); ++i) {
+        current[i] += weight[i];
+        if (current[i] > current[best]) {
+          best = i;
+        }
+      }
+      current[best] -= total;
+      targets.push_back(localities[best]);
+    }
+    return targets;
+  }
+
   static void spawnInitialWork(const unsigned depthRequired,
                                const unsigned tasksRequired,
                                int & stackDepth,
@@ -294,8 +752,7 @@ struct StackStealing {
                                std::vector<hpx::future<void> > & futures){
 
     auto reg = Registry<Space, Node, Bound, Enum>::gReg;
-    auto localities = util::findOtherLocalities();
-    localities.push_back(hpx::find_here());
+    auto targets = initialWorkTargets();
 
     auto tasksSpawned = 0;
     while (stackDepth >= 0) {
@@ -303,7 +760,7 @@ struct StackStealing {
       if (generatorStack[stackDepth].seen < generatorStack[stackDepth].gen.numChildren) {
 
         // Get the next child at this stackDepth
-        generatorStack[stackDepth + 1].node = generatorStack[stackDepth].gen.next();
+        nextChildInto(generatorStack[stackDepth].gen, generatorStack[stackDepth + 1].node);
         auto & child = generatorStack[stackDepth + 1].node;
 
         generatorStack[stackDepth].seen++;
@@ -314,14 +771,16 @@ struct StackStealing {
 
         // Push anything at this depth as a task
         if (stackDepth == depthRequired) {
-          hpx::promise<void> prom;
-          auto f = prom.get_future();
-          auto pid = prom.get_id();
-          futures.push_back(std::move(f));
+          std::vector<hpx::promise<void> > promises;
+          auto pid = trackTask(promises, futures);
 
           // This needs to go to localities no managers now
-          auto mgr = tasksSpawned % localities.size();
-          hpx::async<addWorkAct>(localities[mgr], child, depth, pid);
+          auto mgr = tasksSpawned % targets.size();
+          if (reg->params.pathSteals) {
+            hpx::async<addWorkAct>(targets[mgr], TaskNode<Node>(child, stackPath(generatorStack, stackDepth)), depth, pid);
+          } else {
+            hpx::async<addWorkAct>(targets[mgr], TaskNode<Node>(child), depth, pid);
+          }
 
           stackDepth--;
           depth--;
@@ -333,7 +792,7 @@ struct StackStealing {
           }
         } else {
           // Need to process nodes we don't spawn to ensure correct enumeration etc
-          auto pn = ProcessNode<Space, Node, Args...>::processNode(reg->params, space, child, acc);
+          auto pn = ProcessNode<Space, Node, Args...>::processNode(reg->params, space, child, depth - 1, acc);
           if (pn == ProcessNodeRet::Exit) { return; }
           else if (pn == ProcessNodeRet::Prune) { continue; }
           else if (pn == ProcessNodeRet::Break) {
@@ -342,9 +801,8 @@ struct StackStealing {
             continue;
           }
           // Get the child's generator
-          const auto childGen = Generator(space, child);
           generatorStack[stackDepth].seen = 0;
-          generatorStack[stackDepth].gen = childGen;
+          resetGenerator(generatorStack[stackDepth].gen, space, child);
         }
       } else {
         stackDepth--;
@@ -357,13 +815,8 @@ struct StackStealing {
                        const Node & root,
                        const API::Params<Bound> & params) {
 
-    // FIXME: Assumes homogeneous machines
-    unsigned totalThreads = 0;
-    if (hpx::get_os_thread_count() == 1) {
-      totalThreads = hpx::find_all_localities().size();
-    } else {
-      totalThreads = hpx::find_all_localities().size() * (hpx::get_os_thread_count() - 1);
-    }
+    // Localities may have different core counts
+    auto totalThreads = Workstealing::Scheduler::totalWorkers();
 
     // Master stack
     StackElem<Generator> rootElem(space, root);
@@ -371,7 +824,7 @@ struct StackStealing {
     GeneratorStack<Generator> genStack(maxStackDepth, rootElem);
 
     Enum acc;
-    acc.accumulate(root);
+    accumulateNode(acc, root, 0);
 
     auto stackDepth = 0;
     auto depth = 1;
@@ -383,70 +836,127 @@ struct StackStealing {
     }
 
     // Register the rest of the work from the main thread with the search manager
-    auto searchMgrInfo = std::static_pointer_cast<Policy>(Workstealing::Scheduler::local_policy)->registerThread();
+    auto claims = makeClaimState(params);
+    auto searchMgrInfo = std::static_pointer_cast<Policy>(Workstealing::Scheduler::local_policy)->registerThread(
+        claimFn(claims, Registry<Space, Node, Bound, Enum>::gReg->localSpace(), 1));
     auto stealRequest  = std::get<0>(searchMgrInfo);
 
     // Continue the actual work
-    hpx::promise<void> prom;
-    auto f = prom.get_future();
-    auto pid = prom.get_id();
+    std::vector<hpx::promise<void> > promises;
+    auto pid = trackTask(promises, futures);
+
+    std::vector<std::uint32_t> path;
+    if (params.pathSteals) {
+      path = stackPath(genStack, stackDepth);
+    }
 
     // Launch initialising thread as a new Scheduler
     if (totalThreads == 1) {
-      runTaskFromStack(1, space, genStack, stealRequest, acc, pid, std::get<1>(searchMgrInfo), stackDepth, depth);
+      runTaskFromStack(1, space, genStack, stealRequest, claims, acc, pid, std::get<1>(searchMgrInfo), path, stackDepth, depth);
     } else {
       hpx::threads::executors::default_executor exe(hpx::threads::thread_priority_critical,
                                                     hpx::threads::thread_stacksize_huge);
-      hpx::util::function<void(), false> fn = hpx::util::bind(&runTaskFromStack, 1, space, genStack, stealRequest, acc, pid, std::get<1>(searchMgrInfo), stackDepth, depth);
+      hpx::util::function<void(), false> fn = hpx::util::bind(&runTaskFromStack, 1, space, genStack, stealRequest, claims, acc, pid, std::get<1>(searchMgrInfo), path, stackDepth, depth);
       auto f = hpx::util::bind(&Workstealing::Scheduler::scheduler, fn);
       exe.add(f);
     }
 
-    futures.push_back(std::move(f));
-    hpx::wait_all(futures);
+    if constexpr(countTermination) {
+      Workstealing::Termination::waitForTermination();
+    } else {
+      hpx::wait_all(futures);
+    }
+  }
+
+  // Hybrid: the root is an ordinary task, workers pick up the depth bounded spawns from the
+  // buffers (stealing remotely if they have none) and steal from running stacks once they drain
+  static void doHybridSearch(const Space & space,
+                             const Node & root,
+                             const API::Params<Bound> & params) {
+    hpx::wait_all(hpx::lcos::broadcast<Workstealing::Scheduler::startLocalSchedulers_act>(
+        hpx::find_all_localities()));
+
+    std::vector<hpx::promise<void> > promises;
+    std::vector<hpx::future<void> > futures;
+    auto pid = trackTask(promises, futures);
+    std::static_pointer_cast<Policy>(Workstealing::Scheduler::local_policy)->addwork(TaskNode<Node>(root), 1, pid);
+
+    if constexpr(countTermination) {
+      Workstealing::Termination::waitForTermination();
+    } else {
+      hpx::wait_all(futures);
+    }
   }
 
   static auto search (const Space & space,
                       const Node & root,
-                      const API::Params<Bound> params = API::Params<Bound>()) {
+                      API::Params<Bound> params = API::Params<Bound>()) {
+    // Thieves take work off the searching stack at any time, so it has no consistent point to record
+    API::rejectCheckpoints(params, "StackStealing");
+
+    SearchContext ctx;
+
+    if constexpr(verbose > 1) {
+      Workstealing::StealStats::setEnabledEverywhere(true);
+    }
+
+    if (params.autoTune) {
+      util::autoTune<Generator, isDepthBounded>(space, root, params, verbose);
+    }
+
     if constexpr(verbose) {
       printSkeletonDetails(params);
     }
 
-    hpx::wait_all(hpx::lcos::broadcast<InitRegistryAct<Space, Node, Bound, Enum> >(
-        hpx::find_all_localities(), space, root, params));
+    initRegistries<Space, Node, Bound, Enum>(space, root, params);
 
-    Policy::initPolicy();
+    PN::initSearch(params);
+    util::TaskTrace::begin(params.traceFile, params.traceBufferSize);
+
+    Policy::initPolicy(params.maxDistributedSteals, params.stealPrefetchThreshold);
+
+    if constexpr(countTermination) {
+      hpx::wait_all(hpx::lcos::broadcast<Workstealing::Termination::reset_act>(hpx::find_all_localities()));
+    }
 
     if constexpr(isOptimisation || isDecision) {
       auto inc = hpx::new_<Incumbent>(hpx::find_here()).get();
       hpx::wait_all(hpx::lcos::broadcast<UpdateGlobalIncumbentAct<Space, Node, Bound, Enum> >(
           hpx::find_all_localities(), inc));
-      initIncumbent<Space, Node, Bound, Enum, Objcmp, Verbose>(root, params.initialBound);
+      PN::initIncumbent(root, params);
     }
 
-    doSearch(space, root, params);
+    if constexpr(isHybrid) {
+      doHybridSearch(space, root, params);
+    } else {
+      doSearch(space, root, params);
+    }
 
     hpx::wait_all(hpx::lcos::broadcast<Workstealing::Scheduler::stopSchedulers_act>(
         hpx::find_all_localities()));
 
+    if constexpr (verbose >= 2) {
+      Workstealing::WorkerStates::printAllReports();
+    }
+
+    if constexpr (verbose >= 3) {
+      Workstealing::StealStats::printAllReports();
+    }
+
     hpx::cout << hpx::flush;
 
     if (verbose >= 3) {
-      for (const auto &l : hpx::find_all_localities()) {
-        // We don't broadcast here to avoid racy output.
-        hpx::async<Workstealing::Policies::SearchManagerPerf::printChunkSizeList_act>(l).get();
-      }
+      util::printOnEachLocality<Workstealing::Policies::SearchManagerPerf::printChunkSizeList_act>();
     }
 
+    util::TaskTrace::end(params.traceFile);
+    PN::printReports();
+
     // Return the right thing
     if constexpr(isEnumeration) {
       return combineEnumerators<Space, Node, Bound, Enum>();
     } else if constexpr(isOptimisation || isDecision) {
-      auto reg = Registry<Space, Node, Bound, Enum>::gReg;
-
-      typedef typename Incumbent::GetIncumbentAct<Node, Bound, Objcmp, Verbose> getInc;
-      return hpx::async<getInc>(reg->globalIncumbent).get();
+      return getFinalIncumbent<Space, Node, Bound, Enum, Objcmp, Verbose, lazyIncumbent>();
     } else {
       static_assert(isEnumeration || isOptimisation || isDecision, "Please provide a supported search type: Enumeration, Optimisation, Decision");
     }
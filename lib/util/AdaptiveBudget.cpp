@@ -0,0 +1,130 @@
+#include "AdaptiveBudget.hpp"
+
+#include <hpx/include/iostreams.hpp>
+#include <hpx/lcos/local/mutex.hpp>
+#include <hpx/performance_counters/manage_counter_type.hpp>
+#include <hpx/runtime/get_locality_id.hpp>
+
+#include <boost/format.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace Workstealing { namespace Scheduler {
+bool starving();
+bool saturated(unsigned perWorker);
+}}
+
+namespace YewPar { namespace util { namespace AdaptiveBudget {
+
+namespace {
+
+constexpr unsigned minBudget = 8;
+constexpr unsigned maxBudget = 1u << 24;
+
+// Tasks to average over before adjusting
+constexpr std::uint64_t sampleTasks = 64;
+
+// Pool is flooded once it holds this many tasks per worker
+constexpr unsigned floodFactor = 16;
+
+std::atomic<unsigned> budget(200);
+std::chrono::nanoseconds target(std::chrono::milliseconds(1));
+
+std::atomic<std::uint64_t> sampleCount(0);
+std::atomic<std::uint64_t> sampleNanos(0);
+
+// Protected by adjustMtx
+hpx::lcos::local::mutex adjustMtx;
+unsigned lowest = 200;
+unsigned highest = 200;
+std::uint64_t adjustments = 0;
+double lastMeanMicros = 0;
+
+std::uint64_t getBudget(bool) { return budget.load(); }
+
+// Must hold adjustMtx
+void adjust(double meanNanos) {
+  auto b = budget.load(std::memory_order_relaxed);
+
+  auto factor = std::max(0.5, std::min(2.0, target.count() / std::max(meanNanos, 1.0)));
+
+  if (Workstealing::Scheduler::starving()) {
+    factor = std::min(factor, 0.5);
+  } else if (Workstealing::Scheduler::saturated(floodFactor)) {
+    factor = std::max(factor, 2.0);
+  }
+
+  auto next = static_cast<unsigned>(std::max<double>(minBudget, std::min<double>(maxBudget, b * factor)));
+  lastMeanMicros = meanNanos / 1000;
+  if (next == b) {
+    return;
+  }
+
+  budget.store(next, std::memory_order_relaxed);
+  lowest = std::min(lowest, next);
+  highest = std::max(highest, next);
+  ++adjustments;
+}
+
+}
+
+void reset(unsigned initialBudget, unsigned targetTaskMicros) {
+  std::lock_guard<hpx::lcos::local::mutex> l(adjustMtx);
+  auto b = std::max(minBudget, std::min(maxBudget, initialBudget));
+  budget.store(b);
+  target = std::chrono::microseconds(std::max(1u, targetTaskMicros));
+  sampleCount.store(0);
+  sampleNanos.store(0);
+  lowest = highest = b;
+  adjustments = 0;
+  lastMeanMicros = 0;
+}
+
+unsigned current() {
+  return budget.load(std::memory_order_relaxed);
+}
+
+void taskFinished(std::chrono::steady_clock::duration taskTime) {
+  sampleNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(taskTime).count();
+  if (++sampleCount < sampleTasks) {
+    return;
+  }
+
+  // Someone else is already adjusting, our sample goes into the next round
+  std::unique_lock<hpx::lcos::local::mutex> l(adjustMtx, std::try_to_lock);
+  if (!l.owns_lock()) {
+    return;
+  }
+
+  auto n = sampleCount.exchange(0);
+  auto ns = sampleNanos.exchange(0);
+  if (n > 0) {
+    adjust(static_cast<double>(ns) / n);
+  }
+}
+
+void printReport() {
+  std::lock_guard<hpx::lcos::local::mutex> l(adjustMtx);
+  hpx::cout
+      << (boost::format("%1% Adaptive Budget: final %2% (min %3%, max %4%, %5% adjustments, last mean task %6% us)")
+          % static_cast<std::int64_t>(hpx::get_locality_id())
+          % budget.load()
+          % lowest
+          % highest
+          % adjustments
+          % lastMeanMicros)
+      << hpx::endl;
+}
+
+void registerPerformanceCounters() {
+  hpx::performance_counters::install_counter_type(
+      "/skeletons/budget/backtrackBudget",
+      &getBudget,
+      "Returns the backtrack budget currently used on this locality (adaptive budget only)"
+                                                  );
+}
+
+}}}
@@ -0,0 +1,35 @@
+#ifndef YEWPAR_ADAPTIVE_BUDGET_HPP
+#define YEWPAR_ADAPTIVE_BUDGET_HPP
+
+#include <chrono>
+
+#include <hpx/runtime/actions/plain_action.hpp>
+
+// Per locality tuning of the Budget skeleton's backtrack budget (Params::adaptiveBudget).
+//
+// Finished tasks report how long they ran. Every sampleTasks tasks the mean duration is compared
+// with the target granularity and the budget scaled towards it (by at most 2x either way). The
+// local pool occupancy and number of parked schedulers override this: idle workers with nothing
+// queued for them halve the budget (more spawns), a pool with plenty queued for every worker
+// doubles it (fewer spawns).
+namespace YewPar { namespace util { namespace AdaptiveBudget {
+
+// Start a search with the given budget and target task duration. Must run on every locality.
+void reset(unsigned initialBudget, unsigned targetTaskMicros);
+HPX_DEFINE_PLAIN_ACTION(reset, reset_act);
+
+// Budget to use for the next spawn decision on this locality
+unsigned current();
+
+// Called by each task once it has finished (not including its children)
+void taskFinished(std::chrono::steady_clock::duration taskTime);
+
+// Print the values chosen on this locality during the last search
+void printReport();
+HPX_DEFINE_PLAIN_ACTION(printReport, printReport_act);
+
+void registerPerformanceCounters();
+
+}}}
+
+#endif
@@ -0,0 +1,111 @@
+#include "AdaptiveSpawnDepth.hpp"
+
+#include <hpx/include/iostreams.hpp>
+#include <hpx/runtime/get_locality_id.hpp>
+
+#include <boost/format.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+namespace Workstealing { namespace Scheduler {
+bool starving();
+bool saturated(unsigned perWorker);
+}}
+
+namespace YewPar { namespace util { namespace AdaptiveSpawnDepth {
+
+namespace {
+
+// Deeper tasks share the last entry
+constexpr unsigned maxTrackedDepth = 128;
+
+// Stop spawning above the cutoff once the pool holds this many tasks per worker
+constexpr unsigned floodFactor = 16;
+
+// Tasks smaller than this aren't worth spawning below the cutoff, judged after minSamples tasks
+constexpr std::uint64_t minSamples = 32;
+constexpr auto minTaskTime = std::chrono::microseconds(50);
+
+struct DepthStats {
+  std::atomic<std::uint64_t> tasks {0};
+  std::atomic<std::uint64_t> nanos {0};
+  std::atomic<std::uint64_t> extraSpawns {0};
+  std::atomic<std::uint64_t> suppressedSpawns {0};
+};
+
+DepthStats stats[maxTrackedDepth];
+
+DepthStats & statsFor(unsigned depth) {
+  return stats[std::min(depth, maxTrackedDepth - 1)];
+}
+
+bool tooSmall(const DepthStats & s) {
+  auto n = s.tasks.load(std::memory_order_relaxed);
+  return n >= minSamples &&
+      s.nanos.load(std::memory_order_relaxed) / n <
+      static_cast<std::uint64_t>(std::chrono::nanoseconds(minTaskTime).count());
+}
+
+}
+
+void reset() {
+  for (auto & s : stats) {
+    s.tasks.store(0);
+    s.nanos.store(0);
+    s.extraSpawns.store(0);
+    s.suppressedSpawns.store(0);
+  }
+}
+
+bool shouldSpawn(unsigned childDepth, unsigned spawnDepth) {
+  auto & s = statsFor(childDepth + 1);
+
+  if (childDepth <= spawnDepth) {
+    // Always spawn the root's children so there is something to steal
+    if (childDepth > 1 && Workstealing::Scheduler::saturated(floodFactor)) {
+      s.suppressedSpawns.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    return true;
+  }
+
+  if (!Workstealing::Scheduler::starving()) {
+    return false;
+  }
+
+  if (tooSmall(s)) {
+    return false;
+  }
+  s.extraSpawns.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void taskFinished(unsigned childDepth, std::chrono::steady_clock::duration taskTime) {
+  auto & s = statsFor(childDepth);
+  s.tasks.fetch_add(1, std::memory_order_relaxed);
+  s.nanos.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(taskTime).count(),
+                    std::memory_order_relaxed);
+}
+
+void printReport() {
+  for (unsigned d = 0; d < maxTrackedDepth; ++d) {
+    const auto & s = stats[d];
+    auto n = s.tasks.load();
+    if (n == 0 && s.suppressedSpawns.load() == 0) {
+      continue;
+    }
+    hpx::cout
+        << (boost::format("%1% Depth %2%: %3% tasks, mean %4% us, %5% spawned below cutoff, %6% kept local above cutoff")
+            % static_cast<std::int64_t>(hpx::get_locality_id())
+            % d
+            % n
+            % (n > 0 ? s.nanos.load() / 1000.0 / n : 0.0)
+            % s.extraSpawns.load()
+            % s.suppressedSpawns.load())
+        << hpx::endl;
+  }
+}
+
+}}}
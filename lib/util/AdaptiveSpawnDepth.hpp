@@ -0,0 +1,35 @@
+#ifndef YEWPAR_ADAPTIVE_SPAWN_DEPTH_HPP
+#define YEWPAR_ADAPTIVE_SPAWN_DEPTH_HPP
+
+#include <chrono>
+
+#include <hpx/runtime/actions/plain_action.hpp>
+
+// Spawn decisions for DepthBounded with Params::adaptiveSpawnDepth, made per locality.
+//
+// Above the cutoff (depth <= spawnDepth) children are spawned as usual unless the local pool is
+// saturated, in which case they are searched in the current task. Below the cutoff children are
+// searched in the current task unless workers are parked and the pool is (nearly) empty, in which
+// case they are spawned. Tasks record how long they ran per depth; once enough tasks at a depth
+// have been seen, depths whose tasks turn out too small to be worth a spawn are never spawned
+// below the cutoff.
+namespace YewPar { namespace util { namespace AdaptiveSpawnDepth {
+
+// Clear the statistics for a new search. Must run on every locality.
+void reset();
+HPX_DEFINE_PLAIN_ACTION(reset, reset_act);
+
+// Should a child found while expanding at childDepth be spawned (as a task for childDepth + 1)?
+bool shouldSpawn(unsigned childDepth, unsigned spawnDepth);
+
+// Called by each task once it has finished (not including its children), with the childDepth it
+// was spawned for
+void taskFinished(unsigned childDepth, std::chrono::steady_clock::duration taskTime);
+
+// Print the per depth statistics of the last search on this locality
+void printReport();
+HPX_DEFINE_PLAIN_ACTION(printReport, printReport_act);
+
+}}}
+
+#endif
@@ -0,0 +1,121 @@
+#include "AdaptiveSpawnRate.hpp"
+
+#include <hpx/include/iostreams.hpp>
+#include <hpx/performance_counters/manage_counter_type.hpp>
+#include <hpx/runtime/get_locality_id.hpp>
+
+#include <boost/format.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+
+namespace Workstealing { namespace Scheduler {
+bool starving();
+bool saturated(unsigned perWorker);
+}}
+
+namespace YewPar { namespace util { namespace AdaptiveSpawnRate {
+
+namespace {
+
+constexpr unsigned minProbability = 1;
+constexpr unsigned maxProbability = 1u << 30;
+
+// Pool is flooded once it holds this many tasks per worker
+constexpr unsigned floodFactor = 16;
+
+constexpr std::int64_t adjustIntervalNanos = 1000000;
+
+std::atomic<unsigned> probability(1000000);
+std::atomic<std::uint64_t> currentThreshold(thresholdFor(1000000));
+
+// Time of the last adjustment, whoever wins the CAS on it gets to adjust
+std::atomic<std::int64_t> lastAdjust(0);
+
+std::atomic<unsigned> lowest(1000000);
+std::atomic<unsigned> highest(1000000);
+std::atomic<std::uint64_t> adjustments(0);
+
+std::int64_t nowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void set(unsigned p) {
+  probability.store(p, std::memory_order_relaxed);
+  currentThreshold.store(thresholdFor(p), std::memory_order_relaxed);
+}
+
+std::uint64_t getProbability(bool) { return probability.load(); }
+
+}
+
+std::uint64_t thresholdFor(unsigned spawnProbability) {
+  if (spawnProbability == 0) {
+    return 0;
+  }
+  return std::numeric_limits<std::uint64_t>::max() / spawnProbability;
+}
+
+void reset(unsigned initialProbability) {
+  auto p = initialProbability == 0 ? maxProbability
+                                   : std::max(minProbability, std::min(maxProbability, initialProbability));
+  set(p);
+  lastAdjust.store(nowNanos());
+  lowest.store(p);
+  highest.store(p);
+  adjustments.store(0);
+}
+
+std::uint64_t threshold() {
+  return currentThreshold.load(std::memory_order_relaxed);
+}
+
+void update() {
+  auto now = nowNanos();
+  auto last = lastAdjust.load(std::memory_order_relaxed);
+  if (now - last < adjustIntervalNanos ||
+      !lastAdjust.compare_exchange_strong(last, now, std::memory_order_relaxed)) {
+    return;
+  }
+
+  auto p = probability.load(std::memory_order_relaxed);
+  auto next = p;
+  if (Workstealing::Scheduler::starving()) {
+    next = std::max(minProbability, p / 2);
+  } else if (Workstealing::Scheduler::saturated(floodFactor)) {
+    next = std::min(maxProbability, p * 2);
+  }
+
+  if (next == p) {
+    return;
+  }
+
+  set(next);
+  ++adjustments;
+  if (next < lowest.load()) { lowest.store(next); }
+  if (next > highest.load()) { highest.store(next); }
+}
+
+void printReport() {
+  hpx::cout
+      << (boost::format("%1% Adaptive Spawn Probability: final 1/%2% (min 1/%3%, max 1/%4%, %5% adjustments)")
+          % static_cast<std::int64_t>(hpx::get_locality_id())
+          % probability.load()
+          % lowest.load()
+          % highest.load()
+          % adjustments.load())
+      << hpx::endl;
+}
+
+void registerPerformanceCounters() {
+  hpx::performance_counters::install_counter_type(
+      "/skeletons/random/spawnProbability",
+      &getProbability,
+      "Returns n where the current spawn probability on this locality is 1/n (adaptive spawn probability only)"
+                                                  );
+}
+
+}}}
@@ -0,0 +1,37 @@
+#ifndef YEWPAR_ADAPTIVE_SPAWN_RATE_HPP
+#define YEWPAR_ADAPTIVE_SPAWN_RATE_HPP
+
+#include <cstdint>
+
+#include <hpx/runtime/actions/plain_action.hpp>
+
+// Per locality tuning of the BasicRandom skeleton's spawn probability
+// (Params::adaptiveSpawnProbability). A spawn probability of n means a node spawns with chance 1/n.
+//
+// Workers call update() every so often; at most once per millisecond (per locality) it halves n
+// (spawn more) if workers are parked with nothing queued for them, or doubles it (spawn less) if
+// the local pool holds plenty of work for every worker.
+namespace YewPar { namespace util { namespace AdaptiveSpawnRate {
+
+// Random numbers (from util::threadRandom) below this spawn, giving chance 1/spawnProbability
+std::uint64_t thresholdFor(unsigned spawnProbability);
+
+// Start a search from the given spawn probability. Must run on every locality.
+void reset(unsigned initialProbability);
+HPX_DEFINE_PLAIN_ACTION(reset, reset_act);
+
+// Current threshold on this locality
+std::uint64_t threshold();
+
+// Possibly adjust the spawn probability to the current load
+void update();
+
+// Print the values chosen on this locality during the last search
+void printReport();
+HPX_DEFINE_PLAIN_ACTION(printReport, printReport_act);
+
+void registerPerformanceCounters();
+
+}}}
+
+#endif
@@ -0,0 +1,564 @@
+#ifndef YEWPAR_BITSET_HPP
+#define YEWPAR_BITSET_HPP
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define YEWPAR_BITSET_X86 1
+#endif
+
+#include "BitwiseSerializable.hpp"
+
+// Fixed size bitsets (Ciaran McCreesh's, from the maxclique and mcs apps), with the word loops
+// done by SIMD kernels picked at runtime.
+//
+// Each kernel is compiled for its own instruction set with target attributes, so the build needs
+// no -march flags and one binary runs everywhere: the widest set the CPU supports is detected on
+// first use. The YEWPAR_BITSET_KERNELS environment variable (scalar, avx2, avx512 or
+// avx512popcnt) asks for a narrower one, for comparisons. Every call branches on the level, which
+// never changes during a search so the branch predicts well.
+namespace YewPar { namespace util {
+
+using BitWord = unsigned long long;
+static const constexpr int bits_per_word = sizeof(BitWord) * 8;
+
+namespace BitSetKernels {
+
+// In increasing order, each level implies the ones before it
+enum class Level { Scalar, AVX2, AVX512, AVX512Popcnt };
+
+inline const char * name(const Level l) {
+  switch (l) {
+    case Level::AVX2: return "avx2";
+    case Level::AVX512: return "avx512";
+    case Level::AVX512Popcnt: return "avx512popcnt";
+    default: return "scalar";
+  }
+}
+
+// Widest level this CPU supports
+inline Level supported() {
+#ifdef YEWPAR_BITSET_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return __builtin_cpu_supports("avx512vpopcntdq") ? Level::AVX512Popcnt : Level::AVX512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+    return Level::AVX2;
+  }
+#endif
+  return Level::Scalar;
+}
+
+inline Level & currentLevel() {
+  static Level l = []() {
+      auto best = supported();
+      auto env = std::getenv("YEWPAR_BITSET_KERNELS");
+      if (env) {
+        for (auto l : {Level::Scalar, Level::AVX2, Level::AVX512, Level::AVX512Popcnt}) {
+          if (std::strcmp(env, name(l)) == 0 && l < best) {
+            return l;
+          }
+        }
+      }
+      return best;
+    }();
+  return l;
+}
+
+inline Level level() {
+  return currentLevel();
+}
+
+// Use l (or the widest supported level, if l is wider) from now on. Not thread safe, for benchmarks.
+inline void setLevel(const Level l) {
+  auto best = supported();
+  currentLevel() = l < best ? l : best;
+}
+
+namespace scalar {
+
+inline void intersect(BitWord * a, const BitWord * b, const unsigned n) {
+  for (unsigned i = 0; i < n; ++i) {
+    a[i] &= b[i];
+  }
+}
+
+inline void intersectComplement(BitWord * a, const BitWord * b, const unsigned n) {
+  for (unsigned i = 0; i < n; ++i) {
+    a[i] &= ~b[i];
+  }
+}
+
+inline unsigned popcount(const BitWord * a, const unsigned n) {
+  unsigned result = 0;
+  for (unsigned i = 0; i < n; ++i) {
+    result += __builtin_popcountll(a[i]);
+  }
+  return result;
+}
+
+inline int firstSetBit(const BitWord * a, const unsigned n) {
+  for (unsigned i = 0; i < n; ++i) {
+    int b = __builtin_ffsll(a[i]);
+    if (0 != b) {
+      return i * bits_per_word + b - 1;
+    }
+  }
+  return -1;
+}
+
+inline void unite(BitWord * a, const BitWord * b, const unsigned n) {
+  for (unsigned i = 0; i < n; ++i) {
+    a[i] |= b[i];
+  }
+}
+
+inline unsigned intersectAllPopcount(BitWord * a, const BitWord * const * rows, const unsigned k, const unsigned n) {
+  unsigned result = 0;
+  for (unsigned i = 0; i < n; ++i) {
+    auto w = a[i];
+    for (unsigned r = 0; r < k; ++r) {
+      w &= rows[r][i];
+    }
+    a[i] = w;
+    result += __builtin_popcountll(w);
+  }
+  return result;
+}
+
+inline unsigned intersectComplementPopcount(BitWord * a, const BitWord * b, const unsigned n) {
+  unsigned result = 0;
+  for (unsigned i = 0; i < n; ++i) {
+    a[i] &= ~b[i];
+    result += __builtin_popcountll(a[i]);
+  }
+  return result;
+}
+
+inline unsigned unitePopcount(BitWord * a, const BitWord * b, const unsigned n) {
+  unsigned result = 0;
+  for (unsigned i = 0; i < n; ++i) {
+    a[i] |= b[i];
+    result += __builtin_popcountll(a[i]);
+  }
+  return result;
+}
+
+}
+
+#ifdef YEWPAR_BITSET_X86
+
+namespace avx2 {
+
+__attribute__((target("avx2")))
+inline void intersect(BitWord * a, const BitWord * b, const unsigned n) {
+  unsigned i = 0;
+  for (; i + 4 <= n; i += 4) {
+    auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(a + i), _mm256_and_si256(x, y));
+  }
+  for (; i < n; ++i) {
+    a[i] &= b[i];
+  }
+}
+
+__attribute__((target("avx2")))
+inline void intersectComplement(BitWord * a, const BitWord * b, const unsigned n) {
+  unsigned i = 0;
+  for (; i + 4 <= n; i += 4) {
+    auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+    // andnot complements its first argument
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(a + i), _mm256_andnot_si256(y, x));
+  }
+  for (; i < n; ++i) {
+    a[i] &= ~b[i];
+  }
+}
+
+// A word at a time is as fast as the nibble lookup tricks for sets this small
+__attribute__((target("popcnt")))
+inline unsigned popcount(const BitWord * a, const unsigned n) {
+  unsigned result = 0;
+  for (unsigned i = 0; i < n; ++i) {
+    result += _mm_popcnt_u64(a[i]);
+  }
+  return result;
+}
+
+__attribute__((target("avx2,bmi")))
+inline int firstSetBit(const BitWord * a, const unsigned n) {
+  unsigned i = 0;
+  for (; i + 4 <= n; i += 4) {
+    auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    auto zero = _mm256_cmpeq_epi64(x, _mm256_setzero_si256());
+    auto nonZero = ~_mm256_movemask_pd(_mm256_castsi256_pd(zero)) & 0xf;
+    if (nonZero) {
+      auto w = i + __builtin_ctz(nonZero);
+      return w * bits_per_word + _tzcnt_u64(a[w]);
+    }
+  }
+  for (; i < n; ++i) {
+    if (a[i]) {
+      return i * bits_per_word + _tzcnt_u64(a[i]);
+    }
+  }
+  return -1;
+}
+
+__attribute__((target("avx2")))
+inline void unite(BitWord * a, const BitWord * b, const unsigned n) {
+  unsigned i = 0;
+  for (; i + 4 <= n; i += 4) {
+    auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(a + i), _mm256_or_si256(x, y));
+  }
+  for (; i < n; ++i) {
+    a[i] |= b[i];
+  }
+}
+
+// The fused kernels count each word while it is still in a register, there's no vector popcount
+__attribute__((target("avx2,popcnt")))
+inline unsigned popcount4(const __m256i x) {
+  return _mm_popcnt_u64(_mm256_extract_epi64(x, 0)) + _mm_popcnt_u64(_mm256_extract_epi64(x, 1))
+       + _mm_popcnt_u64(_mm256_extract_epi64(x, 2)) + _mm_popcnt_u64(_mm256_extract_epi64(x, 3));
+}
+
+__attribute__((target("avx2,popcnt")))
+inline unsigned intersectAllPopcount(BitWord * a, const BitWord * const * rows, const unsigned k, const unsigned n) {
+  unsigned result = 0;
+  unsigned i = 0;
+  for (; i + 4 <= n; i += 4) {
+    auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    for (unsigned r = 0; r < k; ++r) {
+      x = _mm256_and_si256(x, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows[r] + i)));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(a + i), x);
+    result += popcount4(x);
+  }
+  for (; i < n; ++i) {
+    auto w = a[i];
+    for (unsigned r = 0; r < k; ++r) {
+      w &= rows[r][i];
+    }
+    a[i] = w;
+    result += _mm_popcnt_u64(w);
+  }
+  return result;
+}
+
+__attribute__((target("avx2,popcnt")))
+inline unsigned intersectComplementPopcount(BitWord * a, const BitWord * b, const unsigned n) {
+  unsigned result = 0;
+  unsigned i = 0;
+  for (; i + 4 <= n; i += 4) {
+    auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+    x = _mm256_andnot_si256(y, x);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(a + i), x);
+    result += popcount4(x);
+  }
+  for (; i < n; ++i) {
+    a[i] &= ~b[i];
+    result += _mm_popcnt_u64(a[i]);
+  }
+  return result;
+}
+
+__attribute__((target("avx2,popcnt")))
+inline unsigned unitePopcount(BitWord * a, const BitWord * b, const unsigned n) {
+  unsigned result = 0;
+  unsigned i = 0;
+  for (; i + 4 <= n; i += 4) {
+    auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+    x = _mm256_or_si256(x, y);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(a + i), x);
+    result += popcount4(x);
+  }
+  for (; i < n; ++i) {
+    a[i] |= b[i];
+    result += _mm_popcnt_u64(a[i]);
+  }
+  return result;
+}
+
+}
+
+namespace avx512 {
+
+// Words past n are masked off, so any n is one pass of 8 word vectors
+
+// Sum of the 8 lanes. GCC's _mm512_reduce_add_epi64 (and the unmasked extracts, which start from
+// _mm256_undefined_si256) trip -Wuninitialized once inlined, so the halves are extracted zero masked.
+__attribute__((target("avx512f")))
+inline unsigned reduceAdd(const __m512i v) {
+  auto x = _mm256_add_epi64(_mm512_maskz_extracti64x4_epi64(0xff, v, 0), _mm512_maskz_extracti64x4_epi64(0xff, v, 1));
+  auto y = _mm_add_epi64(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+  return _mm_cvtsi128_si64(y) + _mm_extract_epi64(y, 1);
+}
+__attribute__((target("avx512f")))
+inline void intersect(BitWord * a, const BitWord * b, const unsigned n) {
+  for (unsigned i = 0; i < n; i += 8) {
+    __mmask8 m = n - i >= 8 ? 0xff : (1u << (n - i)) - 1;
+    auto x = _mm512_maskz_loadu_epi64(m, a + i);
+    auto y = _mm512_maskz_loadu_epi64(m, b + i);
+    _mm512_mask_storeu_epi64(a + i, m, _mm512_and_si512(x, y));
+  }
+}
+
+__attribute__((target("avx512f")))
+inline void intersectComplement(BitWord * a, const BitWord * b, const unsigned n) {
+  for (unsigned i = 0; i < n; i += 8) {
+    __mmask8 m = n - i >= 8 ? 0xff : (1u << (n - i)) - 1;
+    auto x = _mm512_maskz_loadu_epi64(m, a + i);
+    auto y = _mm512_maskz_loadu_epi64(m, b + i);
+    _mm512_mask_storeu_epi64(a + i, m, _mm512_andnot_si512(y, x));
+  }
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+inline unsigned popcount(const BitWord * a, const unsigned n) {
+  auto sum = _mm512_setzero_si512();
+  for (unsigned i = 0; i < n; i += 8) {
+    __mmask8 m = n - i >= 8 ? 0xff : (1u << (n - i)) - 1;
+    sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(_mm512_maskz_loadu_epi64(m, a + i)));
+  }
+  return reduceAdd(sum);
+}
+
+__attribute__((target("avx512f,bmi")))
+inline int firstSetBit(const BitWord * a, const unsigned n) {
+  for (unsigned i = 0; i < n; i += 8) {
+    __mmask8 m = n - i >= 8 ? 0xff : (1u << (n - i)) - 1;
+    auto x = _mm512_maskz_loadu_epi64(m, a + i);
+    unsigned nonZero = _mm512_test_epi64_mask(x, x);
+    if (nonZero) {
+      auto w = i + __builtin_ctz(nonZero);
+      return w * bits_per_word + _tzcnt_u64(a[w]);
+    }
+  }
+  return -1;
+}
+
+__attribute__((target("avx512f")))
+inline void unite(BitWord * a, const BitWord * b, const unsigned n) {
+  for (unsigned i = 0; i < n; i += 8) {
+    __mmask8 m = n - i >= 8 ? 0xff : (1u << (n - i)) - 1;
+    auto x = _mm512_maskz_loadu_epi64(m, a + i);
+    auto y = _mm512_maskz_loadu_epi64(m, b + i);
+    _mm512_mask_storeu_epi64(a + i, m, _mm512_or_si512(x, y));
+  }
+}
+
+// The fused kernels need the vector popcount, AVX512 without it uses the AVX2 ones
+__attribute__((target("avx512f,avx512vpopcntdq")))
+inline unsigned intersectAllPopcount(BitWord * a, const BitWord * const * rows, const unsigned k, const unsigned n) {
+  auto sum = _mm512_setzero_si512();
+  for (unsigned i = 0; i < n; i += 8) {
+    __mmask8 m = n - i >= 8 ? 0xff : (1u << (n - i)) - 1;
+    auto x = _mm512_maskz_loadu_epi64(m, a + i);
+    for (unsigned r = 0; r < k; ++r) {
+      x = _mm512_and_si512(x, _mm512_maskz_loadu_epi64(m, rows[r] + i));
+    }
+    _mm512_mask_storeu_epi64(a + i, m, x);
+    sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(x));
+  }
+  return reduceAdd(sum);
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+inline unsigned intersectComplementPopcount(BitWord * a, const BitWord * b, const unsigned n) {
+  auto sum = _mm512_setzero_si512();
+  for (unsigned i = 0; i < n; i += 8) {
+    __mmask8 m = n - i >= 8 ? 0xff : (1u << (n - i)) - 1;
+    auto x = _mm512_maskz_loadu_epi64(m, a + i);
+    auto y = _mm512_maskz_loadu_epi64(m, b + i);
+    x = _mm512_maskz_andnot_epi64(m, y, x);
+    _mm512_mask_storeu_epi64(a + i, m, x);
+    sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(x));
+  }
+  return reduceAdd(sum);
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+inline unsigned unitePopcount(BitWord * a, const BitWord * b, const unsigned n) {
+  auto sum = _mm512_setzero_si512();
+  for (unsigned i = 0; i < n; i += 8) {
+    __mmask8 m = n - i >= 8 ? 0xff : (1u << (n - i)) - 1;
+    auto x = _mm512_or_si512(_mm512_maskz_loadu_epi64(m, a + i), _mm512_maskz_loadu_epi64(m, b + i));
+    _mm512_mask_storeu_epi64(a + i, m, x);
+    sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(x));
+  }
+  return reduceAdd(sum);
+}
+
+}
+
+#endif
+
+inline void intersect(BitWord * a, const BitWord * b, const unsigned n) {
+#ifdef YEWPAR_BITSET_X86
+  auto l = level();
+  if (l >= Level::AVX512) { return avx512::intersect(a, b, n); }
+  if (l == Level::AVX2) { return avx2::intersect(a, b, n); }
+#endif
+  scalar::intersect(a, b, n);
+}
+
+inline void intersectComplement(BitWord * a, const BitWord * b, const unsigned n) {
+#ifdef YEWPAR_BITSET_X86
+  auto l = level();
+  if (l >= Level::AVX512) { return avx512::intersectComplement(a, b, n); }
+  if (l == Level::AVX2) { return avx2::intersectComplement(a, b, n); }
+#endif
+  scalar::intersectComplement(a, b, n);
+}
+
+inline unsigned popcount(const BitWord * a, const unsigned n) {
+#ifdef YEWPAR_BITSET_X86
+  auto l = level();
+  if (l == Level::AVX512Popcnt) { return avx512::popcount(a, n); }
+  if (l != Level::Scalar) { return avx2::popcount(a, n); }
+#endif
+  return scalar::popcount(a, n);
+}
+
+inline int firstSetBit(const BitWord * a, const unsigned n) {
+#ifdef YEWPAR_BITSET_X86
+  auto l = level();
+  if (l >= Level::AVX512) { return avx512::firstSetBit(a, n); }
+  if (l == Level::AVX2) { return avx2::firstSetBit(a, n); }
+#endif
+  return scalar::firstSetBit(a, n);
+}
+
+inline void unite(BitWord * a, const BitWord * b, const unsigned n) {
+#ifdef YEWPAR_BITSET_X86
+  auto l = level();
+  if (l >= Level::AVX512) { return avx512::unite(a, b, n); }
+  if (l == Level::AVX2) { return avx2::unite(a, b, n); }
+#endif
+  scalar::unite(a, b, n);
+}
+
+// a &= each of the k rows, returning a's popcount, in one pass over a
+inline unsigned intersectAllPopcount(BitWord * a, const BitWord * const * rows, const unsigned k, const unsigned n) {
+#ifdef YEWPAR_BITSET_X86
+  auto l = level();
+  if (l == Level::AVX512Popcnt) { return avx512::intersectAllPopcount(a, rows, k, n); }
+  if (l != Level::Scalar) { return avx2::intersectAllPopcount(a, rows, k, n); }
+#endif
+  return scalar::intersectAllPopcount(a, rows, k, n);
+}
+
+// a &= ~b, returning a's popcount
+inline unsigned intersectComplementPopcount(BitWord * a, const BitWord * b, const unsigned n) {
+#ifdef YEWPAR_BITSET_X86
+  auto l = level();
+  if (l == Level::AVX512Popcnt) { return avx512::intersectComplementPopcount(a, b, n); }
+  if (l != Level::Scalar) { return avx2::intersectComplementPopcount(a, b, n); }
+#endif
+  return scalar::intersectComplementPopcount(a, b, n);
+}
+
+// a |= b, returning a's popcount
+inline unsigned unitePopcount(BitWord * a, const BitWord * b, const unsigned n) {
+#ifdef YEWPAR_BITSET_X86
+  auto l = level();
+  if (l == Level::AVX512Popcnt) { return avx512::unitePopcount(a, b, n); }
+  if (l != Level::Scalar) { return avx2::unitePopcount(a, b, n); }
+#endif
+  return scalar::unitePopcount(a, b, n);
+}
+
+}
+
+template <unsigned words_>
+class BitSet {
+private:
+  using Bits = std::array<BitWord, words_>;
+
+  int _size  = 0;
+  Bits _bits = {{ }};
+
+public:
+  auto resize(int size) -> void {
+    _size = size;
+  }
+
+  auto set(int a) -> void {
+    _bits[a / bits_per_word] |= (BitWord{ 1 } << (a % bits_per_word));
+  }
+
+  auto unset(int a) -> void {
+    _bits[a / bits_per_word] &= ~(BitWord{ 1 } << (a % bits_per_word));
+  }
+
+  auto set_all() -> void {
+    /* only done once, not worth making it clever */
+    for (int i = 0 ; i < _size ; ++i)
+      set(i);
+  }
+
+  auto test(int a) const -> bool {
+    return _bits[a / bits_per_word] & (BitWord{ 1 } << (a % bits_per_word));
+  }
+
+  auto popcount() const -> unsigned {
+    return BitSetKernels::popcount(_bits.data(), words_);
+  }
+
+  auto empty() const -> bool {
+    for (auto & p : _bits)
+      if (0 != p)
+        return false;
+    return true;
+  }
+
+  auto intersect_with(const BitSet<words_> & other) -> void {
+    BitSetKernels::intersect(_bits.data(), other._bits.data(), words_);
+  }
+
+  auto intersect_with_complement(const BitSet<words_> & other) -> void {
+    BitSetKernels::intersectComplement(_bits.data(), other._bits.data(), words_);
+  }
+
+  auto first_set_bit() const -> int {
+    return BitSetKernels::firstSetBit(_bits.data(), words_);
+  }
+
+  // The words themselves, e.g. for binary caches
+  auto data() -> BitWord * {
+    return _bits.data();
+  }
+
+  auto data() const -> const BitWord * {
+    return _bits.data();
+  }
+
+  template<class Archive>
+  void serialize(Archive & ar, const unsigned version) {
+    ar & _size;
+    ar & _bits;
+  }
+};
+
+}}
+
+// Just a size and a fixed array of words, steals copy it in one go
+namespace hpx { namespace traits {
+template <unsigned words_>
+struct is_bitwise_serializable<YewPar::util::BitSet<words_> >
+    : YewPar::BitwiseSerializable<YewPar::util::BitSet<words_> > {};
+}}
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef YEWPAR_BITWISE_SERIALIZABLE_HPP
+#define YEWPAR_BITWISE_SERIALIZABLE_HPP
+
+#include <bitset>
+#include <cstddef>
+#include <type_traits>
+
+#include <hpx/traits/is_bitwise_serializable.hpp>
+
+// Serialising nodes as raw bytes.
+//
+// HPX archives normally walk a type member by member. Types marked bitwise serialisable are
+// instead copied with a single memcpy (straight into the parcel, no per member calls), which is
+// what we want for the flat, fixed size nodes most searches use. Their serialize functions are then
+// only used by archives that can't take raw bytes (e.g. across differing endianness), so keep them.
+//
+// For a plain type use YEWPAR_BITWISE_SERIALIZABLE(Node) at global scope. For class templates,
+// specialise the trait through YewPar::BitwiseSerializable, which checks the type is safe to copy:
+//
+//   namespace hpx { namespace traits {
+//   template <unsigned N>
+//   struct is_bitwise_serializable<MyNode<N> > : YewPar::BitwiseSerializable<MyNode<N> > {};
+//   }}
+namespace YewPar {
+
+template <typename T>
+struct BitwiseSerializable : std::true_type {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Only trivially copyable types can be serialised bitwise");
+};
+
+}
+
+#define YEWPAR_BITWISE_SERIALIZABLE(T)                                  \
+  namespace hpx { namespace traits {                                    \
+  template <>                                                           \
+  struct is_bitwise_serializable<T> : YewPar::BitwiseSerializable<T> {}; \
+  }}                                                                    \
+/**/
+
+// std::bitset is a fixed array of words, as used in many nodes
+namespace hpx { namespace traits {
+template <std::size_t N>
+struct is_bitwise_serializable<std::bitset<N> > : YewPar::BitwiseSerializable<std::bitset<N> > {};
+}}
+
+#endif
@@ -0,0 +1,215 @@
+#ifndef YEWPAR_BOUNDPROPAGATION_HPP
+#define YEWPAR_BOUNDPROPAGATION_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <hpx/apply.hpp>
+#include <hpx/lcos/async.hpp>
+#include <hpx/lcos/future.hpp>
+#include <hpx/lcos/wait_all.hpp>
+#include <hpx/runtime/actions/basic_action.hpp>
+#include <hpx/runtime/get_locality_id.hpp>
+#include <hpx/runtime/threads/thread_helpers.hpp>
+#include <hpx/traits/action_stacksize.hpp>
+#include <hpx/util/tuple.hpp>
+#include <hpx/include/iostreams.hpp>
+
+#include <boost/format.hpp>
+
+#include "Registry.hpp"
+#include "Incumbent.hpp"
+#include "Log.hpp"
+#include "util.hpp"
+
+// Non-blocking propagation of new incumbents.
+//
+// A search thread that finds a better solution updates the local bound straight away and hands
+// the node to this service, then carries on searching. Improvements found on a locality within
+// coalesceWindow of each other are merged so only the best is sent. A flush sends the bound down
+// a binary tree of localities rooted at the sender, where a locality stops forwarding if the
+// bound is no better than what it already has. The node itself goes to the global incumbent
+// asynchronously. Skeletons call drainIncumbentUpdates on every locality before reading the final
+// incumbent.
+//
+// With LazyIncumbent nodes never leave the locality that found them: only the bound is flushed
+// (to the other localities, and to the global incumbent for its IncumbentTimeline) and at the end
+// of the search the locality holding the best bound is asked for its node.
+namespace YewPar { namespace BoundPropagation {
+
+constexpr auto coalesceWindow = std::chrono::milliseconds(1);
+
+template <typename Space, typename Node, typename Bound, typename Enumerator, typename Cmp>
+void propagateBound(Bound bnd, std::uint32_t root, std::uint64_t searchId);
+
+template <typename Space, typename Node, typename Bound, typename Enumerator, typename Cmp>
+struct PropagateBoundAct : hpx::actions::make_direct_action<
+  decltype(&propagateBound<Space, Node, Bound, Enumerator, Cmp>), &propagateBound<Space, Node, Bound, Enumerator, Cmp>, PropagateBoundAct<Space, Node, Bound, Enumerator, Cmp> >::type {};
+
+template <typename Space, typename Node, typename Bound, typename Enumerator, typename Cmp>
+void forwardBound(Bound bnd, std::uint32_t root, std::uint64_t searchId) {
+  for (auto const & child : util::treeChildren(root)) {
+    hpx::apply<PropagateBoundAct<Space, Node, Bound, Enumerator, Cmp> >(child, bnd, root, searchId);
+  }
+}
+
+template <typename Space, typename Node, typename Bound, typename Enumerator, typename Cmp>
+void propagateBound(Bound bnd, std::uint32_t root, std::uint64_t searchId) {
+  auto reg = Registry<Space, Node, Bound, Enumerator>::gReg;
+
+  // Left over from a previous search
+  if (searchId != reg->searchId) {
+    return;
+  }
+
+  // Anything we already beat has been (or is being) sent everywhere by someone else
+  if ((*reg).template updateRegistryBound<Cmp>(bnd)) {
+    forwardBound<Space, Node, Bound, Enumerator, Cmp>(bnd, root, searchId);
+  }
+}
+
+// Send the pending incumbent (if any)
+template <typename Space, typename Node, typename Bound, typename Enumerator, typename Cmp, typename Verbose, bool lazy>
+void flush() {
+  auto reg = Registry<Space, Node, Bound, Enumerator>::gReg;
+
+  std::unique_lock<hpx::lcos::local::mutex> lock(reg->incumbentMtx);
+  reg->incumbentFlushScheduled = false;
+  if (!reg->hasPendingIncumbent) {
+    return;
+  }
+
+  auto node = reg->pendingIncumbent;
+  reg->hasPendingIncumbent = false;
+  reg->lastIncumbentFlush = std::chrono::steady_clock::now();
+
+  auto & updates = reg->incumbentUpdates;
+  updates.erase(std::remove_if(updates.begin(), updates.end(),
+                               [](const hpx::future<void> & f) { return f.is_ready(); }),
+                updates.end());
+
+  // The global incumbent hears of every flushed improvement, if only the bound, for its timeline
+  if constexpr(lazy) {
+    typedef typename Incumbent::UpdateBoundAct<Node, Bound, Cmp, Verbose> act;
+    updates.push_back(hpx::async<act>(reg->globalIncumbent, node.getObj(), hpx::get_locality_id()));
+  } else {
+    typedef typename Incumbent::UpdateIncumbentAct<Node, Bound, Cmp, Verbose> act;
+    updates.push_back(hpx::async<act>(reg->globalIncumbent, node, hpx::get_locality_id()));
+  }
+  lock.unlock();
+
+  forwardBound<Space, Node, Bound, Enumerator, Cmp>(node.getObj(), hpx::get_locality_id(), reg->searchId);
+}
+
+// Called by a search thread on finding a new incumbent. Never blocks on communication.
+template <typename Space, typename Node, typename Bound, typename Enumerator, typename Cmp, typename Verbose, bool lazy>
+void submit(const Node & node) {
+  auto reg = Registry<Space, Node, Bound, Enumerator>::gReg;
+
+  std::unique_lock<hpx::lcos::local::mutex> lock(reg->incumbentMtx);
+  Cmp cmp;
+  if (reg->hasPendingIncumbent && !cmp(node.getObj(), reg->pendingIncumbent.getObj())) {
+    return;
+  }
+  reg->pendingIncumbent = node;
+  reg->hasPendingIncumbent = true;
+
+  auto newLocalIncumbent = false;
+  if constexpr(lazy) {
+    if (!reg->hasLocalIncumbent || cmp(node.getObj(), reg->localIncumbent.getObj())) {
+      reg->localIncumbent = node;
+      reg->hasLocalIncumbent = true;
+      newLocalIncumbent = true;
+    }
+  }
+
+  auto scheduleFlush = !reg->incumbentFlushScheduled;
+  reg->incumbentFlushScheduled = true;
+  // Send straight away unless we sent something very recently
+  auto wait = reg->lastIncumbentFlush + coalesceWindow - std::chrono::steady_clock::now();
+  lock.unlock();
+
+  if constexpr(lazy && Verbose::value >= 1) {
+    if (newLocalIncumbent) {
+      util::Log::write((boost::format("New Incumbent Bound: %1% (locality %2%)\n")
+                        % node.getObj() % hpx::get_locality_id()).str());
+    }
+  }
+
+  if (!scheduleFlush) {
+    return;
+  }
+  hpx::apply([wait]() {
+      if (wait > std::chrono::steady_clock::duration::zero()) {
+        hpx::this_thread::sleep_for(wait);
+      }
+      flush<Space, Node, Bound, Enumerator, Cmp, Verbose, lazy>();
+    });
+}
+
+// Flush anything pending and wait until all our incumbent updates have arrived
+template <typename Space, typename Node, typename Bound, typename Enumerator, typename Cmp, typename Verbose, bool lazy = false>
+void drainIncumbentUpdates() {
+  auto reg = Registry<Space, Node, Bound, Enumerator>::gReg;
+
+  flush<Space, Node, Bound, Enumerator, Cmp, Verbose, lazy>();
+
+  std::vector<hpx::future<void> > updates;
+  {
+    std::lock_guard<hpx::lcos::local::mutex> l(reg->incumbentMtx);
+    updates = std::move(reg->incumbentUpdates);
+    reg->incumbentUpdates.clear();
+  }
+  hpx::wait_all(updates);
+}
+template <typename Space, typename Node, typename Bound, typename Enumerator, typename Cmp, typename Verbose, bool lazy = false>
+struct DrainIncumbentUpdatesAct : hpx::actions::make_action<
+  decltype(&drainIncumbentUpdates<Space, Node, Bound, Enumerator, Cmp, Verbose, lazy>), &drainIncumbentUpdates<Space, Node, Bound, Enumerator, Cmp, Verbose, lazy>, DrainIncumbentUpdatesAct<Space, Node, Bound, Enumerator, Cmp, Verbose, lazy> >::type {};
+
+// LazyIncumbent: the best bound found on this locality, if it found anything
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+hpx::util::tuple<bool, Bound> getLocalIncumbentBound() {
+  auto reg = Registry<Space, Node, Bound, Enumerator>::gReg;
+  std::lock_guard<hpx::lcos::local::mutex> l(reg->incumbentMtx);
+  if (!reg->hasLocalIncumbent) {
+    return hpx::util::make_tuple(false, Bound());
+  }
+  return hpx::util::make_tuple(true, reg->localIncumbent.getObj());
+}
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+struct GetLocalIncumbentBoundAct : hpx::actions::make_direct_action<
+  decltype(&getLocalIncumbentBound<Space, Node, Bound, Enumerator>), &getLocalIncumbentBound<Space, Node, Bound, Enumerator>, GetLocalIncumbentBoundAct<Space, Node, Bound, Enumerator> >::type {};
+
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+Node getLocalIncumbent() {
+  auto reg = Registry<Space, Node, Bound, Enumerator>::gReg;
+  std::lock_guard<hpx::lcos::local::mutex> l(reg->incumbentMtx);
+  return reg->localIncumbent;
+}
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+struct GetLocalIncumbentAct : hpx::actions::make_action<
+  decltype(&getLocalIncumbent<Space, Node, Bound, Enumerator>), &getLocalIncumbent<Space, Node, Bound, Enumerator>, GetLocalIncumbentAct<Space, Node, Bound, Enumerator> >::type {};
+
+}}
+
+namespace hpx { namespace traits {
+template <typename Space, typename Node, typename Bound, typename Enumerator, typename Cmp>
+struct action_stacksize<YewPar::BoundPropagation::PropagateBoundAct<Space, Node, Bound, Enumerator, Cmp> > {
+  enum { value = threads::thread_stacksize_huge };
+};
+
+template <typename Space, typename Node, typename Bound, typename Enumerator, typename Cmp, typename Verbose, bool lazy>
+struct action_stacksize<YewPar::BoundPropagation::DrainIncumbentUpdatesAct<Space, Node, Bound, Enumerator, Cmp, Verbose, lazy> > {
+  enum { value = threads::thread_stacksize_huge };
+};
+
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+struct action_stacksize<YewPar::BoundPropagation::GetLocalIncumbentAct<Space, Node, Bound, Enumerator> > {
+  enum { value = threads::thread_stacksize_huge };
+};
+}}
+
+#endif
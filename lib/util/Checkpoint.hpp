@@ -0,0 +1,114 @@
+#ifndef YEWPAR_CHECKPOINT_HPP
+#define YEWPAR_CHECKPOINT_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <hpx/runtime/serialization/input_archive.hpp>
+#include <hpx/runtime/serialization/output_archive.hpp>
+#include <hpx/runtime/serialization/serialize.hpp>
+#include <hpx/runtime/serialization/string.hpp>
+#include <hpx/runtime/serialization/vector.hpp>
+
+// Checkpoints of a running search (Params::checkpointFile).
+//
+// A checkpoint pauses the search: every task stops at its next node and records the work it has
+// left as CheckpointTasks, one per live stack frame, and queued tasks record themselves when they
+// are next scheduled. Once all tasks have returned the outstanding work, the enumerator totals and
+// the incumbent are written to disk and the recorded tasks are spawned again. No node is searched
+// twice, so pausing only costs the time to drain the workers and write the file.
+//
+// The file doesn't depend on the localities that wrote it, a search resuming from it
+// (Params::resumeFromCheckpoint) spreads the tasks over however many localities it has. The Space
+// isn't saved, the resuming search must be given the same one. A search writing checkpoints removes
+// the file when it completes; one that only resumes (e.g. from a partition) leaves it alone.
+namespace YewPar {
+
+// Search the children of node, from firstChild on. node itself has been processed already and
+// sits at depth childDepth (in the skeleton's depth numbering, the root is 1).
+template <typename Node>
+struct CheckpointTask {
+  Node node;
+  unsigned childDepth;
+  unsigned firstChild;
+
+  template <class Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & node;
+    ar & childDepth;
+    ar & firstChild;
+  }
+};
+
+template <typename Node, typename Bound, typename EnumRes>
+struct Checkpoint {
+  std::vector<CheckpointTask<Node> > tasks;
+
+  // Optimisation/Decision
+  Node incumbent;
+  Bound bound;
+
+  // Enumeration, the counts of every node searched before the checkpoint
+  EnumRes enumerated;
+
+  template <class Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & tasks;
+    ar & incumbent;
+    ar & bound;
+    ar & enumerated;
+  }
+};
+
+// Written to a temporary file first, so a failure while writing leaves the previous checkpoint
+template <typename Node, typename Bound, typename EnumRes>
+void writeCheckpoint(const std::string & file, const Checkpoint<Node, Bound, EnumRes> & cp) {
+  std::vector<char> buf;
+  {
+    hpx::serialization::output_archive ar(buf);
+    ar << cp;
+  }
+
+  auto tmp = file + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out.write(buf.data(), buf.size());
+    if (!out) {
+      throw std::runtime_error("Could not write checkpoint " + tmp);
+    }
+  }
+
+  if (std::rename(tmp.c_str(), file.c_str()) != 0) {
+    throw std::runtime_error("Could not replace checkpoint " + file);
+  }
+}
+
+// Once the search writing checkpoints has finished, so nothing resumes into a completed search. The
+// file may never have been written.
+inline void removeCheckpoint(const std::string & file) {
+  std::remove(file.c_str());
+  std::remove((file + ".tmp").c_str());
+}
+
+template <typename Node, typename Bound, typename EnumRes>
+Checkpoint<Node, Bound, EnumRes> readCheckpoint(const std::string & file) {
+  std::ifstream in(file, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("Could not open checkpoint " + file);
+  }
+  std::vector<char> buf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+  Checkpoint<Node, Bound, EnumRes> cp;
+  hpx::serialization::input_archive ar(buf, buf.size());
+  ar >> cp;
+  return cp;
+}
+
+}
+
+#endif
@@ -0,0 +1,159 @@
+#include "ClaimTable.hpp"
+
+#include <hpx/lcos/async.hpp>
+#include <hpx/lcos/local/mutex.hpp>
+#include <hpx/lcos/local/promise.hpp>
+#include <hpx/runtime/find_here.hpp>
+#include <hpx/runtime/naming/name.hpp>
+#include <hpx/include/threads.hpp>
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+namespace YewPar { namespace util { namespace ClaimTable {
+
+namespace {
+
+// Bitmap allocated in fixed size chunks on first use
+constexpr std::uint64_t wordsPerChunk = 1 << 12;
+constexpr std::uint64_t maxChunks = 1 << 14;
+
+class Bitmap {
+ public:
+  Bitmap() : chunks(new std::atomic<std::atomic<std::uint64_t> *>[maxChunks]) {
+    for (std::uint64_t i = 0; i < maxChunks; ++i) {
+      chunks[i].store(nullptr);
+    }
+  }
+
+  ~Bitmap() {
+    for (std::uint64_t i = 0; i < maxChunks; ++i) {
+      delete[] chunks[i].load();
+    }
+  }
+
+  std::atomic<std::uint64_t> & word(std::uint64_t id) {
+    auto w = id / 64;
+    auto & chunk = chunks[w / wordsPerChunk];
+    auto p = chunk.load(std::memory_order_acquire);
+    if (!p) {
+      auto fresh = new std::atomic<std::uint64_t>[wordsPerChunk];
+      for (std::uint64_t i = 0; i < wordsPerChunk; ++i) {
+        fresh[i].store(0, std::memory_order_relaxed);
+      }
+      if (chunk.compare_exchange_strong(p, fresh, std::memory_order_acq_rel)) {
+        p = fresh;
+      } else {
+        delete[] fresh;
+      }
+    }
+    return p[w % wordsPerChunk];
+  }
+
+ private:
+  std::unique_ptr<std::atomic<std::atomic<std::uint64_t> *>[]> chunks;
+};
+
+std::uint32_t owner = 0;
+std::unique_ptr<Bitmap> bits;
+
+// Remote claims made on this locality that haven't been sent to the owner yet
+struct Batch {
+  std::vector<std::uint64_t> ids;
+  hpx::lcos::local::promise<std::vector<std::uint8_t> > result;
+  hpx::shared_future<std::vector<std::uint8_t> > fut;
+
+  Batch() : fut(result.get_future()) {}
+};
+
+hpx::lcos::local::mutex batchMtx;
+std::shared_ptr<Batch> pending;
+
+// Tasks we already know have been claimed (by anyone), avoids asking the owner twice
+std::unique_ptr<Bitmap> knownClaimed;
+
+bool testAndSet(Bitmap * words, std::uint64_t id) {
+  auto mask = std::uint64_t(1) << (id % 64);
+  return !(words->word(id).fetch_or(mask) & mask);
+}
+
+bool test(Bitmap * words, std::uint64_t id) {
+  auto mask = std::uint64_t(1) << (id % 64);
+  return words->word(id).load(std::memory_order_relaxed) & mask;
+}
+
+bool claimRemote(std::uint64_t id) {
+  std::shared_ptr<Batch> batch;
+  std::size_t pos;
+  bool flusher = false;
+  {
+    std::lock_guard<hpx::lcos::local::mutex> l(batchMtx);
+    if (!pending) {
+      pending = std::make_shared<Batch>();
+      flusher = true;
+    }
+    batch = pending;
+    pos = batch->ids.size();
+    batch->ids.push_back(id);
+  }
+
+  if (flusher) {
+    // Give other claimers on this locality a chance to join the batch
+    hpx::this_thread::yield();
+    {
+      std::lock_guard<hpx::lcos::local::mutex> l(batchMtx);
+      pending.reset();
+    }
+    // Everyone in the batch waits on its result, so a failed claim has to reach them all
+    try {
+      auto res = hpx::async<claimBatch_act>(hpx::naming::get_id_from_locality_id(owner), batch->ids).get();
+      batch->result.set_value(std::move(res));
+    } catch (...) {
+      batch->result.set_exception(std::current_exception());
+    }
+  }
+
+  auto won = batch->fut.get()[pos] != 0;
+
+  // Either way it's taken now
+  testAndSet(knownClaimed.get(), id);
+  return won;
+}
+
+}
+
+void reset(std::uint64_t n, std::uint32_t o) {
+  owner = o;
+  bits.reset(new Bitmap);
+  knownClaimed.reset(new Bitmap);
+
+  // Allocate what we know we'll need up front
+  for (std::uint64_t id = 0; id < n; id += 64 * wordsPerChunk) {
+    bits->word(id);
+    knownClaimed->word(id);
+  }
+}
+
+bool claim(std::uint64_t id) {
+  if (hpx::get_locality_id() == owner) {
+    return testAndSet(bits.get(), id);
+  }
+
+  if (test(knownClaimed.get(), id)) {
+    return false;
+  }
+  return claimRemote(id);
+}
+
+std::vector<std::uint8_t> claimBatch(std::vector<std::uint64_t> ids) {
+  std::vector<std::uint8_t> res;
+  res.reserve(ids.size());
+  for (auto id : ids) {
+    res.push_back(testAndSet(bits.get(), id) ? 1 : 0);
+  }
+  return res;
+}
+
+}}}
@@ -0,0 +1,31 @@
+#ifndef YEWPAR_CLAIM_TABLE_HPP
+#define YEWPAR_CLAIM_TABLE_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <hpx/runtime/actions/plain_action.hpp>
+#include <hpx/runtime/serialization/vector.hpp>
+
+// A set-once flag per task, replacing one DistSetOnceFlag component per task. The claim bits live
+// in an atomic bitmap on the locality that created the tasks (the owner). Claims made there are a
+// single fetch_or; claims from other localities are coalesced, so all threads claiming at about
+// the same time share one round trip to the owner.
+namespace YewPar { namespace util { namespace ClaimTable {
+
+// Prepare the table for tasks owned by the given locality. Must be run everywhere before any task
+// is claimed. numTasks is only a hint for preallocation: the table grows as larger ids are used,
+// so tasks can be claimed while more are still being created.
+void reset(std::uint64_t numTasks, std::uint32_t owner);
+HPX_DEFINE_PLAIN_ACTION(reset, reset_act);
+
+// Returns true for exactly one caller (over all localities) per task id
+bool claim(std::uint64_t id);
+
+// Owner side of a batch of remote claims, result[i] != 0 if ids[i] was claimed by this batch
+std::vector<std::uint8_t> claimBatch(std::vector<std::uint64_t> ids);
+HPX_DEFINE_PLAIN_ACTION(claimBatch, claimBatch_act);
+
+}}}
+
+#endif
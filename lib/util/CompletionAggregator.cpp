@@ -0,0 +1,126 @@
+#include "CompletionAggregator.hpp"
+
+#include <hpx/apply.hpp>
+#include <hpx/lcos/base_lco_with_value.hpp>
+#include <hpx/lcos/local/mutex.hpp>
+#include <hpx/performance_counters/manage_counter_type.hpp>
+#include <hpx/runtime/get_locality_id.hpp>
+#include <hpx/runtime/naming/unmanaged.hpp>
+#include <hpx/runtime/threads/thread_helpers.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+namespace YewPar { namespace util { namespace CompletionAggregator {
+
+namespace {
+
+// Bounds how long a completion is held back. Deep task trees pay it once per remote hop on the
+// way back to the root, so keep it well below the cost of a task.
+constexpr auto flushWindow = std::chrono::microseconds(200);
+
+constexpr std::size_t maxBatch = 256;
+
+struct Batch {
+  std::vector<hpx::naming::id_type> promises;
+  bool flushScheduled = false;
+};
+
+// Keyed by destination locality id
+hpx::lcos::local::mutex batchesMtx;
+std::unordered_map<std::uint32_t, Batch> batches;
+
+std::atomic<std::uint64_t> remoteCompletions(0);
+std::atomic<std::uint64_t> messagesSent(0);
+
+void setPromise(const hpx::naming::id_type & promise) {
+  hpx::apply<hpx::lcos::base_lco_with_value<void>::set_value_action>(promise, true);
+}
+
+void send(const std::uint32_t dest, std::vector<hpx::naming::id_type> promises) {
+  if (promises.empty()) {
+    return;
+  }
+  messagesSent.fetch_add(1, std::memory_order_relaxed);
+  hpx::apply<completeAll_act>(hpx::naming::get_id_from_locality_id(dest), std::move(promises));
+}
+
+void flushDest(const std::uint32_t dest) {
+  std::vector<hpx::naming::id_type> promises;
+  {
+    std::lock_guard<hpx::lcos::local::mutex> l(batchesMtx);
+    auto & b = batches[dest];
+    b.flushScheduled = false;
+    promises.swap(b.promises);
+  }
+  send(dest, std::move(promises));
+}
+
+std::uint64_t getRemoteCompletions(bool reset) {
+  return reset ? remoteCompletions.exchange(0) : remoteCompletions.load();
+}
+
+std::uint64_t getMessagesSent(bool reset) {
+  return reset ? messagesSent.exchange(0) : messagesSent.load();
+}
+
+}
+
+void complete(const hpx::naming::id_type & promise) {
+  auto dest = hpx::naming::get_locality_id_from_id(promise);
+  if (dest == hpx::get_locality_id()) {
+    setPromise(promise);
+    return;
+  }
+
+  remoteCompletions.fetch_add(1, std::memory_order_relaxed);
+
+  std::vector<hpx::naming::id_type> full;
+  bool scheduleFlush = false;
+  {
+    std::lock_guard<hpx::lcos::local::mutex> l(batchesMtx);
+    auto & b = batches[dest];
+    b.promises.push_back(promise);
+    if (b.promises.size() >= maxBatch) {
+      full.swap(b.promises);
+    } else if (!b.flushScheduled) {
+      b.flushScheduled = scheduleFlush = true;
+    }
+  }
+
+  if (!full.empty()) {
+    send(dest, std::move(full));
+  }
+
+  if (scheduleFlush) {
+    hpx::apply([dest]() {
+        hpx::this_thread::sleep_for(flushWindow);
+        flushDest(dest);
+      });
+  }
+}
+
+void completeAll(std::vector<hpx::naming::id_type> promises) {
+  for (const auto & p : promises) {
+    setPromise(p);
+  }
+}
+
+void registerPerformanceCounters() {
+  hpx::performance_counters::install_counter_type(
+      "/skeletons/completions/remote",
+      &getRemoteCompletions,
+      "Returns the number of task completions sent to promises on other localities"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/skeletons/completions/messages",
+      &getMessagesSent,
+      "Returns the number of messages used to send task completions to other localities"
+                                                  );
+}
+
+}}}
@@ -0,0 +1,30 @@
+#ifndef YEWPAR_COMPLETION_AGGREGATOR_HPP
+#define YEWPAR_COMPLETION_AGGREGATOR_HPP
+
+#include <vector>
+
+#include <hpx/runtime/actions/plain_action.hpp>
+#include <hpx/runtime/naming/name.hpp>
+#include <hpx/runtime/serialization/vector.hpp>
+
+// Batched completion of task promises.
+//
+// Every finished task sets its parent's done promise, which often lives on another locality, so
+// fine grained searches send a tiny message per task. Instead completions for remote promises are
+// buffered per destination locality and sent as one message once maxBatch of them are waiting or
+// flushWindow after the first of them, whichever comes first. Completions for local promises are
+// set directly. With CountTermination there are no promises and none of this is used.
+namespace YewPar { namespace util { namespace CompletionAggregator {
+
+// Set the (void) promise, possibly some time later. Never blocks on communication.
+void complete(const hpx::naming::id_type & promise);
+
+// Sets all the promises, they live on the locality running it
+void completeAll(std::vector<hpx::naming::id_type> promises);
+HPX_DEFINE_PLAIN_ACTION(completeAll, completeAll_act);
+
+void registerPerformanceCounters();
+
+}}}
+
+#endif
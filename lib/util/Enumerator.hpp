@@ -1,7 +1,15 @@
 #ifndef UTIL_ENUMERATOR_HPP
 #define UTIL_ENUMERATOR_HPP
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <hpx/runtime/serialization/array.hpp>
 
 namespace YewPar {
 
@@ -32,6 +40,97 @@ struct CountNodesEnumerator : Enumerator<NodeType, std::uint64_t> {
     std::uint64_t get() override { return count; };
 };
 
+// Enumerators may also take the depth of the node (0 for the root) as a second argument:
+//
+//   void accumulate(const NodeType & n, unsigned depth);
+//
+// Skeletons pass it (through accumulateNode below) when the enumerator has that overload, so
+// per-depth counts don't need the depth stored in every node.
+template <typename Enum, typename Node, typename = void>
+struct hasDepthAccumulate : std::false_type {};
+
+template <typename Enum, typename Node>
+struct hasDepthAccumulate<Enum, Node, std::void_t<decltype(
+    std::declval<Enum &>().accumulate(std::declval<const Node &>(), 0u))> > : std::true_type {};
+
+// Enumerators may also provide
+//
+//   void accumulateChildren(Generator & gen);   or
+//   void accumulateChildren(Generator & gen, unsigned childDepth);
+//
+// accumulating every child of a freshly built generator as accumulate would,
+// without the children being built (e.g. a popcount of the candidate set).
+// Skeletons use it when the children are leaves: at the depth limit, or when
+// the generator's childrenAreLeaves() (see NodeGenerator.hpp) says so.
+template <typename Enum, typename Generator, typename = void>
+struct hasDepthAccumulateChildren : std::false_type {};
+
+template <typename Enum, typename Generator>
+struct hasDepthAccumulateChildren<Enum, Generator, std::void_t<decltype(
+    std::declval<Enum &>().accumulateChildren(std::declval<Generator &>(), 0u))> > : std::true_type {};
+
+template <typename Enum, typename Generator, typename = void>
+struct hasAccumulateChildren : hasDepthAccumulateChildren<Enum, Generator> {};
+
+template <typename Enum, typename Generator>
+struct hasAccumulateChildren<Enum, Generator, std::void_t<decltype(
+    std::declval<Enum &>().accumulateChildren(std::declval<Generator &>()))> > : std::true_type {};
+
+template <typename Enum, typename Node>
+void accumulateNode(Enum & acc, const Node & n, const unsigned depth) {
+  if constexpr(hasDepthAccumulate<Enum, Node>::value) {
+    acc.accumulate(n, depth);
+  } else {
+    acc.accumulate(n);
+  }
+}
+
+template <typename Enum, typename Generator>
+void accumulateChildrenOf(Enum & acc, Generator & gen, const unsigned childDepth) {
+  if constexpr(hasDepthAccumulateChildren<Enum, Generator>::value) {
+    acc.accumulateChildren(gen, childDepth);
+  } else {
+    acc.accumulateChildren(gen);
+  }
+}
+
+// Counts the nodes at each depth up to maxDepth, deeper nodes are counted at maxDepth. The counts
+// are a fixed size array, so accumulate is a single increment and, like every enumerator, it is
+// per task and combined into a per worker slot of the Registry without locking. combine adds
+// whole vectors of counts at a time. Any generator's children count in bulk (through numChildren)
+// when they are leaves.
+template <typename NodeType, unsigned maxDepth>
+struct DepthHistogramEnumerator {
+  // Rounded up to whole vectors for combine
+  static constexpr unsigned lanes = 4;
+  static constexpr unsigned buckets = (maxDepth + lanes) / lanes * lanes;
+
+  using ResT = std::array<std::uint64_t, buckets>;
+  alignas(32) ResT counts {};
+
+  void accumulate(const NodeType &, const unsigned depth) {
+    counts[std::min(depth, maxDepth)]++;
+  }
+
+  template <typename Generator>
+  void accumulateChildren(const Generator & gen, const unsigned childDepth) {
+    counts[std::min(childDepth, maxDepth)] += gen.numChildren;
+  }
+
+  void combine(const ResT & other) {
+    typedef std::uint64_t V __attribute__ ((vector_size (lanes * sizeof(std::uint64_t))));
+    for (auto i = 0u; i < buckets; i += lanes) {
+      V a, b;
+      std::memcpy(&a, &counts[i], sizeof(V));
+      std::memcpy(&b, &other[i], sizeof(V));
+      a += b;
+      std::memcpy(&counts[i], &a, sizeof(V));
+    }
+  }
+
+  ResT get() { return counts; }
+};
+
 } // Namespace YewPar
 
 #endif // UTIL_ENUMERATOR_HPP
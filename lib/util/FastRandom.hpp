@@ -0,0 +1,26 @@
+#ifndef YEWPAR_FAST_RANDOM_HPP
+#define YEWPAR_FAST_RANDOM_HPP
+
+#include <cstdint>
+#include <random>
+
+namespace YewPar { namespace util {
+
+// xorshift64* with one state per OS thread. Much cheaper than rand(), which takes a lock in glibc,
+// and safe to call from any number of workers at once. Not for anything needing good statistics.
+inline std::uint64_t threadRandom() {
+  static thread_local std::uint64_t state = []() {
+    std::random_device rd;
+    std::uint64_t s = (static_cast<std::uint64_t>(rd()) << 32) ^ rd();
+    return s == 0 ? 0x9E3779B97F4A7C15ULL : s;
+  }();
+
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return state * 0x2545F4914F6CDD1DULL;
+}
+
+}}
+
+#endif
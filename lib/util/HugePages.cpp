@@ -0,0 +1,142 @@
+#include "HugePages.hpp"
+
+#include <sys/mman.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "RuntimeOptions.hpp"
+
+namespace YewPar { namespace util { namespace HugePages {
+
+namespace {
+
+std::atomic<std::int64_t> explicitHeld(0);
+std::atomic<std::int64_t> transparentHeld(0);
+std::atomic<std::uint64_t> fallbackCount(0);
+
+// Regions we map ourselves are whole huge pages, starting with a tag recording how they were
+// mapped so deallocate knows what to account for
+enum Kind : std::uint32_t {Normal, Transparently, Explicitly};
+
+struct alignas(std::max_align_t) Tag {
+  Kind kind;
+};
+static_assert(sizeof(Tag) == headerBytes, "Tag must be exactly the advertised header");
+
+std::size_t mappedBytes(const std::size_t bytes) {
+  return (bytes + sizeof(Tag) + pageBytes - 1) / pageBytes * pageBytes;
+}
+
+void * mapExplicit(const std::size_t len) {
+#ifdef MAP_HUGETLB
+  auto p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (p != MAP_FAILED) {
+    return p;
+  }
+#endif
+  return nullptr;
+}
+
+// A 2 MB aligned mapping (so the kernel can use huge pages for all of it), advised for transparent
+// huge pages if the platform has them. kind says whether the advice was taken.
+void * mapAligned(const std::size_t len, Kind & kind) {
+  auto p = ::mmap(nullptr, len + pageBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) {
+    return nullptr;
+  }
+
+  auto start = reinterpret_cast<std::uintptr_t>(p);
+  auto aligned = (start + pageBytes - 1) / pageBytes * pageBytes;
+  if (aligned > start) {
+    ::munmap(p, aligned - start);
+  }
+  ::munmap(reinterpret_cast<void *>(aligned + len), start + pageBytes - aligned);
+
+  kind = Normal;
+#ifdef MADV_HUGEPAGE
+  if (::madvise(reinterpret_cast<void *>(aligned), len, MADV_HUGEPAGE) == 0) {
+    kind = Transparently;
+  }
+#endif
+  return reinterpret_cast<void *>(aligned);
+}
+
+std::atomic<std::int64_t> & heldFor(const Kind kind) {
+  return kind == Explicitly ? explicitHeld : transparentHeld;
+}
+
+}
+
+Mode mode() {
+  static const Mode m = []() {
+    const auto & s = RuntimeOptions::get().hugePages;
+    if (s == "explicit") {
+      return Explicit;
+    }
+    if (s == "transparent") {
+      return Transparent;
+    }
+    return Off;
+  }();
+  return m;
+}
+
+void * allocate(const std::size_t bytes) {
+  if (bytes < minBytes || mode() == Off) {
+    return ::operator new(bytes);
+  }
+
+  auto len = mappedBytes(bytes);
+  void * p = nullptr;
+  Kind kind = Explicitly;
+  if (mode() == Explicit) {
+    p = mapExplicit(len);
+  }
+  if (!p) {
+    p = mapAligned(len, kind);
+  }
+  if (!p) {
+    throw std::bad_alloc();
+  }
+
+  // Explicit regions going transparent once the pool runs out is expected, and shows in the bytes
+  if (kind == Normal) {
+    fallbackCount.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    heldFor(kind).fetch_add(len, std::memory_order_relaxed);
+  }
+
+  auto t = static_cast<Tag *>(p);
+  t->kind = kind;
+  return t + 1;
+}
+
+void deallocate(void * p, const std::size_t bytes) {
+  if (bytes < minBytes || mode() == Off) {
+    ::operator delete(p);
+    return;
+  }
+
+  auto t = static_cast<Tag *>(p) - 1;
+  auto len = mappedBytes(bytes);
+  if (t->kind != Normal) {
+    heldFor(t->kind).fetch_sub(len, std::memory_order_relaxed);
+  }
+  ::munmap(t, len);
+}
+
+std::int64_t explicitBytes() {
+  return explicitHeld.load(std::memory_order_relaxed);
+}
+
+std::int64_t transparentBytes() {
+  return transparentHeld.load(std::memory_order_relaxed);
+}
+
+std::uint64_t fallbacks(const bool reset) {
+  return reset ? fallbackCount.exchange(0) : fallbackCount.load();
+}
+
+}}}
@@ -0,0 +1,72 @@
+#ifndef YEWPAR_HUGE_PAGES_HPP
+#define YEWPAR_HUGE_PAGES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+// Optional 2 MB page backing for the search's big, long lived regions: GeneratorStack frames,
+// prioritised DepthPool heaps and the TaskPool slabs tasks (and the nodes bound into them) live in.
+// Deep stacks of large nodes otherwise spread over thousands of 4 KB pages and the search spends
+// a noticeable share of its time on TLB misses.
+//
+// Off unless asked for with --yewpar:huge-pages:
+//
+//   transparent  2 MB aligned anonymous mappings advised with MADV_HUGEPAGE, which the kernel backs
+//                with transparent huge pages when it can (THP "madvise" or "always" mode)
+//   explicit     MAP_HUGETLB mappings from the preallocated huge page pool (vm.nr_hugepages),
+//                falling back to transparent ones once the pool is exhausted
+//
+// Regions smaller than minBytes always come from the allocator, as do all regions where the
+// platform has neither kind of huge page. Regions that couldn't get huge pages still work, on
+// normal pages, and count as fallbacks. Bytes on (or advised for) huge pages and the fallbacks are
+// reported with the /yewpar/memory/* counters, see MemoryUsage.hpp.
+namespace YewPar { namespace util { namespace HugePages {
+
+enum Mode {Off, Transparent, Explicit};
+
+constexpr std::size_t pageBytes = std::size_t(2) << 20;
+constexpr std::size_t minBytes = std::size_t(1) << 20;
+
+// Huge page regions are rounded up to whole pages, including this much bookkeeping at their start
+constexpr std::size_t headerBytes = alignof(std::max_align_t);
+
+// This locality's mode, from --yewpar:huge-pages
+Mode mode();
+
+// Storage for bytes bytes, max_align_t aligned. Must be released with the same size.
+void * allocate(std::size_t bytes);
+void deallocate(void * p, std::size_t bytes);
+
+// Bytes currently mapped on explicit huge pages, advised for transparent ones, and regions that
+// asked for huge pages but had to make do with normal ones (since the last reset)
+std::int64_t explicitBytes();
+std::int64_t transparentBytes();
+std::uint64_t fallbacks(bool reset = false);
+
+// Standard allocator over allocate/deallocate, for containers that can grow large
+template <typename T>
+struct Allocator {
+  using value_type = T;
+
+  Allocator() = default;
+  template <typename U>
+  Allocator(const Allocator<U> &) {}
+
+  T * allocate(std::size_t n) {
+    return static_cast<T *>(HugePages::allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T * p, std::size_t n) {
+    HugePages::deallocate(p, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const Allocator<U> &) const { return true; }
+  template <typename U>
+  bool operator!=(const Allocator<U> &) const { return false; }
+};
+
+}}}
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef YEWPAR_INCUMBENT_HPP
 #define YEWPAR_INCUMBENT_HPP
 
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
 
@@ -9,6 +11,9 @@
 
 #include <boost/format.hpp>
 
+#include "IncumbentTimeline.hpp"
+#include "Log.hpp"
+
 namespace YewPar {
 
 struct Incumbent : public hpx::components::locking_hook<
@@ -45,26 +50,50 @@ struct Incumbent : public hpx::components::locking_hook<
     Node incumbentNode;
     Bound bnd;
 
+    std::chrono::steady_clock::time_point start;
+    IncumbentTimeline<Bound> timeline;
+
+    void record(Bound b, std::uint32_t from) {
+      std::chrono::duration<double> t = std::chrono::steady_clock::now() - start;
+      timeline.improvements.push_back({t.count(), b, from});
+    }
+
   public:
     void initialiseIncumbent(Node n, Bound b) {
       incumbentNode = n;
       bnd = b;
+      start = std::chrono::steady_clock::now();
+      timeline.improvements.clear();
     }
 
-    void updateIncumbent(Node incumbent) {
+    void updateIncumbent(Node incumbent, std::uint32_t from) {
       Cmp cmp;
       if (cmp(incumbent.getObj(), incumbentNode.getObj())) {
         incumbentNode = incumbent;
         bnd = incumbent.getObj();
+        record(bnd, from);
         if constexpr(verbose >= 1) {
-          hpx::cout << (boost::format("New Incumbent Bound: %1%\n") % incumbentNode.getObj()) << hpx::flush;
+          util::Log::write((boost::format("New Incumbent Bound: %1%\n") % incumbentNode.getObj()).str());
         }
       }
     }
 
+    // LazyIncumbent: only the bound is sent, the node stays where it was found
+    void updateBound(Bound b, std::uint32_t from) {
+      Cmp cmp;
+      if (cmp(b, bnd)) {
+        bnd = b;
+        record(bnd, from);
+      }
+    }
+
     Node getIncumbent() const {
       return incumbentNode;
     }
+
+    IncumbentTimeline<Bound> getTimeline() const {
+      return timeline;
+    }
   };
 
   template<typename Node, typename Bound, typename Cmp, typename Verbose>
@@ -75,10 +104,17 @@ struct Incumbent : public hpx::components::locking_hook<
   }
 
   template<typename Node, typename Bound, typename Cmp, typename Verbose>
-  void updateIncumbent(Node incumbent) {
+  void updateIncumbent(Node incumbent, std::uint32_t from) {
+    auto p = ptr.get();
+    auto cmp = static_cast<Incumbent::IncumbentComp<Node, Bound, Cmp, Verbose>*>(p);
+    cmp->updateIncumbent(incumbent, from);
+  }
+
+  template<typename Node, typename Bound, typename Cmp, typename Verbose>
+  void updateBound(Bound bnd, std::uint32_t from) {
     auto p = ptr.get();
     auto cmp = static_cast<Incumbent::IncumbentComp<Node, Bound, Cmp, Verbose>*>(p);
-    cmp->updateIncumbent(incumbent);
+    cmp->updateBound(bnd, from);
   }
 
   template<typename Node, typename Bound, typename Cmp, typename Verbose>
@@ -88,12 +124,25 @@ struct Incumbent : public hpx::components::locking_hook<
     return cmp->getIncumbent();
   }
 
+  template<typename Node, typename Bound, typename Cmp, typename Verbose>
+  IncumbentTimeline<Bound> getTimeline() const {
+    auto p = ptr.get();
+    auto cmp = static_cast<Incumbent::IncumbentComp<Node, Bound, Cmp, Verbose>*>(p);
+    return cmp->getTimeline();
+  }
+
   template<typename Node, typename Bound, typename Cmp, typename Verbose>
   struct UpdateIncumbentAct : hpx::actions::make_action<
     decltype(&Incumbent::updateIncumbent<Node, Bound, Cmp, Verbose>),
     &Incumbent::updateIncumbent<Node, Bound, Cmp, Verbose>,
     UpdateIncumbentAct<Node, Bound, Cmp, Verbose> >::type {};
 
+  template<typename Node, typename Bound, typename Cmp, typename Verbose>
+  struct UpdateBoundAct : hpx::actions::make_action<
+    decltype(&Incumbent::updateBound<Node, Bound, Cmp, Verbose>),
+    &Incumbent::updateBound<Node, Bound, Cmp, Verbose>,
+    UpdateBoundAct<Node, Bound, Cmp, Verbose> >::type {};
+
   template<typename Node, typename Bound, typename Cmp, typename Verbose>
   struct InitialiseIncumbentAct : hpx::actions::make_action<
     decltype(&Incumbent::initialiseIncumbent<Node, Bound, Cmp, Verbose>),
@@ -105,6 +154,12 @@ struct Incumbent : public hpx::components::locking_hook<
     decltype(&Incumbent::getIncumbent<Node, Bound, Cmp, Verbose>),
     &Incumbent::getIncumbent<Node, Bound, Cmp, Verbose>,
     GetIncumbentAct<Node, Bound, Cmp, Verbose> >::type {};
+
+  template<typename Node, typename Bound, typename Cmp, typename Verbose>
+  struct GetTimelineAct : hpx::actions::make_action<
+    decltype(&Incumbent::getTimeline<Node, Bound, Cmp, Verbose>),
+    &Incumbent::getTimeline<Node, Bound, Cmp, Verbose>,
+    GetTimelineAct<Node, Bound, Cmp, Verbose> >::type {};
 };
 
 }
@@ -0,0 +1,62 @@
+#ifndef YEWPAR_INCUMBENT_TIMELINE_HPP
+#define YEWPAR_INCUMBENT_TIMELINE_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <hpx/runtime/serialization/serialize.hpp>
+#include <hpx/runtime/serialization/vector.hpp>
+
+// When each improvement of the incumbent reached the global incumbent, for measuring how quickly
+// a B&B search finds good solutions rather than only how long it takes to finish.
+//
+// Times are taken by the incumbent component on its own clock, in seconds since the search
+// initialised it, so they include the (coalesced) trip from the locality that found the solution.
+namespace YewPar {
+
+template <typename Bound>
+struct IncumbentTimeline {
+  struct Improvement {
+    double seconds;
+    Bound bound;
+    std::uint32_t locality;
+
+    template <class Archive>
+    void serialize(Archive & ar, const unsigned int version) {
+      ar & seconds;
+      ar & bound;
+      ar & locality;
+    }
+  };
+
+  // In the order they arrived, each better than the last
+  std::vector<Improvement> improvements;
+
+  // Seconds to the first solution found, -1 if none was
+  double timeToFirstSolution() const {
+    return improvements.empty() ? -1 : improvements.front().seconds;
+  }
+
+  // Seconds to the final incumbent, i.e. time to optimum for a search that ran to completion. -1
+  // if nothing improved on the initial incumbent.
+  double timeToFinalIncumbent() const {
+    return improvements.empty() ? -1 : improvements.back().seconds;
+  }
+
+  template <class Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & improvements;
+  }
+};
+
+// Timeline of the last optimisation or decision search with bound type Bound, filled in once the
+// search returns
+template <typename Bound>
+IncumbentTimeline<Bound> & lastIncumbentTimeline() {
+  static IncumbentTimeline<Bound> timeline;
+  return timeline;
+}
+
+}
+
+#endif
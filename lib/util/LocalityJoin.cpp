@@ -0,0 +1,51 @@
+#include "LocalityJoin.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+
+#include <hpx/lcos/async.hpp>
+#include <hpx/runtime/find_all_localities.hpp>
+
+namespace YewPar { namespace util {
+
+LocalityWatcher::LocalityWatcher(const unsigned pollMillis, JoinFn join)
+    : join(std::move(join)), known(hpx::find_all_localities()) {
+  if (pollMillis == 0) {
+    poller = hpx::make_ready_future();
+    return;
+  }
+  poller = hpx::async([this, pollMillis]() { run(pollMillis); });
+}
+
+LocalityWatcher::~LocalityWatcher() {
+  stop();
+}
+
+void LocalityWatcher::stop() {
+  {
+    std::lock_guard<hpx::lcos::local::mutex> l(mtx);
+    stopping = true;
+  }
+  cv.notify_all();
+  if (poller.valid()) {
+    poller.get();
+  }
+}
+
+void LocalityWatcher::run(const unsigned pollMillis) {
+  std::unique_lock<hpx::lcos::local::mutex> l(mtx);
+  while (!cv.wait_for(l, std::chrono::milliseconds(pollMillis), [&]() { return stopping; })) {
+    // Joins happen under the lock so stop() waits for them rather than tearing the search down
+    // around a half set up locality
+    for (const auto & loc : hpx::find_all_localities()) {
+      if (std::find(known.begin(), known.end(), loc) == known.end()) {
+        join(loc);
+        known.push_back(loc);
+        ++numJoined;
+      }
+    }
+  }
+}
+
+}}
@@ -0,0 +1,58 @@
+#ifndef YEWPAR_LOCALITY_JOIN_HPP
+#define YEWPAR_LOCALITY_JOIN_HPP
+
+#include <vector>
+
+#include <hpx/lcos/future.hpp>
+#include <hpx/lcos/local/condition_variable.hpp>
+#include <hpx/lcos/local/mutex.hpp>
+#include <hpx/runtime/naming/id_type.hpp>
+#include <hpx/util/function.hpp>
+
+// Localities joining a running search (Params::joinPollMillis).
+//
+// HPX lets localities connect to a running application (--hpx:connect), e.g. when a cluster
+// scheduler hands out more nodes partway through a long enumeration, but the skeletons fix the
+// localities they use when the search starts. While a search runs its root locality polls for
+// localities it hasn't seen and hands each one to the skeleton, which brings it up to date
+// (registry, space and current bound, per-search resets), gives it a workpool in every victim list and
+// starts its schedulers. From then on it steals work like any other locality, and anything
+// gathered from all localities at the end of the search (enumerator results, incumbents) includes
+// it.
+//
+// Only DepthBounded and Budget take joins, with promise based termination (counting termination
+// waves assume a fixed set of localities).
+namespace YewPar { namespace util {
+
+class LocalityWatcher {
+ public:
+  using JoinFn = hpx::util::function<void(const hpx::naming::id_type &), false>;
+
+  // Poll every pollMillis (never if 0) until stopped, calling join on each new locality in turn
+  LocalityWatcher(unsigned pollMillis, JoinFn join);
+  ~LocalityWatcher();
+
+  LocalityWatcher(const LocalityWatcher &) = delete;
+  LocalityWatcher & operator=(const LocalityWatcher &) = delete;
+
+  // Returns once any join in progress has finished, no more are started after
+  void stop();
+
+  unsigned joined() const { return numJoined; }
+
+ private:
+  void run(unsigned pollMillis);
+
+  JoinFn join;
+  std::vector<hpx::naming::id_type> known;
+  unsigned numJoined = 0;
+
+  hpx::lcos::local::mutex mtx;
+  hpx::lcos::local::condition_variable cv;
+  bool stopping = false;
+  hpx::future<void> poller;
+};
+
+}}
+
+#endif
@@ -0,0 +1,126 @@
+#include "Log.hpp"
+
+#include <hpx/apply.hpp>
+#include <hpx/include/iostreams.hpp>
+#include <hpx/lcos/broadcast.hpp>
+#include <hpx/lcos/local/mutex.hpp>
+#include <hpx/lcos/wait_all.hpp>
+#include <hpx/runtime/find_all_localities.hpp>
+#include <hpx/runtime/get_locality_id.hpp>
+#include <hpx/runtime/shutdown_function.hpp>
+#include <hpx/runtime/threads/thread_helpers.hpp>
+
+#include <boost/format.hpp>
+
+#include "PerWorker.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace YewPar { namespace util { namespace Log {
+
+namespace {
+
+constexpr auto drainInterval = std::chrono::milliseconds(10);
+
+// Messages per worker between drains
+constexpr std::uint64_t capacity = 4096;
+
+// Single producer (the worker owning it), single consumer (whoever holds drainMtx). The last slot
+// is shared by threads outside the pool, they take sharedMtx to write to it.
+struct Ring {
+  std::unique_ptr<std::string[]> msgs {new std::string[capacity]};
+  std::atomic<std::uint64_t> head {0}; // next to read
+  std::atomic<std::uint64_t> tail {0}; // next to write
+  std::atomic<std::uint64_t> dropped {0};
+};
+
+PerWorker<Ring> rings;
+
+hpx::lcos::local::mutex sharedMtx;
+hpx::lcos::local::mutex drainMtx;
+std::atomic<bool> drainScheduled(false);
+
+void push(Ring & r, std::string msg) {
+  auto tail = r.tail.load(std::memory_order_relaxed);
+  if (tail - r.head.load(std::memory_order_acquire) >= capacity) {
+    r.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  r.msgs[tail % capacity] = std::move(msg);
+  r.tail.store(tail + 1, std::memory_order_release);
+}
+
+// Everything queued so far as one string, must hold drainMtx
+std::string collect() {
+  std::string out;
+  std::uint64_t dropped = 0;
+  rings.forEach([&](Ring & r) {
+      auto head = r.head.load(std::memory_order_relaxed);
+      auto tail = r.tail.load(std::memory_order_acquire);
+      for (; head != tail; ++head) {
+        out += r.msgs[head % capacity];
+        r.msgs[head % capacity].clear();
+      }
+      r.head.store(head, std::memory_order_release);
+      dropped += r.dropped.exchange(0);
+    });
+
+  if (dropped > 0) {
+    out += (boost::format("%1% Log: %2% messages dropped\n")
+            % static_cast<std::int64_t>(hpx::get_locality_id()) % dropped).str();
+  }
+  return out;
+}
+
+void drain() {
+  std::string out;
+  {
+    std::lock_guard<hpx::lcos::local::mutex> l(drainMtx);
+    out = collect();
+  }
+  if (!out.empty()) {
+    hpx::cout << out << hpx::flush;
+  }
+}
+
+void scheduleDrain() {
+  if (drainScheduled.exchange(true)) {
+    return;
+  }
+  hpx::apply([]() {
+      hpx::this_thread::sleep_for(drainInterval);
+      drainScheduled.store(false);
+      drain();
+    });
+}
+
+}
+
+void write(std::string msg) {
+  auto me = rings.myIndex();
+  if (!rings.isShared(me)) {
+    push(rings[me], std::move(msg));
+  } else {
+    std::lock_guard<hpx::lcos::local::mutex> l(sharedMtx);
+    push(rings[me], std::move(msg));
+  }
+  scheduleDrain();
+}
+
+void flush() {
+  drain();
+}
+
+void flushAll() {
+  hpx::wait_all(hpx::lcos::broadcast<flush_act>(hpx::find_all_localities()));
+}
+
+void registerShutdownFlush() {
+  hpx::register_pre_shutdown_function(&flush);
+}
+
+}}}
@@ -0,0 +1,33 @@
+#ifndef YEWPAR_LOG_HPP
+#define YEWPAR_LOG_HPP
+
+#include <string>
+
+#include <hpx/runtime/actions/plain_action.hpp>
+
+// Diagnostics printed from inside a search (Verbose levels).
+//
+// hpx::cout with hpx::flush is a synchronous round trip to the console locality, so printing from
+// a search thread stalls it. Instead each worker thread appends to its own lock-free ring buffer
+// and the buffers are drained by a background task, at most every drainInterval and as a single
+// write to the console. Messages can be up to one interval late and are interleaved by worker
+// rather than by time; a worker that fills its buffer before the next drain drops messages (and
+// the count of dropped ones is printed). Everything left is flushed at shutdown.
+namespace YewPar { namespace util { namespace Log {
+
+// Queue msg for the console, msg should include its own newline
+void write(std::string msg);
+
+// Write everything queued on this locality now
+void flush();
+HPX_DEFINE_PLAIN_ACTION(flush, flush_act);
+
+// flush on every locality
+void flushAll();
+
+// Flushes at shutdown
+void registerShutdownFlush();
+
+}}}
+
+#endif
@@ -0,0 +1,55 @@
+#include "MappedFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdexcept>
+
+namespace YewPar { namespace util {
+
+MappedFile::MappedFile(const std::string & file) {
+  auto fd = ::open(file.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Could not open " + file);
+  }
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error("Could not stat " + file);
+  }
+
+  bytes = st.st_size;
+  // mmap refuses empty mappings, an empty file is just an empty range
+  if (bytes > 0) {
+    auto p = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error("Could not map " + file);
+    }
+    // Parsers read front to back
+    ::madvise(p, bytes, MADV_SEQUENTIAL);
+    data = static_cast<const char *>(p);
+  }
+  ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data) {
+    ::munmap(const_cast<char *>(data), bytes);
+  }
+}
+
+bool fileStamp(const std::string & file, std::uint64_t & size, std::uint64_t & mtime) {
+  struct stat st;
+  if (::stat(file.c_str(), &st) != 0) {
+    return false;
+  }
+  size = st.st_size;
+  mtime = static_cast<std::uint64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+  return true;
+}
+
+}}
@@ -0,0 +1,36 @@
+#ifndef YEWPAR_MAPPED_FILE_HPP
+#define YEWPAR_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// A whole file mapped read only, for input parsers. Parsing straight out of the page cache avoids
+// the copies (and per line allocations) of reading through streams, which dominates loading large
+// instances. Throws std::runtime_error if the file can't be opened or mapped.
+namespace YewPar { namespace util {
+
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string & file);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile & operator=(const MappedFile &) = delete;
+
+  const char * begin() const { return data; }
+  const char * end() const { return data + bytes; }
+  std::size_t size() const { return bytes; }
+
+ private:
+  const char * data = nullptr;
+  std::size_t bytes = 0;
+};
+
+// Size and modification time (ns) of file, for telling whether something derived from it is stale.
+// False if there is no such file.
+bool fileStamp(const std::string & file, std::uint64_t & size, std::uint64_t & mtime);
+
+}}
+
+#endif
@@ -0,0 +1,162 @@
+#include "MemoTable.hpp"
+
+#include <hpx/include/iostreams.hpp>
+#include <hpx/performance_counters/manage_counter_type.hpp>
+#include <hpx/runtime/get_locality_id.hpp>
+
+#include <boost/format.hpp>
+
+#include "PerWorker.hpp"
+
+#include <atomic>
+#include <limits>
+#include <memory>
+
+namespace YewPar { namespace util { namespace MemoTable {
+
+namespace {
+
+// Slots tried per state before giving up on remembering it
+constexpr unsigned maxProbes = 16;
+
+constexpr std::uint64_t emptyKey = 0;
+constexpr std::int64_t unreached = std::numeric_limits<std::int64_t>::max();
+
+struct Entry {
+  std::atomic<std::uint64_t> key;
+  std::atomic<std::int64_t> cost;
+};
+
+std::unique_ptr<Entry[]> table;
+std::uint64_t mask = 0;
+
+// key 0 marks empty slots, so that state gets a slot of its own
+std::atomic<std::int64_t> zeroKeyCost(unreached);
+
+// Counted per worker thread, the table is hit for every node
+struct Counts {
+  std::atomic<std::uint64_t> hits {0};
+  std::atomic<std::uint64_t> misses {0};
+  std::atomic<std::uint64_t> dropped {0};
+};
+
+PerWorker<Counts> counts;
+
+// splitmix64 finaliser, keys are often small or structured
+std::uint64_t mix(std::uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+std::atomic<std::int64_t> * costFor(std::uint64_t key) {
+  if (key == emptyKey) {
+    return &zeroKeyCost;
+  }
+
+  auto h = mix(key);
+  for (unsigned p = 0; p < maxProbes; ++p) {
+    auto & e = table[(h + p) & mask];
+    auto k = e.key.load(std::memory_order_acquire);
+    if (k == emptyKey && e.key.compare_exchange_strong(k, key, std::memory_order_acq_rel)) {
+      return &e.cost;
+    }
+    // k now holds the slot's key, whether or not we just lost the race for it
+    if (k == key) {
+      return &e.cost;
+    }
+  }
+  return nullptr;
+}
+
+template <std::atomic<std::uint64_t> Counts::* field>
+std::uint64_t total(bool reset) {
+  std::uint64_t sum = 0;
+  counts.forEach([&](Counts & c) {
+      sum += reset ? (c.*field).exchange(0) : (c.*field).load();
+    });
+  return sum;
+}
+
+}
+
+void reset(std::uint64_t entries) {
+  std::uint64_t size = 1;
+  while (size < entries) {
+    size <<= 1;
+  }
+
+  if (!table || mask + 1 != size) {
+    table.reset(new Entry[size]);
+    mask = size - 1;
+  }
+  for (std::uint64_t i = 0; i < size; ++i) {
+    table[i].key.store(emptyKey, std::memory_order_relaxed);
+    table[i].cost.store(unreached, std::memory_order_relaxed);
+  }
+  zeroKeyCost.store(unreached);
+
+  counts.forEach([](Counts & c) {
+      c.hits.store(0);
+      c.misses.store(0);
+      c.dropped.store(0);
+    });
+}
+
+bool seen(std::uint64_t key, std::int64_t cost) {
+  auto & cnt = counts.mine();
+
+  auto c = costFor(key);
+  if (!c) {
+    cnt.dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  auto cur = c->load(std::memory_order_relaxed);
+  while (true) {
+    if (cur <= cost) {
+      cnt.hits.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    if (c->compare_exchange_weak(cur, cost, std::memory_order_relaxed)) {
+      cnt.misses.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+  }
+}
+
+void printReport() {
+  hpx::cout
+      << (boost::format("%1% Memo Table: %2% entries, %3% hits, %4% misses, %5% states not stored (table full)")
+          % static_cast<std::int64_t>(hpx::get_locality_id())
+          % (mask + 1)
+          % total<&Counts::hits>(false)
+          % total<&Counts::misses>(false)
+          % total<&Counts::dropped>(false))
+      << hpx::endl;
+}
+
+void registerPerformanceCounters() {
+  hpx::performance_counters::install_counter_type(
+      "/skeletons/memo/hits",
+      &total<&Counts::hits>,
+      "Returns the number of nodes pruned by the memo table on this locality"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/skeletons/memo/misses",
+      &total<&Counts::misses>,
+      "Returns the number of nodes recorded in the memo table on this locality"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/skeletons/memo/dropped",
+      &total<&Counts::dropped>,
+      "Returns the number of nodes whose state didn't fit in the memo table on this locality"
+                                                  );
+}
+
+}}}
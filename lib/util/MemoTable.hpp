@@ -0,0 +1,42 @@
+#ifndef YEWPAR_MEMO_TABLE_HPP
+#define YEWPAR_MEMO_TABLE_HPP
+
+#include <cstdint>
+
+#include <hpx/runtime/actions/plain_action.hpp>
+
+// Per locality transposition table for API::Memoize.
+//
+// A fixed size, open addressed hash table from search states to the best (lowest) partial cost
+// they have been reached with. Slots are claimed with a CAS on the key and never reused within a
+// search, and costs only ever go down, so readers never see a cost belonging to another state. Once
+// a state's probe window is full it is simply not remembered.
+namespace YewPar { namespace util { namespace MemoTable {
+
+// What API::Memoize's KeyFn returns for a node. key identifies the node's state (the subtrees of
+// two nodes with the same key must be the same). cost is the partial objective, lower is better;
+// with a constant cost only exact repeats are pruned, otherwise also states reached more cheaply
+// before (dominance).
+struct MemoKey {
+  std::uint64_t key;
+  std::int64_t cost = 0;
+};
+
+// Clear the table for a new search, (re)allocating it if needed. entries is rounded up to a power
+// of two. Must run on every locality.
+void reset(std::uint64_t entries);
+HPX_DEFINE_PLAIN_ACTION(reset, reset_act);
+
+// Returns true if the state was already reached with a cost at most cost, i.e. the node can be
+// pruned. Otherwise records cost for the state and returns false.
+bool seen(std::uint64_t key, std::int64_t cost);
+
+// Print the hit/miss counts of the last search on this locality
+void printReport();
+HPX_DEFINE_PLAIN_ACTION(printReport, printReport_act);
+
+void registerPerformanceCounters();
+
+}}}
+
+#endif
@@ -0,0 +1,223 @@
+#include "MemoryUsage.hpp"
+
+#include <hpx/include/iostreams.hpp>
+#include <hpx/performance_counters/manage_counter_type.hpp>
+#include <hpx/runtime/get_locality_id.hpp>
+
+#include <boost/format.hpp>
+
+#include <atomic>
+#include <cstdlib>
+
+#include "HugePages.hpp"
+#include "PerWorker.hpp"
+
+namespace YewPar { namespace util { namespace MemoryUsage {
+
+namespace {
+
+// Threads only add their changes to the shared total once they add up to this much, so the
+// total is off by at most this per thread
+constexpr std::int64_t flushBytes = 64 * 1024;
+
+// Per worker thread. Bytes can be released by another thread than the one that added them, only
+// the sum over slots is meaningful.
+struct Held {
+  std::atomic<std::int64_t> bytes[numKinds];
+  std::atomic<std::int64_t> unflushed {0};
+  std::atomic<std::uint64_t> inlined {0};
+
+  Held() {
+    for (auto & b : bytes) {
+      b.store(0, std::memory_order_relaxed);
+    }
+  }
+};
+
+PerWorker<Held> held_;
+
+std::atomic<std::int64_t> approxTotal(0);
+std::atomic<std::int64_t> highWater(0);
+
+std::int64_t cap = 0;
+std::atomic<bool> throttled(false);
+std::atomic<std::uint64_t> throttles(0);
+
+Held & myHeld() {
+  return held_.mine();
+}
+
+template <Kind kind>
+std::int64_t heldCounter(bool) {
+  return held(kind);
+}
+
+std::int64_t totalCounter(bool) {
+  return total();
+}
+
+std::int64_t highWaterCounter(bool reset) {
+  return reset ? highWater.exchange(approxTotal.load()) : highWater.load();
+}
+
+std::int64_t explicitHugeCounter(bool) {
+  return HugePages::explicitBytes();
+}
+
+std::int64_t transparentHugeCounter(bool) {
+  return HugePages::transparentBytes();
+}
+
+std::uint64_t hugeFallbacksCounter(bool reset) {
+  return HugePages::fallbacks(reset);
+}
+
+std::uint64_t inlinedSpawns(bool reset) {
+  std::uint64_t sum = 0;
+  held_.forEach([&](Held & h) {
+      sum += reset ? h.inlined.exchange(0) : h.inlined.load();
+    });
+  return sum;
+}
+
+}
+
+void add(Kind kind, std::int64_t bytes) {
+  auto & h = myHeld();
+  h.bytes[kind].fetch_add(bytes, std::memory_order_relaxed);
+
+  auto pending = h.unflushed.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  if (std::llabs(pending) < flushBytes) {
+    return;
+  }
+
+  pending = h.unflushed.exchange(0, std::memory_order_relaxed);
+  auto now = approxTotal.fetch_add(pending, std::memory_order_relaxed) + pending;
+  auto prev = highWater.load(std::memory_order_relaxed);
+  while (now > prev && !highWater.compare_exchange_weak(prev, now, std::memory_order_relaxed)) {}
+}
+
+std::int64_t held(Kind kind) {
+  std::int64_t sum = 0;
+  held_.forEach([&](Held & h) {
+      sum += h.bytes[kind].load(std::memory_order_relaxed);
+    });
+  return sum;
+}
+
+std::int64_t total() {
+  return approxTotal.load(std::memory_order_relaxed);
+}
+
+void reset(std::uint64_t capBytes) {
+  cap = capBytes;
+  throttled.store(false);
+  throttles.store(0);
+  highWater.store(approxTotal.load());
+  inlinedSpawns(true);
+}
+
+bool overCap() {
+  if (cap == 0) {
+    return false;
+  }
+
+  auto t = total();
+  auto th = throttled.load(std::memory_order_relaxed);
+  if (!th && t >= cap) {
+    if (!throttled.exchange(true)) {
+      throttles.fetch_add(1, std::memory_order_relaxed);
+    }
+    th = true;
+  } else if (th && t < cap - cap / 4) {
+    throttled.store(false, std::memory_order_relaxed);
+    th = false;
+  }
+
+  if (th) {
+    myHeld().inlined.fetch_add(1, std::memory_order_relaxed);
+  }
+  return th;
+}
+
+void printReport() {
+  hpx::cout
+      << (boost::format("%1% Memory: high-water %2% bytes (pools %3%, stacks %4%, futures %5% now), cap %6%, throttled %7% times, %8% spawns run inline")
+          % static_cast<std::int64_t>(hpx::get_locality_id())
+          % highWater.load()
+          % held(Pools)
+          % held(Stacks)
+          % held(Futures)
+          % cap
+          % throttles.load()
+          % inlinedSpawns(false))
+      << hpx::endl;
+
+  if (HugePages::mode() != HugePages::Off) {
+    hpx::cout
+        << (boost::format("%1% Huge pages: %2% bytes explicit, %3% bytes transparent, %4% regions on normal pages")
+            % static_cast<std::int64_t>(hpx::get_locality_id())
+            % HugePages::explicitBytes()
+            % HugePages::transparentBytes()
+            % HugePages::fallbacks())
+        << hpx::endl;
+  }
+}
+
+void registerPerformanceCounters() {
+  hpx::performance_counters::install_counter_type(
+      "/yewpar/memory/pools",
+      &heldCounter<Pools>,
+      "Returns the bytes held by queued tasks on this locality"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/yewpar/memory/stacks",
+      &heldCounter<Stacks>,
+      "Returns the bytes held by search stack frames (live or cached) on this locality"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/yewpar/memory/futures",
+      &heldCounter<Futures>,
+      "Returns the bytes held by child futures not yet waited on this locality"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/yewpar/memory/total",
+      &totalCounter,
+      "Returns the bytes held by the search on this locality, as used for the memory cap"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/yewpar/memory/highWater",
+      &highWaterCounter,
+      "Returns the most bytes held by the search on this locality"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/yewpar/memory/inlinedSpawns",
+      &inlinedSpawns,
+      "Returns the number of spawns run inline because of the memory cap on this locality"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/yewpar/memory/hugePagesExplicit",
+      &explicitHugeCounter,
+      "Returns the bytes of stacks and pools mapped on explicit (hugetlb) huge pages on this locality"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/yewpar/memory/hugePagesTransparent",
+      &transparentHugeCounter,
+      "Returns the bytes of stacks and pools advised for transparent huge pages on this locality"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/yewpar/memory/hugePageFallbacks",
+      &hugeFallbacksCounter,
+      "Returns the number of regions that asked for huge pages but got normal ones on this locality"
+                                                  );
+}
+
+}}}
@@ -0,0 +1,51 @@
+#ifndef YEWPAR_MEMORY_USAGE_HPP
+#define YEWPAR_MEMORY_USAGE_HPP
+
+#include <cstdint>
+
+#include <hpx/runtime/actions/plain_action.hpp>
+
+// Per locality accounting of the memory held by the search itself, and Params::memoryCapMB.
+//
+// The work pools (DepthPool and the SearchManager's task buffers) count their queued entries,
+// GeneratorStack its built frames (including the ones cached for reuse) and DepthBounded/Budget
+// the futures of children they are still waiting on. Sizes are the objects themselves: heap memory
+// owned by nodes (vectors, bitsets behind a pointer) isn't seen, so this is a lower bound. The
+// totals are /yewpar/memory/* performance counters, along with how much is on huge pages (see
+// HugePages.hpp).
+//
+// With a cap, spawning stops once the locality holds more than the cap and resumes once it is back
+// under three quarters of it; in between skeletons search the children they would have spawned
+// themselves. Searches still finish, they just get less parallel while memory is tight.
+namespace YewPar { namespace util { namespace MemoryUsage {
+
+enum Kind {Pools, Stacks, Futures, numKinds};
+
+// A child future and its promise's shared state. Promises are AGAS registered components, so
+// they are rather more than sizeof(hpx::future<void>).
+constexpr std::int64_t futureBytes = 256;
+
+// bytes (negative to release) now held, or no longer held, for kind. Cheap enough for every task.
+void add(Kind kind, std::int64_t bytes);
+
+// Bytes held on this locality, exact per kind or as the (slightly lagging) total the cap uses
+std::int64_t held(Kind kind);
+std::int64_t total();
+
+// Set the cap for a new search (0 for none) and zero the high-water mark, must run on every
+// locality
+void reset(std::uint64_t capBytes);
+HPX_DEFINE_PLAIN_ACTION(reset, reset_act);
+
+// Should the caller run the task it is about to spawn itself? Counted as an inlined spawn if so.
+bool overCap();
+
+// Print this locality's high-water mark and inlined spawns for the last search
+void printReport();
+HPX_DEFINE_PLAIN_ACTION(printReport, printReport_act);
+
+void registerPerformanceCounters();
+
+}}}
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef YEWPAR_MULTISTART_HPP
+#define YEWPAR_MULTISTART_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <hpx/lcos/async.hpp>
+#include <hpx/lcos/broadcast.hpp>
+#include <hpx/lcos/future.hpp>
+#include <hpx/lcos/wait_all.hpp>
+#include <hpx/runtime/actions/basic_action.hpp>
+#include <hpx/runtime/find_all_localities.hpp>
+#include <hpx/runtime/serialization/vector.hpp>
+#include <hpx/include/iostreams.hpp>
+
+#include <boost/format.hpp>
+
+#include "Registry.hpp"
+#include "workstealing/Scheduler.hpp"
+
+// Multi-start construction heuristics for the initial incumbent (API::InitialHeuristic,
+// Params::multiStartMillis).
+//
+// Before a B&B search starts, every worker on every locality calls the heuristic, a function
+// (space, root, seed) -> Node building a solution from some randomised starting point, over and
+// over until multiStartMillis has passed, keeping the best node it built. The best of those over
+// the whole system becomes the initial incumbent (if it beats Params::initialBound), so the search
+// prunes against a good bound from its first node rather than finding one on the way. Each worker
+// calls the heuristic at least once, however short the time budget.
+namespace YewPar { namespace util { namespace MultiStart {
+
+struct Stats {
+  std::uint64_t starts = 0;
+  double millis = 0;
+
+  template <class Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & starts;
+    ar & millis;
+  }
+};
+
+template <typename Node>
+struct Result {
+  Node best;
+  Stats stats;
+
+  template <class Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & best;
+    ar & stats;
+  }
+};
+
+// The best of this locality's workers, each running the heuristic until the deadline
+template <typename Space, typename Node, typename Bound, typename Enumerator, typename Heuristic, typename Cmp>
+Result<Node> runLocal(const unsigned millis) {
+  auto reg = Registry<Space, Node, Bound, Enumerator>::gReg;
+  auto start = std::chrono::steady_clock::now();
+  auto deadline = start + std::chrono::milliseconds(millis);
+
+  struct Worker {
+    Node best;
+    std::uint64_t starts;
+  };
+
+  std::random_device rd;
+  std::vector<hpx::future<Worker> > workers;
+  for (unsigned i = 0; i < Workstealing::Scheduler::localWorkers(); ++i) {
+    auto exe = Workstealing::Scheduler::workerExecutor(i, hpx::threads::thread_priority_normal);
+    std::uint64_t seed = (static_cast<std::uint64_t>(rd()) << 32) ^ rd();
+    workers.push_back(hpx::async(exe, [reg, deadline, seed]() {
+          const auto & space = reg->localSpace();
+          std::mt19937_64 rng(seed);
+          Cmp cmp;
+
+          Worker w {Heuristic::invoke(space, reg->root, rng()), 1};
+          while (std::chrono::steady_clock::now() < deadline) {
+            auto n = Heuristic::invoke(space, reg->root, rng());
+            ++w.starts;
+            if (cmp(n.getObj(), w.best.getObj())) {
+              w.best = std::move(n);
+            }
+          }
+          return w;
+        }));
+  }
+
+  Result<Node> res;
+  Cmp cmp;
+  bool first = true;
+  for (auto & f : workers) {
+    auto w = f.get();
+    res.stats.starts += w.starts;
+    if (first || cmp(w.best.getObj(), res.best.getObj())) {
+      res.best = std::move(w.best);
+      first = false;
+    }
+  }
+  res.stats.millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return res;
+}
+
+template <typename Space, typename Node, typename Bound, typename Enumerator, typename Heuristic, typename Cmp>
+struct RunLocalAct : hpx::actions::make_action<
+  decltype(&runLocal<Space, Node, Bound, Enumerator, Heuristic, Cmp>), &runLocal<Space, Node, Bound, Enumerator, Heuristic, Cmp>, RunLocalAct<Space, Node, Bound, Enumerator, Heuristic, Cmp> >::type {};
+
+// The best node built on any locality, which must all have their registries initialised
+template <typename Space, typename Node, typename Bound, typename Enumerator, typename Heuristic, typename Cmp>
+Node run(const unsigned millis, const bool verbose) {
+  auto results = hpx::lcos::broadcast<RunLocalAct<Space, Node, Bound, Enumerator, Heuristic, Cmp> >(
+      hpx::find_all_localities(), millis).get();
+
+  Cmp cmp;
+  auto best = 0u;
+  Stats total;
+  for (auto i = 0u; i < results.size(); ++i) {
+    total.starts += results[i].stats.starts;
+    total.millis = std::max(total.millis, results[i].stats.millis);
+    if (cmp(results[i].best.getObj(), results[best].best.getObj())) {
+      best = i;
+    }
+  }
+
+  if (verbose) {
+    hpx::cout << (boost::format("Multi-start heuristic: %1% starts in %2%ms, best objective %3%\n")
+                  % total.starts % total.millis % results[best].best.getObj())
+              << hpx::flush;
+  }
+  return results[best].best;
+}
+
+}}}
+
+#endif
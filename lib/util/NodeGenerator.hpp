@@ -1,6 +1,9 @@
 #ifndef UTIL_LAZY_NODEGENERATOR_HPP
 #define UTIL_LAZY_NODEGENERATOR_HPP
 
+#include <type_traits>
+#include <utility>
+
 namespace YewPar {
 
 #include <hpx/util/tuple.hpp>
@@ -18,6 +21,9 @@ struct NodeGenerator {
 
   // Quickly skip to the nth child if possible Useful for recompute based
   // skeletons where we send a path in the tree rather than a particular node
+  //
+  // This always builds every child up to n, skeletons should use nthChild
+  // below which uses the generator's skip (if any) instead
   NodeType nth(unsigned n) {
     NodeType c;
     for (auto i = 0; i <= n; ++i) {
@@ -27,6 +33,193 @@ struct NodeGenerator {
   };
 };
 
+// Generators may optionally provide
+//
+//   void skip(unsigned k);
+//
+// to move past their next k children without building them (e.g. dropping
+// bits from a candidate set or advancing an index). Afterwards next() must
+// return the child it would have returned after k more calls to next().
+namespace detail {
+template <typename Generator, typename = void>
+struct hasSkip : std::false_type {};
+
+template <typename Generator>
+struct hasSkip<Generator, std::void_t<decltype(std::declval<Generator &>().skip(0u))> > : std::true_type {};
+}
+
+template <typename Generator>
+void skipChildren(Generator & gen, unsigned k) {
+  if constexpr(detail::hasSkip<Generator>::value) {
+    gen.skip(k);
+  } else {
+    for (unsigned i = 0; i < k; ++i) {
+      gen.next();
+    }
+  }
+}
+
+// Return the nth (from 0) child not yet returned by gen
+template <typename Generator>
+typename Generator::Nodetype nthChild(Generator & gen, unsigned n) {
+  skipChildren(gen, n);
+  return gen.next();
+}
+
+// Generators may also provide
+//
+//   void nextInto(NodeType & dest);
+//
+// which writes the next child over dest instead of returning a new node. The
+// stack based skeletons pass the stack frame the child goes into, which holds
+// an older node, so containers in the node can reuse their capacity rather
+// than allocating for every child.
+namespace detail {
+template <typename Generator, typename = void>
+struct hasNextInto : std::false_type {};
+
+template <typename Generator>
+struct hasNextInto<Generator, std::void_t<decltype(std::declval<Generator &>().nextInto(
+    std::declval<typename Generator::Nodetype &>()))> > : std::true_type {};
+}
+
+template <typename Generator>
+void nextChildInto(Generator & gen, typename Generator::Nodetype & dest) {
+  if constexpr(detail::hasNextInto<Generator>::value) {
+    gen.nextInto(dest);
+  } else {
+    dest = gen.next();
+  }
+}
+
+// Generators may also provide
+//
+//   void reset(const Space & space, const NodeType & n);
+//
+// rebuilding themselves in place for the children of n, as if newly
+// constructed. The stack based skeletons build each child's generator in its
+// stack frame, and frames are reused from node to node (see GeneratorStack), so
+// buffers the generator owns keep their capacity instead of being allocated
+// for every node. Without reset the frame's generator is move assigned a new one.
+namespace detail {
+template <typename Generator, typename = void>
+struct hasReset : std::false_type {};
+
+template <typename Generator>
+struct hasReset<Generator, std::void_t<decltype(std::declval<Generator &>().reset(
+    std::declval<const typename Generator::Spacetype &>(),
+    std::declval<const typename Generator::Nodetype &>()))> > : std::true_type {};
+}
+
+template <typename Generator>
+void resetGenerator(Generator & gen,
+                    const typename Generator::Spacetype & space,
+                    const typename Generator::Nodetype & n) {
+  if constexpr(detail::hasReset<Generator>::value) {
+    gen.reset(space, n);
+  } else {
+    gen = Generator(space, n);
+  }
+}
+
+// Generators may also provide
+//
+//   const std::vector<B> & childBounds();
+//
+// returning, in the order next() returns them, the BoundFunction value of
+// every child, computed from the parent in one go. Siblings usually share most
+// of the work (e.g. one spanning tree for all of a TSP node's children) and
+// nothing has to be built. Skeletons then prune children on these bounds before
+// building them, skipping pruned ones with skipChildren. The result must stay
+// valid until the generator is reassigned, so generators typically compute it
+// on the first call and keep it.
+namespace detail {
+template <typename Generator, typename = void>
+struct hasChildBounds : std::false_type {};
+
+template <typename Generator>
+struct hasChildBounds<Generator, std::void_t<decltype(std::declval<Generator &>().childBounds()[0])> > : std::true_type {};
+}
+
+// Generators may also provide
+//
+//   bool childrenAreLeaves();
+//
+// returning true if none of their children have children of their own, e.g.
+// the last row in nqueens. Enumerations can then accumulate the whole level in
+// bulk (see hasAccumulateChildren in Enumerator.hpp).
+namespace detail {
+template <typename Generator, typename = void>
+struct hasChildrenAreLeaves : std::false_type {};
+
+template <typename Generator>
+struct hasChildrenAreLeaves<Generator, std::void_t<decltype(std::declval<Generator &>().childrenAreLeaves())> > : std::true_type {};
+}
+
+template <typename Generator>
+bool childrenAreLeaves(Generator & gen) {
+  if constexpr(detail::hasChildrenAreLeaves<Generator>::value) {
+    return gen.childrenAreLeaves();
+  } else {
+    return false;
+  }
+}
+
+// Generators may also provide
+//
+//   static Delta siblingDelta(const NodeType & base, const NodeType & sibling);
+//   static NodeType applySiblingDelta(const NodeType & base, const Delta & delta);
+//
+// for some serialisable Delta, describing a node by how it differs from a
+// sibling (another child of the same parent). applySiblingDelta(base,
+// siblingDelta(base, n)) must give back n. Siblings usually share most of their
+// state, so StackStealing then sends the nodes of a chunked steal to remote
+// thieves as one node plus deltas (see SiblingDeltas in PathSteal.hpp).
+namespace detail {
+template <typename Generator, typename = void>
+struct hasSiblingDelta : std::false_type {};
+
+template <typename Generator>
+struct hasSiblingDelta<Generator, std::void_t<decltype(Generator::applySiblingDelta(
+    std::declval<const typename Generator::Nodetype &>(),
+    Generator::siblingDelta(std::declval<const typename Generator::Nodetype &>(),
+                            std::declval<const typename Generator::Nodetype &>())))> > : std::true_type {};
+}
+
+// Alternative base without virtual functions. Skeletons are templated on the
+// concrete generator type, so with this base next() is a direct call that can
+// be inlined into the search loops, which matters for generators doing very
+// little work per child (e.g. nqueens). Use as
+//
+//   struct Gen : YewPar::StaticNodeGenerator<Gen, Node, Space> {
+//     Node next() { ... }
+//   };
+template <typename Derived, typename NodeType, typename Space>
+struct StaticNodeGenerator {
+  using Nodetype  = NodeType;
+  using Spacetype = Space;
+
+  unsigned numChildren;
+
+  NodeType nth(unsigned n) {
+    return nthChild(static_cast<Derived &>(*this), n);
+  }
+};
+
+// What skeletons need from a generator, whichever base (if any) it uses
+template <typename Generator, typename = void>
+struct isNodeGenerator : std::false_type {};
+
+template <typename Generator>
+struct isNodeGenerator<Generator, std::void_t<
+  typename Generator::Nodetype,
+  typename Generator::Spacetype,
+  decltype(std::declval<Generator &>().numChildren),
+  decltype(std::declval<Generator &>().next()),
+  decltype(Generator(std::declval<const typename Generator::Spacetype &>(),
+                     std::declval<const typename Generator::Nodetype &>()))> >
+    : std::is_convertible<decltype(std::declval<Generator &>().next()), typename Generator::Nodetype> {};
+
 }
 
 #endif
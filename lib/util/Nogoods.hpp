@@ -0,0 +1,114 @@
+#ifndef YEWPAR_NOGOODS_HPP
+#define YEWPAR_NOGOODS_HPP
+
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <hpx/lcos/local/mutex.hpp>
+
+// Nogoods for restarting searches (see skeletons/Restarts.hpp): subtrees known to hold no
+// solution, named by their path of child indices from the root. Indices are in generator order, so
+// a nogood stays valid whatever order a later run visits children in, and on every worker and
+// locality, as they all expand the same tree.
+namespace YewPar { namespace util {
+
+using NogoodPath = std::vector<std::uint32_t>;
+
+// A worker's own nogoods, walked alongside the search: child(t, i) moves from the trie node of a
+// search node to that of its i'th child, so each lookup is a single hash probe.
+class NogoodTrie {
+ public:
+  static constexpr std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+
+  NogoodTrie() : nogood(1, false) {}
+
+  std::uint32_t root() const { return 0; }
+
+  // The trie node below t for child i, none if no nogood goes through it (or t is none)
+  std::uint32_t child(const std::uint32_t t, const std::uint32_t i) const {
+    if (t == none) {
+      return none;
+    }
+    auto e = edges.find(key(t, i));
+    return e == edges.end() ? none : e->second;
+  }
+
+  bool isNogood(const std::uint32_t t) const {
+    return t != none && nogood[t];
+  }
+
+  // Returns false if p was already known (or lies below a known nogood)
+  bool insert(const NogoodPath & p) {
+    std::uint32_t t = root();
+    for (auto i : p) {
+      if (nogood[t]) {
+        return false;
+      }
+      auto e = edges.find(key(t, i));
+      if (e == edges.end()) {
+        auto n = static_cast<std::uint32_t>(nogood.size());
+        nogood.push_back(false);
+        e = edges.emplace(key(t, i), n).first;
+      }
+      t = e->second;
+    }
+    if (nogood[t]) {
+      return false;
+    }
+    // Anything below t is now unreachable, it isn't worth removing
+    nogood[t] = true;
+    ++count;
+    return true;
+  }
+
+  std::uint64_t size() const { return count; }
+
+ private:
+  static std::uint64_t key(const std::uint32_t t, const std::uint32_t i) {
+    return (static_cast<std::uint64_t>(t) << 32) | i;
+  }
+
+  std::unordered_map<std::uint64_t, std::uint32_t> edges;
+  std::vector<bool> nogood;
+  std::uint64_t count = 0;
+};
+
+// Every nogood learned on, or sent to, a locality in order. Workers read what was added since they
+// last looked at their restarts, so the log is only locked there.
+class NogoodLog {
+ public:
+  void add(const std::vector<NogoodPath> & ps) {
+    std::lock_guard<hpx::lcos::local::mutex> l(mtx);
+    entries.insert(entries.end(), ps.begin(), ps.end());
+  }
+
+  // Insert the entries from cursor on into trie, returning the new cursor
+  std::size_t readInto(const std::size_t cursor, NogoodTrie & trie) {
+    std::lock_guard<hpx::lcos::local::mutex> l(mtx);
+    for (auto i = cursor; i < entries.size(); ++i) {
+      trie.insert(entries[i]);
+    }
+    return entries.size();
+  }
+
+  std::size_t size() {
+    std::lock_guard<hpx::lcos::local::mutex> l(mtx);
+    return entries.size();
+  }
+
+  void clear() {
+    std::lock_guard<hpx::lcos::local::mutex> l(mtx);
+    entries.clear();
+  }
+
+ private:
+  hpx::lcos::local::mutex mtx;
+  std::vector<NogoodPath> entries;
+};
+
+}}
+
+#endif
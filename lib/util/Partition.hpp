@@ -0,0 +1,183 @@
+#ifndef YEWPAR_PARTITION_HPP
+#define YEWPAR_PARTITION_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <hpx/runtime/serialization/input_archive.hpp>
+#include <hpx/runtime/serialization/output_archive.hpp>
+#include <hpx/runtime/serialization/serialize.hpp>
+
+#include "Checkpoint.hpp"
+#include "Enumerator.hpp"
+#include "TreeEstimator.hpp"
+
+// Splitting one search into independent batch jobs.
+//
+// split expands the tree down to a given depth and deals the nodes there out to parts, largest
+// estimated subtree first onto the least loaded part (subtree sizes come from TreeEstimator probes).
+// Each part is a Checkpoint (see Checkpoint.hpp) holding its frontier nodes as tasks, so any
+// DepthBounded search run with Params::resumeFromCheckpoint and the part as checkpointFile
+// searches exactly that part. The nodes above the frontier are accounted for in part 0.
+//
+// Every job then saves its result with writeResult, and a final step combines them with
+// mergeEnumerated (enumerations) or bestIncumbent (optimisation and decision searches).
+//
+// Parts hold the frontier nodes themselves rather than paths to them, like checkpoints do.
+namespace YewPar { namespace util { namespace Partition {
+
+template <typename Node, typename Bound, typename EnumRes>
+using Part = Checkpoint<Node, Bound, EnumRes>;
+
+// Split the search below root into parts at depth (the root is at depth 0), estimating each
+// frontier subtree, no deeper than maxDepth, with probes probes. With a Cmp the best node above or
+// on the frontier (by getObj) becomes every part's incumbent if it beats initialBound.
+template <typename Generator, typename Enum, typename Bound = bool, typename Cmp = void>
+std::vector<Part<typename Generator::Nodetype, Bound, typename Enum::ResT> >
+split(const typename Generator::Spacetype & space,
+      const typename Generator::Nodetype & root,
+      const unsigned depth,
+      const unsigned parts,
+      const unsigned probes,
+      const unsigned maxDepth,
+      const Bound & initialBound = Bound()) {
+  using Node = typename Generator::Nodetype;
+  constexpr bool tracksIncumbent = !std::is_void<Cmp>::value;
+
+  if (parts == 0) {
+    throw std::invalid_argument("Partition::split needs at least one part");
+  }
+
+  Enum interior;
+  std::vector<Node> frontier;
+  Node best = root;
+
+  std::function<void(const Node &, unsigned)> expand = [&](const Node & n, const unsigned d) {
+    if constexpr(tracksIncumbent) {
+      if (Cmp()(n.getObj(), best.getObj())) {
+        best = n;
+      }
+    }
+    if (d == depth) {
+      frontier.push_back(n);
+      return;
+    }
+
+    accumulateNode(interior, n, d);
+    auto gen = Generator(space, n);
+    for (auto i = 0; i < gen.numChildren; ++i) {
+      expand(gen.next(), d + 1);
+    }
+  };
+  expand(root, 0);
+
+  std::vector<double> estimates;
+  for (const auto & n : frontier) {
+    auto below = maxDepth > depth ? maxDepth - depth : 0;
+    estimates.push_back(estimateTree<Generator>(space, n, probes, below).totalNodes());
+  }
+
+  std::vector<std::size_t> order(frontier.size());
+  for (auto i = 0u; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+      return estimates[a] > estimates[b];
+    });
+
+  std::vector<Part<Node, Bound, typename Enum::ResT> > res(parts);
+  std::vector<Enum> accs(parts);
+  std::vector<double> load(parts, 0);
+  for (auto i : order) {
+    auto p = std::min_element(load.begin(), load.end()) - load.begin();
+    load[p] += estimates[i];
+    accumulateNode(accs[p], frontier[i], depth);
+    res[p].tasks.push_back(CheckpointTask<Node> {frontier[i], depth + 1, 0});
+  }
+
+  accs[0].combine(interior.get());
+  for (auto p = 0u; p < parts; ++p) {
+    res[p].enumerated = accs[p].get();
+    res[p].incumbent = root;
+    res[p].bound = initialBound;
+    if constexpr(tracksIncumbent) {
+      if (Cmp()(best.getObj(), initialBound)) {
+        res[p].incumbent = best;
+        res[p].bound = best.getObj();
+      }
+    }
+  }
+  return res;
+}
+
+// Write parts to prefix.0, prefix.1, ...
+template <typename Node, typename Bound, typename EnumRes>
+void writeParts(const std::string & prefix, const std::vector<Part<Node, Bound, EnumRes> > & parts) {
+  for (auto p = 0u; p < parts.size(); ++p) {
+    writeCheckpoint(prefix + "." + std::to_string(p), parts[p]);
+  }
+}
+
+// A job's result (an enumerator's ResT or the incumbent node)
+template <typename T>
+void writeResult(const std::string & file, const T & res) {
+  std::vector<char> buf;
+  {
+    hpx::serialization::output_archive ar(buf);
+    ar << res;
+  }
+
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  out.write(buf.data(), buf.size());
+  if (!out) {
+    throw std::runtime_error("Could not write result " + file);
+  }
+}
+
+template <typename T>
+T readResult(const std::string & file) {
+  std::ifstream in(file, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("Could not open result " + file);
+  }
+  std::vector<char> buf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+  T res;
+  hpx::serialization::input_archive ar(buf, buf.size());
+  ar >> res;
+  return res;
+}
+
+template <typename Enum>
+typename Enum::ResT mergeEnumerated(const std::vector<std::string> & files) {
+  Enum acc;
+  for (const auto & f : files) {
+    acc.combine(readResult<typename Enum::ResT>(f));
+  }
+  return acc.get();
+}
+
+// Must be given at least one file
+template <typename Node, typename Cmp>
+Node bestIncumbent(const std::vector<std::string> & files) {
+  auto best = readResult<Node>(files.at(0));
+  for (auto i = 1u; i < files.size(); ++i) {
+    auto n = readResult<Node>(files[i]);
+    if (Cmp()(n.getObj(), best.getObj())) {
+      best = std::move(n);
+    }
+  }
+  return best;
+}
+
+}}}
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef YEWPAR_PATHSTEAL_HPP
+#define YEWPAR_PATHSTEAL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include <hpx/runtime/serialization/input_archive.hpp>
+#include <hpx/runtime/serialization/output_archive.hpp>
+#include <hpx/runtime/serialization/serialize.hpp>
+#include <hpx/runtime/serialization/vector.hpp>
+
+#include "NodeGenerator.hpp"
+
+// Recompute based steals (Params::pathSteals).
+//
+// A stolen node can be sent as the path of child indices leading to it from the search root
+// (Registry::root), which the thief replays with nthChild. For large nodes (e.g. SIP domains)
+// this is far smaller than the node itself, at the cost of regenerating depth many nodes. The
+// victim decides per steal using the serialised size of the node and a sampled estimate of how long
+// one generator step takes on this locality.
+namespace YewPar {
+
+// The root of a stack stealing task: the node itself and/or its path from the search root. With
+// path steals off this is just the node (path is empty).
+//
+// A task stolen by a remote thief may also carry siblings of the node, encoded relative to it by
+// SiblingDeltas. The thief runs each of them as a task of its own.
+template <typename Node>
+struct TaskNode {
+  bool hasNode = true;
+  Node node;
+  std::vector<std::uint32_t> path;
+  std::vector<std::vector<char> > siblings;
+
+  TaskNode() = default;
+  TaskNode(Node n) : node(std::move(n)) {}
+  TaskNode(Node n, std::vector<std::uint32_t> p) : node(std::move(n)), path(std::move(p)) {}
+
+  // Drop the node, the receiver recomputes it from the path
+  void sendPathOnly() {
+    hasNode = false;
+    node = Node();
+  }
+
+  template <class Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & hasNode;
+    if (hasNode) {
+      ar & node;
+    }
+    ar & path;
+    ar & siblings;
+  }
+};
+
+// Rebuild a node from its path
+template <typename Generator>
+typename Generator::Nodetype recomputeNode(const typename Generator::Spacetype & space,
+                                           typename Generator::Nodetype node,
+                                           const std::vector<std::uint32_t> & path) {
+  for (auto idx : path) {
+    auto gen = Generator(space, node);
+    node = nthChild(gen, idx);
+  }
+  return node;
+}
+
+template <typename Generator>
+struct RecomputeCost {
+  // Assumed cost of moving a byte between localities
+  static constexpr double nsPerByte = 1.0;
+
+  // Time one in this many generator constructions
+  static constexpr unsigned sampleInterval = 256;
+
+  // Moving average of the time (ns) to build one generator on this locality, 0 until measured
+  static std::atomic<std::uint64_t> nsPerStep;
+
+  static void record(std::chrono::steady_clock::duration d) {
+    auto ns = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+    auto cur = nsPerStep.load(std::memory_order_relaxed);
+    nsPerStep.store(cur == 0 ? ns : (3 * cur + ns) / 4, std::memory_order_relaxed);
+  }
+
+  template <typename Node>
+  static std::size_t serializedSize(const Node & n) {
+    std::vector<char> buf;
+    hpx::serialization::output_archive ar(buf);
+    ar << n;
+    return ar.bytes_written();
+  }
+
+  // Is sending the path (and recomputing) cheaper than sending the node?
+  template <typename Node>
+  static bool preferPath(const Node & n, std::size_t pathLength) {
+    auto step = nsPerStep.load(std::memory_order_relaxed);
+    if (step == 0) {
+      return false;
+    }
+    auto pathCost = pathLength * (step + sizeof(std::uint32_t) * nsPerByte);
+    return pathCost < serializedSize(n) * nsPerByte;
+  }
+};
+
+template <typename Generator>
+std::atomic<std::uint64_t> RecomputeCost<Generator>::nsPerStep(0);
+
+// Delta encoded siblings for chunked steals (see hasSiblingDelta in NodeGenerator.hpp). Only
+// usable if the generator provides the hooks.
+template <typename Generator>
+struct SiblingDeltas {
+  using Node = typename Generator::Nodetype;
+
+  static constexpr bool enabled = detail::hasSiblingDelta<Generator>::value;
+
+  static std::vector<char> encode(const Node & base, const Node & sibling) {
+    std::vector<char> buf;
+    std::size_t size;
+    {
+      hpx::serialization::output_archive ar(buf);
+      ar << Generator::siblingDelta(base, sibling);
+      size = ar.bytes_written();
+    }
+    buf.resize(size);
+    return buf;
+  }
+
+  static Node decode(const Node & base, const std::vector<char> & buf) {
+    std::decay_t<decltype(Generator::siblingDelta(base, base))> delta;
+    hpx::serialization::input_archive ar(buf, buf.size());
+    ar >> delta;
+    return Generator::applySiblingDelta(base, delta);
+  }
+};
+
+}
+
+#endif
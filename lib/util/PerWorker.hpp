@@ -0,0 +1,75 @@
+#ifndef YEWPAR_PERWORKER_HPP
+#define YEWPAR_PERWORKER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+#include "hpx/runtime/get_os_thread_count.hpp"
+#include "hpx/runtime/get_worker_thread_num.hpp"
+
+namespace YewPar { namespace util {
+
+// A T for each worker thread of this locality, each on its own cache lines, for state every worker
+// updates often (counters, buffers) that would otherwise bounce one line between them all.
+//
+// The last slot is shared by threads outside the pool, so a T that isn't safe to update from
+// several threads at once needs its users to treat that slot specially (see isShared). Slots are
+// default constructed on first use, once the runtime knows how many workers there are.
+template <typename T>
+class PerWorker {
+ public:
+  // The calling thread's slot
+  T & mine() {
+    return (*this)[myIndex()];
+  }
+
+  std::size_t myIndex() {
+    init();
+    return std::min<std::size_t>(hpx::get_worker_thread_num(), n - 1);
+  }
+
+  // Workers plus the shared slot
+  std::size_t size() {
+    init();
+    return n;
+  }
+
+  bool isShared(std::size_t i) {
+    return i + 1 == size();
+  }
+
+  T & operator[](std::size_t i) {
+    init();
+    return slots[i].value;
+  }
+
+  template <typename F>
+  void forEach(F && f) {
+    init();
+    for (std::size_t i = 0; i < n; ++i) {
+      f(slots[i].value);
+    }
+  }
+
+ private:
+  struct alignas(64) Slot {
+    T value;
+  };
+
+  void init() {
+    std::call_once(initFlag, [this]() {
+      n = hpx::get_os_thread_count() + 1;
+      slots.reset(new Slot[n]);
+    });
+  }
+
+  std::once_flag initFlag;
+  std::size_t n = 0;
+  std::unique_ptr<Slot[]> slots;
+};
+
+}}
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <iterator>
 #include <memory>
@@ -11,9 +12,26 @@
 #include <hpx/runtime/actions/basic_action.hpp>
 #include <hpx/traits/action_stacksize.hpp>
 #include <hpx/lcos/local/mutex.hpp>
+#include <hpx/lcos/async.hpp>
+#include <hpx/lcos/future.hpp>
+#include <hpx/runtime/get_worker_thread_num.hpp>
+#include <hpx/runtime/get_os_thread_count.hpp>
+#include <hpx/runtime/get_locality_id.hpp>
+#include <hpx/runtime/serialization/input_archive.hpp>
+#include <hpx/runtime/serialization/output_archive.hpp>
+#include <hpx/runtime/serialization/serialize_buffer.hpp>
 
 #include "skeletons/API.hpp"
 #include "Enumerator.hpp"
+#include "util.hpp"
+#include "PerWorker.hpp"
+#include "SearchContext.hpp"
+#include "Checkpoint.hpp"
+#include "Nogoods.hpp"
+
+namespace Workstealing { namespace Scheduler {
+void cancelWork();
+}}
 
 namespace YewPar {
 
@@ -25,18 +43,61 @@ struct Registry {
   Space space;
   Node root;
 
+  // Params::numaReplicas: a read only copy of space per NUMA domain, made on first use by a worker
+  // of that domain. Slots are only written (once per search) under replicaMtx.
+  std::unique_ptr<std::atomic<const Space *>[]> replicas;
+  std::vector<std::unique_ptr<Space> > replicaStore;
+  unsigned numReplicas = 0;
+  hpx::lcos::local::mutex replicaMtx;
+
   Skeletons::API::Params<Bound> params;
 
-  // BNB
-  std::atomic<Bound> localBound;
-  hpx::naming::id_type globalIncumbent;
+  // Search this registry currently belongs to (see SearchContext.hpp)
+  std::uint64_t searchId = 0;
+
+  // BNB. The bound and the stop flag are read for every node but only rarely written, so they get
+  // their own cache lines rather than sharing with the (frequently written) state around them.
+  alignas(64) std::atomic<Bound> localBound;
+  alignas(64) hpx::naming::id_type globalIncumbent;
+
+  // Params::boundRefreshInterval: raised for every worker when localBound improves, so workers
+  // pruning against a copy re-read it straight away rather than at their next refresh
+  struct BoundNotice {
+    std::atomic<bool> stale {false};
+  };
+  util::PerWorker<BoundNotice> boundNotices;
+
+  // Incumbent propagation state (see BoundPropagation.hpp)
+  hpx::lcos::local::mutex incumbentMtx;
+  Node pendingIncumbent;
+  bool hasPendingIncumbent = false;
+  bool incumbentFlushScheduled = false;
+  std::chrono::steady_clock::time_point lastIncumbentFlush;
+  std::vector<hpx::future<void> > incumbentUpdates;
+
+  // Best node found on this locality (LazyIncumbent only)
+  Node localIncumbent;
+  bool hasLocalIncumbent = false;
 
   // Decision problems
-  std::atomic<bool> stopSearch {false};
-  hpx::naming::id_type foundPromiseId;
-
-  // Counting Nodes
-  Enumerator acc;
+  alignas(64) std::atomic<bool> stopSearch {false};
+  // Set by the first task that sees stopSearch (through shouldStop), i.e. one that gave up work
+  std::atomic<bool> stopObserved {false};
+  // Search a stop was sent to (stopAndCancelSearch), which may arrive before its initialise
+  std::atomic<std::uint64_t> stopSearchId {0};
+  alignas(64) hpx::naming::id_type foundPromiseId;
+
+  // Checkpointing: while set, tasks stop and record their remaining work in checkpointTasks
+  alignas(64) std::atomic<bool> checkpointing {false};
+  hpx::lcos::local::mutex checkpointMtx;
+  std::vector<CheckpointTask<Node> > checkpointTasks;
+
+  // Restarts: nogoods learned on, or sent to, this locality (see Nogoods.hpp)
+  util::NogoodLog nogoods;
+
+  // Counting Nodes. Each worker thread accumulates into its own slot, threads outside the pool
+  // share the last one under mtx.
+  util::PerWorker<Enumerator> threadAccs;
   using MutexT = hpx::lcos::local::mutex;
   MutexT mtx;
   // using countMapT = std::vector<std::atomic<std::uint64_t> >;
@@ -45,37 +106,103 @@ struct Registry {
   // We construct this object globally at compile time (see below) so this can't
   // happen in the constructor and should instead be called as an action on each
   // locality.
-  void initialise(Space space, Node root, Skeletons::API::Params<Bound> params) {
+  void initialise(const Space & space, Node root, Skeletons::API::Params<Bound> params) {
     this->space = space;
-    this->root = root;
-    this->params = params;
+    initialiseExceptSpace(std::move(root), std::move(params));
+  }
+
+  // For when space has been filled in already
+  void initialiseExceptSpace(Node root, Skeletons::API::Params<Bound> params) {
+    this->root = std::move(root);
+    this->params = std::move(params);
+    this->searchId = currentSearchId();
+    this->stopSearch.store(false);
+    this->stopObserved.store(false);
+    if (this->stopSearchId.load() == this->searchId) {
+      this->stopSearch.store(true);
+    }
+    this->checkpointing.store(false);
+    this->checkpointTasks.clear();
+    this->nogoods.clear();
     this->localBound = params.initialBound;
-    this->acc = Enumerator();
+    this->hasPendingIncumbent = false;
+    this->incumbentFlushScheduled = false;
+    this->hasLocalIncumbent = false;
+    this->incumbentUpdates.clear();
+    this->threadAccs.forEach([](Enumerator & e) { e = Enumerator(); });
+
+    // Replicas of the last search's space are stale by now
+    this->replicaStore.clear();
+    this->numReplicas = this->params.numaReplicas ? util::numNumaDomains() : 0;
+    this->replicas.reset(numReplicas > 1 ? new std::atomic<const Space *>[numReplicas] : nullptr);
+    for (auto i = 0u; replicas && i < numReplicas; ++i) {
+      replicas[i].store(nullptr);
+    }
+  }
+
+  // The space for tasks running on this worker: its NUMA domain's replica with
+  // Params::numaReplicas, else the one copy. The replica is copied by the first worker of the domain
+  // to ask, so under the usual first touch policy its memory is local to the domain. Tasks that
+  // later move to a worker in another domain still read a valid (identical) space, just not a
+  // local one.
+  const Space & localSpace() {
+    if (!replicas) {
+      return space;
+    }
+
+    auto domain = util::getNumaDomain();
+    if (auto r = replicas[domain].load(std::memory_order_acquire)) {
+      return *r;
+    }
+
+    std::lock_guard<hpx::lcos::local::mutex> l(replicaMtx);
+    // We may have been resumed on another worker while waiting for the lock
+    domain = util::getNumaDomain();
+    if (auto r = replicas[domain].load(std::memory_order_acquire)) {
+      return *r;
+    }
+    replicaStore.emplace_back(new Space(space));
+    replicas[domain].store(replicaStore.back().get(), std::memory_order_release);
+    return *replicaStore.back();
   }
 
   // Counting
   void updateEnumerator(Enumerator & e) {
+    // Workers never run two tasks at once, and combine doesn't suspend, so the slot needs no lock
+    auto me = threadAccs.myIndex();
+    if (!threadAccs.isShared(me)) {
+      threadAccs[me].combine(e.get());
+      return;
+    }
+
     std::lock_guard<MutexT> l(mtx);
-    acc.combine(e.get());
+    threadAccs[me].combine(e.get());
   }
 
+  // Only valid once the search on this locality has finished
   using ResT = typename Enumerator::ResT;
   ResT getEnumeratorVal() {
-    return acc.get();
+    std::lock_guard<MutexT> l(mtx);
+    Enumerator res;
+    threadAccs.forEach([&](Enumerator & t) { res.combine(t.get()); });
+    return res.get();
   }
 
-  // BNB
+  // BNB. Returns true if bnd improved the local bound.
   template <typename Cmp>
-  void updateRegistryBound(Bound bnd) {
+  bool updateRegistryBound(Bound bnd) {
     while (true) {
       auto curBound = localBound.load();
       Cmp cmp;
       if (!cmp(bnd, curBound)) {
-        break;
+        return false;
       }
 
       if (localBound.compare_exchange_weak(curBound, bnd)) {
-        break;
+        if (params.boundRefreshInterval > 1) {
+          boundNotices.forEach([](BoundNotice & n) { n.stale.store(true, std::memory_order_relaxed); });
+        }
+        return true;
       }
     }
   }
@@ -84,6 +211,22 @@ struct Registry {
     stopSearch.store(true);
   }
 
+  // Whether tasks should give up, for the per node stop checks
+  bool shouldStop() {
+    if (!stopSearch.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    if (!stopObserved.load(std::memory_order_relaxed)) {
+      stopObserved.store(true, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
+  void saveCheckpointTask(const Node & n, const unsigned childDepth, const unsigned firstChild) {
+    std::lock_guard<hpx::lcos::local::mutex> l(checkpointMtx);
+    checkpointTasks.push_back(CheckpointTask<Node> {n, childDepth, firstChild});
+  }
+
 };
 
 template<typename Space, typename Node, typename Bound, typename Enumerator>
@@ -98,6 +241,66 @@ template <typename Space, typename Node, typename Bound, typename Enumerator>
 struct InitRegistryAct : hpx::actions::make_direct_action<
   decltype(&initialiseRegistry<Space, Node, Bound, Enumerator>), &initialiseRegistry<Space, Node, Bound, Enumerator>, InitRegistryAct<Space, Node, Bound, Enumerator> >::type {};
 
+// Initialise the registries of this locality and its subtree (in a binary tree over the localities
+// rooted at root) from the serialised space. Every locality deserialises straight into its
+// registry and forwards the same buffer, so the space is serialised once in total rather than once
+// per locality, and no locality sends it more than twice.
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+void initialiseRegistryTree(std::uint32_t root,
+                            hpx::serialization::serialize_buffer<char> spaceBuf,
+                            Node rootNode,
+                            YewPar::Skeletons::API::Params<Bound> params);
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+struct InitRegistryTreeAct : hpx::actions::make_action<
+  decltype(&initialiseRegistryTree<Space, Node, Bound, Enumerator>), &initialiseRegistryTree<Space, Node, Bound, Enumerator>, InitRegistryTreeAct<Space, Node, Bound, Enumerator> >::type {};
+
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+void initialiseRegistryTree(std::uint32_t root,
+                            hpx::serialization::serialize_buffer<char> spaceBuf,
+                            Node rootNode,
+                            YewPar::Skeletons::API::Params<Bound> params) {
+  std::vector<hpx::future<void> > children;
+  for (auto const & c : util::treeChildren(root)) {
+    children.push_back(hpx::async<InitRegistryTreeAct<Space, Node, Bound, Enumerator> >(
+        c, root, spaceBuf, rootNode, params));
+  }
+
+  auto reg = Registry<Space, Node, Bound, Enumerator>::gReg;
+  {
+    hpx::serialization::input_archive ar(spaceBuf, spaceBuf.size());
+    ar >> reg->space;
+  }
+  reg->initialiseExceptSpace(std::move(rootNode), std::move(params));
+
+  hpx::wait_all(children);
+}
+
+// Initialise the registries on all localities for a new search (called by every skeleton)
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+void initRegistries(const Space & space, const Node & root, const YewPar::Skeletons::API::Params<Bound> & params) {
+  auto here = hpx::get_locality_id();
+  auto children = util::treeChildren(here);
+
+  std::vector<hpx::future<void> > futs;
+  if (!children.empty()) {
+    // The buffer owns the serialised bytes, parcels reference it rather than copying
+    auto bytes = new std::vector<char>();
+    {
+      hpx::serialization::output_archive ar(*bytes);
+      ar << space;
+    }
+    hpx::serialization::serialize_buffer<char> buf(bytes->data(), bytes->size(),
+                                                   [bytes](char *) { delete bytes; });
+    for (auto const & c : children) {
+      futs.push_back(hpx::async<InitRegistryTreeAct<Space, Node, Bound, Enumerator> >(
+          c, here, buf, root, params));
+    }
+  }
+
+  Registry<Space, Node, Bound, Enumerator>::gReg->initialise(space, root, params);
+  hpx::wait_all(futs);
+}
+
 template <typename Space, typename Node, typename Bound, typename Enumerator>
 typename Enumerator::ResT getEnumeratorVal() {
   return Registry<Space, Node, Bound, Enumerator>::gReg->getEnumeratorVal();
@@ -106,6 +309,29 @@ template <typename Space, typename Node, typename Bound, typename Enumerator>
 struct GetEnumeratorValAct : hpx::actions::make_direct_action<
   decltype(&getEnumeratorVal<Space, Node, Bound, Enumerator>), &getEnumeratorVal<Space, Node, Bound, Enumerator>, GetEnumeratorValAct<Space, Node, Bound, Enumerator> >::type {};
 
+// Combine the enumerators of this locality and its subtree (in a binary tree over the localities
+// rooted at root)
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+typename Enumerator::ResT reduceEnumerators(std::uint32_t root);
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+struct ReduceEnumeratorsAct : hpx::actions::make_action<
+  decltype(&reduceEnumerators<Space, Node, Bound, Enumerator>), &reduceEnumerators<Space, Node, Bound, Enumerator>, ReduceEnumeratorsAct<Space, Node, Bound, Enumerator> >::type {};
+
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+typename Enumerator::ResT reduceEnumerators(std::uint32_t root) {
+  std::vector<hpx::future<typename Enumerator::ResT> > children;
+  for (auto const & c : util::treeChildren(root)) {
+    children.push_back(hpx::async<ReduceEnumeratorsAct<Space, Node, Bound, Enumerator> >(c, root));
+  }
+
+  Enumerator res;
+  res.combine(Registry<Space, Node, Bound, Enumerator>::gReg->getEnumeratorVal());
+  for (auto & f : children) {
+    res.combine(f.get());
+  }
+  return res.get();
+}
+
 template <typename Space, typename Node, typename Bound, typename Enumerator>
 void setStopSearchFlag() {
   Registry<Space, Node, Bound, Enumerator>::gReg->setStopSearchFlag();
@@ -114,6 +340,61 @@ template <typename Space, typename Node, typename Bound, typename Enumerator>
 struct SetStopFlagAct : hpx::actions::make_direct_action<
   decltype(&setStopSearchFlag<Space, Node, Bound, Enumerator>), &setStopSearchFlag<Space, Node, Bound, Enumerator>, SetStopFlagAct<Space, Node, Bound, Enumerator> >::type {};
 
+// Decision search success: stop searching and throw away (by running to completion) everything
+// queued on this locality
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+void stopAndCancel() {
+  Registry<Space, Node, Bound, Enumerator>::gReg->setStopSearchFlag();
+  Workstealing::Scheduler::cancelWork();
+}
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+struct StopAndCancelAct : hpx::actions::make_action<
+  decltype(&stopAndCancel<Space, Node, Bound, Enumerator>), &stopAndCancel<Space, Node, Bound, Enumerator>, StopAndCancelAct<Space, Node, Bound, Enumerator> >::type {};
+
+// stopAndCancel for search id only. If that search hasn't initialised its registry here yet the
+// stop is kept for when it does, rather than being cleared by the initialisation.
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+void stopAndCancelSearch(const std::uint64_t id) {
+  auto reg = Registry<Space, Node, Bound, Enumerator>::gReg;
+  reg->stopSearchId.store(id);
+  if (currentSearchId() == id) {
+    reg->setStopSearchFlag();
+    Workstealing::Scheduler::cancelWork();
+  }
+}
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+struct StopAndCancelSearchAct : hpx::actions::make_action<
+  decltype(&stopAndCancelSearch<Space, Node, Bound, Enumerator>), &stopAndCancelSearch<Space, Node, Bound, Enumerator>, StopAndCancelSearchAct<Space, Node, Bound, Enumerator> >::type {};
+
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+bool stopObserved() {
+  return Registry<Space, Node, Bound, Enumerator>::gReg->stopObserved.load();
+}
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+struct StopObservedAct : hpx::actions::make_action<
+  decltype(&stopObserved<Space, Node, Bound, Enumerator>), &stopObserved<Space, Node, Bound, Enumerator>, StopObservedAct<Space, Node, Bound, Enumerator> >::type {};
+
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+void setCheckpointing(bool on) {
+  Registry<Space, Node, Bound, Enumerator>::gReg->checkpointing.store(on);
+}
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+struct SetCheckpointingAct : hpx::actions::make_direct_action<
+  decltype(&setCheckpointing<Space, Node, Bound, Enumerator>), &setCheckpointing<Space, Node, Bound, Enumerator>, SetCheckpointingAct<Space, Node, Bound, Enumerator> >::type {};
+
+// Hand over (and forget) the work recorded on this locality by the last checkpoint
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+std::vector<CheckpointTask<Node> > takeCheckpointTasks() {
+  auto reg = Registry<Space, Node, Bound, Enumerator>::gReg;
+  std::lock_guard<hpx::lcos::local::mutex> l(reg->checkpointMtx);
+  std::vector<CheckpointTask<Node> > res;
+  res.swap(reg->checkpointTasks);
+  return res;
+}
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+struct TakeCheckpointTasksAct : hpx::actions::make_action<
+  decltype(&takeCheckpointTasks<Space, Node, Bound, Enumerator>), &takeCheckpointTasks<Space, Node, Bound, Enumerator>, TakeCheckpointTasksAct<Space, Node, Bound, Enumerator> >::type {};
+
 template <typename Space, typename Node, typename Bound, typename Enumerator, typename Cmp>
 void updateRegistryBound(Bound bnd) {
   auto reg = Registry<Space, Node, Bound, Enumerator>::gReg;
@@ -147,6 +428,11 @@ struct action_stacksize<YewPar::InitRegistryAct<Space, Node, Bound, Enumerator>
   enum { value = threads::thread_stacksize_huge };
 };
 
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+struct action_stacksize<YewPar::InitRegistryTreeAct<Space, Node, Bound, Enumerator> > {
+  enum { value = threads::thread_stacksize_huge };
+};
+
 template <typename Space, typename Node, typename Bound, typename Enumerator>
 struct action_stacksize<YewPar::SetFoundPromiseIdAct<Space, Node, Bound, Enumerator> > {
   enum { value = threads::thread_stacksize_huge };
@@ -167,11 +453,31 @@ struct action_stacksize<YewPar::SetStopFlagAct<Space, Node, Bound, Enumerator> >
   enum { value = threads::thread_stacksize_huge };
 };
 
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+struct action_stacksize<YewPar::StopAndCancelAct<Space, Node, Bound, Enumerator> > {
+  enum { value = threads::thread_stacksize_huge };
+};
+
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+struct action_stacksize<YewPar::StopAndCancelSearchAct<Space, Node, Bound, Enumerator> > {
+  enum { value = threads::thread_stacksize_huge };
+};
+
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+struct action_stacksize<YewPar::TakeCheckpointTasksAct<Space, Node, Bound, Enumerator> > {
+  enum { value = threads::thread_stacksize_huge };
+};
+
 template <typename Space, typename Node, typename Bound, typename Enumerator>
 struct action_stacksize<YewPar::GetEnumeratorValAct<Space, Node, Bound, Enumerator> > {
   enum { value = threads::thread_stacksize_huge };
 };
 
+template <typename Space, typename Node, typename Bound, typename Enumerator>
+struct action_stacksize<YewPar::ReduceEnumeratorsAct<Space, Node, Bound, Enumerator> > {
+  enum { value = threads::thread_stacksize_huge };
+};
+
 }}
 
 #endif
@@ -0,0 +1,60 @@
+#include "RuntimeOptions.hpp"
+
+#include <cstdlib>
+
+#include <hpx/runtime/config_entry.hpp>
+
+namespace YewPar { namespace util { namespace RuntimeOptions {
+
+boost::program_options::options_description options() {
+  boost::program_options::options_description desc("YewPar options");
+  desc.add_options()
+    ( "yewpar:schedulers",
+      boost::program_options::value<unsigned>()->default_value(0),
+      "Schedulers each locality runs (0: one per worker thread less one for the thread driving the search)"
+    )
+    ("yewpar:reserve-core", "Keep worker thread 0 free of schedulers for communication and IO")
+    ( "yewpar:pin",
+      boost::program_options::value<std::string>(),
+      "Worker thread to core binding: compact, scatter, balanced, numa-balanced or none (as --hpx:bind)"
+    )
+    ( "yewpar:victims",
+      boost::program_options::value<unsigned>()->default_value(0),
+      "Remote steal victims each locality keeps, a random sample on larger clusters (0: all localities)"
+    )
+    ( "yewpar:huge-pages",
+      boost::program_options::value<std::string>()->default_value("none"),
+      "Back search stacks and task pools with 2 MB pages: none, transparent or explicit (falls back to transparent)"
+    );
+  return desc;
+}
+
+Translated translate(int argc, char* argv[]) {
+  boost::program_options::variables_map opts;
+  boost::program_options::store(boost::program_options::command_line_parser(argc, argv)
+                                .options(options()).allow_unregistered().run(), opts);
+
+  Translated res;
+  res.config.push_back("yewpar.schedulers=" + std::to_string(opts["yewpar:schedulers"].as<unsigned>()));
+  res.config.push_back("yewpar.victims=" + std::to_string(opts["yewpar:victims"].as<unsigned>()));
+  res.config.push_back("yewpar.huge_pages=" + opts["yewpar:huge-pages"].as<std::string>());
+  res.config.push_back(std::string("yewpar.reserve_core=") + (opts.count("yewpar:reserve-core") ? "1" : "0"));
+  if (opts.count("yewpar:pin")) {
+    res.hpxArgs.push_back("--hpx:bind=" + opts["yewpar:pin"].as<std::string>());
+  }
+  return res;
+}
+
+const Settings & get() {
+  static const Settings settings = []() {
+    Settings s;
+    s.schedulers = std::strtoul(hpx::get_config_entry("yewpar.schedulers", "0").c_str(), nullptr, 10);
+    s.reserveCore = hpx::get_config_entry("yewpar.reserve_core", "0") == "1";
+    s.victims = std::strtoul(hpx::get_config_entry("yewpar.victims", "0").c_str(), nullptr, 10);
+    s.hugePages = hpx::get_config_entry("yewpar.huge_pages", "none");
+    return s;
+  }();
+  return settings;
+}
+
+}}}
@@ -0,0 +1,49 @@
+#ifndef YEWPAR_RUNTIME_OPTIONS_HPP
+#define YEWPAR_RUNTIME_OPTIONS_HPP
+
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+// YewPar's own command line options (--yewpar:*), which every application accepts alongside the
+// HPX ones through YewPar::init:
+//
+//   --yewpar:schedulers n  schedulers each locality runs (0, the default, is one per worker thread
+//                          less one for the thread driving the search)
+//   --yewpar:reserve-core  ask for worker thread 0 to be kept free of schedulers, for parcel
+//                          handling, IO and the thread driving the search. Best effort: schedulers
+//                          are only hinted onto the other workers, and HPX may still run them (or
+//                          tasks they spawn, or stolen HPX threads) on thread 0
+//   --yewpar:pin policy    worker thread to core binding, passed on as --hpx:bind (compact,
+//                          scatter, balanced, numa-balanced or none)
+//   --yewpar:victims n     remote steal victims each locality keeps (0, the default, is all of
+//                          them), see workstealing/VictimLists.hpp
+//   --yewpar:huge-pages m  back stacks and task pools with 2 MB pages (none, the default,
+//                          transparent or explicit), see util/HugePages.hpp
+//
+// The options become yewpar.* runtime configuration entries, so every locality (and, unlike the
+// application's variables_map, more than just the one running hpx_main) reads the same settings.
+namespace YewPar { namespace util { namespace RuntimeOptions {
+
+boost::program_options::options_description options();
+
+// The configuration entries and extra HPX arguments for the YewPar options in argv
+struct Translated {
+  std::vector<std::string> config;
+  std::vector<std::string> hpxArgs;
+};
+Translated translate(int argc, char* argv[]);
+
+// This locality's settings, read from its runtime configuration on first use
+struct Settings {
+  unsigned schedulers = 0;
+  bool reserveCore = false;
+  unsigned victims = 0;
+  std::string hugePages = "none";
+};
+const Settings & get();
+
+}}}
+
+#endif
@@ -0,0 +1,42 @@
+#include "SearchContext.hpp"
+
+#include <atomic>
+
+#include <hpx/lcos/broadcast.hpp>
+#include <hpx/lcos/wait_all.hpp>
+#include <hpx/runtime/find_all_localities.hpp>
+
+namespace Workstealing { namespace Scheduler {
+extern std::atomic<bool> running;
+}}
+
+namespace YewPar {
+
+namespace {
+
+// Serialises searches started from this process
+hpx::lcos::local::mutex searchMtx;
+std::uint64_t nextSearchId = 0;
+
+// The search this locality is running, see currentSearchId
+std::atomic<std::uint64_t> activeSearchId(0);
+
+}
+
+SearchContext::SearchContext() : lock(searchMtx) {
+  searchId = ++nextSearchId;
+  hpx::wait_all(hpx::lcos::broadcast<beginSearch_act>(hpx::find_all_localities(), searchId));
+}
+
+std::uint64_t currentSearchId() {
+  return activeSearchId.load(std::memory_order_relaxed);
+}
+
+void beginSearch(std::uint64_t id) {
+  activeSearchId.store(id);
+
+  // The previous search stopped the schedulers
+  Workstealing::Scheduler::running.store(true);
+}
+
+}
@@ -0,0 +1,42 @@
+#ifndef YEWPAR_SEARCH_CONTEXT_HPP
+#define YEWPAR_SEARCH_CONTEXT_HPP
+
+#include <cstdint>
+#include <mutex>
+
+#include <hpx/lcos/local/mutex.hpp>
+#include <hpx/runtime/actions/plain_action.hpp>
+
+// Lets one HPX runtime run many searches, e.g. thousands of small instances from one job.
+//
+// Each parallel skeleton's search() holds a SearchContext. Concurrent search() calls in the same
+// process queue up behind each other, since the schedulers and policy are per locality. Every
+// search gets a fresh id, broadcast to all localities before the registries are initialised, and
+// per-search state (scheduler flags, registries) is reset for it. Asynchronous messages carry the
+// id so anything left over from the previous search, such as a late bound update, is ignored.
+namespace YewPar {
+
+class SearchContext {
+ private:
+  std::unique_lock<hpx::lcos::local::mutex> lock;
+  std::uint64_t searchId;
+
+ public:
+  SearchContext();
+
+  SearchContext(const SearchContext &) = delete;
+  SearchContext & operator=(const SearchContext &) = delete;
+
+  std::uint64_t id() const { return searchId; }
+};
+
+// Id of the search currently running on this locality
+std::uint64_t currentSearchId();
+
+// Prepare this locality for a new search
+void beginSearch(std::uint64_t id);
+HPX_DEFINE_PLAIN_ACTION(beginSearch, beginSearch_act);
+
+}
+
+#endif
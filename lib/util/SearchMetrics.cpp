@@ -0,0 +1,137 @@
+#include "SearchMetrics.hpp"
+
+#include <hpx/include/iostreams.hpp>
+#include <hpx/performance_counters/manage_counter_type.hpp>
+#include <hpx/runtime/get_locality_id.hpp>
+
+#include <boost/format.hpp>
+
+#include "PerWorker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace YewPar { namespace util { namespace SearchMetrics {
+
+namespace {
+
+// Counted per worker thread, this is hit for every node
+struct Counts {
+  std::atomic<std::uint64_t> processed;
+  std::atomic<std::uint64_t> pruned;
+  std::atomic<std::uint64_t> levelPruned;
+  std::atomic<std::uint64_t> depth[histogramDepth];
+
+  Counts() {
+    clear();
+  }
+
+  void clear() {
+    processed.store(0);
+    pruned.store(0);
+    levelPruned.store(0);
+    for (auto & d : depth) {
+      d.store(0);
+    }
+  }
+};
+
+PerWorker<Counts> counts;
+
+Counts & myCounts() {
+  return counts.mine();
+}
+
+template <std::atomic<std::uint64_t> Counts::* field>
+std::uint64_t total(bool reset) {
+  std::uint64_t sum = 0;
+  counts.forEach([&](Counts & c) {
+      sum += reset ? (c.*field).exchange(0) : (c.*field).load();
+    });
+  return sum;
+}
+
+// Up to the deepest non empty bucket
+std::vector<std::int64_t> histogram(bool reset) {
+  std::vector<std::int64_t> h(histogramDepth, 0);
+  counts.forEach([&](Counts & c) {
+      for (unsigned d = 0; d < histogramDepth; ++d) {
+        h[d] += reset ? c.depth[d].exchange(0) : c.depth[d].load();
+      }
+    });
+  while (!h.empty() && h.back() == 0) {
+    h.pop_back();
+  }
+  return h;
+}
+
+}
+
+void processed(std::uint64_t n) {
+  myCounts().processed.fetch_add(n, std::memory_order_relaxed);
+}
+
+void pruned() {
+  myCounts().pruned.fetch_add(1, std::memory_order_relaxed);
+}
+
+void levelPruned() {
+  myCounts().levelPruned.fetch_add(1, std::memory_order_relaxed);
+}
+
+void visited(unsigned depth, std::uint64_t n) {
+  myCounts().depth[std::min(depth, histogramDepth - 1)].fetch_add(n, std::memory_order_relaxed);
+}
+
+void reset() {
+  counts.forEach([](Counts & c) { c.clear(); });
+}
+
+void printReport() {
+  auto h = histogram(false);
+  std::string depths;
+  for (unsigned d = 0; d < h.size(); ++d) {
+    if (h[d] != 0) {
+      depths += (boost::format(" %1%:%2%") % d % h[d]).str();
+    }
+  }
+
+  hpx::cout
+      << (boost::format("%1% Search Metrics: %2% nodes processed, %3% pruned, %4% levels pruned, children by depth:%5%")
+          % static_cast<std::int64_t>(hpx::get_locality_id())
+          % total<&Counts::processed>(false)
+          % total<&Counts::pruned>(false)
+          % total<&Counts::levelPruned>(false)
+          % depths)
+      << hpx::endl;
+}
+
+void registerPerformanceCounters() {
+  hpx::performance_counters::install_counter_type(
+      "/yewpar/nodes/processed",
+      &total<&Counts::processed>,
+      "Returns the number of nodes processed (and not pruned) on this locality"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/yewpar/nodes/pruned",
+      &total<&Counts::pruned>,
+      "Returns the number of nodes pruned on this locality"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/yewpar/nodes/levelPruned",
+      &total<&Counts::levelPruned>,
+      "Returns the number of levels cut short by PruneLevel on this locality"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/yewpar/nodes/depthHistogram",
+      &histogram,
+      "Returns the number of children considered at each depth on this locality"
+                                                  );
+}
+
+}}}
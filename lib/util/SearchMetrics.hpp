@@ -0,0 +1,38 @@
+#ifndef YEWPAR_SEARCH_METRICS_HPP
+#define YEWPAR_SEARCH_METRICS_HPP
+
+#include <cstdint>
+
+#include <hpx/runtime/actions/plain_action.hpp>
+
+// Search progress counters for API::Metrics (and any Verbose_ level).
+//
+// ProcessNode counts, per worker thread, the nodes it lets through, the nodes it prunes on the bound
+// (or the memo table), the levels it cuts short with PruneLevel and the children considered at each
+// depth. Nothing is counted, or compiled in, for skeletons without Metrics or Verbose_. The totals
+// are /yewpar/* performance counters, so a running search can be watched with --hpx:print-counter.
+namespace YewPar { namespace util { namespace SearchMetrics {
+
+// Children deeper than this share the last histogram bucket
+constexpr unsigned histogramDepth = 128;
+
+void processed(std::uint64_t n = 1);
+void pruned();
+void levelPruned();
+
+// n children considered at depth (the root is depth 1)
+void visited(unsigned depth, std::uint64_t n = 1);
+
+// Zero the counts for a new search, must run on every locality
+void reset();
+HPX_DEFINE_PLAIN_ACTION(reset, reset_act);
+
+// Print this locality's counts for the last search
+void printReport();
+HPX_DEFINE_PLAIN_ACTION(printReport, printReport_act);
+
+void registerPerformanceCounters();
+
+}}}
+
+#endif
@@ -0,0 +1,183 @@
+#include "SolutionSink.hpp"
+
+#include <hpx/lcos/async.hpp>
+#include <hpx/lcos/broadcast.hpp>
+#include <hpx/lcos/future.hpp>
+#include <hpx/lcos/local/condition_variable.hpp>
+#include <hpx/lcos/local/mutex.hpp>
+#include <hpx/lcos/wait_all.hpp>
+#include <hpx/runtime/find_all_localities.hpp>
+#include <hpx/runtime/get_locality_id.hpp>
+#include <hpx/runtime/get_os_thread_count.hpp>
+#include <hpx/runtime/get_worker_thread_num.hpp>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace YewPar { namespace util { namespace SolutionSink {
+
+namespace {
+
+std::atomic<bool> streaming(false);
+std::atomic<std::uint64_t> written(0);
+
+Consumer consumer;
+std::ofstream out;
+
+// Only touched by their worker while streaming
+struct alignas(64) WorkerBuffer {
+  std::vector<char> bytes;
+};
+std::unique_ptr<WorkerBuffer[]> buffers;
+std::size_t numBuffers = 0;
+
+// Full buffers waiting for the writer. pendingBytes includes the one being written.
+hpx::lcos::local::mutex mtx;
+hpx::lcos::local::condition_variable notEmpty;
+hpx::lcos::local::condition_variable notFull;
+std::deque<std::vector<char> > pending;
+std::uint64_t pendingBytes = 0;
+std::uint64_t maxPending = 0;
+bool closing = false;
+hpx::future<void> writer;
+
+void submit(std::vector<char> && buf) {
+  std::unique_lock<hpx::lcos::local::mutex> l(mtx);
+  notFull.wait(l, [&]() { return maxPending == 0 || pendingBytes < maxPending || closing; });
+  pendingBytes += buf.size();
+  pending.push_back(std::move(buf));
+  l.unlock();
+  notEmpty.notify_one();
+}
+
+void runWriter() {
+  std::unique_lock<hpx::lcos::local::mutex> l(mtx);
+  while (true) {
+    notEmpty.wait(l, [&]() { return !pending.empty() || closing; });
+    if (pending.empty()) {
+      return;
+    }
+
+    auto buf = std::move(pending.front());
+    pending.pop_front();
+    l.unlock();
+
+    if (consumer && !out.is_open()) {
+      consumer(buf.data(), buf.size());
+    } else {
+      out.write(buf.data(), buf.size());
+    }
+
+    l.lock();
+    pendingBytes -= buf.size();
+    notFull.notify_all();
+  }
+}
+
+void append(std::vector<char> & buf, const char * data, std::uint32_t size) {
+  auto at = buf.size();
+  buf.resize(at + sizeof(size) + size);
+  std::memcpy(buf.data() + at, &size, sizeof(size));
+  std::memcpy(buf.data() + at + sizeof(size), data, size);
+}
+
+}
+
+void setConsumer(Consumer c) {
+  consumer = std::move(c);
+}
+
+void open(std::string file, std::uint64_t maxPendingBytes) {
+  if (!file.empty()) {
+    file += "." + std::to_string(hpx::get_locality_id());
+    out.open(file, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      throw std::runtime_error("Could not open solutions " + file);
+    }
+  } else if (!consumer) {
+    throw std::runtime_error("SolutionSink: no file given and no consumer set");
+  }
+
+  numBuffers = hpx::get_os_thread_count();
+  buffers.reset(new WorkerBuffer[numBuffers]);
+  for (auto i = 0u; i < numBuffers; ++i) {
+    buffers[i].bytes.reserve(chunkBytes);
+  }
+
+  pendingBytes = 0;
+  maxPending = maxPendingBytes;
+  closing = false;
+  written.store(0);
+  writer = hpx::async(&runWriter);
+  streaming.store(true);
+}
+
+std::uint64_t close() {
+  streaming.store(false);
+  for (auto i = 0u; i < numBuffers; ++i) {
+    if (!buffers[i].bytes.empty()) {
+      submit(std::move(buffers[i].bytes));
+    }
+  }
+  buffers.reset();
+  numBuffers = 0;
+
+  {
+    std::lock_guard<hpx::lcos::local::mutex> l(mtx);
+    closing = true;
+  }
+  notEmpty.notify_all();
+  notFull.notify_all();
+  writer.get();
+
+  if (out.is_open()) {
+    out.close();
+    if (!out) {
+      throw std::runtime_error("Could not write solutions");
+    }
+  }
+  return written.load();
+}
+
+void begin(const std::string & file, unsigned maxPendingMB) {
+  hpx::wait_all(hpx::lcos::broadcast<open_act>(
+      hpx::find_all_localities(), file, static_cast<std::uint64_t>(maxPendingMB) << 20));
+}
+
+std::uint64_t end() {
+  std::uint64_t total = 0;
+  for (auto n : hpx::lcos::broadcast<close_act>(hpx::find_all_localities()).get()) {
+    total += n;
+  }
+  return total;
+}
+
+bool enabled() {
+  return streaming.load(std::memory_order_relaxed);
+}
+
+void write(const char * data, std::uint32_t size) {
+  written.fetch_add(1, std::memory_order_relaxed);
+
+  auto me = hpx::get_worker_thread_num();
+  if (me >= numBuffers) {
+    std::vector<char> buf;
+    append(buf, data, size);
+    submit(std::move(buf));
+    return;
+  }
+
+  auto & buf = buffers[me].bytes;
+  append(buf, data, size);
+  if (buf.size() >= chunkBytes) {
+    // Swapped out before we (maybe) wait, other tasks on this worker carry on with a fresh buffer
+    std::vector<char> full;
+    full.reserve(chunkBytes);
+    full.swap(buf);
+    submit(std::move(full));
+  }
+}
+
+}}}
@@ -0,0 +1,124 @@
+#ifndef YEWPAR_SOLUTION_SINK_HPP
+#define YEWPAR_SOLUTION_SINK_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <hpx/runtime/actions/plain_action.hpp>
+#include <hpx/runtime/serialization/input_archive.hpp>
+#include <hpx/runtime/serialization/output_archive.hpp>
+#include <hpx/runtime/serialization/serialize.hpp>
+#include <hpx/util/function.hpp>
+
+// Streaming every solution of an enumeration (API::SolutionSink).
+//
+// Enumerators reduce to one value, so listing all solutions through one means holding them all in
+// memory until the search ends. The SolutionSinkEnumerator instead serialises each solution into a
+// buffer of the worker that found it, and full buffers (of chunkBytes) are handed to a writer task on
+// the locality, which appends them to that locality's file (or passes them to a consumer). Only the
+// number of solutions goes through the Registry.
+//
+// Workers finding solutions faster than they can be written wait once maxPendingMB of full buffers
+// are queued on their locality, so memory stays bounded however many solutions there are.
+//
+//   util::SolutionSink::begin("embeddings");  // embeddings.0, embeddings.1, ... one per locality
+//   auto n = DepthBounded<Gen, Enumeration, SolutionSink<Node, IsEmbedding> >::search(space, root);
+//   util::SolutionSink::end();
+//
+// Files hold a sequence of records, a std::uint32_t length and that many bytes of the serialised
+// node, readable with readFile. Solutions found outside begin/end are only counted.
+namespace YewPar { namespace util { namespace SolutionSink {
+
+constexpr std::size_t chunkBytes = 1 << 16;
+
+// Receives full buffers of records on the locality's writer task, in place of the file
+using Consumer = hpx::util::function<void(const char * data, std::size_t size), false>;
+
+// Use consumer instead of a file on this locality for searches begun with an empty file name. Has
+// to be set on every locality, e.g. from a startup function.
+void setConsumer(Consumer consumer);
+
+// Start streaming on this locality (maxPendingBytes 0 for no limit), must run on every locality
+void open(std::string file, std::uint64_t maxPendingBytes);
+HPX_DEFINE_PLAIN_ACTION(open, open_act);
+
+// Write out everything buffered and stop, returning the number of solutions written. Only once no
+// more solutions can be found.
+std::uint64_t close();
+HPX_DEFINE_PLAIN_ACTION(close, close_act);
+
+// Stream to file.<locality id> (or the consumers if file is empty) on all localities
+void begin(const std::string & file, unsigned maxPendingMB = 64);
+
+// Close the sinks of all localities, returning the number of solutions written in total
+std::uint64_t end();
+
+bool enabled();
+
+// Append one record, waiting if the locality is over maxPendingBytes
+void write(const char * data, std::uint32_t size);
+
+template <typename Node>
+void put(const Node & n) {
+  static thread_local std::vector<char> scratch;
+  std::size_t size;
+  {
+    hpx::serialization::output_archive ar(scratch);
+    ar << n;
+    size = ar.bytes_written();
+  }
+  write(scratch.data(), static_cast<std::uint32_t>(size));
+}
+
+// Call fn on every node stored in file
+template <typename Node, typename Fn>
+void readFile(const std::string & file, Fn && fn) {
+  std::ifstream in(file, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("Could not open solutions " + file);
+  }
+
+  std::vector<char> buf;
+  std::uint32_t size;
+  while (in.read(reinterpret_cast<char *>(&size), sizeof(size))) {
+    buf.resize(size);
+    if (!in.read(buf.data(), size)) {
+      throw std::runtime_error("Truncated record in solutions " + file);
+    }
+    hpx::serialization::input_archive ar(buf, size);
+    Node n;
+    ar >> n;
+    fn(n);
+  }
+}
+
+}}
+
+// Enumerator streaming every node for which IsSolution()(node, depth) holds (see above). get() is
+// the number of them.
+template <typename NodeType, typename IsSolution>
+struct SolutionSinkEnumerator {
+  using ResT = std::uint64_t;
+  std::uint64_t count = 0;
+
+  void accumulate(const NodeType & n, const unsigned depth) {
+    if (IsSolution()(n, depth)) {
+      if (util::SolutionSink::enabled()) {
+        util::SolutionSink::put(n);
+      }
+      ++count;
+    }
+  }
+
+  void combine(const ResT & other) { count += other; }
+
+  ResT get() { return count; }
+};
+
+}
+
+#endif
@@ -0,0 +1,164 @@
+#include "TaskPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+#include "HugePages.hpp"
+
+namespace YewPar { namespace util { namespace TaskPool {
+
+namespace {
+
+constexpr std::size_t blockUnit = 64;
+constexpr std::size_t numClasses = maxPooledBytes / blockUnit;
+
+// Each slab is around this big, or a single block for the largest classes
+constexpr std::size_t slabBytes = 64 * 1024;
+
+// With huge pages, slabs are cut from chunks of a whole huge page
+constexpr std::size_t chunkBytes = HugePages::pageBytes - HugePages::headerBytes;
+
+struct Cache;
+
+// In front of every block, keeping what follows max_align_t aligned. Unpooled blocks have no owner.
+struct alignas(std::max_align_t) Header {
+  Cache * owner;
+  std::uint32_t cls;
+};
+
+struct FreeBlock {
+  FreeBlock * next;
+};
+
+struct Cache {
+  FreeBlock * local[numClasses] = {};
+  // Blocks of this cache freed by other threads
+  std::atomic<FreeBlock *> remote[numClasses];
+  std::size_t carved = 0;
+  std::size_t free = 0;
+  char * chunk = nullptr;
+  std::size_t chunkLeft = 0;
+
+  Cache() {
+    for (auto & r : remote) {
+      r.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+};
+
+// Never freed: blocks can be released on other threads after their owner has exited
+Cache & myCache() {
+  static thread_local Cache * cache = new Cache();
+  return *cache;
+}
+
+std::size_t blockBytes(const std::uint32_t cls) {
+  return (cls + 1) * blockUnit;
+}
+
+// Memory for a new slab. With huge pages (see HugePages.hpp) it comes from the thread's current
+// chunk, so the tasks a thread allocates share a few TLB entries. Chunks are kept like slabs are.
+char * slabMemory(Cache & c, const std::size_t bytes) {
+  if (HugePages::mode() == HugePages::Off) {
+    return static_cast<char *>(::operator new(bytes));
+  }
+
+  if (c.chunkLeft < bytes) {
+    c.chunk = static_cast<char *>(HugePages::allocate(chunkBytes));
+    c.chunkLeft = chunkBytes;
+  }
+  auto p = c.chunk;
+  c.chunk += bytes;
+  c.chunkLeft -= bytes;
+  return p;
+}
+
+FreeBlock * carveSlab(Cache & c, const std::uint32_t cls) {
+  auto size = blockBytes(cls);
+  auto n = std::max<std::size_t>(1, slabBytes / size);
+  auto slab = slabMemory(c, n * size);
+
+  FreeBlock * head = nullptr;
+  for (auto i = n; i > 0; --i) {
+    auto b = reinterpret_cast<FreeBlock *>(slab + (i - 1) * size);
+    b->next = head;
+    head = b;
+  }
+  c.carved += n;
+  c.free += n;
+  return head;
+}
+
+std::size_t length(FreeBlock * b) {
+  std::size_t n = 0;
+  for (; b; b = b->next) {
+    ++n;
+  }
+  return n;
+}
+
+}
+
+void * allocate(const std::size_t bytes) {
+  auto total = bytes + sizeof(Header);
+  if (total > maxPooledBytes) {
+    auto h = static_cast<Header *>(::operator new(total));
+    h->owner = nullptr;
+    return h + 1;
+  }
+
+  auto cls = static_cast<std::uint32_t>((total - 1) / blockUnit);
+  auto & c = myCache();
+  auto & list = c.local[cls];
+  if (!list) {
+    list = c.remote[cls].exchange(nullptr, std::memory_order_acquire);
+    c.free += length(list);
+  }
+  if (!list) {
+    list = carveSlab(c, cls);
+  }
+
+  auto b = list;
+  list = b->next;
+  --c.free;
+
+  auto h = reinterpret_cast<Header *>(b);
+  h->owner = &c;
+  h->cls = cls;
+  return h + 1;
+}
+
+void deallocate(void * p) {
+  auto h = static_cast<Header *>(p) - 1;
+  auto owner = h->owner;
+  if (!owner) {
+    ::operator delete(h);
+    return;
+  }
+
+  auto cls = h->cls;
+  auto b = reinterpret_cast<FreeBlock *>(h);
+  auto & c = myCache();
+  if (owner == &c) {
+    b->next = c.local[cls];
+    c.local[cls] = b;
+    ++c.free;
+    return;
+  }
+
+  // Only ever pushed here and taken all at once by the owner, so there is no ABA to worry about
+  auto & remote = owner->remote[cls];
+  b->next = remote.load(std::memory_order_relaxed);
+  while (!remote.compare_exchange_weak(b->next, b, std::memory_order_release, std::memory_order_relaxed)) {}
+}
+
+std::size_t slabBlocks() {
+  return myCache().carved;
+}
+
+std::size_t freeBlocks() {
+  return myCache().free;
+}
+
+}}}
@@ -0,0 +1,113 @@
+#ifndef YEWPAR_TASK_POOL_HPP
+#define YEWPAR_TASK_POOL_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <hpx/runtime/serialization/serialize.hpp>
+
+// Pooled storage for spawned tasks.
+//
+// A spawn binds the task's node, depth and promise into a closure, which is too big for
+// hpx::util::function's inline buffer, so every spawn used to malloc (and every finished task
+// free) on whichever workers ran them, all contending in the allocator. Closures wrapped in
+// pooledTask instead live in blocks from per OS thread free lists: a thread allocates from its own
+// list, carving new slabs when it runs dry, and a block freed on another thread is pushed back onto
+// a lock-free list of the thread that allocated it, which takes those back in one go when its own
+// list is empty. Blocks come in multiples of 64 bytes up to maxPooledBytes, anything bigger goes to
+// the allocator as before.
+//
+// Slabs are kept for the life of the process, so a locality holds on to its high-water mark of
+// queued tasks, the same memory the allocator would otherwise have been asked for over and over.
+// With --yewpar:huge-pages they are cut from 2 MB pages (see HugePages.hpp).
+namespace YewPar { namespace util { namespace TaskPool {
+
+constexpr std::size_t maxPooledBytes = 4096;
+
+// Storage for bytes bytes, aligned for any type
+void * allocate(std::size_t bytes);
+void deallocate(void * p);
+
+// Blocks this thread has carved from slabs, and those of them in its own free lists
+std::size_t slabBlocks();
+std::size_t freeBlocks();
+
+// A T in pooled storage. Copies copy the T into a new block, serialisation sends the T itself and
+// the receiving side gets a block of its own.
+template <typename T>
+class Pooled {
+  static_assert(alignof(T) <= alignof(std::max_align_t), "Pooled blocks are only max_align_t aligned");
+
+ public:
+  Pooled() : p(nullptr) {}
+
+  explicit Pooled(T x) : p(new (allocate(sizeof(T))) T(std::move(x))) {}
+
+  Pooled(const Pooled & other) : p(other.p ? new (allocate(sizeof(T))) T(*other.p) : nullptr) {}
+  Pooled(Pooled && other) noexcept : p(other.p) { other.p = nullptr; }
+
+  Pooled & operator=(Pooled other) noexcept {
+    std::swap(p, other.p);
+    return *this;
+  }
+
+  ~Pooled() { reset(); }
+
+  T & operator*() const { return *p; }
+  T * operator->() const { return p; }
+  explicit operator bool() const { return p != nullptr; }
+
+ private:
+  void reset() {
+    if (p) {
+      p->~T();
+      deallocate(p);
+      p = nullptr;
+    }
+  }
+
+  friend class hpx::serialization::access;
+
+  template <class Archive>
+  void save(Archive & ar, const unsigned int version) const {
+    ar & *p;
+  }
+
+  template <class Archive>
+  void load(Archive & ar, const unsigned int version) {
+    reset();
+    p = new (allocate(sizeof(T))) T();
+    ar & *p;
+  }
+
+  HPX_SERIALIZATION_SPLIT_MEMBER()
+
+  T * p;
+};
+
+// A callable F in pooled storage, small enough for hpx::util::function to hold inline
+template <typename F>
+struct PooledTask {
+  Pooled<F> f;
+
+  template <typename ...Ts>
+  void operator()(Ts && ...xs) {
+    (*f)(std::forward<Ts>(xs)...);
+  }
+
+  template <class Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & f;
+  }
+};
+
+template <typename F>
+PooledTask<std::decay_t<F> > pooledTask(F && f) {
+  return PooledTask<std::decay_t<F> > {Pooled<std::decay_t<F> >(std::forward<F>(f))};
+}
+
+}}}
+
+#endif
@@ -0,0 +1,177 @@
+#include "TaskTrace.hpp"
+
+#include <hpx/lcos/async.hpp>
+#include <hpx/lcos/broadcast.hpp>
+#include <hpx/lcos/wait_all.hpp>
+#include <hpx/runtime/find_all_localities.hpp>
+#include <hpx/runtime/get_locality_id.hpp>
+#include <hpx/runtime/naming/name.hpp>
+
+#include <boost/format.hpp>
+
+#include "PerWorker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+
+namespace YewPar { namespace util { namespace TaskTrace {
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+std::atomic<bool> tracing(false);
+clock::time_point epoch;
+
+// Written only by its worker (the shared slot is why the index is atomic), read once the search is
+// over
+struct Ring {
+  std::unique_ptr<Record[]> records;
+  std::atomic<std::uint64_t> next {0};
+};
+
+PerWorker<Ring> rings;
+std::uint32_t capacity = 0;
+
+std::uint64_t nanosSinceEpoch() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - epoch).count();
+}
+
+const char * originName(std::uint8_t o) {
+  switch (static_cast<Origin>(o)) {
+    case Origin::Root:          return "root";
+    case Origin::SpawnedLocal:  return "spawned-local";
+    case Origin::SpawnedRemote: return "spawned-remote";
+    case Origin::StolenLocal:   return "stolen-local";
+    case Origin::StolenRemote:  return "stolen-remote";
+  }
+  return "unknown";
+}
+
+void writeChromeTrace(const std::string & file, const std::vector<Record> & records) {
+  std::ofstream out(file, std::ios::trunc);
+  out << "{\"traceEvents\":[\n";
+  for (std::size_t i = 0; i < records.size(); ++i) {
+    const auto & r = records[i];
+    // Whole microseconds, as boost::format would print large doubles in exponent form. Both ends
+    // are truncated so back to back tasks still abut.
+    auto startMicros = r.start / 1000;
+    auto endMicros = r.end / 1000;
+    out << (boost::format("{\"name\":\"task\",\"cat\":\"%1%\",\"ph\":\"X\",\"ts\":%2%,\"dur\":%3%,"
+                          "\"pid\":%4%,\"tid\":%5%,\"args\":{\"depth\":%6%,\"nodes\":%7%}}%8%\n")
+            % originName(r.origin) % startMicros % (endMicros - startMicros)
+            % r.locality % r.worker % r.depth % r.nodes
+            % (i + 1 < records.size() ? "," : ""));
+  }
+  out << "]}\n";
+  if (!out) {
+    throw std::runtime_error("Could not write trace " + file);
+  }
+}
+
+void writeCSV(const std::string & file, const std::vector<Record> & records) {
+  std::ofstream out(file, std::ios::trunc);
+  out << "locality,worker,start_ns,end_ns,depth,nodes,origin\n";
+  for (const auto & r : records) {
+    out << r.locality << ',' << r.worker << ',' << r.start << ',' << r.end << ','
+        << r.depth << ',' << r.nodes << ',' << originName(r.origin) << '\n';
+  }
+  if (!out) {
+    throw std::runtime_error("Could not write trace " + file);
+  }
+}
+
+}
+
+Origin originOf(bool stolen, const hpx::naming::id_type & parent) {
+  auto remote = parent != hpx::invalid_id &&
+      hpx::naming::get_locality_id_from_id(parent) != hpx::get_locality_id();
+  if (stolen) {
+    return remote ? Origin::StolenRemote : Origin::StolenLocal;
+  }
+  return remote ? Origin::SpawnedRemote : Origin::SpawnedLocal;
+}
+
+bool enabled() {
+  return tracing.load(std::memory_order_relaxed);
+}
+
+ScopedTask::ScopedTask(unsigned depth, Origin origin)
+    : active(enabled()), depth(depth), origin(origin), start(0), startNodes(0) {
+  if (active) {
+    start = nanosSinceEpoch();
+    startNodes = detail::threadNodes();
+  }
+}
+
+ScopedTask::~ScopedTask() {
+  if (!active || !enabled()) {
+    return;
+  }
+
+  auto worker = rings.myIndex();
+  auto & ring = rings[worker];
+  auto i = ring.next.fetch_add(1, std::memory_order_relaxed);
+  ring.records[i % capacity] = Record {start, nanosSinceEpoch(), detail::threadNodes() - startNodes,
+                                       hpx::get_locality_id(), static_cast<std::uint32_t>(worker),
+                                       depth, static_cast<std::uint8_t>(origin)};
+}
+
+void reset(std::uint32_t recordsPerWorker) {
+  tracing.store(false);
+  capacity = recordsPerWorker;
+  rings.forEach([=](Ring & r) {
+      r.records.reset(recordsPerWorker > 0 ? new Record[recordsPerWorker] : nullptr);
+      r.next.store(0);
+    });
+  if (recordsPerWorker == 0) {
+    return;
+  }
+
+  epoch = clock::now();
+  tracing.store(true);
+}
+
+std::vector<Record> collect() {
+  std::vector<Record> res;
+  if (capacity == 0) {
+    return res;
+  }
+  rings.forEach([&](Ring & r) {
+      auto next = r.next.load();
+      auto n = std::min<std::uint64_t>(next, capacity);
+      for (auto k = next - n; k < next; ++k) {
+        res.push_back(r.records[k % capacity]);
+      }
+    });
+  return res;
+}
+
+void begin(const std::string & file, std::uint32_t recordsPerWorker) {
+  if (file.empty()) {
+    return;
+  }
+  hpx::wait_all(hpx::lcos::broadcast<reset_act>(hpx::find_all_localities(), recordsPerWorker));
+}
+
+void end(const std::string & file) {
+  if (file.empty()) {
+    return;
+  }
+
+  std::vector<Record> records;
+  for (const auto & l : hpx::find_all_localities()) {
+    auto r = hpx::async<collect_act>(l).get();
+    records.insert(records.end(), r.begin(), r.end());
+  }
+  hpx::wait_all(hpx::lcos::broadcast<reset_act>(hpx::find_all_localities(), 0u));
+
+  writeChromeTrace(file + ".json", records);
+  writeCSV(file + ".csv", records);
+}
+
+}}}
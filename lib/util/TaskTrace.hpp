@@ -0,0 +1,103 @@
+#ifndef YEWPAR_TASK_TRACE_HPP
+#define YEWPAR_TASK_TRACE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <hpx/runtime/actions/plain_action.hpp>
+#include <hpx/runtime/naming/id_type.hpp>
+#include <hpx/runtime/serialization/vector.hpp>
+
+// Task granularity traces (Params::traceFile).
+//
+// Skeleton task entry points open a ScopedTask, which records when the task ran, on which worker,
+// its depth, how many nodes it processed and where it came from. Records go into a fixed size ring
+// buffer per worker, so a trace keeps the last Params::traceBufferSize tasks of every worker and
+// recording never allocates or locks. While tracing is off a ScopedTask is one relaxed load.
+//
+// Nodes are counted per OS thread, so a task that suspends (e.g. waiting on a steal) may be charged
+// with nodes of tasks that ran while it was suspended.
+namespace YewPar { namespace util { namespace TaskTrace {
+
+enum class Origin : std::uint8_t {
+  Root,
+  SpawnedLocal,   // spawned on this locality
+  SpawnedRemote,  // spawned on another locality and stolen from there
+  StolenLocal,    // stolen from a running task on this locality
+  StolenRemote    // stolen from a running task on another locality
+};
+
+struct Record {
+  // ns since tracing began on the locality
+  std::uint64_t start;
+  std::uint64_t end;
+  std::uint64_t nodes;
+  std::uint32_t locality;
+  std::uint32_t worker;
+  std::uint32_t depth;
+  std::uint8_t origin;
+
+  template <class Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & start;
+    ar & end;
+    ar & nodes;
+    ar & locality;
+    ar & worker;
+    ar & depth;
+    ar & origin;
+  }
+};
+
+namespace detail {
+inline std::uint64_t & threadNodes() {
+  static thread_local std::uint64_t nodes = 0;
+  return nodes;
+}
+}
+
+// Called by ProcessNode for every node
+inline void countNodes(std::uint64_t n = 1) {
+  detail::threadNodes() += n;
+}
+
+// Spawned or stolen (from a stack), from parent's locality. Tasks with no parent promise (e.g.
+// CountTermination) are taken to be local.
+Origin originOf(bool stolen, const hpx::naming::id_type & parent);
+
+bool enabled();
+
+class ScopedTask {
+ public:
+  ScopedTask(unsigned depth, Origin origin);
+  ~ScopedTask();
+
+  ScopedTask(const ScopedTask &) = delete;
+  ScopedTask & operator=(const ScopedTask &) = delete;
+
+ private:
+  bool active;
+  unsigned depth;
+  Origin origin;
+  std::uint64_t start;
+  std::uint64_t startNodes;
+};
+
+// Start recording, keeping recordsPerWorker tasks per worker, 0 stops. Must run on every locality.
+void reset(std::uint32_t recordsPerWorker);
+HPX_DEFINE_PLAIN_ACTION(reset, reset_act);
+
+// This locality's records, oldest first per worker
+std::vector<Record> collect();
+HPX_DEFINE_PLAIN_ACTION(collect, collect_act);
+
+// Start tracing on all localities if file isn't empty
+void begin(const std::string & file, std::uint32_t recordsPerWorker);
+
+// Gather the records of all localities into file.json and file.csv and stop tracing
+void end(const std::string & file);
+
+}}}
+
+#endif
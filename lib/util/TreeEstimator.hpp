@@ -0,0 +1,185 @@
+#ifndef YEWPAR_TREE_ESTIMATOR_HPP
+#define YEWPAR_TREE_ESTIMATOR_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <hpx/lcos/async.hpp>
+#include <hpx/lcos/future.hpp>
+#include <hpx/lcos/wait_all.hpp>
+#include <hpx/include/iostreams.hpp>
+#include <hpx/runtime/find_all_localities.hpp>
+#include <hpx/runtime/get_os_thread_count.hpp>
+
+#include <boost/format.hpp>
+
+#include "skeletons/API.hpp"
+#include "NodeGenerator.hpp"
+#include "FastRandom.hpp"
+#include "workstealing/Scheduler.hpp"
+
+// Tree size estimates from random probes (Knuth, "Estimating the efficiency of backtrack programs").
+//
+// A probe walks from the root to a leaf picking a child uniformly at random. The product of the
+// branching factors seen down to depth d is an unbiased estimate of the number of nodes at depth d,
+// so averaging over probes estimates the shape of the tree without searching it. How much the
+// probes disagree tells how irregular the tree is. Probes ignore pruning (there is no incumbent
+// yet), so for B&B this is the size of the unpruned tree.
+namespace YewPar { namespace util {
+
+struct TreeEstimate {
+  // Estimated number of nodes at each depth, the root is depth 0
+  std::vector<double> nodesAtDepth;
+
+  // Coefficient of variation of the probes' tree size estimates. Around 0 for regular trees, large
+  // when most of the tree sits below a few nodes.
+  double imbalance = 0;
+
+  double totalNodes() const {
+    double n = 0;
+    for (auto x : nodesAtDepth) {
+      n += x;
+    }
+    return n;
+  }
+
+  // First depth estimated to hold at least n nodes (the deepest depth if there is none)
+  unsigned depthWith(const double n) const {
+    for (unsigned d = 0; d < nodesAtDepth.size(); ++d) {
+      if (nodesAtDepth[d] >= n) {
+        return d;
+      }
+    }
+    return nodesAtDepth.empty() ? 0 : nodesAtDepth.size() - 1;
+  }
+};
+
+namespace detail {
+
+struct ProbeSums {
+  std::vector<double> nodes;
+  double size = 0;
+  double sizeSq = 0;
+};
+
+// Probes never go below maxDepth
+template <typename Generator>
+ProbeSums runProbes(const typename Generator::Spacetype & space,
+                    const typename Generator::Nodetype & root,
+                    const unsigned probes,
+                    const unsigned maxDepth) {
+  ProbeSums sums;
+  sums.nodes.push_back(probes);
+
+  for (unsigned p = 0; p < probes; ++p) {
+    auto node = root;
+    double weight = 1;
+    double size = 1;
+    for (unsigned d = 1; d <= maxDepth; ++d) {
+      auto gen = Generator(space, node);
+      if (gen.numChildren == 0) {
+        break;
+      }
+
+      weight *= gen.numChildren;
+      size += weight;
+      if (sums.nodes.size() <= d) {
+        sums.nodes.push_back(0);
+      }
+      sums.nodes[d] += weight;
+
+      // gen isn't used again, so it may still refer to the old node
+      node = nthChild(gen, threadRandom() % gen.numChildren);
+    }
+    sums.size += size;
+    sums.sizeSq += size * size;
+  }
+  return sums;
+}
+
+}
+
+// Estimate the tree below root with probes random probes, spread over this locality's workers
+template <typename Generator>
+TreeEstimate estimateTree(const typename Generator::Spacetype & space,
+                          const typename Generator::Nodetype & root,
+                          const unsigned probes,
+                          const unsigned maxDepth) {
+  auto chunks = std::max(1u, std::min(probes, static_cast<unsigned>(hpx::get_os_thread_count())));
+
+  std::vector<hpx::future<detail::ProbeSums> > futs;
+  for (unsigned i = 0; i < chunks; ++i) {
+    auto n = probes / chunks + (i < probes % chunks ? 1 : 0);
+    futs.push_back(hpx::async([&space, &root, n, maxDepth]() {
+          return detail::runProbes<Generator>(space, root, n, maxDepth);
+        }));
+  }
+
+  detail::ProbeSums total;
+  for (auto & f : futs) {
+    auto s = f.get();
+    if (total.nodes.size() < s.nodes.size()) {
+      total.nodes.resize(s.nodes.size(), 0);
+    }
+    for (unsigned d = 0; d < s.nodes.size(); ++d) {
+      total.nodes[d] += s.nodes[d];
+    }
+    total.size += s.size;
+    total.sizeSq += s.sizeSq;
+  }
+
+  TreeEstimate est;
+  if (probes == 0) {
+    est.nodesAtDepth.push_back(1);
+    return est;
+  }
+
+  for (auto x : total.nodes) {
+    est.nodesAtDepth.push_back(x / probes);
+  }
+  auto mean = total.size / probes;
+  auto var = std::max(0.0, total.sizeSq / probes - mean * mean);
+  est.imbalance = std::sqrt(var) / mean;
+  return est;
+}
+
+// Pick spawnDepth, backtrackBudget and spawnProbability for params from an estimate of the tree
+// (Params::autoTune). Each is chosen to give every worker in the system around tasksPerWorker
+// tasks, more for irregular trees where some tasks will be far larger than others.
+template <typename Generator, bool depthLimited, typename Bound>
+TreeEstimate autoTune(const typename Generator::Spacetype & space,
+                      const typename Generator::Nodetype & root,
+                      Skeletons::API::Params<Bound> & params,
+                      const bool verbose) {
+  constexpr double tasksPerWorker = 4;
+  constexpr double maxImbalanceFactor = 8;
+  constexpr unsigned maxProbeDepth = 5000;
+
+  auto probeDepth = depthLimited ? params.maxDepth : maxProbeDepth;
+  auto est = estimateTree<Generator>(space, root, params.estimatorProbes, probeDepth);
+
+  double workers = Workstealing::Scheduler::totalWorkers();
+  auto tasks = workers * tasksPerWorker * (1 + std::min(est.imbalance, maxImbalanceFactor));
+
+  params.spawnDepth = std::max(1u, est.depthWith(tasks));
+
+  // Both spawn once per this many nodes (backtracks are close enough to nodes)
+  auto nodesPerTask = std::max(1.0, est.totalNodes() / tasks);
+  params.backtrackBudget = static_cast<unsigned>(std::min(nodesPerTask, 1e9));
+  params.spawnProbability = static_cast<unsigned>(std::min(nodesPerTask, 1e9));
+
+  if (verbose) {
+    hpx::cout << (boost::format("Tree estimate: %1% nodes, imbalance %2%, from %3% probes\n"
+                                "Auto tuned: spawnDepth %4%, backtrackBudget %5%, spawnProbability 1/%6%\n")
+                  % est.totalNodes() % est.imbalance % params.estimatorProbes
+                  % params.spawnDepth % params.backtrackBudget % params.spawnProbability)
+              << hpx::flush;
+  }
+  return est;
+}
+
+}}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef YEWPAR_WORD_DISPATCH_HPP
+#define YEWPAR_WORD_DISPATCH_HPP
+
+#include <type_traits>
+
+// Picking a bitset width at runtime for apps whose nodes hold fixed size bitsets.
+//
+// The app instantiates its search for every power of two number of words up to maxWords and calls
+//
+//   withWordsFor<maxWords>(bits, [&](auto words) {
+//     return search<decltype(words)::value>(...);
+//   });
+//
+// once it knows (e.g. from the input graph) how many bits it needs. f is called with the smallest
+// instantiated width holding bits, so small inputs don't pay, per node and per steal, for the words
+// big ones need. Inputs needing more than maxWords words get maxWords: check before dispatching.
+namespace YewPar { namespace util {
+
+template <unsigned maxWords, unsigned words = 1, typename F>
+auto withWordsFor(const unsigned bits, F && f) {
+  static_assert((maxWords & (maxWords - 1)) == 0, "maxWords must be a power of two");
+  constexpr unsigned bitsPerWord = 64;
+  if constexpr (words >= maxWords) {
+    return f(std::integral_constant<unsigned, words>());
+  } else {
+    if (bits <= words * bitsPerWord) {
+      return f(std::integral_constant<unsigned, words>());
+    }
+    return withWordsFor<maxWords, words * 2>(bits, f);
+  }
+}
+
+}}
+
+#endif
@@ -1,6 +1,10 @@
 #include "util.hpp"
 
+#include <algorithm>
+
 #include <hpx/hpx.hpp>
+#include <hpx/runtime/resource/partitioner.hpp>
+#include <hpx/runtime/threads/topology.hpp>
 
 namespace YewPar { namespace util {
 
@@ -16,4 +20,46 @@ std::vector<hpx::naming::id_type> findOtherLocalities () {
   return locs;
 }
 
+std::vector<hpx::naming::id_type> treeChildren(std::uint32_t root) {
+  auto n = hpx::get_num_localities(hpx::launch::sync);
+  auto rank = (hpx::get_locality_id() + n - root) % n;
+
+  std::vector<hpx::naming::id_type> res;
+  for (auto c : {2 * rank + 1, 2 * rank + 2}) {
+    if (c < n) {
+      res.push_back(hpx::naming::get_id_from_locality_id((c + root) % n));
+    }
+  }
+  return res;
+}
+
+namespace {
+
+// Worker -> NUMA domain, worked out once since the mapping is fixed for the run
+const std::vector<unsigned> & workerDomains() {
+  static const std::vector<unsigned> domains = []() {
+    auto const & topo = hpx::threads::get_topology();
+    auto & rp = hpx::resource::get_partitioner();
+    std::vector<unsigned> res;
+    for (std::size_t i = 0; i < hpx::get_os_thread_count(); ++i) {
+      res.push_back(topo.get_numa_node_number(rp.get_pu_num(i)));
+    }
+    return res;
+  }();
+  return domains;
+}
+
+}
+
+unsigned getNumaDomain() {
+  auto const & domains = workerDomains();
+  auto me = hpx::get_worker_thread_num();
+  return me < domains.size() ? domains[me] : 0;
+}
+
+unsigned numNumaDomains() {
+  auto const & domains = workerDomains();
+  return domains.empty() ? 1 : *std::max_element(domains.begin(), domains.end()) + 1;
+}
+
 }}
@@ -1,8 +1,11 @@
 #ifndef YEWPAR_UTIL_HPP
 #define YEWPAR_UTIL_HPP
 
+#include <cstdint>
 #include <vector>
 
+#include <hpx/lcos/async.hpp>
+#include <hpx/runtime/find_all_localities.hpp>
 #include <hpx/runtime/find_here.hpp>
 
 namespace YewPar { namespace util {
@@ -12,6 +15,26 @@ bool isColocated(hpx::naming::id_type & id);
 // Find all localities except the one the function is called on
 std::vector<hpx::naming::id_type> findOtherLocalities ();
 
+// NUMA domain (from the HPX topology) of the worker thread we are currently running on
+unsigned getNumaDomain();
+
+// Number of NUMA domains the worker threads of this locality are spread over (domains are numbered
+// from 0, so getNumaDomain() is always below this)
+unsigned numNumaDomains();
+
+// Children of this locality in a binary tree over all localities rooted at locality root. Used for
+// broadcasts and reductions that shouldn't all go through one locality.
+std::vector<hpx::naming::id_type> treeChildren(std::uint32_t root);
+
+// Run Act, an action printing a report, on every locality in turn, so each report comes out whole
+// and in locality order rather than interleaved as with a broadcast
+template <typename Act, typename... Args>
+void printOnEachLocality(const Args &... args) {
+  for (const auto & l : hpx::find_all_localities()) {
+    hpx::async<Act>(l, args...).get();
+  }
+}
+
 }}
 
 #endif
@@ -0,0 +1,134 @@
+#ifndef YEWPAR_CHASE_LEV_DEQUE_HPP
+#define YEWPAR_CHASE_LEV_DEQUE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace workstealing {
+
+// Single owner, multiple thief work-stealing deque. Follows "Correct and Efficient Work-Stealing for
+// Weak Memory Models" (Le et al. PPoPP'13). The owner pushes/pops at the bottom without locking and
+// thieves race on the top with a single CAS.
+//
+// Elements are stored as owning pointers so arbitrary (non trivially copyable) task types can be
+// used. The "owner" is whatever is running on the OS thread the deque belongs to; as an OS thread
+// only runs one HPX thread at a time, and push/pop never suspend, owner operations never overlap.
+template <typename T>
+class ChaseLevDeque {
+ private:
+  struct Array {
+    const std::int64_t size;
+    const std::int64_t mask;
+    std::unique_ptr<std::atomic<T *>[]> buf;
+
+    explicit Array(std::int64_t size) : size(size), mask(size - 1), buf(new std::atomic<T *>[size]) {}
+
+    T * get(std::int64_t i) const { return buf[i & mask].load(std::memory_order_relaxed); }
+    void put(std::int64_t i, T * x) { buf[i & mask].store(x, std::memory_order_relaxed); }
+
+    Array * grow(std::int64_t bot, std::int64_t top) const {
+      auto a = new Array(size * 2);
+      for (auto i = top; i < bot; ++i) {
+        a->put(i, get(i));
+      }
+      return a;
+    }
+  };
+
+  alignas(64) std::atomic<std::int64_t> top;
+  alignas(64) std::atomic<std::int64_t> bottom;
+  std::atomic<Array *> array;
+
+  // Thieves may still be reading from old arrays so we only free them when the deque is destroyed
+  std::vector<std::unique_ptr<Array> > garbage;
+
+ public:
+  explicit ChaseLevDeque(std::int64_t initialSize = 1024) : top(0), bottom(0) {
+    garbage.emplace_back(new Array(initialSize));
+    array.store(garbage.back().get(), std::memory_order_relaxed);
+  }
+
+  ~ChaseLevDeque() {
+    auto b = bottom.load(std::memory_order_relaxed);
+    auto t = top.load(std::memory_order_relaxed);
+    auto a = array.load(std::memory_order_relaxed);
+    for (auto i = t; i < b; ++i) {
+      delete a->get(i);
+    }
+  }
+
+  ChaseLevDeque(const ChaseLevDeque &) = delete;
+  ChaseLevDeque & operator=(const ChaseLevDeque &) = delete;
+
+  // Owner only
+  void push(std::unique_ptr<T> x) {
+    auto b = bottom.load(std::memory_order_relaxed);
+    auto t = top.load(std::memory_order_acquire);
+    auto a = array.load(std::memory_order_relaxed);
+    if (b - t > a->size - 1) {
+      garbage.emplace_back(a->grow(b, t));
+      a = garbage.back().get();
+      array.store(a, std::memory_order_release);
+    }
+    a->put(b, x.release());
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+  }
+
+  // Owner only
+  std::unique_ptr<T> pop() {
+    auto b = bottom.load(std::memory_order_relaxed) - 1;
+    auto a = array.load(std::memory_order_relaxed);
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto t = top.load(std::memory_order_relaxed);
+
+    T * x = nullptr;
+    if (t <= b) {
+      x = a->get(b);
+      if (t == b) {
+        // Last element, race the thieves for it
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+          x = nullptr;
+        }
+        bottom.store(b + 1, std::memory_order_relaxed);
+      }
+    } else {
+      bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return std::unique_ptr<T>(x);
+  }
+
+  // Any thread. Returns nullptr if the deque was empty or we lost a race with another thief/owner.
+  std::unique_ptr<T> steal() {
+    auto t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto b = bottom.load(std::memory_order_acquire);
+
+    if (t < b) {
+      auto a = array.load(std::memory_order_acquire);
+      T * x = a->get(t);
+      if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+      }
+      return std::unique_ptr<T>(x);
+    }
+    return nullptr;
+  }
+
+  // Estimates only, may be stale by the time they are used
+  std::int64_t size() const {
+    auto n = bottom.load(std::memory_order_relaxed) - top.load(std::memory_order_relaxed);
+    return n > 0 ? n : 0;
+  }
+
+  bool empty() const {
+    return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+  }
+};
+
+}
+
+#endif
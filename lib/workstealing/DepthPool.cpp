@@ -2,54 +2,185 @@
 
 #include <hpx/include/components.hpp>
 
+#include <algorithm>
+#include <mutex>
+
+#include "StealStats.hpp"
+#include "util/MemoryUsage.hpp"
+
 namespace workstealing {
 
+namespace {
+
+// A queued task and the lock-free deque's node around it (two links)
+constexpr std::int64_t entryBytes = sizeof(DepthPool::fnType) + 2 * sizeof(void *);
+
+}
+
+DepthPool::queueType * DepthPool::getPool(unsigned depth) {
+  auto q = pools[depth].load(std::memory_order_acquire);
+  if (q) {
+    return q;
+  }
+
+  auto newQ = new queueType();
+  if (pools[depth].compare_exchange_strong(q, newQ, std::memory_order_acq_rel)) {
+    return newQ;
+  }
+
+  // Someone else created it first
+  delete newQ;
+  return q;
+}
+
+DepthPool::heapType * DepthPool::getHeap(unsigned depth) {
+  auto h = heaps[depth].load(std::memory_order_acquire);
+  if (h) {
+    return h;
+  }
+
+  auto newH = new heapType();
+  if (heaps[depth].compare_exchange_strong(h, newH, std::memory_order_acq_rel)) {
+    return newH;
+  }
+
+  delete newH;
+  return h;
+}
+
+bool DepthPool::popFrom(unsigned depth, DepthPool::fnType & task, double & priority) {
+  bool found = false;
+  if (prioritised) {
+    // Scans over empty depths stay off the locks
+    auto h = heaps[depth].load(std::memory_order_acquire);
+    if (h && h->count.load(std::memory_order_acquire) > 0) {
+      std::lock_guard<hpx::lcos::local::spinlock> l(h->mtx);
+      if (!h->heap.empty()) {
+        std::pop_heap(h->heap.begin(), h->heap.end());
+        priority = h->heap.back().priority;
+        task = std::move(h->heap.back().task);
+        h->heap.pop_back();
+        h->count.store(h->heap.size(), std::memory_order_release);
+        found = true;
+      }
+    }
+  } else {
+    auto q = pools[depth].load(std::memory_order_acquire);
+    found = q && q->pop_right(task);
+    priority = 0;
+  }
+
+  if (found) {
+    sizes[depth].fetch_sub(1, std::memory_order_relaxed);
+    totalSize.fetch_sub(1, std::memory_order_relaxed);
+    YewPar::util::MemoryUsage::add(YewPar::util::MemoryUsage::Pools, -entryBytes);
+    return true;
+  }
+  return false;
+}
+
 DepthPool::fnType DepthPool::steal() {
   DepthPool::fnType task;
+  double priority;
 
-  for (auto i = 0; i <= lowest; ++i) {
-    if (!pools[i].empty()) {
-      auto task = pools[i].front();
-      pools[i].pop();
+  auto high = highest.load();
+  for (auto i = 0; i <= high; ++i) {
+    if (popFrom(i, task, priority)) {
       return task;
     }
   }
   return nullptr;
 }
 
+DepthPool::Chunk DepthPool::stealChunk(unsigned maxTasks) {
+  auto start = Workstealing::StealStats::clock::now();
+  DepthPool::Chunk chunk;
+  DepthPool::fnType task;
+  double priority;
+
+  auto high = highest.load();
+  for (auto i = 0; i <= high; ++i) {
+    if (!popFrom(i, task, priority)) {
+      continue;
+    }
+    chunk.emplace_back(i, std::move(task), priority);
+
+    // Sizes are approximate (pushes increment after the task is visible) so always take the one
+    // we found and then up to half of what we think was there
+    auto remaining = std::max(0, sizes[i].load(std::memory_order_relaxed));
+    auto toTake = std::min(maxTasks, static_cast<unsigned>(remaining + 2) / 2);
+    while (chunk.size() < toTake && popFrom(i, task, priority)) {
+      chunk.emplace_back(i, std::move(task), priority);
+    }
+    break;
+  }
+
+  // Only ever called by remote thieves
+  Workstealing::StealStats::stealAnswered(Workstealing::StealStats::DepthPool,
+                                          Workstealing::StealStats::clock::now() - start,
+                                          Workstealing::StealStats::serializedSize(chunk));
+  return chunk;
+}
+
 DepthPool::fnType DepthPool::getLocal() {
   DepthPool::fnType task;
-  if (pools[lowest].empty()) {
-    return nullptr;
-  } else {
-    task = pools[lowest].front();
-    pools[lowest].pop();
+  double priority;
+
+  // Fast path: scan down from the lowest hint
+  auto low = lowest.load();
+  for (int i = low; i >= 0; --i) {
+    if (popFrom(i, task, priority)) {
+      // Update lowest pointer if required. If we race with an addWork the full scan below still
+      // finds the work so this doesn't need to be exact.
+      if (i < static_cast<int>(low)) {
+        lowest.compare_exchange_strong(low, i);
+      }
+      return task;
+    }
   }
 
-  // Update lowest pointer if required
-  while (lowest > 0) {
-    if (pools[lowest].empty()) {
-        --lowest;
-    } else {
-      break;
+  // Work might have been added below the hint while we were scanning
+  auto high = highest.load();
+  for (int i = high; i > static_cast<int>(low); --i) {
+    if (popFrom(i, task, priority)) {
+      return task;
     }
   }
 
-  return task;
+  return nullptr;
 }
 
 void DepthPool::addWork(DepthPool::fnType task, unsigned depth) {
-  // Resize if we need to. We don't want this to happen too often, so we double it if we need to.
+  push(std::move(task), depth, 0);
+}
+
+void DepthPool::addPrioritisedWork(DepthPool::fnType task, unsigned depth, double priority) {
+  push(std::move(task), depth, priority);
+}
+
+void DepthPool::push(DepthPool::fnType task, unsigned depth, double priority) {
   if (depth >= max_depth) {
-    max_depth = max_depth * 2;
-    pools.resize(max_depth);
+    depth = max_depth - 1;
   }
 
-  pools[depth].push(task);
-
-  if (depth > lowest) {
-    lowest = depth;
+  if (prioritised) {
+    auto h = getHeap(depth);
+    std::lock_guard<hpx::lcos::local::spinlock> l(h->mtx);
+    h->heap.push_back(Prioritised {priority, std::move(task)});
+    std::push_heap(h->heap.begin(), h->heap.end());
+    h->count.store(h->heap.size(), std::memory_order_release);
+  } else {
+    getPool(depth)->push_left(std::move(task));
   }
+  sizes[depth].fetch_add(1, std::memory_order_relaxed);
+  totalSize.fetch_add(1, std::memory_order_relaxed);
+  YewPar::util::MemoryUsage::add(YewPar::util::MemoryUsage::Pools, entryBytes);
+
+  auto prev = highest.load();
+  while (depth > prev && !highest.compare_exchange_weak(prev, depth)) {}
+
+  prev = lowest.load();
+  while (depth > prev && !lowest.compare_exchange_weak(prev, depth)) {}
 }
 
 }
@@ -62,4 +193,5 @@ HPX_REGISTER_COMPONENT(DepthPool_type, DepthPool);
 
 HPX_REGISTER_ACTION(workstealing::DepthPool::getLocal_action, DepthPool_getLocal_action);
 HPX_REGISTER_ACTION(workstealing::DepthPool::steal_action, DepthPool_steal_action);
+HPX_REGISTER_ACTION(workstealing::DepthPool::stealChunk_action, DepthPool_stealChunk_action);
 HPX_REGISTER_ACTION(workstealing::DepthPool::addWork_action, DepthPool_addWork_action);
@@ -1,13 +1,21 @@
 #ifndef DEPTHPOOL_COMPONENT_HPP
 #define DEPTHPOOL_COMPONENT_HPP
 
-#include <queue>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
 
 #include <hpx/include/components.hpp>
+#include <hpx/lcos/local/spinlock.hpp>
 #include <hpx/util/lockfree/deque.hpp>
 #include <hpx/runtime/actions/basic_action.hpp>
 #include <hpx/runtime/actions/component_action.hpp>
 #include <hpx/util/function.hpp>
+#include <hpx/util/tuple.hpp>
+#include <hpx/runtime/serialization/vector.hpp>
+
+#include "util/HugePages.hpp"
 namespace hpx { namespace naming { struct id_type; } }
 
 namespace workstealing {
@@ -15,36 +23,113 @@ namespace workstealing {
 // A workqueue that tracks tasks based on the depth in the tree they were created at.
 // This allows high vs low tasks to be distinguished while maintaining heuristics as much as possible.
 // In particular a sequential user should see tasks in the same order as a sequential thread
-// Currently only supports access by a single thread at a time as it's very non trivial to implement lock-free.
-class DepthPool : public hpx::components::locking_hook<
-  hpx::components::component_base<DepthPool>> {
- private:
+//
+// Each depth has its own lock-free FIFO so several local workers can push/pop at once. The
+// co-located policy calls getLocal/addWork directly via a pointer, only remote steals use the actions.
+//
+// A prioritised pool (B&B with Params::boundOrderedPool) instead keeps each depth as a max-heap on
+// a per task priority, under a spinlock, so the most promising task at a depth is always taken
+// first. Depth still comes first: the priority only orders tasks within a depth.
+class DepthPool : public hpx::components::component_base<DepthPool> {
+ public:
   using fnType = hpx::util::function<void(hpx::naming::id_type)>;
 
-  std::vector< std::queue<fnType> > pools;
+  // Tasks returned from a batched steal, along with the depth they were stored at and their
+  // priority (0 in FIFO pools)
+  using Chunk = std::vector<hpx::util::tuple<unsigned, fnType, double> >;
+
+ private:
+  using queueType = boost::lockfree::deque<fnType>;
+
+  struct Prioritised {
+    double priority;
+    fnType task;
+
+    bool operator<(const Prioritised & other) const { return priority < other.priority; }
+  };
+
+  // Heaps of a busy depth can get large, so they may be on huge pages (util/HugePages.hpp)
+  struct heapType {
+    hpx::lcos::local::spinlock mtx;
+    std::vector<Prioritised, YewPar::util::HugePages::Allocator<Prioritised> > heap;
+    // heap.size(), written under mtx so scans can skip empty heaps without taking it
+    std::atomic<std::size_t> count {0};
+  };
+
+  bool prioritised;
 
-  // For quicker access
-  unsigned lowest = 0;
+  // Queues are created lazily, most depths never see a task. Only one of the two is used.
+  std::vector<std::atomic<queueType *> > pools;
+  std::vector<std::atomic<heapType *> > heaps;
+
+  // Approximate number of tasks at each depth, used to size batched steals
+  std::vector<std::atomic<int> > sizes;
+  std::atomic<int> totalSize;
+
+  // Deepest level that might have work (hint only) and deepest level ever used (for correctness)
+  std::atomic<unsigned> lowest;
+  std::atomic<unsigned> highest;
   unsigned max_depth;
 
+  static unsigned clampLevels(unsigned levels) { return std::min(std::max(levels, 1u), maxLevels); }
+
+  queueType * getPool(unsigned depth);
+  heapType * getHeap(unsigned depth);
+  bool popFrom(unsigned depth, fnType & task, double & priority);
+  void push(fnType task, unsigned depth, double priority);
+
  public:
-  DepthPool() {
-    // TODO: Size should be settable/dynamic. Currently the same as the default max_depth
-    max_depth = 5000;
-    pools.resize(max_depth);
+  // The default Params::maxDepth
+  static constexpr unsigned defaultLevels = 5000;
+  // Searches without a depth limit can leave maxDepth huge, no pool needs to be that deep
+  static constexpr unsigned maxLevels = 1 << 16;
+
+  // Tasks at depth levels - 1 or deeper share the last level. Skeletons size the pool for the
+  // deepest task they can spawn (see DepthPoolPolicy::initPolicy).
+  explicit DepthPool(bool prioritised = false, unsigned levels = defaultLevels)
+      : prioritised(prioritised), pools(clampLevels(levels)), heaps(clampLevels(levels)),
+        sizes(clampLevels(levels)), totalSize(0), lowest(0), highest(0),
+        max_depth(clampLevels(levels)) {
+    for (auto & p : pools) {
+      p.store(nullptr, std::memory_order_relaxed);
+    }
+    for (auto & h : heaps) {
+      h.store(nullptr, std::memory_order_relaxed);
+    }
+    for (auto & s : sizes) {
+      s.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  ~DepthPool() {
+    for (auto & p : pools) {
+      delete p.load();
+    }
+    for (auto & h : heaps) {
+      delete h.load();
+    }
   }
 
+  // Approximate number of queued tasks
+  std::uint64_t size() const { return std::max(0, totalSize.load(std::memory_order_relaxed)); }
+
   fnType getLocal();
   HPX_DEFINE_COMPONENT_ACTION(DepthPool, getLocal);
   fnType steal();
   HPX_DEFINE_COMPONENT_ACTION(DepthPool, steal);
+  // Steal up to maxTasks, but no more than half, of the tasks at the shallowest non-empty depth
+  Chunk stealChunk(unsigned maxTasks);
+  HPX_DEFINE_COMPONENT_ACTION(DepthPool, stealChunk);
   void addWork(fnType task, unsigned depth);
   HPX_DEFINE_COMPONENT_ACTION(DepthPool, addWork);
+  // Higher priorities are taken first, in a FIFO pool this is just addWork
+  void addPrioritisedWork(fnType task, unsigned depth, double priority);
 };
 }
 
 HPX_REGISTER_ACTION_DECLARATION(workstealing::DepthPool::getLocal_action, DepthPool_getLocal_action);
 HPX_REGISTER_ACTION_DECLARATION(workstealing::DepthPool::steal_action, DepthPool_steal_action);
+HPX_REGISTER_ACTION_DECLARATION(workstealing::DepthPool::stealChunk_action, DepthPool_stealChunk_action);
 HPX_REGISTER_ACTION_DECLARATION(workstealing::DepthPool::addWork_action, DepthPool_addWork_action);
 
 #endif
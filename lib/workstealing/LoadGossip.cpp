@@ -0,0 +1,242 @@
+#include "LoadGossip.hpp"
+
+#include "hpx/apply.hpp"
+#include "hpx/lcos/local/mutex.hpp"
+#include "hpx/performance_counters/manage_counter_type.hpp"
+#include "hpx/runtime/find_here.hpp"
+#include "hpx/runtime/get_num_localities.hpp"
+#include "hpx/runtime/naming/name.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Workstealing { namespace LoadGossip {
+
+namespace {
+
+// Loads are sent as one word so receivers can drop reordered (older) messages with a single CAS
+constexpr unsigned loadBits = 24;
+constexpr std::uint64_t loadMask = (std::uint64_t(1) << loadBits) - 1;
+
+std::uint64_t pack(std::uint64_t seq, std::uint64_t load) {
+  return (seq << loadBits) | std::min(load, loadMask);
+}
+std::uint64_t seqOf(std::uint64_t v) { return v >> loadBits; }
+std::uint64_t loadOf(std::uint64_t v) { return v & loadMask; }
+
+// Don't send magnitude-only changes more often than this
+constexpr auto minUpdateInterval = std::chrono::milliseconds(5);
+
+std::once_flag initFlag;
+std::uint32_t here = 0;
+std::vector<hpx::naming::id_type> remoteLocalities;
+
+// Latest (seq, load) heard from each locality. Starts as "has work". Joins replace it with a larger
+// copy (under sendMtx), earlier copies are kept so readers never see freed memory. setLoad re-applies
+// its update if the copy changed under it, see there.
+std::atomic<std::uint32_t> numLocalities(0);
+std::atomic<std::atomic<std::uint64_t> *> remoteLoad(nullptr);
+std::vector<std::unique_ptr<std::atomic<std::uint64_t>[]> > remoteLoadCopies;
+
+// What we last told everyone (and remoteLocalities, remoteLoadCopies)
+hpx::lcos::local::mutex sendMtx;
+std::atomic<std::uint64_t> lastSent(1);
+std::uint64_t seq = 0;
+std::chrono::steady_clock::time_point lastSendTime;
+
+std::atomic<std::uint64_t> perf_messagesSent(0);
+std::atomic<std::uint64_t> perf_skippedSteals(0);
+
+// Keep the newest of slot and seqAndLoad in slot
+void storeIfNewer(std::atomic<std::uint64_t> & slot, std::uint64_t seqAndLoad) {
+  auto cur = slot.load();
+  while (seqOf(cur) < seqOf(seqAndLoad) && !slot.compare_exchange_weak(cur, seqAndLoad)) {}
+}
+
+// Must hold sendMtx (or be initialising)
+void growRemoteLoad(std::uint32_t n) {
+  auto old = numLocalities.load();
+  if (n <= old) {
+    return;
+  }
+
+  // Publish the new copy before filling it in from the old one: a setLoad that still wrote to the
+  // old copy either did so before we read it here, or sees the new copy afterwards and writes
+  // that too. Until then readers see the default, "has work".
+  std::unique_ptr<std::atomic<std::uint64_t>[]> loads(new std::atomic<std::uint64_t>[n]);
+  for (std::uint32_t i = 0; i < n; ++i) {
+    loads[i].store(pack(0, 1));
+  }
+  auto prev = remoteLoad.exchange(loads.get());
+  numLocalities.store(n);
+  for (std::uint32_t i = 0; i < old; ++i) {
+    storeIfNewer(loads[i], prev[i].load());
+  }
+  remoteLoadCopies.push_back(std::move(loads));
+}
+
+void init() {
+  std::call_once(initFlag, []() {
+    here = hpx::get_locality_id();
+    remoteLocalities = hpx::find_remote_localities();
+    growRemoteLoad(hpx::get_num_localities(hpx::launch::sync));
+  });
+}
+
+// Must hold sendMtx
+void send(std::uint64_t load) {
+  lastSent.store(load);
+  lastSendTime = std::chrono::steady_clock::now();
+  auto msg = pack(++seq, load);
+  for (auto const & loc : remoteLocalities) {
+    hpx::apply<setLoad_act>(loc, here, msg);
+  }
+  perf_messagesSent += remoteLocalities.size();
+}
+
+std::uint64_t get_and_reset(std::atomic<std::uint64_t> & cntr, bool reset) {
+  auto res = cntr.load();
+  if (reset) { cntr = 0; }
+  return res;
+}
+
+std::uint64_t getMessagesSent(bool reset) { return get_and_reset(perf_messagesSent, reset); }
+std::uint64_t getSkippedSteals(bool reset) { return get_and_reset(perf_skippedSteals, reset); }
+
+}
+
+void workAdded() {
+  // Fast path: already advertising work. Ordered after the work was made visible, so update either
+  // sees the work when it checks again or we see its 0 here.
+  if (lastSent.load() != 0) {
+    return;
+  }
+
+  init();
+  std::lock_guard<hpx::lcos::local::mutex> l(sendMtx);
+  if (lastSent.load() == 0) {
+    send(1);
+  }
+}
+
+void update(const hpx::util::function<std::uint64_t(), false> & localLoad) {
+  init();
+  if (numLocalities <= 1) {
+    return;
+  }
+
+  std::lock_guard<hpx::lcos::local::mutex> l(sendMtx);
+  auto prev = lastSent.load();
+  auto load = localLoad();
+
+  if ((prev == 0) == (load == 0)) {
+    // No change in whether we have work, only send large changes in amount and not too often
+    if (load == 0 || (load < 2 * prev && 2 * load > prev) ||
+        std::chrono::steady_clock::now() - lastSendTime < minUpdateInterval) {
+      return;
+    }
+  }
+
+  if (load == 0) {
+    // Work added since the estimate found lastSent non zero and didn't send, so say 0 first (from
+    // now on workAdded sends) and look again. Still having work we keep advertising it.
+    lastSent.store(0);
+    if (localLoad() != 0) {
+      lastSent.store(prev);
+      return;
+    }
+  }
+
+  send(load);
+}
+
+bool advertisesWork(const hpx::naming::id_type & id) {
+  init();
+  auto loc = hpx::naming::get_locality_id_from_id(id);
+  if (loc >= numLocalities.load()) {
+    return true;
+  }
+  return loadOf(remoteLoad.load()[loc].load(std::memory_order_relaxed)) != 0;
+}
+
+bool globalLoadZero() {
+  init();
+  auto n = numLocalities.load();
+  auto loads = remoteLoad.load();
+  for (std::uint32_t i = 0; i < n; ++i) {
+    if (i != here && loadOf(loads[i].load(std::memory_order_relaxed)) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void recordSkippedSteal() {
+  perf_skippedSteals++;
+}
+
+void setLoad(std::uint32_t locality, std::uint64_t seqAndLoad) {
+  init();
+  if (locality >= numLocalities.load()) {
+    return;
+  }
+
+  auto loads = remoteLoad.load();
+  while (true) {
+    storeIfNewer(loads[locality], seqAndLoad);
+    auto now = remoteLoad.load();
+    if (now == loads) {
+      return;
+    }
+    loads = now;
+  }
+}
+
+void addLocality(const hpx::naming::id_type & loc) {
+  init();
+  auto id = hpx::naming::get_locality_id_from_id(loc);
+  if (id == here) {
+    return;
+  }
+
+  std::lock_guard<hpx::lcos::local::mutex> l(sendMtx);
+  // The join may be older news than what init saw
+  if (std::find(remoteLocalities.begin(), remoteLocalities.end(), loc) == remoteLocalities.end()) {
+    remoteLocalities.push_back(loc);
+  }
+  growRemoteLoad(id + 1);
+}
+
+void reset() {
+  init();
+  std::lock_guard<hpx::lcos::local::mutex> l(sendMtx);
+  lastSent.store(1);
+
+  // Messages still arriving from the last search are older than anything sent in this one
+  auto n = numLocalities.load();
+  auto loads = remoteLoad.load();
+  for (std::uint32_t i = 0; i < n; ++i) {
+    auto cur = loads[i].load();
+    while (!loads[i].compare_exchange_weak(cur, pack(seqOf(cur), 1))) {}
+  }
+}
+
+void registerPerformanceCounters() {
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/gossip/messagesSent",
+      &getMessagesSent,
+      "Returns the number of load gossip messages sent from this locality"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/gossip/skippedSteals",
+      &getSkippedSteals,
+      "Returns the number of distributed steals not attempted because no victim advertised work"
+                                                  );
+}
+
+}}
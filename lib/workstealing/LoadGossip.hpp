@@ -0,0 +1,50 @@
+#ifndef YEWPAR_LOADGOSSIP_HPP
+#define YEWPAR_LOADGOSSIP_HPP
+
+#include <cstdint>
+
+#include "hpx/runtime/actions/plain_action.hpp"
+#include "hpx/runtime/naming/id_type.hpp"
+#include "hpx/util/function.hpp"
+
+// Lightweight load information exchange between localities.
+//
+// Each locality tells the others when it goes from having no stealable work to having some and
+// back again (plus occasional coarse updates of how much). Policies use this to skip remote
+// victims that have nothing to give, and to stop stealing remotely altogether once every other
+// locality is known to be empty. Until a locality has said otherwise it is assumed to have work,
+// so the behaviour without any messages is the same as plain random stealing.
+namespace Workstealing { namespace LoadGossip {
+
+// Called (via Scheduler::notifyWorkAvailable) whenever local work is created. Only sends
+// anything if we were previously advertising no work.
+void workAdded();
+
+// Called by idle schedulers with a way to estimate the local load (Policy::localLoad()). Before
+// advertising no work the estimate is taken again, see LoadGossip.cpp.
+void update(const hpx::util::function<std::uint64_t(), false> & localLoad);
+
+// Does the locality owning id (a locality or a component on it) advertise stealable work?
+bool advertisesWork(const hpx::naming::id_type & id);
+
+// True once every remote locality has told us it has no work
+bool globalLoadZero();
+
+// Policies count the distributed steals they didn't attempt because of gossip
+void recordSkippedSteal();
+
+void setLoad(std::uint32_t locality, std::uint64_t seqAndLoad);
+HPX_DEFINE_PLAIN_ACTION(setLoad, setLoad_act);
+
+// Start gossiping with loc, which joined after we started (see Scheduler::addLocality)
+void addLocality(const hpx::naming::id_type & loc);
+
+// Back to assuming every locality has work, and to advertising work ourselves. Called when the
+// schedulers start, so one search's idle tail doesn't hide work in the next.
+void reset();
+
+void registerPerformanceCounters();
+
+}}
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef YEWPAR_OPEN_LEVELS_HPP
+#define YEWPAR_OPEN_LEVELS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <hpx/runtime/threads/thread_helpers.hpp>
+
+// The shallowest levels of a StackStealing search stack, published so that thieves can take
+// unexplored children from them without the searching thread's help (Params::claimSteals).
+//
+// Each level packs the index of the next unclaimed child and the number of children into one
+// atomic. The searching thread and thieves both claim children by bumping the index, so every child
+// goes to exactly one of them, and a thief never waits for the searching thread to reach its next
+// steal check. A thief copies the level's node and builds the child itself (see
+// StackStealing::claimFromStack).
+//
+// Thieves announce themselves in a level's readers count before claiming, and the searching thread
+// waits for it to drop to zero before it overwrites the level's node, so a thief never copies a
+// node that is being written. That wait is only ever for a node copy.
+//
+// Levels the searching thread keeps to itself (e.g. ones whose children it accumulates in bulk) are
+// opened private, and levels from maxLevels down aren't published at all.
+namespace workstealing {
+
+template <typename Node>
+class OpenLevels {
+ public:
+  static constexpr std::size_t maxLevels = 64;
+
+  static bool publishes(const std::size_t i) {
+    return i < maxLevels;
+  }
+
+  // Searching thread: level i holds numChildren children of node, of which the first `first` are
+  // already taken. node must stay where it is while any level is open.
+  void open(const std::size_t i, const Node * node, const std::uint32_t first,
+            const std::uint32_t numChildren, const bool isPrivate = false) {
+    auto & l = levels[i];
+    l.node.store(node, std::memory_order_relaxed);
+    l.state.store(pack(first, numChildren, isPrivate), std::memory_order_release);
+    top.store(i, std::memory_order_release);
+  }
+
+  // Searching thread: the index of the next child of level i to search, or -1 once everything left
+  // on the level has been claimed
+  std::int64_t claim(const std::size_t i) {
+    auto s = levels[i].state.fetch_add(std::uint64_t(1) << 32);
+    return next(s) < end(s) ? static_cast<std::int64_t>(next(s)) : -1;
+  }
+
+  // Searching thread: drop what is left on level i (e.g. the rest of it was pruned)
+  void close(const std::size_t i) {
+    levels[i].state.store(0);
+  }
+
+  void closeAll() {
+    auto t = top.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i <= t; ++i) {
+      close(i);
+    }
+  }
+
+  // Searching thread: wait until no thief can still be copying level i's node, before overwriting
+  // it. Level i must be closed or fully claimed.
+  void waitForReaders(const std::size_t i) {
+    while (levels[i].readers.load() != 0) {
+      hpx::this_thread::yield();
+    }
+  }
+
+  // Thief: claim the next child of the shallowest level with children left, copying its parent into
+  // parent. False if there is nothing to claim.
+  bool steal(std::size_t & level, std::uint32_t & idx, Node & parent) {
+    auto t = top.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i <= t; ++i) {
+      auto & l = levels[i];
+      l.readers.fetch_add(1);
+      auto s = l.state.load();
+      while (!isPrivate(s) && next(s) < end(s)) {
+        if (l.state.compare_exchange_weak(s, s + (std::uint64_t(1) << 32))) {
+          parent = *l.node.load(std::memory_order_relaxed);
+          l.readers.fetch_sub(1);
+          level = i;
+          idx = next(s);
+          return true;
+        }
+      }
+      l.readers.fetch_sub(1);
+    }
+    return false;
+  }
+
+ private:
+  static constexpr std::uint64_t privateBit = std::uint64_t(1) << 31;
+
+  struct Level {
+    std::atomic<std::uint64_t> state {0};
+    std::atomic<const Node *> node {nullptr};
+    std::atomic<unsigned> readers {0};
+  };
+
+  Level levels[maxLevels];
+  std::atomic<std::size_t> top {0};
+
+  static std::uint64_t pack(const std::uint32_t first, const std::uint32_t numChildren, const bool isPrivate) {
+    return (std::uint64_t(first) << 32) | (isPrivate ? privateBit : 0) | numChildren;
+  }
+
+  static std::uint32_t next(const std::uint64_t s) { return s >> 32; }
+  static std::uint32_t end(const std::uint64_t s) { return s & (privateBit - 1); }
+  static bool isPrivate(const std::uint64_t s) { return s & privateBit; }
+};
+
+}
+
+#endif
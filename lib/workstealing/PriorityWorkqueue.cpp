@@ -18,6 +18,7 @@ namespace workstealing {
 
 using funcType = hpx::util::function<void(hpx::naming::id_type)>;
 funcType PriorityWorkqueue::steal() {
+  std::lock_guard<mutex_t> l(mtx);
   if (!tasks.empty()) {
     auto task = tasks.top();
     tasks.pop();
@@ -26,11 +27,27 @@ funcType PriorityWorkqueue::steal() {
   return nullptr;
 }
 
+PriorityWorkqueue::StealResult PriorityWorkqueue::stealWithPriority() {
+  std::lock_guard<mutex_t> l(mtx);
+  if (tasks.empty()) {
+    return hpx::util::make_tuple(funcType(), false, 0);
+  }
+
+  auto task = hpx::util::get<1>(tasks.top());
+  tasks.pop();
+  if (tasks.empty()) {
+    return hpx::util::make_tuple(std::move(task), false, 0);
+  }
+  return hpx::util::make_tuple(std::move(task), true, hpx::util::get<0>(tasks.top()));
+}
+
 void PriorityWorkqueue::addWork(int priority, funcType task) {
+  std::lock_guard<mutex_t> l(mtx);
   tasks.push(hpx::util::make_tuple(priority, std::move(task)));
 }
 
 bool PriorityWorkqueue::workRemaining() {
+  std::lock_guard<mutex_t> l(mtx);
   return tasks.empty();
 }
 }
@@ -41,5 +58,6 @@ typedef hpx::components::component<workstealing::PriorityWorkqueue> workqueue_ty
 HPX_REGISTER_COMPONENT(workqueue_type, priority_workqueue);
 
 HPX_REGISTER_ACTION(workstealing::PriorityWorkqueue::steal_action, workqueue_prio_steal_action);
+HPX_REGISTER_ACTION(workstealing::PriorityWorkqueue::stealWithPriority_action, workqueue_prio_stealWithPriority_action);
 HPX_REGISTER_ACTION(workstealing::PriorityWorkqueue::addWork_action, workqueue_prio_addWork_action);
 HPX_REGISTER_ACTION(workstealing::PriorityWorkqueue::workRemaining_action, workqueue_prio_workRemaining_action);
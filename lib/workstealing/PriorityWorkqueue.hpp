@@ -16,6 +16,7 @@
 #include "hpx/traits/is_action.hpp"                              // for is_a...
 #include "hpx/traits/needs_automatic_registration.hpp"           // for need...
 #include "hpx/util/function.hpp"                                 // for func...
+#include "hpx/lcos/local/mutex.hpp"
 namespace hpx { namespace naming { struct id_type; } }
 
 namespace workstealing
@@ -33,19 +34,28 @@ namespace workstealing
     };
   }
 
-  class PriorityWorkqueue : public hpx::components::locking_hook<
-    hpx::components::component_base<PriorityWorkqueue>
-    >
+  // Locks internally (rather than via locking_hook) so a co-located policy can call it directly
+  // through a pointer as well as through the actions
+  class PriorityWorkqueue : public hpx::components::component_base<PriorityWorkqueue>
     {
     private:
       using funcType  = hpx::util::function<void(hpx::naming::id_type)>;
       using queueType = hpx::util::tuple<int, funcType>;
 
+      using mutex_t = hpx::lcos::local::mutex;
+      mutex_t mtx;
+
       std::priority_queue<queueType, std::vector<queueType>, detail::PriorityWorkqueueCompare> tasks;
 
     public:
+      // Result of a steal: the task (or nullptr), whether anything is left and if so the priority
+      // of the next task to be handed out
+      using StealResult = hpx::util::tuple<funcType, bool, int>;
+
       funcType steal();
       HPX_DEFINE_COMPONENT_ACTION(PriorityWorkqueue, steal);
+      StealResult stealWithPriority();
+      HPX_DEFINE_COMPONENT_ACTION(PriorityWorkqueue, stealWithPriority);
       void addWork(int priority, funcType task);
       HPX_DEFINE_COMPONENT_ACTION(PriorityWorkqueue, addWork);
       bool workRemaining();
@@ -54,6 +64,7 @@ namespace workstealing
 }
 
 HPX_REGISTER_ACTION_DECLARATION(workstealing::PriorityWorkqueue::steal_action, workqueue_prio_steal_action);
+HPX_REGISTER_ACTION_DECLARATION(workstealing::PriorityWorkqueue::stealWithPriority_action, workqueue_prio_stealWithPriority_action);
 HPX_REGISTER_ACTION_DECLARATION(workstealing::PriorityWorkqueue::addWork_action, workqueue_prio_addWork_action);
 HPX_REGISTER_ACTION_DECLARATION(workstealing::PriorityWorkqueue::workRemaining_action, workqueue_prio_workRemaining_action);
 
@@ -1,15 +1,182 @@
 #include "hpx/apply.hpp"
+#include "hpx/lcos/broadcast.hpp"
 #include "hpx/runtime/actions/plain_action.hpp"
 #include "hpx/runtime/naming/id_type.hpp"
+#include "hpx/runtime/find_all_localities.hpp"
+#include "hpx/runtime/find_here.hpp"
+#include "hpx/runtime/get_num_localities.hpp"
+#include "hpx/runtime/get_os_thread_count.hpp"
 #include "hpx/runtime/threads/executors/default_executor.hpp"
 
 #include "Scheduler.hpp"
 #include "ExponentialBackoff.hpp"
+#include "LoadGossip.hpp"
+#include "WorkerStates.hpp"
+#include "StealStats.hpp"
+#include "util/RuntimeOptions.hpp"
+
+#include <mutex>
+#include <numeric>
+#include <vector>
+
+// Number of failed getWork calls (yielding in between) before a scheduler parks
+#define SPINS_BEFORE_PARK 64
 
 namespace Workstealing { namespace Scheduler {
 
+namespace {
+
+// Parking state
+hpx::lcos::local::mutex parkMtx;
+hpx::lcos::local::condition_variable parkCv;
+std::atomic<unsigned> numParked(0);
+std::atomic<std::uint64_t> workEpoch(0);
+
+// Workers of every locality, see workersPerLocality. Gathered again after a locality joins.
+hpx::lcos::local::mutex workersMtx;
+bool workersKnown = false;
+std::vector<unsigned> workers;
+unsigned numWorkers = 0;
+
+// Set when we have told the other localities all our schedulers are parked
+std::atomic<bool> announcedIdle(false);
+
+// Which remote localities have told us they are idle (indexed by locality id). Grows when
+// localities join, so it is only touched under idleMtx; numIdleLocalities lets notifyWorkAvailable
+// skip the lock while nobody is idle.
+hpx::lcos::local::mutex idleMtx;
+std::vector<bool> idleLocalities;
+std::atomic<std::uint32_t> numLocalities(0);
+std::atomic<std::uint32_t> numIdleLocalities(0);
+
+// Must hold idleMtx
+void growIdleLocalities(std::uint32_t n) {
+  if (n > idleLocalities.size()) {
+    idleLocalities.resize(n, false);
+    numLocalities.store(n);
+  }
+}
+
+void announceIdle() {
+  if (numLocalities <= 1 || announcedIdle.exchange(true)) {
+    return;
+  }
+
+  auto here = hpx::get_locality_id();
+  for (auto const & loc : hpx::find_remote_localities()) {
+    hpx::apply<setLocalityIdle_act>(loc, here, true);
+  }
+}
+
+// A scheduler found work again, so take back an announceIdle the others may still act on
+void retractIdle() {
+  if (!announcedIdle.load(std::memory_order_relaxed) || !announcedIdle.exchange(false)) {
+    return;
+  }
+
+  auto here = hpx::get_locality_id();
+  for (auto const & loc : hpx::find_remote_localities()) {
+    hpx::apply<setLocalityIdle_act>(loc, here, false);
+  }
+}
+
+}
+
+void notifyWorkAvailable() {
+  LoadGossip::workAdded();
+
+  if (numParked.load() > 0) {
+    {
+      std::unique_lock<hpx::lcos::local::mutex> l(parkMtx);
+      ++workEpoch;
+    }
+    parkCv.notify_one();
+  }
+
+  // Hint one idle remote locality that there is something to steal
+  if (numIdleLocalities.load(std::memory_order_relaxed) > 0) {
+    std::unique_lock<hpx::lcos::local::mutex> l(idleMtx);
+    for (std::uint32_t i = 0; i < idleLocalities.size(); ++i) {
+      if (idleLocalities[i]) {
+        idleLocalities[i] = false;
+        --numIdleLocalities;
+        l.unlock();
+        hpx::apply<wakeSchedulers_act>(hpx::naming::get_id_from_locality_id(i));
+        break;
+      }
+    }
+  }
+}
+
+unsigned numParkedSchedulers() {
+  return numParked.load(std::memory_order_relaxed);
+}
+
+bool starving() {
+  if (numParked.load(std::memory_order_relaxed) == 0) {
+    return false;
+  }
+  auto policy = local_policy;
+  return !policy || policy->localLoad() < localWorkers();
+}
+
+bool saturated(unsigned perWorker) {
+  auto policy = local_policy;
+  return policy && policy->localLoad() > static_cast<std::uint64_t>(perWorker) * localWorkers();
+}
+
+void wakeSchedulers() {
+  {
+    std::unique_lock<hpx::lcos::local::mutex> l(parkMtx);
+    ++workEpoch;
+  }
+  parkCv.notify_all();
+}
+
+void cancelWork() {
+  auto policy = local_policy;
+  if (!policy) {
+    return;
+  }
+
+  policy->cancel();
+  wakeSchedulers();
+
+  // Schedulers drain in parallel with us, this just makes sure it happens even if they're parked
+  while (auto task = policy->getWork()) {
+    task();
+  }
+}
+
+void setLocalityIdle(std::uint32_t locality, bool idle) {
+  std::lock_guard<hpx::lcos::local::mutex> l(idleMtx);
+  // A locality that joined may announce itself before we have heard of the join
+  growIdleLocalities(locality + 1);
+  bool prev = idleLocalities[locality];
+  idleLocalities[locality] = idle;
+  if (idle && !prev) {
+    ++numIdleLocalities;
+  } else if (!idle && prev) {
+    --numIdleLocalities;
+  }
+}
+
+void addLocality(hpx::naming::id_type loc) {
+  auto id = hpx::naming::get_locality_id_from_id(loc);
+  {
+    std::lock_guard<hpx::lcos::local::mutex> l(idleMtx);
+    growIdleLocalities(id + 1);
+  }
+  {
+    std::lock_guard<hpx::lcos::local::mutex> l(workersMtx);
+    workersKnown = false;
+  }
+  LoadGossip::addLocality(loc);
+}
+
 void scheduler(hpx::util::function<void(), false> initialTask) {
   workstealing::ExponentialBackoff backoff;
+  unsigned spins = 0;
 
   if (!local_policy) {
     std::cerr << "No local policy set when calling scheduler. Returning\n";
@@ -23,22 +190,72 @@ void scheduler(hpx::util::function<void(), false> initialTask) {
 
   // If we are pre-initialised then run that task first then enter the scheduler in this thread
   if (initialTask) {
+    WorkerStates::ScopedState s(WorkerStates::Searching);
     initialTask();
   }
 
+  auto getWork = []() {
+    WorkerStates::ScopedState s(WorkerStates::Stealing);
+    return local_policy->getWork();
+  };
+
+  auto run = [](hpx::util::function<void(), false> & task) {
+    WorkerStates::ScopedState s(WorkerStates::Searching);
+    task();
+  };
+
   for (;;) {
     if (!running) {
       break;
     }
 
-    auto task = local_policy->getWork();
+    auto task = getWork();
 
     if (task) {
       backoff.reset();
-      task();
+      spins = 0;
+      retractIdle();
+      run(task);
+    } else if (spins < SPINS_BEFORE_PARK) {
+      ++spins;
+      WorkerStates::ScopedState s(WorkerStates::Backoff);
+      hpx::this_thread::yield();
     } else {
+      // Register as parked before the final check so a concurrent notifyWorkAvailable can't be missed
+      auto epoch = workEpoch.load();
+      auto parked = ++numParked;
+
+      task = getWork();
+      if (task) {
+        --numParked;
+        backoff.reset();
+        spins = 0;
+        retractIdle();
+        run(task);
+        continue;
+      }
+
+      bool allParked;
+      {
+        std::unique_lock<hpx::lcos::local::mutex> l(mtx);
+        allParked = parked >= numRunningSchedulers;
+      }
+      if (allParked) {
+        announceIdle();
+      }
+
+      // Let other localities know if we've run out of stealable work
+      LoadGossip::update([&]() { return local_policy->localLoad(); });
+
+      // We still time out so distributed steals are retried without a hint
       backoff.failed();
-      hpx::this_thread::suspend(backoff.getSleepTime());
+      {
+        WorkerStates::ScopedState s(WorkerStates::Backoff);
+        std::unique_lock<hpx::lcos::local::mutex> l(parkMtx);
+        parkCv.wait_for(l, backoff.getSleepTime(),
+                        [&]() { return !running || workEpoch.load() != epoch; });
+      }
+      --numParked;
     }
   }
 
@@ -52,6 +269,7 @@ void scheduler(hpx::util::function<void(), false> initialTask) {
 
 void stopSchedulers() {
   running.store(false);
+  wakeSchedulers();
   {
     // Block until all schedulers have finished
     std::unique_lock<hpx::lcos::local::mutex> l(mtx);
@@ -62,12 +280,83 @@ void stopSchedulers() {
 }
 
 void startSchedulers(unsigned n) {
-  hpx::threads::executors::default_executor exe(hpx::threads::thread_priority_critical,
-                                                hpx::threads::thread_stacksize_huge);
+  {
+    std::lock_guard<hpx::lcos::local::mutex> l(idleMtx);
+    growIdleLocalities(hpx::get_num_localities(hpx::launch::sync));
+  }
+  announcedIdle.store(false);
+  WorkerStates::reset();
+  StealStats::reset();
+  LoadGossip::reset();
+
+  for (auto i = 0u; i < n; ++i) {
+    workerExecutor(i, hpx::threads::thread_priority_critical).add(hpx::util::bind(&scheduler, nullptr));
+  }
+}
+
+hpx::threads::executors::default_executor workerExecutor(unsigned i, hpx::threads::thread_priority priority) {
+  auto n = hpx::get_os_thread_count();
+  if (!YewPar::util::RuntimeOptions::get().reserveCore || n == 1) {
+    return hpx::threads::executors::default_executor(priority, hpx::threads::thread_stacksize_huge);
+  }
+  return hpx::threads::executors::default_executor(
+      priority, hpx::threads::thread_stacksize_huge,
+      hpx::threads::thread_schedule_hint(static_cast<std::int16_t>(1 + i % (n - 1))));
+}
 
-  for (auto i = 0; i < n; ++i) {
-    exe.add(hpx::util::bind(&scheduler, nullptr));
+unsigned localWorkers() {
+  auto configured = YewPar::util::RuntimeOptions::get().schedulers;
+  if (configured > 0) {
+    return configured;
   }
+  auto n = hpx::get_os_thread_count();
+  return n == 1 ? 1 : n - 1;
+}
+
+void startLocalSchedulers() {
+  startSchedulers(localWorkers());
+}
+
+void startLocalSchedulersBeside(unsigned busy) {
+  auto n = localWorkers();
+  startSchedulers(n > busy ? n - busy : 0);
+}
+
+namespace {
+
+// Must hold workersMtx
+void gatherWorkers() {
+  if (workersKnown) {
+    return;
+  }
+
+  auto localities = hpx::find_all_localities();
+  auto counts = hpx::lcos::broadcast<localWorkers_act>(localities).get();
+
+  workers.assign(localities.size(), 0);
+  for (std::size_t i = 0; i < localities.size(); ++i) {
+    auto id = hpx::naming::get_locality_id_from_id(localities[i]);
+    if (id >= workers.size()) {
+      workers.resize(id + 1, 0);
+    }
+    workers[id] = counts[i];
+  }
+  numWorkers = std::accumulate(workers.begin(), workers.end(), 0u);
+  workersKnown = true;
+}
+
+}
+
+std::vector<unsigned> workersPerLocality() {
+  std::lock_guard<hpx::lcos::local::mutex> l(workersMtx);
+  gatherWorkers();
+  return workers;
+}
+
+unsigned totalWorkers() {
+  std::lock_guard<hpx::lcos::local::mutex> l(workersMtx);
+  gatherWorkers();
+  return numWorkers;
 }
 
 }}
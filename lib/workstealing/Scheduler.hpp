@@ -2,10 +2,14 @@
 #define YEWPAR_SCHEDULER_HPP
 
 #include <atomic>
+#include <cstdint>
+#include <vector>
 #include "hpx/runtime/actions/plain_action.hpp"
+#include "hpx/runtime/naming/id_type.hpp"
 #include "policies/Policy.hpp"
 #include "hpx/lcos/local/mutex.hpp"
 #include "hpx/lcos/local/condition_variable.hpp"
+#include "hpx/runtime/threads/executors/default_executor.hpp"
 
 namespace Workstealing { namespace Scheduler {
 
@@ -24,10 +28,68 @@ HPX_DEFINE_PLAIN_ACTION(stopSchedulers, stopSchedulers_act);
 
 void scheduler(hpx::util::function<void(), false> initialTask);
 
-// Start "n" uninitialised schedulers
+// Start "n" uninitialised schedulers, placed by workerExecutor
 void startSchedulers(unsigned n);
 HPX_DEFINE_PLAIN_ACTION(startSchedulers, startSchedulers_act);
 
+// Schedulers a search runs on this locality: --yewpar:schedulers if given, else one per worker
+// thread, less one for the thread driving the search (HPX's own on a single threaded locality). See
+// util/RuntimeOptions.hpp.
+unsigned localWorkers();
+HPX_DEFINE_PLAIN_ACTION(localWorkers, localWorkers_act);
+
+// Start localWorkers() schedulers. Broadcast this rather than startSchedulers so localities with
+// different core counts each start their own number.
+void startLocalSchedulers();
+HPX_DEFINE_PLAIN_ACTION(startLocalSchedulers, startLocalSchedulers_act);
+
+// Start localWorkers() schedulers less busy, for skeletons whose calling thread searches itself for
+// the whole run (Ordered's sequential thread)
+void startLocalSchedulersBeside(unsigned busy);
+
+// Executor for the i'th search thread of this locality (schedulers and other per worker loops).
+// With --yewpar:reserve-core threads are hinted round robin onto workers 1.., to keep worker 0 for
+// communication, IO and the thread driving the search. This is only a thread_schedule_hint: HPX's
+// schedulers may still steal the threads onto worker 0.
+hpx::threads::executors::default_executor workerExecutor(unsigned i, hpx::threads::thread_priority priority);
+
+// localWorkers() of every locality, indexed by locality id, and their sum. Gathered on first use
+// and cached until a locality joins (addLocality).
+std::vector<unsigned> workersPerLocality();
+unsigned totalWorkers();
+
+// Idle schedulers park rather than sleeping for a full backoff period. Policies call this when
+// they add work so a parked scheduler (here, or on an idle remote locality) can pick it up.
+void notifyWorkAvailable();
+
+// Number of schedulers on this locality currently parked for lack of work
+unsigned numParkedSchedulers();
+
+// Load hints for spawn heuristics. Starving: some schedulers are parked and there is less than one
+// queued task per worker. Saturated: more than perWorker queued tasks per worker.
+bool starving();
+bool saturated(unsigned perWorker);
+
+// Wake all parked schedulers on this locality
+void wakeSchedulers();
+HPX_DEFINE_PLAIN_ACTION(wakeSchedulers, wakeSchedulers_act);
+
+// Cancel the current search on this locality: the policy stops stealing and every task still
+// queued here is run straight away (they return as soon as they see the stop flag), releasing
+// their promises without waiting for a scheduler to pop them one at a time.
+void cancelWork();
+HPX_DEFINE_PLAIN_ACTION(cancelWork, cancelWork_act);
+
+// Remote localities tell us when all their schedulers are parked, so we know who to wake
+void setLocalityIdle(std::uint32_t locality, bool idle);
+HPX_DEFINE_PLAIN_ACTION(setLocalityIdle, setLocalityIdle_act);
+
+// Make room for loc, which joined the running search (see util/LocalityJoin.hpp), in the per
+// locality state: idle announcements, load gossip and workersPerLocality. Broadcast to every
+// locality, the joiner included.
+void addLocality(hpx::naming::id_type loc);
+HPX_DEFINE_PLAIN_ACTION(addLocality, addLocality_act);
+
 }} // Workstealing::Scheduler
 
 
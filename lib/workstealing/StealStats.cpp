@@ -0,0 +1,284 @@
+#include "StealStats.hpp"
+
+#include "hpx/include/iostreams.hpp"
+#include "hpx/lcos/async.hpp"
+#include "hpx/lcos/broadcast.hpp"
+#include "hpx/lcos/wait_all.hpp"
+#include "hpx/performance_counters/manage_counter_type.hpp"
+#include "hpx/runtime/find_all_localities.hpp"
+#include "hpx/runtime/get_locality_id.hpp"
+#include "hpx/runtime/get_num_localities.hpp"
+
+#include "util/util.hpp"
+
+#include <boost/format.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace Workstealing { namespace StealStats {
+
+namespace {
+
+constexpr unsigned numBuckets = 40;
+
+const char * sourceNames[numSources] = {"SearchManager", "DepthPool"};
+
+struct Histogram {
+  std::atomic<std::uint64_t> buckets[numBuckets];
+
+  void clear() {
+    for (auto & b : buckets) {
+      b.store(0);
+    }
+  }
+
+  void add(std::uint64_t x) {
+    unsigned b = 0;
+    while (x > 1 && b < numBuckets - 1) {
+      x >>= 1;
+      ++b;
+    }
+    buckets[b].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  std::uint64_t count() const {
+    std::uint64_t n = 0;
+    for (const auto & b : buckets) {
+      n += b.load();
+    }
+    return n;
+  }
+
+  // " lower bound:count" for each non empty bucket
+  std::string str() const {
+    std::string s;
+    for (unsigned b = 0; b < numBuckets; ++b) {
+      auto n = buckets[b].load();
+      if (n != 0) {
+        s += (boost::format(" %1%:%2%") % (b == 0 ? 0 : std::uint64_t(1) << b) % n).str();
+      }
+    }
+    return s;
+  }
+};
+
+// Steals made from one victim locality
+struct alignas(64) Victim {
+  Histogram latency; // ns
+  Histogram nodes;   // successful steals only
+  std::atomic<std::uint64_t> failed;
+
+  void clear() {
+    latency.clear();
+    nodes.clear();
+    failed.store(0);
+  }
+};
+
+// Steals answered by this locality
+struct alignas(64) Answered {
+  Histogram service; // ns
+  Histogram bytes;
+
+  void clear() {
+    service.clear();
+    bytes.clear();
+  }
+};
+
+std::atomic<bool> sizesEnabled(false);
+
+std::once_flag initFlag;
+std::uint32_t numVictims = 0;
+std::unique_ptr<Victim[]> victims[numSources];
+Answered answered[numSources];
+
+void init() {
+  std::call_once(initFlag, []() {
+    numVictims = hpx::get_num_localities(hpx::launch::sync);
+    for (unsigned s = 0; s < numSources; ++s) {
+      victims[s].reset(new Victim[numVictims]);
+      for (std::uint32_t v = 0; v < numVictims; ++v) {
+        victims[s][v].clear();
+      }
+      answered[s].clear();
+    }
+  });
+}
+
+std::uint64_t nanos(clock::duration d) {
+  return std::max<std::int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+}
+
+// Summed over victims, up to the last non empty bucket
+template <Source s, Histogram Victim::* field>
+std::vector<std::int64_t> victimHistogram(bool reset) {
+  init();
+  std::vector<std::int64_t> h(numBuckets, 0);
+  for (std::uint32_t v = 0; v < numVictims; ++v) {
+    auto & hist = victims[s][v].*field;
+    for (unsigned b = 0; b < numBuckets; ++b) {
+      h[b] += reset ? hist.buckets[b].exchange(0) : hist.buckets[b].load();
+    }
+  }
+  while (!h.empty() && h.back() == 0) {
+    h.pop_back();
+  }
+  return h;
+}
+
+template <Source s, Histogram Answered::* field>
+std::vector<std::int64_t> answeredHistogram(bool reset) {
+  init();
+  if (field == &Answered::bytes) {
+    setEnabled(true);
+  }
+  auto & hist = answered[s].*field;
+  std::vector<std::int64_t> h(numBuckets, 0);
+  for (unsigned b = 0; b < numBuckets; ++b) {
+    h[b] = reset ? hist.buckets[b].exchange(0) : hist.buckets[b].load();
+  }
+  while (!h.empty() && h.back() == 0) {
+    h.pop_back();
+  }
+  return h;
+}
+
+}
+
+void stealReturned(Source s, std::uint32_t victim, clock::duration latency, std::uint64_t nodes) {
+  init();
+  auto & v = victims[s][std::min(victim, numVictims - 1)];
+  v.latency.add(nanos(latency));
+  if (nodes == 0) {
+    v.failed.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    v.nodes.add(nodes);
+  }
+}
+
+void stealAnswered(Source s, clock::duration service, std::uint64_t bytes) {
+  init();
+  answered[s].service.add(nanos(service));
+  if (enabled()) {
+    answered[s].bytes.add(bytes);
+  }
+}
+
+bool enabled() {
+  return sizesEnabled.load(std::memory_order_relaxed);
+}
+
+void setEnabled(bool on) {
+  sizesEnabled.store(on);
+}
+
+void setEnabledEverywhere(bool on) {
+  hpx::wait_all(hpx::lcos::broadcast<setEnabled_act>(hpx::find_all_localities(), on));
+}
+
+void reset() {
+  init();
+  for (unsigned s = 0; s < numSources; ++s) {
+    for (std::uint32_t v = 0; v < numVictims; ++v) {
+      victims[s][v].clear();
+    }
+    answered[s].clear();
+  }
+}
+
+void printReport() {
+  init();
+  auto locality = static_cast<std::int64_t>(hpx::get_locality_id());
+  for (unsigned s = 0; s < numSources; ++s) {
+    for (std::uint32_t v = 0; v < numVictims; ++v) {
+      const auto & vic = victims[s][v];
+      auto steals = vic.latency.count();
+      if (steals == 0) {
+        continue;
+      }
+      hpx::cout
+          << (boost::format("%1% %2% steals from %3%: %4% (%5% failed), latency (ns):%6%, nodes:%7%")
+              % locality
+              % sourceNames[s]
+              % v
+              % steals
+              % vic.failed.load()
+              % vic.latency.str()
+              % vic.nodes.str())
+          << hpx::endl;
+    }
+
+    const auto & ans = answered[s];
+    if (ans.service.count() != 0) {
+      hpx::cout
+          << (boost::format("%1% %2% steals answered: %3%, time (ns):%4%, bytes:%5%")
+              % locality
+              % sourceNames[s]
+              % ans.service.count()
+              % ans.service.str()
+              % ans.bytes.str())
+          << hpx::endl;
+    }
+  }
+}
+
+void printAllReports() {
+  YewPar::util::printOnEachLocality<printReport_act>();
+}
+
+void registerPerformanceCounters() {
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/steals/SearchManager/latencyHistogram",
+      &victimHistogram<SearchManager, &Victim::latency>,
+      "Returns the number of distributed SearchManager steals from this locality per log2 bucket of round trip time (ns)"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/steals/SearchManager/nodesHistogram",
+      &victimHistogram<SearchManager, &Victim::nodes>,
+      "Returns the number of successful distributed SearchManager steals from this locality per log2 bucket of nodes received"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/steals/SearchManager/answerTimeHistogram",
+      &answeredHistogram<SearchManager, &Answered::service>,
+      "Returns the number of distributed SearchManager steals answered by this locality per log2 bucket of time taken (ns)"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/steals/SearchManager/bytesHistogram",
+      &answeredHistogram<SearchManager, &Answered::bytes>,
+      "Returns the number of distributed SearchManager steals answered by this locality per log2 bucket of bytes sent"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/steals/DepthPool/latencyHistogram",
+      &victimHistogram<DepthPool, &Victim::latency>,
+      "Returns the number of distributed DepthPool steals from this locality per log2 bucket of round trip time (ns)"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/steals/DepthPool/nodesHistogram",
+      &victimHistogram<DepthPool, &Victim::nodes>,
+      "Returns the number of successful distributed DepthPool steals from this locality per log2 bucket of tasks received"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/steals/DepthPool/answerTimeHistogram",
+      &answeredHistogram<DepthPool, &Answered::service>,
+      "Returns the number of distributed DepthPool steals answered by this locality per log2 bucket of time taken (ns)"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/steals/DepthPool/bytesHistogram",
+      &answeredHistogram<DepthPool, &Answered::bytes>,
+      "Returns the number of distributed DepthPool steals answered by this locality per log2 bucket of bytes sent"
+                                                  );
+}
+
+}}
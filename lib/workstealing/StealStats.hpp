@@ -0,0 +1,73 @@
+#ifndef YEWPAR_STEALSTATS_HPP
+#define YEWPAR_STEALSTATS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "hpx/runtime/actions/plain_action.hpp"
+#include "hpx/runtime/serialization/output_archive.hpp"
+
+// Histograms of distributed steals, for SearchManager and DepthPoolPolicy.
+//
+// Every histogram has a fixed number of power of two buckets (bucket b counts values in
+// [2^b, 2^(b+1)), bucket 0 also counts 0), so recording is a couple of relaxed increments and the
+// memory used doesn't grow with the length of the search. The thief records the round trip time
+// and the size of the response in nodes, per victim locality. What a response costs the victim, the
+// time taken to answer and the serialized size, is only known on the victim and recorded there, so
+// each locality's report holds its own answering costs; both ends reset when the schedulers start.
+namespace Workstealing { namespace StealStats {
+
+enum Source : unsigned {
+  SearchManager,
+  DepthPool,
+  numSources
+};
+
+using clock = std::chrono::steady_clock;
+
+// Thief side: a steal from victim (a locality id) came back after latency with nodes nodes
+void stealReturned(Source s, std::uint32_t victim, clock::duration latency, std::uint64_t nodes);
+
+// Victim side: answering a steal took service and sent bytes bytes (only recorded when enabled)
+void stealAnswered(Source s, clock::duration service, std::uint64_t bytes);
+
+// Whether victims measure the serialized size of their responses, which means serializing them a
+// second time. Searches that print the reports turn it on, as does reading a bytesHistogram
+// counter (from then on).
+bool enabled();
+void setEnabled(bool on);
+HPX_DEFINE_PLAIN_ACTION(setEnabled, setEnabled_act);
+
+// setEnabled on every locality
+void setEnabledEverywhere(bool on);
+
+// Serialized size of a steal response, for stealAnswered, or 0 if the sizes aren't enabled
+template <typename T>
+std::uint64_t serializedSize(const T & response) {
+  if (!enabled()) {
+    return 0;
+  }
+  static thread_local std::vector<char> buf;
+  buf.clear();
+  hpx::serialization::output_archive ar(buf);
+  ar << response;
+  return ar.bytes_written();
+}
+
+// Zero all histograms, called when the schedulers start
+void reset();
+
+// Histograms of the last search on this locality
+void printReport();
+HPX_DEFINE_PLAIN_ACTION(printReport, printReport_act);
+
+// printReport on every locality in turn
+void printAllReports();
+
+void registerPerformanceCounters();
+
+}}
+
+#endif
@@ -0,0 +1,86 @@
+#include "Termination.hpp"
+
+#include "hpx/lcos/broadcast.hpp"
+#include "hpx/runtime/find_here.hpp"
+#include "hpx/runtime/threads/thread_helpers.hpp"
+#include "hpx/include/threads.hpp"
+
+#include "util/PerWorker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+namespace Workstealing { namespace Termination {
+
+namespace {
+
+// One pair of counters per worker thread so counting doesn't bounce a single cache line between
+// all workers
+struct Counters {
+  std::atomic<std::uint64_t> spawned {0};
+  std::atomic<std::uint64_t> completed {0};
+};
+
+YewPar::util::PerWorker<Counters> counters;
+
+// Bounds on the time between collection waves
+constexpr auto initialWaveDelay = std::chrono::microseconds(100);
+constexpr auto maxWaveDelay = std::chrono::microseconds(10000);
+
+}
+
+void taskSpawned() {
+  counters.mine().spawned.fetch_add(1);
+}
+
+void taskCompleted() {
+  counters.mine().completed.fetch_add(1);
+}
+
+void reset() {
+  counters.forEach([](Counters & c) {
+      c.spawned.store(0);
+      c.completed.store(0);
+    });
+}
+
+std::vector<std::uint64_t> getCounts() {
+  std::uint64_t spawned = 0, completed = 0;
+  // Completed first: a task completing after we read it must have been spawned before we read
+  // spawned, so a wave can never see more completions than spawns
+  counters.forEach([&](Counters & c) { completed += c.completed.load(); });
+  counters.forEach([&](Counters & c) { spawned += c.spawned.load(); });
+  return {spawned, completed};
+}
+
+void waitForTermination() {
+  auto delay = initialWaveDelay;
+  std::uint64_t prevSpawned = 0, prevCompleted = 0;
+  bool havePrev = false;
+
+  for (;;) {
+    std::uint64_t spawned = 0, completed = 0;
+    for (const auto & c : hpx::lcos::broadcast<getCounts_act>(hpx::find_all_localities()).get()) {
+      spawned += c[0];
+      completed += c[1];
+    }
+
+    if (spawned == completed) {
+      if (havePrev && spawned == prevSpawned && completed == prevCompleted) {
+        return;
+      }
+      // Balanced, confirm with a second wave straight away
+      prevSpawned = spawned;
+      prevCompleted = completed;
+      havePrev = true;
+      continue;
+    }
+
+    havePrev = false;
+    hpx::this_thread::sleep_for(delay);
+    delay = std::min(delay * 2, maxWaveDelay);
+  }
+}
+
+}}
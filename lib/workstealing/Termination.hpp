@@ -0,0 +1,37 @@
+#ifndef YEWPAR_TERMINATION_HPP
+#define YEWPAR_TERMINATION_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "hpx/runtime/actions/plain_action.hpp"
+#include "hpx/runtime/serialization/vector.hpp"
+
+// Counter based termination detection, an alternative to tracking every task with a promise.
+//
+// Each locality counts the tasks it spawns and the tasks it completes. The search is finished once
+// the totals over all localities balance in two consecutive collection waves (Mattern's four
+// counter method): as every counter only grows, identical waves mean no counter changed between
+// them, so at that point every spawned task had completed.
+namespace Workstealing { namespace Termination {
+
+// Must be called before the task is made visible to other threads (e.g. added to a workpool)
+void taskSpawned();
+
+// Must be called after the task has spawned all of its children and published its results
+void taskCompleted();
+
+// Clear the counters, all localities must be reset before the first task of a search is spawned
+void reset();
+HPX_DEFINE_PLAIN_ACTION(reset, reset_act);
+
+// {spawned, completed} on this locality
+std::vector<std::uint64_t> getCounts();
+HPX_DEFINE_PLAIN_ACTION(getCounts, getCounts_act);
+
+// Blocks (suspending the HPX thread) until all tasks spawned on any locality have completed
+void waitForTermination();
+
+}}
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef YEWPAR_VICTIM_LISTS_HPP
+#define YEWPAR_VICTIM_LISTS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <hpx/lcos/async.hpp>
+#include <hpx/lcos/broadcast.hpp>
+#include <hpx/lcos/future.hpp>
+#include <hpx/lcos/wait_all.hpp>
+#include <hpx/runtime/naming/id_type.hpp>
+
+#include "util/RuntimeOptions.hpp"
+
+// Which remote victims each locality steals from.
+//
+// By default every locality knows every other locality's workpool (or search manager). On large
+// clusters that is O(P^2) ids to send out, and to check for colocation, before every search, so
+// with --yewpar:victims n each locality instead gets n of them: the next locality round the ring,
+// which keeps every locality reachable by stealing, and a random sample of the rest. Work then
+// spreads over a random graph of degree n rather than the complete one.
+namespace workstealing {
+
+// Victims of locality self out of all (one entry per locality, in locality order): all the others,
+// or with maxVictims > 0 and more than that many others, self's ring successor plus a sample
+template <typename Victim>
+std::vector<Victim> sampleVictims(const std::vector<Victim> & all,
+                                  const std::size_t self,
+                                  const std::size_t maxVictims,
+                                  const std::uint64_t seed) {
+  std::vector<Victim> res;
+  auto n = all.size();
+  if (maxVictims == 0 || n <= maxVictims + 1) {
+    res.reserve(n);
+    for (auto i = 0u; i < n; ++i) {
+      if (i != self) {
+        res.push_back(all[i]);
+      }
+    }
+    return res;
+  }
+
+  // Floyd's algorithm over the others, bar the successor: n - 2 candidates, offset from self + 2
+  std::mt19937_64 rng(seed);
+  std::vector<std::size_t> picked {1};
+  for (auto j = n - 2 - (maxVictims - 1); j < n - 2; ++j) {
+    auto t = std::uniform_int_distribution<std::size_t>(0, j)(rng) + 2;
+    picked.push_back(std::find(picked.begin(), picked.end(), t) == picked.end() ? t : j + 2);
+  }
+
+  res.reserve(picked.size());
+  for (auto off : picked) {
+    res.push_back(all[(self + off) % n]);
+  }
+  return res;
+}
+
+// Send targets[i] its victims out of victims (one per locality, in locality order) with SetAct.
+// Targets may be the localities themselves or anything living on them, such as the victims.
+template <typename SetAct>
+void distributeVictimsTo(const std::vector<hpx::naming::id_type> & targets,
+                         const std::vector<hpx::naming::id_type> & victims) {
+  auto maxVictims = YewPar::util::RuntimeOptions::get().victims;
+
+  std::random_device rd;
+  auto seed = (static_cast<std::uint64_t>(rd()) << 32) | rd();
+  std::vector<hpx::future<void> > futs;
+  futs.reserve(targets.size());
+  for (auto i = 0u; i < targets.size(); ++i) {
+    futs.push_back(hpx::async<SetAct>(targets[i], sampleVictims(victims, i, maxVictims, seed + i)));
+  }
+  hpx::wait_all(futs);
+}
+
+// distributeVictimsTo the localities. Without a --yewpar:victims limit this is a single broadcast of
+// the full list.
+template <typename SetAct>
+void distributeVictims(const std::vector<hpx::naming::id_type> & localities,
+                       const std::vector<hpx::naming::id_type> & victims) {
+  auto maxVictims = YewPar::util::RuntimeOptions::get().victims;
+  if (maxVictims == 0 || victims.size() <= maxVictims + 1) {
+    hpx::wait_all(hpx::lcos::broadcast<SetAct>(localities, victims));
+    return;
+  }
+  distributeVictimsTo<SetAct>(localities, victims);
+}
+
+}
+
+#endif
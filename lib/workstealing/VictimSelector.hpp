@@ -0,0 +1,122 @@
+#ifndef YEWPAR_VICTIM_SELECTOR_HPP
+#define YEWPAR_VICTIM_SELECTOR_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+namespace workstealing {
+
+// Chooses remote steal victims, weighting each victim by how quickly and how often it has answered
+// steals in the past. On clusters where some localities are much further away (e.g. cross rack)
+// this biases thieves towards cheap victims while still sampling the expensive ones occasionally.
+//
+// Victims are referred to by index so callers can keep their own bookkeeping (e.g. last steal).
+// Not thread safe; policies call it while holding their steal lock.
+template <typename Victim>
+class LatencyWeightedSelector {
+ public:
+  using clock = std::chrono::steady_clock;
+
+ private:
+  struct Stats {
+    // Exponentially weighted moving averages, rtt in microseconds. rtt < 0 means never measured.
+    double rtt = -1.0;
+    double successRate = 1.0;
+  };
+
+  std::vector<Victim> victims;
+  std::vector<Stats> stats;
+
+  // Weight given to the newest sample
+  static constexpr double alpha = 0.25;
+
+  // Floors so a victim is never starved completely (it might have work later)
+  static constexpr double minSuccessRate = 0.05;
+  static constexpr double minRtt = 1.0;
+
+  std::vector<double> cumulative;
+
+ public:
+  LatencyWeightedSelector() = default;
+
+  explicit LatencyWeightedSelector(std::vector<Victim> vs) { setVictims(std::move(vs)); }
+
+  void setVictims(std::vector<Victim> vs) {
+    victims = std::move(vs);
+    stats.assign(victims.size(), Stats());
+    cumulative.resize(victims.size());
+  }
+
+  // A victim that appeared later (a locality joining a running search), unmeasured to begin with
+  void addVictim(Victim v) {
+    victims.push_back(std::move(v));
+    stats.push_back(Stats());
+    cumulative.resize(victims.size());
+  }
+
+  bool empty() const { return victims.empty(); }
+  std::size_t size() const { return victims.size(); }
+  const Victim & operator[](std::size_t i) const { return victims[i]; }
+
+  // Returns the index of the victim to try next. Must not be called when empty().
+  template <typename RNG>
+  std::size_t pick(RNG & rng) {
+    std::size_t res = 0;
+    pick(rng, [](const Victim &) { return true; }, res);
+    return res;
+  }
+
+  // As above but only considers victims for which allowed(victim) holds. Returns false if there
+  // are none.
+  template <typename RNG, typename Pred>
+  bool pick(RNG & rng, Pred allowed, std::size_t & res) {
+    // Unmeasured victims are assumed to be as fast as the fastest known one so they get explored
+    double bestRtt = -1.0;
+    for (const auto & s : stats) {
+      if (s.rtt >= 0 && (bestRtt < 0 || s.rtt < bestRtt)) {
+        bestRtt = s.rtt;
+      }
+    }
+    if (bestRtt < 0) {
+      bestRtt = minRtt;
+    }
+
+    double total = 0.0;
+    for (std::size_t i = 0; i < stats.size(); ++i) {
+      if (allowed(victims[i])) {
+        auto rtt = stats[i].rtt >= 0 ? stats[i].rtt : bestRtt;
+        total += std::max(stats[i].successRate, minSuccessRate) / std::max(rtt, minRtt);
+      }
+      cumulative[i] = total;
+    }
+
+    if (total <= 0.0) {
+      return false;
+    }
+
+    // upper_bound skips over disallowed victims (which have zero width)
+    std::uniform_real_distribution<double> rand(0.0, total);
+    auto r = rand(rng);
+    auto it = std::upper_bound(cumulative.begin(), cumulative.end(), r);
+    if (it == cumulative.end()) {
+      it = std::lower_bound(cumulative.begin(), cumulative.end(), total);
+    }
+    res = std::distance(cumulative.begin(), it);
+    return true;
+  }
+
+  // Feed back the outcome of a steal from victim i
+  void record(std::size_t i, clock::duration rtt, bool success) {
+    auto us = std::chrono::duration<double, std::micro>(rtt).count();
+    auto & s = stats[i];
+    s.rtt = s.rtt < 0 ? us : (1 - alpha) * s.rtt + alpha * us;
+    s.successRate = (1 - alpha) * s.successRate + alpha * (success ? 1.0 : 0.0);
+  }
+};
+
+}
+
+#endif
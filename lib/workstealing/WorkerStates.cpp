@@ -0,0 +1,157 @@
+#include "WorkerStates.hpp"
+
+#include "hpx/include/iostreams.hpp"
+#include "hpx/performance_counters/manage_counter_type.hpp"
+#include "hpx/runtime/get_locality_id.hpp"
+#include "hpx/runtime/threads/thread_helpers.hpp"
+
+#include "util/PerWorker.hpp"
+#include "util/util.hpp"
+
+#include <boost/format.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace Workstealing { namespace WorkerStates {
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+// Scopes add to the slot of the worker they started on, whichever worker they end on, so the
+// totals are only ever updated atomically
+struct Worker {
+  std::atomic<std::uint64_t> nanos[numStates];
+
+  Worker() {
+    for (auto & n : nanos) {
+      n.store(0);
+    }
+  }
+};
+
+YewPar::util::PerWorker<Worker> workers;
+
+// The innermost open scope of the calling HPX thread is kept in its thread data, so it follows the
+// thread across suspensions. Threads outside the pool fall back to a thread_local.
+thread_local ScopedState * outsideScope = nullptr;
+
+ScopedState * innermostScope() {
+  auto id = hpx::threads::get_self_id();
+  if (id == hpx::threads::invalid_thread_id) {
+    return outsideScope;
+  }
+  return reinterpret_cast<ScopedState *>(hpx::threads::get_thread_data(id));
+}
+
+void setInnermostScope(ScopedState * s) {
+  auto id = hpx::threads::get_self_id();
+  if (id == hpx::threads::invalid_thread_id) {
+    outsideScope = s;
+    return;
+  }
+  hpx::threads::set_thread_data(id, reinterpret_cast<std::size_t>(s));
+}
+
+template <State s>
+std::uint64_t total(bool reset) {
+  std::uint64_t sum = 0;
+  workers.forEach([&](Worker & w) {
+      sum += reset ? w.nanos[s].exchange(0) : w.nanos[s].load();
+    });
+  return sum;
+}
+
+double millis(std::uint64_t ns) {
+  return ns / 1e6;
+}
+
+}
+
+ScopedState::ScopedState(State s)
+    : slot(workers.myIndex()), state(s), start(clock::now()), enclosing(innermostScope()) {
+  setInnermostScope(this);
+}
+
+ScopedState::~ScopedState() {
+  std::uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+  workers[slot].nanos[state].fetch_add(ns > innerNanos ? ns - innerNanos : 0, std::memory_order_relaxed);
+  if (enclosing) {
+    enclosing->innerNanos += ns;
+  }
+  setInnermostScope(enclosing);
+}
+
+void reset() {
+  workers.forEach([](Worker & w) {
+      for (auto & n : w.nanos) {
+        n.store(0);
+      }
+    });
+}
+
+void printReport() {
+  auto locality = static_cast<std::int64_t>(hpx::get_locality_id());
+  for (std::size_t i = 0; i < workers.size(); ++i) {
+    const auto & n = workers[i].nanos;
+    std::uint64_t sum = 0;
+    for (const auto & x : n) {
+      sum += x.load();
+    }
+    if (sum == 0) {
+      continue;
+    }
+
+    hpx::cout
+        << (boost::format("%1% Worker %2%: searching %3%ms, stealing %4%ms, steal wait %5%ms, backoff %6%ms, incumbent %7%ms")
+            % locality
+            % (workers.isShared(i) ? std::string("other") : std::to_string(i))
+            % millis(n[Searching].load())
+            % millis(n[Stealing].load())
+            % millis(n[StealWait].load())
+            % millis(n[Backoff].load())
+            % millis(n[Incumbent].load()))
+        << hpx::endl;
+  }
+}
+
+void printAllReports() {
+  YewPar::util::printOnEachLocality<printReport_act>();
+}
+
+void registerPerformanceCounters() {
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/workers/searchingTime",
+      &total<Searching>,
+      "Returns the time (ns) workers on this locality spent running tasks"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/workers/stealingTime",
+      &total<Stealing>,
+      "Returns the time (ns) workers on this locality spent looking for work"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/workers/stealWaitTime",
+      &total<StealWait>,
+      "Returns the time (ns) workers on this locality spent waiting for steal responses"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/workers/backoffTime",
+      &total<Backoff>,
+      "Returns the time (ns) workers on this locality spent yielding or parked without work"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/workers/incumbentTime",
+      &total<Incumbent>,
+      "Returns the time (ns) workers on this locality spent submitting new incumbents"
+                                                  );
+}
+
+}}
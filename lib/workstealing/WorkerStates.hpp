@@ -0,0 +1,67 @@
+#ifndef YEWPAR_WORKERSTATES_HPP
+#define YEWPAR_WORKERSTATES_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "hpx/runtime/actions/plain_action.hpp"
+
+// Where each worker's time goes.
+//
+// Each scope times itself and charges its time on exit, so timing costs two clock reads per state
+// change (a handful per task), not per node. States nest per HPX thread: an inner scope's time is
+// taken out of the enclosing one, so the times are exclusive. A scope charges the worker it was
+// entered on, even if its HPX thread is resumed elsewhere; a thread that suspends inside a state
+// (e.g. waiting on a steal) keeps charging it while others run on the worker, so a worker's states
+// can add up to more than its wall time.
+namespace Workstealing { namespace WorkerStates {
+
+enum State : unsigned {
+  Searching,     // running tasks
+  Stealing,      // looking for work in the policy
+  StealWait,     // waiting for a (remote) victim to answer a steal
+  Backoff,       // yielding or parked for lack of work
+  Incumbent,     // handing a new incumbent to BoundPropagation
+  numStates
+};
+
+// Charge the time until destruction to s on the worker it was constructed on
+class ScopedState {
+ public:
+  explicit ScopedState(State s);
+  ~ScopedState();
+
+  ScopedState(const ScopedState &) = delete;
+  ScopedState & operator=(const ScopedState &) = delete;
+
+ private:
+  std::size_t slot;
+  State state;
+  std::chrono::steady_clock::time_point start;
+  std::uint64_t innerNanos = 0;  // charged by nested scopes
+  ScopedState * enclosing;
+};
+
+// f(), charged to s
+template <typename F>
+auto inState(State s, F && f) -> decltype(f()) {
+  ScopedState scope(s);
+  return f();
+}
+
+// Zero all timers, called when the schedulers start
+void reset();
+
+// Per worker times on this locality
+void printReport();
+HPX_DEFINE_PLAIN_ACTION(printReport, printReport_act);
+
+// printReport on every locality in turn
+void printAllReports();
+
+void registerPerformanceCounters();
+
+}}
+
+#endif
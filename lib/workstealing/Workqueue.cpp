@@ -34,7 +34,7 @@ namespace workstealing
   }
 
   void Workqueue::addWork(funcType task) {
-    tasks.push_left(task);
+    tasks.push_left(std::move(task));
   }
 }
 HPX_REGISTER_COMPONENT_MODULE();
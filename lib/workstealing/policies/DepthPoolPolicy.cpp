@@ -2,11 +2,17 @@
 
 #include <hpx/util/function.hpp>
 #include <hpx/runtime/find_here.hpp>
+#include <hpx/runtime/get_ptr.hpp>
+#include <hpx/runtime/naming/name.hpp>
 #include <hpx/performance_counters/manage_counter_type.hpp>
 
+#include <algorithm>
 #include <memory>
 
 #include "util/util.hpp"
+#include "workstealing/LoadGossip.hpp"
+#include "workstealing/StealStats.hpp"
+#include "workstealing/WorkerStates.hpp"
 
 namespace Workstealing { namespace Policies {
 
@@ -17,6 +23,7 @@ std::atomic<std::uint64_t> perf_localSteals(0);
 std::atomic<std::uint64_t> perf_distributedSteals(0);
 std::atomic<std::uint64_t> perf_failedLocalSteals(0);
 std::atomic<std::uint64_t> perf_failedDistributedSteals(0);
+std::atomic<std::uint64_t> perf_distributedStolenTasks(0);
 
 std::uint64_t get_and_reset(std::atomic<std::uint64_t> & cntr, bool reset) {
   auto res = cntr.load();
@@ -29,6 +36,7 @@ std::uint64_t getLocalSteals(bool reset) { return get_and_reset(perf_localSteals
 std::uint64_t getDistributedSteals (bool reset) { return get_and_reset(perf_distributedSteals, reset);}
 std::uint64_t getFailedLocalSteals(bool reset) { return get_and_reset(perf_failedLocalSteals, reset);}
 std::uint64_t getFailedDistributedSteals(bool reset) { return get_and_reset(perf_failedDistributedSteals, reset);}
+std::uint64_t getDistributedStolenTasks(bool reset) { return get_and_reset(perf_distributedStolenTasks, reset);}
 
 void registerPerformanceCounters() {
   hpx::performance_counters::install_counter_type(
@@ -60,23 +68,64 @@ void registerPerformanceCounters() {
       &getFailedDistributedSteals,
       "Returns the number of failed steals from another locality "
                                                   );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/depthpool/distributedStolenTasks",
+      &getDistributedStolenTasks,
+      "Returns the number of tasks received from other localities (a steal can return several)"
+                                                  );
 }
 
 }
 
 DepthPoolPolicy::DepthPoolPolicy(hpx::naming::id_type workpool) {
   local_workpool = workpool;
-  last_remote = hpx::find_here();
+  local_pool = hpx::get_ptr<workstealing::DepthPool>(hpx::launch::sync, workpool);
 
   std::random_device rd;
   randGenerator.seed(rd());
 }
 
-hpx::util::function<void(), false> DepthPoolPolicy::getWork() {
-  std::unique_lock<mutex_t> l(mtx);
+hpx::util::function<void(), false> DepthPoolPolicy::stealFrom(std::size_t victim) {
+  auto start = decltype(victims)::clock::now();
+  auto chunk = WorkerStates::inState(WorkerStates::StealWait, [&]() {
+      return hpx::async<workstealing::DepthPool::stealChunk_action>(victims[victim], chunkSize).get();
+    });
+  auto latency = decltype(victims)::clock::now() - start;
+  victims.record(victim, latency, !chunk.empty());
+  StealStats::stealReturned(StealStats::DepthPool, hpx::naming::get_locality_id_from_id(victims[victim]),
+                            latency, chunk.size());
+
+  if (chunk.empty()) {
+    DepthPoolPolicyPerf::perf_failedDistributedSteals++;
+    chunkSize = std::max(1u, chunkSize / 2);
+    return nullptr;
+  }
+
+  DepthPoolPolicyPerf::perf_distributedSteals++;
+  DepthPoolPolicyPerf::perf_distributedStolenTasks += chunk.size();
+
+  // Victim had at least as much as we asked for, ask for more next time
+  if (chunk.size() == chunkSize) {
+    chunkSize = std::min(maxChunkSize, chunkSize * 2);
+  }
+
+  // Keep the stolen tasks at the depth (and priority) they came from so the usual local order still
+  // applies
+  if (chunk.size() > 1) {
+    for (auto i = 1; i < chunk.size(); ++i) {
+      local_pool->addPrioritisedWork(std::move(hpx::util::get<1>(chunk[i])), hpx::util::get<0>(chunk[i]),
+                                     hpx::util::get<2>(chunk[i]));
+    }
+    Workstealing::Scheduler::notifyWorkAvailable();
+  }
+
+  return hpx::util::bind(std::move(hpx::util::get<1>(chunk[0])), hpx::find_here());
+}
 
+hpx::util::function<void(), false> DepthPoolPolicy::getWork() {
   hpx::util::function<void(hpx::naming::id_type)> task;
-  task = hpx::async<workstealing::DepthPool::getLocal_action>(local_workpool).get();
+  task = local_pool->getLocal();
 
   if (task) {
     DepthPoolPolicyPerf::perf_localSteals++;
@@ -85,31 +134,37 @@ hpx::util::function<void(), false> DepthPoolPolicy::getWork() {
     DepthPoolPolicyPerf::perf_failedLocalSteals++;
   }
 
-  if (!distributed_workpools.empty()) {
+  if (isCancelled()) {
+    return nullptr;
+  }
+
+  // Only one thread steals remotely at a time, others just retry locally
+  std::unique_lock<mutex_t> l(mtx, std::try_to_lock);
+  if (!l.owns_lock()) {
+    return nullptr;
+  }
+
+  if (!victims.empty()) {
     // Last steal optimisation
-    if (last_remote != hpx::find_here()) {
-      task = hpx::async<workstealing::DepthPool::steal_action>(last_remote).get();
-      if (task) {
-        DepthPoolPolicyPerf::perf_distributedSteals++;
-        return hpx::util::bind(task, hpx::find_here());
-      } else {
-        DepthPoolPolicyPerf::perf_failedDistributedSteals++;
-        last_remote = hpx::find_here();
+    if (last_remote >= 0 && LoadGossip::advertisesWork(victims[last_remote])) {
+      auto stolen = stealFrom(last_remote);
+      if (stolen) {
+        return stolen;
       }
     }
-
-    // If we fail the last steal then we try else where
-    std::uniform_int_distribution<int> rand(0, distributed_workpools.size() - 1);
-    auto victim = distributed_workpools.begin();
-    std::advance(victim, rand(randGenerator));
-    task = hpx::async<workstealing::DepthPool::steal_action>(*victim).get();
-
-    if (task) {
-      last_remote = *victim;
-      DepthPoolPolicyPerf::perf_distributedSteals++;
-      return hpx::util::bind(task, hpx::find_here());
-    } else {
-      DepthPoolPolicyPerf::perf_failedDistributedSteals++;
+    last_remote = -1;
+
+    // If we fail the last steal then we try else where, favouring close/productive victims that
+    // claim to have work
+    std::size_t victim;
+    if (!victims.pick(randGenerator, LoadGossip::advertisesWork, victim)) {
+      LoadGossip::recordSkippedSteal();
+      return nullptr;
+    }
+    auto stolen = stealFrom(victim);
+    if (stolen) {
+      last_remote = victim;
+      return stolen;
     }
   }
 
@@ -117,17 +172,30 @@ hpx::util::function<void(), false> DepthPoolPolicy::getWork() {
 }
 
 void DepthPoolPolicy::addwork(hpx::util::function<void(hpx::naming::id_type)> task, unsigned depth) {
-  std::unique_lock<mutex_t> l(mtx);
   DepthPoolPolicyPerf::perf_spawns++;
-  hpx::apply<workstealing::DepthPool::addWork_action>(local_workpool, task, depth);
+  local_pool->addWork(std::move(task), depth);
+  Workstealing::Scheduler::notifyWorkAvailable();
+}
+
+void DepthPoolPolicy::addwork(hpx::util::function<void(hpx::naming::id_type)> task, unsigned depth,
+                              double priority) {
+  DepthPoolPolicyPerf::perf_spawns++;
+  local_pool->addPrioritisedWork(std::move(task), depth, priority);
+  Workstealing::Scheduler::notifyWorkAvailable();
 }
 
 void DepthPoolPolicy::registerDistributedDepthPools(std::vector<hpx::naming::id_type> workpools) {
   std::unique_lock<mutex_t> l(mtx);
-  distributed_workpools = workpools;
-  distributed_workpools .erase(
-      std::remove_if(distributed_workpools.begin(), distributed_workpools.end(), YewPar::util::isColocated),
-      distributed_workpools.end());
+  workpools.erase(
+      std::remove_if(workpools.begin(), workpools.end(), YewPar::util::isColocated),
+      workpools.end());
+  victims.setVictims(std::move(workpools));
+  last_remote = -1;
+}
+
+void DepthPoolPolicy::addDistributedDepthPool(hpx::naming::id_type workpool) {
+  std::unique_lock<mutex_t> l(mtx);
+  victims.addVictim(std::move(workpool));
 }
 
 }}
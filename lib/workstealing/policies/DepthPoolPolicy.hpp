@@ -13,11 +13,17 @@
 #include <hpx/runtime/actions/basic_action.hpp>
 
 #include "../DepthPool.hpp"
+#include "../VictimSelector.hpp"
+#include "../VictimLists.hpp"
 
+#include <memory>
 #include <random>
 #include <vector>
 
-namespace Workstealing { namespace Scheduler {extern std::shared_ptr<Policy> local_policy; }}
+namespace Workstealing { namespace Scheduler {
+extern std::shared_ptr<Policy> local_policy;
+void notifyWorkAvailable();
+}}
 
 namespace Workstealing { namespace Policies {
 
@@ -26,30 +32,51 @@ void registerPerformanceCounters();
 }
 
 
-// TODO: Performance counters
 class DepthPoolPolicy : public Policy {
 
  private:
   hpx::naming::id_type local_workpool;
-  hpx::naming::id_type last_remote;
-  std::vector<hpx::naming::id_type> distributed_workpools;
+  // Direct access to the co-located pool so local spawns/pops avoid the action layer
+  std::shared_ptr<workstealing::DepthPool> local_pool;
+
+  // Remote pools, chosen by steal latency/success. last_remote is an index into victims (-1 if the
+  // last distributed steal failed)
+  workstealing::LatencyWeightedSelector<hpx::naming::id_type> victims;
+  int last_remote = -1;
 
   // random number generator
   std::mt19937 randGenerator;
 
+  // Protects the distributed steal state. Local pops/pushes don't take it.
   using mutex_t = hpx::lcos::local::mutex;
   mutex_t mtx;
 
+  // Number of tasks to ask for on a distributed steal. Grows while steals succeed and shrinks when
+  // they fail, so a busy victim gets drained in a few round trips while a near idle system
+  // doesn't move tasks around needlessly. Protected by mtx.
+  static constexpr unsigned maxChunkSize = 64;
+  unsigned chunkSize = 1;
+
+  // Steal a chunk from the victim, run the first task and push the rest into the local pool
+  hpx::util::function<void(), false> stealFrom(std::size_t victim);
+
  public:
   DepthPoolPolicy(hpx::naming::id_type workpool);
   ~DepthPoolPolicy() = default;
 
   hpx::util::function<void(), false> getWork() override;
 
+  std::uint64_t localLoad() override { return local_pool->size(); }
+
   void addwork(hpx::util::function<void(hpx::naming::id_type)> task, unsigned depth);
 
+  // For prioritised pools (see DepthPool), higher priorities run first within a depth
+  void addwork(hpx::util::function<void(hpx::naming::id_type)> task, unsigned depth, double priority);
+
   void registerDistributedDepthPools(std::vector<hpx::naming::id_type> workpools);
 
+  void addDistributedDepthPool(hpx::naming::id_type workpool);
+
   static void setDepthPool(hpx::naming::id_type localworkpool) {
     Workstealing::Scheduler::local_policy = std::make_shared<DepthPoolPolicy>(localworkpool);
   }
@@ -66,16 +93,63 @@ class DepthPoolPolicy : public Policy {
     &DepthPoolPolicy::setDistributedDepthPools,
     setDistributedDepthPools_act>::type {};
 
-  static void initPolicy() {
-    std::vector<hpx::future<void> > futs;
+  static void addDistributedDepthPoolTo(hpx::naming::id_type workpool) {
+    std::static_pointer_cast<Workstealing::Policies::DepthPoolPolicy>(Workstealing::Scheduler::local_policy)->addDistributedDepthPool(workpool);
+  }
+  struct addDistributedDepthPool_act : hpx::actions::make_action<
+    decltype(&DepthPoolPolicy::addDistributedDepthPoolTo),
+    &DepthPoolPolicy::addDistributedDepthPoolTo,
+    addDistributedDepthPool_act>::type {};
+
+  // The pools and localities of the current search, on the locality that set it up
+  struct Members {
+    bool prioritised = false;
+    unsigned levels = workstealing::DepthPool::defaultLevels;
+    std::vector<hpx::naming::id_type> localities;
     std::vector<hpx::naming::id_type> pools;
-    for (auto const& loc : hpx::find_all_localities()) {
-      auto depthpool = hpx::new_<workstealing::DepthPool>(loc).get();
-      futs.push_back(hpx::async<setDepthPool_act>(loc, depthpool));
-      pools.push_back(depthpool);
+  };
+
+  static Members & members() {
+    static Members m;
+    return m;
+  }
+
+  // Pools are created on all localities at once, victim lists as in workstealing/VictimLists.hpp.
+  // levels should cover the deepest task spawned, deeper ones share the last level.
+  static void initPolicy(bool prioritised = false,
+                         unsigned levels = workstealing::DepthPool::defaultLevels) {
+    auto localities = hpx::find_all_localities();
+    std::vector<hpx::future<hpx::naming::id_type> > created;
+    for (auto const& loc : localities) {
+      created.push_back(hpx::new_<workstealing::DepthPool>(loc, prioritised, levels));
+    }
+
+    std::vector<hpx::naming::id_type> pools;
+    std::vector<hpx::future<void> > futs;
+    for (auto i = 0u; i < localities.size(); ++i) {
+      pools.push_back(created[i].get());
+      futs.push_back(hpx::async<setDepthPool_act>(localities[i], pools.back()));
     }
     hpx::wait_all(futs);
-    hpx::wait_all(hpx::lcos::broadcast<setDistributedDepthPools_act>(hpx::find_all_localities(), pools));
+    workstealing::distributeVictims<setDistributedDepthPools_act>(localities, pools);
+    members() = Members {prioritised, levels, std::move(localities), std::move(pools)};
+  }
+
+  // Give a locality that joined the running search (see util/LocalityJoin.hpp) a pool, and add it
+  // to every victim list. Called on the locality that ran initPolicy.
+  static void joinLocality(const hpx::naming::id_type & loc) {
+    auto & m = members();
+    auto depthpool = hpx::new_<workstealing::DepthPool>(loc, m.prioritised, m.levels).get();
+    hpx::async<setDepthPool_act>(loc, depthpool).get();
+
+    auto pools = m.pools;
+    pools.push_back(depthpool);
+    hpx::async<setDistributedDepthPools_act>(loc, workstealing::sampleVictims(
+        pools, pools.size() - 1, YewPar::util::RuntimeOptions::get().victims, std::random_device()())).get();
+    hpx::wait_all(hpx::lcos::broadcast<addDistributedDepthPool_act>(m.localities, depthpool));
+
+    m.localities.push_back(loc);
+    m.pools.push_back(depthpool);
   }
 };
 
@@ -0,0 +1,246 @@
+#include "PerThreadWorkpool.hpp"
+
+#include <hpx/util/function.hpp>
+#include <hpx/runtime/find_here.hpp>
+#include <hpx/runtime/threads/thread_helpers.hpp>
+#include <hpx/performance_counters/manage_counter_type.hpp>
+
+#include <algorithm>
+#include <memory>
+
+#include "util/util.hpp"
+#include "workstealing/LoadGossip.hpp"
+#include "workstealing/VictimLists.hpp"
+#include "workstealing/WorkerStates.hpp"
+
+namespace Workstealing { namespace Policies {
+
+namespace PerThreadWorkpoolPerf {
+
+std::atomic<std::uint64_t> perf_spawns(0);
+std::atomic<std::uint64_t> perf_localSteals(0);
+std::atomic<std::uint64_t> perf_distributedSteals(0);
+std::atomic<std::uint64_t> perf_failedLocalSteals(0);
+std::atomic<std::uint64_t> perf_failedDistributedSteals(0);
+
+std::uint64_t get_and_reset(std::atomic<std::uint64_t> & cntr, bool reset) {
+  auto res = cntr.load();
+  if (reset) { cntr = 0; }
+  return res;
+}
+
+std::uint64_t getSpawns (bool reset) { return get_and_reset(perf_spawns, reset);}
+std::uint64_t getLocalSteals(bool reset) { return get_and_reset(perf_localSteals, reset);}
+std::uint64_t getDistributedSteals (bool reset) { return get_and_reset(perf_distributedSteals, reset);}
+std::uint64_t getFailedLocalSteals(bool reset) { return get_and_reset(perf_failedLocalSteals, reset);}
+std::uint64_t getFailedDistributedSteals(bool reset) { return get_and_reset(perf_failedDistributedSteals, reset);}
+
+void registerPerformanceCounters() {
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/PerThreadWorkpool/spawns",
+      &getSpawns,
+      "Returns the number of tasks spawned on this locality"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/PerThreadWorkpool/localSteals",
+      &getLocalSteals,
+      "Returns the number of tasks stolen from another thread on the same locality"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/PerThreadWorkpool/distributedSteals",
+      &getDistributedSteals,
+      "Returns the number of tasks stolen from another thread on another locality"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/PerThreadWorkpool/localFailedSteals",
+      &getFailedLocalSteals,
+      "Returns the number of failed steals from this locality "
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/PerThreadWorkpool/distributedFailedSteals",
+      &getFailedDistributedSteals,
+      "Returns the number of failed steals from another locality "
+                                                  );
+
+}
+
+}
+
+PerThreadWorkpool::PerThreadWorkpool() : overflowSize(0) {
+  auto nThreads = hpx::get_os_thread_count();
+  deques.reserve(nThreads);
+  for (auto i = 0; i < nThreads; ++i) {
+    deques.emplace_back(new workstealing::ChaseLevDeque<fnType>());
+  }
+
+  std::random_device rd;
+  randGenerator.seed(rd());
+
+  // Victims are the localities themselves, so each one samples its own (see VictimLists.hpp)
+  auto localities = hpx::find_all_localities();
+  auto self = std::find(localities.begin(), localities.end(), hpx::find_here()) - localities.begin();
+  victims.setVictims(workstealing::sampleVictims(
+      localities, self, YewPar::util::RuntimeOptions::get().victims, randGenerator()));
+}
+
+void PerThreadWorkpool::addVictimLocality(hpx::naming::id_type loc) {
+  std::lock_guard<mutex_t> l(distributedMtx);
+  victims.addVictim(std::move(loc));
+}
+
+PerThreadWorkpool::fnType PerThreadWorkpool::popOverflow() {
+  if (overflowSize.load(std::memory_order_relaxed) == 0) {
+    return nullptr;
+  }
+
+  std::unique_lock<mutex_t> l(overflowMtx);
+  if (overflow.empty()) {
+    return nullptr;
+  }
+  auto task = std::move(overflow.front());
+  overflow.pop();
+  --overflowSize;
+  return task;
+}
+
+PerThreadWorkpool::fnType PerThreadWorkpool::stealLocal(std::size_t thief) {
+  // Cheap per-thread generator, victim choice doesn't need to be high quality
+  static thread_local std::minstd_rand rng(std::random_device{}());
+
+  auto nDeques = deques.size();
+  if (nDeques > 1) {
+    std::uniform_int_distribution<std::size_t> rand(0, nDeques - 1);
+    auto start = rand(rng);
+    for (auto i = 0; i < nDeques; ++i) {
+      auto victim = (start + i) % nDeques;
+      if (victim == thief) {
+        continue;
+      }
+      auto task = deques[victim]->steal();
+      if (task) {
+        return std::move(*task);
+      }
+    }
+  }
+
+  return popOverflow();
+}
+
+PerThreadWorkpool::fnType PerThreadWorkpool::stealFromVictim(std::size_t victim) {
+  auto start = decltype(victims)::clock::now();
+  auto task = WorkerStates::inState(WorkerStates::StealWait, [&]() {
+      return hpx::async<stealFromLocality_act>(victims[victim]).get();
+    });
+  victims.record(victim, decltype(victims)::clock::now() - start, static_cast<bool>(task));
+
+  if (task) {
+    PerThreadWorkpoolPerf::perf_distributedSteals++;
+  } else {
+    PerThreadWorkpoolPerf::perf_failedDistributedSteals++;
+  }
+  return task;
+}
+
+PerThreadWorkpool::fnType PerThreadWorkpool::stealDistributed() {
+  if (victims.empty()) {
+    return nullptr;
+  }
+
+  // Someone else is already stealing remotely for this locality
+  std::unique_lock<mutex_t> l(distributedMtx, std::try_to_lock);
+  if (!l.owns_lock()) {
+    return nullptr;
+  }
+
+  fnType task;
+
+  // Last steal optimisation
+  if (last_remote >= 0 && LoadGossip::advertisesWork(victims[last_remote])) {
+    task = stealFromVictim(last_remote);
+    if (task) {
+      return task;
+    }
+  }
+  last_remote = -1;
+
+  std::size_t victim;
+  if (!victims.pick(randGenerator, LoadGossip::advertisesWork, victim)) {
+    LoadGossip::recordSkippedSteal();
+    return nullptr;
+  }
+  task = stealFromVictim(victim);
+  if (task) {
+    last_remote = victim;
+  }
+  return task;
+}
+
+hpx::util::function<void(), false> PerThreadWorkpool::getWork() {
+  auto me = hpx::get_worker_thread_num();
+
+  fnType task;
+  if (me < deques.size()) {
+    auto t = deques[me]->pop();
+    if (t) {
+      return hpx::util::bind(std::move(*t), hpx::find_here());
+    }
+  }
+
+  task = stealLocal(me);
+  if (task) {
+    PerThreadWorkpoolPerf::perf_localSteals++;
+    return hpx::util::bind(task, hpx::find_here());
+  } else {
+    PerThreadWorkpoolPerf::perf_failedLocalSteals++;
+  }
+
+  if (isCancelled()) {
+    return nullptr;
+  }
+
+  task = stealDistributed();
+  if (task) {
+    return hpx::util::bind(task, hpx::find_here());
+  }
+
+  return nullptr;
+}
+
+void PerThreadWorkpool::addwork(fnType task) {
+  PerThreadWorkpoolPerf::perf_spawns++;
+
+  auto me = hpx::get_worker_thread_num();
+  if (me < deques.size()) {
+    deques[me]->push(std::unique_ptr<fnType>(new fnType(std::move(task))));
+  } else {
+    std::unique_lock<mutex_t> l(overflowMtx);
+    overflow.push(std::move(task));
+    ++overflowSize;
+  }
+
+  Workstealing::Scheduler::notifyWorkAvailable();
+}
+
+std::uint64_t PerThreadWorkpool::localLoad() {
+  std::uint64_t load = overflowSize.load(std::memory_order_relaxed);
+  for (auto const & d : deques) {
+    load += d->size();
+  }
+  return load;
+}
+
+PerThreadWorkpool::fnType PerThreadWorkpool::steal() {
+  // Anything left is drained locally, see Policy::cancel
+  if (isCancelled()) {
+    return nullptr;
+  }
+
+  // Remote thieves aren't workers here, so no deque is excluded
+  return stealLocal(deques.size());
+}
+
+}}
@@ -0,0 +1,126 @@
+#ifndef YEWPAR_POLICY_PERTHREADWORKPOOL_HPP
+#define YEWPAR_POLICY_PERTHREADWORKPOOL_HPP
+
+#include "Policy.hpp"
+
+#include <hpx/lcos/async.hpp>
+#include <hpx/lcos/broadcast.hpp>
+#include <hpx/lcos/local/mutex.hpp>
+#include <hpx/util/function.hpp>
+#include <hpx/runtime/actions/plain_action.hpp>
+#include <hpx/runtime/actions/basic_action.hpp>
+
+#include "workstealing/ChaseLevDeque.hpp"
+#include "workstealing/VictimSelector.hpp"
+
+#include <atomic>
+#include <memory>
+#include <queue>
+#include <random>
+#include <vector>
+
+namespace Workstealing { namespace Scheduler {
+extern std::shared_ptr<Policy> local_policy;
+void notifyWorkAvailable();
+}}
+
+namespace Workstealing { namespace Policies {
+
+namespace PerThreadWorkpoolPerf {
+void registerPerformanceCounters();
+}
+
+// Workpool with one Chase-Lev deque per worker (OS) thread. The owner pushes/pops locally without
+// locks or actions, idle threads steal from a random local victim first and only go remote (via
+// actions) once every local deque has come up empty.
+class PerThreadWorkpool : public Policy {
+ public:
+  using fnType = hpx::util::function<void(hpx::naming::id_type)>;
+
+ private:
+  std::vector<std::unique_ptr<workstealing::ChaseLevDeque<fnType> > > deques;
+
+  // Threads that aren't HPX workers (should be rare) have no deque and use this instead
+  using mutex_t = hpx::lcos::local::mutex;
+  mutex_t overflowMtx;
+  std::queue<fnType> overflow;
+  std::atomic<unsigned> overflowSize;
+
+  // Only one remote steal in flight per locality
+  mutex_t distributedMtx;
+  workstealing::LatencyWeightedSelector<hpx::naming::id_type> victims;
+  int last_remote = -1;
+  std::mt19937 randGenerator;
+
+  fnType popOverflow();
+  fnType stealLocal(std::size_t thief);
+  fnType stealFromVictim(std::size_t victim);
+  fnType stealDistributed();
+
+ public:
+  PerThreadWorkpool();
+  ~PerThreadWorkpool() = default;
+
+  hpx::util::function<void(), false> getWork() override;
+
+  std::uint64_t localLoad() override;
+
+  void addwork(fnType task);
+
+  // Serves a steal from another locality
+  fnType steal();
+
+  static fnType stealFromLocality() {
+    auto policy = std::static_pointer_cast<PerThreadWorkpool>(Workstealing::Scheduler::local_policy);
+    if (!policy) {
+      return nullptr;
+    }
+    return policy->steal();
+  }
+  struct stealFromLocality_act : hpx::actions::make_action<
+    decltype(&PerThreadWorkpool::stealFromLocality),
+    &PerThreadWorkpool::stealFromLocality,
+    stealFromLocality_act>::type {};
+
+  static void setPolicy() {
+    Workstealing::Scheduler::local_policy = std::make_shared<PerThreadWorkpool>();
+  }
+  struct setPolicy_act : hpx::actions::make_action<
+    decltype(&PerThreadWorkpool::setPolicy),
+    &PerThreadWorkpool::setPolicy,
+    setPolicy_act>::type {};
+
+  void addVictimLocality(hpx::naming::id_type loc);
+
+  static void addVictimLocalityTo(hpx::naming::id_type loc) {
+    std::static_pointer_cast<PerThreadWorkpool>(Workstealing::Scheduler::local_policy)->addVictimLocality(loc);
+  }
+  struct addVictimLocality_act : hpx::actions::make_action<
+    decltype(&PerThreadWorkpool::addVictimLocalityTo),
+    &PerThreadWorkpool::addVictimLocalityTo,
+    addVictimLocality_act>::type {};
+
+  // Localities of the current search, on the locality that set it up
+  static std::vector<hpx::naming::id_type> & members() {
+    static std::vector<hpx::naming::id_type> m;
+    return m;
+  }
+
+  // Victims are localities, so there is no component list to distribute
+  static void initPolicy() {
+    members() = hpx::find_all_localities();
+    hpx::wait_all(hpx::lcos::broadcast<setPolicy_act>(members()));
+  }
+
+  // Set up a locality that joined the running search (see util/LocalityJoin.hpp), which already
+  // sees every other locality, and add it to their victim lists
+  static void joinLocality(const hpx::naming::id_type & loc) {
+    hpx::async<setPolicy_act>(loc).get();
+    hpx::wait_all(hpx::lcos::broadcast<addVictimLocality_act>(members(), loc));
+    members().push_back(loc);
+  }
+};
+
+}}
+
+#endif
@@ -3,10 +3,27 @@
 
 #include <hpx/util/function.hpp>
 
+#include <atomic>
+#include <cstdint>
+
 class Policy {
  public:
   // Scheduler hook point
   virtual hpx::util::function<void(), false> getWork() = 0;
+
+  // Estimate of how much work on this locality could be stolen remotely. Used for load gossip,
+  // policies that don't know always claim to have some.
+  virtual std::uint64_t localLoad() { return 1; }
+
+  // The search is over (a decision problem found its target). Policies stop stealing from and
+  // serving steals to other localities; getWork hands out only locally queued tasks so they can be
+  // run, see the stop flag and release their promises. Policies are recreated for each search so
+  // this is never cleared.
+  void cancel() { cancelled.store(true); }
+  bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+
+ protected:
+  std::atomic<bool> cancelled {false};
 };
 
 #endif
@@ -1,12 +1,20 @@
 #include "PriorityOrdered.hpp"
 
 #include <hpx/performance_counters/manage_counter_type.hpp>
+#include <hpx/runtime/get_ptr.hpp>
+
+#include <limits>
+
+#include "workstealing/LoadGossip.hpp"
+#include "workstealing/WorkerStates.hpp"
 
 namespace Workstealing { namespace Policies { namespace PriorityOrderedPerf {
 
 std::atomic<std::uint64_t> perf_spawns(0);
 std::atomic<std::uint64_t> perf_steals(0);
 std::atomic<std::uint64_t> perf_failedSteals(0);
+std::atomic<std::uint64_t> perf_distributedSteals(0);
+std::atomic<std::uint64_t> perf_failedDistributedSteals(0);
 
 std::uint64_t get_and_reset(std::atomic<std::uint64_t> & cntr, bool reset) {
   auto res = cntr.load();
@@ -17,26 +25,146 @@ std::uint64_t get_and_reset(std::atomic<std::uint64_t> & cntr, bool reset) {
 std::uint64_t getSpawns (bool reset) { return get_and_reset(perf_spawns, reset);}
 std::uint64_t getSteals(bool reset) { return get_and_reset(perf_steals, reset);}
 std::uint64_t getFailedSteals(bool reset) { return get_and_reset(perf_failedSteals, reset);}
+std::uint64_t getDistributedSteals(bool reset) { return get_and_reset(perf_distributedSteals, reset);}
+std::uint64_t getFailedDistributedSteals(bool reset) { return get_and_reset(perf_failedDistributedSteals, reset);}
 
 void registerPerformanceCounters() {
   hpx::performance_counters::install_counter_type(
       "/workstealing/PriorityOrdered/spawns",
       &getSpawns,
-      "Number of tasks spawned on the global workpool"
+      "Number of tasks spawned on this locality"
                                                   );
 
   hpx::performance_counters::install_counter_type(
       "/workstealing/PriorityOrdered/steals",
       &getSteals,
-      "Returns the number of tasks stolen from the global task queue"
+      "Returns the number of tasks taken from the local task queue"
                                                   );
 
   hpx::performance_counters::install_counter_type(
       "/workstealing/PriorityOrdered/failedSteals",
       &getFailedSteals,
-      "Returns the number of failed steals from the global task queue"
+      "Returns the number of times the local task queue was empty"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/PriorityOrdered/distributedSteals",
+      &getDistributedSteals,
+      "Returns the number of tasks stolen from another locality's task queue"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/PriorityOrdered/distributedFailedSteals",
+      &getFailedDistributedSteals,
+      "Returns the number of failed steals from another locality's task queue"
                                                   );
+}
+
+}
+
+PriorityOrderedPolicy::PriorityOrderedPolicy(hpx::naming::id_type localWorkqueue,
+                                             std::vector<hpx::naming::id_type> workqueues)
+    : localWorkqueue(localWorkqueue), workqueues(std::move(workqueues)), nextTarget(0) {
+  localQueue = hpx::get_ptr<workstealing::PriorityWorkqueue>(hpx::launch::sync, localWorkqueue);
+  here = hpx::get_locality_id();
+
+  watermarks.reset(new Watermark[this->workqueues.size()]);
+  for (std::size_t i = 0; i < this->workqueues.size(); ++i) {
+    watermarks[i].hasWork.store(i != here);
+    watermarks[i].priority.store(std::numeric_limits<int>::max());
+  }
+
+  std::random_device rd;
+  randGenerator.seed(rd());
+}
+
+PriorityOrderedPolicy::funcType PriorityOrderedPolicy::stealDistributed() {
+  // Pick the victim believed to hold the best task. Larger priorities are handed out first (see
+  // detail::PriorityWorkqueueCompare). Ties are broken randomly so thieves spread out.
+  int best = -1;
+  int bestPriority = std::numeric_limits<int>::min();
+  unsigned ties = 0;
+  for (std::size_t i = 0; i < workqueues.size(); ++i) {
+    if (i == here || !watermarks[i].hasWork.load() || !LoadGossip::advertisesWork(workqueues[i])) {
+      continue;
+    }
+    auto p = watermarks[i].priority.load();
+    if (best < 0 || p > bestPriority) {
+      best = i;
+      bestPriority = p;
+      ties = 1;
+    } else if (p == bestPriority) {
+      ++ties;
+      std::uniform_int_distribution<unsigned> rand(0, ties - 1);
+      if (rand(randGenerator) == 0) {
+        best = i;
+      }
+    }
+  }
+
+  if (best < 0) {
+    LoadGossip::recordSkippedSteal();
+    return nullptr;
+  }
+
+  auto res = WorkerStates::inState(WorkerStates::StealWait, [&]() {
+      return hpx::async<workstealing::PriorityWorkqueue::stealWithPriority_action>(workqueues[best]).get();
+    });
+  auto & task = hpx::util::get<0>(res);
+
+  // Piggyback: the reply tells us what the victim has left
+  watermarks[best].hasWork.store(hpx::util::get<1>(res));
+  watermarks[best].priority.store(hpx::util::get<2>(res));
+
+  if (task) {
+    PriorityOrderedPerf::perf_distributedSteals++;
+  } else {
+    PriorityOrderedPerf::perf_failedDistributedSteals++;
+  }
+  return task;
+}
+
+hpx::util::function<void(), false> PriorityOrderedPolicy::getWork() {
+  auto task = localQueue->steal();
+  if (task) {
+    PriorityOrderedPerf::perf_steals++;
+    return hpx::util::bind(task, hpx::find_here());
+  }
+  PriorityOrderedPerf::perf_failedSteals++;
+
+  if (workqueues.size() <= 1 || isCancelled()) {
+    return nullptr;
+  }
+
+  std::unique_lock<mutex_t> l(mtx, std::try_to_lock);
+  if (!l.owns_lock()) {
+    return nullptr;
+  }
+
+  task = stealDistributed();
+  if (task) {
+    return hpx::util::bind(task, hpx::find_here());
+  }
+  return nullptr;
+}
+
+void PriorityOrderedPolicy::addwork(int priority, funcType task) {
+  PriorityOrderedPerf::perf_spawns++;
+
+  auto target = nextTarget++ % workqueues.size();
+  if (target == here) {
+    addworkLocal(priority, std::move(task));
+  } else {
+    // The target will have work again, even if we saw it empty
+    watermarks[target].hasWork.store(true);
+    watermarks[target].priority.store(std::numeric_limits<int>::max());
+    hpx::apply<addworkFromRemote_act>(hpx::naming::get_id_from_locality_id(target), priority, std::move(task));
+  }
+}
 
+void PriorityOrderedPolicy::addworkLocal(int priority, funcType task) {
+  localQueue->addWork(priority, std::move(task));
+  Workstealing::Scheduler::notifyWorkAvailable();
 }
 
-}}}
+}}
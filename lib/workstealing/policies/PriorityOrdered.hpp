@@ -9,7 +9,15 @@
 #include "Policy.hpp"
 #include "workstealing/PriorityWorkqueue.hpp"
 
-namespace Workstealing { namespace Scheduler {extern std::shared_ptr<Policy> local_policy; }}
+#include <atomic>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace Workstealing { namespace Scheduler {
+extern std::shared_ptr<Policy> local_policy;
+void notifyWorkAvailable();
+}}
 
 namespace Workstealing { namespace Policies {
 
@@ -18,51 +26,80 @@ namespace PriorityOrderedPerf {
 extern std::atomic<std::uint64_t> perf_spawns;
 extern std::atomic<std::uint64_t> perf_steals;
 extern std::atomic<std::uint64_t> perf_failedSteals;
+extern std::atomic<std::uint64_t> perf_distributedSteals;
+extern std::atomic<std::uint64_t> perf_failedDistributedSteals;
 
 void registerPerformanceCounters();
 
 }
 
-
+// Relaxed distributed priority queue. Every locality has its own PriorityWorkqueue and new tasks
+// are dealt round robin over them in spawn order, so each local queue holds an evenly spread slice
+// of the global order. Workers pop from their local queue without leaving the locality and only
+// steal remotely once it is empty, going to the locality whose best remaining task (as last seen on
+// a steal from it) comes earliest in the order.
+//
+// This only relaxes the order tasks are *started* by the parallel workers; the Ordered skeleton's
+// sequential thread and started flags still give the same replicability guarantees.
 class PriorityOrderedPolicy : public Policy {
  private:
-  hpx::naming::id_type globalWorkqueue;
+  using funcType = hpx::util::function<void(hpx::naming::id_type)>;
+
+  hpx::naming::id_type localWorkqueue;
+  std::shared_ptr<workstealing::PriorityWorkqueue> localQueue;
+
+  // Workqueues of all localities, indexed by locality id
+  std::vector<hpx::naming::id_type> workqueues;
+  std::uint32_t here;
 
+  // Round robin target for the next addwork
+  std::atomic<unsigned> nextTarget;
+
+  // Per-locality watermark: priority of the best task we believe is left there. Unknown (or
+  // not yet stolen from) queues are assumed to have the best possible task.
+  struct Watermark {
+    std::atomic<bool> hasWork;
+    std::atomic<int> priority;
+  };
+  std::unique_ptr<Watermark[]> watermarks;
+
+  std::mt19937 randGenerator;
+
+  // Only one distributed steal at a time per locality
   using mutex_t = hpx::lcos::local::mutex;
   mutex_t mtx;
 
+  funcType stealDistributed();
+
  public:
-  PriorityOrderedPolicy (hpx::naming::id_type gWorkqueue) : globalWorkqueue(gWorkqueue) {};
+  PriorityOrderedPolicy(hpx::naming::id_type localWorkqueue, std::vector<hpx::naming::id_type> workqueues);
 
-  // Priority Ordered policy just forwards requests to the global workqueue
-  hpx::util::function<void(), false> getWork() override {
-    std::unique_lock<mutex_t> l(mtx);
+  hpx::util::function<void(), false> getWork() override;
 
-    hpx::util::function<void(hpx::naming::id_type)> task;
-    task = hpx::async<workstealing::PriorityWorkqueue::steal_action>(globalWorkqueue).get();
-    if (task) {
-      PriorityOrderedPerf::perf_steals++;
-      return hpx::util::bind(task, hpx::find_here());
-    }
+  // Note PriorityWorkqueue::workRemaining() returns true when the queue is *empty*
+  std::uint64_t localLoad() override { return localQueue->workRemaining() ? 0 : 1; }
 
-    PriorityOrderedPerf::perf_failedSteals++;
-    return nullptr;
-  }
+  void addwork(int priority, funcType task);
 
-  void addwork(int priority, hpx::util::function<void(hpx::naming::id_type)> task) {
-    std::unique_lock<mutex_t> l(mtx);
-    PriorityOrderedPerf::perf_spawns++;
-    hpx::apply<workstealing::PriorityWorkqueue::addWork_action>(globalWorkqueue, priority, task);
-  }
+  // Add to the queue on this locality
+  void addworkLocal(int priority, funcType task);
 
   hpx::future<bool> workRemaining() {
-    std::unique_lock<mutex_t> l(mtx);
-    return hpx::async<workstealing::PriorityWorkqueue::workRemaining_action>(globalWorkqueue);
+    return hpx::make_ready_future(localQueue->workRemaining());
   }
 
+  static void addworkFromRemote(int priority, funcType task) {
+    std::static_pointer_cast<PriorityOrderedPolicy>(Workstealing::Scheduler::local_policy)->addworkLocal(priority, std::move(task));
+  }
+  struct addworkFromRemote_act : hpx::actions::make_action<
+    decltype(&PriorityOrderedPolicy::addworkFromRemote),
+    &PriorityOrderedPolicy::addworkFromRemote,
+    addworkFromRemote_act>::type {};
+
   // Policy initialiser
-  static void setPriorityWorkqueuePolicy(hpx::naming::id_type globalWorkqueue) {
-    Workstealing::Scheduler::local_policy = std::make_shared<PriorityOrderedPolicy>(globalWorkqueue);
+  static void setPriorityWorkqueuePolicy(std::vector<hpx::naming::id_type> workqueues) {
+    auto local = workqueues[hpx::get_locality_id()];
+    Workstealing::Scheduler::local_policy = std::make_shared<PriorityOrderedPolicy>(local, workqueues);
   }
   struct setPriorityWorkqueuePolicy_act : hpx::actions::make_action<
     decltype(&PriorityOrderedPolicy::setPriorityWorkqueuePolicy),
@@ -70,9 +107,17 @@ class PriorityOrderedPolicy : public Policy {
     setPriorityWorkqueuePolicy_act>::type {};
 
   static void initPolicy () {
-    auto globalWorkqueue = hpx::new_<workstealing::PriorityWorkqueue>(hpx::find_here()).get();
-    hpx::wait_all(hpx::lcos::broadcast<setPriorityWorkqueuePolicy_act>(
-        hpx::find_all_localities(), globalWorkqueue));
+    auto locs = hpx::find_all_localities();
+    // Tasks are pushed to the queue their priority maps to, so every locality needs the full list
+    std::vector<hpx::future<hpx::naming::id_type> > created;
+    for (auto const & loc : locs) {
+      created.push_back(hpx::new_<workstealing::PriorityWorkqueue>(loc));
+    }
+    std::vector<hpx::naming::id_type> workqueues(locs.size());
+    for (auto i = 0u; i < locs.size(); ++i) {
+      workqueues[hpx::naming::get_locality_id_from_id(locs[i])] = created[i].get();
+    }
+    hpx::wait_all(hpx::lcos::broadcast<setPriorityWorkqueuePolicy_act>(locs, workqueues));
   }
 };
 
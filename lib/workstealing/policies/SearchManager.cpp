@@ -19,6 +19,15 @@ std::uint64_t getLocalSteals(bool reset) { return get_and_reset(perf_localSteals
 std::uint64_t getDistributedSteals (bool reset) { return get_and_reset(perf_distributedSteals, reset);}
 std::uint64_t getFailedLocalSteals(bool reset) { return get_and_reset(perf_failedLocalSteals, reset);}
 std::uint64_t getFailedDistributedSteals(bool reset) { return get_and_reset(perf_failedDistributedSteals, reset);}
+std::uint64_t getSameDomainSteals(bool reset) { return get_and_reset(perf_sameDomainSteals, reset);}
+std::uint64_t getCrossDomainSteals(bool reset) { return get_and_reset(perf_crossDomainSteals, reset);}
+std::uint64_t getFailedSameDomainSteals(bool reset) { return get_and_reset(perf_failedSameDomainSteals, reset);}
+std::uint64_t getFailedCrossDomainSteals(bool reset) { return get_and_reset(perf_failedCrossDomainSteals, reset);}
+std::uint64_t getPrefetchSteals(bool reset) { return get_and_reset(perf_prefetchSteals, reset);}
+std::uint64_t getSpawns(bool reset) { return get_and_reset(perf_spawns, reset);}
+std::uint64_t getPathSteals(bool reset) { return get_and_reset(perf_pathSteals, reset);}
+std::uint64_t getDeltaSteals(bool reset) { return get_and_reset(perf_deltaSteals, reset);}
+std::uint64_t getClaimSteals(bool reset) { return get_and_reset(perf_claimSteals, reset);}
 
 void registerPerformanceCounters() {
   hpx::performance_counters::install_counter_type(
@@ -44,27 +53,87 @@ void registerPerformanceCounters() {
       &getFailedDistributedSteals,
       "Returns the number of failed steals from another locality "
                                                   );
-}
 
-// Debugging information that doesn't fit a counter format
-void printDistributedStealsList() {
-  for (const auto &p : distributedStealsList) {
-    hpx::cout
-        << (boost::format("Steal %1% - %2% , success: %3%")
-            % static_cast<std::int64_t>(hpx::get_locality_id())
-            % static_cast<std::int64_t>(hpx::naming::get_locality_id_from_id(p.first))
-            % p.second)
-        << hpx::endl;
-  }
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/SearchManager/sameDomainSteals",
+      &getSameDomainSteals,
+      "Returns the number of local steals from a thread on the same NUMA domain"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/SearchManager/crossDomainSteals",
+      &getCrossDomainSteals,
+      "Returns the number of local steals from a thread on a different NUMA domain"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/SearchManager/sameDomainFailedSteals",
+      &getFailedSameDomainSteals,
+      "Returns the number of failed local steals from a thread on the same NUMA domain"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/SearchManager/crossDomainFailedSteals",
+      &getFailedCrossDomainSteals,
+      "Returns the number of failed local steals from a thread on a different NUMA domain"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/SearchManager/prefetchSteals",
+      &getPrefetchSteals,
+      "Returns the number of distributed steals started early because the task buffer was running low"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/SearchManager/spawns",
+      &getSpawns,
+      "Returns the number of tasks spawned into the task buffers on this locality (Hybrid skeleton)"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/SearchManager/pathSteals",
+      &getPathSteals,
+      "Returns the number of stolen nodes sent as a path from the root rather than the node itself"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/SearchManager/deltaSteals",
+      &getDeltaSteals,
+      "Returns the number of stolen nodes sent as a delta against a sibling rather than the node itself"
+                                                  );
+
+  hpx::performance_counters::install_counter_type(
+      "/workstealing/SearchManager/claimSteals",
+      &getClaimSteals,
+      "Returns the number of steals answered from a thread's published stack levels without signalling it"
+                                                  );
 }
 
+// Debugging information that doesn't fit a counter format
 void printChunkSizeList() {
+  std::uint64_t total[2] = {0, 0};
+  std::uint64_t count[2] = {0, 0};
   for (const auto &c : chunkSizeList) {
     hpx::cout
-        << (boost::format("%1% Stole Chunk of Size %2%")
+        << (boost::format("%1% Stole %3% Chunk of Size %2%")
             % static_cast<std::int64_t>(hpx::get_locality_id())
-            % c)
+            % c.first
+            % (c.second ? "Distributed" : "Local"))
         << hpx::endl;
+    total[c.second] += c.first;
+    count[c.second]++;
+  }
+
+  for (auto remote : {0, 1}) {
+    if (count[remote] > 0) {
+      hpx::cout
+          << (boost::format("%1% Mean %2% Chunk Size: %3% (%4% steals)")
+              % static_cast<std::int64_t>(hpx::get_locality_id())
+              % (remote ? "Distributed" : "Local")
+              % (static_cast<double>(total[remote]) / count[remote])
+              % count[remote])
+          << hpx::endl;
+    }
   }
 }
 
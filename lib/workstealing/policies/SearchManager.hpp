@@ -6,9 +6,8 @@
 #include <random>                                                // for defa...
 #include <vector>                                                // for vector
 #include <utility>                                               // for vector
-#include <queue>
 #include <atomic>
-#include <unordered_map>
+#include <algorithm>
 
 #include <hpx/include/components.hpp>
 
@@ -46,9 +45,19 @@
 #include "hpx/util/lockfree/deque.hpp"
 
 #include "Policy.hpp"
+#include "workstealing/ChaseLevDeque.hpp"
+#include "workstealing/VictimSelector.hpp"
+#include "workstealing/LoadGossip.hpp"
+#include "workstealing/WorkerStates.hpp"
+#include "workstealing/StealStats.hpp"
 #include "util/util.hpp"
+#include "workstealing/VictimLists.hpp"
+#include "util/MemoryUsage.hpp"
 
-namespace Workstealing { namespace Scheduler {extern std::shared_ptr<Policy> local_policy; }}
+namespace Workstealing { namespace Scheduler {
+extern std::shared_ptr<Policy> local_policy;
+void notifyWorkAvailable();
+}}
 
 namespace Workstealing { namespace Policies {
 
@@ -59,14 +68,31 @@ std::atomic<std::uint64_t> perf_distributedSteals(0);
 std::atomic<std::uint64_t> perf_failedLocalSteals(0);
 std::atomic<std::uint64_t> perf_failedDistributedSteals(0);
 
-std::vector<std::pair<hpx::naming::id_type, bool> > distributedStealsList;
+// Distributed steals started ahead of time because the task buffer ran low
+std::atomic<std::uint64_t> perf_prefetchSteals(0);
 
-std::vector<std::uint32_t> chunkSizeList;
+// Tasks spawned directly into the buffers (Hybrid skeleton) rather than stolen
+std::atomic<std::uint64_t> perf_spawns(0);
 
-void registerPerformanceCounters();
+// Steal responses sent (by this locality) as a path rather than a node (Params::pathSteals)
+std::atomic<std::uint64_t> perf_pathSteals(0);
+
+// Stolen nodes sent (by this locality) as a delta against a sibling (SiblingDeltas)
+std::atomic<std::uint64_t> perf_deltaSteals(0);
+
+// Steals answered by claiming from a thread's published stack levels (Params::claimSteals)
+std::atomic<std::uint64_t> perf_claimSteals(0);
+
+// Breakdown of local steals by NUMA domain of the victim
+std::atomic<std::uint64_t> perf_sameDomainSteals(0);
+std::atomic<std::uint64_t> perf_crossDomainSteals(0);
+std::atomic<std::uint64_t> perf_failedSameDomainSteals(0);
+std::atomic<std::uint64_t> perf_failedCrossDomainSteals(0);
 
-void printDistributedStealsList();
-HPX_DEFINE_PLAIN_ACTION(printDistributedStealsList, printDistributedStealsList_act);
+// Size of each successful steal response and whether it came from another locality
+std::vector<std::pair<std::uint32_t, bool> > chunkSizeList;
+
+void registerPerformanceCounters();
 
 void printChunkSizeList();
 HPX_DEFINE_PLAIN_ACTION(printChunkSizeList, printChunkSizeList_act);
@@ -91,8 +117,9 @@ struct SearchManager : public hpx::components::component_base<SearchManager> {
   // std::shared_ptr<void> ptr;
 
   template <typename SearchInfo, typename FuncToCall, typename ...Args>
-  void init() {
-    Workstealing::Scheduler::local_policy = std::make_shared<SearchManagerComp<SearchInfo, FuncToCall, Args...> >();
+  void init(unsigned maxDistributedSteals, unsigned stealPrefetchThreshold) {
+    Workstealing::Scheduler::local_policy =
+        std::make_shared<SearchManagerComp<SearchInfo, FuncToCall, Args...> >(maxDistributedSteals, stealPrefetchThreshold);
   }
 
   template <typename SearchInfo, typename FuncToCall, typename ...Args>
@@ -112,21 +139,36 @@ struct SearchManager : public hpx::components::component_base<SearchManager> {
     // We return an empty vector here to signal no tasks
     using Response = std::vector<Task>;
 
-    // Information shared between a thread and the manager. We set the atomic on a steal and then use the channel to await a response
+    // Information shared between a thread and the manager. We set the atomic on a steal and then use the channel to await a response.
+    // The bool tells the thread whether the thief is on another locality (set before the atomic).
     using SharedState = std::tuple<std::atomic<bool>, hpx::lcos::local::one_element_channel<Response>, bool>;
 
-    // Lock to protect the component
+    // Optionally, a thread can let thieves take work from it directly, without signalling it (see
+    // StackStealing's claim steals). The claim fills in a task, or returns false if there is none.
+    using Claim = hpx::util::function<bool(SearchInfo &, int &, hpx::naming::id_type &), false>;
+
+    // Lock to protect the distributed steal state. Local steals and buffered tasks don't need it.
     using MutexT = hpx::lcos::local::mutex;
     MutexT mtx;
 
-    // (internal) Id's of currently running threads, for managing the active map
-    std::queue<unsigned> activeIds;
-
-    // Active thread shared states
-    std::unordered_map<unsigned, std::shared_ptr<SharedState> > active;
-
-    // Shared states of threads currently being stolen from
-    std::unordered_map<unsigned, std::shared_ptr<SharedState> > inactive;
+    // One slot per (potentially) running search thread. A slot moves Free -> Registering -> Active
+    // when a thread registers; a thief owns it while Stealing and puts it back to Active once the
+    // thread has responded. The thread owns the state and domain while Registering, the thief while
+    // Stealing, so neither needs a lock.
+    enum SlotStatus : int { Free, Registering, Active, Stealing };
+    struct ThreadSlot {
+      std::atomic<int> status {Free};
+      unsigned domain = 0;
+      std::shared_ptr<SharedState> state;
+      Claim claim;
+    };
+    std::unique_ptr<ThreadSlot[]> slots;
+    unsigned numSlots;
+    std::atomic<unsigned> numActive;
+
+    // Leftover tasks from local/distributed steals, pushed by the worker that stole them. Other
+    // workers take from these before stealing from a running stack.
+    std::vector<std::unique_ptr<workstealing::ChaseLevDeque<Task> > > threadBuffers;
 
     // Pointers to SearchManagers on other localities
     std::vector<hpx::naming::id_type> distributedSearchManagers;
@@ -134,65 +176,197 @@ struct SearchManager : public hpx::components::component_base<SearchManager> {
     // random number generator
     std::mt19937 randGenerator;
 
-    // Are we currently doing a distributed steal?
-    bool isStealingDistributed = false;
+    // Number of distributed steals currently outstanding and how many we allow at once
+    unsigned distributedStealsInFlight = 0;
+    unsigned maxDistributedSteals;
+
+    // Prefetch remote work once the task buffer drops to this size (0 = never prefetch)
+    unsigned stealPrefetchThreshold;
 
-    // Task Buffer for chunking
+    // Shared task buffer for chunks that arrive outside a worker (prefetches) or on non-workers
     boost::lockfree::deque<Task> taskBuffer;
 
-    // Last steal optimisation
-    hpx::naming::id_type last_remote;
+    // Tasks across taskBuffer and threadBuffers
+    std::atomic<unsigned> taskBufferSize;
+
+    // Remote managers weighted by steal latency/success
+    using Selector = workstealing::LatencyWeightedSelector<hpx::naming::id_type>;
+    Selector victims;
+
+    // Last steal optimisation, index into victims (-1 if the last distributed steal failed)
+    int last_remote = -1;
+
+    // Choose a remote victim that advertises work, must be called with the lock held. Returns
+    // false if no other locality claims to have anything.
+    bool pickDistributedVictim(std::size_t & victim) {
+      // Last steal optimisation. Only the first outstanding steal goes there, any others spread
+      // out so they don't all queue up on the same victim
+      if (last_remote >= 0 && distributedStealsInFlight == 0 &&
+          LoadGossip::advertisesWork(victims[last_remote])) {
+        victim = last_remote;
+        return true;
+      }
+
+      if (!victims.pick(randGenerator, LoadGossip::advertisesWork, victim)) {
+        LoadGossip::recordSkippedSteal();
+        return false;
+      }
+      return true;
+    }
+
+    // Record the outcome of a distributed steal that returned nodes nodes, must be called with the
+    // lock held
+    void finishDistributedSteal(std::size_t victim, Selector::clock::time_point start, std::size_t nodes) {
+      --distributedStealsInFlight;
+      auto latency = Selector::clock::now() - start;
+      auto success = nodes > 0;
+      victims.record(victim, latency, success);
+      StealStats::stealReturned(StealStats::SearchManager,
+                                hpx::naming::get_locality_id_from_id(victims[victim]), latency, nodes);
+      if (success) {
+        last_remote = victim;
+      } else if (last_remote == static_cast<int>(victim)) {
+        last_remote = -1;
+      }
+    }
+
+    // Buffer tasks in the calling worker's own buffer, or the shared one if shared == true or
+    // we are not on a worker
+    void bufferTasks(typename Response::iterator begin, typename Response::iterator end, bool shared = false) {
+      auto me = hpx::get_worker_thread_num();
+      for (auto itr = begin; itr != end; ++itr) {
+        if (!shared && me < threadBuffers.size()) {
+          threadBuffers[me]->push(std::unique_ptr<Task>(new Task(std::move(*itr))));
+        } else {
+          taskBuffer.push_left(std::move(*itr));
+        }
+        ++taskBufferSize;
+      }
+      YewPar::util::MemoryUsage::add(YewPar::util::MemoryUsage::Pools,
+                                     std::distance(begin, end) * static_cast<std::int64_t>(sizeof(Task)));
+    }
+
+    // Take a buffered task: our own buffer first, then the shared one, then other workers'
+    bool popBuffered(Task & task) {
+      if (taskBufferSize.load(std::memory_order_relaxed) == 0) {
+        return false;
+      }
+
+      auto me = hpx::get_worker_thread_num();
+      std::unique_ptr<Task> t;
+      if (me < threadBuffers.size()) {
+        t = threadBuffers[me]->pop();
+      }
+
+      if (!t && taskBuffer.pop_right(task)) {
+        --taskBufferSize;
+        YewPar::util::MemoryUsage::add(YewPar::util::MemoryUsage::Pools, -static_cast<std::int64_t>(sizeof(Task)));
+        return true;
+      }
+
+      for (auto i = 1; !t && i <= threadBuffers.size(); ++i) {
+        auto victim = (me + i) % threadBuffers.size();
+        if (victim != me) {
+          t = threadBuffers[victim]->steal();
+        }
+      }
+
+      if (!t) {
+        return false;
+      }
+      task = std::move(*t);
+      --taskBufferSize;
+      YewPar::util::MemoryUsage::add(YewPar::util::MemoryUsage::Pools, -static_cast<std::int64_t>(sizeof(Task)));
+      return true;
+    }
 
     // Try to steal from a thread on another (random) locality
     Response tryDistributedSteal(std::unique_lock<MutexT> & l) {
-      // We only allow one distributed steal to happen at a time (to make sure we
-      // don't overload the communication)
-      if (isStealingDistributed) {
+      // Bound the number of outstanding steals to make sure we don't overload the communication
+      if (distributedStealsInFlight >= maxDistributedSteals) {
         return {};
       }
 
-      isStealingDistributed = true;
-
-      // Last steal optimisation
-      hpx::naming::id_type victim;
-      if (last_remote != hpx::find_here()) {
-        victim = last_remote;
-      } else {
-        auto vic = distributedSearchManagers.begin();
-
-        std::uniform_int_distribution<> rand(0, distributedSearchManagers.size() - 1);
-        std::advance(vic, rand(randGenerator));
-        victim = *vic;
+      std::size_t victim;
+      if (!pickDistributedVictim(victim)) {
+        return {};
       }
+      auto victimId = victims[victim];
+      ++distributedStealsInFlight;
 
+      auto start = Selector::clock::now();
       l.unlock();
-      auto res = hpx::async<GetDistributedWorkAct<SearchInfo, FuncToCall, Args...> >(victim).get();
+      auto res = WorkerStates::inState(WorkerStates::StealWait, [&]() {
+          return hpx::async<GetDistributedWorkAct<SearchInfo, FuncToCall, Args...> >(victimId).get();
+        });
       l.lock();
 
-      isStealingDistributed = false;
+      finishDistributedSteal(victim, start, res.size());
 
-      if (!res.empty()) {
-        SearchManagerPerf::distributedStealsList.push_back(std::make_pair(victim, true));
-        last_remote = victim;
-      } else {
-        SearchManagerPerf::distributedStealsList.push_back(std::make_pair(victim, false));
-        last_remote = hpx::find_here();
+      return res;
+    }
+
+    // Steal ahead: when the task buffer is running low start a distributed steal in the background
+    // so the work has (hopefully) arrived by the time a worker goes idle. Must be called with the
+    // lock held.
+    void maybePrefetch() {
+      if (stealPrefetchThreshold == 0 ||
+          distributedSearchManagers.empty() ||
+          distributedStealsInFlight >= maxDistributedSteals ||
+          taskBufferSize.load(std::memory_order_relaxed) > stealPrefetchThreshold) {
+        return;
       }
 
-      return res;
+      std::size_t victim;
+      if (!pickDistributedVictim(victim)) {
+        return;
+      }
+      ++distributedStealsInFlight;
+      SearchManagerPerf::perf_prefetchSteals++;
+
+      // Keep the manager alive until the response arrives, even if the search has moved on
+      auto self = std::static_pointer_cast<SearchManagerComp>(Workstealing::Scheduler::local_policy);
+      auto start = Selector::clock::now();
+      hpx::async<GetDistributedWorkAct<SearchInfo, FuncToCall, Args...> >(victims[victim]).then(
+          [self, victim, start](hpx::future<Response> f) {
+            auto res = f.get();
+
+            std::unique_lock<MutexT> l(self->mtx);
+            self->finishDistributedSteal(victim, start, res.size());
+            if (res.empty()) {
+              SearchManagerPerf::perf_failedDistributedSteals++;
+              return;
+            }
+
+            SearchManagerPerf::perf_distributedSteals++;
+            SearchManagerPerf::chunkSizeList.emplace_back(res.size(), true);
+            self->bufferTasks(res.begin(), res.end(), true);
+            l.unlock();
+
+            Workstealing::Scheduler::notifyWorkAvailable();
+          });
     }
 
    public:
 
-    SearchManagerComp() {
-      for (auto i = 0; i < hpx::get_os_thread_count(); ++i) {
-        activeIds.push(i);
+    SearchManagerComp(unsigned maxDistributedSteals = 1, unsigned stealPrefetchThreshold = 0)
+        : maxDistributedSteals(std::max(1u, maxDistributedSteals)),
+          stealPrefetchThreshold(stealPrefetchThreshold),
+          numActive(0),
+          taskBufferSize(0) {
+      auto nThreads = hpx::get_os_thread_count();
+
+      // One extra slot for the master thread which may register from outside the pool
+      numSlots = nThreads + 1;
+      slots.reset(new ThreadSlot[numSlots]);
+
+      threadBuffers.reserve(nThreads);
+      for (auto i = 0; i < nThreads; ++i) {
+        threadBuffers.emplace_back(new workstealing::ChaseLevDeque<Task>());
       }
 
       std::random_device rd;
       randGenerator.seed(rd());
-
-      last_remote = hpx::find_here();
     }
 
     // Notify this search manager of the globalId's of potential steal victims
@@ -202,71 +376,179 @@ struct SearchManager : public hpx::components::component_base<SearchManager> {
       distributedSearchManagers.erase(
           std::remove_if(distributedSearchManagers.begin(), distributedSearchManagers.end(), YewPar::util::isColocated),
           distributedSearchManagers.end());
+      victims.setVictims(distributedSearchManagers);
+      last_remote = -1;
     }
 
-    // Try to get work from a (random) thread running on this locality and wrap it
-    // back up for serializing over the network
+    // Answer a steal from another locality, see StealStats
     Response getDistributedWork() {
-      std::unique_lock<MutexT> l(mtx);
-      return getLocalWork(l);
+      auto start = StealStats::clock::now();
+      auto res = answerDistributedSteal();
+      StealStats::stealAnswered(StealStats::SearchManager, StealStats::clock::now() - start,
+                                StealStats::serializedSize(res));
+      return res;
     }
 
-    // Try to get work from a (random) thread running on this locality
-    Response getLocalWork(std::unique_lock<MutexT> & l) {
-      if (active.empty()) {
+    // Try to get work from a (random) thread running on this locality and wrap it
+    // back up for serializing over the network
+    Response answerDistributedSteal() {
+      // Anything left is drained locally, see Policy::cancel
+      if (isCancelled()) {
+        return {};
+      }
+
+      Task task;
+      if (popBuffered(task)) {
+        return {task};
+      }
+
+      unsigned victim;
+      if (!pickVictim(0, false, victim, true)) {
         return {};
       }
-      auto victim = active.begin();
+      return stealFrom(victim, true);
+    }
 
-      std::uniform_int_distribution<> rand(0, active.size() - 1);
-      std::advance(victim, rand(randGenerator));
+    // Claim a random active thread in the given NUMA domain (sameDomain == true) or outside of it.
+    // With anyDomain the domain is ignored. The claimed slot must be handed to stealFrom.
+    bool pickVictim(unsigned domain, bool sameDomain, unsigned & victim, bool anyDomain = false) {
+      if (numActive.load(std::memory_order_relaxed) == 0) {
+        return false;
+      }
 
-      auto pos         = victim->first;
-      auto stealReqPtr = victim->second;
+      static thread_local std::minstd_rand rng(std::random_device{}());
+      std::uniform_int_distribution<unsigned> rand(0, numSlots - 1);
+      auto start = rand(rng);
+      for (auto i = 0; i < numSlots; ++i) {
+        auto pos = (start + i) % numSlots;
+        auto & slot = slots[pos];
+        if (slot.status.load(std::memory_order_relaxed) != Active) {
+          continue;
+        }
+        int expected = Active;
+        if ((anyDomain || (slot.domain == domain) == sameDomain) &&
+            slot.status.compare_exchange_strong(expected, Stealing, std::memory_order_acquire)) {
+          victim = pos;
+          return true;
+        }
+      }
+      return false;
+    }
+
+    // Try to get work from a thread running on this locality, preferring threads on our own socket
+    Response getLocalWork() {
+      auto domain = YewPar::util::getNumaDomain();
+
+      unsigned victim;
+      if (pickVictim(domain, true, victim)) {
+        auto res = stealFrom(victim);
+        if (!res.empty()) {
+          SearchManagerPerf::perf_sameDomainSteals++;
+          return res;
+        }
+        SearchManagerPerf::perf_failedSameDomainSteals++;
+      }
 
-      // We remove the victim from active while we steal, so that if we suspend
-      // no other thread gets in the way of our steal
-      active.erase(pos);
-      inactive[pos] = stealReqPtr;
+      if (pickVictim(domain, false, victim)) {
+        auto res = stealFrom(victim);
+        if (!res.empty()) {
+          SearchManagerPerf::perf_crossDomainSteals++;
+          return res;
+        }
+        SearchManagerPerf::perf_failedCrossDomainSteals++;
+      }
+
+      return {};
+    }
+
+    // Steal from a thread whose slot we have claimed (moved to Stealing) in pickVictim
+    Response stealFrom(unsigned pos, bool remoteThief = false) {
+      auto & slot = slots[pos];
+      if (slot.claim) {
+        return claimFrom(slot);
+      }
+
+      auto stealReqPtr = slot.state;
 
       // Signal the thread that we need work from it and wait for some (or Nothing)
-      //std::get<2>(*stealReqPtr) = true;
+      std::get<2>(*stealReqPtr) = remoteThief;
       std::get<0>(*stealReqPtr).store(true);
 
-      auto resF = std::get<1>(*stealReqPtr).get();
-      l.unlock();
-      auto res = resF.get();
-      l.lock();
+      auto res = WorkerStates::inState(WorkerStates::StealWait, [&]() {
+          return std::get<1>(*stealReqPtr).get().get();
+        });
 
-      // -1 depth signals that the thread we tried to steal from has finished it's search
+      // -1 depth signals that the thread we tried to steal from has finished it's search. It
+      // leaves its slot for us to free.
       if (!res.empty() && hpx::util::get<1>(res[0]) == -1) {
+        slot.state.reset();
+        slot.status.store(Free, std::memory_order_release);
         return {};
       }
 
       // Allow this thread to be stolen from again
-      active[pos] = stealReqPtr;
-      inactive.erase(pos);
+      slot.status.store(Active, std::memory_order_release);
+      return res;
+    }
+
+    // Take a task straight from a thread that registered a claim, it keeps searching meanwhile. The
+    // thread can't finish (unregister) until we hand the slot back.
+    Response claimFrom(ThreadSlot & slot) {
+      Response res;
+      SearchInfo info; int depth; hpx::naming::id_type prom;
+      if (slot.claim(info, depth, prom)) {
+        SearchManagerPerf::perf_claimSteals++;
+        res.emplace_back(hpx::util::make_tuple(std::move(info), depth, std::move(prom)));
+      }
+      slot.status.store(Active, std::memory_order_release);
       return res;
     }
 
+    // Queue a task created by the skeleton itself (e.g. Hybrid's depth bounded spawns). It goes to
+    // the calling worker's buffer: the worker takes the newest task back first, other workers and
+    // remote thieves the oldest.
+    void addwork(SearchInfo info, int depth, hpx::naming::id_type donePromise) {
+      SearchManagerPerf::perf_spawns++;
+      Response res {hpx::util::make_tuple(std::move(info), depth, std::move(donePromise))};
+      bufferTasks(res.begin(), res.end());
+      Workstealing::Scheduler::notifyWorkAvailable();
+    }
+
+    // Stealable work is the running stacks plus anything buffered from chunked steals
+    std::uint64_t localLoad() override {
+      return numActive.load() + taskBufferSize.load();
+    }
+
     // Called by the scheduler to ask the searchManager to add more work
     hpx::util::function<void(), false> getWork() override {
-      std::unique_lock<MutexT> l(mtx);
-
       // Return from task buffer first if anything exists
       Task task;
-      if (taskBuffer.pop_right(task)) {
+      if (popBuffered(task)) {
+        if (stealPrefetchThreshold > 0) {
+          std::lock_guard<MutexT> l(mtx);
+          maybePrefetch();
+        }
+
         SearchInfo searchInfo; int depth; hpx::naming::id_type prom;
         hpx::util::tie(searchInfo, depth, prom) = task;
         return hpx::util::bind(FuncToCall::fn_ptr(), searchInfo, depth, prom);
       }
 
+      // Running threads see the stop flag themselves, there is nothing worth stealing
+      if (isCancelled()) {
+        return nullptr;
+      }
+
       Response maybeStolen;
-      if (active.empty()) {
+      bool stolenRemotely = false;
+      std::unique_lock<MutexT> l(mtx, std::defer_lock);
+      if (numActive.load() == 0) {
+        l.lock();
         // No local threads running, steal distributed
         if (!distributedSearchManagers.empty()) {
           maybeStolen = tryDistributedSteal(l);
           if (!maybeStolen.empty()) {
+            stolenRemotely = true;
             SearchManagerPerf::perf_distributedSteals++;
           } else {
             SearchManagerPerf::perf_failedDistributedSteals++;
@@ -277,27 +559,48 @@ struct SearchManager : public hpx::components::component_base<SearchManager> {
           return nullptr;
         }
       } else {
-        maybeStolen = getLocalWork(l);
+        // Same socket, then other sockets, then other localities
+        maybeStolen = getLocalWork();
         if (!maybeStolen.empty()) {
           SearchManagerPerf::perf_localSteals++;
         } else {
           SearchManagerPerf::perf_failedLocalSteals++;
-          return nullptr;
+          l.lock();
+          if (distributedSearchManagers.empty()) {
+            return nullptr;
+          }
+
+          maybeStolen = tryDistributedSteal(l);
+          if (!maybeStolen.empty()) {
+            stolenRemotely = true;
+            SearchManagerPerf::perf_distributedSteals++;
+          } else {
+            SearchManagerPerf::perf_failedDistributedSteals++;
+            return nullptr;
+          }
         }
       }
 
       if (!maybeStolen.empty()) {
-        SearchManagerPerf::chunkSizeList.emplace_back(maybeStolen.size());
+        // Local steals don't hold the lock, but the chunk size list isn't thread safe
+        if (!l.owns_lock()) {
+          l.lock();
+        }
+        SearchManagerPerf::chunkSizeList.emplace_back(maybeStolen.size(), stolenRemotely);
 
         // Take off the first task and queue up anything else that was returned
         auto first = maybeStolen[0];
         SearchInfo searchInfo; int depth; hpx::naming::id_type prom;
         hpx::util::tie(searchInfo, depth, prom) = first;
 
-        auto itr = maybeStolen.begin();
-        ++itr;
-        for (itr; itr != maybeStolen.end(); ++itr) {
-          taskBuffer.push_left(std::move(*itr));
+        bufferTasks(std::next(maybeStolen.begin()), maybeStolen.end());
+        if (stolenRemotely) {
+          maybePrefetch();
+        }
+        l.unlock();
+        if (maybeStolen.size() > 1) {
+          // Let idle workers pick up the rest
+          Workstealing::Scheduler::notifyWorkAvailable();
         }
 
         return hpx::util::bind(FuncToCall::fn_ptr(), searchInfo, depth, prom);
@@ -306,28 +609,58 @@ struct SearchManager : public hpx::components::component_base<SearchManager> {
 
     // Signal the searchManager that a local thread is now finished working and should be removed from active
     void unregisterThread(unsigned activeId) {
-      std::lock_guard<MutexT> l(mtx);
-      if (active.find(activeId) != active.end()) {
-        active.erase(activeId);
-      } else {
-        // A steal must be in progress on this id so cancel it before finishing
-        // Canceled steals (-1 flag) are already removed from active
-        auto & state = inactive[activeId];
-        std::vector<Task> noSteal {hpx::util::make_tuple(SearchInfo(), -1, hpx::find_here())};
-        std::get<1>(*state).set(noSteal);
-        inactive.erase(activeId);
-      }
-      activeIds.push(activeId);
+      auto & slot = slots[activeId];
+      auto & state = *slot.state;
+      numActive--;
+
+      while (true) {
+        int expected = Active;
+        if (slot.status.compare_exchange_strong(expected, Free, std::memory_order_acq_rel)) {
+          slot.state.reset();
+          return;
+        }
+
+        // A steal is in progress. If it is waiting on us cancel it (the thief then frees the
+        // slot), otherwise the thief is about to signal us or already has its answer and is
+        // about to hand the slot back.
+        if (std::get<0>(state).load()) {
+          std::vector<Task> noSteal {hpx::util::make_tuple(SearchInfo(), -1, hpx::find_here())};
+          std::get<0>(state).store(false);
+          std::get<1>(state).set(noSteal);
+          return;
+        }
+        hpx::this_thread::yield();
+      }
     }
 
     // Generate a new stealRequest pair that can be used with an existing thread to add steals to it
-    // Used for master-threads initialising work while maintaining a stack
-    std::pair<std::shared_ptr<SharedState>, unsigned> registerThread() {
-      std::lock_guard<MutexT> l(mtx);
+    // Used for master-threads initialising work while maintaining a stack. With a claim, thieves
+    // use it instead of the stealRequest.
+    std::pair<std::shared_ptr<SharedState>, unsigned> registerThread(Claim claim = nullptr) {
       auto shared_state = std::make_shared<SharedState>();
-      auto nextId = activeIds.front();
-      activeIds.pop();
-      active[nextId] = shared_state;
+
+      unsigned nextId = 0;
+      while (true) {
+        int expected = Free;
+        if (slots[nextId].status.compare_exchange_strong(expected, Registering, std::memory_order_acquire)) {
+          break;
+        }
+        nextId = (nextId + 1) % numSlots;
+        if (nextId == 0) {
+          // Slots are only briefly held by finished threads whose last steal is being cancelled
+          hpx::this_thread::yield();
+        }
+      }
+
+      auto & slot = slots[nextId];
+      slot.state = shared_state;
+      slot.claim = std::move(claim);
+      slot.domain = YewPar::util::getNumaDomain();
+      slot.status.store(Active, std::memory_order_release);
+      numActive++;
+
+      // There is now a new stack that can be stolen from
+      Workstealing::Scheduler::notifyWorkAvailable();
       return std::make_pair(shared_state, nextId);
     }
 
@@ -340,20 +673,29 @@ struct SearchManager : public hpx::components::component_base<SearchManager> {
 
     typedef Response Response_t;
     typedef SharedState SharedState_t;
+    typedef Claim Claim_t;
 
     // Helper function to setup the components/policies on each node and register required information
-    static void initPolicy() {
-      std::vector<hpx::naming::id_type> searchManagers;
-      for (auto const& loc : hpx::find_all_localities()) {
-        auto searchManager = hpx::new_<SearchManager>(loc).get();
-        hpx::async<InitComponentAct<SearchInfo, FuncToCall, Args...> >(searchManager).get();
-        searchManagers.push_back(searchManager);
+    // Managers are created and initialised on all localities at once, victim lists as in
+    // workstealing/VictimLists.hpp
+    static void initPolicy(unsigned maxDistributedSteals = 1, unsigned stealPrefetchThreshold = 0) {
+      auto localities = hpx::find_all_localities();
+      std::vector<hpx::future<hpx::naming::id_type> > created;
+      for (auto const& loc : localities) {
+        created.push_back(hpx::new_<SearchManager>(loc));
       }
 
-      for (auto const & mgr : searchManagers) {
-        using act = typename SearchManager::RegisterDistributedManagersAct<SearchInfo, FuncToCall, Args...>;
-        hpx::async<act>(mgr, searchManagers).get();
+      std::vector<hpx::naming::id_type> searchManagers;
+      std::vector<hpx::future<void> > futs;
+      for (auto & f : created) {
+        searchManagers.push_back(f.get());
+        futs.push_back(hpx::async<InitComponentAct<SearchInfo, FuncToCall, Args...> >(
+            searchManagers.back(), maxDistributedSteals, stealPrefetchThreshold));
       }
+      hpx::wait_all(futs);
+
+      using act = typename SearchManager::RegisterDistributedManagersAct<SearchInfo, FuncToCall, Args...>;
+      workstealing::distributeVictimsTo<act>(searchManagers, searchManagers);
     }
 
   };
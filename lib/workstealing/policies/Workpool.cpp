@@ -7,6 +7,7 @@
 #include <memory>
 
 #include "util/util.hpp"
+#include "workstealing/WorkerStates.hpp"
 
 namespace Workstealing { namespace Policies {
 
@@ -86,10 +87,12 @@ hpx::util::function<void(), false> Workpool::getWork() {
     WorkpoolPerf::perf_failedLocalSteals++;
   }
 
-  if (!distributed_workqueues.empty()) {
+  if (!distributed_workqueues.empty() && !isCancelled()) {
     // Last steal optimisation
     if (last_remote != hpx::find_here()) {
-      task = hpx::async<workstealing::Workqueue::steal_action>(last_remote).get();
+      task = WorkerStates::inState(WorkerStates::StealWait, [&]() {
+          return hpx::async<workstealing::Workqueue::steal_action>(last_remote).get();
+        });
       if (task) {
         WorkpoolPerf::perf_distributedSteals++;
         return hpx::util::bind(task, hpx::find_here());
@@ -103,7 +106,9 @@ hpx::util::function<void(), false> Workpool::getWork() {
     std::uniform_int_distribution<int> rand(0, distributed_workqueues.size() - 1);
     auto victim = distributed_workqueues.begin();
     std::advance(victim, rand(randGenerator));
-    task = hpx::async<workstealing::Workqueue::steal_action>(*victim).get();
+    task = WorkerStates::inState(WorkerStates::StealWait, [&]() {
+        return hpx::async<workstealing::Workqueue::steal_action>(*victim).get();
+      });
 
     if (task) {
       last_remote = *victim;
@@ -120,7 +125,9 @@ hpx::util::function<void(), false> Workpool::getWork() {
 void Workpool::addwork(hpx::util::function<void(hpx::naming::id_type)> task) {
   std::unique_lock<mutex_t> l(mtx);
   WorkpoolPerf::perf_spawns++;
-  hpx::apply<workstealing::Workqueue::addWork_action>(local_workqueue, task);
+  hpx::apply<workstealing::Workqueue::addWork_action>(local_workqueue, std::move(task));
+  l.unlock();
+  Workstealing::Scheduler::notifyWorkAvailable();
 }
 
 void Workpool::registerDistributedWorkqueues(std::vector<hpx::naming::id_type> workqueues) {
@@ -131,4 +138,9 @@ void Workpool::registerDistributedWorkqueues(std::vector<hpx::naming::id_type> w
       distributed_workqueues.end());
 }
 
+void Workpool::addDistributedWorkqueue(hpx::naming::id_type workqueue) {
+  std::unique_lock<mutex_t> l(mtx);
+  distributed_workqueues.push_back(std::move(workqueue));
+}
+
 }}
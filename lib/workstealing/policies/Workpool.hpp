@@ -13,11 +13,15 @@
 #include <hpx/runtime/actions/basic_action.hpp>
 
 #include "workstealing/Workqueue.hpp"
+#include "workstealing/VictimLists.hpp"
 
 #include <random>
 #include <vector>
 
-namespace Workstealing { namespace Scheduler {extern std::shared_ptr<Policy> local_policy; }}
+namespace Workstealing { namespace Scheduler {
+extern std::shared_ptr<Policy> local_policy;
+void notifyWorkAvailable();
+}}
 
 namespace Workstealing { namespace Policies {
 
@@ -50,6 +54,8 @@ class Workpool : public Policy {
 
   void registerDistributedWorkqueues(std::vector<hpx::naming::id_type> workqueues);
 
+  void addDistributedWorkqueue(hpx::naming::id_type workqueue);
+
   static void setWorkqueue(hpx::naming::id_type localWorkqueue) {
     Workstealing::Scheduler::local_policy = std::make_shared<Workpool>(localWorkqueue);
   }
@@ -66,16 +72,59 @@ class Workpool : public Policy {
     &Workpool::setDistributedWorkqueues,
     setDistributedWorkqueues_act>::type {};
 
+  static void addDistributedWorkqueueTo(hpx::naming::id_type workqueue) {
+    std::static_pointer_cast<Workstealing::Policies::Workpool>(Workstealing::Scheduler::local_policy)->addDistributedWorkqueue(workqueue);
+  }
+  struct addDistributedWorkqueue_act : hpx::actions::make_action<
+    decltype(&Workpool::addDistributedWorkqueueTo),
+    &Workpool::addDistributedWorkqueueTo,
+    addDistributedWorkqueue_act>::type {};
+
+  // The workqueues and localities of the current search, on the locality that set it up
+  struct Members {
+    std::vector<hpx::naming::id_type> localities;
+    std::vector<hpx::naming::id_type> workqueues;
+  };
+
+  static Members & members() {
+    static Members m;
+    return m;
+  }
+
+  // Workqueues are created on all localities at once, victim lists as in workstealing/VictimLists.hpp
   static void initPolicy() {
-    std::vector<hpx::future<void> > futs;
+    auto localities = hpx::find_all_localities();
+    std::vector<hpx::future<hpx::naming::id_type> > created;
+    for (auto const& loc : localities) {
+      created.push_back(hpx::new_<workstealing::Workqueue>(loc));
+    }
+
     std::vector<hpx::naming::id_type> workqueues;
-    for (auto const& loc : hpx::find_all_localities()) {
-      auto workqueue = hpx::new_<workstealing::Workqueue>(loc).get();
-      futs.push_back(hpx::async<setWorkqueue_act>(loc, workqueue));
-      workqueues.push_back(workqueue);
+    std::vector<hpx::future<void> > futs;
+    for (auto i = 0u; i < localities.size(); ++i) {
+      workqueues.push_back(created[i].get());
+      futs.push_back(hpx::async<setWorkqueue_act>(localities[i], workqueues.back()));
     }
     hpx::wait_all(futs);
-    hpx::wait_all(hpx::lcos::broadcast<setDistributedWorkqueues_act>(hpx::find_all_localities(), workqueues));
+    workstealing::distributeVictims<setDistributedWorkqueues_act>(localities, workqueues);
+    members() = Members {std::move(localities), std::move(workqueues)};
+  }
+
+  // Give a locality that joined the running search (see util/LocalityJoin.hpp) a workqueue, and
+  // add it to every victim list. Called on the locality that ran initPolicy.
+  static void joinLocality(const hpx::naming::id_type & loc) {
+    auto & m = members();
+    auto workqueue = hpx::new_<workstealing::Workqueue>(loc).get();
+    hpx::async<setWorkqueue_act>(loc, workqueue).get();
+
+    auto workqueues = m.workqueues;
+    workqueues.push_back(workqueue);
+    hpx::async<setDistributedWorkqueues_act>(loc, workstealing::sampleVictims(
+        workqueues, workqueues.size() - 1, YewPar::util::RuntimeOptions::get().victims, std::random_device()())).get();
+    hpx::wait_all(hpx::lcos::broadcast<addDistributedWorkqueue_act>(m.localities, workqueue));
+
+    m.localities.push_back(loc);
+    m.workqueues.push_back(workqueue);
   }
 };
 
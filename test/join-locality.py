@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+"""Runs an app on one locality and connects a second locality to it partway through.
+
+The first process is the console, started expecting connecting localities; after the delay a
+second process connects to it (--hpx:connect) as a worker. The console's output is echoed and its
+exit status returned, so ctest can check the result and that the join happened.
+
+    join-locality.py [--delay 1.0] [--port 7950] [--threads 2] <app> [app args...]
+"""
+
+import argparse
+import subprocess
+import sys
+import time
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--delay", type=float, default=1.0,
+                        help="seconds to wait before connecting the second locality")
+    parser.add_argument("--port", type=int, default=7950,
+                        help="console port, the connecting locality uses the next one")
+    parser.add_argument("--threads", type=int, default=2,
+                        help="threads for the connecting locality")
+    parser.add_argument("app")
+    parser.add_argument("args", nargs=argparse.REMAINDER)
+    opts = parser.parse_args()
+
+    console = subprocess.Popen(
+        [opts.app] + opts.args +
+        ["--hpx:hpx=127.0.0.1:%d" % opts.port, "--hpx:expect-connecting-localities"],
+        stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+
+    time.sleep(opts.delay)
+    worker = subprocess.Popen(
+        [opts.app] + opts.args +
+        ["--hpx:connect",
+         "--hpx:agas=127.0.0.1:%d" % opts.port,
+         "--hpx:hpx=127.0.0.1:%d" % (opts.port + 1),
+         "--hpx:threads", str(opts.threads)],
+        stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+    out, _ = console.communicate()
+    sys.stdout.write(out)
+
+    # The worker shuts down with the console, don't leave it behind if it didn't
+    try:
+        worker.wait(timeout=30)
+    except subprocess.TimeoutExpired:
+        worker.kill()
+
+    return console.returncode
+
+
+if __name__ == "__main__":
+    sys.exit(main())